@@ -0,0 +1,377 @@
+#include "Engine.h"
+
+namespace{
+
+// Blocks and pages start on a cache line
+const size_t BlockAlignment = 64;
+
+void NTAPI ReleaseScratchArena(void *arena);
+
+// Set once the registry is gone, threads exiting after that leave their arenas alone
+bool g_registryDestroyed = false;
+
+struct AllocatorRegistry{
+	std::mutex mutex;
+	std::vector<TrackedAllocator *> allocators;
+
+	// Fiber local slot holding each thread's arena, its callback frees the arena when the thread exits since
+	// VS2013 has no thread_local destructors
+	DWORD scratchSlot;
+
+	// Declared last so the arenas unregister while the list is still alive
+	std::vector<std::unique_ptr<ScratchArena>> scratchArenas;
+
+	AllocatorRegistry() : scratchSlot(FlsAlloc(ReleaseScratchArena)){
+
+	}
+
+	~AllocatorRegistry(){
+		g_registryDestroyed = true;
+	}
+};
+
+AllocatorRegistry &Registry(){
+	static AllocatorRegistry registry;
+
+	return registry;
+}
+
+THREAD_LOCAL ScratchArena *t_scratchArena = nullptr;
+std::atomic<uint32_t> g_numScratchArenas(0);
+
+// Runs on the exiting thread
+void NTAPI ReleaseScratchArena(void *arena){
+	if(!arena || g_registryDestroyed) return;
+
+	AllocatorRegistry &registry = Registry();
+	std::unique_ptr<ScratchArena> released;
+
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		for(auto it = registry.scratchArenas.begin(); it != registry.scratchArenas.end(); ++it){
+			if(it->get() != arena) continue;
+
+			released = std::move(*it);
+			registry.scratchArenas.erase(it);
+			break;
+		}
+	}
+
+	// Destroyed outside the lock, the arena unregisters itself
+	t_scratchArena = nullptr;
+}
+
+size_t AlignUp(size_t value, size_t alignment){
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Keeps a running maximum without a lock
+void UpdatePeak(std::atomic<size_t> &peak, size_t value){
+	size_t current = peak.load(std::memory_order_relaxed);
+
+	while(value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+}
+
+TrackedAllocator::TrackedAllocator(const std::string &name) : m_name(name){
+	AllocatorRegistry &registry = Registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	registry.allocators.push_back(this);
+}
+
+TrackedAllocator::~TrackedAllocator(){
+	AllocatorRegistry &registry = Registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	auto it = std::find(registry.allocators.begin(), registry.allocators.end(), this);
+	if(it != registry.allocators.end()) registry.allocators.erase(it);
+}
+
+void TrackedAllocator::getAllStats(std::vector<AllocatorStats> &stats){
+	AllocatorRegistry &registry = Registry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	stats.resize(registry.allocators.size());
+
+	for(size_t i = 0; i < registry.allocators.size(); i++){
+		registry.allocators[i]->getStats(stats[i]);
+	}
+}
+
+std::string TrackedAllocator::formatStats(){
+	std::vector<AllocatorStats> stats;
+	std::string text;
+	char line[256];
+
+	getAllStats(stats);
+
+	sprintf_s(line, "%-32s %10s %10s %10s %12s %8s\n", "Allocator (KB)", "Capacity", "Used", "Peak", "Allocations", "Failed");
+	text += line;
+
+	for(const auto &allocator : stats){
+		sprintf_s(line, "%-32s %10.1f %10.1f %10.1f %12llu %8llu\n", allocator.name.c_str(), allocator.capacity / 1024.0,
+			allocator.used / 1024.0, allocator.peak / 1024.0, allocator.numAllocations, allocator.numFailed);
+		text += line;
+	}
+
+	return text;
+}
+
+LinearAllocator::LinearAllocator(const std::string &name, size_t capacity) : TrackedAllocator(name), m_capacity(capacity){
+	m_memory = static_cast<uint8_t *>(_aligned_malloc(capacity, BlockAlignment));
+
+	if(!m_memory) m_capacity = 0;
+
+	m_offset			= 0;
+	m_peak				= 0;
+	m_numAllocations	= 0;
+	m_numFailed			= 0;
+}
+
+LinearAllocator::~LinearAllocator(){
+	_aligned_free(m_memory);
+}
+
+void *LinearAllocator::allocate(size_t size, size_t alignment){
+	size_t offset = m_offset.load(std::memory_order_relaxed);
+	size_t begin, end;
+
+	// Claim the aligned range, another thread may have moved the offset meanwhile
+	do{
+		begin = AlignUp(offset, alignment);
+		end = begin + size;
+
+		if(end > m_capacity){
+			m_numFailed.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+	}while(!m_offset.compare_exchange_weak(offset, end, std::memory_order_relaxed));
+
+	m_numAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	return m_memory + begin;
+}
+
+void LinearAllocator::reset(){
+	UpdatePeak(m_peak, m_offset.load(std::memory_order_relaxed));
+
+	m_offset.store(0, std::memory_order_relaxed);
+}
+
+void LinearAllocator::getStats(AllocatorStats &stats) const{
+	stats.name				= m_name;
+	stats.capacity			= m_capacity;
+	stats.used				= m_offset.load(std::memory_order_relaxed);
+	stats.peak				= std::max(stats.used, m_peak.load(std::memory_order_relaxed));
+	stats.numAllocations	= m_numAllocations.load(std::memory_order_relaxed);
+	stats.numFailed			= m_numFailed.load(std::memory_order_relaxed);
+}
+
+FrameAllocator::FrameAllocator(const std::string &name, size_t capacityPerFrame, uint32_t numFrames){
+	char index[16];
+
+	for(uint32_t i = 0; i < std::max<uint32_t>(numFrames, 1); i++){
+		sprintf_s(index, " %u", i);
+		m_frames.push_back(std::unique_ptr<LinearAllocator>(new LinearAllocator(name + index, capacityPerFrame)));
+	}
+}
+
+LinearAllocator &FrameAllocator::beginFrame(uint32_t slot){
+	LinearAllocator &frame = get(slot);
+
+	frame.reset();
+
+	return frame;
+}
+
+LinearAllocator &FrameAllocator::get(uint32_t slot){
+	return *m_frames[slot % m_frames.size()];
+}
+
+ScratchArena::ScratchArena(const std::string &name, size_t blockSize) : TrackedAllocator(name), m_blockSize(blockSize){
+	m_block				= 0;
+	m_offset			= 0;
+	m_used				= 0;
+	m_peak				= 0;
+	m_capacity			= 0;
+	m_numAllocations	= 0;
+
+	addBlock(blockSize);
+}
+
+ScratchArena::~ScratchArena(){
+	for(auto &block : m_blocks){
+		_aligned_free(block.memory);
+	}
+}
+
+void ScratchArena::addBlock(size_t capacity){
+	Block block = {static_cast<uint8_t *>(_aligned_malloc(capacity, BlockAlignment)), capacity};
+
+	if(!block.memory) return;
+
+	m_blocks.push_back(block);
+	m_capacity.store(m_capacity.load(std::memory_order_relaxed) + capacity, std::memory_order_relaxed);
+}
+
+ScratchArena &ScratchArena::get(){
+	if(!t_scratchArena){
+		AllocatorRegistry &registry = Registry();
+		char name[32];
+
+		sprintf_s(name, "Scratch %u", g_numScratchArenas++);
+		t_scratchArena = new ScratchArena(name);
+
+		// The registry owns the arena until the thread exits, or until shutdown without a fiber local slot
+		{
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.scratchArenas.push_back(std::unique_ptr<ScratchArena>(t_scratchArena));
+		}
+
+		if(registry.scratchSlot != FLS_OUT_OF_INDEXES) FlsSetValue(registry.scratchSlot, t_scratchArena);
+	}
+
+	return *t_scratchArena;
+}
+
+void *ScratchArena::allocate(size_t size, size_t alignment){
+	while(m_block < m_blocks.size()){
+		Block &block = m_blocks[m_block];
+		size_t begin = AlignUp(m_offset, alignment);
+
+		if(begin + size <= block.capacity){
+			m_offset = begin + size;
+
+			size_t used = m_used.load(std::memory_order_relaxed) + size;
+			m_used.store(used, std::memory_order_relaxed);
+			m_numAllocations.store(m_numAllocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+			if(used > m_peak.load(std::memory_order_relaxed)) m_peak.store(used, std::memory_order_relaxed);
+
+			return block.memory + begin;
+		}
+
+		// Move on to the next block, the tail of this one stays unused until a rewind
+		m_block++;
+		m_offset = 0;
+
+		if(m_block == m_blocks.size()) addBlock(std::max(m_blockSize, AlignUp(size, BlockAlignment)));
+	}
+
+	return nullptr;
+}
+
+ScratchArena::Marker ScratchArena::getMarker() const{
+	Marker marker = {m_block, m_offset, m_used.load(std::memory_order_relaxed)};
+
+	return marker;
+}
+
+void ScratchArena::rewind(const Marker &marker){
+	m_block		= marker.block;
+	m_offset	= marker.offset;
+
+	m_used.store(marker.used, std::memory_order_relaxed);
+
+	// Back to empty after overflowing, replace the blocks with one that fits everything next time. Past
+	// MaxRetainedSize the arena shrinks to a single default block instead
+	if(m_block == 0 && m_offset == 0 && m_blocks.size() > 1){
+		size_t capacity = m_capacity.load(std::memory_order_relaxed);
+
+		for(auto &block : m_blocks){
+			_aligned_free(block.memory);
+		}
+
+		m_blocks.clear();
+		m_capacity.store(0, std::memory_order_relaxed);
+
+		addBlock(capacity <= MaxRetainedSize ? capacity : m_blockSize);
+	}
+}
+
+void ScratchArena::getStats(AllocatorStats &stats) const{
+	stats.name				= m_name;
+	stats.capacity			= m_capacity.load(std::memory_order_relaxed);
+	stats.used				= m_used.load(std::memory_order_relaxed);
+	stats.peak				= m_peak.load(std::memory_order_relaxed);
+	stats.numAllocations	= m_numAllocations.load(std::memory_order_relaxed);
+	stats.numFailed			= 0;
+}
+
+PoolAllocator::PoolAllocator(const std::string &name, size_t objectSize, size_t alignment, size_t objectsPerPage) : TrackedAllocator(name){
+
+	// Free objects hold the free list link
+	m_alignment			= std::max(alignment, sizeof(void *));
+	m_objectSize		= AlignUp(std::max(objectSize, sizeof(void *)), m_alignment);
+	m_objectsPerPage	= std::max<size_t>(objectsPerPage, 1);
+
+	m_freeList			= nullptr;
+	m_numPages			= 0;
+	m_numUsed			= 0;
+	m_peak				= 0;
+	m_numAllocations	= 0;
+}
+
+PoolAllocator::~PoolAllocator(){
+	for(auto page : m_pages){
+		_aligned_free(page);
+	}
+}
+
+void PoolAllocator::addPage(){
+	uint8_t *page = static_cast<uint8_t *>(_aligned_malloc(m_objectSize * m_objectsPerPage, std::max(m_alignment, BlockAlignment)));
+
+	if(!page) return;
+
+	m_pages.push_back(page);
+	m_numPages.store(m_pages.size(), std::memory_order_relaxed);
+
+	// Link back to front so objects are handed out in address order
+	for(size_t i = m_objectsPerPage; i > 0; i--){
+		void *object = page + (i - 1) * m_objectSize;
+
+		*static_cast<void **>(object) = m_freeList;
+		m_freeList = object;
+	}
+}
+
+void *PoolAllocator::allocate(){
+	if(!m_freeList) addPage();
+	if(!m_freeList) return nullptr;
+
+	void *object = m_freeList;
+	m_freeList = *static_cast<void **>(object);
+
+	size_t used = m_numUsed.load(std::memory_order_relaxed) + 1;
+	m_numUsed.store(used, std::memory_order_relaxed);
+	m_numAllocations.store(m_numAllocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	if(used > m_peak.load(std::memory_order_relaxed)) m_peak.store(used, std::memory_order_relaxed);
+
+	return object;
+}
+
+void PoolAllocator::free(void *object){
+	if(!object) return;
+
+	*static_cast<void **>(object) = m_freeList;
+	m_freeList = object;
+
+	m_numUsed.store(m_numUsed.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+size_t PoolAllocator::getObjectSize() const{
+	return m_objectSize;
+}
+
+void PoolAllocator::getStats(AllocatorStats &stats) const{
+	stats.name				= m_name;
+	stats.capacity			= m_numPages.load(std::memory_order_relaxed) * m_objectsPerPage * m_objectSize;
+	stats.used				= m_numUsed.load(std::memory_order_relaxed) * m_objectSize;
+	stats.peak				= m_peak.load(std::memory_order_relaxed) * m_objectSize;
+	stats.numAllocations	= m_numAllocations.load(std::memory_order_relaxed);
+	stats.numFailed			= 0;
+}
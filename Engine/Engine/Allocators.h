@@ -0,0 +1,181 @@
+#pragma once
+
+///////////////////////
+// Allocator classes //
+///////////////////////
+
+struct AllocatorStats{
+	std::string name;
+
+	// Bytes, capacity is everything the allocator holds from the system
+	size_t capacity, used, peak;
+
+	uint64_t numAllocations, numFailed;
+};
+
+// Allocators register themselves so their statistics can be listed together
+class TrackedAllocator{
+protected:
+	std::string m_name;
+
+	TrackedAllocator(const TrackedAllocator &) = delete;
+	TrackedAllocator &operator=(const TrackedAllocator &) = delete;
+
+public:
+	static const size_t DefaultAlignment = 16;
+
+	TrackedAllocator(const std::string &name);
+	virtual ~TrackedAllocator();
+
+	virtual void getStats(AllocatorStats &stats) const = 0;
+
+	// Every live allocator in creation order
+	static void getAllStats(std::vector<AllocatorStats> &stats);
+	static std::string formatStats();
+};
+
+// Bump allocator over one fixed block, any thread may allocate. Nothing is destructed, only plain data belongs here
+class LinearAllocator : public TrackedAllocator{
+private:
+	uint8_t *m_memory;
+	size_t m_capacity;
+
+	std::atomic<size_t> m_offset;
+	std::atomic<size_t> m_peak;
+	std::atomic<uint64_t> m_numAllocations, m_numFailed;
+
+public:
+	LinearAllocator(const std::string &name, size_t capacity);
+	~LinearAllocator();
+
+	// Null once the block is full
+	void *allocate(size_t size, size_t alignment = DefaultAlignment);
+
+	template<typename T>
+	T *allocateArray(size_t count){
+		return static_cast<T *>(allocate(sizeof(T) * count, std::alignment_of<T>::value));
+	}
+
+	// No allocation may be in use or in progress
+	void reset();
+
+	void getStats(AllocatorStats &stats) const;
+};
+
+// One linear allocator per frame in flight, a frame's memory stays valid until its slot comes around again
+class FrameAllocator{
+private:
+	std::vector<std::unique_ptr<LinearAllocator>> m_frames;
+
+public:
+	FrameAllocator(const std::string &name, size_t capacityPerFrame, uint32_t numFrames);
+
+	// Resets the slot, everything allocated by the frame that last used it is gone
+	LinearAllocator &beginFrame(uint32_t slot);
+	LinearAllocator &get(uint32_t slot);
+};
+
+// Stack of temporaries owned by one thread, released together by rewinding. Grows by whole blocks
+class ScratchArena : public TrackedAllocator{
+public:
+	static const size_t BlockSize			= 256 * 1024;
+	static const size_t MaxRetainedSize		= 16 * 1024 * 1024;
+
+	struct Marker{
+		size_t block, offset, used;
+	};
+
+private:
+	struct Block{
+		uint8_t *memory;
+		size_t capacity;
+	};
+
+	std::vector<Block> m_blocks;
+	size_t m_blockSize;
+
+	// Current block and the offset into it
+	size_t m_block, m_offset;
+
+	// Only written by the owning thread, atomic so the stats can be read from elsewhere
+	std::atomic<size_t> m_used, m_peak, m_capacity;
+	std::atomic<uint64_t> m_numAllocations;
+
+	void addBlock(size_t capacity);
+
+public:
+	ScratchArena(const std::string &name, size_t blockSize = BlockSize);
+	~ScratchArena();
+
+	// The calling thread's arena, created on first use and freed when the thread exits
+	static ScratchArena &get();
+
+	void *allocate(size_t size, size_t alignment = DefaultAlignment);
+
+	template<typename T>
+	T *allocateArray(size_t count){
+		return static_cast<T *>(allocate(sizeof(T) * count, std::alignment_of<T>::value));
+	}
+
+	Marker getMarker() const;
+
+	// Frees everything allocated after marker, rewinding to the start merges the blocks so the arena stops growing
+	void rewind(const Marker &marker);
+
+	void getStats(AllocatorStats &stats) const;
+};
+
+// Rewinds the calling thread's scratch arena when it goes out of scope
+class ScratchScope{
+private:
+	ScratchArena &m_arena;
+	ScratchArena::Marker m_marker;
+
+	ScratchScope(const ScratchScope &) = delete;
+	ScratchScope &operator=(const ScratchScope &) = delete;
+
+public:
+	ScratchScope() : m_arena(ScratchArena::get()), m_marker(m_arena.getMarker()){
+
+	}
+
+	~ScratchScope(){
+		m_arena.rewind(m_marker);
+	}
+
+	void *allocate(size_t size, size_t alignment = TrackedAllocator::DefaultAlignment){
+		return m_arena.allocate(size, alignment);
+	}
+
+	template<typename T>
+	T *allocateArray(size_t count){
+		return m_arena.allocateArray<T>(count);
+	}
+};
+
+// Fixed size objects carved from pages, freed objects are reused first. Not thread safe, but getStats can be
+// called from any thread while the owner allocates under its own lock
+class PoolAllocator : public TrackedAllocator{
+private:
+	size_t m_objectSize, m_alignment, m_objectsPerPage;
+
+	std::vector<uint8_t *> m_pages;
+	void *m_freeList;
+
+	// Only written by the owner, atomic so the stats can be read from elsewhere
+	std::atomic<size_t> m_numPages, m_numUsed, m_peak;
+	std::atomic<uint64_t> m_numAllocations;
+
+	void addPage();
+
+public:
+	PoolAllocator(const std::string &name, size_t objectSize, size_t alignment = DefaultAlignment, size_t objectsPerPage = 64);
+	~PoolAllocator();
+
+	void *allocate();
+	void free(void *object);
+
+	size_t getObjectSize() const;
+
+	void getStats(AllocatorStats &stats) const;
+};
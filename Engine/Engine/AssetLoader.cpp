@@ -0,0 +1,231 @@
+#include "Engine.h"
+
+AssetLoader::AssetLoader(uint32_t numIoThreads, uint32_t numWorkerThreads){
+	m_jobSystem		= nullptr;
+	m_numPending	= 0;
+	m_quit			= false;
+
+	for(uint32_t i = 0; i < std::max<uint32_t>(1, numIoThreads); i++){
+		m_ioThreads.push_back(std::thread(&AssetLoader::ioThreadMain, this));
+	}
+
+	for(uint32_t i = 0; i < std::max<uint32_t>(1, numWorkerThreads); i++){
+		m_workerThreads.push_back(std::thread(&AssetLoader::workerThreadMain, this));
+	}
+}
+
+AssetLoader::AssetLoader(JobSystem &jobSystem){
+	m_jobSystem		= &jobSystem;
+	m_numPending	= 0;
+	m_quit			= false;
+}
+
+AssetLoader::~AssetLoader(){
+
+	// Jobs still touch the queues after handing their result over
+	if(m_jobSystem){
+		m_jobSystem->wait(m_counter);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+
+	m_ioSignal.notify_all();
+	m_workSignal.notify_all();
+
+	for(auto &thread : m_ioThreads)		thread.join();
+	for(auto &thread : m_workerThreads)	thread.join();
+}
+
+void AssetLoader::ioThreadMain(){
+	while(true){
+		Job *job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_ioSignal.wait(lock, [this]{ return m_quit || !m_ioQueue.empty(); });
+
+			if(m_quit) return;
+
+			job = m_ioQueue.front();
+			m_ioQueue.pop_front();
+		}
+
+		// Files that fail to open skip processing and go straight to the main thread
+		if(!readJob(job)){
+			completeJob(job);
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_workQueue.push_back(job);
+		}
+
+		m_workSignal.notify_one();
+	}
+}
+
+void AssetLoader::workerThreadMain(){
+	while(true){
+		Job *job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_workSignal.wait(lock, [this]{ return m_quit || !m_workQueue.empty(); });
+
+			if(m_quit) return;
+
+			job = m_workQueue.front();
+			m_workQueue.pop_front();
+		}
+
+		processJob(job);
+		completeJob(job);
+	}
+}
+
+bool AssetLoader::readJob(Job *job){
+	job->succeeded		= job->file.open(job->path);
+	job->data.bytes		= job->file.getData();
+	job->data.size		= job->file.getSize();
+
+	return job->succeeded;
+}
+
+void AssetLoader::processJob(Job *job){
+	if(job->process) job->succeeded = job->process(job->data);
+}
+
+void AssetLoader::completeJob(Job *job){
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_doneQueue.push_back(job);
+	}
+
+	m_doneSignal.notify_one();
+}
+
+void AssetLoader::load(const std::wstring &path, const ProcessFunc &process, const FinalizeFunc &finalize){
+	std::unique_ptr<Job> job(new Job);
+
+	job->path		= path;
+	job->data.bytes	= nullptr;
+	job->data.size	= 0;
+	job->process	= process;
+	job->finalize	= finalize;
+	job->succeeded	= true;
+
+	Job *queued = job.get();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if(!m_jobSystem) m_ioQueue.push_back(queued);
+
+		m_jobs.push_back(std::move(job));
+		m_numPending++;
+	}
+
+	if(!m_jobSystem){
+		m_ioSignal.notify_one();
+		return;
+	}
+
+	m_jobSystem->run([this, queued]{
+		if(readJob(queued)) processJob(queued);
+
+		completeJob(queued);
+	}, &m_counter);
+}
+
+void AssetLoader::load(const uint8_t *bytes, size_t size, const ProcessFunc &process, const FinalizeFunc &finalize){
+	std::unique_ptr<Job> job(new Job);
+
+	job->data.bytes	= bytes;
+	job->data.size	= size;
+	job->process	= process;
+	job->finalize	= finalize;
+	job->succeeded	= true;
+
+	queue(std::move(job));
+}
+
+void AssetLoader::run(const ProcessFunc &process, const FinalizeFunc &finalize){
+	std::unique_ptr<Job> job(new Job);
+
+	job->data.bytes	= nullptr;
+	job->data.size	= 0;
+	job->process	= process;
+	job->finalize	= finalize;
+	job->succeeded	= true;
+
+	queue(std::move(job));
+}
+
+void AssetLoader::queue(std::unique_ptr<Job> job){
+	Job *queued = job.get();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if(!m_jobSystem) m_workQueue.push_back(queued);
+
+		m_jobs.push_back(std::move(job));
+		m_numPending++;
+	}
+
+	if(!m_jobSystem){
+		m_workSignal.notify_one();
+		return;
+	}
+
+	m_jobSystem->run([this, queued]{
+		processJob(queued);
+		completeJob(queued);
+	}, &m_counter);
+}
+
+uint32_t AssetLoader::finalize(){
+	uint32_t numFailed = 0;
+
+	while(true){
+		std::deque<Job *> batch;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if(m_numPending == 0) break;
+
+			m_doneSignal.wait(lock, [this]{ return !m_doneQueue.empty(); });
+
+			// Take everything that finished so far as one batch
+			batch.swap(m_doneQueue);
+			m_numPending -= static_cast<uint32_t>(batch.size());
+		}
+
+		for(auto job : batch){
+			if(!job->succeeded){
+				numFailed++;
+			}
+			else if(job->finalize){
+				job->finalize(job->data);
+			}
+
+			// The file is no longer needed once the resource exists
+			job->file.close();
+		}
+	}
+
+	// Every job has handed its result over, wait for them to return before their jobs are freed
+	if(m_jobSystem) m_jobSystem->wait(m_counter);
+
+	m_jobs.clear();
+
+	return numFailed;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+////////////////////////
+// Asset loader class //
+////////////////////////
+
+class AssetLoader{
+public:
+
+	// A job's file contents, mapped or in memory owned by the caller. Empty for jobs without a file
+	struct Data{
+		const uint8_t *bytes;
+		size_t size;
+	};
+
+	// Runs on a worker thread with the file contents
+	typedef std::function<bool(const Data &data)> ProcessFunc;
+
+	// Runs on the thread calling finalize(), this is where device resources get created
+	typedef std::function<void(const Data &data)> FinalizeFunc;
+
+private:
+	struct Job{
+		std::wstring path;
+		MappedFile file;
+		Data data;
+
+		ProcessFunc process;
+		FinalizeFunc finalize;
+
+		bool succeeded;
+	};
+
+	// I/O threads map files, workers parse and decode, finished jobs wait for finalize()
+	std::vector<std::thread> m_ioThreads, m_workerThreads;
+
+	// Set instead of the threads when the jobs run on a job system, the counter holds the ones in flight
+	JobSystem *m_jobSystem;
+	JobSystem::Counter m_counter;
+
+	std::deque<Job *> m_ioQueue, m_workQueue, m_doneQueue;
+	std::vector<std::unique_ptr<Job>> m_jobs;
+
+	std::mutex m_mutex;
+	std::condition_variable m_ioSignal, m_workSignal, m_doneSignal;
+
+	uint32_t m_numPending;
+	bool m_quit;
+
+	void ioThreadMain();
+	void workerThreadMain();
+
+	// Maps the job's file, false if it can't be opened
+	bool readJob(Job *job);
+	void processJob(Job *job);
+	void completeJob(Job *job);
+
+	// Hands a job that already has its contents to the workers
+	void queue(std::unique_ptr<Job> job);
+
+public:
+	AssetLoader(uint32_t numIoThreads, uint32_t numWorkerThreads);
+
+	// Reads and processes on jobSystem instead of threads of its own, for a handful of loads (e.g. a reload)
+	// where starting threads would cost more than the loads
+	explicit AssetLoader(JobSystem &jobSystem);
+	~AssetLoader();
+
+	// Queues a file to be mapped, processed and finalized, either function may be empty
+	void load(const std::wstring &path, const ProcessFunc &process, const FinalizeFunc &finalize);
+
+	// Same for contents already in memory (e.g. a packed file), they must stay valid until finalize() returns
+	void load(const uint8_t *bytes, size_t size, const ProcessFunc &process, const FinalizeFunc &finalize);
+
+	// Queues CPU work that has no file to read (e.g. shader compilation)
+	void run(const ProcessFunc &process, const FinalizeFunc &finalize);
+
+	// Finalizes jobs in batches as they complete until every queued job is done,
+	// returns the number of jobs that failed to read or process
+	uint32_t finalize();
+};
@@ -0,0 +1,866 @@
+#include "Engine.h"
+
+namespace BlockCompression{
+
+namespace{
+
+// BC7 mode layouts, bit counts are per endpoint channel or per index
+struct BC7Mode{
+	uint8_t numSubsets;
+	uint8_t partitionBits;
+	uint8_t rotationBits;
+	uint8_t indexSelectionBits;
+	uint8_t colorBits;
+	uint8_t alphaBits;
+	uint8_t endpointPBits;
+	uint8_t sharedPBits;
+	uint8_t indexBits;
+	uint8_t indexBits2;
+};
+
+const BC7Mode BC7Modes[8] = {
+	{3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+	{2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+	{3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+	{2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+	{1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+	{1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+	{1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+	{2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+// Two subset partitions, a set bit puts the texel in the second subset
+const uint16_t BC7Partitions2[64] = {
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+const uint8_t BC7Partitions3[64][16] = {
+	{0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+	{0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+	{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+	{0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1}, {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+	{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2}, {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+	{0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+	{0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2}, {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+	{0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+	{0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2}, {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+	{0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+	{0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+	{0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2}, {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+	{0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0}, {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+	{0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0}, {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+	{0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2}, {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+	{0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1}, {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+	{0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+	{0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2}, {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+	{0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0}, {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+	{0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0}, {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+	{0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1}, {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+	{0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1}, {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+	{0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1}, {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+	{0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1}, {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+	{0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2}, {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+	{0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2}, {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+	{0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2}, {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+	{0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+	{0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+	{0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+	{0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1}, {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+	{0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+};
+
+// Texels whose index is stored with one bit less, the first texel is always an anchor
+const uint8_t BC7Anchors2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+	15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+	 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+const uint8_t BC7Anchors3a[64] = {
+	 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+	 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+	 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+	 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+};
+
+const uint8_t BC7Anchors3b[64] = {
+	15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+	15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+	15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+	15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+};
+
+const uint8_t BC7Weights2[4]	= {0, 21, 43, 64};
+const uint8_t BC7Weights3[8]	= {0, 9, 18, 27, 37, 46, 55, 64};
+const uint8_t BC7Weights4[16]	= {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+const uint8_t *GetBC7Weights(uint32_t numBits){
+	return numBits == 2 ? BC7Weights2 : (numBits == 3 ? BC7Weights3 : BC7Weights4);
+}
+
+// Reads a 128-bit block from the least significant bit up
+class BitReader{
+private:
+	const uint8_t *m_data;
+	uint32_t m_pos;
+
+public:
+	BitReader(const uint8_t *data) : m_data(data), m_pos(0){}
+
+	uint32_t read(uint32_t numBits){
+		uint32_t value = 0;
+
+		for(uint32_t i = 0; i < numBits; i++, m_pos++){
+			value |= ((m_data[m_pos >> 3] >> (m_pos & 7)) & 1) << i;
+		}
+
+		return value;
+	}
+};
+
+// x / 3 and x / 7 for 16-bit lanes up to 0x7FF, through a high multiply
+__m128i Div3(__m128i x){
+	return _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16(static_cast<short>(0xAAAB))), 1);
+}
+
+__m128i Div7(__m128i x){
+	return _mm_mulhi_epu16(x, _mm_set1_epi16(9363));
+}
+
+__m128i Div5(__m128i x){
+	return _mm_mulhi_epu16(x, _mm_set1_epi16(13108));
+}
+
+// 5:6:5 color to 8-bit RGB with full alpha in 16-bit lanes
+__m128i Unpack565(uint32_t color){
+	uint32_t r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+
+	return _mm_setr_epi16(
+		static_cast<short>((r << 3) | (r >> 2)),
+		static_cast<short>((g << 2) | (g >> 4)),
+		static_cast<short>((b << 3) | (b >> 2)),
+		255, 0, 0, 0, 0
+	);
+}
+
+uint32_t Pack565(float r, float g, float b){
+	uint32_t r5 = static_cast<uint32_t>(std::min(std::max(r, 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	uint32_t g6 = static_cast<uint32_t>(std::min(std::max(g, 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+	uint32_t b5 = static_cast<uint32_t>(std::min(std::max(b, 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+
+	return (r5 << 11) | (g6 << 5) | b5;
+}
+
+float HorizontalSum(__m128 v){
+	__m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(v, shuffled);
+
+	shuffled	= _mm_movehl_ps(shuffled, sums);
+	sums		= _mm_add_ss(sums, shuffled);
+
+	return _mm_cvtss_f32(sums);
+}
+
+// Color half of BC1/BC3, BC3 always decodes with four colors regardless of endpoint order
+void DecodeColorBlock(const uint8_t *block, uint8_t *texels, bool allowThreeColor){
+	uint32_t c0 = block[0] | (block[1] << 8);
+	uint32_t c1 = block[2] | (block[3] << 8);
+	uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (block[7] << 24);
+
+	__m128i e0 = Unpack565(c0), e1 = Unpack565(c1);
+	__m128i color2, color3;
+
+	if(c0 > c1 || !allowThreeColor){
+		color2 = Div3(_mm_add_epi16(_mm_add_epi16(e0, e0), e1));
+		color3 = Div3(_mm_add_epi16(_mm_add_epi16(e1, e1), e0));
+	}
+	else{
+		color2 = _mm_srli_epi16(_mm_add_epi16(e0, e1), 1);
+		color3 = _mm_setzero_si128();
+	}
+
+	uint32_t palette[4];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(palette), _mm_packus_epi16(_mm_unpacklo_epi64(e0, e1), _mm_unpacklo_epi64(color2, color3)));
+
+	for(uint32_t i = 0; i < 16; i++){
+		memcpy(texels + i * 4, &palette[(indices >> (i * 2)) & 3], 4);
+	}
+}
+
+// Single channel block shared by BC3 alpha, BC4 and BC5
+void DecodeAlphaBlock(const uint8_t *block, uint8_t *texels, uint32_t channel){
+	uint32_t a0 = block[0], a1 = block[1];
+
+	__m128i v0 = _mm_set1_epi16(static_cast<short>(a0));
+	__m128i v1 = _mm_set1_epi16(static_cast<short>(a1));
+	__m128i values;
+
+	// Six interpolated values, or four plus 0 and 255
+	if(a0 > a1){
+		__m128i sum = _mm_add_epi16(_mm_mullo_epi16(v0, _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1)), _mm_mullo_epi16(v1, _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6)));
+
+		values = Div7(_mm_add_epi16(sum, _mm_set1_epi16(3)));
+	}
+	else{
+		__m128i sum = _mm_add_epi16(_mm_mullo_epi16(v0, _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0)), _mm_mullo_epi16(v1, _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0)));
+
+		values = Div5(_mm_add_epi16(sum, _mm_setr_epi16(2, 2, 2, 2, 2, 2, 0, 0)));
+		values = _mm_or_si128(values, _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+	}
+
+	uint8_t palette[16];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(palette), _mm_packus_epi16(values, values));
+
+	uint64_t indices = 0;
+
+	for(uint32_t i = 0; i < 6; i++){
+		indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+	}
+
+	for(uint32_t i = 0; i < 16; i++){
+		texels[i * 4 + channel] = palette[(indices >> (i * 3)) & 7];
+	}
+}
+
+void EncodeColorBlock(const uint8_t *texels, uint8_t *block, bool allowThreeColor){
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+
+	// Planar float channels, four texels per register
+	__m128 r[4], g[4], b[4], opaque[4];
+	uint32_t transparentMask = 0;
+
+	for(uint32_t i = 0; i < 4; i++){
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texels + i * 16));
+
+		r[i] = _mm_cvtepi32_ps(_mm_and_si128(pixels, byteMask));
+		g[i] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask));
+		b[i] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask));
+
+		__m128 transparent = _mm_cmplt_ps(_mm_cvtepi32_ps(_mm_srli_epi32(pixels, 24)), _mm_set1_ps(128.0f));
+
+		if(!allowThreeColor) transparent = _mm_setzero_ps();
+
+		opaque[i] = _mm_andnot_ps(transparent, _mm_set1_ps(1.0f));
+		transparentMask |= _mm_movemask_ps(transparent) << (i * 4);
+	}
+
+	// Fully transparent blocks only need the transparent index
+	if(transparentMask == 0xFFFF){
+		memset(block, 0, 4);
+		memset(block + 4, 0xFF, 4);
+		return;
+	}
+
+	// Mean and covariance of the opaque texels
+	__m128 sumR = _mm_setzero_ps(), sumG = _mm_setzero_ps(), sumB = _mm_setzero_ps(), count = _mm_setzero_ps();
+
+	for(uint32_t i = 0; i < 4; i++){
+		sumR	= _mm_add_ps(sumR, _mm_mul_ps(r[i], opaque[i]));
+		sumG	= _mm_add_ps(sumG, _mm_mul_ps(g[i], opaque[i]));
+		sumB	= _mm_add_ps(sumB, _mm_mul_ps(b[i], opaque[i]));
+		count	= _mm_add_ps(count, opaque[i]);
+	}
+
+	float invCount = 1.0f / HorizontalSum(count);
+	float meanR = HorizontalSum(sumR) * invCount, meanG = HorizontalSum(sumG) * invCount, meanB = HorizontalSum(sumB) * invCount;
+
+	__m128 vMeanR = _mm_set1_ps(meanR), vMeanG = _mm_set1_ps(meanG), vMeanB = _mm_set1_ps(meanB);
+	__m128 covRR = _mm_setzero_ps(), covRG = _mm_setzero_ps(), covRB = _mm_setzero_ps();
+	__m128 covGG = _mm_setzero_ps(), covGB = _mm_setzero_ps(), covBB = _mm_setzero_ps();
+
+	for(uint32_t i = 0; i < 4; i++){
+		__m128 dr = _mm_mul_ps(_mm_sub_ps(r[i], vMeanR), opaque[i]);
+		__m128 dg = _mm_mul_ps(_mm_sub_ps(g[i], vMeanG), opaque[i]);
+		__m128 db = _mm_mul_ps(_mm_sub_ps(b[i], vMeanB), opaque[i]);
+
+		covRR = _mm_add_ps(covRR, _mm_mul_ps(dr, dr));
+		covRG = _mm_add_ps(covRG, _mm_mul_ps(dr, dg));
+		covRB = _mm_add_ps(covRB, _mm_mul_ps(dr, db));
+		covGG = _mm_add_ps(covGG, _mm_mul_ps(dg, dg));
+		covGB = _mm_add_ps(covGB, _mm_mul_ps(dg, db));
+		covBB = _mm_add_ps(covBB, _mm_mul_ps(db, db));
+	}
+
+	float cov[6] = {HorizontalSum(covRR), HorizontalSum(covRG), HorizontalSum(covRB), HorizontalSum(covGG), HorizontalSum(covGB), HorizontalSum(covBB)};
+
+	// Principal axis through power iteration, starting from the covariance row with the largest variance
+	float axis[3];
+
+	if(cov[0] >= cov[3] && cov[0] >= cov[5]){
+		axis[0] = cov[0]; axis[1] = cov[1]; axis[2] = cov[2];
+	}
+	else if(cov[3] >= cov[5]){
+		axis[0] = cov[1]; axis[1] = cov[3]; axis[2] = cov[4];
+	}
+	else{
+		axis[0] = cov[2]; axis[1] = cov[4]; axis[2] = cov[5];
+	}
+
+	for(uint32_t iter = 0; iter < 8; iter++){
+		float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		float length = std::max(std::max(fabsf(x), fabsf(y)), fabsf(z));
+
+		if(length < FLT_EPSILON) break;
+
+		axis[0] = x / length;
+		axis[1] = y / length;
+		axis[2] = z / length;
+	}
+
+	float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+	// Flat blocks have no axis, both endpoints end up at the mean
+	if(axisLength > FLT_EPSILON){
+		axis[0] /= axisLength;
+		axis[1] /= axisLength;
+		axis[2] /= axisLength;
+	}
+	else{
+		axis[0] = axis[1] = axis[2] = 0.0f;
+	}
+
+	// Extent of the opaque texels along the axis
+	__m128 vAxisR = _mm_set1_ps(axis[0]), vAxisG = _mm_set1_ps(axis[1]), vAxisB = _mm_set1_ps(axis[2]);
+	__m128 minT = _mm_set1_ps(FLT_MAX), maxT = _mm_set1_ps(-FLT_MAX);
+
+	for(uint32_t i = 0; i < 4; i++){
+		__m128 t = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_sub_ps(r[i], vMeanR), vAxisR),
+			_mm_mul_ps(_mm_sub_ps(g[i], vMeanG), vAxisG)),
+			_mm_mul_ps(_mm_sub_ps(b[i], vMeanB), vAxisB));
+
+		__m128 isOpaque = _mm_cmpgt_ps(opaque[i], _mm_setzero_ps());
+
+		minT = _mm_min_ps(minT, _mm_or_ps(_mm_and_ps(isOpaque, t), _mm_andnot_ps(isOpaque, _mm_set1_ps(FLT_MAX))));
+		maxT = _mm_max_ps(maxT, _mm_or_ps(_mm_and_ps(isOpaque, t), _mm_andnot_ps(isOpaque, _mm_set1_ps(-FLT_MAX))));
+	}
+
+	minT = _mm_min_ps(minT, _mm_shuffle_ps(minT, minT, _MM_SHUFFLE(2, 3, 0, 1)));
+	minT = _mm_min_ps(minT, _mm_shuffle_ps(minT, minT, _MM_SHUFFLE(1, 0, 3, 2)));
+	maxT = _mm_max_ps(maxT, _mm_shuffle_ps(maxT, maxT, _MM_SHUFFLE(2, 3, 0, 1)));
+	maxT = _mm_max_ps(maxT, _mm_shuffle_ps(maxT, maxT, _MM_SHUFFLE(1, 0, 3, 2)));
+
+	float tMin = _mm_cvtss_f32(minT), tMax = _mm_cvtss_f32(maxT);
+
+	uint32_t c0 = Pack565(meanR + axis[0] * tMax, meanG + axis[1] * tMax, meanB + axis[2] * tMax);
+	uint32_t c1 = Pack565(meanR + axis[0] * tMin, meanG + axis[1] * tMin, meanB + axis[2] * tMin);
+
+	// Four colors need c0 > c1, three colors plus transparent need c0 <= c1
+	bool threeColor = transparentMask != 0;
+
+	if((!threeColor && c0 < c1) || (threeColor && c0 > c1)) std::swap(c0, c1);
+
+	// Project onto the quantized endpoints to pick indices
+	int16_t endpoints[16];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(endpoints), _mm_unpacklo_epi64(Unpack565(c0), Unpack565(c1)));
+
+	float dirR = static_cast<float>(endpoints[4] - endpoints[0]);
+	float dirG = static_cast<float>(endpoints[5] - endpoints[1]);
+	float dirB = static_cast<float>(endpoints[6] - endpoints[2]);
+	float length2 = dirR * dirR + dirG * dirG + dirB * dirB;
+	float steps = threeColor ? 2.0f : 3.0f;
+	float scale = length2 > 0.0f ? steps / length2 : 0.0f;
+
+	__m128 vDirR = _mm_set1_ps(dirR * scale), vDirG = _mm_set1_ps(dirG * scale), vDirB = _mm_set1_ps(dirB * scale);
+	__m128 vStartR = _mm_set1_ps(endpoints[0]), vStartG = _mm_set1_ps(endpoints[1]), vStartB = _mm_set1_ps(endpoints[2]);
+
+	static const uint32_t FourColorOrder[4]		= {0, 2, 3, 1};
+	static const uint32_t ThreeColorOrder[3]	= {0, 2, 1};
+
+	uint32_t indices = 0;
+
+	for(uint32_t i = 0; i < 4; i++){
+		__m128 t = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_sub_ps(r[i], vStartR), vDirR),
+			_mm_mul_ps(_mm_sub_ps(g[i], vStartG), vDirG)),
+			_mm_mul_ps(_mm_sub_ps(b[i], vStartB), vDirB));
+
+		t = _mm_min_ps(_mm_max_ps(_mm_add_ps(t, _mm_set1_ps(0.5f)), _mm_setzero_ps()), _mm_set1_ps(steps));
+
+		int32_t steps4[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(steps4), _mm_cvttps_epi32(t));
+
+		for(uint32_t j = 0; j < 4; j++){
+			uint32_t texel = i * 4 + j;
+			uint32_t index;
+
+			if(transparentMask & (1 << texel))	index = 3;
+			else if(threeColor)					index = ThreeColorOrder[steps4[j]];
+			else								index = FourColorOrder[steps4[j]];
+
+			indices |= index << (texel * 2);
+		}
+	}
+
+	block[0] = static_cast<uint8_t>(c0);
+	block[1] = static_cast<uint8_t>(c0 >> 8);
+	block[2] = static_cast<uint8_t>(c1);
+	block[3] = static_cast<uint8_t>(c1 >> 8);
+
+	memcpy(block + 4, &indices, 4);
+}
+
+// Encodes one channel of 16 RGBA8 texels with eight interpolated values between the extremes
+void EncodeAlphaBlock(const uint8_t *texels, uint8_t *block, uint32_t channel){
+	uint8_t values[16];
+
+	for(uint32_t i = 0; i < 16; i++) values[i] = texels[i * 4 + channel];
+
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+	__m128i vMin = v, vMax = v;
+
+	for(int shift = 8; shift > 0; shift >>= 1){
+		__m128i shiftedMin = vMin, shiftedMax = vMax;
+
+		// Shift counts have to be immediates
+		switch(shift){
+			case 8: shiftedMin = _mm_srli_si128(vMin, 8); shiftedMax = _mm_srli_si128(vMax, 8); break;
+			case 4: shiftedMin = _mm_srli_si128(vMin, 4); shiftedMax = _mm_srli_si128(vMax, 4); break;
+			case 2: shiftedMin = _mm_srli_si128(vMin, 2); shiftedMax = _mm_srli_si128(vMax, 2); break;
+			case 1: shiftedMin = _mm_srli_si128(vMin, 1); shiftedMax = _mm_srli_si128(vMax, 1); break;
+		}
+
+		vMin = _mm_min_epu8(vMin, shiftedMin);
+		vMax = _mm_max_epu8(vMax, shiftedMax);
+	}
+
+	uint32_t minValue = _mm_cvtsi128_si32(vMin) & 0xFF;
+	uint32_t maxValue = _mm_cvtsi128_si32(vMax) & 0xFF;
+
+	block[0] = static_cast<uint8_t>(maxValue);
+	block[1] = static_cast<uint8_t>(minValue);
+
+	if(maxValue == minValue){
+		memset(block + 2, 0, 6);
+		return;
+	}
+
+	// Step from the minimum in sevenths of the range, 7 maps to index 0, 0 to index 1 and k to 8 - k
+	__m128 scale = _mm_set1_ps(7.0f / (maxValue - minValue));
+	__m128i zero = _mm_setzero_si128();
+	__m128i diff = _mm_subs_epu8(v, _mm_set1_epi8(static_cast<char>(minValue)));
+	__m128i diffLo = _mm_unpacklo_epi8(diff, zero), diffHi = _mm_unpackhi_epi8(diff, zero);
+	__m128i steps[4];
+
+	steps[0] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(diffLo, zero)), scale), _mm_set1_ps(0.5f)));
+	steps[1] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(diffLo, zero)), scale), _mm_set1_ps(0.5f)));
+	steps[2] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(diffHi, zero)), scale), _mm_set1_ps(0.5f)));
+	steps[3] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(diffHi, zero)), scale), _mm_set1_ps(0.5f)));
+
+	uint64_t indices = 0;
+
+	for(uint32_t i = 0; i < 4; i++){
+		__m128i index = _mm_and_si128(_mm_sub_epi32(_mm_set1_epi32(8), steps[i]), _mm_set1_epi32(7));
+
+		// Swap 0 and 1
+		index = _mm_xor_si128(index, _mm_and_si128(_mm_cmplt_epi32(index, _mm_set1_epi32(2)), _mm_set1_epi32(1)));
+
+		uint32_t index4[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(index4), index);
+
+		for(uint32_t j = 0; j < 4; j++){
+			indices |= static_cast<uint64_t>(index4[j]) << ((i * 4 + j) * 3);
+		}
+	}
+
+	for(uint32_t i = 0; i < 6; i++){
+		block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+}
+
+typedef void (*BlockFunc)(const uint8_t *in, uint8_t *out);
+
+BlockFunc GetDecoder(BlockFormat format){
+	switch(format){
+		case FormatBC1: return DecodeBlockBC1;
+		case FormatBC3: return DecodeBlockBC3;
+		case FormatBC4: return DecodeBlockBC4;
+		case FormatBC5: return DecodeBlockBC5;
+		case FormatBC7: return DecodeBlockBC7;
+	}
+
+	return nullptr;
+}
+
+BlockFunc GetEncoder(BlockFormat format){
+	switch(format){
+		case FormatBC1: return EncodeBlockBC1;
+		case FormatBC3: return EncodeBlockBC3;
+		case FormatBC4: return EncodeBlockBC4;
+		case FormatBC5: return EncodeBlockBC5;
+		default:		return nullptr;
+	}
+}
+
+}
+
+bool GetBlockFormat(DXGI_FORMAT format, BlockFormat &blockFormat){
+	switch(format){
+		case DXGI_FORMAT_BC1_TYPELESS:
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			blockFormat = FormatBC1;
+			return true;
+
+		case DXGI_FORMAT_BC3_TYPELESS:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			blockFormat = FormatBC3;
+			return true;
+
+		case DXGI_FORMAT_BC4_TYPELESS:
+		case DXGI_FORMAT_BC4_UNORM:
+			blockFormat = FormatBC4;
+			return true;
+
+		case DXGI_FORMAT_BC5_TYPELESS:
+		case DXGI_FORMAT_BC5_UNORM:
+			blockFormat = FormatBC5;
+			return true;
+
+		case DXGI_FORMAT_BC7_TYPELESS:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			blockFormat = FormatBC7;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+size_t GetBlockSize(BlockFormat format){
+	return (format == FormatBC1 || format == FormatBC4) ? 8 : 16;
+}
+
+size_t GetRowBytes(BlockFormat format, size_t width){
+	return std::max<size_t>(1, (width + 3) / 4) * GetBlockSize(format);
+}
+
+size_t GetSurfaceBytes(BlockFormat format, size_t width, size_t height){
+	return GetRowBytes(format, width) * std::max<size_t>(1, (height + 3) / 4);
+}
+
+void DecodeBlockBC1(const uint8_t *block, uint8_t *texels){
+	DecodeColorBlock(block, texels, true);
+}
+
+void DecodeBlockBC3(const uint8_t *block, uint8_t *texels){
+	DecodeColorBlock(block + 8, texels, false);
+	DecodeAlphaBlock(block, texels, 3);
+}
+
+void DecodeBlockBC4(const uint8_t *block, uint8_t *texels){
+	for(uint32_t i = 0; i < 16; i++){
+		texels[i * 4 + 1] = 0;
+		texels[i * 4 + 2] = 0;
+		texels[i * 4 + 3] = 255;
+	}
+
+	DecodeAlphaBlock(block, texels, 0);
+}
+
+void DecodeBlockBC5(const uint8_t *block, uint8_t *texels){
+	for(uint32_t i = 0; i < 16; i++){
+		texels[i * 4 + 2] = 0;
+		texels[i * 4 + 3] = 255;
+	}
+
+	DecodeAlphaBlock(block, texels, 0);
+	DecodeAlphaBlock(block + 8, texels, 1);
+}
+
+void DecodeBlockBC7(const uint8_t *block, uint8_t *texels){
+	uint32_t mode = 0;
+
+	while(mode < 8 && !(block[0] & (1 << mode))) mode++;
+
+	// Reserved mode, decodes to transparent black
+	if(mode == 8){
+		memset(texels, 0, 64);
+		return;
+	}
+
+	const BC7Mode &info = BC7Modes[mode];
+	BitReader reader(block);
+
+	reader.read(mode + 1);
+
+	uint32_t partition		= reader.read(info.partitionBits);
+	uint32_t rotation		= reader.read(info.rotationBits);
+	uint32_t indexSelection	= reader.read(info.indexSelectionBits);
+	uint32_t numEndpoints	= info.numSubsets * 2;
+
+	// Endpoints are stored channel by channel, then the p-bits
+	uint32_t endpoints[6][4];
+	uint32_t pBits[6] = {0};
+
+	for(uint32_t channel = 0; channel < 3; channel++){
+		for(uint32_t i = 0; i < numEndpoints; i++) endpoints[i][channel] = reader.read(info.colorBits);
+	}
+
+	for(uint32_t i = 0; i < numEndpoints; i++) endpoints[i][3] = reader.read(info.alphaBits);
+
+	if(info.endpointPBits){
+		for(uint32_t i = 0; i < numEndpoints; i++) pBits[i] = reader.read(1);
+	}
+
+	if(info.sharedPBits){
+		for(uint32_t i = 0; i < info.numSubsets; i++) pBits[i * 2] = pBits[i * 2 + 1] = reader.read(1);
+	}
+
+	bool hasPBits = info.endpointPBits || info.sharedPBits;
+
+	// Expand to 8 bits by replicating the high bits
+	for(uint32_t i = 0; i < numEndpoints; i++){
+		for(uint32_t channel = 0; channel < 4; channel++){
+			uint32_t numBits = channel < 3 ? info.colorBits : info.alphaBits;
+
+			if(numBits == 0){
+				endpoints[i][channel] = 255;
+				continue;
+			}
+
+			uint32_t value = endpoints[i][channel];
+
+			if(hasPBits){
+				value = (value << 1) | pBits[i];
+				numBits++;
+			}
+
+			value <<= 8 - numBits;
+			endpoints[i][channel] = value | (value >> numBits);
+		}
+	}
+
+	// Subset and anchor of each texel
+	uint8_t subsets[16];
+	bool anchors[16];
+
+	for(uint32_t i = 0; i < 16; i++){
+		if(info.numSubsets == 1)		subsets[i] = 0;
+		else if(info.numSubsets == 2)	subsets[i] = (BC7Partitions2[partition] >> i) & 1;
+		else							subsets[i] = BC7Partitions3[partition][i];
+
+		anchors[i] = i == 0 ||
+			(info.numSubsets == 2 && i == BC7Anchors2[partition]) ||
+			(info.numSubsets == 3 && (i == BC7Anchors3a[partition] || i == BC7Anchors3b[partition]));
+	}
+
+	uint32_t indices[16], indices2[16];
+
+	for(uint32_t i = 0; i < 16; i++) indices[i] = reader.read(info.indexBits - (anchors[i] ? 1 : 0));
+
+	if(info.indexBits2){
+		for(uint32_t i = 0; i < 16; i++) indices2[i] = reader.read(info.indexBits2 - (i == 0 ? 1 : 0));
+	}
+
+	// Color and alpha weights, modes 4 and 5 have a separate index set for one of them
+	uint16_t weights[16][4];
+
+	for(uint32_t i = 0; i < 16; i++){
+		uint32_t colorWeight, alphaWeight;
+
+		if(!info.indexBits2){
+			colorWeight = alphaWeight = GetBC7Weights(info.indexBits)[indices[i]];
+		}
+		else if(indexSelection){
+			colorWeight = GetBC7Weights(info.indexBits2)[indices2[i]];
+			alphaWeight = GetBC7Weights(info.indexBits)[indices[i]];
+		}
+		else{
+			colorWeight = GetBC7Weights(info.indexBits)[indices[i]];
+			alphaWeight = GetBC7Weights(info.indexBits2)[indices2[i]];
+		}
+
+		weights[i][0] = weights[i][1] = weights[i][2] = static_cast<uint16_t>(colorWeight);
+		weights[i][3] = static_cast<uint16_t>(alphaWeight);
+	}
+
+	// Interpolate two texels per register, ((64 - w) * e0 + w * e1 + 32) >> 6
+	for(uint32_t i = 0; i < 16; i += 2){
+		const uint32_t *a0 = endpoints[subsets[i] * 2], *b0 = endpoints[subsets[i] * 2 + 1];
+		const uint32_t *a1 = endpoints[subsets[i + 1] * 2], *b1 = endpoints[subsets[i + 1] * 2 + 1];
+
+		__m128i e0 = _mm_setr_epi16(
+			static_cast<short>(a0[0]), static_cast<short>(a0[1]), static_cast<short>(a0[2]), static_cast<short>(a0[3]),
+			static_cast<short>(a1[0]), static_cast<short>(a1[1]), static_cast<short>(a1[2]), static_cast<short>(a1[3]));
+		__m128i e1 = _mm_setr_epi16(
+			static_cast<short>(b0[0]), static_cast<short>(b0[1]), static_cast<short>(b0[2]), static_cast<short>(b0[3]),
+			static_cast<short>(b1[0]), static_cast<short>(b1[1]), static_cast<short>(b1[2]), static_cast<short>(b1[3]));
+		__m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights[i]));
+
+		__m128i result = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(_mm_set1_epi16(64), w), e0), _mm_mullo_epi16(w, e1));
+		result = _mm_srli_epi16(_mm_add_epi16(result, _mm_set1_epi16(32)), 6);
+
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(texels + i * 4), _mm_packus_epi16(result, result));
+	}
+
+	// Rotation swaps alpha with one of the color channels
+	if(rotation){
+		for(uint32_t i = 0; i < 16; i++) std::swap(texels[i * 4 + 3], texels[i * 4 + rotation - 1]);
+	}
+}
+
+void EncodeBlockBC1(const uint8_t *texels, uint8_t *block){
+	EncodeColorBlock(texels, block, true);
+}
+
+void EncodeBlockBC3(const uint8_t *texels, uint8_t *block){
+	EncodeAlphaBlock(texels, block, 3);
+	EncodeColorBlock(texels, block + 8, false);
+}
+
+void EncodeBlockBC4(const uint8_t *texels, uint8_t *block){
+	EncodeAlphaBlock(texels, block, 0);
+}
+
+void EncodeBlockBC5(const uint8_t *texels, uint8_t *block){
+	EncodeAlphaBlock(texels, block, 0);
+	EncodeAlphaBlock(texels, block + 8, 1);
+}
+
+bool DecodeSurface(BlockFormat format, const uint8_t *blocks, size_t width, size_t height,
+	uint8_t *texels, size_t rowPitch, uint32_t numThreads){
+
+	BlockFunc decode = GetDecoder(format);
+
+	if(!decode || !blocks || !texels || width == 0 || height == 0) return false;
+
+	size_t blockSize	= GetBlockSize(format);
+	size_t rowBytes		= GetRowBytes(format, width);
+	size_t numBlocksX	= rowBytes / blockSize;
+
+	Util::ParallelRanges((height + 3) / 4, numThreads, [&](size_t begin, size_t end){
+		uint8_t decoded[64];
+
+		for(size_t blockY = begin; blockY < end; blockY++){
+			const uint8_t *block = blocks + blockY * rowBytes;
+
+			for(size_t blockX = 0; blockX < numBlocksX; blockX++, block += blockSize){
+				decode(block, decoded);
+
+				// Partial blocks on the right and bottom edges are clipped
+				size_t copyWidth	= std::min<size_t>(4, width - blockX * 4);
+				size_t copyHeight	= std::min<size_t>(4, height - blockY * 4);
+
+				for(size_t y = 0; y < copyHeight; y++){
+					memcpy(texels + (blockY * 4 + y) * rowPitch + blockX * 16, decoded + y * 16, copyWidth * 4);
+				}
+			}
+		}
+	});
+
+	return true;
+}
+
+bool EncodeSurface(BlockFormat format, const uint8_t *texels, size_t width, size_t height, size_t rowPitch,
+	uint8_t *blocks, uint32_t numThreads){
+
+	BlockFunc encode = GetEncoder(format);
+
+	if(!encode || !blocks || !texels || width == 0 || height == 0) return false;
+
+	size_t blockSize	= GetBlockSize(format);
+	size_t rowBytes		= GetRowBytes(format, width);
+	size_t numBlocksX	= rowBytes / blockSize;
+
+	Util::ParallelRanges((height + 3) / 4, numThreads, [&](size_t begin, size_t end){
+		uint8_t gathered[64];
+
+		for(size_t blockY = begin; blockY < end; blockY++){
+			uint8_t *block = blocks + blockY * rowBytes;
+
+			for(size_t blockX = 0; blockX < numBlocksX; blockX++, block += blockSize){
+
+				// Replicate the last row and column into partial blocks
+				for(size_t y = 0; y < 4; y++){
+					size_t srcY = std::min(blockY * 4 + y, height - 1);
+
+					for(size_t x = 0; x < 4; x++){
+						size_t srcX = std::min(blockX * 4 + x, width - 1);
+
+						memcpy(gathered + (y * 4 + x) * 4, texels + srcY * rowPitch + srcX * 4, 4);
+					}
+				}
+
+				encode(gathered, block);
+			}
+		}
+	});
+
+	return true;
+}
+
+double ComputePSNR(const uint8_t *imageA, const uint8_t *imageB, size_t width, size_t height, size_t rowPitch, uint32_t channelMask){
+	uint32_t numChannels = (channelMask & 1) + ((channelMask >> 1) & 1) + ((channelMask >> 2) & 1) + ((channelMask >> 3) & 1);
+
+	if(numChannels == 0 || width == 0 || height == 0) return DBL_MAX;
+
+	// Masked channels are zeroed in both images before differencing
+	uint32_t maskBytes = 0;
+
+	for(uint32_t i = 0; i < 4; i++){
+		if(channelMask & (1 << i)) maskBytes |= 0xFFu << (i * 8);
+	}
+
+	__m128i mask = _mm_set1_epi32(maskBytes);
+	__m128i zero = _mm_setzero_si128();
+	double sumSquares = 0.0;
+
+	for(size_t y = 0; y < height; y++){
+		const uint8_t *rowA = imageA + y * rowPitch;
+		const uint8_t *rowB = imageB + y * rowPitch;
+		size_t x = 0;
+
+		// Four texels at a time, squared differences summed in pairs by the multiply-add
+		__m128i rowSum = _mm_setzero_si128();
+
+		for(; x + 4 <= width; x += 4){
+			__m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rowA + x * 4)), mask);
+			__m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rowB + x * 4)), mask);
+
+			__m128i diffLo = _mm_sub_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			__m128i diffHi = _mm_sub_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+			rowSum = _mm_add_epi32(rowSum, _mm_add_epi32(_mm_madd_epi16(diffLo, diffLo), _mm_madd_epi16(diffHi, diffHi)));
+
+			// Flush before the 32-bit lanes can overflow
+			if((x & 0x3FFF) == 0x3FFC){
+				uint32_t lanes[4];
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), rowSum);
+
+				sumSquares	+= static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+				rowSum		= _mm_setzero_si128();
+			}
+		}
+
+		uint32_t lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), rowSum);
+
+		sumSquares += static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+
+		for(; x < width; x++){
+			for(uint32_t channel = 0; channel < 4; channel++){
+				if(!(channelMask & (1 << channel))) continue;
+
+				int32_t diff = rowA[x * 4 + channel] - rowB[x * 4 + channel];
+				sumSquares += diff * diff;
+			}
+		}
+	}
+
+	if(sumSquares == 0.0) return DBL_MAX;
+
+	double mse = sumSquares / (static_cast<double>(width) * height * numChannels);
+
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+/////////////////////////////////
+// CPU block compression codec //
+/////////////////////////////////
+
+namespace BlockCompression{
+
+enum BlockFormat{
+	FormatBC1,
+	FormatBC3,
+	FormatBC4,
+	FormatBC5,
+	FormatBC7,
+};
+
+// Maps a DXGI format onto a CPU codec, SNORM variants and BC2/BC6H are not handled
+bool GetBlockFormat(DXGI_FORMAT format, BlockFormat &blockFormat);
+
+// Bytes per 4x4 block, the surface layout is the same as GetSurfaceInfo in the DDS loader:
+// max(1, (width + 3) / 4) blocks per row and max(1, (height + 3) / 4) rows
+size_t GetBlockSize(BlockFormat format);
+size_t GetRowBytes(BlockFormat format, size_t width);
+size_t GetSurfaceBytes(BlockFormat format, size_t width, size_t height);
+
+// Single block codecs, texels are 16 RGBA8 values in row order.
+// BC4 reads and writes the red channel, BC5 red and green, decoded BC4/BC5 texels get blue 0 and alpha 255
+void DecodeBlockBC1(const uint8_t *block, uint8_t *texels);
+void DecodeBlockBC3(const uint8_t *block, uint8_t *texels);
+void DecodeBlockBC4(const uint8_t *block, uint8_t *texels);
+void DecodeBlockBC5(const uint8_t *block, uint8_t *texels);
+void DecodeBlockBC7(const uint8_t *block, uint8_t *texels);
+
+void EncodeBlockBC1(const uint8_t *texels, uint8_t *block);
+void EncodeBlockBC3(const uint8_t *texels, uint8_t *block);
+void EncodeBlockBC4(const uint8_t *texels, uint8_t *block);
+void EncodeBlockBC5(const uint8_t *texels, uint8_t *block);
+
+// Whole surfaces, block rows are split across numThreads threads (0 uses every core).
+// Decoding writes RGBA8 with the given row pitch, encoding reads RGBA8 and replicates edge texels
+// into partial blocks. Encoding BC7 is not supported and returns false
+bool DecodeSurface(BlockFormat format, const uint8_t *blocks, size_t width, size_t height,
+	uint8_t *texels, size_t rowPitch, uint32_t numThreads = 0);
+bool EncodeSurface(BlockFormat format, const uint8_t *texels, size_t width, size_t height, size_t rowPitch,
+	uint8_t *blocks, uint32_t numThreads = 0);
+
+// Peak signal-to-noise ratio in dB between two RGBA8 images over the channels set in channelMask
+// (bit 0 red to bit 3 alpha), identical images return DBL_MAX
+double ComputePSNR(const uint8_t *imageA, const uint8_t *imageB, size_t width, size_t height, size_t rowPitch,
+	uint32_t channelMask = 0xF);
+
+}
@@ -7,6 +7,11 @@ Camera::Camera(){
 
 	m_proj		= DirectX::XMMatrixIdentity();
 	m_ortho		= DirectX::XMMatrixIdentity();
+
+	m_nearPlane	= 0.0f;
+	m_farPlane	= 1.0f;
+
+	m_dirty		= true;
 }
 
 Camera::~Camera(){
@@ -14,44 +19,55 @@ Camera::~Camera(){
 }
 
 void Camera::setPos(const DirectX::XMFLOAT3 &newPos){
-	m_pos = DirectX::XMLoadFloat3(&newPos);
+	m_pos	= DirectX::XMLoadFloat3(&newPos);
+	m_dirty = true;
 }
 
 void Camera::setTarget(const DirectX::XMFLOAT3 &newTarget){
-	m_target = DirectX::XMLoadFloat3(&newTarget);
+	m_target	= DirectX::XMLoadFloat3(&newTarget);
+	m_dirty		= true;
 }
 
 void Camera::setUp(const DirectX::XMFLOAT3 &newUp){
-	m_up = DirectX::XMLoadFloat3(&newUp);
+	m_up	= DirectX::XMLoadFloat3(&newUp);
+	m_dirty = true;
 }
 
 void Camera::setProperties(float width, float height, float nearPlane, float farPlane){
 	m_proj	= DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV4, (width / height), nearPlane, farPlane);
 	m_ortho = DirectX::XMMatrixOrthographicLH(width, height, nearPlane, farPlane);
+
+	m_nearPlane	= nearPlane;
+	m_farPlane	= farPlane;
+	m_dirty		= true;
 }
 
 void Camera::moveForward(float speed){
-	m_pos = DirectX::XMVectorAdd(m_pos, DirectX::XMVectorScale(m_target, speed));
+	m_pos	= DirectX::XMVectorAdd(m_pos, DirectX::XMVectorScale(m_target, speed));
+	m_dirty = true;
 }
 
 void Camera::moveBackward(float speed){
-	m_pos = DirectX::XMVectorAdd(m_pos, DirectX::XMVectorScale(m_target, -speed));
+	m_pos	= DirectX::XMVectorAdd(m_pos, DirectX::XMVectorScale(m_target, -speed));
+	m_dirty = true;
 }
 
 void Camera::moveLeft(float speed){
 	DirectX::XMVECTOR left = DirectX::XMVectorScale(DirectX::XMVector3Normalize(DirectX::XMVector3Cross(m_target, m_up)), speed);
 
-	m_pos = DirectX::XMVectorAdd(m_pos, DirectX::XMVectorScale(left, speed));
+	m_pos	= DirectX::XMVectorAdd(m_pos, DirectX::XMVectorScale(left, speed));
+	m_dirty = true;
 }
 
 void Camera::moveRight(float speed){
 	DirectX::XMVECTOR right = DirectX::XMVectorScale(DirectX::XMVector3Normalize(DirectX::XMVector3Cross(m_up, m_target)), speed);
 
-	m_pos = DirectX::XMVectorAdd(m_pos, DirectX::XMVectorScale(right, speed));
+	m_pos	= DirectX::XMVectorAdd(m_pos, DirectX::XMVectorScale(right, speed));
+	m_dirty = true;
 }
 
 void Camera::rotate(float pitch, float yaw){
-	DirectX::XMVECTOR right		= getRight();
+	DirectX::XMVECTOR right		= DirectX::XMVector3Normalize(DirectX::XMVector3Cross(m_target, m_up));
 	DirectX::XMMATRIX rotation	= DirectX::XMMatrixRotationAxis(right, -pitch);
 
 	m_up		= DirectX::XMVector3TransformNormal(m_up, rotation);
@@ -62,6 +78,43 @@ void Camera::rotate(float pitch, float yaw){
 	right		= DirectX::XMVector3TransformNormal(right, rotation);
 	m_up		= DirectX::XMVector3TransformNormal(m_up, rotation);
 	m_target	= DirectX::XMVector3TransformNormal(m_target, rotation);
+
+	m_dirty		= true;
+}
+
+void Camera::update() const{
+	if(!m_dirty) return;
+
+	m_right		= DirectX::XMVector3Normalize(DirectX::XMVector3Cross(m_target, m_up));
+
+	// Row-major matrices
+	m_view		= DirectX::XMMatrixLookAtLH(m_pos, DirectX::XMVectorAdd(m_target, m_pos), m_up);
+	m_viewProj	= DirectX::XMMatrixMultiply(m_view, m_proj);
+
+	m_invView		= DirectX::XMMatrixInverse(nullptr, m_view);
+	m_invViewProj	= DirectX::XMMatrixInverse(nullptr, m_viewProj);
+
+	// Transposed copies for the shaders
+	m_viewT		= DirectX::XMMatrixTranspose(m_view);
+	m_projT		= DirectX::XMMatrixTranspose(m_proj);
+	m_orthoT	= DirectX::XMMatrixTranspose(m_ortho);
+	m_viewProjT = DirectX::XMMatrixTranspose(m_viewProj);
+
+	// Extract frustum planes from the columns of the view-projection matrix (z in [0, 1])
+	const DirectX::XMMATRIX &cols = m_viewProjT;
+
+	m_frustum[PlaneLeft]	= DirectX::XMPlaneNormalize(DirectX::XMVectorAdd(cols.r[3], cols.r[0]));
+	m_frustum[PlaneRight]	= DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(cols.r[3], cols.r[0]));
+	m_frustum[PlaneBottom]	= DirectX::XMPlaneNormalize(DirectX::XMVectorAdd(cols.r[3], cols.r[1]));
+	m_frustum[PlaneTop]		= DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(cols.r[3], cols.r[1]));
+	m_frustum[PlaneNear]	= DirectX::XMPlaneNormalize(cols.r[2]);
+	m_frustum[PlaneFar]		= DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(cols.r[3], cols.r[2]));
+
+	m_dirty = false;
+}
+
+bool Camera::isDirty() const{
+	return m_dirty;
 }
 
 DirectX::XMVECTOR Camera::getPos() const{
@@ -77,18 +130,68 @@ DirectX::XMVECTOR Camera::getUp() const{
 }
 
 DirectX::XMVECTOR Camera::getRight() const{
-	return DirectX::XMVector3Normalize(DirectX::XMVector3Cross(m_target, m_up));
+	update();
+	return m_right;
+}
+
+float Camera::getNearPlane() const{
+	return m_nearPlane;
+}
+
+float Camera::getFarPlane() const{
+	return m_farPlane;
 }
 
 DirectX::XMMATRIX Camera::getViewMatrix() const{
-	return DirectX::XMMatrixTranspose(DirectX::XMMatrixLookAtLH(m_pos, DirectX::XMVectorAdd(m_target, m_pos), m_up));
+	update();
+	return m_viewT;
 }
 
 DirectX::XMMATRIX Camera::getProjMatrix() const{
-	return DirectX::XMMatrixTranspose(m_proj);
+	update();
+	return m_projT;
 }
 
 DirectX::XMMATRIX Camera::getOrthoMatrix() const{
-	return DirectX::XMMatrixTranspose(m_ortho);
+	update();
+	return m_orthoT;
+}
+
+DirectX::XMMATRIX Camera::getViewProjMatrix() const{
+	update();
+	return m_viewProjT;
+}
+
+DirectX::XMMATRIX Camera::getInvViewMatrix() const{
+	update();
+	return m_invView;
+}
+
+DirectX::XMMATRIX Camera::getInvViewProjMatrix() const{
+	update();
+	return m_invViewProj;
+}
+
+DirectX::XMMATRIX Camera::getViewProjMatrixCPU() const{
+	update();
+	return m_viewProj;
+}
+
+DirectX::XMVECTOR Camera::getFrustumPlane(FrustumPlane plane) const{
+	update();
+	return m_frustum[plane];
+}
+
+const DirectX::XMVECTOR *Camera::getFrustumPlanes() const{
+	update();
+	return m_frustum;
+}
+
+void UpdateCameras(Camera * const *cameras, uint32_t numCameras){
+
+	// Only dirty cameras do any work, so this is cheap to call every frame on all views
+	for(uint32_t i = 0; i < numCameras; i++){
+		cameras[i]->update();
+	}
 }
 
@@ -5,9 +5,31 @@
 //////////////////
 
 class Camera{
+public:
+
+	// Frustum plane indices, planes are stored as (a, b, c, d) with normals pointing inwards
+	enum FrustumPlane{
+		PlaneLeft = 0,
+		PlaneRight,
+		PlaneBottom,
+		PlaneTop,
+		PlaneNear,
+		PlaneFar,
+		PlaneCount
+	};
+
 private:
 	DirectX::XMMATRIX m_proj, m_ortho;
 	DirectX::XMVECTOR m_pos, m_target, m_up;
+	float m_nearPlane, m_farPlane;
+
+	// Cached derived data, rebuilt by update() only when the camera has changed
+	mutable DirectX::XMMATRIX m_view, m_viewProj, m_invView, m_invViewProj;
+	mutable DirectX::XMMATRIX m_viewT, m_projT, m_orthoT, m_viewProjT;
+	mutable DirectX::XMVECTOR m_right;
+	mutable DirectX::XMVECTOR m_frustum[PlaneCount];
+
+	mutable bool m_dirty;
 
 public:
 	Camera();
@@ -25,12 +47,32 @@ public:
 
 	void rotate(float pitch, float yaw);
 
+	// Rebuilds the cached matrices and frustum planes if anything changed since the last call
+	void update() const;
+	bool isDirty() const;
+
 	DirectX::XMVECTOR getPos() const;
 	DirectX::XMVECTOR getTarget() const;
 	DirectX::XMVECTOR getUp() const;
 	DirectX::XMVECTOR getRight() const;
 
+	float getNearPlane() const;
+	float getFarPlane() const;
+
+	// Transposed matrices, ready to be copied into constant buffers
 	DirectX::XMMATRIX getViewMatrix() const;
 	DirectX::XMMATRIX getProjMatrix() const;
 	DirectX::XMMATRIX getOrthoMatrix() const;
+	DirectX::XMMATRIX getViewProjMatrix() const;
+
+	// Row-major matrices for CPU-side math (culling, picking)
+	DirectX::XMMATRIX getInvViewMatrix() const;
+	DirectX::XMMATRIX getInvViewProjMatrix() const;
+	DirectX::XMMATRIX getViewProjMatrixCPU() const;
+
+	DirectX::XMVECTOR getFrustumPlane(FrustumPlane plane) const;
+	const DirectX::XMVECTOR *getFrustumPlanes() const;
 };
+
+// Updates a batch of cameras (shadow cascades, probes, reflection views) in one pass
+void UpdateCameras(Camera * const *cameras, uint32_t numCameras);
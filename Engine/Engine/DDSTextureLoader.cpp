@@ -23,6 +23,7 @@
 #include <memory>
 
 #include "DDSTextureLoader.h"
+#include "Engine.h"
 
 #if !defined(NO_D3D11_DEBUG_NAME) && ( defined(_DEBUG) || defined(PROFILE) )
 #pragma comment(lib,"dxguid.lib")
@@ -66,6 +67,9 @@ struct DDS_PIXELFORMAT
 #define DDS_ALPHA       0x00000002  // DDPF_ALPHA
 
 #define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+#define DDS_HEADER_FLAGS_MIPMAP         0x00020000  // DDSD_MIPMAPCOUNT
+
+#define DDS_SURFACE_FLAGS_MIPMAP 0x00400008 // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
 
 #define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
 #define DDS_WIDTH  0x00000004 // DDSD_WIDTH
@@ -123,7 +127,11 @@ namespace
 
 	struct handle_closer { void operator()(HANDLE h) { if(h) CloseHandle(h); } };
 
-	typedef public std::unique_ptr<void, handle_closer> ScopedHandle;
+	typedef std::unique_ptr<void, handle_closer> ScopedHandle;
+
+	struct view_unmapper { void operator()(const uint8_t* p) { if(p) UnmapViewOfFile(p); } };
+
+	typedef std::unique_ptr<const uint8_t, view_unmapper> ScopedView;
 
 	inline HANDLE safe_handle(HANDLE h) { return (h == INVALID_HANDLE_VALUE) ? 0 : h; }
 
@@ -140,124 +148,6 @@ namespace
 
 };
 
-//--------------------------------------------------------------------------------------
-static HRESULT LoadTextureDataFromFile(_In_z_ const wchar_t* fileName,
-	std::unique_ptr<uint8_t[]>& ddsData,
-	DDS_HEADER** header,
-	uint8_t** bitData,
-	size_t* bitSize
-	)
-{
-	if(!header || !bitData || !bitSize)
-	{
-		return E_POINTER;
-	}
-
-	// open the file
-	ScopedHandle hFile(safe_handle(CreateFileW(fileName,
-		GENERIC_READ,
-		FILE_SHARE_READ,
-		nullptr,
-		OPEN_EXISTING,
-		FILE_ATTRIBUTE_NORMAL,
-		nullptr)));
-
-	if(!hFile)
-	{
-		return HRESULT_FROM_WIN32(GetLastError());
-	}
-
-	// Get the file size
-	LARGE_INTEGER FileSize = {0};
-
-#if (_WIN32_WINNT >= _WIN32_WINNT_VISTA)
-	FILE_STANDARD_INFO fileInfo;
-	if(!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
-	{
-		return HRESULT_FROM_WIN32(GetLastError());
-	}
-	FileSize = fileInfo.EndOfFile;
-#else
-	GetFileSizeEx(hFile.get(), &FileSize);
-#endif
-
-	// File is too big for 32-bit allocation, so reject read
-	if(FileSize.HighPart > 0)
-	{
-		return E_FAIL;
-	}
-
-	// Need at least enough data to fill the header and magic number to be a valid DDS
-	if(FileSize.LowPart < (sizeof(DDS_HEADER) + sizeof(uint32_t)))
-	{
-		return E_FAIL;
-	}
-
-	// create enough space for the file data
-	ddsData.reset(new (std::nothrow) uint8_t[FileSize.LowPart]);
-	if(!ddsData)
-	{
-		return E_OUTOFMEMORY;
-	}
-
-	// read the data in
-	DWORD BytesRead = 0;
-	if(!ReadFile(hFile.get(),
-		ddsData.get(),
-		FileSize.LowPart,
-		&BytesRead,
-		nullptr
-		))
-	{
-		return HRESULT_FROM_WIN32(GetLastError());
-	}
-
-	if(BytesRead < FileSize.LowPart)
-	{
-		return E_FAIL;
-	}
-
-	// DDS files always start with the same magic number ("DDS ")
-	uint32_t dwMagicNumber = *(const uint32_t*)(ddsData.get());
-	if(dwMagicNumber != DDS_MAGIC)
-	{
-		return E_FAIL;
-	}
-
-	auto hdr = reinterpret_cast<DDS_HEADER*>(ddsData.get() + sizeof(uint32_t));
-
-	// Verify header to validate DDS file
-	if(hdr->size != sizeof(DDS_HEADER) ||
-		hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
-	{
-		return E_FAIL;
-	}
-
-	// Check for DX10 extension
-	bool bDXT10Header = false;
-	if((hdr->ddspf.flags & DDS_FOURCC) &&
-		(MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
-	{
-		// Must be long enough for both headers and magic value
-		if(FileSize.LowPart < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
-		{
-			return E_FAIL;
-		}
-
-		bDXT10Header = true;
-	}
-
-	// setup the pointers in the process request
-	*header = hdr;
-	ptrdiff_t offset = sizeof(uint32_t) + sizeof(DDS_HEADER)
-		+ (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
-	*bitData = ddsData.get() + offset;
-	*bitSize = FileSize.LowPart - offset;
-
-	return S_OK;
-}
-
-
 //--------------------------------------------------------------------------------------
 // Return the BPP for a particular format
 //--------------------------------------------------------------------------------------
@@ -787,6 +677,65 @@ static DXGI_FORMAT MakeSRGB(_In_ DXGI_FORMAT format)
 
 
 //--------------------------------------------------------------------------------------
+static bool IsSRGB(_In_ DXGI_FORMAT format)
+{
+	switch(format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Levels of a full chain down to 1x1x1
+static size_t CountFullMipChain(_In_ size_t width,
+	_In_ size_t height,
+	_In_ size_t depth)
+{
+	size_t largest = std::max(std::max(width, height), depth);
+	size_t mipCount = 1;
+
+	while(largest > 1)
+	{
+		largest >>= 1;
+		++mipCount;
+	}
+
+	return mipCount;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Single 2D surfaces without mips that GenerateDDSMipsFromMemory can build a chain for
+static bool CanGenerateMipsOnCPU(_In_ uint32_t resDim,
+	_In_ size_t mipCount,
+	_In_ UINT arraySize,
+	_In_ bool isCubeMap,
+	_In_ DXGI_FORMAT format)
+{
+	return mipCount == 1
+		&& resDim == D3D11_RESOURCE_DIMENSION_TEXTURE2D
+		&& arraySize == 1
+		&& !isCubeMap
+		&& MipGenerator::IsFormatSupported(format);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Lays out bitSize bytes of bit data and points initData at the subresources that fit maxsize.
+// bitData holds the windowSize bytes starting windowOffset bytes into the bit data, and every
+// kept subresource has to lie inside it. keptOffset and keptEnd bound the kept subresources.
+// Without bitData and initData only the layout is computed and no pointers are formed
 static HRESULT FillInitData(_In_ size_t width,
 	_In_ size_t height,
 	_In_ size_t depth,
@@ -794,15 +743,19 @@ static HRESULT FillInitData(_In_ size_t width,
 	_In_ size_t arraySize,
 	_In_ DXGI_FORMAT format,
 	_In_ size_t maxsize,
-	_In_ size_t bitSize,
-	_In_reads_bytes_(bitSize) const uint8_t* bitData,
+	_In_ uint64_t bitSize,
+	_In_ uint64_t windowOffset,
+	_In_ size_t windowSize,
+	_In_reads_bytes_opt_(windowSize) const uint8_t* bitData,
 	_Out_ size_t& twidth,
 	_Out_ size_t& theight,
 	_Out_ size_t& tdepth,
 	_Out_ size_t& skipMip,
-	_Out_writes_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData)
+	_Out_ uint64_t& keptOffset,
+	_Out_ uint64_t& keptEnd,
+	_Out_writes_opt_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData)
 {
-	if(!bitData || !initData)
+	if(!bitData != !initData)
 	{
 		return E_POINTER;
 	}
@@ -811,11 +764,12 @@ static HRESULT FillInitData(_In_ size_t width,
 	twidth = 0;
 	theight = 0;
 	tdepth = 0;
+	keptOffset = 0;
+	keptEnd = 0;
 
 	size_t NumBytes = 0;
 	size_t RowBytes = 0;
-	const uint8_t* pSrcBits = bitData;
-	const uint8_t* pEndBits = bitData + bitSize;
+	uint64_t position = 0;
 
 	size_t index = 0;
 	for(size_t j = 0; j < arraySize; j++)
@@ -833,6 +787,12 @@ static HRESULT FillInitData(_In_ size_t width,
 				nullptr
 				);
 
+			uint64_t surfaceBytes = static_cast<uint64_t>(NumBytes) * d;
+			if(surfaceBytes > bitSize - position)
+			{
+				return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+			}
+
 			if((mipCount <= 1) || !maxsize || (w <= maxsize && h <= maxsize && d <= maxsize))
 			{
 				if(!twidth)
@@ -840,13 +800,24 @@ static HRESULT FillInitData(_In_ size_t width,
 					twidth = w;
 					theight = h;
 					tdepth = d;
+					keptOffset = position;
 				}
 
-				assert(index < mipCount * arraySize);
-				_Analysis_assume_(index < mipCount * arraySize);
-				initData[index].pSysMem = (const void*)pSrcBits;
-				initData[index].SysMemPitch = static_cast<UINT>(RowBytes);
-				initData[index].SysMemSlicePitch = static_cast<UINT>(NumBytes);
+				keptEnd = position + surfaceBytes;
+
+				if(initData)
+				{
+					if(position < windowOffset || position + surfaceBytes > windowOffset + windowSize)
+					{
+						return E_UNEXPECTED;
+					}
+
+					assert(index < mipCount * arraySize);
+					_Analysis_assume_(index < mipCount * arraySize);
+					initData[index].pSysMem = bitData + static_cast<size_t>(position - windowOffset);
+					initData[index].SysMemPitch = static_cast<UINT>(RowBytes);
+					initData[index].SysMemSlicePitch = static_cast<UINT>(NumBytes);
+				}
 				++index;
 			}
 			else if(!j)
@@ -855,12 +826,7 @@ static HRESULT FillInitData(_In_ size_t width,
 				++skipMip;
 			}
 
-			if(pSrcBits + (NumBytes*d) > pEndBits)
-			{
-				return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
-			}
-
-			pSrcBits += NumBytes * d;
+			position += surfaceBytes;
 
 			w = w >> 1;
 			h = h >> 1;
@@ -913,6 +879,13 @@ static HRESULT CreateD3DResources(_In_ ID3D11Device* d3dDevice,
 		format = MakeSRGB(format);
 	}
 
+	// Counted against the GPU memory budget before anything is created
+	GpuAllocationId allocation = ReserveGpuMemory(GetGpuMemoryCategory(bindFlags, usage),
+		GetTextureMemorySize(width, height, depth, mipCount, arraySize, format));
+
+	if(allocation == GpuMemoryTracker::InvalidAllocation)
+		return E_OUTOFMEMORY;
+
 	switch(resDim)
 	{
 	case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
@@ -932,6 +905,7 @@ static HRESULT CreateD3DResources(_In_ ID3D11Device* d3dDevice,
 			initData,
 			&tex
 			);
+		BindGpuMemory(SUCCEEDED(hr) ? tex : nullptr, allocation);
 		if(SUCCEEDED(hr) && tex != 0)
 		{
 			if(textureView != 0)
@@ -1003,6 +977,7 @@ static HRESULT CreateD3DResources(_In_ ID3D11Device* d3dDevice,
 			initData,
 			&tex
 			);
+		BindGpuMemory(SUCCEEDED(hr) ? tex : nullptr, allocation);
 		if(SUCCEEDED(hr) && tex != 0)
 		{
 			if(textureView != 0)
@@ -1081,6 +1056,7 @@ static HRESULT CreateD3DResources(_In_ ID3D11Device* d3dDevice,
 			initData,
 			&tex
 			);
+		BindGpuMemory(SUCCEEDED(hr) ? tex : nullptr, allocation);
 		if(SUCCEEDED(hr) && tex != 0)
 		{
 			if(textureView != 0)
@@ -1115,6 +1091,10 @@ static HRESULT CreateD3DResources(_In_ ID3D11Device* d3dDevice,
 		}
 	}
 		break;
+
+	default:
+		BindGpuMemory(nullptr, allocation);
+		break;
 	}
 
 	return hr;
@@ -1122,32 +1102,28 @@ static HRESULT CreateD3DResources(_In_ ID3D11Device* d3dDevice,
 
 
 //--------------------------------------------------------------------------------------
-static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
-	_In_opt_ ID3D11DeviceContext* d3dContext,
-	_In_ const DDS_HEADER* header,
-	_In_reads_bytes_(bitSize) const uint8_t* bitData,
-	_In_ size_t bitSize,
-	_In_ size_t maxsize,
-	_In_ D3D11_USAGE usage,
-	_In_ unsigned int bindFlags,
-	_In_ unsigned int cpuAccessFlags,
-	_In_ unsigned int miscFlags,
-	_In_ bool forceSRGB,
-	_Outptr_opt_ ID3D11Resource** texture,
-	_Outptr_opt_ ID3D11ShaderResourceView** textureView)
+// Decode and bound-check the texture description stored in the DDS headers
+//--------------------------------------------------------------------------------------
+static HRESULT ParseDDSHeader(_In_ const DDS_HEADER* header,
+	_Out_ uint32_t& resDim,
+	_Out_ UINT& width,
+	_Out_ UINT& height,
+	_Out_ UINT& depth,
+	_Out_ size_t& mipCount,
+	_Out_ UINT& arraySize,
+	_Out_ DXGI_FORMAT& format,
+	_Out_ bool& isCubeMap)
 {
-	HRESULT hr = S_OK;
-
-	UINT width = header->width;
-	UINT height = header->height;
-	UINT depth = header->depth;
+	width = header->width;
+	height = header->height;
+	depth = header->depth;
 
-	uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
-	UINT arraySize = 1;
-	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
-	bool isCubeMap = false;
+	resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+	arraySize = 1;
+	format = DXGI_FORMAT_UNKNOWN;
+	isCubeMap = false;
 
-	size_t mipCount = header->mipMapCount;
+	mipCount = header->mipMapCount;
 	if(0 == mipCount)
 	{
 		mipCount = 1;
@@ -1304,6 +1280,45 @@ static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
 		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
 	}
 
+	return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// bitData is a window of windowSize bytes, windowOffset bytes into the bitSize bytes of bit data
+// the header describes. It has to cover every subresource that fits maxsize
+static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
+	_In_opt_ ID3D11DeviceContext* d3dContext,
+	_In_ const DDS_HEADER* header,
+	_In_ uint64_t bitSize,
+	_In_ uint64_t windowOffset,
+	_In_ size_t windowSize,
+	_In_reads_bytes_(windowSize) const uint8_t* bitData,
+	_In_ size_t maxsize,
+	_In_ D3D11_USAGE usage,
+	_In_ unsigned int bindFlags,
+	_In_ unsigned int cpuAccessFlags,
+	_In_ unsigned int miscFlags,
+	_In_ bool forceSRGB,
+	_Outptr_opt_ ID3D11Resource** texture,
+	_Outptr_opt_ ID3D11ShaderResourceView** textureView)
+{
+	UINT width = 0;
+	UINT height = 0;
+	UINT depth = 0;
+
+	uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+	UINT arraySize = 1;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	bool isCubeMap = false;
+	size_t mipCount = 1;
+
+	HRESULT hr = ParseDDSHeader(header, resDim, width, height, depth, mipCount, arraySize, format, isCubeMap);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
 	bool autogen = false;
 	if(mipCount == 1 && d3dContext != 0 && textureView != 0) // Must have context and shader-view to auto generate mipmaps
 	{
@@ -1323,9 +1338,14 @@ static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
 
 	if(autogen)
 	{
-		// Create texture with auto-generated mipmaps
+		// A single mip is always kept, so the window starts at the top level
+		assert(windowOffset == 0);
+
+		// Create texture with auto-generated mipmaps. The level count is spelled out so the budget is
+		// charged for the whole chain GenerateMips fills, not just the uploaded top level
 		ID3D11Resource* tex = nullptr;
-		hr = CreateD3DResources(d3dDevice, resDim, width, height, depth, 0, arraySize,
+		size_t autogenMipCount = CountFullMipChain(width, height, (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE3D) ? depth : 1);
+		hr = CreateD3DResources(d3dDevice, resDim, width, height, depth, autogenMipCount, arraySize,
 			format, usage,
 			bindFlags | D3D11_BIND_RENDER_TARGET,
 			cpuAccessFlags,
@@ -1337,7 +1357,7 @@ static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
 			size_t rowBytes = 0;
 			GetSurfaceInfo(width, height, format, &numBytes, &rowBytes, nullptr);
 
-			if(numBytes > bitSize)
+			if(numBytes > windowSize)
 			{
 				(*textureView)->Release();
 				*textureView = nullptr;
@@ -1368,11 +1388,10 @@ static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
 
 			if(arraySize > 1)
 			{
-				const uint8_t* pSrcBits = bitData;
-				const uint8_t* pEndBits = bitData + bitSize;
+				size_t position = 0;
 				for(UINT item = 0; item < arraySize; ++item)
 				{
-					if((pSrcBits + numBytes) > pEndBits)
+					if(numBytes > windowSize - position)
 					{
 						(*textureView)->Release();
 						*textureView = nullptr;
@@ -1381,8 +1400,8 @@ static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
 					}
 
 					UINT res = D3D11CalcSubresource(0, item, mipLevels);
-					d3dContext->UpdateSubresource(tex, res, nullptr, pSrcBits, static_cast<UINT>(rowBytes), static_cast<UINT>(numBytes));
-					pSrcBits += numBytes;
+					d3dContext->UpdateSubresource(tex, res, nullptr, bitData + position, static_cast<UINT>(rowBytes), static_cast<UINT>(numBytes));
+					position += numBytes;
 				}
 			}
 			else
@@ -1404,7 +1423,8 @@ static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
 	}
 	else
 	{
-		// Create the texture
+		// Create the texture with the mips the file has, single-mip files get their chain when they
+		// are packed (see BuildTexturePack) rather than on every load
 		std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> initData(new (std::nothrow) D3D11_SUBRESOURCE_DATA[mipCount * arraySize]);
 		if(!initData)
 		{
@@ -1415,8 +1435,10 @@ static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
 		size_t twidth = 0;
 		size_t theight = 0;
 		size_t tdepth = 0;
-		hr = FillInitData(width, height, depth, mipCount, arraySize, format, maxsize, bitSize, bitData,
-			twidth, theight, tdepth, skipMip, initData.get());
+		uint64_t keptOffset = 0;
+		uint64_t keptEnd = 0;
+		hr = FillInitData(width, height, depth, mipCount, arraySize, format, maxsize, bitSize, windowOffset, windowSize, bitData,
+			twidth, theight, tdepth, skipMip, keptOffset, keptEnd, initData.get());
 
 		if(SUCCEEDED(hr))
 		{
@@ -1456,8 +1478,8 @@ static HRESULT CreateTextureFromDDS(_In_ ID3D11Device* d3dDevice,
 					break;
 				}
 
-				hr = FillInitData(width, height, depth, mipCount, arraySize, format, maxsize, bitSize, bitData,
-					twidth, theight, tdepth, skipMip, initData.get());
+				hr = FillInitData(width, height, depth, mipCount, arraySize, format, maxsize, bitSize, windowOffset, windowSize, bitData,
+					twidth, theight, tdepth, skipMip, keptOffset, keptEnd, initData.get());
 				if(SUCCEEDED(hr))
 				{
 					hr = CreateD3DResources(d3dDevice, resDim, twidth, theight, tdepth, mipCount - skipMip, arraySize,
@@ -1502,64 +1524,259 @@ static DDS_ALPHA_MODE GetAlphaMode(_In_ const DDS_HEADER* header)
 
 
 //--------------------------------------------------------------------------------------
-_Use_decl_annotations_
-HRESULT DirectX::CreateDDSTextureFromMemory(ID3D11Device* d3dDevice,
-const uint8_t* ddsData,
-size_t ddsDataSize,
-ID3D11Resource** texture,
-ID3D11ShaderResourceView** textureView,
-size_t maxsize,
-DDS_ALPHA_MODE* alphaMode)
+static HRESULT GetDDSHeaderFromMemory(_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+	_In_ size_t ddsDataSize,
+	_Out_ const DDS_HEADER** header,
+	_Out_ size_t* offset)
 {
-	return CreateDDSTextureFromMemoryEx(d3dDevice, nullptr, ddsData, ddsDataSize, maxsize,
-		D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, false,
-		texture, textureView, alphaMode);
-}
+	if(ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+	{
+		return E_FAIL;
+	}
 
-_Use_decl_annotations_
-HRESULT DirectX::CreateDDSTextureFromMemory(ID3D11Device* d3dDevice,
-ID3D11DeviceContext* d3dContext,
-const uint8_t* ddsData,
-size_t ddsDataSize,
-ID3D11Resource** texture,
-ID3D11ShaderResourceView** textureView,
-size_t maxsize,
-DDS_ALPHA_MODE* alphaMode)
-{
-	return CreateDDSTextureFromMemoryEx(d3dDevice, d3dContext, ddsData, ddsDataSize, maxsize,
-		D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, false,
-		texture, textureView, alphaMode);
-}
+	uint32_t dwMagicNumber = *(const uint32_t*)(ddsData);
+	if(dwMagicNumber != DDS_MAGIC)
+	{
+		return E_FAIL;
+	}
 
-_Use_decl_annotations_
-HRESULT DirectX::CreateDDSTextureFromMemoryEx(ID3D11Device* d3dDevice,
-const uint8_t* ddsData,
-size_t ddsDataSize,
-size_t maxsize,
-D3D11_USAGE usage,
-unsigned int bindFlags,
-unsigned int cpuAccessFlags,
-unsigned int miscFlags,
-bool forceSRGB,
-ID3D11Resource** texture,
-ID3D11ShaderResourceView** textureView,
-DDS_ALPHA_MODE* alphaMode)
-{
-	return CreateDDSTextureFromMemoryEx(d3dDevice, nullptr, ddsData, ddsDataSize, maxsize,
-		usage, bindFlags, cpuAccessFlags, miscFlags, forceSRGB,
-		texture, textureView, alphaMode);
-}
+	auto hdr = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
 
-_Use_decl_annotations_
-HRESULT DirectX::CreateDDSTextureFromMemoryEx(ID3D11Device* d3dDevice,
-ID3D11DeviceContext* d3dContext,
-const uint8_t* ddsData,
-size_t ddsDataSize,
-size_t maxsize,
-D3D11_USAGE usage,
-unsigned int bindFlags,
-unsigned int cpuAccessFlags,
-unsigned int miscFlags,
+	// Verify header to validate DDS file
+	if(hdr->size != sizeof(DDS_HEADER) ||
+		hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+	{
+		return E_FAIL;
+	}
+
+	// Check for DX10 extension
+	bool bDXT10Header = false;
+	if((hdr->ddspf.flags & DDS_FOURCC) &&
+		(MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
+	{
+		// Must be long enough for both headers and magic value
+		if(ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
+		{
+			return E_FAIL;
+		}
+
+		bDXT10Header = true;
+	}
+
+	*header = hdr;
+	*offset = sizeof(uint32_t)
+		+ sizeof(DDS_HEADER)
+		+ (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
+
+	return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reads the headers into headerData and maps only the part of the file holding the
+// subresources that fit maxsize. Views are limited by the address space rather than the
+// file size, so files past 4 GB load on 32-bit builds as long as what is kept fits
+static HRESULT LoadTextureDataFromFile(_In_z_ const wchar_t* fileName,
+	_In_ size_t maxsize,
+	_Out_writes_bytes_(sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)) uint8_t* headerData,
+	ScopedView& ddsData,
+	const DDS_HEADER** header,
+	uint64_t* bitSize,
+	uint64_t* windowOffset,
+	size_t* windowSize,
+	const uint8_t** bitData
+	)
+{
+	if(!headerData || !header || !bitSize || !windowOffset || !windowSize || !bitData)
+	{
+		return E_POINTER;
+	}
+
+	// open the file
+	ScopedHandle hFile(safe_handle(CreateFileW(fileName,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr)));
+
+	if(!hFile)
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	// Get the file size
+	LARGE_INTEGER FileSize = {0};
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_VISTA)
+	FILE_STANDARD_INFO fileInfo;
+	if(!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+	FileSize = fileInfo.EndOfFile;
+#else
+	GetFileSizeEx(hFile.get(), &FileSize);
+#endif
+
+	if(FileSize.QuadPart < 0)
+	{
+		return E_FAIL;
+	}
+
+	uint64_t fileSize = static_cast<uint64_t>(FileSize.QuadPart);
+
+	// Validate the headers before anything is mapped
+	DWORD bytesRead = 0;
+	if(!ReadFile(hFile.get(), headerData, sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10), &bytesRead, nullptr))
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	size_t offset = 0;
+	HRESULT hr = GetDDSHeaderFromMemory(headerData, bytesRead, header, &offset);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	UINT width = 0;
+	UINT height = 0;
+	UINT depth = 0;
+	uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+	UINT arraySize = 1;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	bool isCubeMap = false;
+	size_t mipCount = 1;
+
+	hr = ParseDDSHeader(*header, resDim, width, height, depth, mipCount, arraySize, format, isCubeMap);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	// Range of the bit data the texture will be created from
+	size_t twidth = 0;
+	size_t theight = 0;
+	size_t tdepth = 0;
+	size_t skipMip = 0;
+	uint64_t keptOffset = 0;
+	uint64_t keptEnd = 0;
+
+	hr = FillInitData(width, height, depth, mipCount, arraySize, format, maxsize, fileSize - offset, 0, 0, nullptr,
+		twidth, theight, tdepth, skipMip, keptOffset, keptEnd, nullptr);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	// Views start on an allocation granularity boundary
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+
+	uint64_t windowStart = offset + keptOffset;
+	uint64_t viewStart = windowStart - windowStart % systemInfo.dwAllocationGranularity;
+	uint64_t viewSize = offset + keptEnd - viewStart;
+
+	if(viewSize > static_cast<uint64_t>(SIZE_MAX))
+	{
+		return HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE);
+	}
+
+	// map the file read-only, the view keeps the mapping alive once the handles are closed
+	ScopedHandle hMapping(CreateFileMappingW(hFile.get(),
+		nullptr,
+		PAGE_READONLY,
+		0,
+		0,
+		nullptr));
+
+	if(!hMapping)
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	ddsData.reset(static_cast<const uint8_t*>(MapViewOfFile(hMapping.get(),
+		FILE_MAP_READ,
+		static_cast<DWORD>(viewStart >> 32),
+		static_cast<DWORD>(viewStart & 0xFFFFFFFF),
+		static_cast<size_t>(viewSize))));
+
+	if(!ddsData)
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	// the subresource pointers point straight into the mapped view
+	*bitSize = fileSize - offset;
+	*windowOffset = keptOffset;
+	*windowSize = static_cast<size_t>(keptEnd - keptOffset);
+	*bitData = ddsData.get() + static_cast<size_t>(windowStart - viewStart);
+
+	return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromMemory(ID3D11Device* d3dDevice,
+const uint8_t* ddsData,
+size_t ddsDataSize,
+ID3D11Resource** texture,
+ID3D11ShaderResourceView** textureView,
+size_t maxsize,
+DDS_ALPHA_MODE* alphaMode)
+{
+	return CreateDDSTextureFromMemoryEx(d3dDevice, nullptr, ddsData, ddsDataSize, maxsize,
+		D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, false,
+		texture, textureView, alphaMode);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromMemory(ID3D11Device* d3dDevice,
+ID3D11DeviceContext* d3dContext,
+const uint8_t* ddsData,
+size_t ddsDataSize,
+ID3D11Resource** texture,
+ID3D11ShaderResourceView** textureView,
+size_t maxsize,
+DDS_ALPHA_MODE* alphaMode)
+{
+	return CreateDDSTextureFromMemoryEx(d3dDevice, d3dContext, ddsData, ddsDataSize, maxsize,
+		D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, false,
+		texture, textureView, alphaMode);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromMemoryEx(ID3D11Device* d3dDevice,
+const uint8_t* ddsData,
+size_t ddsDataSize,
+size_t maxsize,
+D3D11_USAGE usage,
+unsigned int bindFlags,
+unsigned int cpuAccessFlags,
+unsigned int miscFlags,
+bool forceSRGB,
+ID3D11Resource** texture,
+ID3D11ShaderResourceView** textureView,
+DDS_ALPHA_MODE* alphaMode)
+{
+	return CreateDDSTextureFromMemoryEx(d3dDevice, nullptr, ddsData, ddsDataSize, maxsize,
+		usage, bindFlags, cpuAccessFlags, miscFlags, forceSRGB,
+		texture, textureView, alphaMode);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromMemoryEx(ID3D11Device* d3dDevice,
+ID3D11DeviceContext* d3dContext,
+const uint8_t* ddsData,
+size_t ddsDataSize,
+size_t maxsize,
+D3D11_USAGE usage,
+unsigned int bindFlags,
+unsigned int cpuAccessFlags,
+unsigned int miscFlags,
 bool forceSRGB,
 ID3D11Resource** texture,
 ID3D11ShaderResourceView** textureView,
@@ -1584,46 +1801,17 @@ DDS_ALPHA_MODE* alphaMode)
 	}
 
 	// Validate DDS file in memory
-	if(ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
-	{
-		return E_FAIL;
-	}
-
-	uint32_t dwMagicNumber = *(const uint32_t*)(ddsData);
-	if(dwMagicNumber != DDS_MAGIC)
-	{
-		return E_FAIL;
-	}
-
-	auto header = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
-
-	// Verify header to validate DDS file
-	if(header->size != sizeof(DDS_HEADER) ||
-		header->ddspf.size != sizeof(DDS_PIXELFORMAT))
-	{
-		return E_FAIL;
-	}
+	const DDS_HEADER* header = nullptr;
+	size_t offset = 0;
 
-	// Check for DX10 extension
-	bool bDXT10Header = false;
-	if((header->ddspf.flags & DDS_FOURCC) &&
-		(MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+	HRESULT hr = GetDDSHeaderFromMemory(ddsData, ddsDataSize, &header, &offset);
+	if(FAILED(hr))
 	{
-		// Must be long enough for both headers and magic value
-		if(ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
-		{
-			return E_FAIL;
-		}
-
-		bDXT10Header = true;
+		return hr;
 	}
 
-	ptrdiff_t offset = sizeof(uint32_t)
-		+ sizeof(DDS_HEADER)
-		+ (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
-
-	HRESULT hr = CreateTextureFromDDS(d3dDevice, d3dContext, header,
-		ddsData + offset, ddsDataSize - offset, maxsize,
+	hr = CreateTextureFromDDS(d3dDevice, d3dContext, header,
+		ddsDataSize - offset, 0, ddsDataSize - offset, ddsData + offset, maxsize,
 		usage, bindFlags, cpuAccessFlags, miscFlags, forceSRGB,
 		texture, textureView);
 	if(SUCCEEDED(hr))
@@ -1645,6 +1833,309 @@ DDS_ALPHA_MODE* alphaMode)
 	return hr;
 }
 
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::GetTextureMemorySize(size_t width,
+size_t height,
+size_t depth,
+size_t mipCount,
+size_t arraySize,
+DXGI_FORMAT format)
+{
+	if(mipCount == 0)
+	{
+		mipCount = CountFullMipChain(width, height, depth);
+	}
+
+	size_t numBytes = 0;
+
+	for(size_t mip = 0; mip < mipCount; ++mip)
+	{
+		size_t surfaceBytes = 0;
+		GetSurfaceInfo(width, height, format, &surfaceBytes, nullptr, nullptr);
+
+		numBytes += surfaceBytes * depth;
+
+		width = std::max<size_t>(width >> 1, 1);
+		height = std::max<size_t>(height >> 1, 1);
+		depth = std::max<size_t>(depth >> 1, 1);
+	}
+
+	return numBytes * std::max<size_t>(arraySize, 1);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::GetSurfacePitch(size_t width,
+size_t height,
+DXGI_FORMAT format,
+size_t* rowBytes,
+size_t* numBytes)
+{
+	GetSurfaceInfo(width, height, format, numBytes, rowBytes, nullptr);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSTextureFootprintFromMemory(const uint8_t* ddsData,
+size_t ddsDataSize,
+size_t maxsize,
+size_t* width,
+size_t* height,
+size_t* mipCount,
+size_t* numBytes)
+{
+	if(!ddsData || !width || !height || !mipCount || !numBytes)
+	{
+		return E_INVALIDARG;
+	}
+
+	const DDS_HEADER* header = nullptr;
+	size_t offset = 0;
+
+	HRESULT hr = GetDDSHeaderFromMemory(ddsData, ddsDataSize, &header, &offset);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	UINT w = 0;
+	UINT h = 0;
+	UINT d = 0;
+	uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+	UINT arraySize = 1;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	bool isCubeMap = false;
+	size_t mips = 1;
+
+	hr = ParseDDSHeader(header, resDim, w, h, d, mips, arraySize, format, isCubeMap);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	// Run the same layout pass the loader uses so the result matches what would be created
+	size_t skipMip = 0;
+	size_t twidth = 0;
+	size_t theight = 0;
+	size_t tdepth = 0;
+	uint64_t keptOffset = 0;
+	uint64_t keptEnd = 0;
+	hr = FillInitData(w, h, d, mips, arraySize, format, maxsize, ddsDataSize - offset, 0, 0, nullptr,
+		twidth, theight, tdepth, skipMip, keptOffset, keptEnd, nullptr);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	size_t residentMips = mips - skipMip;
+
+	*width = twidth;
+	*height = theight;
+	*mipCount = residentMips;
+	*numBytes = GetTextureMemorySize(twidth, theight, tdepth, residentMips, arraySize, format);
+
+	return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSMetadataFromMemory(const uint8_t* ddsData,
+size_t ddsDataSize,
+uint64_t fileSize,
+DDS_METADATA& metadata)
+{
+	if(!ddsData || fileSize < ddsDataSize)
+	{
+		return E_INVALIDARG;
+	}
+
+	const DDS_HEADER* header = nullptr;
+	size_t offset = 0;
+
+	HRESULT hr = GetDDSHeaderFromMemory(ddsData, ddsDataSize, &header, &offset);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	UINT width = 0;
+	UINT height = 0;
+	UINT depth = 0;
+	uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+	UINT arraySize = 1;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	bool isCubeMap = false;
+	size_t mipCount = 1;
+
+	hr = ParseDDSHeader(header, resDim, width, height, depth, mipCount, arraySize, format, isCubeMap);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	metadata.resourceDimension = resDim;
+	metadata.width = width;
+	metadata.height = height;
+	metadata.depth = depth;
+	metadata.mipCount = mipCount;
+	metadata.arraySize = arraySize;
+	metadata.format = format;
+	metadata.isCubeMap = isCubeMap;
+	metadata.alphaMode = GetAlphaMode(header);
+	metadata.headerSize = offset;
+	metadata.subresources.resize(mipCount * arraySize);
+
+	// Same walk as FillInitData, items are stored one after another with their mips in order
+	uint64_t position = offset;
+	size_t index = 0;
+	for(size_t j = 0; j < arraySize; j++)
+	{
+		size_t w = width;
+		size_t h = height;
+		size_t d = depth;
+		for(size_t i = 0; i < mipCount; i++)
+		{
+			DDS_SUBRESOURCE_INFO& info = metadata.subresources[index++];
+
+			GetSurfaceInfo(w, h, format, &info.slicePitch, &info.rowPitch, nullptr);
+
+			info.width = w;
+			info.height = h;
+			info.depth = d;
+			info.offset = position;
+			info.numBytes = static_cast<uint64_t>(info.slicePitch) * d;
+
+			if(info.numBytes > fileSize - position)
+			{
+				return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+			}
+
+			position += info.numBytes;
+
+			w = std::max<size_t>(1, w >> 1);
+			h = std::max<size_t>(1, h >> 1);
+			d = std::max<size_t>(1, d >> 1);
+		}
+	}
+
+	metadata.dataSize = position - offset;
+
+	return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSMetadataFromFile(const wchar_t* fileName,
+DDS_METADATA& metadata)
+{
+	if(!fileName)
+	{
+		return E_INVALIDARG;
+	}
+
+	ScopedHandle hFile(safe_handle(CreateFileW(fileName,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr)));
+
+	if(!hFile)
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	LARGE_INTEGER FileSize = {0};
+	if(!GetFileSizeEx(hFile.get(), &FileSize))
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	if(FileSize.QuadPart < 0)
+	{
+		return E_FAIL;
+	}
+
+	// Only the magic number and both headers are read, the bit data is never touched
+	uint8_t headerData[sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)];
+	DWORD bytesRead = 0;
+
+	if(!ReadFile(hFile.get(), headerData, sizeof(headerData), &bytesRead, nullptr))
+	{
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	return GetDDSMetadataFromMemory(headerData, bytesRead, static_cast<uint64_t>(FileSize.QuadPart), metadata);
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GenerateDDSMipsFromMemory(const uint8_t* ddsData,
+size_t ddsDataSize,
+const MipGenerator::MipOptions& options,
+std::vector<uint8_t>& output)
+{
+	if(!ddsData)
+	{
+		return E_INVALIDARG;
+	}
+
+	const DDS_HEADER* header = nullptr;
+	size_t offset = 0;
+
+	HRESULT hr = GetDDSHeaderFromMemory(ddsData, ddsDataSize, &header, &offset);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	UINT width = 0;
+	UINT height = 0;
+	UINT depth = 0;
+	uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+	UINT arraySize = 1;
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	bool isCubeMap = false;
+	size_t mipCount = 1;
+
+	hr = ParseDDSHeader(header, resDim, width, height, depth, mipCount, arraySize, format, isCubeMap);
+	if(FAILED(hr))
+	{
+		return hr;
+	}
+
+	if(!CanGenerateMipsOnCPU(resDim, mipCount, arraySize, isCubeMap, format))
+	{
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	}
+
+	MipGenerator::MipOptions surfaceOptions = options;
+	surfaceOptions.srgb = options.srgb || IsSRGB(format);
+
+	std::vector<uint8_t> chain;
+	size_t generatedMips = 0;
+	if(!MipGenerator::GenerateSurfaceMips(format, ddsData + offset, ddsDataSize - offset, width, height, surfaceOptions, chain, generatedMips))
+	{
+		return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+	}
+
+	// Same headers with the mip count filled in, followed by the new chain
+	output.resize(offset + chain.size());
+	memcpy(&output[0], ddsData, offset);
+	memcpy(&output[offset], &chain[0], chain.size());
+
+	auto outHeader = reinterpret_cast<DDS_HEADER*>(&output[sizeof(uint32_t)]);
+	outHeader->mipMapCount = static_cast<uint32_t>(generatedMips);
+	outHeader->flags |= DDS_HEADER_FLAGS_MIPMAP;
+	outHeader->caps |= DDS_SURFACE_FLAGS_MIPMAP;
+
+	return S_OK;
+}
+
 //--------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT DirectX::CreateDDSTextureFromFile(ID3D11Device* d3dDevice,
@@ -1723,16 +2214,23 @@ DDS_ALPHA_MODE* alphaMode)
 		return E_INVALIDARG;
 	}
 
-	DDS_HEADER* header = nullptr;
-	uint8_t* bitData = nullptr;
-	size_t bitSize = 0;
+	uint8_t headerData[sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)];
+	const DDS_HEADER* header = nullptr;
+	const uint8_t* bitData = nullptr;
+	uint64_t bitSize = 0;
+	uint64_t windowOffset = 0;
+	size_t windowSize = 0;
 
-	std::unique_ptr<uint8_t[]> ddsData;
+	ScopedView ddsData;
 	HRESULT hr = LoadTextureDataFromFile(fileName,
+		maxsize,
+		headerData,
 		ddsData,
 		&header,
-		&bitData,
-		&bitSize
+		&bitSize,
+		&windowOffset,
+		&windowSize,
+		&bitData
 		);
 	if(FAILED(hr))
 	{
@@ -1740,7 +2238,7 @@ DDS_ALPHA_MODE* alphaMode)
 	}
 
 	hr = CreateTextureFromDDS(d3dDevice, d3dContext, header,
-		bitData, bitSize, maxsize,
+		bitSize, windowOffset, windowSize, bitData, maxsize,
 		usage, bindFlags, cpuAccessFlags, miscFlags, forceSRGB,
 		texture, textureView);
 
@@ -18,9 +18,7 @@
 // http://go.microsoft.com/fwlink/?LinkId=248929
 //--------------------------------------------------------------------------------------
 
-#ifdef _MSC_VER
 #pragma once
-#endif
 
 #include <d3d11_1.h>
 
@@ -29,6 +27,13 @@
 #include <stdint.h>
 #pragma warning(pop)
 
+#include <vector>
+
+namespace MipGenerator
+{
+	struct MipOptions;
+}
+
 #if defined(_MSC_VER) && (_MSC_VER<1610) && !defined(_In_reads_)
 #define _In_reads_(exp)
 #define _Out_writes_(exp)
@@ -52,6 +57,44 @@ namespace DirectX
 		DDS_ALPHA_MODE_CUSTOM = 4,
 	};
 
+	// Layout of one subresource (one mip of one array item) inside the DDS file
+	struct DDS_SUBRESOURCE_INFO
+	{
+		size_t width;
+		size_t height;
+		size_t depth;
+		size_t rowPitch;
+		size_t slicePitch;
+
+		// Byte offset from the start of the file and total size including every depth slice, 64-bit
+		// so files past 4 GB can be described on 32-bit builds
+		uint64_t offset;
+		uint64_t numBytes;
+	};
+
+	// Texture description read from the DDS headers alone
+	struct DDS_METADATA
+	{
+		uint32_t resourceDimension;
+		size_t width;
+		size_t height;
+		size_t depth;
+		size_t mipCount;
+		size_t arraySize;
+		DXGI_FORMAT format;
+		bool isCubeMap;
+		DDS_ALPHA_MODE alphaMode;
+
+		// Size of the magic number and headers, the bit data starts here
+		size_t headerSize;
+
+		// Bytes of bit data the headers describe
+		uint64_t dataSize;
+
+		// Ordered like D3D11CalcSubresource, mip + item * mipCount
+		std::vector<DDS_SUBRESOURCE_INFO> subresources;
+	};
+
 	// Standard version
 	HRESULT CreateDDSTextureFromMemory(_In_ ID3D11Device* d3dDevice,
 		_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
@@ -147,4 +190,53 @@ namespace DirectX
 		_Outptr_opt_ ID3D11ShaderResourceView** textureView,
 		_Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
 		);
+
+	// Top-level size, mip count and total bytes of the texture that CreateDDSTextureFromMemoryEx
+	// would create for the given maxsize, without creating any resources
+	HRESULT GetDDSTextureFootprintFromMemory(_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+		_In_ size_t ddsDataSize,
+		_In_ size_t maxsize,
+		_Out_ size_t* width,
+		_Out_ size_t* height,
+		_Out_ size_t* mipCount,
+		_Out_ size_t* numBytes
+		);
+
+	// Bytes of every mip of every array slice, mipCount 0 means the full chain down to 1x1
+	size_t GetTextureMemorySize(_In_ size_t width,
+		_In_ size_t height,
+		_In_ size_t depth,
+		_In_ size_t mipCount,
+		_In_ size_t arraySize,
+		_In_ DXGI_FORMAT format
+		);
+
+	// Row pitch and total bytes of one tightly packed surface, as it is stored in a DDS file
+	void GetSurfacePitch(_In_ size_t width,
+		_In_ size_t height,
+		_In_ DXGI_FORMAT format,
+		_Out_ size_t* rowBytes,
+		_Out_ size_t* numBytes
+		);
+
+	// Parses the headers without creating any resources. ddsDataSize only has to cover the headers,
+	// fileSize is the full size of the file and is checked against the described bit data
+	HRESULT GetDDSMetadataFromMemory(_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+		_In_ size_t ddsDataSize,
+		_In_ uint64_t fileSize,
+		_Out_ DDS_METADATA& metadata
+		);
+
+	// Reads only the header bytes of the file
+	HRESULT GetDDSMetadataFromFile(_In_z_ const wchar_t* szFileName,
+		_Out_ DDS_METADATA& metadata
+		);
+
+	// Builds the full mip chain of a single-mip 2D DDS file on the CPU and returns it as a new
+	// DDS file in memory. sRGB formats are always filtered in linear space
+	HRESULT GenerateDDSMipsFromMemory(_In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+		_In_ size_t ddsDataSize,
+		_In_ const MipGenerator::MipOptions& options,
+		_Out_ std::vector<uint8_t>& output
+		);
 }
@@ -1,8 +1,10 @@
 #pragma once
 
-// Windows headers
+// Windows headers, without the min/max macros that break std::min and std::max
+#define NOMINMAX
 #include <windows.h>
 #include <shlwapi.h>
+#include <intrin.h>
 
 // STD headers
 #include <string>
@@ -10,6 +12,17 @@
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <unordered_map>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 // DirectX headers
 #include <d3d11.h>
@@ -19,12 +32,35 @@
 
 // Project headers
 #include "Util.h"
+#include "Allocators.h"
+#include "GpuMemoryTracker.h"
 #include "Camera.h"
 #include "Id.h"
+#include "EntityWorld.h"
 #include "DDSTextureLoader.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
 #include "Timer.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "ShaderCache.h"
+#include "ShaderPermutations.h"
+#include "InputLayoutCache.h"
+#include "UploadManager.h"
+#include "MeshBufferPolicy.h"
 #include "MeshEntity.h"
 #include "Shadow.h"
+#include "Occlusion.h"
+#include "LightCulling.h"
+#include "LightClusters.h"
+#include "MappedFile.h"
+#include "TexturePack.h"
+#include "TextureManifest.h"
+#include "TextureStreamer.h"
+#include "AssetLoader.h"
+#include "HotReload.h"
 
 // Classes
 class Camera;
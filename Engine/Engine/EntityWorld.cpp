@@ -0,0 +1,248 @@
+#include "Engine.h"
+
+namespace{
+
+// Chunks start on a cache line
+const size_t ChunkAlignment	= 64;
+const size_t ChunksPerPage	= 16;
+
+std::vector<ComponentInfo> &ComponentTypes(){
+	static std::vector<ComponentInfo> types;
+
+	return types;
+}
+
+uint32_t AlignUp(uint32_t value, uint32_t alignment){
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+uint32_t RegisterComponentType(uint32_t size, uint32_t alignment){
+	std::vector<ComponentInfo> &types = ComponentTypes();
+	ComponentInfo info = {size, alignment};
+
+	types.push_back(info);
+
+	return static_cast<uint32_t>(types.size()) - 1;
+}
+
+const ComponentInfo &GetComponentInfo(uint32_t type){
+	return ComponentTypes()[type];
+}
+
+EntityWorld::EntityWorld() : m_chunks("Entity chunks", ChunkSize, ChunkAlignment, ChunksPerPage){
+
+}
+
+EntityWorld::~EntityWorld(){
+
+}
+
+EntityWorld::Archetype *EntityWorld::getArchetype(ComponentMask mask){
+	auto it = m_archetypeMasks.find(mask);
+
+	if(it != m_archetypeMasks.end()) return it->second;
+
+	std::unique_ptr<Archetype> archetype(new Archetype);
+	uint32_t entitySize = sizeof(Id);
+
+	archetype->mask			= mask;
+	archetype->numEntities	= 0;
+
+	for(uint32_t type = 0; type < MaxComponentTypes; type++){
+		archetype->offsets[type] = 0;
+
+		if(mask & (ComponentMask(1) << type)){
+			archetype->types.push_back(type);
+			entitySize += GetComponentInfo(type).size;
+		}
+	}
+
+	// Guess from the summed sizes, then back off until the aligned arrays fit
+	uint32_t capacity = ChunkSize / entitySize;
+
+	while(true){
+		uint32_t offset = sizeof(Id) * capacity;
+
+		for(uint32_t type : archetype->types){
+			const ComponentInfo &info = GetComponentInfo(type);
+
+			offset = AlignUp(offset, info.alignment);
+			archetype->offsets[type] = offset;
+			offset += info.size * capacity;
+		}
+
+		if(offset <= ChunkSize) break;
+
+		capacity--;
+	}
+
+	archetype->capacity = capacity;
+
+	Archetype *result = archetype.get();
+
+	m_archetypes.push_back(std::move(archetype));
+	m_archetypeMasks[mask] = result;
+
+	return result;
+}
+
+uint8_t *EntityWorld::getComponent(const EntityLocation &location, uint32_t type) const{
+	const Archetype &archetype = *location.archetype;
+
+	if(!(archetype.mask & (ComponentMask(1) << type))) return nullptr;
+
+	uint8_t *chunk = archetype.chunks[location.row / archetype.capacity];
+
+	return chunk + archetype.offsets[type] + GetComponentInfo(type).size * (location.row % archetype.capacity);
+}
+
+uint32_t EntityWorld::pushEntity(Archetype &archetype, const Id &id){
+	uint32_t row = archetype.numEntities++;
+	uint32_t slot = row % archetype.capacity;
+
+	if(slot == 0) archetype.chunks.push_back(static_cast<uint8_t *>(m_chunks.allocate()));
+
+	uint8_t *chunk = archetype.chunks.back();
+
+	reinterpret_cast<Id *>(chunk)[slot] = id;
+
+	return row;
+}
+
+void EntityWorld::removeEntity(Archetype &archetype, uint32_t row){
+	uint32_t last = --archetype.numEntities;
+	uint8_t *lastChunk = archetype.chunks.back();
+	uint32_t lastSlot = last % archetype.capacity;
+
+	if(row != last){
+		uint8_t *chunk = archetype.chunks[row / archetype.capacity];
+		uint32_t slot = row % archetype.capacity;
+
+		for(uint32_t type : archetype.types){
+			uint32_t size = GetComponentInfo(type).size;
+
+			memcpy(chunk + archetype.offsets[type] + size * slot, lastChunk + archetype.offsets[type] + size * lastSlot, size);
+		}
+
+		Id moved = reinterpret_cast<Id *>(lastChunk)[lastSlot];
+
+		reinterpret_cast<Id *>(chunk)[slot] = moved;
+		m_locations[moved.getIndex()].row = row;
+	}
+
+	// Keep every chunk but the last full
+	if(lastSlot == 0){
+		m_chunks.free(lastChunk);
+		archetype.chunks.pop_back();
+	}
+}
+
+Id EntityWorld::create(ComponentMask mask){
+	Archetype *archetype = getArchetype(mask);
+	Id id = m_ids.create();
+
+	if(id.isNull()) return id;
+
+	if(m_locations.size() <= id.getIndex()) m_locations.resize(id.getIndex() + 1);
+
+	EntityLocation location = {archetype, pushEntity(*archetype, id)};
+	m_locations[id.getIndex()] = location;
+
+	for(uint32_t type : archetype->types){
+		memset(getComponent(location, type), 0, GetComponentInfo(type).size);
+	}
+
+	return id;
+}
+
+bool EntityWorld::destroy(const Id &id){
+	if(!isAlive(id)) return false;
+
+	EntityLocation &location = m_locations[id.getIndex()];
+
+	removeEntity(*location.archetype, location.row);
+	location.archetype = nullptr;
+
+	return m_ids.destroy(id);
+}
+
+bool EntityWorld::isAlive(const Id &id) const{
+	return m_ids.isValid(id);
+}
+
+bool EntityWorld::addComponents(const Id &id, ComponentMask mask){
+	if(!isAlive(id)) return false;
+
+	EntityLocation &location = m_locations[id.getIndex()];
+	Archetype *source = location.archetype;
+
+	if((source->mask & mask) == mask) return true;
+
+	// Copy what the entity keeps and zero the rest
+	Archetype *target = getArchetype(source->mask | mask);
+	EntityLocation moved = {target, pushEntity(*target, id)};
+
+	for(uint32_t type : target->types){
+		uint8_t *component = getComponent(moved, type);
+		uint8_t *previous = getComponent(location, type);
+
+		if(previous) memcpy(component, previous, GetComponentInfo(type).size);
+		else memset(component, 0, GetComponentInfo(type).size);
+	}
+
+	removeEntity(*source, location.row);
+	location = moved;
+
+	return true;
+}
+
+bool EntityWorld::removeComponents(const Id &id, ComponentMask mask){
+	if(!isAlive(id)) return false;
+
+	EntityLocation &location = m_locations[id.getIndex()];
+	Archetype *source = location.archetype;
+
+	if((source->mask & mask) == 0) return true;
+
+	Archetype *target = getArchetype(source->mask & ~mask);
+	EntityLocation moved = {target, pushEntity(*target, id)};
+
+	for(uint32_t type : target->types){
+		memcpy(getComponent(moved, type), getComponent(location, type), GetComponentInfo(type).size);
+	}
+
+	removeEntity(*source, location.row);
+	location = moved;
+
+	return true;
+}
+
+ComponentMask EntityWorld::getMask(const Id &id) const{
+	if(!isAlive(id)) return 0;
+
+	return m_locations[id.getIndex()].archetype->mask;
+}
+
+void EntityWorld::getChunks(ComponentMask required, ComponentMask excluded, std::vector<Chunk> &chunks) const{
+	chunks.clear();
+
+	for(const auto &archetype : m_archetypes){
+		if((archetype->mask & required) != required || (archetype->mask & excluded) != 0) continue;
+
+		for(size_t i = 0; i < archetype->chunks.size(); i++){
+			uint32_t size = std::min(archetype->capacity, archetype->numEntities - static_cast<uint32_t>(i) * archetype->capacity);
+
+			chunks.push_back(Chunk(archetype.get(), archetype->chunks[i], size));
+		}
+	}
+}
+
+uint32_t EntityWorld::getNumEntities() const{
+	return m_ids.getNumAlive();
+}
+
+uint32_t EntityWorld::getNumArchetypes() const{
+	return static_cast<uint32_t>(m_archetypes.size());
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+////////////////////////
+// Entity world class //
+////////////////////////
+
+typedef uint64_t ComponentMask;
+
+struct ComponentInfo{
+	uint32_t size, alignment;
+};
+
+// Component types are numbered process-wide the first time they're used, they have to be plain data
+uint32_t RegisterComponentType(uint32_t size, uint32_t alignment);
+const ComponentInfo &GetComponentInfo(uint32_t type);
+
+template<typename T>
+struct ComponentType{
+	static const uint32_t id;
+
+	static ComponentMask mask(){
+		return ComponentMask(1) << id;
+	}
+};
+
+template<typename T>
+const uint32_t ComponentType<T>::id = RegisterComponentType(sizeof(T), std::alignment_of<T>::value);
+
+// ComponentMaskOf<A, B, C>::get()
+template<typename... T>
+struct ComponentMaskOf;
+
+template<>
+struct ComponentMaskOf<>{
+	static ComponentMask get(){
+		return 0;
+	}
+};
+
+template<typename T, typename... Rest>
+struct ComponentMaskOf<T, Rest...>{
+	static ComponentMask get(){
+		return ComponentType<T>::mask() | ComponentMaskOf<Rest...>::get();
+	}
+};
+
+class EntityWorld{
+public:
+	static const uint32_t MaxComponentTypes	= 64;
+	static const uint32_t ChunkSize			= 16 * 1024;
+
+private:
+
+	// Entities with exactly the same components, stored in fixed size chunks. Inside a chunk every component
+	// has its own array, the ids come first
+	struct Archetype{
+		ComponentMask mask;
+		std::vector<uint32_t> types;
+
+		uint32_t capacity;
+		uint32_t offsets[MaxComponentTypes];
+
+		// Every chunk but the last is full
+		std::vector<uint8_t *> chunks;
+		uint32_t numEntities;
+	};
+
+	struct EntityLocation{
+		Archetype *archetype;
+		uint32_t row;
+	};
+
+	IdAllocator m_ids;
+	std::vector<EntityLocation> m_locations;
+
+	// Every archetype's chunks come from here
+	PoolAllocator m_chunks;
+
+	std::vector<std::unique_ptr<Archetype>> m_archetypes;
+	std::unordered_map<ComponentMask, Archetype *> m_archetypeMasks;
+
+	Archetype *getArchetype(ComponentMask mask);
+
+	uint8_t *getComponent(const EntityLocation &location, uint32_t type) const;
+
+	// Appends an entity to the last chunk and returns its row
+	uint32_t pushEntity(Archetype &archetype, const Id &id);
+
+	// Moves the archetype's last entity into the hole
+	void removeEntity(Archetype &archetype, uint32_t row);
+
+	EntityWorld(const EntityWorld &) = delete;
+	EntityWorld &operator=(const EntityWorld &) = delete;
+
+public:
+
+	// Components of one chunk, arrays are indexed by row
+	class Chunk{
+	private:
+		const Archetype *m_archetype;
+		uint8_t *m_data;
+		uint32_t m_size;
+
+	public:
+		Chunk(const Archetype *archetype, uint8_t *data, uint32_t size) : m_archetype(archetype), m_data(data), m_size(size){
+
+		}
+
+		uint32_t size() const{
+			return m_size;
+		}
+
+		const Id *getIds() const{
+			return reinterpret_cast<const Id *>(m_data);
+		}
+
+		bool has(ComponentMask mask) const{
+			return (m_archetype->mask & mask) == mask;
+		}
+
+		// Null if the chunk's entities don't have T
+		template<typename T>
+		T *get() const{
+			if(!has(ComponentType<T>::mask())) return nullptr;
+
+			return reinterpret_cast<T *>(m_data + m_archetype->offsets[ComponentType<T>::id]);
+		}
+	};
+
+	EntityWorld();
+	~EntityWorld();
+
+	// Components start zeroed
+	Id create(ComponentMask mask);
+	bool destroy(const Id &id);
+	bool isAlive(const Id &id) const;
+
+	// Structural changes move the entity to the chunks of its new archetype, components it keeps are copied
+	bool addComponents(const Id &id, ComponentMask mask);
+	bool removeComponents(const Id &id, ComponentMask mask);
+
+	ComponentMask getMask(const Id &id) const;
+
+	// Null if the entity is gone or doesn't have T
+	template<typename T>
+	T *get(const Id &id) const{
+		if(!isAlive(id)) return nullptr;
+
+		return reinterpret_cast<T *>(getComponent(m_locations[id.getIndex()], ComponentType<T>::id));
+	}
+
+	template<typename T>
+	T *add(const Id &id, const T &value){
+		if(!addComponents(id, ComponentType<T>::mask())) return nullptr;
+
+		T *component = get<T>(id);
+		*component = value;
+
+		return component;
+	}
+
+	// Chunks of every archetype that has all of required and none of excluded, in storage order. Chunks can be
+	// processed in parallel as long as nothing changes the world's structure meanwhile
+	void getChunks(ComponentMask required, ComponentMask excluded, std::vector<Chunk> &chunks) const;
+
+	uint32_t getNumEntities() const;
+	uint32_t getNumArchetypes() const;
+};
@@ -0,0 +1,108 @@
+#include "Engine.h"
+
+FramePipeline::FramePipeline(JobSystem &jobs, uint32_t latency, const StageFunc &snapshot, const StageFunc &update, const StageFunc &submit) :
+	m_jobs(jobs), m_snapshot(snapshot), m_update(update), m_submit(submit){
+
+	m_latency		= std::min(std::max<uint32_t>(latency, 1), MaxLatency);
+	m_nextSubmit	= 0;
+	m_nextPrepare	= 0;
+
+	resetStats();
+}
+
+FramePipeline::~FramePipeline(){
+	flush();
+}
+
+void FramePipeline::prepare(uint64_t frame){
+	uint32_t slot = static_cast<uint32_t>(frame % m_latency);
+
+	m_timer.createTimeStamp(m_snapshotTimes[slot]);
+
+	{
+		PROFILE_ZONE("Snapshot");
+		m_snapshot(slot, frame);
+	}
+
+	// Chain onto the previous frame's update, its slot isn't reused before this frame is submitted
+	JobSystem::Counter *previous = nullptr;
+
+	if(m_latency > 1 && frame > 0) previous = &m_counters[(frame - 1) % m_latency];
+
+	m_jobs.run([this, slot, frame]{
+		PROFILE_ZONE("Update");
+		m_update(slot, frame);
+	}, &m_counters[slot], previous);
+}
+
+void FramePipeline::runFrame(){
+	while(m_nextPrepare < m_nextSubmit + m_latency){
+		prepare(m_nextPrepare++);
+	}
+
+	uint64_t frame = m_nextSubmit++;
+	uint32_t slot = static_cast<uint32_t>(frame % m_latency);
+
+	m_jobs.wait(m_counters[slot]);
+
+	{
+		PROFILE_ZONE("Submit");
+		m_submit(slot, frame);
+	}
+
+	TimeStamp now;
+	m_timer.createTimeStamp(now);
+
+	m_totalLatency += m_timer.getDeltaTime(m_snapshotTimes[slot], now);
+
+	// The first frame has nothing to measure against
+	if(m_stats.numFrames > 0){
+		double frameTime = m_timer.getDeltaTime(m_lastSubmit, now);
+
+		m_totalFrameTime += frameTime;
+
+		m_stats.minFrameTime = std::min(m_stats.minFrameTime, frameTime);
+		m_stats.maxFrameTime = std::max(m_stats.maxFrameTime, frameTime);
+		m_stats.averageFrameTime = m_totalFrameTime / m_stats.numFrames;
+		m_stats.framesPerSecond = m_stats.averageFrameTime > 0 ? 1.0 / m_stats.averageFrameTime : 0;
+	}
+
+	m_stats.numFrames++;
+	m_stats.averageLatency = m_totalLatency / m_stats.numFrames;
+
+	m_lastSubmit = now;
+}
+
+void FramePipeline::flush(){
+	for(uint32_t i = 0; i < m_latency; i++){
+		m_jobs.wait(m_counters[i]);
+	}
+
+	m_nextPrepare = m_nextSubmit;
+}
+
+void FramePipeline::setLatency(uint32_t latency){
+	flush();
+
+	m_latency = std::min(std::max<uint32_t>(latency, 1), MaxLatency);
+}
+
+uint32_t FramePipeline::getLatency() const{
+	return m_latency;
+}
+
+const FramePipelineStats &FramePipeline::getStats() const{
+	return m_stats;
+}
+
+void FramePipeline::resetStats(){
+	m_stats.numFrames			= 0;
+	m_stats.averageFrameTime	= 0;
+	m_stats.minFrameTime		= DBL_MAX;
+	m_stats.maxFrameTime		= 0;
+	m_stats.averageLatency		= 0;
+	m_stats.framesPerSecond		= 0;
+
+	m_totalFrameTime	= 0;
+	m_totalLatency		= 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+//////////////////////////
+// Frame pipeline class //
+//////////////////////////
+
+struct FramePipelineStats{
+	uint64_t numFrames;
+
+	// Time between consecutive submits, in seconds
+	double averageFrameTime, minFrameTime, maxFrameTime;
+
+	// From the snapshot of a frame to the end of its submit
+	double averageLatency;
+
+	double framesPerSecond;
+};
+
+// Runs frames in three stages so the CPU work of upcoming frames overlaps the submit of the current one:
+//   snapshot	main thread, copies whatever the frame needs (cameras, input, time) into the frame's slot
+//   update		job, builds transforms, visibility and draw lists from the slot only
+//   submit		main thread, issues the device calls for the slot
+// Updates run one after another in frame order, so they may share systems such as the occlusion culler
+class FramePipeline{
+public:
+
+	// slot is in [0, latency) and picks the frame's copy of the double-buffered data
+	typedef std::function<void(uint32_t slot, uint64_t frame)> StageFunc;
+
+	static const uint32_t MaxLatency = 4;
+
+private:
+	JobSystem &m_jobs;
+	uint32_t m_latency;
+	StageFunc m_snapshot, m_update, m_submit;
+
+	// Raised while the update of the frame in that slot is running
+	JobSystem::Counter m_counters[MaxLatency];
+	TimeStamp m_snapshotTimes[MaxLatency];
+
+	// Next frame to submit and next frame to snapshot, everything in between is in flight
+	uint64_t m_nextSubmit, m_nextPrepare;
+
+	Timer m_timer;
+	TimeStamp m_lastSubmit;
+	FramePipelineStats m_stats;
+	double m_totalFrameTime, m_totalLatency;
+
+	void prepare(uint64_t frame);
+
+public:
+
+	// latency is the number of frames in flight, 1 runs every frame start to finish before the next
+	FramePipeline(JobSystem &jobs, uint32_t latency, const StageFunc &snapshot, const StageFunc &update, const StageFunc &submit);
+	~FramePipeline();
+
+	// Starts updates until latency frames are in flight, then waits for the oldest one and submits it.
+	// Must be called from the job system's main thread
+	void runFrame();
+
+	// Waits for every update in flight and drops those frames, they get snapshotted again on the next run
+	void flush();
+
+	void setLatency(uint32_t latency);
+	uint32_t getLatency() const;
+
+	const FramePipelineStats &getStats() const;
+	void resetStats();
+};
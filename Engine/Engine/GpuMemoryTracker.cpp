@@ -0,0 +1,316 @@
+#include "Engine.h"
+
+namespace{
+
+// Created before main and intentionally leaked, see GetGpuMemoryTracker()
+GpuMemoryTracker *g_tracker = new GpuMemoryTracker();
+
+THREAD_LOCAL uint32_t t_tag = GpuMemoryTracker::NoTag;
+
+void ClearUsage(GpuMemoryUsage &usage){
+	memset(&usage, 0, sizeof(GpuMemoryUsage));
+}
+
+bool FitsBudget(const GpuMemoryUsage &usage, uint64_t bytes){
+	return usage.budget == 0 || usage.bytes + bytes <= usage.budget;
+}
+
+void AddUsage(GpuMemoryUsage &usage, uint64_t bytes){
+	usage.bytes += bytes;
+	usage.numAllocations++;
+	usage.peakBytes = std::max(usage.peakBytes, usage.bytes);
+}
+
+void FormatSize(char (&text)[32], uint64_t bytes){
+	sprintf_s(text, "%.2f MB", bytes / (1024.0 * 1024.0));
+}
+
+}
+
+GpuMemoryTracker::GpuMemoryTracker(){
+	for(auto &usage : m_categories){
+		ClearUsage(usage);
+	}
+
+	ClearUsage(m_total);
+
+	memset(m_frameAllocated, 0, sizeof(m_frameAllocated));
+	memset(m_frameFreed, 0, sizeof(m_frameFreed));
+
+	m_nextAllocation	= InvalidAllocation + 1;
+	m_frame				= 0;
+}
+
+void GpuMemoryTracker::setBudget(GpuMemoryCategory category, uint64_t bytes){
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_categories[category].budget = bytes;
+}
+
+void GpuMemoryTracker::setTotalBudget(uint64_t bytes){
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_total.budget = bytes;
+}
+
+uint32_t GpuMemoryTracker::getTag(const std::wstring &name){
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_tagIndices.find(name);
+
+	if(it != m_tagIndices.end()) return it->second;
+
+	GpuMemoryTagStats tag = {name, 0, 0, 0};
+	uint32_t index = static_cast<uint32_t>(m_tags.size());
+
+	m_tags.push_back(tag);
+	m_tagIndices[name] = index;
+
+	return index;
+}
+
+GpuAllocationId GpuMemoryTracker::allocate(GpuMemoryCategory category, uint64_t bytes, uint32_t tag){
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	GpuMemoryUsage &usage = m_categories[category];
+
+	if(!FitsBudget(usage, bytes) || !FitsBudget(m_total, bytes)){
+		usage.numRejected++;
+		m_total.numRejected++;
+
+		return InvalidAllocation;
+	}
+
+	AddUsage(usage, bytes);
+	AddUsage(m_total, bytes);
+
+	m_frameAllocated[category] += bytes;
+	m_frameAllocated[GpuMemoryCategoryCount] += bytes;
+
+	if(tag < m_tags.size()){
+		GpuMemoryTagStats &stats = m_tags[tag];
+
+		stats.bytes += bytes;
+		stats.numAllocations++;
+		stats.peakBytes = std::max(stats.peakBytes, stats.bytes);
+	}
+	else{
+		tag = NoTag;
+	}
+
+	GpuAllocationId allocation = m_nextAllocation++;
+	Allocation record = {category, bytes, tag};
+
+	m_allocations[allocation] = record;
+
+	return allocation;
+}
+
+void GpuMemoryTracker::free(GpuAllocationId allocation){
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_allocations.find(allocation);
+
+	if(it == m_allocations.end()) return;
+
+	const Allocation &record = it->second;
+	GpuMemoryUsage &usage = m_categories[record.category];
+
+	usage.bytes -= record.bytes;
+	usage.numAllocations--;
+	m_total.bytes -= record.bytes;
+	m_total.numAllocations--;
+
+	m_frameFreed[record.category] += record.bytes;
+	m_frameFreed[GpuMemoryCategoryCount] += record.bytes;
+
+	if(record.tag != NoTag){
+		m_tags[record.tag].bytes -= record.bytes;
+		m_tags[record.tag].numAllocations--;
+	}
+
+	m_allocations.erase(it);
+}
+
+void GpuMemoryTracker::endFrame(){
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for(uint32_t i = 0; i < GpuMemoryCategoryCount; i++){
+		m_categories[i].frameAllocated	= m_frameAllocated[i];
+		m_categories[i].frameFreed		= m_frameFreed[i];
+	}
+
+	m_total.frameAllocated	= m_frameAllocated[GpuMemoryCategoryCount];
+	m_total.frameFreed		= m_frameFreed[GpuMemoryCategoryCount];
+
+	memset(m_frameAllocated, 0, sizeof(m_frameAllocated));
+	memset(m_frameFreed, 0, sizeof(m_frameFreed));
+
+	m_frame++;
+}
+
+void GpuMemoryTracker::getStats(GpuMemoryStats &stats) const{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	stats.frame = m_frame;
+	stats.total = m_total;
+
+	for(uint32_t i = 0; i < GpuMemoryCategoryCount; i++){
+		stats.categories[i] = m_categories[i];
+	}
+}
+
+void GpuMemoryTracker::getTagStats(std::vector<GpuMemoryTagStats> &tags) const{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		tags = m_tags;
+	}
+
+	std::stable_sort(tags.begin(), tags.end(), [](const GpuMemoryTagStats &a, const GpuMemoryTagStats &b){
+		return a.bytes > b.bytes;
+	});
+}
+
+std::string GpuMemoryTracker::formatStats(uint32_t maxTags) const{
+	GpuMemoryStats stats;
+	std::vector<GpuMemoryTagStats> tags;
+	std::string text;
+	char line[512], bytes[32], peak[32], budget[32];
+
+	getStats(stats);
+	getTagStats(tags);
+
+	sprintf_s(line, "GPU memory at frame %llu\n%-16s %12s %12s %12s %8s %10s %12s %12s\n", stats.frame, "Category", "Used", "Peak", "Budget",
+		"Count", "Rejected", "Frame +", "Frame -");
+	text += line;
+
+	for(uint32_t i = 0; i <= GpuMemoryCategoryCount; i++){
+		const GpuMemoryUsage &usage = i < GpuMemoryCategoryCount ? stats.categories[i] : stats.total;
+
+		if(i < GpuMemoryCategoryCount && usage.peakBytes == 0 && usage.budget == 0 && usage.numRejected == 0) continue;
+
+		FormatSize(bytes, usage.bytes);
+		FormatSize(peak, usage.peakBytes);
+
+		if(usage.budget) FormatSize(budget, usage.budget);
+		else sprintf_s(budget, "-");
+
+		sprintf_s(line, "%-16s %12s %12s %12s %8u %10llu %12llu %12llu\n", i < GpuMemoryCategoryCount ? GetCategoryName(static_cast<GpuMemoryCategory>(i)) : "Total",
+			bytes, peak, budget, usage.numAllocations, usage.numRejected, usage.frameAllocated, usage.frameFreed);
+		text += line;
+	}
+
+	for(uint32_t i = 0; i < tags.size() && i < maxTags && tags[i].bytes > 0; i++){
+		FormatSize(bytes, tags[i].bytes);
+		FormatSize(peak, tags[i].peakBytes);
+
+		sprintf_s(line, "  %12s %12s %6u  %ls\n", bytes, peak, tags[i].numAllocations, tags[i].name.c_str());
+		text += line;
+	}
+
+	return text;
+}
+
+const char *GpuMemoryTracker::GetCategoryName(GpuMemoryCategory category){
+	static const char *names[] = {"Vertex buffer", "Index buffer", "Constant buffer", "Texture", "Render target", "Depth stencil", "Staging", "Other"};
+
+	return category < GpuMemoryCategoryCount ? names[category] : "Unknown";
+}
+
+GpuMemoryTracker &GetGpuMemoryTracker(){
+	return *g_tracker;
+}
+
+GpuMemoryTag::GpuMemoryTag(const std::wstring &name) : m_previous(t_tag){
+	t_tag = GetGpuMemoryTracker().getTag(name);
+}
+
+GpuMemoryTag::~GpuMemoryTag(){
+	t_tag = m_previous;
+}
+
+uint32_t GpuMemoryTag::getCurrent(){
+	return t_tag;
+}
+
+// D3D11 resources
+namespace{
+
+// {6C1A3F52-9D4E-4B7A-8E21-5F03C79A14D6}
+const GUID ReleaseHookGuid = {0x6c1a3f52, 0x9d4e, 0x4b7a, {0x8e, 0x21, 0x5f, 0x03, 0xc7, 0x9a, 0x14, 0xd6}};
+
+// Kept in the resource's private data, D3D releases it when the resource is destroyed
+class ReleaseHook : public IUnknown{
+private:
+	std::atomic<ULONG> m_refs;
+	GpuAllocationId m_allocation;
+
+public:
+	ReleaseHook(GpuAllocationId allocation) : m_refs(1), m_allocation(allocation){
+
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **object){
+		if(iid != __uuidof(IUnknown)){
+			*object = nullptr;
+			return E_NOINTERFACE;
+		}
+
+		AddRef();
+		*object = this;
+
+		return S_OK;
+	}
+
+	ULONG STDMETHODCALLTYPE AddRef(){
+		return ++m_refs;
+	}
+
+	ULONG STDMETHODCALLTYPE Release(){
+		ULONG refs = --m_refs;
+
+		if(refs == 0){
+			GetGpuMemoryTracker().free(m_allocation);
+			delete this;
+		}
+
+		return refs;
+	}
+};
+
+}
+
+GpuMemoryCategory GetGpuMemoryCategory(UINT bindFlags, D3D11_USAGE usage){
+	if(usage == D3D11_USAGE_STAGING) return GpuMemoryStaging;
+
+	if(bindFlags & D3D11_BIND_VERTEX_BUFFER) return GpuMemoryVertexBuffer;
+	if(bindFlags & D3D11_BIND_INDEX_BUFFER) return GpuMemoryIndexBuffer;
+	if(bindFlags & D3D11_BIND_CONSTANT_BUFFER) return GpuMemoryConstantBuffer;
+	if(bindFlags & D3D11_BIND_DEPTH_STENCIL) return GpuMemoryDepthStencil;
+
+	// Textures that get their mips generated are bound as render targets too
+	if((bindFlags & D3D11_BIND_RENDER_TARGET) && !(bindFlags & D3D11_BIND_SHADER_RESOURCE)) return GpuMemoryRenderTarget;
+	if(bindFlags & D3D11_BIND_SHADER_RESOURCE) return GpuMemoryTexture;
+
+	return GpuMemoryOther;
+}
+
+GpuAllocationId ReserveGpuMemory(GpuMemoryCategory category, uint64_t bytes){
+	return GetGpuMemoryTracker().allocate(category, bytes, t_tag);
+}
+
+void BindGpuMemory(ID3D11Resource *resource, GpuAllocationId allocation){
+	if(allocation == GpuMemoryTracker::InvalidAllocation) return;
+
+	if(!resource){
+		GetGpuMemoryTracker().free(allocation);
+		return;
+	}
+
+	// The resource holds the only reference once this one is dropped, if it couldn't take one the
+	// reservation is freed here
+	ReleaseHook *hook = new ReleaseHook(allocation);
+
+	resource->SetPrivateDataInterface(ReleaseHookGuid, hook);
+	hook->Release();
+}
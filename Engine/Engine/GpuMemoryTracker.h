@@ -0,0 +1,132 @@
+#pragma once
+
+//////////////////////////////
+// GPU memory tracker class //
+//////////////////////////////
+
+enum GpuMemoryCategory{
+	GpuMemoryVertexBuffer,
+	GpuMemoryIndexBuffer,
+	GpuMemoryConstantBuffer,
+	GpuMemoryTexture,
+	GpuMemoryRenderTarget,
+	GpuMemoryDepthStencil,
+	GpuMemoryStaging,
+	GpuMemoryOther,
+	GpuMemoryCategoryCount
+};
+
+typedef uint64_t GpuAllocationId;
+
+struct GpuMemoryUsage{
+	uint64_t bytes, peakBytes;
+	uint32_t numAllocations;
+
+	// 0 when unlimited, allocations that would go over it are rejected
+	uint64_t budget;
+	uint64_t numRejected;
+
+	// Bytes allocated and freed during the last finished frame
+	uint64_t frameAllocated, frameFreed;
+};
+
+struct GpuMemoryStats{
+	uint64_t frame;
+
+	GpuMemoryUsage categories[GpuMemoryCategoryCount];
+	GpuMemoryUsage total;
+};
+
+struct GpuMemoryTagStats{
+	std::wstring name;
+
+	uint64_t bytes, peakBytes;
+	uint32_t numAllocations;
+};
+
+// Sizes of GPU resources by category and by the asset that created them. Only does the bookkeeping, the
+// sizes are estimates from the resource descriptions since D3D11 doesn't report the real ones
+class GpuMemoryTracker{
+public:
+	static const GpuAllocationId InvalidAllocation	= 0;
+	static const uint32_t NoTag						= 0xFFFFFFFF;
+
+private:
+	struct Allocation{
+		GpuMemoryCategory category;
+		uint64_t bytes;
+		uint32_t tag;
+	};
+
+	mutable std::mutex m_mutex;
+
+	std::unordered_map<GpuAllocationId, Allocation> m_allocations;
+	GpuAllocationId m_nextAllocation;
+
+	GpuMemoryUsage m_categories[GpuMemoryCategoryCount], m_total;
+
+	// Bytes allocated and freed so far this frame, index GpuMemoryCategoryCount is the total
+	uint64_t m_frameAllocated[GpuMemoryCategoryCount + 1], m_frameFreed[GpuMemoryCategoryCount + 1];
+	uint64_t m_frame;
+
+	std::vector<GpuMemoryTagStats> m_tags;
+	std::unordered_map<std::wstring, uint32_t> m_tagIndices;
+
+	GpuMemoryTracker(const GpuMemoryTracker &) = delete;
+	GpuMemoryTracker &operator=(const GpuMemoryTracker &) = delete;
+
+public:
+	GpuMemoryTracker();
+
+	// 0 removes the budget, lowering it below the current usage only affects new allocations
+	void setBudget(GpuMemoryCategory category, uint64_t bytes);
+	void setTotalBudget(uint64_t bytes);
+
+	// The same name always gives the same tag
+	uint32_t getTag(const std::wstring &name);
+
+	// InvalidAllocation if the category or total budget would be exceeded
+	GpuAllocationId allocate(GpuMemoryCategory category, uint64_t bytes, uint32_t tag = NoTag);
+	void free(GpuAllocationId allocation);
+
+	// Closes the frame's allocated and freed counters
+	void endFrame();
+
+	void getStats(GpuMemoryStats &stats) const;
+
+	// Every tag that has held memory, largest current usage first
+	void getTagStats(std::vector<GpuMemoryTagStats> &tags) const;
+
+	std::string formatStats(uint32_t maxTags = 8) const;
+
+	static const char *GetCategoryName(GpuMemoryCategory category);
+};
+
+// Process-wide tracker every resource creation path reports to. Never destroyed, so resources released
+// during static destruction can still report
+GpuMemoryTracker &GetGpuMemoryTracker();
+
+// Tags allocations the calling thread makes while it's in scope, usually with the asset's path
+class GpuMemoryTag{
+private:
+	uint32_t m_previous;
+
+	GpuMemoryTag(const GpuMemoryTag &) = delete;
+	GpuMemoryTag &operator=(const GpuMemoryTag &) = delete;
+
+public:
+	GpuMemoryTag(const std::wstring &name);
+	~GpuMemoryTag();
+
+	static uint32_t getCurrent();
+};
+
+// D3D11 side, allocations go to the process-wide tracker under the calling thread's tag
+GpuMemoryCategory GetGpuMemoryCategory(UINT bindFlags, D3D11_USAGE usage);
+
+// Reserves the memory before the resource is created, InvalidAllocation when over budget
+GpuAllocationId ReserveGpuMemory(GpuMemoryCategory category, uint64_t bytes);
+
+// Hands the reservation to the resource, it is freed when the resource is destroyed. A null resource
+// (creation failed) frees it right away
+void BindGpuMemory(ID3D11Resource *resource, GpuAllocationId allocation);
@@ -0,0 +1,272 @@
+#include "Engine.h"
+
+namespace{
+
+class D3D11QuerySource : public GpuQuerySource{
+private:
+	ID3D11Device *m_device;
+	ID3D11DeviceContext *m_context;
+
+	std::vector<ID3D11Query *> m_disjoint, m_timestamps;
+	uint32_t m_numTimestamps;
+
+	template<typename T>
+	bool getData(ID3D11Query *query, T &data){
+
+		// S_FALSE until the GPU is done, never flush or wait here
+		return m_context->GetData(query, &data, sizeof(T), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+	}
+
+public:
+	D3D11QuerySource(ID3D11Device *device, ID3D11DeviceContext *context) : m_device(device), m_context(context), m_numTimestamps(0){
+
+	}
+
+	~D3D11QuerySource(){
+		for(auto query : m_disjoint){
+			ReleaseCOM(query);
+		}
+
+		for(auto query : m_timestamps){
+			ReleaseCOM(query);
+		}
+	}
+
+	bool create(uint32_t numFrames, uint32_t numTimestamps){
+		D3D11_QUERY_DESC disjointDesc = {D3D11_QUERY_TIMESTAMP_DISJOINT, 0};
+		D3D11_QUERY_DESC timestampDesc = {D3D11_QUERY_TIMESTAMP, 0};
+
+		m_numTimestamps = numTimestamps;
+		m_disjoint.resize(numFrames, nullptr);
+		m_timestamps.resize(numFrames * numTimestamps, nullptr);
+
+		for(auto &query : m_disjoint){
+			if(FAILED(m_device->CreateQuery(&disjointDesc, &query))) return false;
+		}
+
+		for(auto &query : m_timestamps){
+			if(FAILED(m_device->CreateQuery(&timestampDesc, &query))) return false;
+		}
+
+		return true;
+	}
+
+	void beginFrame(uint32_t frame){
+		m_context->Begin(m_disjoint[frame]);
+	}
+
+	void endFrame(uint32_t frame){
+		m_context->End(m_disjoint[frame]);
+	}
+
+	void timestamp(uint32_t frame, uint32_t index){
+		m_context->End(m_timestamps[frame * m_numTimestamps + index]);
+	}
+
+	bool getFrequency(uint32_t frame, uint64_t &frequency, bool &disjoint){
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT data;
+
+		if(!getData(m_disjoint[frame], data)) return false;
+
+		frequency = data.Frequency;
+		disjoint = data.Disjoint != FALSE;
+
+		return true;
+	}
+
+	bool getTimestamp(uint32_t frame, uint32_t index, uint64_t &ticks){
+		UINT64 data;
+
+		if(!getData(m_timestamps[frame * m_numTimestamps + index], data)) return false;
+
+		ticks = data;
+
+		return true;
+	}
+};
+
+}
+
+GpuProfiler::GpuProfiler(ID3D11Device *device, ID3D11DeviceContext *context, uint32_t latency) :
+	GpuProfiler(std::unique_ptr<GpuQuerySource>(new D3D11QuerySource(device, context)), latency){
+
+}
+
+GpuProfiler::GpuProfiler(std::unique_ptr<GpuQuerySource> source, uint32_t latency) : m_source(std::move(source)){
+	m_frames.resize(std::max<uint32_t>(latency, 1) + 1);
+
+	for(auto &frame : m_frames){
+		frame.numZones	= 0;
+		frame.index		= 0;
+		frame.pending	= false;
+	}
+
+	m_frameIndex	= 0;
+	m_current		= nullptr;
+	m_depth			= 0;
+
+	m_numCollected	= 0;
+	m_numSkipped	= 0;
+	m_numDisjoint	= 0;
+
+	// Every zone takes a timestamp when it begins and one when it ends
+	m_created = m_source->create(static_cast<uint32_t>(m_frames.size()), MaxZones * 2);
+	m_track = Profiler::createTrack("GPU");
+}
+
+bool GpuProfiler::collect(Frame &frame){
+	uint32_t slot = static_cast<uint32_t>(frame.index % m_frames.size());
+	uint64_t frequency = 0, ticks[MaxZones * 2];
+	bool disjoint = false;
+
+	// The disjoint query ends after every timestamp, but check them all anyway
+	if(!m_source->getFrequency(slot, frequency, disjoint)) return false;
+
+	for(uint32_t i = 0; i < frame.numZones; i++){
+		if(!frame.zones[i].ended) continue;
+
+		if(!m_source->getTimestamp(slot, i * 2, ticks[i * 2]) || !m_source->getTimestamp(slot, i * 2 + 1, ticks[i * 2 + 1])) return false;
+	}
+
+	frame.pending = false;
+
+	// The GPU clock changed mid-frame, the timestamps can't be trusted
+	if(disjoint || frequency == 0){
+		m_numDisjoint++;
+		return true;
+	}
+
+	m_numCollected++;
+
+	uint64_t first = UINT64_MAX;
+
+	for(uint32_t i = 0; i < frame.numZones; i++){
+		if(frame.zones[i].ended) first = std::min(first, ticks[i * 2]);
+	}
+
+	m_timings.clear();
+
+	if(first == UINT64_MAX) return true;
+
+	// Without a shared clock, place the frame as early on the CPU timeline as it can be without any
+	// timestamp landing before the CPU issued it
+	double cyclesPerTick = Profiler::getCyclesPerSecond() / frequency;
+	double msPerTick = 1000.0 / frequency;
+	double offset = -DBL_MAX;
+
+	for(uint32_t i = 0; i < frame.numZones; i++){
+		const Zone &zone = frame.zones[i];
+
+		if(!zone.ended) continue;
+
+		offset = std::max(offset, zone.beginIssued - (static_cast<int64_t>(ticks[i * 2] - first)) * cyclesPerTick);
+		offset = std::max(offset, zone.endIssued - (static_cast<int64_t>(ticks[i * 2 + 1] - first)) * cyclesPerTick);
+	}
+
+	for(uint32_t i = 0; i < frame.numZones; i++){
+		const Zone &zone = frame.zones[i];
+
+		if(!zone.ended) continue;
+
+		int64_t begin = static_cast<int64_t>(ticks[i * 2] - first);
+		int64_t end = std::max(begin, static_cast<int64_t>(ticks[i * 2 + 1] - first));
+
+		Profiler::recordZone(m_track, zone.name, static_cast<uint64_t>(offset + begin * cyclesPerTick),
+			static_cast<uint64_t>(offset + end * cyclesPerTick), zone.depth);
+
+		GpuZoneTiming timing = {zone.name, zone.depth, begin * msPerTick, (end - begin) * msPerTick};
+		m_timings.push_back(timing);
+	}
+
+	return true;
+}
+
+void GpuProfiler::beginFrame(){
+	if(!m_created) return;
+
+	// Read back oldest first, a frame can't finish before the ones submitted ahead of it
+	std::vector<Frame *> pending;
+
+	for(auto &frame : m_frames){
+		if(frame.pending) pending.push_back(&frame);
+	}
+
+	std::sort(pending.begin(), pending.end(), [](const Frame *a, const Frame *b){
+		return a->index < b->index;
+	});
+
+	for(auto frame : pending){
+		if(!collect(*frame)) break;
+	}
+
+	// The GPU is too far behind to reuse the queries, skip this frame rather than stall
+	Frame &frame = m_frames[m_frameIndex % m_frames.size()];
+
+	if(frame.pending){
+		m_numSkipped++;
+		return;
+	}
+
+	frame.index		= m_frameIndex;
+	frame.numZones	= 0;
+
+	m_current	= &frame;
+	m_depth		= 0;
+
+	m_source->beginFrame(static_cast<uint32_t>(m_frameIndex % m_frames.size()));
+}
+
+void GpuProfiler::endFrame(){
+	if(m_current){
+		m_source->endFrame(static_cast<uint32_t>(m_frameIndex % m_frames.size()));
+
+		m_current->pending = true;
+		m_current = nullptr;
+	}
+
+	m_frameIndex++;
+}
+
+uint32_t GpuProfiler::beginZone(const char *name){
+	if(!m_current || m_current->numZones == MaxZones) return InvalidZone;
+
+	uint32_t index = m_current->numZones++;
+	Zone &zone = m_current->zones[index];
+
+	zone.name			= name;
+	zone.depth			= m_depth++;
+	zone.beginIssued	= ReadCycleCounter();
+	zone.endIssued		= 0;
+	zone.ended			= false;
+
+	m_source->timestamp(static_cast<uint32_t>(m_frameIndex % m_frames.size()), index * 2);
+
+	return index;
+}
+
+void GpuProfiler::endZone(uint32_t zone){
+	if(!m_current || zone >= m_current->numZones || m_current->zones[zone].ended) return;
+
+	m_current->zones[zone].endIssued = ReadCycleCounter();
+	m_current->zones[zone].ended = true;
+
+	m_source->timestamp(static_cast<uint32_t>(m_frameIndex % m_frames.size()), zone * 2 + 1);
+
+	m_depth--;
+}
+
+const std::vector<GpuZoneTiming> &GpuProfiler::getTimings() const{
+	return m_timings;
+}
+
+uint64_t GpuProfiler::getNumCollected() const{
+	return m_numCollected;
+}
+
+uint64_t GpuProfiler::getNumSkipped() const{
+	return m_numSkipped;
+}
+
+uint64_t GpuProfiler::getNumDisjoint() const{
+	return m_numDisjoint;
+}
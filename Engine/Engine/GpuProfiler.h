@@ -0,0 +1,116 @@
+#pragma once
+
+////////////////////////
+// GPU profiler class //
+////////////////////////
+
+// The queries the GPU profiler issues, implemented over D3D11 and by fakes that run without a device
+class GpuQuerySource{
+public:
+	virtual ~GpuQuerySource(){}
+
+	// One disjoint query per frame slot plus numTimestamps timestamp queries per slot
+	virtual bool create(uint32_t numFrames, uint32_t numTimestamps) = 0;
+
+	// Brackets a frame with its disjoint query
+	virtual void beginFrame(uint32_t frame) = 0;
+	virtual void endFrame(uint32_t frame) = 0;
+
+	virtual void timestamp(uint32_t frame, uint32_t index) = 0;
+
+	// Never block, false while the GPU hasn't got that far
+	virtual bool getFrequency(uint32_t frame, uint64_t &frequency, bool &disjoint) = 0;
+	virtual bool getTimestamp(uint32_t frame, uint32_t index, uint64_t &ticks) = 0;
+};
+
+struct GpuZoneTiming{
+	const char *name;
+	uint32_t depth;
+
+	// Milliseconds, begin is relative to the first zone of the frame
+	double begin, duration;
+};
+
+class GpuProfiler{
+public:
+	static const uint32_t MaxZones		= 32;
+	static const uint32_t InvalidZone	= 0xFFFFFFFF;
+
+private:
+	struct Zone{
+		const char *name;
+		uint32_t depth;
+
+		// Cycle counter when each timestamp was issued, the GPU can't have reached it before then
+		uint64_t beginIssued, endIssued;
+		bool ended;
+	};
+
+	struct Frame{
+		Zone zones[MaxZones];
+		uint32_t numZones;
+
+		uint64_t index;
+		bool pending;
+	};
+
+	std::unique_ptr<GpuQuerySource> m_source;
+	std::vector<Frame> m_frames;
+	bool m_created;
+
+	// Frame being recorded, skipped frames record nothing
+	uint64_t m_frameIndex;
+	Frame *m_current;
+	uint32_t m_depth;
+
+	uint64_t m_numCollected, m_numSkipped, m_numDisjoint;
+
+	// Results of the newest collected frame
+	std::vector<GpuZoneTiming> m_timings;
+
+	Profiler::ThreadBuffer *m_track;
+
+	bool collect(Frame &frame);
+
+public:
+
+	// latency is how many frames the GPU may fall behind before frames stop being timed, results show up
+	// that many frames late
+	GpuProfiler(ID3D11Device *device, ID3D11DeviceContext *context, uint32_t latency = 3);
+	GpuProfiler(std::unique_ptr<GpuQuerySource> source, uint32_t latency = 3);
+
+	// Reads back every finished frame, then starts timing a new one unless its queries are still in use
+	void beginFrame();
+	void endFrame();
+
+	uint32_t beginZone(const char *name);
+	void endZone(uint32_t zone);
+
+	// Zones of the newest frame that has been read back
+	const std::vector<GpuZoneTiming> &getTimings() const;
+
+	uint64_t getNumCollected() const;
+	uint64_t getNumSkipped() const;
+	uint64_t getNumDisjoint() const;
+};
+
+// Times its scope on the GPU
+class GpuProfileZone{
+private:
+	GpuProfiler &m_profiler;
+	uint32_t m_zone;
+
+	GpuProfileZone(const GpuProfileZone &) = delete;
+	GpuProfileZone &operator=(const GpuProfileZone &) = delete;
+
+public:
+	GpuProfileZone(GpuProfiler &profiler, const char *name) : m_profiler(profiler){
+		m_zone = m_profiler.beginZone(name);
+	}
+
+	~GpuProfileZone(){
+		m_profiler.endZone(m_zone);
+	}
+};
+
+#define GPU_PROFILE_ZONE(profiler, name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(profiler, name)
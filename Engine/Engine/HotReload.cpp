@@ -0,0 +1,358 @@
+#include "Engine.h"
+
+#if !defined(_WIN32)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace{
+
+#if defined(_WIN32)
+const wchar_t PathSeparator = L'\\';
+#else
+const wchar_t PathSeparator = L'/';
+#endif
+
+// Room for a few hundred notifications between polls, an overflow reloads the whole directory
+const size_t NotifyBufferSize = 64 * 1024;
+
+bool IsSeparator(wchar_t c){
+	return c == L'\\' || c == L'/';
+}
+
+std::wstring JoinPath(const std::wstring &directory, const std::wstring &name){
+	if(directory.empty() || IsSeparator(directory.back())) return directory + name;
+
+	return directory + PathSeparator + name;
+}
+
+}
+
+FileWatcher::FileWatcher(const std::wstring &directory) : m_directory(directory), m_numOverflows(0){
+#if defined(_WIN32)
+	m_pending	= false;
+	m_event		= CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_handle	= CreateFile(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+
+	m_buffer.resize(NotifyBufferSize / sizeof(DWORD));
+
+	if(isValid()) issue();
+#else
+	std::string narrow(directory.size() * MB_LEN_MAX + 1, '\0');
+	size_t length = wcstombs(&narrow[0], directory.c_str(), narrow.size());
+
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	m_buffer.resize(NotifyBufferSize);
+
+	if(m_fd >= 0 && (length == static_cast<size_t>(-1) ||
+		inotify_add_watch(m_fd, narrow.substr(0, length).c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0)){
+
+		close(m_fd);
+		m_fd = -1;
+	}
+#endif
+}
+
+FileWatcher::~FileWatcher(){
+#if defined(_WIN32)
+
+	// The read has to be finished before the buffer goes away
+	if(m_pending){
+		DWORD bytes;
+
+		CancelIo(m_handle);
+		GetOverlappedResult(m_handle, &m_overlapped, &bytes, TRUE);
+	}
+
+	if(m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+	if(m_event) CloseHandle(m_event);
+#else
+	if(m_fd >= 0) close(m_fd);
+#endif
+}
+
+#if defined(_WIN32)
+bool FileWatcher::issue(){
+	memset(&m_overlapped, 0, sizeof(OVERLAPPED));
+	m_overlapped.hEvent = m_event;
+
+	m_pending = ReadDirectoryChangesW(m_handle, &m_buffer[0], static_cast<DWORD>(m_buffer.size() * sizeof(DWORD)), TRUE,
+		FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, NULL, &m_overlapped, NULL) != FALSE;
+
+	return m_pending;
+}
+#endif
+
+bool FileWatcher::isValid() const{
+#if defined(_WIN32)
+	return m_handle != INVALID_HANDLE_VALUE && m_event != NULL;
+#else
+	return m_fd >= 0;
+#endif
+}
+
+void FileWatcher::poll(std::vector<std::wstring> &changed){
+	if(!isValid()) return;
+
+#if defined(_WIN32)
+	if(!m_pending && !issue()) return;
+
+	DWORD bytes;
+
+	if(!GetOverlappedResult(m_handle, &m_overlapped, &bytes, FALSE)){
+		if(GetLastError() != ERROR_IO_INCOMPLETE) m_pending = false;
+		return;
+	}
+
+	m_pending = false;
+
+	// Zero bytes means the notifications didn't fit
+	if(bytes == 0){
+		m_numOverflows++;
+		changed.push_back(m_directory);
+	}
+	else{
+		const uint8_t *position = reinterpret_cast<const uint8_t *>(&m_buffer[0]);
+
+		while(true){
+			const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(position);
+
+			if(info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME){
+				changed.push_back(JoinPath(m_directory, std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR))));
+			}
+
+			if(info->NextEntryOffset == 0) break;
+
+			position += info->NextEntryOffset;
+		}
+	}
+
+	issue();
+#else
+	while(true){
+		ssize_t bytes = read(m_fd, &m_buffer[0], m_buffer.size());
+
+		if(bytes <= 0) break;
+
+		for(ssize_t offset = 0; offset < bytes;){
+			const inotify_event *event = reinterpret_cast<const inotify_event *>(&m_buffer[offset]);
+
+			if(event->mask & IN_Q_OVERFLOW){
+				m_numOverflows++;
+				changed.push_back(m_directory);
+			}
+			else if(event->len > 0){
+				std::wstring name(strlen(event->name), L'\0');
+				size_t length = mbstowcs(&name[0], event->name, name.size());
+
+				if(length != static_cast<size_t>(-1)) changed.push_back(JoinPath(m_directory, name.substr(0, length)));
+			}
+
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+#endif
+}
+
+const std::wstring &FileWatcher::getDirectory() const{
+	return m_directory;
+}
+
+uint32_t FileWatcher::getNumOverflows() const{
+	return m_numOverflows;
+}
+
+ChangeDebouncer::ChangeDebouncer(double delay) : m_delay(delay){
+
+}
+
+void ChangeDebouncer::notify(const std::wstring &path, double time){
+	auto it = m_changes.find(path);
+
+	if(it == m_changes.end()){
+		Change change = {time, time};
+		m_changes[path] = change;
+	}
+	else{
+		it->second.lastTime = time;
+	}
+}
+
+void ChangeDebouncer::collect(double time, std::vector<ReadyChange> &ready){
+	for(auto it = m_changes.begin(); it != m_changes.end();){
+		if(time - it->second.lastTime < m_delay){
+			++it;
+			continue;
+		}
+
+		ReadyChange change = {it->first, it->second.firstTime};
+
+		ready.push_back(change);
+		it = m_changes.erase(it);
+	}
+}
+
+size_t ChangeDebouncer::getNumPending() const{
+	return m_changes.size();
+}
+
+const double HotReloader::DefaultDelay = 0.1;
+
+HotReloader::HotReloader(double delay) : m_debouncer(delay){
+	memset(&m_stats, 0, sizeof(HotReloadStats));
+
+	m_totalReloadTime = 0;
+	m_timer.createTimeStamp(m_start);
+}
+
+double HotReloader::getTime() const{
+	TimeStamp now;
+
+	m_timer.createTimeStamp(now);
+
+	return m_timer.getDeltaTime(m_start, now);
+}
+
+bool HotReloader::watch(const std::wstring &directory){
+	std::unique_ptr<FileWatcher> watcher(new FileWatcher(directory));
+
+	if(!watcher->isValid()) return false;
+
+	m_watchers.push_back(std::move(watcher));
+
+	return true;
+}
+
+void HotReloader::add(const std::wstring &path, const ReloadFunc &reload){
+	Asset asset = {path, reload};
+
+	m_assets[NormalizePath(path)].push_back(asset);
+}
+
+void HotReloader::notify(const std::wstring &path){
+	m_stats.numChanges++;
+	m_debouncer.notify(NormalizePath(path), getTime());
+}
+
+uint32_t HotReloader::update(){
+	m_changed.clear();
+
+	for(auto &watcher : m_watchers){
+		watcher->poll(m_changed);
+	}
+
+	for(const auto &path : m_changed){
+		notify(path);
+	}
+
+	m_ready.clear();
+	m_debouncer.collect(getTime(), m_ready);
+
+	uint32_t numReloads = 0;
+
+	for(const auto &change : m_ready){
+		auto it = m_assets.find(change.path);
+
+		if(it != m_assets.end()){
+			for(const auto &asset : it->second){
+				reload(asset, change.firstTime);
+				numReloads++;
+			}
+
+			continue;
+		}
+
+		// A directory whose notifications were lost, everything under it is reloaded
+		std::wstring prefix = change.path + PathSeparator;
+
+		for(const auto &entry : m_assets){
+			if(entry.first.compare(0, prefix.size(), prefix) != 0) continue;
+
+			for(const auto &asset : entry.second){
+				reload(asset, change.firstTime);
+				numReloads++;
+			}
+		}
+	}
+
+	return numReloads;
+}
+
+void HotReloader::reload(const Asset &asset, double firstTime){
+	double begin = getTime();
+	bool succeeded = asset.reload(asset.path);
+	double end = getTime();
+
+	if(!succeeded){
+		m_stats.numFailed++;
+
+		char message[512];
+
+		sprintf_s(message, "Hot reload failed: %ls\n", asset.path.c_str());
+		OutputDebugStringA(message);
+
+		return;
+	}
+
+	m_stats.numReloads++;
+
+	m_stats.lastLatency			= end - firstTime;
+	m_stats.lastReloadTime		= end - begin;
+	m_stats.maxReloadTime		= std::max(m_stats.maxReloadTime, m_stats.lastReloadTime);
+
+	m_totalReloadTime += m_stats.lastReloadTime;
+	m_stats.averageReloadTime	= m_totalReloadTime / m_stats.numReloads;
+}
+
+const HotReloadStats &HotReloader::getStats() const{
+	return m_stats;
+}
+
+std::string HotReloader::formatStats() const{
+	char text[256];
+
+	sprintf_s(text, "Hot reload: %llu changes, %llu reloads (%llu failed), %.3f ms average, %.3f ms max, %.3f ms last latency\n",
+		m_stats.numChanges, m_stats.numReloads, m_stats.numFailed, m_stats.averageReloadTime * 1000, m_stats.maxReloadTime * 1000,
+		m_stats.lastLatency * 1000);
+
+	return text;
+}
+
+std::wstring HotReloader::NormalizePath(const std::wstring &path){
+	std::vector<std::wstring> parts;
+	size_t begin = 0;
+	bool absolute = !path.empty() && IsSeparator(path[0]);
+
+	while(begin <= path.size()){
+		size_t end = begin;
+
+		while(end < path.size() && !IsSeparator(path[end])) end++;
+
+		std::wstring part = path.substr(begin, end - begin);
+
+		// Leading ".." can't be resolved without the working directory, they are kept
+		if(part == L".."){
+			if(!parts.empty() && parts.back() != L"..") parts.pop_back();
+			else parts.push_back(part);
+		}
+		else if(!part.empty() && part != L"."){
+			parts.push_back(part);
+		}
+
+		begin = end + 1;
+	}
+
+	std::wstring normalized = absolute ? std::wstring(1, PathSeparator) : std::wstring();
+
+	for(size_t i = 0; i < parts.size(); i++){
+		if(i > 0) normalized += PathSeparator;
+		normalized += parts[i];
+	}
+
+#if defined(_WIN32)
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), towlower);
+#endif
+
+	return normalized;
+}
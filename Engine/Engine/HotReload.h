@@ -0,0 +1,138 @@
+#pragma once
+
+////////////////////////
+// Hot reload classes //
+////////////////////////
+
+// Reports files that changed in a directory without blocking. Subdirectories are watched too with
+// ReadDirectoryChangesW, inotify only watches the directory itself
+class FileWatcher{
+private:
+	std::wstring m_directory;
+	uint32_t m_numOverflows;
+
+#if defined(_WIN32)
+	HANDLE m_handle, m_event;
+	OVERLAPPED m_overlapped;
+	std::vector<DWORD> m_buffer;
+	bool m_pending;
+
+	bool issue();
+#else
+	int m_fd;
+	std::vector<char> m_buffer;
+#endif
+
+	FileWatcher(const FileWatcher &) = delete;
+	FileWatcher &operator=(const FileWatcher &) = delete;
+
+public:
+	FileWatcher(const std::wstring &directory);
+	~FileWatcher();
+
+	bool isValid() const;
+
+	// Appends the paths that changed since the last poll. When notifications were lost the directory itself
+	// is reported, anything in it may have changed
+	void poll(std::vector<std::wstring> &changed);
+
+	const std::wstring &getDirectory() const;
+	uint32_t getNumOverflows() const;
+};
+
+// Holds changes back until a path has been quiet for the delay, editors often save in several writes
+class ChangeDebouncer{
+public:
+	struct ReadyChange{
+		std::wstring path;
+
+		// When the first of the writes was seen
+		double firstTime;
+	};
+
+private:
+	struct Change{
+		double firstTime, lastTime;
+	};
+
+	std::unordered_map<std::wstring, Change> m_changes;
+	double m_delay;
+
+public:
+	ChangeDebouncer(double delay);
+
+	void notify(const std::wstring &path, double time);
+
+	// Moves the paths that haven't changed for the delay into ready
+	void collect(double time, std::vector<ReadyChange> &ready);
+
+	size_t getNumPending() const;
+};
+
+struct HotReloadStats{
+	uint64_t numChanges, numReloads, numFailed;
+
+	// Seconds, latency is from the first change seen to the reload finishing and includes the debounce delay,
+	// reload time is the loader alone
+	double lastLatency, lastReloadTime, averageReloadTime, maxReloadTime;
+};
+
+// Re-runs the loader of an asset when its file changes. Loaders swap the new resources in behind the handles
+// and pointers that are read every frame, so whatever holds those doesn't notice
+class HotReloader{
+public:
+
+	// Returns false to keep the old resource, e.g. when a shader no longer compiles
+	typedef std::function<bool(const std::wstring &path)> ReloadFunc;
+
+	static const double DefaultDelay;
+
+private:
+	struct Asset{
+		std::wstring path;
+		ReloadFunc reload;
+	};
+
+	std::vector<std::unique_ptr<FileWatcher>> m_watchers;
+
+	// Keyed by normalized path
+	std::unordered_map<std::wstring, std::vector<Asset>> m_assets;
+
+	ChangeDebouncer m_debouncer;
+
+	Timer m_timer;
+	TimeStamp m_start;
+
+	HotReloadStats m_stats;
+	double m_totalReloadTime;
+
+	std::vector<std::wstring> m_changed;
+	std::vector<ChangeDebouncer::ReadyChange> m_ready;
+
+	double getTime() const;
+	void reload(const Asset &asset, double firstTime);
+
+	HotReloader(const HotReloader &) = delete;
+	HotReloader &operator=(const HotReloader &) = delete;
+
+public:
+	HotReloader(double delay = DefaultDelay);
+
+	bool watch(const std::wstring &directory);
+
+	// The directory holding path has to be watched for changes to be seen, several loaders may share a path
+	void add(const std::wstring &path, const ReloadFunc &reload);
+
+	// Same as a change seen by a watcher
+	void notify(const std::wstring &path);
+
+	// Polls the watchers and reloads whatever stopped changing, returns how many loaders ran. Loaders run on
+	// the calling thread, which has to be the one that owns the resources
+	uint32_t update();
+
+	const HotReloadStats &getStats() const;
+	std::string formatStats() const;
+
+	// Both slashes separate, "." and ".." are resolved where possible, case is folded on Windows
+	static std::wstring NormalizePath(const std::wstring &path);
+};
@@ -1,29 +1,133 @@
 #include "Engine.h"
 
-Id::Id(){
-	wchar_t string[40];
+Id::Id() : m_value(InvalidIndex){
 
-	CoCreateGuid(&m_guid);
-	StringFromGUID2(m_guid, string, 40);
-	m_string = string;
 }
 
-Id::~Id(){
+Id::Id(uint32_t index, uint32_t generation) : m_value(static_cast<uint64_t>(generation) << 32 | index){
+
+}
 
+uint32_t Id::getIndex() const{
+	return static_cast<uint32_t>(m_value);
 }
 
-std::wstring Id::toString() const{
-	return m_string;
+uint32_t Id::getGeneration() const{
+	return static_cast<uint32_t>(m_value >> 32);
 }
 
-const wchar_t * Id::toCString() const{
-	return m_string.c_str();
+uint64_t Id::getValue() const{
+	return m_value;
+}
+
+bool Id::isNull() const{
+	return getIndex() == InvalidIndex;
 }
 
 bool Id::operator== (const Id &id) const{
-	return m_guid == id.m_guid;
+	return m_value == id.m_value;
 }
 
 bool Id::operator!= (const Id &id) const{
-	return m_guid != id.m_guid;
+	return m_value != id.m_value;
+}
+
+bool Id::operator< (const Id &id) const{
+	return m_value < id.m_value;
+}
+
+IdAllocator::IdAllocator(){
+	m_firstFree	= Id::InvalidIndex;
+	m_numAlive	= 0;
+}
+
+IdAllocator::~IdAllocator(){
+
+}
+
+Id IdAllocator::create(){
+	uint32_t index = m_firstFree;
+
+	if(index != Id::InvalidIndex){
+		m_firstFree = m_slots[index].nextFree;
+	}
+	else{
+
+		// The last index is reserved for the null id
+		if(m_slots.size() >= Id::InvalidIndex) return Id();
+
+		Slot slot = {1, Id::InvalidIndex};
+
+		index = static_cast<uint32_t>(m_slots.size());
+		m_slots.push_back(slot);
+	}
+
+	m_slots[index].nextFree = index;
+	m_numAlive++;
+
+	return Id(index, m_slots[index].generation);
+}
+
+bool IdAllocator::destroy(const Id &id){
+	if(!isValid(id)) return false;
+
+	uint32_t index = id.getIndex();
+	Slot &slot = m_slots[index];
+
+	// Generation 0 is skipped when it wraps so a default constructed id can never match
+	if(++slot.generation == 0) slot.generation = 1;
+
+	slot.nextFree = m_firstFree;
+	m_firstFree = index;
+	m_numAlive--;
+
+	if(!m_guids.empty()) m_guids.erase(index);
+
+	return true;
+}
+
+bool IdAllocator::isValid(const Id &id) const{
+	uint32_t index = id.getIndex();
+
+	// A live slot points its free list link at itself
+	return index < m_slots.size() && m_slots[index].generation == id.getGeneration() && m_slots[index].nextFree == index;
+}
+
+bool IdAllocator::getGuid(const Id &id, GUID &guid){
+	if(!isValid(id)) return false;
+
+	auto it = m_guids.find(id.getIndex());
+
+	if(it == m_guids.end()){
+		GUID created;
+
+		if(FAILED(CoCreateGuid(&created))) return false;
+
+		it = m_guids.insert(std::make_pair(id.getIndex(), created)).first;
+	}
+
+	guid = it->second;
+
+	return true;
+}
+
+std::wstring IdAllocator::getGuidString(const Id &id){
+	GUID guid;
+	wchar_t string[40];
+
+	if(!getGuid(id, guid) || !StringFromGUID2(guid, string, 40)) return std::wstring();
+
+	return string;
+}
+
+void IdAllocator::reserve(uint32_t capacity){
+	m_slots.reserve(capacity);
+}
+
+uint32_t IdAllocator::getNumAlive() const{
+	return m_numAlive;
+}
+
+uint32_t IdAllocator::getCapacity() const{
+	return static_cast<uint32_t>(m_slots.size());
 }
@@ -4,18 +4,67 @@
 // ID class //
 //////////////
 
+// Handle to a slot of an IdAllocator, the generation tells it apart from earlier users of the same slot
 class Id{
 private:
-	GUID m_guid;
-	std::wstring m_string;
+	uint64_t m_value;
 
 public:
+	static const uint32_t InvalidIndex = 0xFFFFFFFF;
+
+	// Null id, never valid
 	Id();
-	~Id();
+	Id(uint32_t index, uint32_t generation);
+
+	uint32_t getIndex() const;
+	uint32_t getGeneration() const;
+
+	// Index in the low half, generation in the high half
+	uint64_t getValue() const;
 
-	std::wstring toString() const;
-	const wchar_t *toCString() const;
+	bool isNull() const;
 
 	bool operator == (const Id &id) const;
 	bool operator != (const Id &id) const;
+	bool operator < (const Id &id) const;
+};
+
+// Hands out ids backed by a slot array, so creating, destroying and validating one are all O(1) without
+// touching the heap once the array has grown. Not thread safe
+class IdAllocator{
+private:
+	struct Slot{
+		uint32_t generation;
+
+		// Next slot on the free list while this one is free
+		uint32_t nextFree;
+	};
+
+	std::vector<Slot> m_slots;
+	uint32_t m_firstFree;
+	uint32_t m_numAlive;
+
+	// Only ids that were asked for one, e.g. when they're saved
+	std::unordered_map<uint32_t, GUID> m_guids;
+
+public:
+	IdAllocator();
+	~IdAllocator();
+
+	Id create();
+
+	// Stale and null ids are ignored
+	bool destroy(const Id &id);
+
+	// False once the id has been destroyed, even if its slot has been reused since
+	bool isValid(const Id &id) const;
+
+	// Created the first time it's asked for, stays the same until the id is destroyed
+	bool getGuid(const Id &id, GUID &guid);
+	std::wstring getGuidString(const Id &id);
+
+	void reserve(uint32_t capacity);
+
+	uint32_t getNumAlive() const;
+	uint32_t getCapacity() const;
 };
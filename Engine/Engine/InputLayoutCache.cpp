@@ -0,0 +1,94 @@
+#include "Engine.h"
+
+namespace{
+
+bool IsSameElement(const D3D11_INPUT_ELEMENT_DESC &a, const D3D11_INPUT_ELEMENT_DESC &b){
+	return a.SemanticIndex == b.SemanticIndex && a.Format == b.Format && a.InputSlot == b.InputSlot && a.AlignedByteOffset == b.AlignedByteOffset &&
+		a.InputSlotClass == b.InputSlotClass && a.InstanceDataStepRate == b.InstanceDataStepRate;
+}
+
+}
+
+InputLayoutCache::InputLayoutCache(ID3D11Device *device) :
+	m_create([device](const Util::VertexLayoutData &layoutData, ID3D11InputLayout **layout){
+		return Util::CreateVertexLayout(device, layoutData, layout);
+	}){
+
+	m_numHits = 0;
+}
+
+InputLayoutCache::InputLayoutCache(const CreateFunc &create) : m_create(create){
+	m_numHits = 0;
+}
+
+InputLayoutCache::~InputLayoutCache(){
+	for(auto &entry : m_entries){
+		ReleaseCOM(entry.layout);
+	}
+}
+
+uint64_t InputLayoutCache::ComputeKey(const std::vector<std::string> &semanticNames, const std::vector<D3D11_INPUT_ELEMENT_DESC> &elements){
+	uint64_t hash = Util::FNVOffsetBasis;
+
+	for(size_t i = 0; i < elements.size(); i++){
+		const D3D11_INPUT_ELEMENT_DESC &element = elements[i];
+
+		for(char c : semanticNames[i]){
+			char upper = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+			hash = Util::HashFNV1a(&upper, 1, hash);
+		}
+
+		// Fields are hashed one by one since the struct has a pointer and padding in it, the leading zero ends the name
+		uint32_t fields[] = {0, element.SemanticIndex, static_cast<uint32_t>(element.Format), element.InputSlot, element.AlignedByteOffset,
+			static_cast<uint32_t>(element.InputSlotClass), element.InstanceDataStepRate};
+
+		hash = Util::HashFNV1a(fields, sizeof(fields), hash);
+	}
+
+	return hash;
+}
+
+bool InputLayoutCache::IsSameSignature(const std::vector<std::string> &namesA, const std::vector<D3D11_INPUT_ELEMENT_DESC> &elementsA,
+	const std::vector<std::string> &namesB, const std::vector<D3D11_INPUT_ELEMENT_DESC> &elementsB){
+
+	if(elementsA.size() != elementsB.size()) return false;
+
+	for(size_t i = 0; i < elementsA.size(); i++){
+		if(!IsSameElement(elementsA[i], elementsB[i]) || _stricmp(namesA[i].c_str(), namesB[i].c_str()) != 0) return false;
+	}
+
+	return true;
+}
+
+bool InputLayoutCache::get(const Util::VertexLayoutData &layoutData, ID3D11InputLayout **layout){
+	if(layoutData.elements.empty() || layoutData.semanticNames.size() != layoutData.elements.size()) return false;
+
+	uint64_t key = ComputeKey(layoutData.semanticNames, layoutData.elements);
+
+	// Only a handful of signatures exist, so a linear scan over the keys is plenty
+	for(const auto &entry : m_entries){
+		if(entry.key == key && IsSameSignature(entry.semanticNames, entry.elements, layoutData.semanticNames, layoutData.elements)){
+			m_numHits++;
+			*layout = entry.layout;
+
+			return true;
+		}
+	}
+
+	Entry entry = {key, layoutData.semanticNames, layoutData.elements, nullptr};
+
+	if(!m_create(layoutData, &entry.layout)) return false;
+
+	m_entries.push_back(entry);
+	*layout = entry.layout;
+
+	return true;
+}
+
+uint32_t InputLayoutCache::getNumLayouts() const{
+	return static_cast<uint32_t>(m_entries.size());
+}
+
+uint32_t InputLayoutCache::getNumHits() const{
+	return m_numHits;
+}
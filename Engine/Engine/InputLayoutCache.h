@@ -0,0 +1,45 @@
+#pragma once
+
+//////////////////////////////
+// Input layout cache class //
+//////////////////////////////
+
+// Shares one input layout between every vertex shader with the same input signature
+class InputLayoutCache{
+public:
+
+	// Creates the layout for a signature that is not cached yet
+	typedef std::function<bool(const Util::VertexLayoutData &layoutData, ID3D11InputLayout **layout)> CreateFunc;
+
+private:
+	struct Entry{
+		uint64_t key;
+		std::vector<std::string> semanticNames;
+		std::vector<D3D11_INPUT_ELEMENT_DESC> elements;
+
+		ID3D11InputLayout *layout;
+	};
+
+	CreateFunc m_create;
+	std::vector<Entry> m_entries;
+	uint32_t m_numHits;
+
+public:
+	InputLayoutCache(ID3D11Device *device);
+	InputLayoutCache(const CreateFunc &create);
+	~InputLayoutCache();
+
+	// Hash of the semantic names (case-insensitive, like D3D matches them) and every field of the
+	// element descriptions, the bytecode is not part of it
+	static uint64_t ComputeKey(const std::vector<std::string> &semanticNames, const std::vector<D3D11_INPUT_ELEMENT_DESC> &elements);
+
+	// Full comparison used to confirm a key match
+	static bool IsSameSignature(const std::vector<std::string> &namesA, const std::vector<D3D11_INPUT_ELEMENT_DESC> &elementsA,
+		const std::vector<std::string> &namesB, const std::vector<D3D11_INPUT_ELEMENT_DESC> &elementsB);
+
+	// The returned layout is owned by the cache and must not be released. Call from the thread creating device resources
+	bool get(const Util::VertexLayoutData &layoutData, ID3D11InputLayout **layout);
+
+	uint32_t getNumLayouts() const;
+	uint32_t getNumHits() const;
+};
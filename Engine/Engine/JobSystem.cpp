@@ -0,0 +1,450 @@
+#include "Engine.h"
+
+namespace{
+
+// System and deque the current thread owns, threads not created by a system have none
+THREAD_LOCAL const JobSystem *t_system = nullptr;
+THREAD_LOCAL uint32_t t_index = 0;
+THREAD_LOCAL uint32_t t_random = 0;
+
+// Xorshift, used to pick where to steal from
+uint32_t NextRandom(){
+	uint32_t x = t_random ? t_random : 2463534242u + t_index;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return t_random = x;
+}
+
+const int64_t InitialRingSize = 256;
+
+}
+
+JobSystem::Counter::Counter(){
+	m_value = 0;
+}
+
+bool JobSystem::Counter::isDone() const{
+	return m_value.load() == 0;
+}
+
+JobSystem::WorkDeque::Ring::Ring(int64_t size) : capacity(size), items(new std::atomic<Job *>[static_cast<size_t>(size)]){
+
+}
+
+JobSystem::WorkDeque::WorkDeque(){
+	m_top		= 0;
+	m_bottom	= 0;
+
+	m_rings.push_back(std::unique_ptr<Ring>(new Ring(InitialRingSize)));
+	m_ring = m_rings.back().get();
+}
+
+void JobSystem::WorkDeque::push(Job *job){
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_acquire);
+	Ring *ring = m_ring.load(std::memory_order_relaxed);
+
+	// Full, move everything still queued over to a ring twice the size
+	if(bottom - top > ring->capacity - 1){
+		Ring *grown = new Ring(ring->capacity * 2);
+
+		for(int64_t i = top; i < bottom; i++){
+			grown->items[i & (grown->capacity - 1)].store(ring->items[i & (ring->capacity - 1)].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+
+		m_rings.push_back(std::unique_ptr<Ring>(grown));
+		m_ring.store(grown, std::memory_order_release);
+		ring = grown;
+	}
+
+	// Release publishes the job to thieves acquiring m_bottom
+	ring->items[bottom & (ring->capacity - 1)].store(job, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_release);
+}
+
+JobSystem::Job *JobSystem::WorkDeque::pop(){
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	Ring *ring = m_ring.load(std::memory_order_relaxed);
+
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	int64_t top = m_top.load(std::memory_order_relaxed);
+
+	// Empty
+	if(top > bottom){
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job *job = ring->items[bottom & (ring->capacity - 1)].load(std::memory_order_relaxed);
+
+	// Last job, race the thieves for it
+	if(top == bottom){
+		if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+JobSystem::Job *JobSystem::WorkDeque::steal(){
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+	if(top >= bottom) return nullptr;
+
+	Ring *ring = m_ring.load(std::memory_order_acquire);
+	Job *job = ring->items[top & (ring->capacity - 1)].load(std::memory_order_relaxed);
+
+	// Lost to the owner or another thief
+	if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+
+	return job;
+}
+
+JobSystem::JobSystem(uint32_t numWorkers) : m_jobPool("Jobs", sizeof(Job), std::alignment_of<Job>::value, 4 * JobBatchSize){
+	// At least one worker, threads that don't own a deque rely on the workers to drain the inbox
+	if(numWorkers == 0) numWorkers = std::max<uint32_t>(2, std::thread::hardware_concurrency()) - 1;
+
+	m_inbox			= nullptr;
+	m_numQueued		= 0;
+	m_numSleeping	= 0;
+	m_quit			= false;
+
+	for(uint32_t i = 0; i <= numWorkers; i++){
+		JobCache cache = {nullptr, 0};
+
+		m_deques.push_back(std::unique_ptr<WorkDeque>(new WorkDeque()));
+		m_jobCaches.push_back(std::unique_ptr<JobCache>(new JobCache(cache)));
+	}
+
+	// The creating thread is the main thread
+	t_system	= this;
+	t_index		= 0;
+
+	for(uint32_t i = 1; i <= numWorkers; i++){
+		m_workers.push_back(std::thread(&JobSystem::workerMain, this, i));
+	}
+}
+
+JobSystem::~JobSystem(){
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_quit = true;
+	}
+
+	m_wakeSignal.notify_all();
+
+	for(auto &worker : m_workers){
+		worker.join();
+	}
+
+	if(t_system == this) t_system = nullptr;
+}
+
+void JobSystem::workerMain(uint32_t index){
+	t_system	= this;
+	t_index		= index;
+
+	char name[32];
+	sprintf_s(name, "Worker %u", index);
+	Profiler::setThreadName(name);
+
+	while(true){
+		Job *job = take();
+
+		if(job){
+			execute(job);
+			continue;
+		}
+
+		// A job was counted but is on its way between queues or another thread is about to take it
+		if(m_numQueued.load() > 0){
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Sleep until something is queued
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+		m_numSleeping++;
+		m_wakeSignal.wait(lock, [this]{ return m_quit || m_numQueued.load() > 0; });
+		m_numSleeping--;
+
+		if(m_quit) return;
+	}
+}
+
+JobSystem::Job *JobSystem::allocateJob(){
+	if(t_system != this){
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		return static_cast<Job *>(m_jobPool.allocate());
+	}
+
+	JobCache &cache = *m_jobCaches[t_index];
+
+	// Refill a whole batch at once so the lock is only taken every JobBatchSize jobs
+	if(!cache.jobs){
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+
+		for(uint32_t i = 0; i < JobBatchSize; i++){
+			Job *job = static_cast<Job *>(m_jobPool.allocate());
+
+			if(!job) break;
+
+			job->next = cache.jobs;
+			cache.jobs = job;
+			cache.numJobs++;
+		}
+	}
+
+	Job *job = cache.jobs;
+
+	if(job){
+		cache.jobs = job->next;
+		cache.numJobs--;
+	}
+
+	return job;
+}
+
+void JobSystem::freeJob(Job *job){
+	if(t_system != this){
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		m_jobPool.free(job);
+
+		return;
+	}
+
+	JobCache &cache = *m_jobCaches[t_index];
+
+	job->next = cache.jobs;
+	cache.jobs = job;
+	cache.numJobs++;
+
+	// Jobs are freed by whoever ran them, hand a batch back once a thread holds more than it needs
+	if(cache.numJobs >= 2 * JobBatchSize){
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+
+		for(uint32_t i = 0; i < JobBatchSize; i++){
+			Job *returned = cache.jobs;
+
+			cache.jobs = returned->next;
+			m_jobPool.free(returned);
+		}
+
+		cache.numJobs -= JobBatchSize;
+	}
+}
+
+void JobSystem::submit(Job *job, Counter *dependency){
+	if(dependency){
+		std::lock_guard<std::mutex> lock(dependency->m_mutex);
+
+		// Checked under the lock, finish() takes the same lock after the counter hits zero
+		if(dependency->m_value.load() > 0){
+			dependency->m_dependents.push_back(job);
+			return;
+		}
+	}
+
+	push(job);
+}
+
+void JobSystem::push(Job *job){
+	if(t_system == this){
+		m_deques[t_index]->push(job);
+	}
+	else{
+		pushInbox(job, job);
+	}
+
+	// Sleepers check m_numQueued under the lock, so either they see this job or they get the notify
+	m_numQueued++;
+
+	if(m_numSleeping.load() > 0){
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wakeSignal.notify_one();
+	}
+}
+
+void JobSystem::pushInbox(Job *first, Job *last){
+	Job *head = m_inbox.load(std::memory_order_relaxed);
+
+	// Only pushes compare against the head, draining swaps the whole list out, so there's no ABA to worry about
+	do{
+		last->next = head;
+	} while(!m_inbox.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+JobSystem::Job *JobSystem::takeInbox(){
+	if(t_system != this || !m_inbox.load(std::memory_order_relaxed)) return nullptr;
+
+	Job *jobs = m_inbox.exchange(nullptr, std::memory_order_acquire);
+
+	if(!jobs) return nullptr;
+
+	// Newest first in the stack, reverse it so the oldest job runs first
+	Job *oldest = nullptr;
+
+	while(jobs){
+		Job *next = jobs->next;
+
+		jobs->next = oldest;
+		oldest = jobs;
+		jobs = next;
+	}
+
+	// The rest go to this thread's deque where others can steal them
+	Job *job = oldest;
+	Job *rest = oldest->next;
+
+	while(rest){
+
+		// Read the link first, the job can be stolen and freed as soon as it's pushed
+		Job *next = rest->next;
+
+		m_deques[t_index]->push(rest);
+		rest = next;
+	}
+
+	return job;
+}
+
+JobSystem::Job *JobSystem::take(){
+	Job *job = nullptr;
+	uint32_t numDeques = static_cast<uint32_t>(m_deques.size());
+	bool owner = t_system == this;
+
+	// Own deque first, newest job first for cache locality
+	if(owner) job = m_deques[t_index]->pop();
+
+	// Then steal the oldest job from someone else, starting at a random victim
+	if(!job){
+		uint32_t start = NextRandom() % numDeques;
+
+		for(uint32_t i = 0; i < numDeques && !job; i++){
+			uint32_t victim = (start + i) % numDeques;
+
+			if(!owner || victim != t_index) job = m_deques[victim]->steal();
+		}
+	}
+
+	if(!job) job = takeInbox();
+
+	if(job) m_numQueued--;
+
+	return job;
+}
+
+void JobSystem::execute(Job *job){
+	Counter *counter = job->counter;
+
+	job->invoke(job);
+	freeJob(job);
+
+	finish(counter);
+}
+
+void JobSystem::finish(Counter *counter){
+	if(!counter) return;
+
+	// Not the last job, the counter can't reach zero here
+	int32_t value = counter->m_value.load();
+
+	while(value > 1){
+		if(counter->m_value.compare_exchange_weak(value, value - 1)) return;
+	}
+
+	// The last decrement happens under the lock, wait() takes it once before returning so the
+	// counter is never destroyed while it's still in use here
+	std::vector<Job *> dependents;
+
+	{
+		std::lock_guard<std::mutex> lock(counter->m_mutex);
+
+		if(counter->m_value.fetch_sub(1) == 1) dependents.swap(counter->m_dependents);
+	}
+
+	for(Job *job : dependents){
+		push(job);
+	}
+}
+
+void JobSystem::wait(Counter &counter){
+	PROFILE_ZONE("JobSystem::wait");
+
+	bool mainThread = isMainThread();
+
+	while(!counter.isDone()){
+		if(mainThread && runMainThreadJobs() > 0) continue;
+
+		Job *job = take();
+
+		if(job) execute(job);
+		else std::this_thread::yield();
+	}
+
+	// Let the job that finished the counter step out of it
+	std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void JobSystem::splitRange(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t begin, size_t end)> &func,
+	Counter *counter){
+
+	// Hand the upper half off and keep splitting the lower one, thieves then take the biggest pieces first
+	while(end - begin > grainSize){
+		size_t middle = begin + (end - begin) / 2;
+
+		run([this, middle, end, grainSize, &func, counter]{ splitRange(middle, end, grainSize, func, counter); }, counter);
+
+		end = middle;
+	}
+
+	func(begin, end);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)> &func){
+	if(count == 0) return;
+
+	Counter counter;
+
+	splitRange(0, count, std::max<size_t>(1, grainSize), func, &counter);
+	wait(counter);
+}
+
+uint32_t JobSystem::runMainThreadJobs(){
+	uint32_t numRun = 0;
+
+	while(true){
+		Job *job = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mainMutex);
+
+			if(m_mainJobs.empty()) break;
+
+			job = m_mainJobs.front();
+			m_mainJobs.pop_front();
+		}
+
+		execute(job);
+		numRun++;
+	}
+
+	return numRun;
+}
+
+bool JobSystem::isMainThread() const{
+	return t_system == this && t_index == 0;
+}
+
+uint32_t JobSystem::getNumWorkers() const{
+	return static_cast<uint32_t>(m_workers.size());
+}
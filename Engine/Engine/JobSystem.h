@@ -0,0 +1,204 @@
+#pragma once
+
+//////////////////////
+// Job system class //
+//////////////////////
+
+class JobSystem{
+public:
+	typedef std::function<void()> JobFunc;
+
+	struct Job;
+
+	// Number of unfinished jobs, jobs can also be held back until one of these reaches zero
+	class Counter{
+	private:
+		friend class JobSystem;
+
+		std::atomic<int32_t> m_value;
+
+		// Jobs waiting for this counter to reach zero
+		std::mutex m_mutex;
+		std::vector<Job *> m_dependents;
+
+		Counter(const Counter &) = delete;
+		Counter &operator=(const Counter &) = delete;
+
+	public:
+		Counter();
+
+		// Only for polling, a counter must be passed to wait() before it is destroyed
+		bool isDone() const;
+	};
+
+	// Callables up to this size are stored in the job itself, bigger ones go on the heap
+	static const size_t JobStorageSize	= 96;
+
+	struct Job{
+
+		// Calls the stored callable and destroys it
+		void (*invoke)(Job *job);
+
+		Counter *counter;
+		Job *next;
+
+		std::aligned_storage<JobStorageSize, 16>::type storage;
+	};
+
+private:
+
+	// Jobs move between a thread's cache and the shared pool this many at a time
+	static const uint32_t JobBatchSize	= 64;
+
+	// Chase-Lev work-stealing deque, the owning thread pushes and pops at the bottom while
+	// every other thread steals from the top
+	class WorkDeque{
+	private:
+		struct Ring{
+			int64_t capacity;
+			std::unique_ptr<std::atomic<Job *>[]> items;
+
+			Ring(int64_t size);
+		};
+
+		std::atomic<int64_t> m_top;
+		char m_padding[64];
+		std::atomic<int64_t> m_bottom;
+		std::atomic<Ring *> m_ring;
+
+		// Outgrown rings stay alive since a thief may still be reading from one
+		std::vector<std::unique_ptr<Ring>> m_rings;
+
+	public:
+		WorkDeque();
+
+		void push(Job *job);
+		Job *pop();
+		Job *steal();
+	};
+
+	// Free jobs owned by one thread, only the shared pool needs the lock
+	struct JobCache{
+		Job *jobs;
+		uint32_t numJobs;
+		char padding[64];
+	};
+
+	// Deque 0 belongs to the thread that created the system, the rest to the workers. Each has a job cache
+	std::vector<std::unique_ptr<WorkDeque>> m_deques;
+	std::vector<std::unique_ptr<JobCache>> m_jobCaches;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_poolMutex;
+	PoolAllocator m_jobPool;
+
+	// Jobs queued from threads that don't own a deque, a lock-free stack that the thread draining it takes whole
+	std::atomic<Job *> m_inbox;
+
+	// Jobs that have to run on the main thread, e.g. anything using the immediate context
+	std::mutex m_mainMutex;
+	std::deque<Job *> m_mainJobs;
+
+	// Idle workers sleep until something gets queued
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeSignal;
+	std::atomic<int32_t> m_numQueued, m_numSleeping;
+	std::atomic<bool> m_quit;
+
+	void workerMain(uint32_t index);
+
+	Job *allocateJob();
+	void freeJob(Job *job);
+
+	// Job::invoke for callables stored in the job and on the heap
+	template<typename Func>
+	static void invokeInline(Job *job){
+		Func *func = reinterpret_cast<Func *>(&job->storage);
+
+		(*func)();
+		func->~Func();
+	}
+
+	template<typename Func>
+	static void invokeHeap(Job *job){
+		Func *func = *reinterpret_cast<Func **>(&job->storage);
+
+		(*func)();
+		delete func;
+	}
+
+	// Stores func in the job when it fits, otherwise on the heap
+	template<typename Func, typename Arg>
+	static void store(Job *job, Arg &&func, std::true_type){
+		new(&job->storage) Func(std::forward<Arg>(func));
+		job->invoke = &invokeInline<Func>;
+	}
+
+	template<typename Func, typename Arg>
+	static void store(Job *job, Arg &&func, std::false_type){
+		*reinterpret_cast<Func **>(&job->storage) = new Func(std::forward<Arg>(func));
+		job->invoke = &invokeHeap<Func>;
+	}
+
+	template<typename Arg>
+	Job *createJob(Arg &&func, Counter *counter){
+		typedef typename std::decay<Arg>::type Func;
+		typedef std::integral_constant<bool, sizeof(Func) <= JobStorageSize && std::alignment_of<Func>::value <= 16> FitsInline;
+
+		Job *job = allocateJob();
+
+		store<Func>(job, std::forward<Arg>(func), FitsInline());
+
+		job->counter	= counter;
+		job->next		= nullptr;
+
+		if(counter) counter->m_value++;
+
+		return job;
+	}
+
+	void submit(Job *job, Counter *dependency);
+	void push(Job *job);
+	void pushInbox(Job *first, Job *last);
+	Job *takeInbox();
+	Job *take();
+	void execute(Job *job);
+	void finish(Counter *counter);
+
+	void splitRange(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t begin, size_t end)> &func, Counter *counter);
+
+public:
+
+	// 0 workers uses one per core besides the calling thread (but at least one), the calling thread becomes the main thread
+	JobSystem(uint32_t numWorkers = 0);
+
+	// Every job must have been waited on before this
+	~JobSystem();
+
+	// Queues a job, counter (if any) is raised now and lowered when the job is done. With dependency
+	// the job is held back until that counter reaches zero
+	template<typename Func>
+	void run(Func &&func, Counter *counter = nullptr, Counter *dependency = nullptr){
+		submit(createJob(std::forward<Func>(func), counter), dependency);
+	}
+
+	// Runs other jobs until counter reaches zero, the main thread also runs its own queue meanwhile
+	void wait(Counter &counter);
+
+	// Splits [0, count) down to ranges of at most grainSize and waits for all of them, the calling thread takes part
+	void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)> &func);
+
+	// Queues a job for the main thread, it runs during runMainThreadJobs() or a wait() on the main thread
+	template<typename Func>
+	void runOnMainThread(Func &&func, Counter *counter = nullptr){
+		Job *job = createJob(std::forward<Func>(func), counter);
+
+		std::lock_guard<std::mutex> lock(m_mainMutex);
+		m_mainJobs.push_back(job);
+	}
+
+	uint32_t runMainThreadJobs();
+
+	bool isMainThread() const;
+	uint32_t getNumWorkers() const;
+};
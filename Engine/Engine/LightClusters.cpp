@@ -0,0 +1,573 @@
+#include "Engine.h"
+
+namespace{
+
+// Lights per transform job, slices are assigned one per job
+const size_t TransformGrainSize = 1024;
+
+// Slice whose near depth is the last one at or in front of z, clamped to the grid
+uint32_t FindSlice(const float *sliceDepth, uint32_t numSlices, float z){
+	uint32_t slice = static_cast<uint32_t>(std::upper_bound(sliceDepth, sliceDepth + numSlices + 1, z) - sliceDepth);
+
+	return std::min(slice > 0 ? slice - 1 : 0, numSlices - 1);
+}
+
+// Distance from position to [min, max] along one axis for four boxes, squared
+__m128 AxisDistanceSq(const float *min, const float *max, __m128 position){
+	__m128 distance = _mm_max_ps(_mm_setzero_ps(), _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(min), position), _mm_sub_ps(position, _mm_loadu_ps(max))));
+
+	return _mm_mul_ps(distance, distance);
+}
+
+}
+
+LightClusterer::LightClusterer(JobSystem *jobs, uint32_t indexCapacity) : m_jobs(jobs), m_indexCapacity(indexCapacity){
+	memset(m_sliceDepth, 0, sizeof(m_sliceDepth));
+	memset(m_columnMin, 0, sizeof(m_columnMin));
+	memset(m_columnMax, 0, sizeof(m_columnMax));
+	memset(m_rowMin, 0, sizeof(m_rowMin));
+	memset(m_rowMax, 0, sizeof(m_rowMax));
+
+	m_sliceScale	= 0;
+	m_sliceBias		= 0;
+
+	m_slices.resize(NumSlices);
+	m_pointCounts.resize(NumClusters);
+	m_spotCounts.resize(NumClusters);
+	m_clusters.resize(NumClusters);
+	m_indices.resize(indexCapacity);
+
+	memset(&m_stats, 0, sizeof(LightClusterStats));
+}
+
+void LightClusterer::setGrid(const LightBinView &view){
+	float ratio = view.farPlane / view.nearPlane;
+
+	for(uint32_t i = 0; i < NumSlices; i++){
+		m_sliceDepth[i] = view.nearPlane * powf(ratio, static_cast<float>(i) / NumSlices);
+	}
+
+	m_sliceDepth[NumSlices] = view.farPlane;
+
+	m_sliceScale	= NumSlices / logf(ratio);
+	m_sliceBias		= -logf(view.nearPlane) * m_sliceScale;
+
+	// Slopes of the tile edges through the eye, rows run down the screen
+	float columnSlopes[NumColumns + 1], rowSlopes[NumRows + 1];
+
+	for(uint32_t i = 0; i <= NumColumns; i++){
+		columnSlopes[i] = (2.0f * i / NumColumns - 1.0f) / view.projScaleX;
+	}
+
+	for(uint32_t i = 0; i <= NumRows; i++){
+		rowSlopes[i] = (1.0f - 2.0f * i / NumRows) / view.projScaleY;
+	}
+
+	// A froxel's box spans its edges at both its near and its far depth
+	for(uint32_t slice = 0; slice < NumSlices; slice++){
+		float nearZ = m_sliceDepth[slice], farZ = m_sliceDepth[slice + 1];
+
+		for(uint32_t i = 0; i < NumColumns; i++){
+			m_columnMin[slice * NumColumns + i] = std::min(columnSlopes[i] * nearZ, columnSlopes[i] * farZ);
+			m_columnMax[slice * NumColumns + i] = std::max(columnSlopes[i + 1] * nearZ, columnSlopes[i + 1] * farZ);
+		}
+
+		for(uint32_t i = 0; i < NumRows; i++){
+			m_rowMin[slice * NumRows + i] = std::min(rowSlopes[i + 1] * nearZ, rowSlopes[i + 1] * farZ);
+			m_rowMax[slice * NumRows + i] = std::max(rowSlopes[i] * nearZ, rowSlopes[i] * farZ);
+		}
+	}
+}
+
+void LightClusterer::transformLights(const LightBinView &view, const void *lights, size_t stride, uint32_t begin, uint32_t end, bool spot,
+	ViewLight *viewLights) const{
+
+	const DirectX::XMFLOAT4X4 &m = view.view;
+	const uint8_t *bytes = static_cast<const uint8_t *>(lights);
+
+	// The frustum's sides as x = +-slopeX * z and y = +-slopeY * z, with what normalizes the distances to them
+	float slopeX = 1.0f / view.projScaleX, slopeY = 1.0f / view.projScaleY;
+	__m128 sideSlopeX	= _mm_set1_ps(slopeX);
+	__m128 sideSlopeY	= _mm_set1_ps(slopeY);
+	__m128 sideScaleX	= _mm_set1_ps(1.0f / sqrtf(1.0f + slopeX * slopeX));
+	__m128 sideScaleY	= _mm_set1_ps(1.0f / sqrtf(1.0f + slopeY * slopeY));
+
+	for(uint32_t i = begin; i < end; i += 4){
+		uint32_t numInGroup = std::min(end - i, 4u);
+
+		// Position and radius, then direction and the cosine for spot lights. A missing light has a negative radius
+		float sphere[4][4], cone[4][4], sinAngle[4];
+
+		for(uint32_t j = 0; j < 4; j++){
+			if(j < numInGroup){
+				const uint8_t *light = bytes + (i + j) * stride;
+
+				memcpy(sphere[j], light, sizeof(sphere[j]));
+
+				if(spot){
+					const SpotLight *spotLight = reinterpret_cast<const SpotLight *>(light);
+
+					memcpy(cone[j], &spotLight->direction, sizeof(cone[j]));
+					sinAngle[j] = spotLight->sinAngle;
+				}
+			}
+			else{
+				memset(sphere[j], 0, sizeof(sphere[j]));
+				memset(cone[j], 0, sizeof(cone[j]));
+				sphere[j][3] = -1.0f;
+				sinAngle[j] = 0.0f;
+			}
+		}
+
+		__m128 x = _mm_loadu_ps(sphere[0]);
+		__m128 y = _mm_loadu_ps(sphere[1]);
+		__m128 z = _mm_loadu_ps(sphere[2]);
+		__m128 r = _mm_loadu_ps(sphere[3]);
+
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+
+		__m128 viewX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._11)), _mm_mul_ps(y, _mm_set1_ps(m._21))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m._31)), _mm_set1_ps(m._41)));
+		__m128 viewY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._12)), _mm_mul_ps(y, _mm_set1_ps(m._22))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m._32)), _mm_set1_ps(m._42)));
+		__m128 viewZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._13)), _mm_mul_ps(y, _mm_set1_ps(m._23))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m._33)), _mm_set1_ps(m._43)));
+
+		// Distances to the sides, positive inside
+		__m128 outside	= _mm_sub_ps(_mm_setzero_ps(), r);
+		__m128 left		= _mm_mul_ps(_mm_add_ps(viewX, _mm_mul_ps(sideSlopeX, viewZ)), sideScaleX);
+		__m128 right	= _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sideSlopeX, viewZ), viewX), sideScaleX);
+		__m128 bottom	= _mm_mul_ps(_mm_add_ps(viewY, _mm_mul_ps(sideSlopeY, viewZ)), sideScaleY);
+		__m128 top		= _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sideSlopeY, viewZ), viewY), sideScaleY);
+
+		int inside = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(left, outside), _mm_cmpge_ps(right, outside)),
+			_mm_and_ps(_mm_cmpge_ps(bottom, outside), _mm_cmpge_ps(top, outside))));
+
+		float centers[3][4], radius[4], directions[3][4], cosAngle[4];
+
+		_mm_storeu_ps(centers[0], viewX);
+		_mm_storeu_ps(centers[1], viewY);
+		_mm_storeu_ps(centers[2], viewZ);
+		_mm_storeu_ps(radius, r);
+
+		// Directions only rotate
+		if(spot){
+			__m128 dx = _mm_loadu_ps(cone[0]);
+			__m128 dy = _mm_loadu_ps(cone[1]);
+			__m128 dz = _mm_loadu_ps(cone[2]);
+			__m128 c = _mm_loadu_ps(cone[3]);
+
+			_MM_TRANSPOSE4_PS(dx, dy, dz, c);
+
+			_mm_storeu_ps(directions[0], _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(m._11)), _mm_mul_ps(dy, _mm_set1_ps(m._21))),
+				_mm_mul_ps(dz, _mm_set1_ps(m._31))));
+			_mm_storeu_ps(directions[1], _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(m._12)), _mm_mul_ps(dy, _mm_set1_ps(m._22))),
+				_mm_mul_ps(dz, _mm_set1_ps(m._32))));
+			_mm_storeu_ps(directions[2], _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(m._13)), _mm_mul_ps(dy, _mm_set1_ps(m._23))),
+				_mm_mul_ps(dz, _mm_set1_ps(m._33))));
+			_mm_storeu_ps(cosAngle, c);
+		}
+
+		for(uint32_t j = 0; j < numInGroup; j++){
+			ViewLight &light = viewLights[i + j];
+
+			light.x			= centers[0][j];
+			light.y			= centers[1][j];
+			light.z			= centers[2][j];
+			light.radius	= radius[j];
+			light.dirX		= spot ? directions[0][j] : 0.0f;
+			light.dirY		= spot ? directions[1][j] : 0.0f;
+			light.dirZ		= spot ? directions[2][j] : 0.0f;
+			light.cosAngle	= spot ? cosAngle[j] : 0.0f;
+			light.sinAngle	= spot ? sinAngle[j] : 0.0f;
+
+			float minZ = light.z - light.radius, maxZ = light.z + light.radius;
+
+			if(!(inside & (1 << j)) || maxZ < m_sliceDepth[0] || minZ > m_sliceDepth[NumSlices]){
+				light.firstSlice	= 1;
+				light.lastSlice		= 0;
+				continue;
+			}
+
+			// A slice more on either side in case rounding put the sphere's ends in the wrong one, the box test has the last word
+			light.firstSlice	= FindSlice(m_sliceDepth, NumSlices, minZ);
+			light.lastSlice		= FindSlice(m_sliceDepth, NumSlices, maxZ);
+			light.firstSlice	= light.firstSlice > 0 ? light.firstSlice - 1 : 0;
+			light.lastSlice		= std::min(light.lastSlice + 1, NumSlices - 1);
+		}
+	}
+}
+
+void LightClusterer::findSpans(uint32_t slice, const ViewLight &light, uint32_t index, bool spot, std::vector<ClusterSpan> &spans) const{
+	const float *columnMin = &m_columnMin[slice * NumColumns], *columnMax = &m_columnMax[slice * NumColumns];
+	const float *rowMin = &m_rowMin[slice * NumRows], *rowMax = &m_rowMax[slice * NumRows];
+	float nearZ = m_sliceDepth[slice], farZ = m_sliceDepth[slice + 1];
+
+	float dz = std::max(0.0f, std::max(nearZ - light.z, light.z - farZ));
+	__m128 radiusSq = _mm_set1_ps(light.radius * light.radius);
+	__m128 dzSq = _mm_set1_ps(dz * dz);
+
+	// Rows the sphere reaches at all, with their part of the distance to the boxes
+	float rowDistanceSq[NumRows];
+	int rows = 0;
+
+	for(uint32_t i = 0; i < NumRows; i += 4){
+		__m128 distanceSq = _mm_add_ps(AxisDistanceSq(rowMin + i, rowMax + i, _mm_set1_ps(light.y)), dzSq);
+
+		_mm_storeu_ps(rowDistanceSq + i, distanceSq);
+		rows |= _mm_movemask_ps(_mm_cmple_ps(distanceSq, radiusSq)) << i;
+	}
+
+	if(rows == 0) return;
+
+	__m128 columnDistanceSq[NumColumns / 4];
+
+	for(uint32_t i = 0; i < NumColumns; i += 4){
+		columnDistanceSq[i / 4] = AxisDistanceSq(columnMin + i, columnMax + i, _mm_set1_ps(light.x));
+	}
+
+	// Cone against the spheres around the boxes, the sphere is centered on the box and reaches its corners
+	float halfZ = 0.5f * (farZ - nearZ);
+	float vz = 0.5f * (nearZ + farZ) - light.z;
+
+	for(uint32_t row = 0; row < NumRows; row++){
+		if(!(rows & (1 << row))) continue;
+
+		__m128 distanceSq = _mm_set1_ps(rowDistanceSq[row]);
+		int columns = 0;
+
+		for(uint32_t i = 0; i < NumColumns; i += 4){
+			columns |= _mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(columnDistanceSq[i / 4], distanceSq), radiusSq)) << i;
+		}
+
+		if(spot && columns){
+			float halfY = 0.5f * (rowMax[row] - rowMin[row]);
+			float vy = 0.5f * (rowMin[row] + rowMax[row]) - light.y;
+
+			__m128 half = _mm_set1_ps(0.5f);
+			__m128 extentYZ = _mm_set1_ps(halfY * halfY + halfZ * halfZ);
+			__m128 lengthYZ = _mm_set1_ps(vy * vy + vz * vz);
+			__m128 alongYZ = _mm_set1_ps(vy * light.dirY + vz * light.dirZ);
+			__m128 positionX = _mm_set1_ps(light.x);
+			__m128 directionX = _mm_set1_ps(light.dirX);
+			__m128 cosAngle = _mm_set1_ps(light.cosAngle);
+			__m128 sinAngle = _mm_set1_ps(light.sinAngle);
+			__m128 range = _mm_set1_ps(light.radius);
+			int inCone = 0;
+
+			for(uint32_t i = 0; i < NumColumns; i += 4){
+				if(!(columns & (0xF << i))) continue;
+
+				__m128 minX = _mm_loadu_ps(columnMin + i), maxX = _mm_loadu_ps(columnMax + i);
+				__m128 halfX = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+				__m128 vx = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(minX, maxX), half), positionX);
+
+				__m128 sphereRadius = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(halfX, halfX), extentYZ));
+				__m128 lengthSq = _mm_add_ps(_mm_mul_ps(vx, vx), lengthYZ);
+				__m128 along = _mm_add_ps(_mm_mul_ps(vx, directionX), alongYZ);
+
+				// Distance from the sphere's center to the cone's side, past the apex it is the distance to the apex
+				__m128 across = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSq, _mm_mul_ps(along, along)), _mm_setzero_ps()));
+				__m128 closest = _mm_sub_ps(_mm_mul_ps(cosAngle, across), _mm_mul_ps(along, sinAngle));
+
+				__m128 hit = _mm_and_ps(_mm_cmple_ps(closest, sphereRadius),
+					_mm_and_ps(_mm_cmple_ps(along, _mm_add_ps(sphereRadius, range)), _mm_cmpge_ps(along, _mm_sub_ps(_mm_setzero_ps(), sphereRadius))));
+
+				inCone |= _mm_movemask_ps(hit) << i;
+			}
+
+			columns &= inCone;
+		}
+
+		if(columns == 0) continue;
+
+		ClusterSpan span = {index, static_cast<uint16_t>(row), static_cast<uint16_t>(columns)};
+		spans.push_back(span);
+	}
+}
+
+void LightClusterer::assignSlice(uint32_t slice){
+	SliceLights &lights = m_slices[slice];
+
+	lights.pointSpans.clear();
+	lights.spotSpans.clear();
+
+	for(uint32_t i : lights.points){
+		findSpans(slice, m_points[i], i, false, lights.pointSpans);
+	}
+
+	for(uint32_t i : lights.spots){
+		findSpans(slice, m_spots[i], i, true, lights.spotSpans);
+	}
+
+	// Only this slice's clusters are counted here, the jobs never share one. Adding the bits is cheaper than
+	// branching on them
+	for(const auto &span : lights.pointSpans){
+		uint32_t *counts = &m_pointCounts[GetClusterIndex(0, span.row, slice)];
+
+		for(uint32_t column = 0; column < NumColumns; column++) counts[column] += (span.columns >> column) & 1;
+	}
+
+	for(const auto &span : lights.spotSpans){
+		uint32_t *counts = &m_spotCounts[GetClusterIndex(0, span.row, slice)];
+
+		for(uint32_t column = 0; column < NumColumns; column++) counts[column] += (span.columns >> column) & 1;
+	}
+}
+
+void LightClusterer::fillSlice(uint32_t slice){
+	const SliceLights &lights = m_slices[slice];
+
+	// The counts start over as cursors into each cluster's list
+	for(const auto &span : lights.pointSpans){
+		for(uint32_t column = 0; column < NumColumns; column++){
+			if(!(span.columns & (1 << column))) continue;
+
+			uint32_t cluster = GetClusterIndex(column, span.row, slice);
+			uint32_t &cursor = m_pointCounts[cluster];
+
+			if(cursor < m_clusters[cluster].numPointLights) m_indices[m_clusters[cluster].offset + cursor++] = span.light;
+		}
+	}
+
+	for(const auto &span : lights.spotSpans){
+		for(uint32_t column = 0; column < NumColumns; column++){
+			if(!(span.columns & (1 << column))) continue;
+
+			uint32_t cluster = GetClusterIndex(column, span.row, slice);
+			uint32_t &cursor = m_spotCounts[cluster];
+
+			if(cursor < m_clusters[cluster].numSpotLights){
+				m_indices[m_clusters[cluster].offset + m_clusters[cluster].numPointLights + cursor++] = span.light;
+			}
+		}
+	}
+}
+
+void LightClusterer::forEach(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)> &func) const{
+	if(m_jobs) m_jobs->parallelFor(count, grainSize, func);
+	else if(count > 0) func(0, count);
+}
+
+void LightClusterer::assign(const LightBinView &view, const PointLight *pointLights, uint32_t numPointLights, const SpotLight *spotLights,
+	uint32_t numSpotLights){
+
+	memset(&m_stats, 0, sizeof(LightClusterStats));
+	m_stats.numPointLights	= numPointLights;
+	m_stats.numSpotLights	= numSpotLights;
+
+	setGrid(view);
+
+	m_points.resize(numPointLights);
+	m_spots.resize(numSpotLights);
+
+	forEach(numPointLights, TransformGrainSize, [this, &view, pointLights](size_t begin, size_t end){
+		transformLights(view, pointLights, sizeof(PointLight), static_cast<uint32_t>(begin), static_cast<uint32_t>(end), false, &m_points[0]);
+	});
+
+	forEach(numSpotLights, TransformGrainSize, [this, &view, spotLights](size_t begin, size_t end){
+		transformLights(view, spotLights, sizeof(SpotLight), static_cast<uint32_t>(begin), static_cast<uint32_t>(end), true, &m_spots[0]);
+	});
+
+	// Each slice gets the lights that may reach it, in light order
+	for(auto &lights : m_slices){
+		lights.points.clear();
+		lights.spots.clear();
+	}
+
+	for(uint32_t i = 0; i < numPointLights; i++){
+		for(uint32_t slice = m_points[i].firstSlice; slice <= m_points[i].lastSlice; slice++) m_slices[slice].points.push_back(i);
+	}
+
+	for(uint32_t i = 0; i < numSpotLights; i++){
+		for(uint32_t slice = m_spots[i].firstSlice; slice <= m_spots[i].lastSlice; slice++) m_slices[slice].spots.push_back(i);
+	}
+
+	std::fill(m_pointCounts.begin(), m_pointCounts.end(), 0);
+	std::fill(m_spotCounts.begin(), m_spotCounts.end(), 0);
+
+	forEach(NumSlices, 1, [this](size_t begin, size_t end){
+		for(size_t slice = begin; slice < end; slice++) assignSlice(static_cast<uint32_t>(slice));
+	});
+
+	// Lay the lists out back to back, a full cluster or index list keeps the lights that come first
+	uint32_t offset = 0;
+
+	for(uint32_t i = 0; i < NumClusters; i++){
+		uint32_t numPoints	= std::min(m_pointCounts[i], static_cast<uint32_t>(MaxLightsPerCluster));
+		uint32_t numSpots	= std::min(m_spotCounts[i], static_cast<uint32_t>(MaxLightsPerCluster));
+		uint32_t numLights	= m_pointCounts[i] + m_spotCounts[i];
+
+		numPoints	= std::min(numPoints, m_indexCapacity - offset);
+		numSpots	= std::min(numSpots, m_indexCapacity - offset - numPoints);
+
+		m_stats.maxClusterLights	= std::max(m_stats.maxClusterLights, numLights);
+		m_stats.numDropped			+= numLights - numPoints - numSpots;
+
+		if(numLights > 0) m_stats.numOccupied++;
+
+		m_clusters[i].offset			= offset;
+		m_clusters[i].numPointLights	= static_cast<uint16_t>(numPoints);
+		m_clusters[i].numSpotLights		= static_cast<uint16_t>(numSpots);
+
+		m_pointCounts[i] = m_spotCounts[i] = 0;
+
+		offset += numPoints + numSpots;
+	}
+
+	m_stats.numIndices = offset;
+
+	forEach(NumSlices, 1, [this](size_t begin, size_t end){
+		for(size_t slice = begin; slice < end; slice++) fillSlice(static_cast<uint32_t>(slice));
+	});
+}
+
+uint32_t LightClusterer::GetClusterIndex(uint32_t column, uint32_t row, uint32_t slice){
+	return (slice * NumRows + row) * NumColumns + column;
+}
+
+void LightClusterer::getClusterBounds(uint32_t cluster, DirectX::XMFLOAT3 &min, DirectX::XMFLOAT3 &max) const{
+	uint32_t column	= cluster % NumColumns;
+	uint32_t row	= cluster / NumColumns % NumRows;
+	uint32_t slice	= cluster / (NumColumns * NumRows);
+
+	min = DirectX::XMFLOAT3(m_columnMin[slice * NumColumns + column], m_rowMin[slice * NumRows + row], m_sliceDepth[slice]);
+	max = DirectX::XMFLOAT3(m_columnMax[slice * NumColumns + column], m_rowMax[slice * NumRows + row], m_sliceDepth[slice + 1]);
+}
+
+DirectX::XMFLOAT2 LightClusterer::getSliceParams() const{
+	return DirectX::XMFLOAT2(m_sliceScale, m_sliceBias);
+}
+
+const LightCluster *LightClusterer::getClusters() const{
+	return &m_clusters[0];
+}
+
+const uint32_t *LightClusterer::getIndices() const{
+	return m_indices.empty() ? nullptr : &m_indices[0];
+}
+
+uint32_t LightClusterer::getNumIndices() const{
+	return m_stats.numIndices;
+}
+
+const LightClusterStats &LightClusterer::getStats() const{
+	return m_stats;
+}
+
+std::string LightClusterer::formatStats() const{
+	char text[256];
+
+	sprintf_s(text, "Light clusters: %u point and %u spot lights, %u indices in %u of %u clusters, %u most in a cluster, %u dropped\n",
+		m_stats.numPointLights, m_stats.numSpotLights, m_stats.numIndices, m_stats.numOccupied, NumClusters, m_stats.maxClusterLights,
+		m_stats.numDropped);
+
+	return text;
+}
+
+LightClusterLists::LightClusterLists(ID3D11Device *device, uint32_t maxSpotLights, uint32_t indexCapacity) :
+	m_maxSpotLights(maxSpotLights), m_indexCapacity(indexCapacity){
+
+	m_numSpotLights	= 0;
+
+	m_spotBuffer	= m_clusterBuffer = m_indexBuffer = nullptr;
+	m_spotView		= m_clusterView = m_indexView = nullptr;
+
+	GpuMemoryTag tag(L"Light lists");
+
+	// Clusters start out empty, a frame drawn before the first upload shades no lights from them
+	std::vector<LightCluster> empty(LightClusterer::NumClusters);
+
+	memset(&empty[0], 0, empty.size() * sizeof(LightCluster));
+
+	if(!createBuffer(device, maxSpotLights, sizeof(SpotLight), true, nullptr, &m_spotBuffer, &m_spotView)) return;
+	if(!createBuffer(device, LightClusterer::NumClusters, sizeof(LightCluster), false, &empty[0], &m_clusterBuffer, &m_clusterView)) return;
+
+	createBuffer(device, indexCapacity, sizeof(uint32_t), false, nullptr, &m_indexBuffer, &m_indexView);
+}
+
+LightClusterLists::~LightClusterLists(){
+	ReleaseCOM(m_spotView);
+	ReleaseCOM(m_clusterView);
+	ReleaseCOM(m_indexView);
+	ReleaseCOM(m_spotBuffer);
+	ReleaseCOM(m_clusterBuffer);
+	ReleaseCOM(m_indexBuffer);
+}
+
+bool LightClusterLists::createBuffer(ID3D11Device *device, uint32_t numElements, uint32_t stride, bool dynamic, const void *data, ID3D11Buffer **buffer,
+	ID3D11ShaderResourceView **view){
+
+	D3D11_BUFFER_DESC bufferDesc = {0};
+
+	bufferDesc.ByteWidth			= numElements * stride;
+	bufferDesc.Usage				= dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+	bufferDesc.BindFlags			= D3D11_BIND_SHADER_RESOURCE;
+	bufferDesc.CPUAccessFlags		= dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
+	bufferDesc.MiscFlags			= D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	bufferDesc.StructureByteStride	= stride;
+
+	D3D11_SUBRESOURCE_DATA initialData = {0};
+
+	initialData.pSysMem = data;
+
+	GpuAllocationId allocation = ReserveGpuMemory(GpuMemoryOther, bufferDesc.ByteWidth);
+
+	if(allocation == GpuMemoryTracker::InvalidAllocation){
+		*buffer = nullptr;
+		return false;
+	}
+
+	if(FAILED(device->CreateBuffer(&bufferDesc, data ? &initialData : NULL, buffer))){
+		*buffer = nullptr;
+		BindGpuMemory(nullptr, allocation);
+		return false;
+	}
+
+	BindGpuMemory(*buffer, allocation);
+
+	if(FAILED(device->CreateShaderResourceView(*buffer, NULL, view))){
+		*view = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+bool LightClusterLists::isValid() const{
+	return m_spotView && m_clusterView && m_indexView;
+}
+
+void LightClusterLists::setSpotLights(ID3D11DeviceContext *context, const SpotLight *lights, uint32_t numLights){
+	if(!isValid()) return;
+
+	m_numSpotLights = std::min(numLights, m_maxSpotLights);
+
+	if(m_numSpotLights == 0) return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+
+	if(FAILED(context->Map(m_spotBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))){
+		m_numSpotLights = 0;
+		return;
+	}
+
+	memcpy(mapped.pData, lights, m_numSpotLights * sizeof(SpotLight));
+	context->Unmap(m_spotBuffer, 0);
+}
+
+void LightClusterLists::upload(UploadManager &uploads, const LightClusterer &clusterer){
+	if(!isValid()) return;
+
+	uint32_t numIndices = std::min(clusterer.getNumIndices(), m_indexCapacity);
+
+	uploads.upload(m_clusterBuffer, 0, clusterer.getClusters(), LightClusterer::NumClusters * sizeof(LightCluster));
+
+	if(numIndices > 0) uploads.upload(m_indexBuffer, 0, clusterer.getIndices(), numIndices * sizeof(uint32_t));
+}
+
+void LightClusterLists::bind(ID3D11DeviceContext *context, UINT slot){
+	ID3D11ShaderResourceView *views[] = {m_clusterView, m_indexView, m_spotView};
+
+	context->PSSetShaderResources(slot, 3, views);
+}
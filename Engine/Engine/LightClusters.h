@@ -0,0 +1,160 @@
+#pragma once
+
+///////////////////////////
+// Clustered light lists //
+///////////////////////////
+
+// Same layout as SpotLight in the shaders. The cone is lit out to radius from position, its half angle is
+// given by its cosine and sine and must stay under 90 degrees
+struct SpotLight{
+	DirectX::XMFLOAT3 position;
+	float radius;
+	DirectX::XMFLOAT3 direction;
+	float cosAngle;
+	DirectX::XMFLOAT3 color;
+	float sinAngle;
+};
+
+// Range of a cluster's lights in the index list, the point lights come first and the spot lights after them.
+// Same layout as Clusters in the shaders
+struct LightCluster{
+	uint32_t offset;
+	uint16_t numPointLights, numSpotLights;
+};
+
+struct LightClusterStats{
+	uint32_t numPointLights, numSpotLights;
+	uint32_t numIndices, numOccupied;
+	uint32_t maxClusterLights;
+
+	// Lights left out of a cluster because it or the index list was full
+	uint32_t numDropped;
+};
+
+// Assigns point and spot lights to a grid of froxels, screen tiles cut into slices whose depth grows
+// exponentially from the near plane to the far plane. Each slice is assigned on its own job, a light's bounding
+// sphere is tested against the boxes around the froxels and spot lights test their cone against the boxes'
+// bounding spheres as well. Clusters list their lights in light order
+class LightClusterer{
+public:
+	static const uint32_t NumColumns			= 16;
+	static const uint32_t NumRows				= 8;
+	static const uint32_t NumSlices				= 24;
+	static const uint32_t NumClusters			= NumColumns * NumRows * NumSlices;
+
+	// Of each kind of light
+	static const uint32_t MaxLightsPerCluster	= 256;
+
+private:
+
+	// View space light, culled when firstSlice is past lastSlice
+	struct ViewLight{
+		float x, y, z, radius;
+		float dirX, dirY, dirZ;
+		float cosAngle, sinAngle;
+		uint32_t firstSlice, lastSlice;
+	};
+
+	// Columns of one row of a slice that a light touches, a bit per column
+	struct ClusterSpan{
+		uint32_t light;
+		uint16_t row, columns;
+	};
+
+	// Lights whose slice range covers a slice and the spans they touch in it
+	struct SliceLights{
+		std::vector<uint32_t> points, spots;
+		std::vector<ClusterSpan> pointSpans, spotSpans;
+	};
+
+	JobSystem *m_jobs;
+	uint32_t m_indexCapacity;
+
+	// Froxel boxes in view space. Depth only depends on the slice, x on the slice and column and y on the
+	// slice and row, so the box tests split the same way
+	float m_sliceDepth[NumSlices + 1];
+	float m_sliceScale, m_sliceBias;
+	float m_columnMin[NumSlices * NumColumns], m_columnMax[NumSlices * NumColumns];
+	float m_rowMin[NumSlices * NumRows], m_rowMax[NumSlices * NumRows];
+
+	std::vector<ViewLight> m_points, m_spots;
+	std::vector<SliceLights> m_slices;
+
+	std::vector<uint32_t> m_pointCounts, m_spotCounts;
+	std::vector<LightCluster> m_clusters;
+	std::vector<uint32_t> m_indices;
+
+	LightClusterStats m_stats;
+
+	void setGrid(const LightBinView &view);
+
+	// Lights transformed into view space with the slices they may reach, four at a time. Lights outside the
+	// frustum's sides reach none
+	void transformLights(const LightBinView &view, const void *lights, size_t stride, uint32_t begin, uint32_t end, bool spot,
+		ViewLight *viewLights) const;
+
+	void findSpans(uint32_t slice, const ViewLight &light, uint32_t index, bool spot, std::vector<ClusterSpan> &spans) const;
+	void assignSlice(uint32_t slice);
+	void fillSlice(uint32_t slice);
+
+	// Runs on the job system when there is one
+	void forEach(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)> &func) const;
+
+	LightClusterer(const LightClusterer &) = delete;
+	LightClusterer &operator=(const LightClusterer &) = delete;
+
+public:
+	LightClusterer(JobSystem *jobs, uint32_t indexCapacity);
+
+	void assign(const LightBinView &view, const PointLight *pointLights, uint32_t numPointLights, const SpotLight *spotLights,
+		uint32_t numSpotLights);
+
+	// Slice by slice, row by row from the top left
+	static uint32_t GetClusterIndex(uint32_t column, uint32_t row, uint32_t slice);
+
+	// View space box of a cluster as of the last assign
+	void getClusterBounds(uint32_t cluster, DirectX::XMFLOAT3 &min, DirectX::XMFLOAT3 &max) const;
+
+	// Scale and bias that turn the log of a view space depth into its slice, (scale, bias)
+	DirectX::XMFLOAT2 getSliceParams() const;
+
+	const LightCluster *getClusters() const;
+	const uint32_t *getIndices() const;
+	uint32_t getNumIndices() const;
+
+	const LightClusterStats &getStats() const;
+	std::string formatStats() const;
+};
+
+// Owns the spot light list and the cluster lists the material shader reads, the lists come from a
+// LightClusterer through the upload manager
+class LightClusterLists{
+private:
+	uint32_t m_maxSpotLights, m_numSpotLights;
+	uint32_t m_indexCapacity;
+
+	ID3D11Buffer *m_spotBuffer, *m_clusterBuffer, *m_indexBuffer;
+	ID3D11ShaderResourceView *m_spotView, *m_clusterView, *m_indexView;
+
+	// Dynamic buffers are written by the CPU, the rest are copied into. Initial data is optional
+	bool createBuffer(ID3D11Device *device, uint32_t numElements, uint32_t stride, bool dynamic, const void *data, ID3D11Buffer **buffer,
+		ID3D11ShaderResourceView **view);
+
+	LightClusterLists(const LightClusterLists &) = delete;
+	LightClusterLists &operator=(const LightClusterLists &) = delete;
+
+public:
+	LightClusterLists(ID3D11Device *device, uint32_t maxSpotLights, uint32_t indexCapacity);
+	~LightClusterLists();
+
+	bool isValid() const;
+
+	// Spot lights past maxSpotLights are ignored
+	void setSpotLights(ID3D11DeviceContext *context, const SpotLight *lights, uint32_t numLights);
+
+	// The lists land with the upload manager's next submit
+	void upload(UploadManager &uploads, const LightClusterer &clusterer);
+
+	// Binds the clusters, the index list and the spot lights to three consecutive pixel shader slots
+	void bind(ID3D11DeviceContext *context, UINT slot);
+};
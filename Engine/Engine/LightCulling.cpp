@@ -0,0 +1,545 @@
+#include "Engine.h"
+
+namespace{
+
+// Bit per tile for the four tiles from first on, set when the sphere reaches past the tile's first edge and
+// isn't entirely beyond its second. Edge i is the distance a[i] * position + b[i] * depth
+int TestTiles(const float *a, const float *b, uint32_t first, __m128 position, __m128 depth, __m128 inside, __m128 outside){
+	__m128 begin	= _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + first), position), _mm_mul_ps(_mm_loadu_ps(b + first), depth));
+	__m128 end		= _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + first + 1), position), _mm_mul_ps(_mm_loadu_ps(b + first + 1), depth));
+
+	return _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(begin, inside), _mm_cmple_ps(end, outside)));
+}
+
+uint32_t LowestBit(int mask){
+	uint32_t bit = 0;
+
+	while(!(mask & (1 << bit))) bit++;
+
+	return bit;
+}
+
+uint32_t HighestBit(int mask){
+	uint32_t bit = 3;
+
+	while(!(mask & (1 << bit))) bit--;
+
+	return bit;
+}
+
+}
+
+LightBinView GetLightBinView(const Camera &camera){
+	LightBinView view;
+	DirectX::XMFLOAT4X4 proj;
+
+	// The camera hands out transposed matrices for the shaders
+	DirectX::XMStoreFloat4x4(&view.view, DirectX::XMMatrixTranspose(camera.getViewMatrix()));
+	DirectX::XMStoreFloat4x4(&proj, camera.getProjMatrix());
+
+	view.projScaleX	= proj._11;
+	view.projScaleY	= proj._22;
+	view.nearPlane	= camera.getNearPlane();
+	view.farPlane	= camera.getFarPlane();
+
+	return view;
+}
+
+LightBinner::LightBinner(uint32_t width, uint32_t height, uint32_t indexCapacity) : m_width(width), m_height(height), m_indexCapacity(indexCapacity){
+	m_tilesX = (width + TileSize - 1) / TileSize;
+	m_tilesY = (height + TileSize - 1) / TileSize;
+
+	// One edge more than tiles, and a group of four past that
+	m_columnA.assign(m_tilesX + 5, 0.0f);
+	m_columnB.assign(m_tilesX + 5, 0.0f);
+	m_rowA.assign(m_tilesY + 5, 0.0f);
+	m_rowB.assign(m_tilesY + 5, 0.0f);
+
+	m_tiles.resize(m_tilesX * m_tilesY);
+	m_cursors.resize(m_tilesX * m_tilesY);
+	m_counts.resize((m_tilesX + 1) * (m_tilesY + 1));
+	m_rowCounts.resize(m_tilesY + 1);
+	m_rowOffsets.resize(m_tilesY);
+	m_indices.resize(indexCapacity);
+
+	memset(&m_stats, 0, sizeof(LightBinStats));
+}
+
+void LightBinner::setEdges(const LightBinView &view){
+	for(uint32_t i = 0; i <= m_tilesX; i++){
+		float pixel = static_cast<float>(std::min(i * TileSize, m_width));
+		float slope = (2.0f * pixel / m_width - 1.0f) / view.projScaleX;
+		float scale = 1.0f / sqrtf(1.0f + slope * slope);
+
+		m_columnA[i] = scale;
+		m_columnB[i] = -slope * scale;
+	}
+
+	// Rows run down the screen, the distances are flipped so a tile is still inside its first edge and
+	// outside its second like a column
+	for(uint32_t i = 0; i <= m_tilesY; i++){
+		float pixel = static_cast<float>(std::min(i * TileSize, m_height));
+		float slope = (1.0f - 2.0f * pixel / m_height) / view.projScaleY;
+		float scale = 1.0f / sqrtf(1.0f + slope * slope);
+
+		m_rowA[i] = -scale;
+		m_rowB[i] = slope * scale;
+	}
+}
+
+bool LightBinner::findRange(const float *a, const float *b, uint32_t numTiles, uint32_t start, float offset, float z, float radius,
+	uint16_t &first, uint16_t &last) const{
+
+	__m128 position	= _mm_set1_ps(offset);
+	__m128 depth	= _mm_set1_ps(z);
+	__m128 inside	= _mm_set1_ps(-radius);
+	__m128 outside	= _mm_set1_ps(radius);
+
+	// A sphere entirely in front of the eye touches one run of tiles around the one its center projects to,
+	// the run is followed out both ways from there
+	if(start < numTiles && (TestTiles(a, b, start, position, depth, inside, outside) & 1)){
+		uint32_t begin = start, end = start;
+
+		for(uint32_t i = start + 1; i < numTiles; i += 4){
+			int missed = ~TestTiles(a, b, i, position, depth, inside, outside) & 0xF;
+
+			// Past the last tile counts as missed
+			if(numTiles - i < 4) missed |= 0xF & ~((1 << (numTiles - i)) - 1);
+
+			if(missed){
+				end = i + LowestBit(missed) - 1;
+				break;
+			}
+
+			end = i + 3;
+		}
+
+		for(uint32_t i = start; i > 0;){
+			uint32_t group = i >= 4 ? i - 4 : 0;
+			int missed = ~TestTiles(a, b, group, position, depth, inside, outside) & ((1 << (i - group)) - 1);
+
+			if(missed){
+				begin = group + HighestBit(missed) + 1;
+				break;
+			}
+
+			begin = i = group;
+		}
+
+		first	= static_cast<uint16_t>(begin);
+		last	= static_cast<uint16_t>(end);
+
+		return true;
+	}
+
+	// Otherwise, or when rounding put the center's tile just outside, every tile is tested
+	int32_t firstTile = -1, lastTile = -1;
+
+	for(uint32_t i = 0; i < numTiles; i += 4){
+		int mask = TestTiles(a, b, i, position, depth, inside, outside);
+
+		if(numTiles - i < 4) mask &= (1 << (numTiles - i)) - 1;
+		if(mask == 0) continue;
+
+		if(firstTile < 0) firstTile = i + LowestBit(mask);
+		lastTile = i + HighestBit(mask);
+	}
+
+	// A sphere reaching behind the eye can touch two runs, the range covers the tiles between them too
+	first	= static_cast<uint16_t>(firstTile);
+	last	= static_cast<uint16_t>(lastTile);
+
+	return firstTile >= 0;
+}
+
+void LightBinner::bin(const LightBinView &view, const PointLight *lights, uint32_t numLights){
+	memset(&m_stats, 0, sizeof(LightBinStats));
+	m_stats.numLights = numLights;
+
+	setEdges(view);
+
+	m_rects.resize(numLights);
+
+	std::fill(m_counts.begin(), m_counts.end(), 0);
+	std::fill(m_rowCounts.begin(), m_rowCounts.end(), 0);
+
+	const DirectX::XMFLOAT4X4 &m = view.view;
+	__m128 nearPlane	= _mm_set1_ps(view.nearPlane);
+	__m128 farPlane		= _mm_set1_ps(view.farPlane);
+	__m128 projScaleX	= _mm_set1_ps(view.projScaleX);
+	__m128 projScaleY	= _mm_set1_ps(view.projScaleY);
+	__m128 columnScale	= _mm_set1_ps(0.5f * m_width / TileSize);
+	__m128 rowScale		= _mm_set1_ps(0.5f * m_height / TileSize);
+	__m128 lastColumn	= _mm_set1_ps(static_cast<float>(m_tilesX - 1));
+	__m128 lastRow		= _mm_set1_ps(static_cast<float>(m_tilesY - 1));
+	__m128 zero			= _mm_setzero_ps();
+	__m128 one			= _mm_set1_ps(1.0f);
+
+	// Four lights at a time into view space, the rectangle of tiles each one touches is found a row and
+	// a column at a time
+	for(uint32_t i = 0; i < numLights; i += 4){
+		uint32_t numInGroup = std::min(numLights - i, 4u);
+		PointLight group[4];
+
+		// A missing light has a negative radius, it never gets past the near plane
+		for(uint32_t j = 0; j < 4; j++){
+			if(j < numInGroup){
+				group[j] = lights[i + j];
+			}
+			else{
+				memset(&group[j], 0, sizeof(PointLight));
+				group[j].radius = -1.0f;
+			}
+		}
+
+		__m128 x = _mm_loadu_ps(&group[0].position.x);
+		__m128 y = _mm_loadu_ps(&group[1].position.x);
+		__m128 z = _mm_loadu_ps(&group[2].position.x);
+		__m128 r = _mm_loadu_ps(&group[3].position.x);
+
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+
+		__m128 viewX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._11)), _mm_mul_ps(y, _mm_set1_ps(m._21))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m._31)), _mm_set1_ps(m._41)));
+		__m128 viewY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._12)), _mm_mul_ps(y, _mm_set1_ps(m._22))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m._32)), _mm_set1_ps(m._42)));
+		__m128 viewZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m._13)), _mm_mul_ps(y, _mm_set1_ps(m._23))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m._33)), _mm_set1_ps(m._43)));
+
+		int visible = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(viewZ, r), nearPlane), _mm_cmple_ps(_mm_sub_ps(viewZ, r), farPlane)));
+		int inFront = _mm_movemask_ps(_mm_cmpgt_ps(viewZ, r));
+
+		// Tiles the centers project to, clamped to the screen, only used for spheres in front of the eye
+		__m128 columns	= _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_div_ps(viewX, viewZ), projScaleX), one), columnScale);
+		__m128 rows		= _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(_mm_div_ps(viewY, viewZ), projScaleY)), rowScale);
+
+		columns	= _mm_min_ps(_mm_max_ps(columns, zero), lastColumn);
+		rows	= _mm_min_ps(_mm_max_ps(rows, zero), lastRow);
+
+		float centerX[4], centerY[4], centerZ[4], radius[4];
+		int32_t startX[4], startY[4];
+
+		_mm_storeu_ps(centerX, viewX);
+		_mm_storeu_ps(centerY, viewY);
+		_mm_storeu_ps(centerZ, viewZ);
+		_mm_storeu_ps(radius, r);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(startX), _mm_cvttps_epi32(columns));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(startY), _mm_cvttps_epi32(rows));
+
+		for(uint32_t j = 0; j < numInGroup; j++){
+			TileRect &rect = m_rects[i + j];
+
+			uint32_t columnStart	= (inFront & (1 << j)) ? startX[j] : m_tilesX;
+			uint32_t rowStart		= (inFront & (1 << j)) ? startY[j] : m_tilesY;
+
+			if(!(visible & (1 << j)) ||
+				!findRange(&m_columnA[0], &m_columnB[0], m_tilesX, columnStart, centerX[j], centerZ[j], radius[j], rect.minX, rect.maxX) ||
+				!findRange(&m_rowA[0], &m_rowB[0], m_tilesY, rowStart, centerY[j], centerZ[j], radius[j], rect.minY, rect.maxY)){
+
+				rect.minX = rect.minY = 1;
+				rect.maxX = rect.maxY = 0;
+				continue;
+			}
+
+			m_stats.numVisible++;
+
+			// Corners of the rectangle, summed into the tile counts afterwards
+			uint32_t stride = m_tilesX + 1;
+
+			m_counts[rect.minY * stride + rect.minX]++;
+			m_counts[rect.minY * stride + rect.maxX + 1]--;
+			m_counts[(rect.maxY + 1) * stride + rect.minX]--;
+			m_counts[(rect.maxY + 1) * stride + rect.maxX + 1]++;
+
+			m_rowCounts[rect.minY]++;
+			m_rowCounts[rect.maxY + 1]--;
+		}
+	}
+
+	// Running sums along each row and then down each column turn the corners into counts
+	uint32_t stride = m_tilesX + 1;
+
+	for(uint32_t tileY = 0; tileY < m_tilesY; tileY++){
+		int32_t *row = &m_counts[tileY * stride];
+		const int32_t *above = tileY > 0 ? row - stride : nullptr;
+		int32_t sum = 0;
+
+		for(uint32_t tileX = 0; tileX < m_tilesX; tileX++){
+			sum += row[tileX];
+
+			row[tileX] = sum + (above ? above[tileX] : 0);
+			m_tiles[tileY * m_tilesX + tileX].count = row[tileX];
+		}
+
+		if(tileY > 0) m_rowCounts[tileY] += m_rowCounts[tileY - 1];
+	}
+
+	// Lay the lists out back to back, a full tile or index list keeps the lights that come first
+	uint32_t offset = 0;
+
+	for(uint32_t i = 0; i < m_tiles.size(); i++){
+		uint32_t count = std::min(m_tiles[i].count, static_cast<uint32_t>(MaxLightsPerTile));
+
+		count = std::min(count, m_indexCapacity - offset);
+
+		m_stats.maxTileLights	= std::max(m_stats.maxTileLights, m_tiles[i].count);
+		m_stats.numDropped		+= m_tiles[i].count - count;
+
+		m_tiles[i].offset	= offset;
+		m_tiles[i].count	= count;
+		m_cursors[i]		= 0;
+
+		offset += count;
+	}
+
+	m_stats.numIndices = offset;
+
+	// Lights are gathered per row first so the lists are filled a row at a time, writing all over the index
+	// list light by light misses the cache on nearly every index
+	uint32_t numRowLights = 0;
+
+	for(uint32_t i = 0; i < m_tilesY; i++){
+		m_rowOffsets[i]	= numRowLights;
+		numRowLights	+= m_rowCounts[i];
+		m_rowCounts[i]	= 0;
+	}
+
+	m_rowLights.resize(numRowLights);
+
+	for(uint32_t i = 0; i < numLights; i++){
+		const TileRect &rect = m_rects[i];
+
+		for(uint32_t tileY = rect.minY; tileY <= rect.maxY; tileY++){
+			m_rowLights[m_rowOffsets[tileY] + m_rowCounts[tileY]++] = i;
+		}
+	}
+
+	for(uint32_t tileY = 0; tileY < m_tilesY; tileY++){
+		const uint32_t *rowLights = m_rowLights.empty() ? nullptr : &m_rowLights[m_rowOffsets[tileY]];
+
+		for(uint32_t i = 0; i < m_rowCounts[tileY]; i++){
+			const TileRect &rect = m_rects[rowLights[i]];
+
+			for(uint32_t tile = tileY * m_tilesX + rect.minX; tile <= tileY * m_tilesX + rect.maxX; tile++){
+				if(m_cursors[tile] < m_tiles[tile].count) m_indices[m_tiles[tile].offset + m_cursors[tile]++] = rowLights[i];
+			}
+		}
+	}
+}
+
+uint32_t LightBinner::getNumTilesX() const{
+	return m_tilesX;
+}
+
+uint32_t LightBinner::getNumTilesY() const{
+	return m_tilesY;
+}
+
+const LightTile *LightBinner::getTiles() const{
+	return &m_tiles[0];
+}
+
+const uint32_t *LightBinner::getIndices() const{
+	return m_indices.empty() ? nullptr : &m_indices[0];
+}
+
+uint32_t LightBinner::getNumIndices() const{
+	return m_stats.numIndices;
+}
+
+const LightBinStats &LightBinner::getStats() const{
+	return m_stats;
+}
+
+std::string LightBinner::formatStats() const{
+	char text[256];
+
+	sprintf_s(text, "Light binning: %u lights, %u visible, %u indices in %u tiles, %u most in a tile, %u dropped\n", m_stats.numLights,
+		m_stats.numVisible, m_stats.numIndices, m_tilesX * m_tilesY, m_stats.maxTileLights, m_stats.numDropped);
+
+	return text;
+}
+
+LightCuller::LightCuller(ID3D11Device *device, uint32_t width, uint32_t height, uint32_t maxLights, uint32_t indexCapacity) :
+	m_width(width), m_height(height), m_maxLights(maxLights), m_indexCapacity(indexCapacity){
+
+	m_tilesX		= (width + LightBinner::TileSize - 1) / LightBinner::TileSize;
+	m_tilesY		= (height + LightBinner::TileSize - 1) / LightBinner::TileSize;
+	m_numLights		= 0;
+	m_boundSlot		= -1;
+
+	m_shader		= nullptr;
+	m_constantBuffer = nullptr;
+
+	m_lightBuffer	= m_tileBuffer = m_indexBuffer = m_counterBuffer = nullptr;
+	m_lightView		= m_tileView = m_indexView = nullptr;
+	m_tileAccess	= m_indexAccess = m_counterAccess = nullptr;
+
+	GpuMemoryTag tag(L"Light lists");
+
+	if(!createBuffer(device, maxLights, sizeof(PointLight), &m_lightBuffer, &m_lightView, nullptr)) return;
+	if(!createBuffer(device, m_tilesX * m_tilesY, sizeof(LightTile), &m_tileBuffer, &m_tileView, &m_tileAccess)) return;
+	if(!createBuffer(device, indexCapacity, sizeof(uint32_t), &m_indexBuffer, &m_indexView, &m_indexAccess)) return;
+	if(!createBuffer(device, 1, sizeof(uint32_t), &m_counterBuffer, nullptr, &m_counterAccess)) return;
+
+	Util::CreateConstantBuffer(device, sizeof(LightCullingConstantBufferData), &m_constantBuffer, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+}
+
+LightCuller::~LightCuller(){
+	ReleaseCOM(m_tileAccess);
+	ReleaseCOM(m_indexAccess);
+	ReleaseCOM(m_counterAccess);
+	ReleaseCOM(m_lightView);
+	ReleaseCOM(m_tileView);
+	ReleaseCOM(m_indexView);
+	ReleaseCOM(m_lightBuffer);
+	ReleaseCOM(m_tileBuffer);
+	ReleaseCOM(m_indexBuffer);
+	ReleaseCOM(m_counterBuffer);
+	ReleaseCOM(m_constantBuffer);
+}
+
+bool LightCuller::createBuffer(ID3D11Device *device, uint32_t numElements, uint32_t stride, ID3D11Buffer **buffer, ID3D11ShaderResourceView **view,
+	ID3D11UnorderedAccessView **access){
+
+	D3D11_BUFFER_DESC bufferDesc = {0};
+
+	bufferDesc.ByteWidth			= numElements * stride;
+	bufferDesc.Usage				= access ? D3D11_USAGE_DEFAULT : D3D11_USAGE_DYNAMIC;
+	bufferDesc.BindFlags			= (view ? D3D11_BIND_SHADER_RESOURCE : 0) | (access ? D3D11_BIND_UNORDERED_ACCESS : 0);
+	bufferDesc.CPUAccessFlags		= access ? 0 : D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags			= D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	bufferDesc.StructureByteStride	= stride;
+
+	GpuAllocationId allocation = ReserveGpuMemory(GpuMemoryOther, bufferDesc.ByteWidth);
+
+	if(allocation == GpuMemoryTracker::InvalidAllocation){
+		*buffer = nullptr;
+		return false;
+	}
+
+	if(FAILED(device->CreateBuffer(&bufferDesc, NULL, buffer))){
+		*buffer = nullptr;
+		BindGpuMemory(nullptr, allocation);
+		return false;
+	}
+
+	BindGpuMemory(*buffer, allocation);
+
+	// Structured buffers get views of every element without a description
+	if(view && FAILED(device->CreateShaderResourceView(*buffer, NULL, view))){
+		*view = nullptr;
+		return false;
+	}
+
+	if(access && FAILED(device->CreateUnorderedAccessView(*buffer, NULL, access))){
+		*access = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+bool LightCuller::isValid() const{
+	return m_constantBuffer && m_lightView && m_tileView && m_indexView && m_counterAccess;
+}
+
+void LightCuller::setShader(ID3D11ComputeShader *shader){
+	m_shader = shader;
+}
+
+void LightCuller::setLights(ID3D11DeviceContext *context, const PointLight *lights, uint32_t numLights){
+	if(!isValid()) return;
+
+	m_numLights = std::min(numLights, m_maxLights);
+
+	if(m_numLights == 0) return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+
+	if(FAILED(context->Map(m_lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))){
+		m_numLights = 0;
+		return;
+	}
+
+	memcpy(mapped.pData, lights, m_numLights * sizeof(PointLight));
+	context->Unmap(m_lightBuffer, 0);
+}
+
+void LightCuller::cull(ID3D11DeviceContext *context, const Camera &camera){
+	if(!m_shader || !isValid()) return;
+
+	// A resource can't be read by one stage while another writes it
+	if(m_boundSlot >= 0){
+		ID3D11ShaderResourceView *views[3] = {nullptr};
+
+		context->PSSetShaderResources(m_boundSlot, 3, views);
+		m_boundSlot = -1;
+	}
+
+	LightBinView view = GetLightBinView(camera);
+	LightCullingConstantBufferData cbData;
+
+	cbData.view				= camera.getViewMatrix();
+	cbData.projScale		= DirectX::XMFLOAT2(view.projScaleX, view.projScaleY);
+	cbData.nearPlane		= view.nearPlane;
+	cbData.farPlane			= view.farPlane;
+	cbData.screenSize		= DirectX::XMUINT2(m_width, m_height);
+	cbData.numTilesX		= m_tilesX;
+	cbData.numLights		= m_numLights;
+	cbData.indexCapacity	= m_indexCapacity;
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+
+	if(FAILED(context->Map(m_constantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+
+	memcpy(mapped.pData, &cbData, sizeof(LightCullingConstantBufferData));
+	context->Unmap(m_constantBuffer, 0);
+
+	// Tiles take their ranges of the index list from this counter
+	UINT zero[4] = {0};
+
+	context->ClearUnorderedAccessViewUint(m_counterAccess, zero);
+
+	ID3D11UnorderedAccessView *access[] = {m_tileAccess, m_indexAccess, m_counterAccess};
+
+	context->CSSetShader(m_shader, NULL, 0);
+	context->CSSetConstantBuffers(0, 1, &m_constantBuffer);
+	context->CSSetShaderResources(0, 1, &m_lightView);
+	context->CSSetUnorderedAccessViews(0, 3, access, NULL);
+
+	context->Dispatch(m_tilesX, m_tilesY, 1);
+
+	// Unbound again so the pixel shader can read what was written
+	ID3D11UnorderedAccessView *noAccess[3] = {nullptr};
+	ID3D11ShaderResourceView *noView = nullptr;
+
+	context->CSSetUnorderedAccessViews(0, 3, noAccess, NULL);
+	context->CSSetShaderResources(0, 1, &noView);
+	context->CSSetShader(NULL, NULL, 0);
+}
+
+void LightCuller::upload(UploadManager &uploads, const LightBinner &binner){
+	if(!isValid() || binner.getNumTilesX() != m_tilesX || binner.getNumTilesY() != m_tilesY) return;
+
+	uint32_t numIndices = std::min(binner.getNumIndices(), m_indexCapacity);
+
+	uploads.upload(m_tileBuffer, 0, binner.getTiles(), m_tilesX * m_tilesY * sizeof(LightTile));
+
+	if(numIndices > 0) uploads.upload(m_indexBuffer, 0, binner.getIndices(), numIndices * sizeof(uint32_t));
+}
+
+void LightCuller::bind(ID3D11DeviceContext *context, UINT slot){
+	ID3D11ShaderResourceView *views[] = {m_lightView, m_indexView, m_tileView};
+
+	context->PSSetShaderResources(slot, 3, views);
+	m_boundSlot = static_cast<int32_t>(slot);
+}
+
+uint32_t LightCuller::getNumTilesX() const{
+	return m_tilesX;
+}
+
+uint32_t LightCuller::getNumTilesY() const{
+	return m_tilesY;
+}
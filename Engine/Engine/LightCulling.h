@@ -0,0 +1,157 @@
+#pragma once
+
+/////////////////////////
+// Tiled light culling //
+/////////////////////////
+
+// Same layout as PointLight in the shaders
+struct PointLight{
+	DirectX::XMFLOAT3 position;
+	float radius;
+	DirectX::XMFLOAT3 color;
+	float padding;
+};
+
+// Range of a tile's lights in the index list, same layout as TileLights in the shaders
+struct LightTile{
+	uint32_t offset, count;
+};
+
+// What the tiles are binned against, the view matrix is row-major and the scales are the projection's _11 and _22
+struct LightBinView{
+	DirectX::XMFLOAT4X4 view;
+	float projScaleX, projScaleY;
+	float nearPlane, farPlane;
+};
+
+LightBinView GetLightBinView(const Camera &camera);
+
+struct LightBinStats{
+	uint32_t numLights, numVisible;
+	uint32_t numIndices, maxTileLights;
+
+	// Lights left out of a tile because it or the index list was full
+	uint32_t numDropped;
+};
+
+// Builds the per-tile light lists on the CPU with the same test as LightCulling_CS.hlsl. It is the reference
+// the compute shader is checked against and the fallback when it can't run. Tiles list their lights in light
+// order, the compute shader's order is whatever its threads happen to append in
+class LightBinner{
+public:
+	static const uint32_t TileSize			= 16;
+	static const uint32_t MaxLightsPerTile	= 512;
+
+private:
+	uint32_t m_width, m_height;
+	uint32_t m_tilesX, m_tilesY;
+	uint32_t m_indexCapacity;
+
+	// Tile edges through the eye as normalized (a, b), a point's distance to edge i is a * x + b * z for
+	// columns and a * y + b * z for rows. Padded so the last group of four can be loaded whole
+	std::vector<float> m_columnA, m_columnB, m_rowA, m_rowB;
+
+	// First and last tile each light touches, empty when it was culled
+	struct TileRect{
+		uint16_t minX, minY, maxX, maxY;
+	};
+
+	std::vector<TileRect> m_rects;
+	std::vector<LightTile> m_tiles;
+
+	// Lights per tile as the corners of each light's rectangle, one column and row past the tiles
+	std::vector<int32_t> m_counts;
+	std::vector<uint32_t> m_cursors;
+	std::vector<uint32_t> m_indices;
+
+	// Lights touching each row of tiles, in light order
+	std::vector<uint32_t> m_rowCounts, m_rowOffsets, m_rowLights;
+
+	LightBinStats m_stats;
+
+	void setEdges(const LightBinView &view);
+
+	// First and last tile along one axis, start is the tile the center projects to or numTiles when the sphere
+	// isn't entirely in front of the eye
+	bool findRange(const float *a, const float *b, uint32_t numTiles, uint32_t start, float offset, float z, float radius,
+		uint16_t &first, uint16_t &last) const;
+
+	LightBinner(const LightBinner &) = delete;
+	LightBinner &operator=(const LightBinner &) = delete;
+
+public:
+	LightBinner(uint32_t width, uint32_t height, uint32_t indexCapacity);
+
+	void bin(const LightBinView &view, const PointLight *lights, uint32_t numLights);
+
+	uint32_t getNumTilesX() const;
+	uint32_t getNumTilesY() const;
+
+	// Row by row from the top left
+	const LightTile *getTiles() const;
+	const uint32_t *getIndices() const;
+	uint32_t getNumIndices() const;
+
+	const LightBinStats &getStats() const;
+	std::string formatStats() const;
+};
+
+struct LightCullingConstantBufferData{
+	DirectX::XMMATRIX view;
+	DirectX::XMFLOAT2 projScale;
+	float nearPlane, farPlane;
+	DirectX::XMUINT2 screenSize;
+	uint32_t numTilesX, numLights;
+	uint32_t indexCapacity;
+};
+
+// Owns the light list and the tile lists the material shader reads. The lists are built by the compute shader,
+// or copied in from a LightBinner when the CPU does the binning
+class LightCuller{
+private:
+	uint32_t m_width, m_height;
+	uint32_t m_tilesX, m_tilesY;
+	uint32_t m_maxLights, m_numLights;
+	uint32_t m_indexCapacity;
+
+	ID3D11ComputeShader *m_shader;
+	ID3D11Buffer *m_constantBuffer;
+
+	ID3D11Buffer *m_lightBuffer, *m_tileBuffer, *m_indexBuffer, *m_counterBuffer;
+	ID3D11ShaderResourceView *m_lightView, *m_tileView, *m_indexView;
+	ID3D11UnorderedAccessView *m_tileAccess, *m_indexAccess, *m_counterAccess;
+
+	// Pixel shader slot the lists were last bound to, they have to come off it before the compute shader writes them
+	int32_t m_boundSlot;
+
+	// Buffers without an unordered access view are dynamic, the CPU writes them
+	bool createBuffer(ID3D11Device *device, uint32_t numElements, uint32_t stride, ID3D11Buffer **buffer, ID3D11ShaderResourceView **view,
+		ID3D11UnorderedAccessView **access);
+
+	LightCuller(const LightCuller &) = delete;
+	LightCuller &operator=(const LightCuller &) = delete;
+
+public:
+	LightCuller(ID3D11Device *device, uint32_t width, uint32_t height, uint32_t maxLights, uint32_t indexCapacity);
+	~LightCuller();
+
+	bool isValid() const;
+
+	// Replaces the culling compute shader, e.g. after it was reloaded
+	void setShader(ID3D11ComputeShader *shader);
+
+	// Lights past maxLights are ignored
+	void setLights(ID3D11DeviceContext *context, const PointLight *lights, uint32_t numLights);
+
+	// Builds the tile lists on the GPU
+	void cull(ID3D11DeviceContext *context, const Camera &camera);
+
+	// Takes the tile lists from the CPU instead, they land with the upload manager's next submit
+	void upload(UploadManager &uploads, const LightBinner &binner);
+
+	// Binds the light list, the index list and the tiles to three consecutive pixel shader slots
+	void bind(ID3D11DeviceContext *context, UINT slot);
+
+	uint32_t getNumTilesX() const;
+	uint32_t getNumTilesY() const;
+};
@@ -0,0 +1,90 @@
+// Tile size and list limit, these match LightBinner
+#define TILE_SIZE				16
+#define MAX_LIGHTS_PER_TILE		512
+
+cbuffer ConstantBuffer : register (b0){
+	matrix View;
+	float2 ProjScale;
+	float NearPlane;
+	float FarPlane;
+	uint2 ScreenSize;
+	uint NumTilesX;
+	uint NumLights;
+	uint IndexCapacity;
+}
+
+struct PointLight{
+	float3 position;
+	float radius;
+	float3 color;
+	float padding;
+};
+
+StructuredBuffer<PointLight> Lights		: register(t0);
+
+RWStructuredBuffer<uint2> TileLights	: register(u0);
+RWStructuredBuffer<uint> LightIndices	: register(u1);
+RWStructuredBuffer<uint> IndexCounter	: register(u2);
+
+groupshared uint TileCount;
+groupshared uint TileOffset;
+groupshared uint TileIndices[MAX_LIGHTS_PER_TILE];
+
+// Distance from a tile edge through the eye at the given slope, positive past it
+float EdgeDistance(float position, float z, float slope){
+	return (position - slope * z) * rsqrt(1.0f + slope * slope);
+}
+
+// One group per tile, its threads test the lights in turn and append the ones that touch it
+[numthreads(TILE_SIZE, TILE_SIZE, 1)]
+void C_Shader(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex){
+	if(groupIndex == 0) TileCount = 0;
+
+	// Slopes of the tile's sides in view space, the last row and column stop at the screen's edge
+	float2 minPixel	= groupId.xy * TILE_SIZE;
+	float2 maxPixel	= min(minPixel + TILE_SIZE, ScreenSize);
+	float left		= (2.0f * minPixel.x / ScreenSize.x - 1.0f) / ProjScale.x;
+	float right		= (2.0f * maxPixel.x / ScreenSize.x - 1.0f) / ProjScale.x;
+	float top		= (1.0f - 2.0f * minPixel.y / ScreenSize.y) / ProjScale.y;
+	float bottom	= (1.0f - 2.0f * maxPixel.y / ScreenSize.y) / ProjScale.y;
+
+	GroupMemoryBarrierWithGroupSync();
+
+	for(uint i = groupIndex; i < NumLights; i += TILE_SIZE * TILE_SIZE){
+		PointLight light = Lights[i];
+		float3 center = mul(float4(light.position, 1.0f), View).xyz;
+		float radius = light.radius;
+
+		if(center.z + radius < NearPlane || center.z - radius > FarPlane) continue;
+
+		if(EdgeDistance(center.x, center.z, left) < -radius || EdgeDistance(center.x, center.z, right) > radius) continue;
+		if(EdgeDistance(center.y, center.z, bottom) < -radius || EdgeDistance(center.y, center.z, top) > radius) continue;
+
+		uint slot;
+		InterlockedAdd(TileCount, 1, slot);
+
+		if(slot < MAX_LIGHTS_PER_TILE) TileIndices[slot] = i;
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	// Take a range of the index list, whatever doesn't fit is dropped
+	if(groupIndex == 0){
+		uint count = min(TileCount, MAX_LIGHTS_PER_TILE);
+		uint offset;
+
+		InterlockedAdd(IndexCounter[0], count, offset);
+
+		count = offset < IndexCapacity ? min(count, IndexCapacity - offset) : 0;
+		TileLights[groupId.y * NumTilesX + groupId.x] = uint2(offset, count);
+
+		TileCount	= count;
+		TileOffset	= offset;
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	for(uint j = groupIndex; j < TileCount; j += TILE_SIZE * TILE_SIZE){
+		LightIndices[TileOffset + j] = TileIndices[j];
+	}
+}
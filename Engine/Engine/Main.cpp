@@ -24,28 +24,138 @@ static const uint32_t Height			= 600;
 static const float CameraMoveSpeed		= 2.0f;
 static const float CameraRotateSpeed	= 0.005f;
 
+// Occlusion buffer is a quarter of the backbuffer on each axis
+static const uint32_t OcclusionWidth	= Width / 4;
+static const uint32_t OcclusionHeight	= Height / 4;
+static const float OccluderCellSize		= 0.5f;
+
+// Frames in flight, 2 updates the next frame while the current one is submitted
+static const uint32_t FrameLatency		= 2;
+static const size_t FrameMemorySize		= 1024 * 1024;
+
+// Texture streaming
+static const size_t TextureBudget		= 64 * 1024 * 1024;
+static const size_t MinResidentSize		= 64;
+
+// Buffer uploads are copied out of this ring once per frame
+static const size_t UploadRingSize		= 8 * 1024 * 1024;
+
+// Point lights, culled into 16 pixel tiles by a compute shader or on the CPU
+static const uint32_t NumPointLights	= 128;
+static const uint32_t MaxPointLights	= 4096;
+static const uint32_t LightIndexCapacity	= 256 * 1024;
+
+// Spot lights, only shaded when the lights are clustered
+static const uint32_t NumSpotLights		= 32;
+static const uint32_t MaxSpotLights		= 1024;
+
+// GPU memory, the tracker's report goes to the debugger every few seconds
+static const uint64_t GpuMemoryBudget	= 256 * 1024 * 1024;
+static const uint32_t GpuMemoryDumpInterval	= 600;
+
 }
 
+// Scene components, world matrices are stored transposed for the shaders like MeshEntity's
+struct TransformComponent{
+	DirectX::XMFLOAT4X4 world;
+};
+
+struct BoundsComponent{
+	DirectX::XMFLOAT3 min, max;
+};
+
+struct MeshComponent{
+	const MeshEntity *mesh;
+};
+
+struct MaterialComponent{
+	StreamedTextureHandle diffuse, normal;
+};
+
+enum ShadowFlags{
+	ShadowCast = 1,
+};
+
+struct ShadowComponent{
+	uint32_t flags;
+};
+
+struct OccluderComponent{
+	const OccluderMesh *occluder;
+};
+
+// Entity that passed culling, with its world matrix for the frame
+struct DrawItem{
+	const MeshEntity *entity;
+	DirectX::XMFLOAT4X4 world;
+	StreamedTextureHandle diffuse, normal;
+};
+
+// Items live in the frame's memory, they stay valid until its slot is reused
+struct DrawList{
+	DrawItem *items;
+	uint32_t numItems;
+};
+
+// Written by the snapshot and update stages of a frame, read by its submit
+struct FrameData{
+	float time;
+	Camera userCamera, lightCamera;
+
+	// Temporaries of the frame, reset when the snapshot reuses the slot
+	LinearAllocator *memory;
+
+	DrawList drawList, shadowList;
+	float chiefScreenSize;
+
+	// Lists that didn't fit the frame's memory, kept until the slot is reused
+	std::vector<DrawItem> drawOverflow, shadowOverflow;
+
+	// Tile light lists binned by the update when the CPU does the culling
+	bool cpuLightCulling;
+	LightBinner *lightBinner;
+
+	// Froxel light lists, assigned by the update instead of the tiles
+	bool clusteredLights;
+	LightClusterer *lightClusterer;
+
+	// Material variant the submit binds, matches the light lists picked above
+	uint32_t materialMask;
+};
+
 struct MaterialConstantBufferData{
 	DirectX::XMMATRIX world;
 	DirectX::XMMATRIX viewProj;
 	DirectX::XMMATRIX lightView;
 	DirectX::XMVECTOR lightDir;
 	DirectX::XMVECTOR cameraDir;
-	DirectX::XMVECTOR mode;
+	DirectX::XMUINT2 numTiles;
+	DirectX::XMFLOAT2 clusterScale;
+	DirectX::XMFLOAT2 clusterDepth;
 };
 
 // Shaders and vertex layouts
 ID3D11VertexShader *g_materialVS, *g_shadowVS, *g_passthruVS;
-ID3D11PixelShader *g_materialPS, *g_texToQuadPS;
+ID3D11PixelShader *g_texToQuadPS;
+ID3D11ComputeShader *g_lightCullingCS;
+
+// Material pixel shader variants indexed by permutation mask, g_materialMask picks the next frame's
+ShaderPermutations g_materialPermutations(ShaderDesc{L"..\\Engine\\Material_PS.hlsl", "P_Shader", "ps_5_0"});
+std::vector<ID3D11PixelShader *> g_materialPSVariants;
+uint32_t g_materialMask;
 ID3D11InputLayout *g_materialVertLayout, *g_shadowVertLayout, *g_passthruVertLayout;
+InputLayoutCache *g_layoutCache;
+
+// Compiled shaders persist here between runs
+ShaderCache g_shaderCache(L"..\\ShaderCache");
 
 // Buffers
 ID3D11Buffer *g_materialConstantBuffer;
 
 // Textures
-ID3D11Texture2D *g_diffuseTexture, *g_normalTexture;
-ID3D11ShaderResourceView *g_diffuseTextureView, *g_normalTextureView;
+TexturePack g_texturePack;
+TextureStreamer *g_textureStreamer;
+StreamedTextureHandle g_diffuseTexture, g_normalTexture;
 
 // CPU-side constant buffer data for shaders
 MaterialConstantBufferData g_materialCbData;
@@ -59,9 +169,53 @@ ShadowMapper *g_shadowMapper;
 // Geometric entities
 MeshEntity g_masterChief, g_crate, g_sphere, g_plane, g_quad;
 
+// Creates mesh buffers with the usage each mesh's policy asks for, streamed ones are filled through the upload ring
+UploadManager *g_uploadManager;
+MeshBufferBackend *g_meshBuffers;
+
+// Scene, only the update stage touches it once the frame loop is running
+EntityWorld g_world;
+Id g_chiefEntity, g_sphereEntity, g_planeEntity;
+
+// Per-chunk results of the parallel extraction, merged in chunk order
+std::vector<EntityWorld::Chunk> g_extractChunks;
+std::vector<DrawList> g_extractDrawLists;
+std::vector<std::vector<DrawItem>> g_extractOverflow;
+std::atomic<uint32_t> g_numDrawListOverflows(0);
+
+// Linear memory for each frame in flight
+FrameAllocator *g_frameAllocator;
+
+// Frame tasks
+JobSystem *g_jobSystem;
+FramePipeline *g_framePipeline;
+
+// Timestamps around each pass, read back a few frames later
+GpuProfiler *g_gpuProfiler;
+
+// Reloads shaders, textures and meshes as their files are edited
+HotReloader *g_hotReloader;
+
+// Per-frame data, one slot per frame in flight
+FrameData g_frames[FramePipeline::MaxLatency];
+
 // Cameras
 Camera g_lightCamera;
 
+// Occlusion culling
+OcclusionCuller *g_occlusionCuller;
+OccluderMesh g_chiefOccluder, g_planeOccluder;
+
+// Point lights and their tile lists, 'L' switches the culling between the GPU and the CPU
+std::vector<PointLight> g_pointLights;
+LightCuller *g_lightCuller;
+bool g_cpuLightCulling;
+
+// Spot lights and the cluster lists, 'K' switches the shading from tiles to clusters
+std::vector<SpotLight> g_spotLights;
+LightClusterLists *g_lightClusters;
+bool g_clusteredLights;
+
 void UpdateConstantBuffer(){
 	D3D11_MAPPED_SUBRESOURCE mappedSubRsrc;
 
@@ -70,34 +224,147 @@ void UpdateConstantBuffer(){
 	Global::DeviceContext->Unmap(g_materialConstantBuffer, NULL);
 }
 
-bool LoadShaders(){
-	int ret = 0;
+void LoadVertexShader(AssetLoader &loader, const std::wstring &path, ID3D11VertexShader **shader, ID3D11InputLayout **layout,
+	int &numShaders, int &numLayouts){
 
-	// Create vertex/pixel shaders
-	if(Util::CreateVertexShaderFromBinary(Global::Device, L"..\\Debug\\Material_VS.cso", &g_materialVS))	ret++;
-	if(Util::CreateVertexShaderFromBinary(Global::Device, L"..\\Debug\\Shadow_VS.cso", &g_shadowVS))		ret++;
-	if(Util::CreateVertexShaderFromBinary(Global::Device, L"..\\Debug\\Passthru_VS.cso", &g_passthruVS))	ret++;
-	
-	if(Util::CreatePixelShaderFromBinary(Global::Device, L"..\\Debug\\Material_PS.cso", &g_materialPS))		ret++;
-	if(Util::CreatePixelShaderFromBinary(Global::Device, L"..\\Debug\\TexToQuad_PS.cso", &g_texToQuadPS))	ret++;
+	ShaderDesc desc = {path, "V_Shader", "vs_5_0"};
+	std::shared_ptr<std::shared_ptr<const CompiledShader>> compiled = std::make_shared<std::shared_ptr<const CompiledShader>>();
 
-	return (ret == 5);
+	// Cache misses compile on a worker, the input layout comes from the same compile's reflection data
+	// and is shared with every other vertex shader that has the same signature
+	loader.run([desc, compiled](const AssetLoader::Data &){
+		return g_shaderCache.get(desc, *compiled);
+	},
+	[compiled, shader, layout, &numShaders, &numLayouts](const AssetLoader::Data &){
+		const CompiledShader &vs = **compiled;
+
+		if(SUCCEEDED(Global::Device->CreateVertexShader(&vs.bytecode[0], vs.bytecode.size(), NULL, shader))) numShaders++;
+		if(g_layoutCache->get(vs, layout)) numLayouts++;
+	});
+}
+
+void LoadPixelShader(AssetLoader &loader, const std::wstring &path, ID3D11PixelShader **shader, int &ret){
+	ShaderDesc desc = {path, "P_Shader", "ps_5_0"};
+	std::shared_ptr<std::shared_ptr<const CompiledShader>> compiled = std::make_shared<std::shared_ptr<const CompiledShader>>();
+
+	loader.run([desc, compiled](const AssetLoader::Data &){
+		return g_shaderCache.get(desc, *compiled);
+	},
+	[compiled, shader, &ret](const AssetLoader::Data &){
+		const CompiledShader &ps = **compiled;
+
+		if(SUCCEEDED(Global::Device->CreatePixelShader(&ps.bytecode[0], ps.bytecode.size(), NULL, shader))) ret++;
+	});
+}
+
+void LoadComputeShader(AssetLoader &loader, const std::wstring &path, ID3D11ComputeShader **shader, int &ret){
+	ShaderDesc desc = {path, "C_Shader", "cs_5_0"};
+	std::shared_ptr<std::shared_ptr<const CompiledShader>> compiled = std::make_shared<std::shared_ptr<const CompiledShader>>();
+
+	loader.run([desc, compiled](const AssetLoader::Data &){
+		return g_shaderCache.get(desc, *compiled);
+	},
+	[compiled, shader, &ret](const AssetLoader::Data &){
+		const CompiledShader &cs = **compiled;
+
+		if(SUCCEEDED(Global::Device->CreateComputeShader(&cs.bytecode[0], cs.bytecode.size(), NULL, shader))) ret++;
+	});
+}
+
+void LoadPixelShaderVariants(AssetLoader &loader, const ShaderPermutations &permutations, std::vector<ID3D11PixelShader *> &variants, int &ret){
+	variants.assign(permutations.getNumVariants(), nullptr);
+
+	// Counts as one shader once every valid variant has been created
+	std::shared_ptr<uint32_t> numPending = std::make_shared<uint32_t>(0);
+
+	for(uint32_t mask = 0; mask < permutations.getNumVariants(); mask++){
+		if(permutations.isValid(mask)) (*numPending)++;
+	}
+
+	for(uint32_t mask = 0; mask < permutations.getNumVariants(); mask++){
+		if(!permutations.isValid(mask)) continue;
+
+		ShaderDesc desc = permutations.getDesc(mask);
+		std::shared_ptr<std::shared_ptr<const CompiledShader>> compiled = std::make_shared<std::shared_ptr<const CompiledShader>>();
+
+		loader.run([desc, compiled](const AssetLoader::Data &){
+			return g_shaderCache.get(desc, *compiled);
+		},
+		[compiled, &variants, mask, numPending, &ret](const AssetLoader::Data &){
+			const CompiledShader &ps = **compiled;
+
+			if(SUCCEEDED(Global::Device->CreatePixelShader(&ps.bytecode[0], ps.bytecode.size(), NULL, &variants[mask])) && --(*numPending) == 0) ret++;
+		});
+	}
 }
 
-bool LoadLayouts(){
-	int ret = 0;
+void LoadMesh(AssetLoader &loader, const std::wstring &path, MeshEntity &entity, OccluderMesh *occluder, int &ret){
+	// Validate on a worker, the occluder is simplified there too since it only needs the CPU-side data
+	loader.load(path, [occluder](const AssetLoader::Data &data){
+		BoxMesh mesh;
+
+		if(!DecodeMeshFromMemory(data.bytes, data.size, mesh) || mesh.numVertices == 0 || mesh.numIndices == 0) return false;
+
+		if(occluder){
+			SimplifyOccluder(mesh.vertices, mesh.indices, mesh.numVertices, mesh.numIndices, sizeof(BoxVertex), Global::OccluderCellSize, *occluder);
+		}
+
+		return true;
+	},
 
-	// Create input layouts
-	if(Util::CreateVertexLayoutFromFile(Global::Device, L"..\\Engine\\Material_VS.hlsl", "V_Shader", &g_materialVertLayout))	ret++;
-	if(Util::CreateVertexLayoutFromFile(Global::Device, L"..\\Engine\\Shadow_VS.hlsl", "V_Shader", &g_shadowVertLayout))		ret++;
-	if(Util::CreateVertexLayoutFromFile(Global::Device, L"..\\Engine\\Passthru_VS.hlsl", "V_Shader", &g_passthruVertLayout))	ret++;
+	// The buffers are filled straight from the mapped file, it stays open until this returns
+	[path, &entity, &ret](const AssetLoader::Data &data){
+		GpuMemoryTag tag(path);
+		BoxMesh mesh;
 
-	return (ret == 3);
+		if(DecodeMeshFromMemory(data.bytes, data.size, mesh) && LoadMeshFromFile(*g_meshBuffers, path, mesh.usage, mesh.vertices, mesh.indices,
+			mesh.numVertices, mesh.numIndices, sizeof(BoxVertex), entity)) ret++;
+	});
 }
 
-bool LoadEntities(){
-	int ret = 0;
+void LoadTexture(AssetLoader &loader, const std::wstring &path, StreamedTextureHandle *handle, int &ret){
+	std::shared_ptr<PreparedTexture> prepared = std::make_shared<PreparedTexture>();
+
+	// Header validation and mip layouts are worked out on a worker, the low mips are created on the main thread
+	auto finalize = [prepared, handle, &ret](const AssetLoader::Data &data){
+		*handle = g_textureStreamer->load(*prepared, data.bytes, data.size);
 
+		if(*handle != TextureStreamer::InvalidHandle) ret++;
+	};
+
+	const uint8_t *packed;
+	size_t packedSize;
+
+	auto prepare = [path, prepared](const AssetLoader::Data &data){
+		return g_textureStreamer->prepare(path, data.bytes, data.size, *prepared);
+	};
+
+	// Packed textures are already mapped, so they skip the I/O thread and are used in place
+	if(g_texturePack.find(path, &packed, &packedSize)){
+		loader.load(packed, packedSize, prepare, finalize);
+	}
+	else{
+		loader.load(path, prepare, finalize);
+	}
+}
+
+void LoadShaders(AssetLoader &loader, int &numShaders, int &numLayouts){
+
+	// Create vertex/pixel shaders and the vertex layouts reflected from them
+	LoadVertexShader(loader, L"..\\Engine\\Material_VS.hlsl", &g_materialVS, &g_materialVertLayout, numShaders, numLayouts);
+	LoadVertexShader(loader, L"..\\Engine\\Shadow_VS.hlsl", &g_shadowVS, &g_shadowVertLayout, numShaders, numLayouts);
+	LoadVertexShader(loader, L"..\\Engine\\Passthru_VS.hlsl", &g_passthruVS, &g_passthruVertLayout, numShaders, numLayouts);
+
+	// The lighting model and whether lights are looked up by tile or by cluster are picked by permutation, every variant is compiled up front
+	g_materialPermutations.addKeywordGroup({"COOK_TORRANCE_1", "COOK_TORRANCE_2", "COOK_TORRANCE_3", "COOK_TORRANCE_4", "NO_LIGHTING"});
+	g_materialPermutations.addKeywordGroup({"TILED_LIGHTS", "CLUSTERED_LIGHTS"});
+
+	LoadPixelShaderVariants(loader, g_materialPermutations, g_materialPSVariants, numShaders);
+	LoadPixelShader(loader, L"..\\Engine\\TexToQuad_PS.hlsl", &g_texToQuadPS, numShaders);
+	LoadComputeShader(loader, L"..\\Engine\\LightCulling_CS.hlsl", &g_lightCullingCS, numShaders);
+}
+
+void LoadEntities(AssetLoader &loader, int &ret){
 	float g_planeRawVertices[] = {
 		-0.5f, -0.5f, 0.5f, 1.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f,  -0.707f, 0.0f, 0.707f,
 		-0.5f, 0.5f, 0.5f, 1.0f,   0.0f, 0.0f, -1.0f,  0.0f, 1.0f,  -0.707f, 0.0f, -0.707f,
@@ -117,26 +384,35 @@ bool LoadEntities(){
 		0, 2, 3,
 	};
 
-	// Load models into renderable entities
+	// Load models into renderable entities, the chief also becomes a simplified occluder
 	// TODO: Change boxer to use only a single file extension (.BOX), so that git doesn't commit it
-	if(LoadMeshFromFile(Global::Device, L"..\\..\\Models\\chief.box", g_masterChief))								ret++;
-	if(LoadMeshFromFile(Global::Device, L"..\\..\\Models\\crate.box", g_crate))										ret++;
-	if(LoadMeshFromFile(Global::Device, L"..\\..\\Models\\sphere.box", g_sphere))									ret++;
-	if(LoadMeshFromFile(Global::Device, g_planeRawVertices, g_planeRawIndices, 4, 6, sizeof(BoxVertex), g_plane))	ret++;
-	if(LoadMeshFromFile(Global::Device, g_quadRawVertices, g_planeRawIndices, 4, 6, sizeof(float) * 6, g_quad))		ret++;
-	//LoadMeshFromFile(Global::Device, L"..\\..\\Models\\wall.box", g_plane);
+	LoadMesh(loader, L"..\\..\\Models\\chief.box", g_masterChief, &g_chiefOccluder, ret);
+	LoadMesh(loader, L"..\\..\\Models\\crate.box", g_crate, nullptr, ret);
+	LoadMesh(loader, L"..\\..\\Models\\sphere.box", g_sphere, nullptr, ret);
+	//LoadMesh(loader, L"..\\..\\Models\\wall.box", g_plane, nullptr, ret);
+
+	// The raw meshes are tiny and live on the stack, so they are created right away
+	GpuMemoryTag tag(L"Raw meshes");
 
-	return (ret == 5);
+	if(LoadMeshFromFile(*g_meshBuffers, L"Plane", MeshUsageStatic, g_planeRawVertices, g_planeRawIndices, 4, 6, sizeof(BoxVertex), g_plane))	ret++;
+	if(LoadMeshFromFile(*g_meshBuffers, L"Quad", MeshUsageStatic, g_quadRawVertices, g_planeRawIndices, 4, 6, sizeof(float) * 6, g_quad))		ret++;
+
+	SimplifyOccluder(g_planeRawVertices, g_planeRawIndices, 4, 6, sizeof(BoxVertex), 0, g_planeOccluder);
 }
 
-bool LoadTexturesAndSampler(){
-	int ret = 0;
-	
-	// Load textures
-	if(SUCCEEDED(DirectX::CreateDDSTextureFromFile(Global::Device, Global::DeviceContext, L"..\\..\\Textures\\chief_techsuit_d.DDS",
-		reinterpret_cast<ID3D11Resource **>(&g_diffuseTexture), &g_diffuseTextureView))) ret++;
-	if(SUCCEEDED(DirectX::CreateDDSTextureFromFile(Global::Device, Global::DeviceContext, L"..\\..\\Textures\\chief_techsuit_n.DDS",
-		reinterpret_cast<ID3D11Resource **>(&g_normalTexture), &g_normalTextureView))) ret++;
+void LoadTexturesAndSampler(AssetLoader &loader, int &ret){
+
+	// Load textures, only the low mips are resident at first
+	g_textureStreamer = new TextureStreamer(Global::Device, Global::DeviceContext, Global::TextureBudget, Global::MinResidentSize);
+
+	// Use the packed archive when one has been built, loose files otherwise
+	if(g_texturePack.open(L"..\\..\\Textures\\Textures.pak")) g_textureStreamer->setTexturePack(&g_texturePack);
+
+	g_diffuseTexture	= TextureStreamer::InvalidHandle;
+	g_normalTexture		= TextureStreamer::InvalidHandle;
+
+	LoadTexture(loader, L"..\\..\\Textures\\chief_techsuit_d.DDS", &g_diffuseTexture, ret);
+	LoadTexture(loader, L"..\\..\\Textures\\chief_techsuit_n.DDS", &g_normalTexture, ret);
 
 	// Define simple sampler
 	D3D11_SAMPLER_DESC SamplerStateTexture = {
@@ -151,33 +427,343 @@ bool LoadTexturesAndSampler(){
 	};
 
 	Global::Device->CreateSamplerState(&SamplerStateTexture, &Global::SimpleSampler);
+}
+
+// Same order as MeshEntity's reset, rotate, scale and translate, the result is transposed for the shaders
+DirectX::XMMATRIX ComposeWorldMatrix(const DirectX::XMFLOAT3 &axis, float angle, const DirectX::XMFLOAT3 &scale, const DirectX::XMFLOAT3 &translation){
+	DirectX::XMMATRIX world = DirectX::XMMatrixTranspose(DirectX::XMMatrixRotationAxis(DirectX::XMLoadFloat3(&axis), angle * DirectX::XM_PI / 180));
 
-	return (ret == 2);
+	world = DirectX::XMMatrixMultiply(world, DirectX::XMMatrixScaling(scale.x, scale.y, scale.z));
+	world = DirectX::XMMatrixMultiply(world, DirectX::XMMatrixTranslation(translation.x, translation.y, translation.z));
+
+	return DirectX::XMMatrixTranspose(world);
+}
+
+Id CreateSceneEntity(const MeshEntity &mesh, const OccluderMesh *occluder, bool castShadows, const DirectX::XMMATRIX &world){
+	ComponentMask mask = ComponentMaskOf<TransformComponent, BoundsComponent, MeshComponent, MaterialComponent>::get();
+
+	if(occluder) mask |= ComponentType<OccluderComponent>::mask();
+	if(castShadows) mask |= ComponentType<ShadowComponent>::mask();
+
+	Id id = g_world.create(mask);
+
+	DirectX::XMStoreFloat4x4(&g_world.get<TransformComponent>(id)->world, world);
+
+	BoundsComponent *bounds = g_world.get<BoundsComponent>(id);
+	bounds->min = mesh.getBoundsMin();
+	bounds->max = mesh.getBoundsMax();
+
+	g_world.get<MeshComponent>(id)->mesh = &mesh;
+
+	// Everything shares the chief's textures for now
+	MaterialComponent *material = g_world.get<MaterialComponent>(id);
+	material->diffuse	= g_diffuseTexture;
+	material->normal	= g_normalTexture;
+
+	if(occluder) g_world.get<OccluderComponent>(id)->occluder = occluder;
+	if(castShadows) g_world.get<ShadowComponent>(id)->flags = ShadowCast;
+
+	return id;
+}
+
+void CreateScene(){
+	DirectX::XMFLOAT3 axis(-1, 0, 0);
+
+	// The sphere follows the light, UpdateTransforms moves it every frame
+	g_chiefEntity	= CreateSceneEntity(g_masterChief, &g_chiefOccluder, true, ComposeWorldMatrix(axis, 90, DirectX::XMFLOAT3(1, 1, 1), DirectX::XMFLOAT3(0, 0, 0)));
+	g_sphereEntity	= CreateSceneEntity(g_sphere, nullptr, false, ComposeWorldMatrix(axis, 0, DirectX::XMFLOAT3(1, 1, 1), DirectX::XMFLOAT3(0, 0, 0)));
+	g_planeEntity	= CreateSceneEntity(g_plane, &g_planeOccluder, false, ComposeWorldMatrix(axis, 90, DirectX::XMFLOAT3(100, 100, 100), DirectX::XMFLOAT3(0, 50, 0)));
+}
+
+// Lights spiral out from the chief at a few heights, colors cycle around the spiral
+void CreatePointLights(){
+	const float GoldenAngle = 2.39996f;
+
+	g_pointLights.resize(Global::NumPointLights);
+
+	for(uint32_t i = 0; i < Global::NumPointLights; i++){
+		PointLight &light = g_pointLights[i];
+		float angle = i * GoldenAngle;
+		float distance = 4.0f + 36.0f * sqrtf(static_cast<float>(i) / Global::NumPointLights);
+
+		light.position	= DirectX::XMFLOAT3(cosf(angle) * distance, 2.0f + (i % 5) * 3.0f, sinf(angle) * distance);
+		light.radius	= 6.0f + (i % 3) * 3.0f;
+		light.color		= DirectX::XMFLOAT3(0.5f + 0.5f * cosf(angle), 0.5f + 0.5f * cosf(angle + 2.094f), 0.5f + 0.5f * cosf(angle + 4.189f));
+		light.padding	= 0.0f;
+	}
+}
+
+// Spot lights ring the chief from above and lean in towards it
+void CreateSpotLights(){
+	const float TwoPi = 6.28319f;
+
+	g_spotLights.resize(Global::NumSpotLights);
+
+	for(uint32_t i = 0; i < Global::NumSpotLights; i++){
+		SpotLight &light = g_spotLights[i];
+		float angle = i * TwoPi / Global::NumSpotLights;
+		float cone = 0.35f + (i % 4) * 0.05f;
+
+		DirectX::XMFLOAT3 position(cosf(angle) * 20.0f, 18.0f, sinf(angle) * 20.0f);
+		DirectX::XMVECTOR direction = DirectX::XMVector3Normalize(DirectX::XMVectorSet(-position.x * 0.5f, -position.y, -position.z * 0.5f, 0.0f));
+
+		light.position	= position;
+		light.radius	= 40.0f;
+		light.cosAngle	= cosf(cone);
+		light.sinAngle	= sinf(cone);
+		light.color		= DirectX::XMFLOAT3(0.5f + 0.5f * sinf(angle), 0.5f + 0.5f * sinf(angle + 2.094f), 0.5f + 0.5f * sinf(angle + 4.189f));
+
+		DirectX::XMStoreFloat3(&light.direction, direction);
+	}
+}
+
+// Reloads run their asset's loader again on the job system's workers and swap the result in behind the
+// pointer or handle the frame reads, the old resource is kept when loading fails
+bool ReloadVertexShader(const std::wstring &path, ID3D11VertexShader **shader, ID3D11InputLayout **layout){
+	ID3D11VertexShader *loaded = nullptr;
+	ID3D11InputLayout *loadedLayout = nullptr;
+	int numShaders = 0, numLayouts = 0;
+
+	{
+		AssetLoader loader(*g_jobSystem);
+
+		LoadVertexShader(loader, path, &loaded, &loadedLayout, numShaders, numLayouts);
+		loader.finalize();
+	}
+
+	if(numShaders != 1 || numLayouts != 1){
+		ReleaseCOM(loaded);
+		return false;
+	}
+
+	// Layouts belong to the cache
+	ReleaseCOM(*shader);
+
+	*shader	= loaded;
+	*layout	= loadedLayout;
+
+	return true;
+}
+
+bool ReloadPixelShader(const std::wstring &path, ID3D11PixelShader **shader){
+	ID3D11PixelShader *loaded = nullptr;
+	int numShaders = 0;
+
+	{
+		AssetLoader loader(*g_jobSystem);
+
+		LoadPixelShader(loader, path, &loaded, numShaders);
+		loader.finalize();
+	}
+
+	if(numShaders != 1){
+		ReleaseCOM(loaded);
+		return false;
+	}
+
+	ReleaseCOM(*shader);
+	*shader = loaded;
+
+	return true;
+}
+
+bool ReloadComputeShader(const std::wstring &path, ID3D11ComputeShader **shader){
+	ID3D11ComputeShader *loaded = nullptr;
+	int numShaders = 0;
+
+	{
+		AssetLoader loader(*g_jobSystem);
+
+		LoadComputeShader(loader, path, &loaded, numShaders);
+		loader.finalize();
+	}
+
+	if(numShaders != 1){
+		ReleaseCOM(loaded);
+		return false;
+	}
+
+	ReleaseCOM(*shader);
+	*shader = loaded;
+
+	return true;
+}
+
+bool ReloadMaterialShaders(){
+	std::vector<ID3D11PixelShader *> variants;
+	int numShaders = 0;
+
+	// Every permutation is rebuilt, so they compile in parallel
+	{
+		AssetLoader loader(*g_jobSystem);
+
+		LoadPixelShaderVariants(loader, g_materialPermutations, variants, numShaders);
+		loader.finalize();
+	}
+
+	// A variant that failed leaves the others unused, the whole set is swapped or none of it
+	if(numShaders == 1) variants.swap(g_materialPSVariants);
+
+	for(auto &variant : variants){
+		ReleaseCOM(variant);
+	}
+
+	return numShaders == 1;
+}
+
+bool ReloadMesh(const std::wstring &path, MeshEntity &entity, OccluderMesh *occluder){
+	MeshEntity loaded;
+	OccluderMesh loadedOccluder;
+	int numMeshes = 0;
+
+	{
+		AssetLoader loader(*g_jobSystem);
+
+		LoadMesh(loader, path, loaded, occluder ? &loadedOccluder : nullptr, numMeshes);
+		loader.finalize();
+	}
+
+	if(numMeshes != 1) return false;
+
+	// Updates in flight read the bounds and occluders, they are dropped and run again with the new ones.
+	// Draw lists only point at the entity and the buffers are read on this thread
+	g_framePipeline->flush();
+
+	entity.swap(loaded);
+
+	if(occluder) *occluder = std::move(loadedOccluder);
+
+	std::vector<EntityWorld::Chunk> chunks;
+	g_world.getChunks(ComponentMaskOf<BoundsComponent, MeshComponent>::get(), 0, chunks);
+
+	for(const auto &chunk : chunks){
+		BoundsComponent *bounds = chunk.get<BoundsComponent>();
+		const MeshComponent *meshes = chunk.get<MeshComponent>();
+
+		for(uint32_t i = 0; i < chunk.size(); i++){
+			if(meshes[i].mesh != &entity) continue;
+
+			bounds[i].min = entity.getBoundsMin();
+			bounds[i].max = entity.getBoundsMax();
+		}
+	}
+
+	return true;
+}
+
+bool ReloadTexture(const std::wstring &path, StreamedTextureHandle handle){
+	MappedFile file;
+	PreparedTexture prepared;
+
+	return file.open(path) && g_textureStreamer->prepare(path, file.getData(), file.getSize(), prepared) &&
+		g_textureStreamer->reload(handle, prepared, file.getData(), file.getSize());
+}
+
+void WatchAssets(){
+	g_hotReloader = new HotReloader();
+
+	g_hotReloader->watch(L"..\\Engine");
+	g_hotReloader->watch(L"..\\..\\Models");
+	g_hotReloader->watch(L"..\\..\\Textures");
+
+	g_hotReloader->add(L"..\\Engine\\Material_VS.hlsl", [](const std::wstring &path){
+		return ReloadVertexShader(path, &g_materialVS, &g_materialVertLayout);
+	});
+	g_hotReloader->add(L"..\\Engine\\Shadow_VS.hlsl", [](const std::wstring &path){
+		if(!ReloadVertexShader(path, &g_shadowVS, &g_shadowVertLayout)) return false;
+
+		g_shadowMapper->setShader(g_shadowVS, g_shadowVertLayout);
+		return true;
+	});
+	g_hotReloader->add(L"..\\Engine\\Passthru_VS.hlsl", [](const std::wstring &path){
+		return ReloadVertexShader(path, &g_passthruVS, &g_passthruVertLayout);
+	});
+	g_hotReloader->add(L"..\\Engine\\Material_PS.hlsl", [](const std::wstring &){
+		return ReloadMaterialShaders();
+	});
+	g_hotReloader->add(L"..\\Engine\\TexToQuad_PS.hlsl", [](const std::wstring &path){
+		return ReloadPixelShader(path, &g_texToQuadPS);
+	});
+	g_hotReloader->add(L"..\\Engine\\LightCulling_CS.hlsl", [](const std::wstring &path){
+		if(!ReloadComputeShader(path, &g_lightCullingCS)) return false;
+
+		g_lightCuller->setShader(g_lightCullingCS);
+		return true;
+	});
+
+	g_hotReloader->add(L"..\\..\\Models\\chief.box", [](const std::wstring &path){
+		return ReloadMesh(path, g_masterChief, &g_chiefOccluder);
+	});
+	g_hotReloader->add(L"..\\..\\Models\\crate.box", [](const std::wstring &path){
+		return ReloadMesh(path, g_crate, nullptr);
+	});
+	g_hotReloader->add(L"..\\..\\Models\\sphere.box", [](const std::wstring &path){
+		return ReloadMesh(path, g_sphere, nullptr);
+	});
+
+	// Packed textures are read from the archive, editing the loose file changes nothing
+	const uint8_t *packed;
+	size_t packedSize;
+
+	if(!g_texturePack.find(L"..\\..\\Textures\\chief_techsuit_d.DDS", &packed, &packedSize)){
+		g_hotReloader->add(L"..\\..\\Textures\\chief_techsuit_d.DDS", [](const std::wstring &path){
+			return ReloadTexture(path, g_diffuseTexture);
+		});
+	}
+
+	if(!g_texturePack.find(L"..\\..\\Textures\\chief_techsuit_n.DDS", &packed, &packedSize)){
+		g_hotReloader->add(L"..\\..\\Textures\\chief_techsuit_n.DDS", [](const std::wstring &path){
+			return ReloadTexture(path, g_normalTexture);
+		});
+	}
 }
 
 void SetResources(){
-	if(!LoadShaders()){
+	int numShaders = 0, numLayouts = 0, numEntities = 0, numTextures = 0;
+
+	// Vertex shaders with the same input signature share one layout
+	g_layoutCache = new InputLayoutCache(Global::Device);
+	g_uploadManager = new UploadManager(Global::Device, Global::DeviceContext, Global::UploadRingSize);
+	g_meshBuffers = new D3D11MeshBufferBackend(Global::Device, g_uploadManager);
+
+	// Everything is queued up front so file reads, decoding and shader reflection overlap,
+	// device resources are then created in batches on this thread as the jobs finish
+	{
+		uint32_t numCores = std::max<uint32_t>(2, std::thread::hardware_concurrency());
+		AssetLoader loader(2, numCores - 1);
+
+		LoadShaders(loader, numShaders, numLayouts);
+		LoadEntities(loader, numEntities);
+		LoadTexturesAndSampler(loader, numTextures);
+
+		loader.finalize();
+	}
+
+	if(numShaders != 6){
 		MessageBox(0, L"Error loading shaders", L"Error", 0);
 		exit(-1);
 	}
 
-	if(!LoadLayouts()){
+	if(numLayouts != 3){
 		MessageBox(0, L"Error loading vertex layouts from shaders", L"Error", 0);
 		exit(-1);
 	}
 
-	if(!LoadEntities()){
+	if(numEntities != 5){
 		MessageBox(0, L"Error loading geometry from files", L"Error", 0);
 		exit(-1);
 	}
 
-	if(!LoadTexturesAndSampler()){
+	if(numTextures != 2){
 		MessageBox(0, L"Error loading textures", L"Error", 0);
 		exit(-1);
 	}
 
 	// Setup the material shader's constant buffer
-	Util::CreateConstantBuffer(Global::Device, sizeof(MaterialConstantBufferData), &g_materialConstantBuffer, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+	{
+		GpuMemoryTag tag(L"Material constants");
+		Util::CreateConstantBuffer(Global::Device, sizeof(MaterialConstantBufferData), &g_materialConstantBuffer, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+	}
 	g_materialCbData.world = DirectX::XMMatrixIdentity();
 
 	// Setup cameras
@@ -186,11 +772,45 @@ void SetResources(){
 
 	Global::UserCamera.setPos(DirectX::XMFLOAT3(0, 0, 0));
 
-	// Setup mode for toggling
-	g_materialCbData.mode = DirectX::XMVectorSet(0, 0, 0, 0);
+	// Start with the default lighting model
+	g_materialMask = 0;
 
 	// Setup shadow-mapping
 	g_shadowMapper = new ShadowMapper(Global::Device, Global::Width, Global::Height, g_shadowVS, g_shadowVertLayout);
+
+	if(!g_shadowMapper->isValid()){
+		MessageBox(0, L"Error creating the shadow map", L"Error", 0);
+		exit(-1);
+	}
+
+	// Setup occlusion culling
+	g_occlusionCuller = new OcclusionCuller(Global::OcclusionWidth, Global::OcclusionHeight);
+
+	// Setup light culling, each frame in flight bins into its own lists when the CPU culls
+	g_lightCuller = new LightCuller(Global::Device, Global::Width, Global::Height, Global::MaxPointLights, Global::LightIndexCapacity);
+	g_lightCuller->setShader(g_lightCullingCS);
+
+	for(auto &frame : g_frames){
+		frame.lightBinner = new LightBinner(Global::Width, Global::Height, Global::LightIndexCapacity);
+	}
+
+	CreatePointLights();
+	g_lightCuller->setLights(Global::DeviceContext, &g_pointLights[0], static_cast<uint32_t>(g_pointLights.size()));
+
+	// Clustered lights are assigned on the CPU, the update spreads each frame's slices over the job system
+	g_lightClusters = new LightClusterLists(Global::Device, Global::MaxSpotLights, Global::LightIndexCapacity);
+
+	for(auto &frame : g_frames){
+		frame.lightClusterer = new LightClusterer(g_jobSystem, Global::LightIndexCapacity);
+	}
+
+	CreateSpotLights();
+	g_lightClusters->setSpotLights(Global::DeviceContext, &g_spotLights[0], static_cast<uint32_t>(g_spotLights.size()));
+
+	// Meshes and texture handles are ready, build the scene from them
+	CreateScene();
+
+	WatchAssets();
 }
 
 void HandleKeyInput(uint32_t vKey){
@@ -199,11 +819,27 @@ void HandleKeyInput(uint32_t vKey){
 		case 'S': Global::UserCamera.moveBackward(Global::CameraMoveSpeed);	break;
 		case 'A': Global::UserCamera.moveLeft(Global::CameraMoveSpeed);		break;
 		case 'D': Global::UserCamera.moveRight(Global::CameraMoveSpeed);	break;
-		case 'Z': g_materialCbData.mode = DirectX::XMVectorSet(0, 0, 0, 0);			break;
-		case 'X': g_materialCbData.mode = DirectX::XMVectorSet(1, 1, 1, 1);			break;
-		case 'C': g_materialCbData.mode = DirectX::XMVectorSet(2, 2, 2, 2);			break;
-		case 'V': g_materialCbData.mode = DirectX::XMVectorSet(3, 3, 3, 3);			break;
-		case 'B': g_materialCbData.mode = DirectX::XMVectorSet(4, 4, 4, 4);			break;
+		case 'Z': g_materialMask = g_materialPermutations.setKeyword(g_materialMask, "COOK_TORRANCE_1");	break;
+		case 'X': g_materialMask = g_materialPermutations.setKeyword(g_materialMask, "COOK_TORRANCE_2");	break;
+		case 'C': g_materialMask = g_materialPermutations.setKeyword(g_materialMask, "COOK_TORRANCE_3");	break;
+		case 'V': g_materialMask = g_materialPermutations.setKeyword(g_materialMask, "COOK_TORRANCE_4");	break;
+		case 'B': g_materialMask = g_materialPermutations.setKeyword(g_materialMask, "NO_LIGHTING");		break;
+		case 'L': g_cpuLightCulling = !g_cpuLightCulling;	break;
+		case 'K':
+			g_clusteredLights = !g_clusteredLights;
+			g_materialMask = g_materialPermutations.setKeyword(g_materialMask, g_clusteredLights ? "CLUSTERED_LIGHTS" : "TILED_LIGHTS");
+			break;
+
+		// Toggles a capture, the trace is written when it stops
+		case 'P':
+			if(!Profiler::isCapturing()){
+				Profiler::beginCapture();
+			}
+			else{
+				Profiler::endCapture();
+				Profiler::writeChromeTrace(L"..\\Profile.json");
+			}
+			break;
 	}
 }
 
@@ -218,33 +854,199 @@ void HandleMouseMove(uint32_t rButton, uint16_t newXPos, uint16_t newYPos){
 	oldYPos = newYPos;
 }
 
-void GenerateShadowMap(){
+float EstimateScreenSize(const BoundsComponent &bounds, const TransformComponent &transform, const Camera &camera){
+
+	// Bounding sphere of the entity in world space
+	DirectX::XMMATRIX world = DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&transform.world));
+	DirectX::XMVECTOR boundsMin = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&bounds.min), world);
+	DirectX::XMVECTOR boundsMax = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&bounds.max), world);
+
+	DirectX::XMVECTOR center = DirectX::XMVectorScale(DirectX::XMVectorAdd(boundsMin, boundsMax), 0.5f);
+	float radius = 0.5f * DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(boundsMax, boundsMin)));
+	float distance = std::max(DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(center, camera.getPos()))), 0.001f);
+
+	// Projected diameter in pixels for the 45 degree vertical field of view the cameras use
+	return Global::Height * radius / (distance * tanf(DirectX::XM_PIDIV4 * 0.5f));
+}
+
+void GenerateShadowMap(const FrameData &frame){
+	PROFILE_ZONE("GenerateShadowMap");
 
 	// Send only position (float4), adjust offset to make up for difference
 	//UINT stride = sizeof(float) * 4, offset = sizeof(float) * 8;
 	UINT stride = g_masterChief.getVertexSize(), offset = 0;
 	
-	g_shadowMapper->startShadowRender(Global::DeviceContext, g_lightCamera);
+	g_shadowMapper->startShadowRender(Global::DeviceContext, frame.lightCamera);
 
-	// Prepare shadow caster
-	ID3D11Buffer *vertexBuffer = g_masterChief.getVertexBuffer();
-	ID3D11Buffer *indexBuffer = g_masterChief.getIndexBuffer();
+	// Render each shadow caster
+	for(uint32_t i = 0; i < frame.shadowList.numItems; i++){
+		const DrawItem &item = frame.shadowList.items[i];
+		ID3D11Buffer *vertexBuffer = item.entity->getVertexBuffer();
 
-	// Transform
-	DirectX::XMFLOAT3 axis(-1, 0, 0);
+		g_shadowMapper->setWorldMatrix(Global::DeviceContext, DirectX::XMLoadFloat4x4(&item.world));
+
+		// Attach buffers and render
+		Global::DeviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		Global::DeviceContext->IASetIndexBuffer(item.entity->getIndexBuffer(), DXGI_FORMAT_R32_UINT, offset);
+		Global::DeviceContext->DrawIndexed(item.entity->getNumIndices(), 0, 0);
+	}
+}
+
+void UpdateLight(FrameData &frame){
+	const float LightSpeed = .75f;
+	DirectX::XMFLOAT3 lightOrigin(0, 60, -15), lightProtrusion(70, 0, 70);
+	float time = frame.time;
 	
-	g_masterChief.reset();
-	g_masterChief.rotate(axis, 90);
+	// Update light(s)
+	frame.lightCamera.setPos(
+		DirectX::XMFLOAT3(
+			cos(time * LightSpeed) * sin(time * LightSpeed) * lightProtrusion.x + lightOrigin.x,
+			cos(time * LightSpeed) * lightProtrusion.y + lightOrigin.y,
+			sin(time * LightSpeed) * sin(time * LightSpeed) * lightProtrusion.z + lightOrigin.z
+		)
+	);
 
-	g_shadowMapper->setWorldMatrix(Global::DeviceContext, g_masterChief.getWorldMatrix());
+	// Calculate new light camera target (flip position)
+	auto vector = DirectX::XMVector3Normalize(DirectX::XMVectorNegate(frame.lightCamera.getPos()));
+	DirectX::XMFLOAT3 target;
 
-	// Attach buffers and render
-	Global::DeviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-	Global::DeviceContext->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, offset);
-	Global::DeviceContext->DrawIndexed(g_masterChief.getNumIndices(), 0, 0);
+	DirectX::XMStoreFloat3(&target, vector);
+
+	frame.lightCamera.setTarget(target);
+}
+
+void UpdateTransforms(const FrameData &frame){
+	PROFILE_ZONE("UpdateTransforms");
+
+	// Everything else is static, only the sphere follows the light
+	DirectX::XMFLOAT3 translation;
+	DirectX::XMStoreFloat3(&translation, frame.lightCamera.getPos());
+
+	TransformComponent *transform = g_world.get<TransformComponent>(g_sphereEntity);
+
+	if(transform){
+		DirectX::XMStoreFloat4x4(&transform->world, ComposeWorldMatrix(DirectX::XMFLOAT3(-1, 0, 0), 0, DirectX::XMFLOAT3(1, 1, 1), translation));
+	}
+}
+
+// Falls back to the heap when the frame's memory is full, nothing may drop out of a list
+DrawItem *AllocateDrawItems(LinearAllocator &memory, uint32_t count, std::vector<DrawItem> &overflow){
+	DrawItem *items = memory.allocateArray<DrawItem>(count);
+
+	if(items) return items;
+
+	g_numDrawListOverflows++;
+	overflow.resize(count);
+
+	return overflow.data();
+}
+
+void BuildDrawList(FrameData &frame){
+	PROFILE_ZONE("BuildDrawList");
+
+	// Rasterize occluders on the CPU, world matrices are stored transposed for the shaders
+	g_occlusionCuller->beginFrame(frame.userCamera);
+	g_world.getChunks(ComponentMaskOf<TransformComponent, OccluderComponent>::get(), 0, g_extractChunks);
+
+	for(const auto &chunk : g_extractChunks){
+		const TransformComponent *transforms = chunk.get<TransformComponent>();
+		const OccluderComponent *occluders = chunk.get<OccluderComponent>();
+
+		for(uint32_t i = 0; i < chunk.size(); i++){
+			g_occlusionCuller->renderOccluder(*occluders[i].occluder, DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&transforms[i].world)));
+		}
+	}
+
+	g_occlusionCuller->endFrame();
+
+	// Shadow casters aren't culled against the user camera, size the list for every candidate
+	g_world.getChunks(ComponentMaskOf<TransformComponent, MeshComponent, ShadowComponent>::get(), 0, g_extractChunks);
+
+	uint32_t numCandidates = 0;
+
+	for(const auto &chunk : g_extractChunks){
+		numCandidates += chunk.size();
+	}
+
+	frame.shadowList.items = AllocateDrawItems(*frame.memory, numCandidates, frame.shadowOverflow);
+	frame.shadowList.numItems = 0;
+
+	for(const auto &chunk : g_extractChunks){
+		const TransformComponent *transforms = chunk.get<TransformComponent>();
+		const MeshComponent *meshes = chunk.get<MeshComponent>();
+		const ShadowComponent *shadows = chunk.get<ShadowComponent>();
+
+		for(uint32_t i = 0; i < chunk.size(); i++){
+			if(!(shadows[i].flags & ShadowCast)) continue;
+
+			DrawItem item = {meshes[i].mesh, transforms[i].world, TextureStreamer::InvalidHandle, TextureStreamer::InvalidHandle};
+			frame.shadowList.items[frame.shadowList.numItems++] = item;
+		}
+	}
+
+	// Cull every chunk on its own job, the occlusion buffer is only read from here on
+	g_world.getChunks(ComponentMaskOf<TransformComponent, BoundsComponent, MeshComponent, MaterialComponent>::get(), 0, g_extractChunks);
+	g_extractDrawLists.resize(g_extractChunks.size());
+	g_extractOverflow.resize(g_extractChunks.size());
+
+	LinearAllocator *memory = frame.memory;
+
+	g_jobSystem->parallelFor(g_extractChunks.size(), 1, [memory](size_t begin, size_t end){
+		for(size_t c = begin; c < end; c++){
+			const EntityWorld::Chunk &chunk = g_extractChunks[c];
+			const TransformComponent *transforms = chunk.get<TransformComponent>();
+			const BoundsComponent *bounds = chunk.get<BoundsComponent>();
+			const MeshComponent *meshes = chunk.get<MeshComponent>();
+			const MaterialComponent *materials = chunk.get<MaterialComponent>();
+			DrawList &drawList = g_extractDrawLists[c];
+
+			// Room for the whole chunk
+			drawList.items = AllocateDrawItems(*memory, chunk.size(), g_extractOverflow[c]);
+			drawList.numItems = 0;
+
+			for(uint32_t i = 0; i < chunk.size(); i++){
+
+				// Skip anything hidden behind the occluders
+				if(!g_occlusionCuller->isVisible(bounds[i].min, bounds[i].max, DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&transforms[i].world)))){
+					continue;
+				}
+
+				DrawItem item = {meshes[i].mesh, transforms[i].world, materials[i].diffuse, materials[i].normal};
+				drawList.items[drawList.numItems++] = item;
+			}
+		}
+	});
+
+	// Merge in chunk order so the draw order doesn't depend on scheduling
+	uint32_t numVisible = 0;
+
+	for(const auto &drawList : g_extractDrawLists){
+		numVisible += drawList.numItems;
+	}
+
+	frame.drawList.items = AllocateDrawItems(*frame.memory, numVisible, frame.drawOverflow);
+	frame.drawList.numItems = 0;
+
+	for(const auto &drawList : g_extractDrawLists){
+		if(drawList.numItems == 0) continue;
+
+		memcpy(frame.drawList.items + frame.drawList.numItems, drawList.items, drawList.numItems * sizeof(DrawItem));
+		frame.drawList.numItems += drawList.numItems;
+	}
+
+	uint32_t numOverflows = g_numDrawListOverflows.exchange(0);
+
+	if(numOverflows > 0){
+		char message[128];
+
+		sprintf_s(message, "Frame memory full, %u draw lists moved to the heap\n", numOverflows);
+		OutputDebugStringA(message);
+	}
 }
 
-void RenderScene(){
+void RenderScene(const FrameData &frame){
+	PROFILE_ZONE("RenderScene");
+
 	float clearColor[] = {.3f, .5f, 1.0f, 1.0f};
 	auto shadowTextureView = g_shadowMapper->getShadowTextureView();
 
@@ -261,12 +1063,12 @@ void RenderScene(){
 
 	// Bind material vertex/pixel shaders
 	Global::DeviceContext->VSSetShader(g_materialVS, 0, 0);
-	Global::DeviceContext->PSSetShader(g_materialPS, 0, 0);
+	Global::DeviceContext->PSSetShader(g_materialPSVariants[frame.materialMask], 0, 0);
 
-	// Bind textures
-	Global::DeviceContext->PSSetShaderResources(0, 1, &g_diffuseTextureView);
-	Global::DeviceContext->PSSetShaderResources(1, 1, &g_normalTextureView);
+	// Bind shadow map and the light lists, material textures are bound per item
 	Global::DeviceContext->PSSetShaderResources(2, 1, &shadowTextureView);
+	g_lightCuller->bind(Global::DeviceContext, 3);
+	g_lightClusters->bind(Global::DeviceContext, 6);
 
 	// Bind texture-sampler
 	Global::DeviceContext->PSSetSamplers(0, 1, &Global::SimpleSampler);
@@ -276,42 +1078,33 @@ void RenderScene(){
 	Global::DeviceContext->PSSetConstantBuffers(0, 1, &g_materialConstantBuffer);
 
 	// Fill constant buffer
-	g_materialCbData.viewProj = Global::UserCamera.getProjMatrix() * Global::UserCamera.getViewMatrix();
-	g_materialCbData.lightView = g_lightCamera.getProjMatrix() * g_lightCamera.getViewMatrix();
-	g_materialCbData.cameraDir = DirectX::XMVectorNegate(Global::UserCamera.getTarget());
-	g_materialCbData.lightDir = g_lightCamera.getPos();
-
-	// Render each object in a loop
-	DirectX::XMFLOAT3 axis(-1, 0, 0);
-	float rotations[] = {90, 0, 90};
-	DirectX::XMFLOAT3 scales[] = {DirectX::XMFLOAT3(1, 1, 1), DirectX::XMFLOAT3(1, 1, 1), DirectX::XMFLOAT3(100, 100, 100)};
-	DirectX::XMFLOAT3 translations[] = {DirectX::XMFLOAT3(0, 0, 0), DirectX::XMFLOAT3(0, 0, 0), DirectX::XMFLOAT3(0, 50, 0)};
-
-	MeshEntity *entities[] = {&g_masterChief, &g_sphere, &g_plane};
-
-	ID3D11Buffer *vertexBuffers[] = {entities[0]->getVertexBuffer(), entities[1]->getVertexBuffer(), entities[2]->getVertexBuffer()};
-	ID3D11Buffer *indexBuffers[] = {entities[0]->getIndexBuffer(), entities[1]->getIndexBuffer(), entities[2]->getIndexBuffer()};
+	g_materialCbData.viewProj = frame.userCamera.getViewProjMatrix();
+	g_materialCbData.lightView = frame.lightCamera.getViewProjMatrix();
+	g_materialCbData.cameraDir = DirectX::XMVectorNegate(frame.userCamera.getTarget());
+	g_materialCbData.lightDir = frame.lightCamera.getPos();
+	g_materialCbData.numTiles = DirectX::XMUINT2(g_lightCuller->getNumTilesX(), g_lightCuller->getNumTilesY());
+	g_materialCbData.clusterScale = DirectX::XMFLOAT2(static_cast<float>(LightClusterer::NumColumns) / Global::Width, static_cast<float>(LightClusterer::NumRows) / Global::Height);
+	g_materialCbData.clusterDepth = frame.lightClusterer->getSliceParams();
+
+	// Render each visible object in a loop
 	UINT stride = g_masterChief.getVertexSize(), offset = 0;
 
-	// Add in the sphere translation
-	DirectX::XMStoreFloat3(&translations[1], g_lightCamera.getPos());
+	for(uint32_t i = 0; i < frame.drawList.numItems; i++){
+		const DrawItem &item = frame.drawList.items[i];
+		ID3D11Buffer *vertexBuffer = item.entity->getVertexBuffer();
 
-	for(int i = 0; i < 3; i++){
+		ID3D11ShaderResourceView *textureViews[] = {g_textureStreamer->getView(item.diffuse), g_textureStreamer->getView(item.normal)};
 
-		// Transform
-		entities[i]->reset();
-		entities[i]->rotate(axis, rotations[i]);
-		entities[i]->scale(scales[i]);
-		entities[i]->translate(translations[i]);
+		Global::DeviceContext->PSSetShaderResources(0, 2, textureViews);
 
-		g_materialCbData.world = entities[i]->getWorldMatrix();
+		g_materialCbData.world = DirectX::XMLoadFloat4x4(&item.world);
 
 		UpdateConstantBuffer();
 
 		// Attach buffers and render
-		Global::DeviceContext->IASetVertexBuffers(0, 1, &vertexBuffers[i], &stride, &offset);
-		Global::DeviceContext->IASetIndexBuffer(entities[i]->getIndexBuffer(), DXGI_FORMAT_R32_UINT, offset);
-		Global::DeviceContext->DrawIndexed(entities[i]->getNumIndices(), 0, 0);
+		Global::DeviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		Global::DeviceContext->IASetIndexBuffer(item.entity->getIndexBuffer(), DXGI_FORMAT_R32_UINT, offset);
+		Global::DeviceContext->DrawIndexed(item.entity->getNumIndices(), 0, 0);
 	}
 }
 
@@ -340,42 +1133,197 @@ void RenderFromTexture(){
 	Global::DeviceContext->DrawIndexed(g_quad.getNumIndices(), 0, 0);
 }
 
-void Render(){
-	const float LightSpeed = .75f;
-	DirectX::XMFLOAT3 lightOrigin(0, 60, -15), lightProtrusion(70, 0, 70);
-	float time = (float)Global::GameTimer.getDeltaTime(g_timeStart, g_timeCurrent);
-	
-	// Update light(s)
-	g_lightCamera.setPos(
-		DirectX::XMFLOAT3(
-			cos(time * LightSpeed) * sin(time * LightSpeed) * lightProtrusion.x + lightOrigin.x,
-			cos(time * LightSpeed) * lightProtrusion.y + lightOrigin.y,
-			sin(time * LightSpeed) * sin(time * LightSpeed) * lightProtrusion.z + lightOrigin.z
-		)
-	);
+// Main thread, copies everything the update reads that input handling may change
+void SnapshotFrame(uint32_t slot, uint64_t){
+	FrameData &frame = g_frames[slot];
+
+	frame.time = (float)Global::GameTimer.getDeltaTime(g_timeStart, g_timeCurrent);
+	frame.memory = &g_frameAllocator->beginFrame(slot);
+	frame.userCamera = Global::UserCamera;
+	frame.lightCamera = g_lightCamera;
+	frame.cpuLightCulling = g_cpuLightCulling;
+	frame.clusteredLights = g_clusteredLights;
+	frame.materialMask = g_materialMask;
+}
 
-	// Calculate new light camera target (flip position)
-	auto vector = DirectX::XMVector3Normalize(DirectX::XMVectorNegate(g_lightCamera.getPos()));
-	DirectX::XMFLOAT3 target;
+// Job, runs while the previous frame is being submitted
+void UpdateFrame(uint32_t slot, uint64_t){
+	FrameData &frame = g_frames[slot];
 
-	DirectX::XMStoreFloat3(&target, vector);
+	UpdateLight(frame);
+
+	// Refresh cached camera matrices once for the frame
+	Camera *cameras[] = {&frame.userCamera, &frame.lightCamera};
 
-	g_lightCamera.setTarget(target);
+	UpdateCameras(cameras, 2);
 
-	GenerateShadowMap();
-	RenderScene();
-	//RenderFromTexture();
+	UpdateTransforms(frame);
+	BuildDrawList(frame);
+
+	if(frame.clusteredLights){
+		PROFILE_ZONE("LightClusterer::assign");
+		frame.lightClusterer->assign(GetLightBinView(frame.userCamera), &g_pointLights[0], static_cast<uint32_t>(g_pointLights.size()), &g_spotLights[0],
+			static_cast<uint32_t>(g_spotLights.size()));
+	}
+	else if(frame.cpuLightCulling){
+		PROFILE_ZONE("LightBinner::bin");
+		frame.lightBinner->bin(GetLightBinView(frame.userCamera), &g_pointLights[0], static_cast<uint32_t>(g_pointLights.size()));
+	}
+
+	frame.chiefScreenSize = EstimateScreenSize(*g_world.get<BoundsComponent>(g_chiefEntity), *g_world.get<TransformComponent>(g_chiefEntity), frame.userCamera);
+}
+
+// Main thread, only reads the frame's slot
+void SubmitFrame(uint32_t slot, uint64_t){
+	const FrameData &frame = g_frames[slot];
+
+	// Light lists built on the CPU ride along with the other uploads
+	if(frame.clusteredLights) g_lightClusters->upload(*g_uploadManager, *frame.lightClusterer);
+	else if(frame.cpuLightCulling) g_lightCuller->upload(*g_uploadManager, *frame.lightBinner);
+
+	// Buffer updates queued since the last frame land before anything is drawn
+	{
+		PROFILE_ZONE("UploadManager::submit");
+		g_uploadManager->submit();
+	}
+
+	g_gpuProfiler->beginFrame();
+
+	{
+		GPU_PROFILE_ZONE(*g_gpuProfiler, "Frame (GPU)");
+
+		{
+			GPU_PROFILE_ZONE(*g_gpuProfiler, "GenerateShadowMap (GPU)");
+			GenerateShadowMap(frame);
+		}
+
+		if(!frame.clusteredLights && !frame.cpuLightCulling){
+			GPU_PROFILE_ZONE(*g_gpuProfiler, "LightCulling (GPU)");
+			g_lightCuller->cull(Global::DeviceContext, frame.userCamera);
+		}
+
+		{
+			GPU_PROFILE_ZONE(*g_gpuProfiler, "RenderScene (GPU)");
+			RenderScene(frame);
+		}
+
+		//RenderFromTexture();
+	}
+
+	g_gpuProfiler->endFrame();
+
+	// Mip feedback for the chief's textures, then stream in or evict
+	g_textureStreamer->requestDetail(g_diffuseTexture, frame.chiefScreenSize);
+	g_textureStreamer->requestDetail(g_normalTexture, frame.chiefScreenSize);
+
+	PROFILE_ZONE("TextureStreamer::update");
+	g_textureStreamer->update();
+}
+
+// Decodes every mesh under directory through a null backend, nothing touches a device
+bool WriteMeshUsageReport(const std::wstring &directory, const std::wstring &path){
+	NullMeshBufferBackend backend;
+	std::vector<std::wstring> files;
+	std::vector<uint8_t> data;
+	bool ret = true;
+
+	Util::FindFiles(directory, L"*.box", files);
+	std::sort(files.begin(), files.end());
+
+	for(const auto &file : files){
+		BoxMesh mesh;
+		MeshEntity entity;
+
+		if(!Util::ReadFileToMemory(directory + L"\\" + file, data) || !DecodeMeshFromMemory(data.data(), data.size(), mesh) || mesh.numVertices == 0 ||
+			mesh.numIndices == 0){
+
+			ret = false;
+			continue;
+		}
+
+		ret &= LoadMeshFromFile(backend, file, mesh.usage, mesh.vertices, mesh.indices, mesh.numVertices, mesh.numIndices, sizeof(BoxVertex), entity);
+	}
+
+	std::string report = backend.formatReport();
+	OutputDebugStringA(report.c_str());
+
+	return Util::WriteMemoryToFile(path, report.data(), report.size()) && ret;
+}
+
+// Tool modes, the engine exits right after running them
+//   Engine.exe -pack <texture directory> <archive>		builds a texture pack
+//   Engine.exe -scan <texture directory> <manifest>	writes the header metadata of every texture
+//   Engine.exe -usage <mesh directory> <report>		writes the buffer usage every mesh would get
+//   Engine.exe -setusage <mesh> <static|streamed|dynamic>	sets the usage policy in a mesh's metadata
+//   Engine.exe -mips <source dds> <destination dds>	writes a copy of a single-mip texture with its full mip chain
+bool RunToolCommand(int &exitCode){
+	int numArgs = 0;
+	LPWSTR *args = CommandLineToArgvW(GetCommandLineW(), &numArgs);
+
+	if(!args) return false;
+
+	bool isTool = numArgs == 4;
+
+	if(isTool && lstrcmpiW(args[1], L"-pack") == 0){
+		exitCode = BuildTexturePack(args[2], args[3]) ? 0 : 1;
+	}
+	else if(isTool && lstrcmpiW(args[1], L"-scan") == 0){
+		std::vector<TextureManifestEntry> entries;
+		TextureScanStats stats;
+
+		ScanTextureDirectory(args[2], entries, stats);
+
+		char report[256];
+		sprintf_s(report, "Scanned %Iu textures (%Iu failed) in %.3f s, %.0f files/s\n", stats.numFiles, stats.numFailed, stats.seconds, stats.filesPerSecond);
+		OutputDebugStringA(report);
+
+		exitCode = WriteTextureManifest(args[3], entries) && stats.numFailed == 0 ? 0 : 1;
+	}
+	else if(isTool && lstrcmpiW(args[1], L"-usage") == 0){
+		exitCode = WriteMeshUsageReport(args[2], args[3]) ? 0 : 1;
+	}
+	else if(isTool && lstrcmpiW(args[1], L"-setusage") == 0){
+		MeshUsage usage;
+
+		exitCode = ParseMeshUsage(args[3], usage) && WriteMeshUsage(args[2], usage) ? 0 : 1;
+	}
+	else if(isTool && lstrcmpiW(args[1], L"-mips") == 0){
+		// Same chain the texture pack builds for loose single-mip files
+		exitCode = MipGenerator::GenerateDDSMipsToFile(args[2], args[3], MipGenerator::MipOptions()) ? 0 : 1;
+	}
+	else{
+		isTool = false;
+	}
+
+	LocalFree(args);
+
+	return isTool;
 }
 
 int WINAPI WinMain(HINSTANCE instance, HINSTANCE prevInstance, LPSTR cmdLine, int numCmdShow){
+	int exitCode;
+
+	if(RunToolCommand(exitCode)) return exitCode;
+
 	CoInitialize(NULL);
 
 	Util::D3DInitData data = {instance, L"Wnd", L"DX_Wnd", Global::Width, Global::Height, 1};
 
+	// Resources over budget fail to create, the texture streamer keeps itself well under it
+	GetGpuMemoryTracker().setTotalBudget(Global::GpuMemoryBudget);
+
 	CreateDX11Wnd(data, &Global::WndHandle, &Global::Device, &Global::SwapChain, &Global::DeviceContext, &Global::BackBufferView, &Global::DepthView);
 
+	// The job system's main thread is this one, device calls stay here
+	Profiler::setThreadName("Main");
+	g_jobSystem = new JobSystem();
+	g_frameAllocator = new FrameAllocator("Frame", Global::FrameMemorySize, FramePipeline::MaxLatency);
+
 	SetResources();
 
+	g_gpuProfiler = new GpuProfiler(Global::Device, Global::DeviceContext);
+	g_framePipeline = new FramePipeline(*g_jobSystem, Global::FrameLatency, SnapshotFrame, UpdateFrame, SubmitFrame);
+
 	MSG msg;
 
 	Global::GameTimer.createTimeStamp(g_timeStart);
@@ -398,9 +1346,62 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE prevInstance, LPSTR cmdLine, in
 
 		Global::GameTimer.createTimeStamp(g_timeCurrent);
 
-		Render();
+		g_framePipeline->runFrame();
+
+		// Device work queued by jobs
+		g_jobSystem->runMainThreadJobs();
+
+		// Edited assets are swapped in between frames
+		{
+			PROFILE_ZONE("HotReloader::update");
+			g_hotReloader->update();
+		}
+
+		{
+			PROFILE_ZONE("Present");
+			Global::SwapChain->Present(0, 0);
+		}
+
+		Profiler::endFrame();
+
+		GpuMemoryTracker &gpuMemory = GetGpuMemoryTracker();
+		GpuMemoryStats gpuMemoryStats;
+
+		gpuMemory.endFrame();
+		gpuMemory.getStats(gpuMemoryStats);
+
+		if(gpuMemoryStats.frame % Global::GpuMemoryDumpInterval == 0) OutputDebugStringA(gpuMemory.formatStats().c_str());
+	}
+
+	g_framePipeline->flush();
+
+	const FramePipelineStats &stats = g_framePipeline->getStats();
+
+	char report[256];
+	sprintf_s(report, "%llu frames at latency %u: %.3f ms average (%.3f - %.3f), %.3f ms snapshot to submit, %.1f fps\n",
+		stats.numFrames, g_framePipeline->getLatency(), stats.averageFrameTime * 1000, stats.minFrameTime * 1000, stats.maxFrameTime * 1000,
+		stats.averageLatency * 1000, stats.framesPerSecond);
+	OutputDebugStringA(report);
+	OutputDebugStringA(Profiler::formatStats().c_str());
+	OutputDebugStringA(TrackedAllocator::formatStats().c_str());
+	OutputDebugStringA(GetGpuMemoryTracker().formatStats().c_str());
+	OutputDebugStringA(g_meshBuffers->formatReport().c_str());
+	OutputDebugStringA(g_uploadManager->formatStats().c_str());
+	OutputDebugStringA(g_hotReloader->formatStats().c_str());
+
+	// Only there when the CPU culled the lights at some point
+	for(const auto &frame : g_frames){
+		if(!frame.lightBinner || frame.lightBinner->getStats().numLights == 0) continue;
+
+		OutputDebugStringA(frame.lightBinner->formatStats().c_str());
+		break;
+	}
+
+	for(const auto &frame : g_frames){
+		if(!frame.lightClusterer || frame.lightClusterer->getStats().numPointLights == 0) continue;
 
-		Global::SwapChain->Present(0, 0);
+		OutputDebugStringA(frame.lightClusterer->formatStats().c_str());
+		break;
 	}
 
 	return 0;
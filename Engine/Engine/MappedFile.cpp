@@ -0,0 +1,62 @@
+#include "Engine.h"
+
+MappedFile::MappedFile(){
+	m_data = nullptr;
+	m_size = 0;
+}
+
+MappedFile::~MappedFile(){
+	close();
+}
+
+bool MappedFile::open(const std::wstring &path){
+	close();
+
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+
+	if(!GetFileSizeEx(file, &size) || size.QuadPart < 0 || static_cast<uint64_t>(size.QuadPart) > SIZE_MAX){
+		CloseHandle(file);
+		return false;
+	}
+
+	// Mappings of empty files fail, there is nothing to map anyway
+	if(size.QuadPart == 0){
+		CloseHandle(file);
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	// The view keeps the mapping alive once both handles are closed
+	if(mapping){
+		m_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		CloseHandle(mapping);
+	}
+
+	CloseHandle(file);
+
+	if(!m_data) return false;
+
+	m_size = static_cast<size_t>(size.QuadPart);
+
+	return true;
+}
+
+void MappedFile::close(){
+	if(m_data) UnmapViewOfFile(m_data);
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+const uint8_t *MappedFile::getData() const{
+	return m_data;
+}
+
+size_t MappedFile::getSize() const{
+	return m_size;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+///////////////////////
+// Mapped file class //
+///////////////////////
+
+// Read-only view of a whole file. Pages are read in as they are first touched, so parsing a mapped file
+// needs no copy and no allocation
+class MappedFile{
+private:
+	const uint8_t *m_data;
+	size_t m_size;
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	// Empty files open with a null view, files that don't fit the address space fail
+	bool open(const std::wstring &path);
+	void close();
+
+	const uint8_t *getData() const;
+	size_t getSize() const;
+};
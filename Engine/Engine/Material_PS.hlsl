@@ -4,9 +4,35 @@ cbuffer ConstantBuffer : register (b0){
 	matrix LightView;
 	float3 LightDir;
 	float3 CameraDir;
-	float3 Mode;
+	uint2 NumTiles;
+	float2 ClusterScale;
+	float2 ClusterDepth;
 }
 
+// Matches LightCulling_CS.hlsl
+#define TILE_SIZE 16
+
+// Matches LightClusterer
+#define CLUSTER_COLUMNS	16
+#define CLUSTER_ROWS	8
+#define CLUSTER_SLICES	24
+
+struct PointLight{
+	float3 position;
+	float radius;
+	float3 color;
+	float padding;
+};
+
+struct SpotLight{
+	float3 position;
+	float radius;
+	float3 direction;
+	float cosAngle;
+	float3 color;
+	float sinAngle;
+};
+
 SamplerState TextureSampler{
 	Filter		= MIN_MAG_MIP_LINEAR;
 	AddressU	= Wrap;
@@ -17,6 +43,16 @@ Texture2D DiffuseTexture	: register(t0);
 Texture2D NormalTexture		: register(t1);
 Texture2D ShadowMap			: register(t2);
 
+// Point lights and the lists of the ones touching each screen tile
+StructuredBuffer<PointLight> Lights		: register(t3);
+StructuredBuffer<uint> LightIndices		: register(t4);
+StructuredBuffer<uint2> TileLights		: register(t5);
+
+// Froxel clusters, their index list and the spot lights, read instead of the tiles with CLUSTERED_LIGHTS
+StructuredBuffer<uint2> Clusters			: register(t6);
+StructuredBuffer<uint> ClusterIndices		: register(t7);
+StructuredBuffer<SpotLight> SpotLights		: register(t8);
+
 struct InputPixel{
 	float4 position : SV_POSITION;
 	float3 normal	: NORMAL;
@@ -24,6 +60,7 @@ struct InputPixel{
 	float3 tangent	: TANGENT0;
 	float3 lightDir : TEXCOORD1;
 	float4 lpos		: TEXCOORD2;
+	float3 worldPos	: TEXCOORD3;
 };
 
 float3 SampleNormalMap(float3 N, float3 T, float2 uv){
@@ -245,6 +282,60 @@ float4 CookTorrance4(float3 normal, float3 light, float4 diffuse, float3 lightCo
     return float4( final, 1.0f );
 }
 
+// Diffuse light from one light, falling off to nothing at its radius
+float3 ShadeLight(float3 position, float radius, float3 lightColor, float3 worldPos, float3 N, float4 diffuse){
+	float3 L = position - worldPos;
+	float distance = length(L);
+	float attenuation = saturate(1.0f - distance / radius);
+
+	return lightColor * diffuse.rgb * saturate(dot(N, L / max(distance, 0.0001f))) * attenuation * attenuation;
+}
+
+// Every point light in the pixel's tile
+float3 ShadeTileLights(float2 pixel, float3 worldPos, float3 N, float4 diffuse){
+	uint2 tile = uint2(pixel) / TILE_SIZE;
+	uint2 range = TileLights[tile.y * NumTiles.x + tile.x];
+	float3 color = float3(0, 0, 0);
+
+	for(uint i = 0; i < range.y; i++){
+		PointLight light = Lights[LightIndices[range.x + i]];
+
+		color += ShadeLight(light.position, light.radius, light.color, worldPos, N, diffuse);
+	}
+
+	return color;
+}
+
+// Every point and spot light in the pixel's cluster, the slice comes from the log of the view depth
+float3 ShadeClusterLights(float2 pixel, float depth, float3 worldPos, float3 N, float4 diffuse){
+	uint slice = uint(clamp(log(depth) * ClusterDepth.x + ClusterDepth.y, 0, CLUSTER_SLICES - 1));
+	uint2 cell = min(uint2(pixel * ClusterScale), uint2(CLUSTER_COLUMNS - 1, CLUSTER_ROWS - 1));
+	uint2 cluster = Clusters[(slice * CLUSTER_ROWS + cell.y) * CLUSTER_COLUMNS + cell.x];
+
+	// Point lights come first, the counts share the second half
+	uint numPointLights = cluster.y & 0xFFFF;
+	uint numSpotLights = cluster.y >> 16;
+	float3 color = float3(0, 0, 0);
+
+	for(uint i = 0; i < numPointLights; i++){
+		PointLight light = Lights[ClusterIndices[cluster.x + i]];
+
+		color += ShadeLight(light.position, light.radius, light.color, worldPos, N, diffuse);
+	}
+
+	for(uint j = 0; j < numSpotLights; j++){
+		SpotLight light = SpotLights[ClusterIndices[cluster.x + numPointLights + j]];
+
+		// Softened over the outer tenth of the cone
+		float cosine = dot(normalize(worldPos - light.position), light.direction);
+		float cone = smoothstep(light.cosAngle, lerp(light.cosAngle, 1.0f, 0.1f), cosine);
+
+		color += cone * ShadeLight(light.position, light.radius, light.color, worldPos, N, diffuse);
+	}
+
+	return color;
+}
+
 float4 P_Shader(InputPixel input) : SV_TARGET
 {
 	float4 diffuse = DiffuseTexture.Sample(TextureSampler, input.texUV);
@@ -255,6 +346,8 @@ float4 P_Shader(InputPixel input) : SV_TARGET
 	projectTexCoord.x = 0.5f + (input.lpos.x / input.lpos.w * 0.5f);
 	projectTexCoord.y = 0.5f - (input.lpos.y / input.lpos.w * 0.5f);
 	float pixelDepth = input.lpos.z / input.lpos.w;
+	float4 color = float4(0, 0, 0, 1);
+
 	if((saturate(projectTexCoord.x) == projectTexCoord.x) && (saturate(projectTexCoord.y) == projectTexCoord.y) &&
 		(pixelDepth > 0)){
 
@@ -270,16 +363,31 @@ float4 P_Shader(InputPixel input) : SV_TARGET
 
 	// Compare the depth of the shadow map value and the depth of the light to determine whether to shadow or to light this pixel.
 	// If the light is in front of the object then light the pixel, if not then shadow this pixel since an object (occluder) is casting a shadow on it.
-	if(lightDepthValue >= depthValue) return float4(0, 0, 0, 1);
+	if(lightDepthValue < depthValue){
 
 	//return SolidColor(float3(1, 0, 1));
-	if (Mode.x == 0.0f) return CookTorrance(normal, input.lightDir, diffuse, float3(1, 1, 1), .13, .6);
-	if (Mode.x == 1.0f) return CookTorrance2(normal, input.lightDir, diffuse, float3(1, 1, 1), 0.23, .1);
-	if (Mode.x == 2.0f) return CookTorrance3(normal, input.lightDir, diffuse, float3(1, 1, 1), 0.23, .1);
-	if (Mode.x == 3.0f) return CookTorrance4(normal, input.lightDir, diffuse, float3(1, 1, 1), 0.3, 1);
+	// Lighting model permutations, COOK_TORRANCE_1 is the default
+	#if defined(COOK_TORRANCE_2)
+	color = CookTorrance2(normal, input.lightDir, diffuse, float3(1, 1, 1), 0.23, .1);
+	#elif defined(COOK_TORRANCE_3)
+	color = CookTorrance3(normal, input.lightDir, diffuse, float3(1, 1, 1), 0.23, .1);
+	#elif defined(COOK_TORRANCE_4)
+	color = CookTorrance4(normal, input.lightDir, diffuse, float3(1, 1, 1), 0.3, 1);
+	#elif !defined(NO_LIGHTING)
+	color = CookTorrance(normal, input.lightDir, diffuse, float3(1, 1, 1), .13, .6);
+	#endif
 	//return diffuse;
 
 	//return BlinnPhong(normalize(input.normal), diffuse, float3(1, 1, 1), input.lightDir);
 	}
-	return float4(0, 0, 0, 1);
+	}
+
+	// Point and spot lights aren't shadowed
+	#if defined(CLUSTERED_LIGHTS) && !defined(NO_LIGHTING)
+	color.rgb += ShadeClusterLights(input.position.xy, input.position.w, input.worldPos, normal, diffuse);
+	#elif !defined(NO_LIGHTING)
+	color.rgb += ShadeTileLights(input.position.xy, input.worldPos, normal, diffuse);
+	#endif
+
+	return color;
 }
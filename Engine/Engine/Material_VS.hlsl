@@ -4,7 +4,9 @@ cbuffer ConstantBuffer : register (b0){
 	matrix LightView;
 	float3 LightDir;
 	float3 CameraDir;
-	float3 Mode;
+	uint2 NumTiles;
+	float2 ClusterScale;
+	float2 ClusterDepth;
 }
 
 struct InputVertex{
@@ -21,6 +23,7 @@ struct OutputVertex{
 	float3 tangent	: TANGENT0;
 	float3 lightDir : TEXCOORD1;
 	float4 lpos		: TEXCOORD2;
+	float3 worldPos	: TEXCOORD3;
 };
 
 OutputVertex V_Shader(InputVertex input){
@@ -37,6 +40,7 @@ OutputVertex V_Shader(InputVertex input){
 	output.texUV = input.texUV;
 
 	float4 worldPos = mul(input.pos, World);
+	output.worldPos = worldPos.xyz;
 	output.lightDir = LightDir.xyz - worldPos.xyz;
 	output.lightDir = normalize(output.lightDir);
 
@@ -0,0 +1,120 @@
+#include "Engine.h"
+
+MeshBufferUsage GetMeshBufferUsage(MeshUsage usage){
+	MeshBufferUsage bufferUsage = {D3D11_USAGE_IMMUTABLE, static_cast<D3D11_CPU_ACCESS_FLAG>(0)};
+
+	// Streamed meshes are updated by copying into them, only dynamic ones are written by the CPU
+	if(usage == MeshUsageStreamed){
+		bufferUsage.usage		= D3D11_USAGE_DEFAULT;
+	}
+	else if(usage == MeshUsageDynamic){
+		bufferUsage.usage		= D3D11_USAGE_DYNAMIC;
+		bufferUsage.cpuAccess	= D3D11_CPU_ACCESS_WRITE;
+	}
+
+	return bufferUsage;
+}
+
+const char *GetMeshUsageName(MeshUsage usage){
+	static const char *names[] = {"Static", "Streamed", "Dynamic"};
+
+	return usage < MeshUsageCount ? names[usage] : "Unknown";
+}
+
+const char *GetBufferUsageName(D3D11_USAGE usage){
+	switch(usage){
+	case D3D11_USAGE_DEFAULT:	return "Default";
+	case D3D11_USAGE_IMMUTABLE:	return "Immutable";
+	case D3D11_USAGE_DYNAMIC:	return "Dynamic";
+	case D3D11_USAGE_STAGING:	return "Staging";
+	}
+
+	return "Unknown";
+}
+
+bool ParseMeshUsage(const std::wstring &name, MeshUsage &usage){
+	static const wchar_t *names[] = {L"static", L"streamed", L"dynamic"};
+
+	for(uint32_t i = 0; i < MeshUsageCount; i++){
+		if(lstrcmpiW(name.c_str(), names[i]) == 0){
+			usage = static_cast<MeshUsage>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool MeshBufferBackend::create(const std::wstring &name, MeshUsage usage, const Util::VertexBufferCreationData &data,
+	ID3D11Buffer **vertexBuffer, ID3D11Buffer **indexBuffer){
+
+	MeshBufferRecord record;
+
+	record.name			= name;
+	record.usage		= usage < MeshUsageCount ? usage : MeshUsageStatic;
+	record.bufferUsage	= GetMeshBufferUsage(record.usage);
+	record.vertexBytes	= data.numVertices * data.vertexElementSize;
+	record.indexBytes	= data.numIndices * sizeof(uint32_t);
+
+	*vertexBuffer	= nullptr;
+	*indexBuffer	= nullptr;
+
+	record.created = createBuffers(data, record.bufferUsage, vertexBuffer, indexBuffer);
+	m_records.push_back(record);
+
+	return record.created;
+}
+
+const std::vector<MeshBufferRecord> &MeshBufferBackend::getRecords() const{
+	return m_records;
+}
+
+std::string MeshBufferBackend::formatReport() const{
+	std::string text;
+	char line[512];
+
+	sprintf_s(line, "%-40s %-10s %-10s %12s %12s\n", "Mesh", "Policy", "Usage", "Vertex KB", "Index KB");
+	text += line;
+
+	for(const auto &record : m_records){
+		sprintf_s(line, "%-40ls %-10s %-10s %12.1f %12.1f%s\n", record.name.c_str(), GetMeshUsageName(record.usage),
+			GetBufferUsageName(record.bufferUsage.usage), record.vertexBytes / 1024.0, record.indexBytes / 1024.0, record.created ? "" : " failed");
+		text += line;
+	}
+
+	return text;
+}
+
+D3D11MeshBufferBackend::D3D11MeshBufferBackend(ID3D11Device *device, UploadManager *uploads) : m_device(device), m_uploads(uploads){
+
+}
+
+bool D3D11MeshBufferBackend::createBuffers(const Util::VertexBufferCreationData &data, const MeshBufferUsage &usage,
+	ID3D11Buffer **vertexBuffer, ID3D11Buffer **indexBuffer){
+
+	// Immutable buffers can only get their contents at creation
+	if(usage.usage == D3D11_USAGE_IMMUTABLE && (!data.vertexData || !data.indexData)) return false;
+
+	if(usage.usage != D3D11_USAGE_DEFAULT || !m_uploads){
+		return Util::CreateVertexIndexBuffer(m_device, data, vertexBuffer, indexBuffer, usage.usage, usage.cpuAccess);
+	}
+
+	// Created empty, the contents are copied in with the next submit like any later update
+	Util::VertexBufferCreationData empty = data;
+
+	empty.vertexData	= nullptr;
+	empty.indexData		= nullptr;
+
+	if(!Util::CreateVertexIndexBuffer(m_device, empty, vertexBuffer, indexBuffer, usage.usage, usage.cpuAccess)) return false;
+
+	m_uploads->upload(*vertexBuffer, 0, data.vertexData, data.numVertices * data.vertexElementSize);
+	m_uploads->upload(*indexBuffer, 0, data.indexData, data.numIndices * sizeof(uint32_t));
+
+	return true;
+}
+
+bool NullMeshBufferBackend::createBuffers(const Util::VertexBufferCreationData &data, const MeshBufferUsage &usage,
+	ID3D11Buffer **vertexBuffer, ID3D11Buffer **indexBuffer){
+
+	return data.numVertices > 0 && data.numIndices > 0;
+}
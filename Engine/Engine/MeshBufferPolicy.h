@@ -0,0 +1,82 @@
+#pragma once
+
+//////////////////////////////
+// Mesh buffer usage policy //
+//////////////////////////////
+
+// How a mesh changes after it's loaded, kept per asset in the .BOX metadata
+enum MeshUsage{
+	MeshUsageStatic,		// Never changes, immutable buffers
+	MeshUsageStreamed,		// Replaced through copies now and then, default buffers
+	MeshUsageDynamic,		// Rewritten by the CPU, dynamic buffers
+	MeshUsageCount
+};
+
+struct MeshBufferUsage{
+	D3D11_USAGE usage;
+	D3D11_CPU_ACCESS_FLAG cpuAccess;
+};
+
+MeshBufferUsage GetMeshBufferUsage(MeshUsage usage);
+
+const char *GetMeshUsageName(MeshUsage usage);
+const char *GetBufferUsageName(D3D11_USAGE usage);
+
+// Case insensitive, false if name isn't static, streamed or dynamic
+bool ParseMeshUsage(const std::wstring &name, MeshUsage &usage);
+
+struct MeshBufferRecord{
+	std::wstring name;
+
+	MeshUsage usage;
+	MeshBufferUsage bufferUsage;
+
+	uint32_t vertexBytes, indexBytes;
+	bool created;
+};
+
+// Creates the buffers of a mesh with the usage the policy picks and records every decision. Main thread only
+class MeshBufferBackend{
+private:
+	std::vector<MeshBufferRecord> m_records;
+
+	MeshBufferBackend(const MeshBufferBackend &) = delete;
+	MeshBufferBackend &operator=(const MeshBufferBackend &) = delete;
+
+protected:
+	virtual bool createBuffers(const Util::VertexBufferCreationData &data, const MeshBufferUsage &usage, ID3D11Buffer **vertexBuffer,
+		ID3D11Buffer **indexBuffer) = 0;
+
+public:
+	MeshBufferBackend(){}
+	virtual ~MeshBufferBackend(){}
+
+	bool create(const std::wstring &name, MeshUsage usage, const Util::VertexBufferCreationData &data, ID3D11Buffer **vertexBuffer,
+		ID3D11Buffer **indexBuffer);
+
+	const std::vector<MeshBufferRecord> &getRecords() const;
+
+	// One line per mesh: name, policy, D3D11 usage and buffer sizes
+	std::string formatReport() const;
+};
+
+// Streamed meshes get their contents through the upload manager when there is one
+class D3D11MeshBufferBackend : public MeshBufferBackend{
+private:
+	ID3D11Device *m_device;
+	UploadManager *m_uploads;
+
+protected:
+	bool createBuffers(const Util::VertexBufferCreationData &data, const MeshBufferUsage &usage, ID3D11Buffer **vertexBuffer,
+		ID3D11Buffer **indexBuffer);
+
+public:
+	D3D11MeshBufferBackend(ID3D11Device *device, UploadManager *uploads = nullptr);
+};
+
+// Creates nothing and leaves the buffers null, for tools that only need to know what each mesh would get
+class NullMeshBufferBackend : public MeshBufferBackend{
+protected:
+	bool createBuffers(const Util::VertexBufferCreationData &data, const MeshBufferUsage &usage, ID3D11Buffer **vertexBuffer,
+		ID3D11Buffer **indexBuffer);
+};
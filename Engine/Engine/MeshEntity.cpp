@@ -6,6 +6,9 @@ MeshEntity::MeshEntity(){
 	m_numVertices	= 0;
 	m_numIndices	= 0;
 	m_vertexSize	= 0;
+	m_usage			= MeshUsageStatic;
+	m_boundsMin		= DirectX::XMFLOAT3(0, 0, 0);
+	m_boundsMax		= DirectX::XMFLOAT3(0, 0, 0);
 	m_world			= DirectX::XMMatrixIdentity();
 }
 
@@ -60,6 +63,18 @@ uint32_t MeshEntity::getVertexSize() const{
 	return m_vertexSize;
 }
 
+MeshUsage MeshEntity::getUsage() const{
+	return m_usage;
+}
+
+const DirectX::XMFLOAT3 &MeshEntity::getBoundsMin() const{
+	return m_boundsMin;
+}
+
+const DirectX::XMFLOAT3 &MeshEntity::getBoundsMax() const{
+	return m_boundsMax;
+}
+
 ID3D11Buffer *MeshEntity::getVertexBuffer() const{
 	return m_vertexBuffer;
 }
@@ -81,6 +96,9 @@ MeshEntity &MeshEntity::operator=(MeshEntity &entity){
 	m_numVertices	= entity.m_numVertices;
 	m_numIndices	= entity.m_numIndices;
 	m_vertexSize	= entity.m_vertexSize;
+	m_usage			= entity.m_usage;
+	m_boundsMin		= entity.m_boundsMin;
+	m_boundsMax		= entity.m_boundsMax;
 	
 	m_world			= entity.m_world;
 
@@ -91,7 +109,19 @@ MeshEntity &MeshEntity::operator=(MeshEntity &entity){
 	return *this;
 }
 
-bool LoadMeshFromFile(ID3D11Device *device, const std::wstring &path, MeshEntity &entity){
+void MeshEntity::swap(MeshEntity &entity){
+	std::swap(m_vertexBuffer, entity.m_vertexBuffer);
+	std::swap(m_indexBuffer, entity.m_indexBuffer);
+
+	std::swap(m_numVertices, entity.m_numVertices);
+	std::swap(m_numIndices, entity.m_numIndices);
+	std::swap(m_vertexSize, entity.m_vertexSize);
+	std::swap(m_usage, entity.m_usage);
+	std::swap(m_boundsMin, entity.m_boundsMin);
+	std::swap(m_boundsMax, entity.m_boundsMax);
+}
+
+bool LoadMeshFromFile(MeshBufferBackend &backend, const std::wstring &path, MeshEntity &entity){
 	entity.m_vertexSize	= sizeof(BoxVertex);
 
 	// Open up the model
@@ -112,42 +142,134 @@ bool LoadMeshFromFile(ID3D11Device *device, const std::wstring &path, MeshEntity
 	vertexBufferSize		= entity.m_numVertices * entity.m_vertexSize;
 	indexBufferSize			= header.numIndices * sizeof(uint32_t);
 
-	// Allocate buffers
-	void *vertices		= new uint8_t[vertexBufferSize]();
-	uint32_t *indices	= new uint32_t[header.numIndices]();
+	// Allocate buffers, they only live until the GPU-side copies exist
+	ScratchScope scratch;
+	uint8_t *vertices	= scratch.allocateArray<uint8_t>(vertexBufferSize);
+	uint32_t *indices	= scratch.allocateArray<uint32_t>(header.numIndices);
+
+	if(!vertices || !indices){
+		CloseHandle(file);
+		return false;
+	}
+
+	memset(vertices, 0, vertexBufferSize);
+	memset(indices, 0, indexBufferSize);
 
 	// Read in vertices first, then indices
 	ReadFile(file, vertices, vertexBufferSize, &bytesRead, NULL);
 	ReadFile(file, indices, indexBufferSize, &bytesRead, NULL);
 
+	// The usage policy comes last, older files don't have one
+	BoxMetadata metadata;
+
+	entity.m_usage = MeshUsageStatic;
+
+	if(ReadFile(file, &metadata, sizeof(BoxMetadata), &bytesRead, NULL) && bytesRead == sizeof(BoxMetadata) &&
+		metadata.magic == BoxMetadataMagic && metadata.usage < MeshUsageCount){
+
+		entity.m_usage = static_cast<MeshUsage>(metadata.usage);
+	}
+
+	ComputeMeshBounds(vertices, entity.m_numVertices, entity.m_vertexSize, entity);
+
 	// Create GPU-side buffers
 	bool ret = true;
 	Util::VertexBufferCreationData data = {vertices, indices, entity.m_numVertices, entity.m_numIndices, entity.m_vertexSize};
 
-	if(FAILED(Util::CreateVertexIndexBuffer(device, data, &entity.m_vertexBuffer, &entity.m_indexBuffer, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE))){
+	if(!backend.create(path, entity.m_usage, data, &entity.m_vertexBuffer, &entity.m_indexBuffer)){
 		ret = false;
 	}
 
 	// Clean up
-	delete[] vertices;
-	delete[] indices;
-
 	CloseHandle(file);
 	
 	return ret;
 }
 
-bool LoadMeshFromFile(ID3D11Device *device, void *vertices, uint32_t *indices, int32_t numVertices, int32_t numIndices,
-	int32_t vertexSize, MeshEntity &entity){
+bool LoadMeshFromFile(MeshBufferBackend &backend, const std::wstring &name, MeshUsage usage, const void *vertices, const uint32_t *indices,
+	int32_t numVertices, int32_t numIndices, int32_t vertexSize, MeshEntity &entity){
 
 	entity.m_vertexSize	= vertexSize;
+	entity.m_usage		= usage;
 
 	// Fill in some data
 	entity.m_numVertices	= numVertices;
 	entity.m_numIndices		= numIndices;
 
+	ComputeMeshBounds(vertices, entity.m_numVertices, entity.m_vertexSize, entity);
+
 	// Create GPU-side buffers
 	Util::VertexBufferCreationData data = {vertices, indices, entity.m_numVertices, entity.m_numIndices, entity.m_vertexSize};
 
-	return Util::CreateVertexIndexBuffer(device, data, &entity.m_vertexBuffer, &entity.m_indexBuffer, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
-}
\ No newline at end of file
+	return backend.create(name, usage, data, &entity.m_vertexBuffer, &entity.m_indexBuffer);
+}
+
+bool DecodeMeshFromMemory(const uint8_t *data, size_t size, BoxMesh &mesh){
+	if(size < sizeof(BoxHeader) || reinterpret_cast<uintptr_t>(data) % sizeof(uint32_t) != 0) return false;
+
+	BoxHeader header;
+	memcpy(&header, data, sizeof(BoxHeader));
+
+	if(header.numVertices < 0 || header.numIndices < 0) return false;
+
+	// Vertices come first, then indices
+	size_t vertexBufferSize	= static_cast<size_t>(header.numVertices) * sizeof(BoxVertex);
+	size_t indexBufferSize	= static_cast<size_t>(header.numIndices) * sizeof(uint32_t);
+
+	if(size < sizeof(BoxHeader) + vertexBufferSize + indexBufferSize) return false;
+
+	mesh.vertices		= reinterpret_cast<const BoxVertex *>(data + sizeof(BoxHeader));
+	mesh.indices		= reinterpret_cast<const uint32_t *>(data + sizeof(BoxHeader) + vertexBufferSize);
+	mesh.numVertices	= static_cast<uint32_t>(header.numVertices);
+	mesh.numIndices		= static_cast<uint32_t>(header.numIndices);
+
+	// Optional metadata trailer
+	size_t metadataOffset = sizeof(BoxHeader) + vertexBufferSize + indexBufferSize;
+	BoxMetadata metadata;
+
+	mesh.usage = MeshUsageStatic;
+
+	if(size >= metadataOffset + sizeof(BoxMetadata)){
+		memcpy(&metadata, data + metadataOffset, sizeof(BoxMetadata));
+
+		if(metadata.magic == BoxMetadataMagic && metadata.usage < MeshUsageCount) mesh.usage = static_cast<MeshUsage>(metadata.usage);
+	}
+
+	return true;
+}
+
+bool WriteMeshUsage(const std::wstring &path, MeshUsage usage){
+	std::vector<uint8_t> data;
+	BoxMesh mesh;
+
+	if(usage >= MeshUsageCount || !Util::ReadFileToMemory(path, data) || !DecodeMeshFromMemory(data.data(), data.size(), mesh)) return false;
+
+	// Drop whatever follows the indices and append the new trailer
+	BoxMetadata metadata = {BoxMetadataMagic, static_cast<uint32_t>(usage)};
+	size_t metadataOffset = sizeof(BoxHeader) + mesh.numVertices * sizeof(BoxVertex) + mesh.numIndices * sizeof(uint32_t);
+
+	data.resize(metadataOffset + sizeof(BoxMetadata));
+	memcpy(&data[metadataOffset], &metadata, sizeof(BoxMetadata));
+
+	return Util::WriteMemoryToFile(path, &data[0], data.size());
+}
+
+void ComputeMeshBounds(const void *vertices, uint32_t numVertices, uint32_t vertexSize, MeshEntity &entity){
+	if(numVertices == 0) return;
+
+	const uint8_t *vertex = static_cast<const uint8_t *>(vertices);
+	DirectX::XMVECTOR boundsMin = DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3 *>(vertex));
+	DirectX::XMVECTOR boundsMax = boundsMin;
+
+	for(uint32_t i = 1; i < numVertices; i++){
+		vertex += vertexSize;
+
+		DirectX::XMVECTOR pos = DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3 *>(vertex));
+
+		boundsMin = DirectX::XMVectorMin(boundsMin, pos);
+		boundsMax = DirectX::XMVectorMax(boundsMax, pos);
+	}
+
+	DirectX::XMStoreFloat3(&entity.m_boundsMin, boundsMin);
+	DirectX::XMStoreFloat3(&entity.m_boundsMax, boundsMax);
+}
@@ -12,10 +12,29 @@ struct BoxVertex{
 	float tanX, tanY, tanZ;
 };
 
+// Optional trailer after the indices, files without one are static
+struct BoxMetadata{
+	uint32_t magic;
+	uint32_t usage;
+};
+
+static const uint32_t BoxMetadataMagic = 0x4D584F42; // "BOXM"
+
+// CPU-side contents of a .BOX file, points into the data it was decoded from and is only valid as long as that
+struct BoxMesh{
+	const BoxVertex *vertices;
+	const uint32_t *indices;
+	uint32_t numVertices, numIndices;
+
+	MeshUsage usage;
+};
+
 class MeshEntity{
 private:
 	ID3D11Buffer *m_vertexBuffer, *m_indexBuffer;
 	uint32_t m_numVertices, m_numIndices, m_vertexSize;
+	MeshUsage m_usage;
+	DirectX::XMFLOAT3 m_boundsMin, m_boundsMax;
 	DirectX::XMMATRIX m_world;
 
 public:
@@ -36,6 +55,11 @@ public:
 	uint32_t getNumVertices() const;
 	uint32_t getNumIndices() const;
 	uint32_t getVertexSize() const;
+	MeshUsage getUsage() const;
+
+	// Object-space bounding box, taken from the vertex positions at load time
+	const DirectX::XMFLOAT3 &getBoundsMin() const;
+	const DirectX::XMFLOAT3 &getBoundsMax() const;
 
 	ID3D11Buffer *getVertexBuffer() const;
 	ID3D11Buffer *getIndexBuffer() const;
@@ -43,11 +67,26 @@ public:
 
 	MeshEntity & operator=(MeshEntity &entity);
 
-	friend bool LoadMeshFromFile(ID3D11Device *device, const std::wstring &path, MeshEntity &entity);
-	friend bool LoadMeshFromFile(ID3D11Device *device, void *vertices, uint32_t *indices, int32_t numVertices, int32_t numIndices,
-		int32_t vertexSize, MeshEntity &entity);
+	// Exchanges the buffers and everything describing them, the world matrix stays
+	void swap(MeshEntity &entity);
+
+	friend bool LoadMeshFromFile(MeshBufferBackend &backend, const std::wstring &path, MeshEntity &entity);
+	friend bool LoadMeshFromFile(MeshBufferBackend &backend, const std::wstring &name, MeshUsage usage, const void *vertices, const uint32_t *indices,
+		int32_t numVertices, int32_t numIndices, int32_t vertexSize, MeshEntity &entity);
+	friend void ComputeMeshBounds(const void *vertices, uint32_t numVertices, uint32_t vertexSize, MeshEntity &entity);
 };
 
-bool LoadMeshFromFile(ID3D11Device *device, const std::wstring &path, MeshEntity &entity);
-bool LoadMeshFromFile(ID3D11Device *device, void *vertices, uint32_t *indices, int32_t numVertices, int32_t numIndices, 
-	int32_t vertexSize, MeshEntity &entity);
+// The buffers get the usage the mesh's policy asks for, the name is what the backend reports them under
+bool LoadMeshFromFile(MeshBufferBackend &backend, const std::wstring &path, MeshEntity &entity);
+bool LoadMeshFromFile(MeshBufferBackend &backend, const std::wstring &name, MeshUsage usage, const void *vertices, const uint32_t *indices,
+	int32_t numVertices, int32_t numIndices, int32_t vertexSize, MeshEntity &entity);
+
+// Validates a .BOX file that was already read into memory without copying it, safe to call from any thread. The data
+// has to be 4 byte aligned, mapped files and file buffers are
+bool DecodeMeshFromMemory(const uint8_t *data, size_t size, BoxMesh &mesh);
+
+// Replaces the metadata trailer of a .BOX file
+bool WriteMeshUsage(const std::wstring &path, MeshUsage usage);
+
+// Computes the bounding box of the entity from vertices that start with a float3 position
+void ComputeMeshBounds(const void *vertices, uint32_t numVertices, uint32_t vertexSize, MeshEntity &entity);
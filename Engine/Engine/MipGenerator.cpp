@@ -0,0 +1,407 @@
+#include "Engine.h"
+
+namespace MipGenerator{
+
+namespace{
+
+// The Kaiser filter spans two destination texels either side of the center
+const float KaiserAlpha		= 4.0f;
+const float KaiserRadius	= 2.0f;
+
+// 8-bit sRGB to linear and back, built during static initialization so worker threads only ever read them
+struct SRGBTables{
+	float toLinear[256];
+	uint8_t toSRGB[4096];
+
+	SRGBTables(){
+		for(uint32_t i = 0; i < 256; i++){
+			float c = i / 255.0f;
+
+			toLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		for(uint32_t i = 0; i < 4096; i++){
+			float c = i / 4095.0f;
+			float s = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+
+			toSRGB[i] = static_cast<uint8_t>(s * 255.0f + 0.5f);
+		}
+	}
+};
+
+const SRGBTables SRGB;
+
+// Source texels and weights for each destination texel along one axis
+struct FilterTaps{
+	std::vector<uint32_t> start;
+	std::vector<uint32_t> indices;
+	std::vector<float> weights;
+};
+
+float Sinc(float x){
+	if(fabsf(x) < 1e-6f) return 1.0f;
+
+	x *= DirectX::XM_PI;
+
+	return sinf(x) / x;
+}
+
+// Zeroth order modified Bessel function of the first kind
+float BesselI0(float x){
+	float sum = 1.0f, term = 1.0f;
+
+	for(uint32_t k = 1; k < 32 && term > sum * 1e-8f; k++){
+		float half = x / (2.0f * k);
+
+		term	*= half * half;
+		sum		+= term;
+	}
+
+	return sum;
+}
+
+float Kaiser(float t){
+	if(fabsf(t) >= 1.0f) return 0.0f;
+
+	return BesselI0(KaiserAlpha * sqrtf(1.0f - t * t)) / BesselI0(KaiserAlpha);
+}
+
+void BuildTaps(size_t srcSize, size_t dstSize, MipFilter filter, FilterTaps &taps){
+	float scale		= static_cast<float>(srcSize) / dstSize;
+	float radius	= filter == FilterBox ? 0.5f * scale : KaiserRadius * scale;
+
+	taps.start.clear();
+	taps.indices.clear();
+	taps.weights.clear();
+
+	for(size_t dst = 0; dst < dstSize; dst++){
+		float center	= (dst + 0.5f) * scale;
+		int32_t first	= static_cast<int32_t>(floorf(center - radius));
+		int32_t last	= static_cast<int32_t>(ceilf(center + radius));
+		size_t start	= taps.weights.size();
+		float sum		= 0.0f;
+
+		taps.start.push_back(static_cast<uint32_t>(start));
+
+		for(int32_t src = first; src < last; src++){
+			float weight;
+
+			// Box weights are the overlap with the footprint, Kaiser is a windowed sinc in destination units
+			if(filter == FilterBox){
+				weight = std::min(src + 1.0f, center + radius) - std::max(static_cast<float>(src), center - radius);
+			}
+			else{
+				float x = (src + 0.5f - center) / scale;
+
+				weight = Sinc(x) * Kaiser(x / KaiserRadius);
+			}
+
+			if(weight == 0.0f || (filter == FilterBox && weight < 0.0f)) continue;
+
+			// Clamp to the edge
+			int32_t clamped = std::min(std::max(src, 0), static_cast<int32_t>(srcSize) - 1);
+
+			taps.indices.push_back(static_cast<uint32_t>(clamped));
+			taps.weights.push_back(weight);
+
+			sum += weight;
+		}
+
+		for(size_t i = start; i < taps.weights.size(); i++) taps.weights[i] /= sum;
+	}
+
+	taps.start.push_back(static_cast<uint32_t>(taps.weights.size()));
+}
+
+// Horizontal pass, one RGBA texel per register
+void FilterRows(const float *src, size_t srcWidth, size_t height, const FilterTaps &taps, size_t dstWidth, float *dst, uint32_t numThreads){
+	Util::ParallelRanges(height, numThreads, [&](size_t begin, size_t end){
+		for(size_t y = begin; y < end; y++){
+			const float *srcRow	= src + y * srcWidth * 4;
+			float *dstRow		= dst + y * dstWidth * 4;
+
+			for(size_t x = 0; x < dstWidth; x++){
+				__m128 sum = _mm_setzero_ps();
+
+				for(uint32_t i = taps.start[x]; i < taps.start[x + 1]; i++){
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(srcRow + taps.indices[i] * 4), _mm_set1_ps(taps.weights[i])));
+				}
+
+				_mm_storeu_ps(dstRow + x * 4, sum);
+			}
+		}
+	});
+}
+
+// Vertical pass, whole source rows are accumulated so memory is read in order
+void FilterColumns(const float *src, size_t width, const FilterTaps &taps, size_t dstHeight, float *dst, uint32_t numThreads){
+	Util::ParallelRanges(dstHeight, numThreads, [&](size_t begin, size_t end){
+		for(size_t y = begin; y < end; y++){
+			float *dstRow = dst + y * width * 4;
+
+			memset(dstRow, 0, width * 4 * sizeof(float));
+
+			for(uint32_t i = taps.start[y]; i < taps.start[y + 1]; i++){
+				const float *srcRow = src + taps.indices[i] * width * 4;
+				__m128 weight = _mm_set1_ps(taps.weights[i]);
+
+				for(size_t x = 0; x < width * 4; x += 4){
+					_mm_storeu_ps(dstRow + x, _mm_add_ps(_mm_loadu_ps(dstRow + x), _mm_mul_ps(_mm_loadu_ps(srcRow + x), weight)));
+				}
+			}
+		}
+	});
+}
+
+void ToLinear(const uint8_t *texels, size_t width, size_t height, size_t rowPitch, bool srgb, float *out, uint32_t numThreads){
+	Util::ParallelRanges(height, numThreads, [&](size_t begin, size_t end){
+		for(size_t y = begin; y < end; y++){
+			const uint8_t *row	= texels + y * rowPitch;
+			float *outRow		= out + y * width * 4;
+
+			for(size_t x = 0; x < width * 4; x += 4){
+				for(uint32_t c = 0; c < 3; c++){
+					outRow[x + c] = srgb ? SRGB.toLinear[row[x + c]] : row[x + c] / 255.0f;
+				}
+
+				outRow[x + 3] = row[x + 3] / 255.0f;
+			}
+		}
+	});
+}
+
+void FromLinear(const float *level, size_t width, size_t height, bool srgb, float alphaScale, uint8_t *texels, uint32_t numThreads){
+	Util::ParallelRanges(height, numThreads, [&](size_t begin, size_t end){
+		__m128 zero		= _mm_setzero_ps();
+		__m128 one		= _mm_set1_ps(1.0f);
+		__m128 scale	= _mm_setr_ps(1.0f, 1.0f, 1.0f, alphaScale);
+		__m128 toByte	= _mm_set1_ps(255.0f);
+		__m128 toIndex	= _mm_setr_ps(4095.0f, 4095.0f, 4095.0f, 255.0f);
+		__m128 half		= _mm_set1_ps(0.5f);
+
+		for(size_t y = begin; y < end; y++){
+			const float *row	= level + y * width * 4;
+			uint8_t *outRow		= texels + y * width * 4;
+
+			for(size_t x = 0; x < width; x++){
+				__m128 value = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(row + x * 4), scale), zero), one);
+
+				if(srgb){
+					int32_t index[4];
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(index), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, toIndex), half)));
+
+					outRow[x * 4 + 0] = SRGB.toSRGB[index[0]];
+					outRow[x * 4 + 1] = SRGB.toSRGB[index[1]];
+					outRow[x * 4 + 2] = SRGB.toSRGB[index[2]];
+					outRow[x * 4 + 3] = static_cast<uint8_t>(index[3]);
+				}
+				else{
+					__m128i bytes = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, toByte), half));
+
+					bytes = _mm_packs_epi32(bytes, bytes);
+					bytes = _mm_packus_epi16(bytes, bytes);
+
+					*reinterpret_cast<int32_t *>(outRow + x * 4) = _mm_cvtsi128_si32(bytes);
+				}
+			}
+		}
+	});
+}
+
+// Fraction of texels whose scaled alpha passes the alpha test, once rounded to 8 bits the way FromLinear stores it
+float ComputeCoverage(const float *level, size_t numTexels, float alphaScale, float reference){
+	size_t covered = 0;
+
+	for(size_t i = 0; i < numTexels; i++){
+		float alpha = std::min(std::max(level[i * 4 + 3] * alphaScale, 0.0f), 1.0f);
+
+		if(static_cast<int32_t>(alpha * 255.0f + 0.5f) / 255.0f > reference) covered++;
+	}
+
+	return static_cast<float>(covered) / numTexels;
+}
+
+// Bisects for the alpha scale that brings a mip's coverage closest to the top level's
+float FindAlphaScale(const float *level, size_t numTexels, float targetCoverage, float reference){
+	float low = 0.0f, high = 4.0f;
+	float bestScale = 1.0f, bestError = fabsf(ComputeCoverage(level, numTexels, 1.0f, reference) - targetCoverage);
+
+	for(uint32_t i = 0; i < 12; i++){
+		float scale		= (low + high) * 0.5f;
+		float coverage	= ComputeCoverage(level, numTexels, scale, reference);
+		float error		= fabsf(coverage - targetCoverage);
+
+		if(error < bestError){
+			bestError = error;
+			bestScale = scale;
+		}
+
+		if(coverage < targetCoverage)	low = scale;
+		else							high = scale;
+	}
+
+	return bestScale;
+}
+
+}
+
+size_t GetMipCount(size_t width, size_t height){
+	size_t mipCount = 1;
+
+	while(width > 1 || height > 1){
+		width	= std::max<size_t>(1, width >> 1);
+		height	= std::max<size_t>(1, height >> 1);
+
+		mipCount++;
+	}
+
+	return mipCount;
+}
+
+bool GenerateMipChain(const uint8_t *texels, size_t width, size_t height, size_t rowPitch, const MipOptions &options,
+	std::vector<uint8_t> &chain, size_t &mipCount){
+
+	if(!texels || width == 0 || height == 0) return false;
+
+	mipCount = GetMipCount(width, height);
+
+	// Packed size of the whole chain
+	size_t chainBytes = 0;
+
+	for(size_t mip = 0; mip < mipCount; mip++){
+		chainBytes += std::max<size_t>(1, width >> mip) * std::max<size_t>(1, height >> mip) * 4;
+	}
+
+	chain.resize(chainBytes);
+
+	for(size_t y = 0; y < height; y++){
+		memcpy(&chain[y * width * 4], texels + y * rowPitch, width * 4);
+	}
+
+	// Every level is filtered from the previous one in linear floating point
+	std::vector<float> current(width * height * 4), next, rows;
+	FilterTaps horizontalTaps, verticalTaps;
+
+	ToLinear(texels, width, height, rowPitch, options.srgb, &current[0], options.numThreads);
+
+	bool preserveCoverage	= options.alphaReference > 0.0f;
+	float targetCoverage	= preserveCoverage ? ComputeCoverage(&current[0], width * height, 1.0f, options.alphaReference) : 0.0f;
+	size_t offset			= width * height * 4;
+
+	for(size_t mip = 1; mip < mipCount; mip++){
+		size_t dstWidth		= std::max<size_t>(1, width >> 1);
+		size_t dstHeight	= std::max<size_t>(1, height >> 1);
+
+		BuildTaps(width, dstWidth, options.filter, horizontalTaps);
+		BuildTaps(height, dstHeight, options.filter, verticalTaps);
+
+		rows.resize(dstWidth * height * 4);
+		next.resize(dstWidth * dstHeight * 4);
+
+		FilterRows(&current[0], width, height, horizontalTaps, dstWidth, &rows[0], options.numThreads);
+		FilterColumns(&rows[0], dstWidth, verticalTaps, dstHeight, &next[0], options.numThreads);
+
+		// Coverage is only corrected on the stored level, the next level still filters the unscaled alpha
+		float alphaScale = preserveCoverage ? FindAlphaScale(&next[0], dstWidth * dstHeight, targetCoverage, options.alphaReference) : 1.0f;
+
+		FromLinear(&next[0], dstWidth, dstHeight, options.srgb, alphaScale, &chain[offset], options.numThreads);
+
+		offset += dstWidth * dstHeight * 4;
+
+		current.swap(next);
+		width	= dstWidth;
+		height	= dstHeight;
+	}
+
+	return true;
+}
+
+bool IsFormatSupported(DXGI_FORMAT format){
+	switch(format){
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			return true;
+
+		default:{
+			BlockCompression::BlockFormat blockFormat;
+
+			// BC7 can only be decoded
+			return BlockCompression::GetBlockFormat(format, blockFormat) && blockFormat != BlockCompression::FormatBC7;
+		}
+	}
+}
+
+bool GenerateSurfaceMips(DXGI_FORMAT format, const uint8_t *bits, size_t bitSize, size_t width, size_t height,
+	const MipOptions &options, std::vector<uint8_t> &chain, size_t &mipCount){
+
+	if(!IsFormatSupported(format) || !bits || width == 0 || height == 0) return false;
+
+	MipOptions surfaceOptions = options;
+	BlockCompression::BlockFormat blockFormat;
+
+	// Uncompressed formats are filtered in place, red and blue order does not matter to the filter
+	if(!BlockCompression::GetBlockFormat(format, blockFormat)){
+		if(bitSize < width * height * 4) return false;
+
+		// The X channel of BGRX carries no alpha to preserve
+		if(format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB) surfaceOptions.alphaReference = 0.0f;
+
+		return GenerateMipChain(bits, width, height, width * 4, surfaceOptions, chain, mipCount);
+	}
+
+	// Block formats are decoded, filtered and encoded again level by level
+	if(bitSize < BlockCompression::GetSurfaceBytes(blockFormat, width, height)) return false;
+
+	// BC4 and BC5 hold data rather than color
+	if(blockFormat == BlockCompression::FormatBC4 || blockFormat == BlockCompression::FormatBC5){
+		surfaceOptions.srgb				= false;
+		surfaceOptions.alphaReference	= 0.0f;
+	}
+
+	std::vector<uint8_t> texels(width * height * 4), texelChain;
+
+	if(!BlockCompression::DecodeSurface(blockFormat, bits, width, height, &texels[0], width * 4, options.numThreads)) return false;
+	if(!GenerateMipChain(&texels[0], width, height, width * 4, surfaceOptions, texelChain, mipCount)) return false;
+
+	size_t chainBytes = 0;
+
+	for(size_t mip = 0; mip < mipCount; mip++){
+		chainBytes += BlockCompression::GetSurfaceBytes(blockFormat, std::max<size_t>(1, width >> mip), std::max<size_t>(1, height >> mip));
+	}
+
+	chain.resize(chainBytes);
+
+	// The top level keeps its original blocks
+	size_t texelOffset = width * height * 4;
+	size_t blockOffset = BlockCompression::GetSurfaceBytes(blockFormat, width, height);
+
+	memcpy(&chain[0], bits, blockOffset);
+
+	for(size_t mip = 1; mip < mipCount; mip++){
+		size_t mipWidth		= std::max<size_t>(1, width >> mip);
+		size_t mipHeight	= std::max<size_t>(1, height >> mip);
+
+		BlockCompression::EncodeSurface(blockFormat, &texelChain[texelOffset], mipWidth, mipHeight, mipWidth * 4, &chain[blockOffset], options.numThreads);
+
+		texelOffset += mipWidth * mipHeight * 4;
+		blockOffset += BlockCompression::GetSurfaceBytes(blockFormat, mipWidth, mipHeight);
+	}
+
+	return true;
+}
+
+bool GenerateDDSMipsToFile(const std::wstring &srcPath, const std::wstring &dstPath, const MipOptions &options){
+	std::vector<uint8_t> source, output;
+
+	if(!Util::ReadFileToMemory(srcPath, source) || source.empty()) return false;
+
+	if(FAILED(DirectX::GenerateDDSMipsFromMemory(&source[0], source.size(), options, output))) return false;
+
+	return Util::WriteMemoryToFile(dstPath, &output[0], output.size());
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+///////////////////////////
+// CPU mip-chain builder //
+///////////////////////////
+
+namespace MipGenerator{
+
+enum MipFilter{
+	FilterBox,
+	FilterKaiser,
+};
+
+struct MipOptions{
+	MipFilter filter;
+
+	// Color channels are filtered in linear space and converted back to sRGB
+	bool srgb;
+
+	// Alpha-test reference in [0, 1], the fraction of texels above it is kept at every mip (0 disables)
+	float alphaReference;
+
+	// Threads rows are split across, 0 uses every core
+	uint32_t numThreads;
+
+	MipOptions() : filter(FilterBox), srgb(false), alphaReference(0.0f), numThreads(0){}
+};
+
+// Number of levels in a full chain down to 1x1
+size_t GetMipCount(size_t width, size_t height);
+
+// Builds a full chain from an RGBA8 image, every level including the top one is packed
+// one after another with no row padding
+bool GenerateMipChain(const uint8_t *texels, size_t width, size_t height, size_t rowPitch, const MipOptions &options,
+	std::vector<uint8_t> &chain, size_t &mipCount);
+
+// Formats GenerateSurfaceMips handles: 8-bit RGBA/BGRA and the block formats that can be re-encoded
+bool IsFormatSupported(DXGI_FORMAT format);
+
+// Builds a full chain for a single 2D surface, the output has the same layout as the bit data of a mipmapped DDS file
+bool GenerateSurfaceMips(DXGI_FORMAT format, const uint8_t *bits, size_t bitSize, size_t width, size_t height,
+	const MipOptions &options, std::vector<uint8_t> &chain, size_t &mipCount);
+
+// Offline path, reads a single-mip DDS file and writes a mipmapped copy
+bool GenerateDDSMipsToFile(const std::wstring &srcPath, const std::wstring &dstPath, const MipOptions &options);
+
+}
@@ -0,0 +1,348 @@
+#include "Engine.h"
+
+namespace{
+
+// Clips a polygon against the near plane (z >= 0 in clip space), returns the new vertex count
+uint32_t ClipNear(const DirectX::XMFLOAT4 *in, uint32_t numIn, DirectX::XMFLOAT4 *out){
+	uint32_t numOut = 0;
+
+	for(uint32_t i = 0; i < numIn; i++){
+		const DirectX::XMFLOAT4 &a = in[i];
+		const DirectX::XMFLOAT4 &b = in[(i + 1) % numIn];
+
+		bool aInside = a.z >= 0.0f, bInside = b.z >= 0.0f;
+
+		if(aInside) out[numOut++] = a;
+
+		if(aInside != bInside){
+			float t = a.z / (a.z - b.z);
+
+			out[numOut++] = DirectX::XMFLOAT4(
+				a.x + (b.x - a.x) * t,
+				a.y + (b.y - a.y) * t,
+				0.0f,
+				a.w + (b.w - a.w) * t
+			);
+		}
+	}
+
+	return numOut;
+}
+
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height){
+
+	// Keep the width a multiple of the tile size so rows can be processed 4 pixels at a time
+	m_width		= std::max<uint32_t>(1, (width + TileSize - 1) / TileSize) * TileSize;
+	m_height	= std::max<uint32_t>(1, (height + TileSize - 1) / TileSize) * TileSize;
+	m_tilesX	= m_width / TileSize;
+	m_tilesY	= m_height / TileSize;
+
+	m_depth.resize(m_width * m_height, 1.0f);
+	m_tileMaxDepth.resize(m_tilesX * m_tilesY, 1.0f);
+
+	DirectX::XMStoreFloat4x4(&m_viewProj, DirectX::XMMatrixIdentity());
+
+	m_numTriangles = 0;
+}
+
+OcclusionCuller::~OcclusionCuller(){
+
+}
+
+void OcclusionCuller::beginFrame(const Camera &camera){
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+	std::fill(m_tileMaxDepth.begin(), m_tileMaxDepth.end(), 1.0f);
+
+	DirectX::XMStoreFloat4x4(&m_viewProj, camera.getViewProjMatrixCPU());
+
+	m_numTriangles = 0;
+}
+
+void OcclusionCuller::renderOccluder(const OccluderMesh &occluder, const DirectX::XMMATRIX &world){
+	DirectX::XMMATRIX worldViewProj = DirectX::XMMatrixMultiply(world, DirectX::XMLoadFloat4x4(&m_viewProj));
+
+	// Transform every vertex to clip space once, into the thread's scratch memory since this runs for every occluder each frame
+	ScratchScope scratch;
+	DirectX::XMFLOAT4 *clipVerts = scratch.allocateArray<DirectX::XMFLOAT4>(occluder.positions.size());
+
+	if(!clipVerts) return;
+
+	for(size_t i = 0; i < occluder.positions.size(); i++){
+		DirectX::XMVECTOR pos = DirectX::XMVectorSetW(DirectX::XMLoadFloat3(&occluder.positions[i]), 1.0f);
+
+		DirectX::XMStoreFloat4(&clipVerts[i], DirectX::XMVector4Transform(pos, worldViewProj));
+	}
+
+	const float halfWidth = 0.5f * m_width, halfHeight = 0.5f * m_height;
+
+	for(size_t i = 0; i + 2 < occluder.indices.size(); i += 3){
+		DirectX::XMFLOAT4 poly[3] = {
+			clipVerts[occluder.indices[i]],
+			clipVerts[occluder.indices[i + 1]],
+			clipVerts[occluder.indices[i + 2]]
+		};
+
+		// Trivially reject triangles fully outside one of the side planes
+		if((poly[0].x > poly[0].w && poly[1].x > poly[1].w && poly[2].x > poly[2].w) ||
+			(poly[0].x < -poly[0].w && poly[1].x < -poly[1].w && poly[2].x < -poly[2].w) ||
+			(poly[0].y > poly[0].w && poly[1].y > poly[1].w && poly[2].y > poly[2].w) ||
+			(poly[0].y < -poly[0].w && poly[1].y < -poly[1].w && poly[2].y < -poly[2].w)){
+			continue;
+		}
+
+		// Clip against the near plane, which can turn the triangle into a quad
+		DirectX::XMFLOAT4 clipped[4];
+		uint32_t numClipped = ClipNear(poly, 3, clipped);
+
+		if(numClipped < 3) continue;
+
+		// Project to screen space
+		DirectX::XMFLOAT3 screen[4];
+
+		for(uint32_t j = 0; j < numClipped; j++){
+			float invW = 1.0f / clipped[j].w;
+
+			screen[j].x = (clipped[j].x * invW) * halfWidth + halfWidth;
+			screen[j].y = halfHeight - (clipped[j].y * invW) * halfHeight;
+			screen[j].z = clipped[j].z * invW;
+		}
+
+		for(uint32_t j = 1; j + 1 < numClipped; j++){
+			rasterizeTriangle(screen[0], screen[j], screen[j + 1]);
+		}
+	}
+}
+
+void OcclusionCuller::rasterizeTriangle(const DirectX::XMFLOAT3 &v0, const DirectX::XMFLOAT3 &v1, const DirectX::XMFLOAT3 &v2){
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+	if(fabsf(area) < 1e-6f) return;
+
+	// Orient edges so the inside is positive regardless of winding, occluders are double-sided
+	const DirectX::XMFLOAT3 &a = v0;
+	const DirectX::XMFLOAT3 &b = area > 0 ? v1 : v2;
+	const DirectX::XMFLOAT3 &c = area > 0 ? v2 : v1;
+
+	area = fabsf(area);
+
+	// Screen bounds, clamped to the buffer
+	int32_t minX = std::max<int32_t>(0, static_cast<int32_t>(floorf(std::min(a.x, std::min(b.x, c.x)))));
+	int32_t maxX = std::min<int32_t>(m_width - 1, static_cast<int32_t>(ceilf(std::max(a.x, std::max(b.x, c.x)))));
+	int32_t minY = std::max<int32_t>(0, static_cast<int32_t>(floorf(std::min(a.y, std::min(b.y, c.y)))));
+	int32_t maxY = std::min<int32_t>(m_height - 1, static_cast<int32_t>(ceilf(std::max(a.y, std::max(b.y, c.y)))));
+
+	if(minX > maxX || minY > maxY) return;
+
+	// Process 4 pixels per step, start on an aligned column
+	minX &= ~3;
+
+	// Edge functions E(x, y) = A * x + B * y + C, positive inside
+	float edgeA[3] = {b.y - c.y, c.y - a.y, a.y - b.y};
+	float edgeB[3] = {c.x - b.x, a.x - c.x, b.x - a.x};
+	float edgeC[3] = {b.x * c.y - b.y * c.x, c.x * a.y - c.y * a.x, a.x * b.y - a.y * b.x};
+
+	// Depth plane from barycentrics
+	float invArea = 1.0f / area;
+	float zA = (edgeA[0] * a.z + edgeA[1] * b.z + edgeA[2] * c.z) * invArea;
+	float zB = (edgeB[0] * a.z + edgeB[1] * b.z + edgeB[2] * c.z) * invArea;
+	float zC = (edgeC[0] * a.z + edgeC[1] * b.z + edgeC[2] * c.z) * invArea;
+
+	const DirectX::XMVECTOR pixelOffsets = DirectX::XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const DirectX::XMVECTOR zero = DirectX::XMVectorZero();
+
+	DirectX::XMVECTOR stepA[3], stepZ = DirectX::XMVectorReplicate(zA * 4.0f);
+
+	for(int e = 0; e < 3; e++){
+		stepA[e] = DirectX::XMVectorReplicate(edgeA[e] * 4.0f);
+	}
+
+	for(int32_t y = minY; y <= maxY; y++){
+		float py = static_cast<float>(y) + 0.5f;
+		DirectX::XMVECTOR px = DirectX::XMVectorAdd(DirectX::XMVectorReplicate(static_cast<float>(minX)), pixelOffsets);
+
+		DirectX::XMVECTOR edge[3];
+
+		for(int e = 0; e < 3; e++){
+			edge[e] = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorReplicate(edgeA[e]), px,
+				DirectX::XMVectorReplicate(edgeB[e] * py + edgeC[e]));
+		}
+
+		DirectX::XMVECTOR depth = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorReplicate(zA), px,
+			DirectX::XMVectorReplicate(zB * py + zC));
+
+		float *row = &m_depth[y * m_width];
+
+		for(int32_t x = minX; x <= maxX; x += 4){
+
+			// Pixel centres strictly inside all three edges, which keeps the coverage conservative
+			DirectX::XMVECTOR inside = DirectX::XMVectorAndInt(
+				DirectX::XMVectorAndInt(DirectX::XMVectorGreater(edge[0], zero), DirectX::XMVectorGreater(edge[1], zero)),
+				DirectX::XMVectorGreater(edge[2], zero));
+
+			if(!DirectX::XMVector4EqualInt(inside, DirectX::XMVectorFalseInt())){
+				DirectX::XMVECTOR old = DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4 *>(row + x));
+				DirectX::XMVECTOR nearest = DirectX::XMVectorMin(old, DirectX::XMVectorMax(depth, zero));
+
+				DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4 *>(row + x), DirectX::XMVectorSelect(old, nearest, inside));
+			}
+
+			for(int e = 0; e < 3; e++){
+				edge[e] = DirectX::XMVectorAdd(edge[e], stepA[e]);
+			}
+
+			depth = DirectX::XMVectorAdd(depth, stepZ);
+		}
+	}
+
+	m_numTriangles++;
+}
+
+void OcclusionCuller::endFrame(){
+
+	// Each tile keeps the farthest occluder depth it contains, anything behind that is hidden
+	for(uint32_t ty = 0; ty < m_tilesY; ty++){
+		for(uint32_t tx = 0; tx < m_tilesX; tx++){
+			float maxDepth = 0.0f;
+
+			for(uint32_t y = ty * TileSize; y < (ty + 1) * TileSize; y++){
+				const float *row = &m_depth[y * m_width + tx * TileSize];
+
+				for(uint32_t x = 0; x < TileSize; x++){
+					maxDepth = std::max(maxDepth, row[x]);
+				}
+			}
+
+			m_tileMaxDepth[ty * m_tilesX + tx] = maxDepth;
+		}
+	}
+}
+
+bool OcclusionCuller::isVisible(const DirectX::XMFLOAT3 &boundsMin, const DirectX::XMFLOAT3 &boundsMax,
+	const DirectX::XMMATRIX &world) const{
+
+	DirectX::XMMATRIX worldViewProj = DirectX::XMMatrixMultiply(world, DirectX::XMLoadFloat4x4(&m_viewProj));
+
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+
+	// Project the 8 corners of the box
+	for(uint32_t i = 0; i < 8; i++){
+		DirectX::XMVECTOR corner = DirectX::XMVectorSet(
+			(i & 1) ? boundsMax.x : boundsMin.x,
+			(i & 2) ? boundsMax.y : boundsMin.y,
+			(i & 4) ? boundsMax.z : boundsMin.z,
+			1.0f);
+
+		DirectX::XMFLOAT4 clip;
+
+		DirectX::XMStoreFloat4(&clip, DirectX::XMVector4Transform(corner, worldViewProj));
+
+		// Crossing the near plane, nothing sensible to test against
+		if(clip.z <= 0.0f || clip.w <= 1e-5f) return true;
+
+		float invW = 1.0f / clip.w;
+		float x = (clip.x * invW) * 0.5f * m_width + 0.5f * m_width;
+		float y = 0.5f * m_height - (clip.y * invW) * 0.5f * m_height;
+
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		minZ = std::min(minZ, clip.z * invW);
+	}
+
+	// Outside the screen entirely
+	if(maxX < 0 || maxY < 0 || minX >= m_width || minY >= m_height || minZ > 1.0f) return false;
+
+	int32_t x0 = std::max<int32_t>(0, static_cast<int32_t>(minX));
+	int32_t y0 = std::max<int32_t>(0, static_cast<int32_t>(minY));
+	int32_t x1 = std::min<int32_t>(m_width - 1, static_cast<int32_t>(maxX));
+	int32_t y1 = std::min<int32_t>(m_height - 1, static_cast<int32_t>(maxY));
+
+	for(int32_t ty = y0 / TileSize; ty <= y1 / static_cast<int32_t>(TileSize); ty++){
+		for(int32_t tx = x0 / TileSize; tx <= x1 / static_cast<int32_t>(TileSize); tx++){
+
+			// Box is behind every occluder pixel in this tile
+			if(minZ > m_tileMaxDepth[ty * m_tilesX + tx]) continue;
+
+			// Otherwise refine per pixel over the overlapping part of the tile
+			int32_t py0 = std::max<int32_t>(y0, ty * TileSize), py1 = std::min<int32_t>(y1, (ty + 1) * TileSize - 1);
+			int32_t px0 = std::max<int32_t>(x0, tx * TileSize), px1 = std::min<int32_t>(x1, (tx + 1) * TileSize - 1);
+
+			for(int32_t y = py0; y <= py1; y++){
+				for(int32_t x = px0; x <= px1; x++){
+					if(minZ <= m_depth[y * m_width + x]) return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+uint32_t OcclusionCuller::getWidth() const{
+	return m_width;
+}
+
+uint32_t OcclusionCuller::getHeight() const{
+	return m_height;
+}
+
+uint32_t OcclusionCuller::getNumTriangles() const{
+	return m_numTriangles;
+}
+
+const float *OcclusionCuller::getDepthBuffer() const{
+	return &m_depth[0];
+}
+
+void SimplifyOccluder(const void *vertices, const uint32_t *indices, uint32_t numVertices, uint32_t numIndices,
+	uint32_t vertexSize, float cellSize, OccluderMesh &occluder){
+
+	const uint8_t *vertexData = static_cast<const uint8_t *>(vertices);
+
+	// Vertices are only copied once a kept triangle uses them
+	ScratchScope scratch;
+	uint32_t *remap = scratch.allocateArray<uint32_t>(numVertices);
+
+	occluder.positions.clear();
+	occluder.indices.clear();
+
+	if(!remap) return;
+
+	std::fill(remap, remap + numVertices, UINT32_MAX);
+
+	// Twice the smallest area kept, the cross product below gives twice a triangle's area. Moving or merging
+	// vertices would let the occluder grow past the silhouette or in front of the surface, so small triangles
+	// are dropped whole instead
+	float minDoubleArea = cellSize * cellSize;
+
+	for(uint32_t i = 0; i + 2 < numIndices; i += 3){
+		const DirectX::XMFLOAT3 &p0 = *reinterpret_cast<const DirectX::XMFLOAT3 *>(vertexData + indices[i] * vertexSize);
+		const DirectX::XMFLOAT3 &p1 = *reinterpret_cast<const DirectX::XMFLOAT3 *>(vertexData + indices[i + 1] * vertexSize);
+		const DirectX::XMFLOAT3 &p2 = *reinterpret_cast<const DirectX::XMFLOAT3 *>(vertexData + indices[i + 2] * vertexSize);
+
+		if(cellSize > 0.0f){
+			float e1x = p1.x - p0.x, e1y = p1.y - p0.y, e1z = p1.z - p0.z;
+			float e2x = p2.x - p0.x, e2y = p2.y - p0.y, e2z = p2.z - p0.z;
+
+			float cx = e1y * e2z - e1z * e2y;
+			float cy = e1z * e2x - e1x * e2z;
+			float cz = e1x * e2y - e1y * e2x;
+
+			if(cx * cx + cy * cy + cz * cz < minDoubleArea * minDoubleArea) continue;
+		}
+
+		for(uint32_t j = 0; j < 3; j++){
+			uint32_t &index = remap[indices[i + j]];
+
+			if(index == UINT32_MAX){
+				index = static_cast<uint32_t>(occluder.positions.size());
+				occluder.positions.push_back(*reinterpret_cast<const DirectX::XMFLOAT3 *>(vertexData + indices[i + j] * vertexSize));
+			}
+
+			occluder.indices.push_back(index);
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+///////////////////////////////
+// Software occlusion culler //
+///////////////////////////////
+
+// CPU-side triangle soup used only for rasterizing into the occlusion buffer
+struct OccluderMesh{
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<uint32_t> indices;
+};
+
+class OcclusionCuller{
+private:
+	static const uint32_t TileSize = 8;
+
+	uint32_t m_width, m_height;
+	uint32_t m_tilesX, m_tilesY;
+
+	// Nearest occluder depth per pixel, and the farthest of those per tile
+	std::vector<float> m_depth;
+	std::vector<float> m_tileMaxDepth;
+
+	DirectX::XMFLOAT4X4 m_viewProj;
+
+	uint32_t m_numTriangles;
+
+	void rasterizeTriangle(const DirectX::XMFLOAT3 &v0, const DirectX::XMFLOAT3 &v1, const DirectX::XMFLOAT3 &v2);
+
+public:
+	OcclusionCuller(uint32_t width, uint32_t height);
+	~OcclusionCuller();
+
+	// Clears the depth buffer and takes the view-projection used for this frame
+	void beginFrame(const Camera &camera);
+
+	// Rasterizes an occluder with a row-major world matrix
+	void renderOccluder(const OccluderMesh &occluder, const DirectX::XMMATRIX &world);
+
+	// Builds the per-tile depth hierarchy, must be called before any visibility tests
+	void endFrame();
+
+	// Tests an object-space bounding box against the occluders
+	bool isVisible(const DirectX::XMFLOAT3 &boundsMin, const DirectX::XMFLOAT3 &boundsMax, const DirectX::XMMATRIX &world) const;
+
+	uint32_t getWidth() const;
+	uint32_t getHeight() const;
+	uint32_t getNumTriangles() const;
+	const float *getDepthBuffer() const;
+};
+
+// Builds an occluder from vertices that start with a float3 position. Triangles with less area than half a
+// cellSize square are dropped (0 keeps them all) and the rest are kept unchanged, so the occluder never covers
+// anything the mesh does not and never sits in front of it
+void SimplifyOccluder(const void *vertices, const uint32_t *indices, uint32_t numVertices, uint32_t numIndices,
+	uint32_t vertexSize, float cellSize, OccluderMesh &occluder);
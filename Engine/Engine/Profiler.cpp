@@ -0,0 +1,321 @@
+#include "Engine.h"
+
+namespace{
+
+// Zone as it was drained from a ring, times in cycles
+struct RecordedEvent{
+	const char *name;
+	uint64_t begin, end;
+	uint32_t depth, threadId;
+};
+
+struct ZoneHistory{
+	double frameTimes[Profiler::StatsWindow];
+	uint32_t frameCalls[Profiler::StatsWindow];
+
+	// Totals for the frame that's being drained
+	uint64_t cycles;
+	uint32_t calls;
+
+	// Shallowest depth the zone was seen at, only used to indent the table
+	uint32_t depth;
+};
+
+// Caps the memory a forgotten capture can take
+const size_t MaxCapturedEvents = 4 * 1024 * 1024;
+
+THREAD_LOCAL Profiler::ThreadBuffer *t_buffer = nullptr;
+
+std::atomic<bool> g_enabled(true);
+
+// Everything below is guarded by g_mutex
+std::mutex g_mutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> g_buffers;
+
+std::unordered_map<const char *, ZoneHistory> g_zones;
+uint32_t g_numFrames = 0;
+
+bool g_capturing = false;
+std::vector<RecordedEvent> g_captured;
+
+// Reused between frames so draining doesn't allocate
+std::vector<RecordedEvent> g_drained;
+
+// Cycle counter and timer read together once, both are measured from here
+Timer g_timer;
+TimeStamp g_startTime;
+uint64_t g_startCycles = 0;
+
+void StartClock(){
+	if(g_startCycles) return;
+
+	g_timer.createTimeStamp(g_startTime);
+	g_startCycles = ReadCycleCounter();
+}
+
+double CyclesPerSecond(){
+	TimeStamp now;
+
+	StartClock();
+
+	g_timer.createTimeStamp(now);
+	uint64_t cycles = ReadCycleCounter();
+
+	double seconds = g_timer.getDeltaTime(g_startTime, now);
+
+	// Too early to tell, assume a nanosecond clock
+	if(seconds < 0.001) return 1e9;
+
+	return static_cast<double>(cycles - g_startCycles) / seconds;
+}
+
+}
+
+Profiler::ThreadBuffer *Profiler::createBuffer(const char *name){
+	std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+
+	buffer->head		= 0;
+	buffer->depth		= 0;
+	buffer->tail		= 0;
+
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	StartClock();
+
+	buffer->threadId = static_cast<uint32_t>(g_buffers.size()) + 1;
+
+	if(name){
+		buffer->threadName = name;
+	}
+	else{
+		char defaultName[32];
+		sprintf_s(defaultName, "Thread %u", buffer->threadId);
+		buffer->threadName = defaultName;
+	}
+
+	// Rings live as long as the program, a thread may exit with zones still queued
+	g_buffers.push_back(std::move(buffer));
+
+	return g_buffers.back().get();
+}
+
+Profiler::ThreadBuffer *Profiler::registerThread(){
+	t_buffer = createBuffer(nullptr);
+
+	return t_buffer;
+}
+
+Profiler::ThreadBuffer *Profiler::getThreadBuffer(){
+	ThreadBuffer *buffer = t_buffer;
+
+	return buffer ? buffer : registerThread();
+}
+
+void Profiler::setEnabled(bool enabled){
+	g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::isEnabled(){
+	return g_enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char *name){
+	ThreadBuffer *buffer = getThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(g_mutex);
+	buffer->threadName = name;
+}
+
+Profiler::ThreadBuffer *Profiler::createTrack(const char *name){
+	return createBuffer(name);
+}
+
+void Profiler::recordZone(ThreadBuffer *track, const char *name, uint64_t begin, uint64_t end, uint32_t depth){
+	if(track && isEnabled()) track->push(name, begin, end, depth);
+}
+
+void Profiler::endFrame(){
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	double cyclesPerMs = CyclesPerSecond() / 1000.0;
+
+	// Zones tend to repeat back to back, skip the lookup when they do
+	const char *lastName = nullptr;
+	ZoneHistory *lastZone = nullptr;
+
+	for(auto &buffer : g_buffers){
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+		// Anything the owner lapped since the last frame is gone
+		uint64_t tail = std::max(buffer->tail, head > RingSize ? head - RingSize : 0);
+
+		std::vector<RecordedEvent> &events = g_drained;
+		events.clear();
+
+		for(uint64_t i = tail; i < head; i++){
+			const Event &event = buffer->events[i & (RingSize - 1)];
+			RecordedEvent recorded = {event.name.load(std::memory_order_relaxed), event.begin.load(std::memory_order_relaxed),
+				event.end.load(std::memory_order_relaxed), event.depth.load(std::memory_order_relaxed), buffer->threadId};
+
+			events.push_back(recorded);
+		}
+
+		// Drop whatever was overwritten while it was being copied
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		uint64_t newHead = buffer->head.load(std::memory_order_relaxed);
+		uint64_t firstValid = newHead > RingSize ? newHead - RingSize : 0;
+		size_t skip = static_cast<size_t>(std::min(head, std::max(tail, firstValid)) - tail);
+
+		for(size_t i = skip; i < events.size(); i++){
+			const RecordedEvent &event = events[i];
+
+			if(event.name != lastName){
+				auto it = g_zones.find(event.name);
+
+				// The history is too big to build on every lookup, only insert when it's missing
+				if(it == g_zones.end()){
+					it = g_zones.insert(std::make_pair(event.name, ZoneHistory())).first;
+					it->second.depth = event.depth;
+				}
+
+				lastName = event.name;
+				lastZone = &it->second;
+			}
+
+			ZoneHistory &zone = *lastZone;
+
+			zone.cycles += event.end - event.begin;
+			zone.calls++;
+			zone.depth = std::min(zone.depth, event.depth);
+
+			if(g_capturing && g_captured.size() < MaxCapturedEvents) g_captured.push_back(event);
+		}
+
+		buffer->tail = head;
+	}
+
+	// Close the frame for every zone, zones that didn't run get a zero
+	uint32_t slot = g_numFrames % StatsWindow;
+
+	for(auto &it : g_zones){
+		ZoneHistory &zone = it.second;
+
+		zone.frameTimes[slot] = zone.cycles / cyclesPerMs;
+		zone.frameCalls[slot] = zone.calls;
+		zone.cycles = 0;
+		zone.calls = 0;
+	}
+
+	g_numFrames++;
+}
+
+void Profiler::beginCapture(){
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	g_capturing = true;
+	g_captured.clear();
+}
+
+void Profiler::endCapture(){
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	g_capturing = false;
+}
+
+bool Profiler::isCapturing(){
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	return g_capturing;
+}
+
+bool Profiler::writeChromeTrace(const std::wstring &path){
+	std::string text = "{\"traceEvents\":[\n";
+	char line[512];
+
+	{
+		std::lock_guard<std::mutex> lock(g_mutex);
+
+		double cyclesPerUs = CyclesPerSecond() / 1000000.0;
+
+		for(const auto &buffer : g_buffers){
+			sprintf_s(line, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+				buffer->threadId, buffer->threadName.c_str());
+			text += line;
+		}
+
+		// Complete events, nesting is rebuilt from the times
+		for(const auto &event : g_captured){
+			sprintf_s(line, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n", event.name, event.threadId,
+				(event.begin - g_startCycles) / cyclesPerUs, (event.end - event.begin) / cyclesPerUs);
+			text += line;
+		}
+	}
+
+	// Strip the last separator
+	if(text.size() > 2 && text[text.size() - 2] == ',') text.erase(text.size() - 2, 1);
+
+	text += "],\"displayTimeUnit\":\"ms\"}\n";
+
+	return Util::WriteMemoryToFile(path, text.data(), text.size());
+}
+
+void Profiler::getStats(std::vector<ProfileZoneStats> &stats){
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	uint32_t numFrames = std::min(g_numFrames, StatsWindow);
+
+	stats.clear();
+
+	if(numFrames == 0) return;
+
+	for(const auto &it : g_zones){
+		const ZoneHistory &zone = it.second;
+		ProfileZoneStats zoneStats = {it.first, zone.depth, 0, DBL_MAX, 0, 0};
+
+		for(uint32_t i = 0; i < numFrames; i++){
+			zoneStats.averageTime += zone.frameTimes[i];
+			zoneStats.minTime = std::min(zoneStats.minTime, zone.frameTimes[i]);
+			zoneStats.maxTime = std::max(zoneStats.maxTime, zone.frameTimes[i]);
+			zoneStats.callsPerFrame += zone.frameCalls[i];
+		}
+
+		zoneStats.averageTime /= numFrames;
+		zoneStats.callsPerFrame /= numFrames;
+
+		stats.push_back(zoneStats);
+	}
+
+	std::sort(stats.begin(), stats.end(), [](const ProfileZoneStats &a, const ProfileZoneStats &b){
+		return a.averageTime > b.averageTime;
+	});
+}
+
+std::string Profiler::formatStats(){
+	std::vector<ProfileZoneStats> stats;
+	std::string text;
+	char line[256];
+
+	getStats(stats);
+
+	sprintf_s(line, "%-40s %9s %9s %9s %8s\n", "Zone (ms per frame)", "Average", "Min", "Max", "Calls");
+	text += line;
+
+	for(const auto &zone : stats){
+
+		// Nested zones are indented by their depth
+		std::string name(std::min<uint32_t>(zone.depth, 8) * 2, ' ');
+		name += zone.name;
+
+		sprintf_s(line, "%-40s %9.3f %9.3f %9.3f %8.1f\n", name.c_str(), zone.averageTime, zone.minTime, zone.maxTime, zone.callsPerFrame);
+		text += line;
+	}
+
+	return text;
+}
+
+double Profiler::getCyclesPerSecond(){
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	return CyclesPerSecond();
+}
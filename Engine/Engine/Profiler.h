@@ -0,0 +1,134 @@
+#pragma once
+
+////////////////////
+// Profiler class //
+////////////////////
+
+struct ProfileZoneStats{
+	const char *name;
+	uint32_t depth;
+
+	// Per-frame totals over the rolling window, in milliseconds
+	double averageTime, minTime, maxTime;
+	double callsPerFrame;
+};
+
+// Collects nested zones from every thread. Each thread writes finished zones into its own ring, endFrame()
+// drains the rings on one thread, so recording a zone never takes a lock
+class Profiler{
+public:
+	static const uint32_t RingSize		= 16384;
+	static const uint32_t StatsWindow	= 64;
+
+	// Fields are relaxed atomics so the draining thread can read a slot while its owner overwrites it,
+	// on x86 they compile to plain loads and stores
+	struct Event{
+		std::atomic<const char *> name;
+		std::atomic<uint64_t> begin, end;
+		std::atomic<uint32_t> depth;
+	};
+
+	struct ThreadBuffer{
+		Event events[RingSize];
+
+		// Only the owning thread writes these
+		std::atomic<uint64_t> head;
+		uint32_t depth;
+
+		uint32_t threadId;
+		std::string threadName;
+
+		// Next event endFrame() hasn't read yet
+		uint64_t tail;
+
+		// Only called by the owner
+		void push(const char *name, uint64_t begin, uint64_t end, uint32_t depth){
+			uint64_t index = head.load(std::memory_order_relaxed);
+			Event &event = events[index & (RingSize - 1)];
+
+			event.name.store(name, std::memory_order_relaxed);
+			event.begin.store(begin, std::memory_order_relaxed);
+			event.end.store(end, std::memory_order_relaxed);
+			event.depth.store(depth, std::memory_order_relaxed);
+
+			// Publishes the event to endFrame()
+			head.store(index + 1, std::memory_order_release);
+		}
+	};
+
+private:
+	static ThreadBuffer *registerThread();
+	static ThreadBuffer *createBuffer(const char *name);
+
+public:
+
+	// Returns the calling thread's ring, creating it on first use
+	static ThreadBuffer *getThreadBuffer();
+
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+
+	// Shows up as the thread's name in traces
+	static void setThreadName(const char *name);
+
+	// Extra timeline for zones measured somewhere else, e.g. on the GPU. Only one thread may record into a
+	// track, times are in cycles
+	static ThreadBuffer *createTrack(const char *name);
+	static void recordZone(ThreadBuffer *track, const char *name, uint64_t begin, uint64_t end, uint32_t depth);
+
+	// Drains every thread's ring into the statistics and the capture, call once per frame from one thread
+	static void endFrame();
+
+	// Zones drained while capturing are kept for writeChromeTrace()
+	static void beginCapture();
+	static void endCapture();
+	static bool isCapturing();
+
+	// Chrome/Perfetto trace event JSON, load through chrome://tracing or ui.perfetto.dev
+	static bool writeChromeTrace(const std::wstring &path);
+
+	// Zones sorted by average time per frame
+	static void getStats(std::vector<ProfileZoneStats> &stats);
+	static std::string formatStats();
+
+	// Measured cycle counter frequency
+	static double getCyclesPerSecond();
+
+	friend class ProfileZone;
+};
+
+// Times its scope, name must outlive the profiler (string literals do)
+class ProfileZone{
+private:
+	Profiler::ThreadBuffer *m_buffer;
+	const char *m_name;
+	uint64_t m_begin;
+
+	ProfileZone(const ProfileZone &) = delete;
+	ProfileZone &operator=(const ProfileZone &) = delete;
+
+public:
+	ProfileZone(const char *name){
+		m_buffer = Profiler::isEnabled() ? Profiler::getThreadBuffer() : nullptr;
+
+		if(m_buffer){
+			m_name = name;
+			m_buffer->depth++;
+			m_begin = ReadCycleCounter();
+		}
+	}
+
+	~ProfileZone(){
+		if(!m_buffer) return;
+
+		uint64_t end = ReadCycleCounter();
+
+		m_buffer->depth--;
+		m_buffer->push(m_name, m_begin, end, m_buffer->depth);
+	}
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
@@ -0,0 +1,242 @@
+#include "Engine.h"
+
+namespace{
+
+struct ShaderCacheHeader{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t bytecodeSize;
+	uint32_t numElements;
+};
+
+// Every input element is stored as these three fields followed by the semantic name
+struct ShaderCacheElement{
+	uint32_t semanticIndex;
+	uint32_t format;
+	uint32_t nameLength;
+};
+
+void Append(std::vector<uint8_t> &data, const void *src, size_t size){
+	const uint8_t *bytes = static_cast<const uint8_t *>(src);
+
+	data.insert(data.end(), bytes, bytes + size);
+}
+
+bool Consume(const std::vector<uint8_t> &data, size_t &position, void *dst, size_t size){
+	if(size > data.size() - position) return false;
+
+	if(size) memcpy(dst, &data[position], size);
+	position += size;
+
+	return true;
+}
+
+bool CompileWithD3D(const ShaderDesc &desc, const std::vector<uint8_t> &source, std::vector<uint8_t> &bytecode){
+	if(source.empty()) return false;
+
+	std::vector<D3D_SHADER_MACRO> macros;
+
+	for(const auto &define : desc.defines){
+		D3D_SHADER_MACRO macro = {define.name.c_str(), define.value.c_str()};
+		macros.push_back(macro);
+	}
+
+	D3D_SHADER_MACRO terminator = {nullptr, nullptr};
+	macros.push_back(terminator);
+
+	// The source name is what relative includes and error messages are resolved against
+	char sourceName[MAX_PATH] = {0};
+	WideCharToMultiByte(CP_ACP, 0, desc.path.c_str(), -1, sourceName, MAX_PATH - 1, NULL, NULL);
+
+	ID3DBlob *shaderBlob = nullptr, *errorBlob = nullptr;
+
+	HRESULT result = D3DCompile(&source[0], source.size(), sourceName, &macros[0], D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		desc.entryPoint.c_str(), desc.profile.c_str(), 0, 0, &shaderBlob, &errorBlob);
+
+	if(errorBlob){
+		DbgOutA(static_cast<const char *>(errorBlob->GetBufferPointer()));
+		errorBlob->Release();
+	}
+
+	if(FAILED(result)) return false;
+
+	const uint8_t *compiled = static_cast<const uint8_t *>(shaderBlob->GetBufferPointer());
+
+	bytecode.assign(compiled, compiled + shaderBlob->GetBufferSize());
+	shaderBlob->Release();
+
+	return true;
+}
+
+bool ReflectWithD3D(const ShaderDesc &desc, CompiledShader &shader){
+
+	// Only vertex shaders have an input signature worth keeping
+	if(desc.profile.compare(0, 3, "vs_") != 0) return true;
+
+	return Util::ReflectVertexLayout(shader);
+}
+
+}
+
+ShaderCache::ShaderCache(const std::wstring &directory) :
+	m_directory(directory), m_compile(CompileWithD3D), m_reflect(ReflectWithD3D), m_salt(D3D_COMPILER_VERSION){
+
+	m_numMemoryHits	= 0;
+	m_numDiskHits	= 0;
+	m_numCompiles	= 0;
+}
+
+ShaderCache::ShaderCache(const std::wstring &directory, const CompileFunc &compile, const ReflectFunc &reflect, uint64_t salt) :
+	m_directory(directory), m_compile(compile), m_reflect(reflect), m_salt(salt){
+
+	m_numMemoryHits	= 0;
+	m_numDiskHits	= 0;
+	m_numCompiles	= 0;
+}
+
+uint64_t ShaderCache::computeKey(const ShaderDesc &desc, const std::vector<uint8_t> &source) const{
+	uint32_t version = Version;
+
+	uint64_t hash = Util::HashFNV1a(&version, sizeof(version));
+	hash = Util::HashFNV1a(&m_salt, sizeof(m_salt), hash);
+
+	// Strings are hashed with their terminators so neighbouring fields can't run into each other
+	hash = Util::HashFNV1a(source.empty() ? nullptr : &source[0], source.size(), hash);
+	hash = Util::HashFNV1a(desc.entryPoint.c_str(), desc.entryPoint.size() + 1, hash);
+	hash = Util::HashFNV1a(desc.profile.c_str(), desc.profile.size() + 1, hash);
+
+	for(const auto &define : desc.defines){
+		hash = Util::HashFNV1a(define.name.c_str(), define.name.size() + 1, hash);
+		hash = Util::HashFNV1a(define.value.c_str(), define.value.size() + 1, hash);
+	}
+
+	return hash;
+}
+
+std::wstring ShaderCache::getCachePath(uint64_t key) const{
+	wchar_t name[32];
+
+	swprintf_s(name, L"\\%016llx.shc", key);
+
+	return m_directory + name;
+}
+
+bool ShaderCache::readCacheFile(uint64_t key, CompiledShader &shader) const{
+	std::vector<uint8_t> data;
+	ShaderCacheHeader header;
+	size_t position = 0;
+
+	if(!Util::ReadFileToMemory(getCachePath(key), data) || !Consume(data, position, &header, sizeof(header))) return false;
+
+	// A key mismatch means a hash collision on the file name, treat it as a miss
+	if(header.magic != Magic || header.version != Version || header.key != key || header.bytecodeSize == 0) return false;
+
+	shader.bytecode.resize(header.bytecodeSize);
+	shader.semanticNames.clear();
+	shader.elements.clear();
+
+	if(!Consume(data, position, &shader.bytecode[0], header.bytecodeSize)) return false;
+
+	for(uint32_t i = 0; i < header.numElements; i++){
+		ShaderCacheElement stored;
+
+		if(!Consume(data, position, &stored, sizeof(stored)) || stored.nameLength > data.size() - position) return false;
+
+		D3D11_INPUT_ELEMENT_DESC element = {nullptr, stored.semanticIndex, static_cast<DXGI_FORMAT>(stored.format), 0,
+			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0};
+
+		shader.semanticNames.push_back(std::string(reinterpret_cast<const char *>(&data[position]), stored.nameLength));
+		shader.elements.push_back(element);
+
+		position += stored.nameLength;
+	}
+
+	return position == data.size();
+}
+
+bool ShaderCache::writeCacheFile(uint64_t key, const CompiledShader &shader) const{
+	ShaderCacheHeader header = {Magic, Version, key, static_cast<uint32_t>(shader.bytecode.size()), static_cast<uint32_t>(shader.elements.size())};
+	std::vector<uint8_t> data;
+
+	Append(data, &header, sizeof(header));
+	Append(data, &shader.bytecode[0], shader.bytecode.size());
+
+	for(size_t i = 0; i < shader.elements.size(); i++){
+		ShaderCacheElement stored = {shader.elements[i].SemanticIndex, static_cast<uint32_t>(shader.elements[i].Format),
+			static_cast<uint32_t>(shader.semanticNames[i].size())};
+
+		Append(data, &stored, sizeof(stored));
+		Append(data, shader.semanticNames[i].data(), shader.semanticNames[i].size());
+	}
+
+	// Write to a temporary first so a concurrent reader never sees a partial file
+	std::wstring path = getCachePath(key);
+	std::wstring tempPath = path + L".tmp";
+
+	CreateDirectoryW(m_directory.c_str(), NULL);
+
+	if(!Util::WriteMemoryToFile(tempPath, &data[0], data.size())) return false;
+
+	if(!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)){
+		DeleteFileW(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool ShaderCache::get(const ShaderDesc &desc, std::shared_ptr<const CompiledShader> &shader){
+	std::vector<uint8_t> source;
+
+	if(!Util::ReadFileToMemory(desc.path, source)) return false;
+
+	uint64_t key = computeKey(desc, source);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_shaders.find(key);
+
+		if(it != m_shaders.end()){
+			m_numMemoryHits++;
+			shader = it->second;
+
+			return true;
+		}
+	}
+
+	// Disk lookups and compiles happen outside the lock
+	std::shared_ptr<CompiledShader> loaded = std::make_shared<CompiledShader>();
+
+	if(readCacheFile(key, *loaded)){
+		m_numDiskHits++;
+	}
+	else{
+		if(!m_compile(desc, source, loaded->bytecode) || loaded->bytecode.empty() || !m_reflect(desc, *loaded)) return false;
+
+		m_numCompiles++;
+
+		// A failed write only costs a recompile next time
+		writeCacheFile(key, *loaded);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Keep whichever copy got in first if another thread raced us to the same key
+	shader = m_shaders.insert(std::make_pair(key, std::shared_ptr<const CompiledShader>(loaded))).first->second;
+
+	return true;
+}
+
+uint32_t ShaderCache::getNumMemoryHits() const{
+	return m_numMemoryHits;
+}
+
+uint32_t ShaderCache::getNumDiskHits() const{
+	return m_numDiskHits;
+}
+
+uint32_t ShaderCache::getNumCompiles() const{
+	return m_numCompiles;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+////////////////////////
+// Shader cache class //
+////////////////////////
+
+struct ShaderDefine{
+	std::string name;
+	std::string value;
+};
+
+struct ShaderDesc{
+	std::wstring path;
+	std::string entryPoint;
+	std::string profile;
+	std::vector<ShaderDefine> defines;
+};
+
+// Bytecode plus the reflected input signature, the signature is only filled in for vertex shaders
+using CompiledShader = Util::VertexLayoutData;
+
+class ShaderCache{
+public:
+
+	// Compiles HLSL source into bytecode
+	typedef std::function<bool(const ShaderDesc &desc, const std::vector<uint8_t> &source, std::vector<uint8_t> &bytecode)> CompileFunc;
+
+	// Fills in the input signature of shader.bytecode
+	typedef std::function<bool(const ShaderDesc &desc, CompiledShader &shader)> ReflectFunc;
+
+	static const uint32_t Magic		= 0x43444853; // "SHDC"
+	static const uint32_t Version	= 1;
+
+private:
+	std::wstring m_directory;
+	CompileFunc m_compile;
+	ReflectFunc m_reflect;
+
+	// Mixed into every key, changes whenever the compiler does
+	uint64_t m_salt;
+
+	std::unordered_map<uint64_t, std::shared_ptr<const CompiledShader>> m_shaders;
+	std::mutex m_mutex;
+
+	std::atomic<uint32_t> m_numMemoryHits, m_numDiskHits, m_numCompiles;
+
+	std::wstring getCachePath(uint64_t key) const;
+
+	bool readCacheFile(uint64_t key, CompiledShader &shader) const;
+	bool writeCacheFile(uint64_t key, const CompiledShader &shader) const;
+
+public:
+
+	// Compiles with D3DCompile, cache files are kept in directory
+	ShaderCache(const std::wstring &directory);
+
+	// Custom compiler, salt should identify its version
+	ShaderCache(const std::wstring &directory, const CompileFunc &compile, const ReflectFunc &reflect, uint64_t salt);
+
+	// Hash of the source, entry point, profile and defines (in order), the compiler salt and the cache version
+	uint64_t computeKey(const ShaderDesc &desc, const std::vector<uint8_t> &source) const;
+
+	// Looks the shader up in memory, then on disk, and only compiles on a miss. Thread safe, so misses
+	// queued on several workers compile in parallel
+	bool get(const ShaderDesc &desc, std::shared_ptr<const CompiledShader> &shader);
+
+	uint32_t getNumMemoryHits() const;
+	uint32_t getNumDiskHits() const;
+	uint32_t getNumCompiles() const;
+};
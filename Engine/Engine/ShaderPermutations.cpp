@@ -0,0 +1,66 @@
+#include "Engine.h"
+
+ShaderPermutations::ShaderPermutations(const ShaderDesc &base) : m_base(base){
+	m_numBits = 0;
+}
+
+bool ShaderPermutations::addKeywordGroup(const std::vector<std::string> &keywords){
+	Group group = {keywords, m_numBits, 0};
+
+	while((1u << group.bits) < keywords.size()) group.bits++;
+
+	// The variant table is indexed by mask, so keep it to a sane size
+	if(keywords.empty() || m_numBits + group.bits > 16) return false;
+
+	for(uint32_t i = 0; i < keywords.size(); i++){
+		if(!keywords[i].empty() && m_keywords.count(keywords[i])) return false;
+	}
+
+	for(uint32_t i = 0; i < keywords.size(); i++){
+		KeywordBits bits = {i << group.shift, ((1u << group.bits) - 1) << group.shift};
+
+		if(!keywords[i].empty()) m_keywords[keywords[i]] = bits;
+	}
+
+	m_groups.push_back(group);
+	m_numBits += group.bits;
+
+	return true;
+}
+
+uint32_t ShaderPermutations::setKeyword(uint32_t mask, const std::string &keyword) const{
+	auto it = m_keywords.find(keyword);
+
+	if(it == m_keywords.end()) return mask;
+
+	return (mask & ~it->second.fieldMask) | it->second.value;
+}
+
+uint32_t ShaderPermutations::getNumVariants() const{
+	return 1u << m_numBits;
+}
+
+bool ShaderPermutations::isValid(uint32_t mask) const{
+	if(mask >= getNumVariants()) return false;
+
+	for(const auto &group : m_groups){
+		if(((mask >> group.shift) & ((1u << group.bits) - 1)) >= group.keywords.size()) return false;
+	}
+
+	return true;
+}
+
+ShaderDesc ShaderPermutations::getDesc(uint32_t mask) const{
+	ShaderDesc desc = m_base;
+
+	for(const auto &group : m_groups){
+		uint32_t option = (mask >> group.shift) & ((1u << group.bits) - 1);
+
+		if(option < group.keywords.size() && !group.keywords[option].empty()){
+			ShaderDefine define = {group.keywords[option], "1"};
+			desc.defines.push_back(define);
+		}
+	}
+
+	return desc;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+//////////////////////////////
+// Shader permutation class //
+//////////////////////////////
+
+// Keywords are declared in groups of mutually exclusive options, each group owns a bit field of the
+// variant mask wide enough for its options. An empty option name defines nothing
+class ShaderPermutations{
+private:
+	struct Group{
+		std::vector<std::string> keywords;
+		uint32_t shift, bits;
+	};
+
+	ShaderDesc m_base;
+	std::vector<Group> m_groups;
+	uint32_t m_numBits;
+
+	// Group field value selecting a keyword, and the mask of the whole field
+	struct KeywordBits{
+		uint32_t value, fieldMask;
+	};
+
+	std::unordered_map<std::string, KeywordBits> m_keywords;
+
+public:
+	ShaderPermutations(const ShaderDesc &base);
+
+	// The first option is what a zero mask selects
+	bool addKeywordGroup(const std::vector<std::string> &keywords);
+
+	// Returns mask with the keyword's group switched to that keyword, or mask unchanged for an unknown keyword
+	uint32_t setKeyword(uint32_t mask, const std::string &keyword) const;
+
+	// Every mask below getNumVariants() indexes a variant table, but only valid ones select an option in every group
+	uint32_t getNumVariants() const;
+	bool isValid(uint32_t mask) const;
+
+	// Base description plus the selected keyword of every group defined to 1
+	ShaderDesc getDesc(uint32_t mask) const;
+};
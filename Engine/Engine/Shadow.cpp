@@ -3,6 +3,11 @@
 ShadowMapper::ShadowMapper(ID3D11Device *device, uint32_t width, uint32_t height, ID3D11VertexShader *vertexShader, 
 	ID3D11InputLayout *layout) : m_vertexShader(vertexShader), m_layout(layout){
 
+	m_texture			= nullptr;
+	m_depthView			= nullptr;
+	m_shaderView		= nullptr;
+	m_constantBuffer	= nullptr;
+
 	D3D11_TEXTURE2D_DESC depthDesc = {0};
 	D3D11_DEPTH_STENCIL_VIEW_DESC depthViewDesc;
 	D3D11_SHADER_RESOURCE_VIEW_DESC depthShaderViewDesc;
@@ -31,7 +36,18 @@ ShadowMapper::ShadowMapper(ID3D11Device *device, uint32_t width, uint32_t height
 
 	// Create the 2D-texture for writing depth to, create the shader-view and depth-view
 	// to be able to manipulate this texture
-	if(FAILED(device->CreateTexture2D(&depthDesc, NULL, &m_texture))) return;
+	GpuMemoryTag tag(L"Shadow map");
+	GpuAllocationId allocation = ReserveGpuMemory(GpuMemoryDepthStencil, DirectX::GetTextureMemorySize(width, height, 1, 1, 1, depthDesc.Format));
+
+	// Over budget, the mapper stays invalid
+	if(allocation == GpuMemoryTracker::InvalidAllocation) return;
+
+	if(FAILED(device->CreateTexture2D(&depthDesc, NULL, &m_texture))){
+		BindGpuMemory(nullptr, allocation);
+		return;
+	}
+
+	BindGpuMemory(m_texture, allocation);
 
 	if(FAILED(device->CreateDepthStencilView(m_texture, &depthViewDesc, &m_depthView))){
 		ReleaseCOM(m_texture);
@@ -41,9 +57,11 @@ ShadowMapper::ShadowMapper(ID3D11Device *device, uint32_t width, uint32_t height
 	if(FAILED(device->CreateShaderResourceView(m_texture, &depthShaderViewDesc, &m_shaderView))){
 		ReleaseCOM(m_texture);
 		ReleaseCOM(m_depthView);
+		return;
 	}
 
-	m_cbData = (ShadowMapConstantBufferData *)_aligned_malloc(sizeof(ShadowMapConstantBufferData), 16);
+	DirectX::XMStoreFloat4x4(&m_view, DirectX::XMMatrixIdentity());
+	DirectX::XMStoreFloat4x4(&m_proj, DirectX::XMMatrixIdentity());
 
 	Util::CreateConstantBuffer(device, sizeof(ShadowMapConstantBufferData), &m_constantBuffer, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
 }
@@ -52,6 +70,10 @@ ShadowMapper::~ShadowMapper(){
 
 }
 
+bool ShadowMapper::isValid() const{
+	return m_texture && m_depthView && m_shaderView && m_constantBuffer;
+}
+
 void ShadowMapper::startShadowRender(ID3D11DeviceContext *context, const Camera &light){
 
 	// Clear depth texture and set rendering to only target depth
@@ -65,16 +87,10 @@ void ShadowMapper::startShadowRender(ID3D11DeviceContext *context, const Camera
 	context->IASetInputLayout(m_layout);
 
 	// Set/update constant buffer then update it
-	D3D11_MAPPED_SUBRESOURCE mappedSubRsrc;
-
-	context->Map(m_constantBuffer, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &mappedSubRsrc);
-
-	m_cbData->world = DirectX::XMMatrixIdentity();
-	m_cbData->view = light.getViewMatrix();
-	m_cbData->proj = light.getProjMatrix();
-	memcpy(mappedSubRsrc.pData, m_cbData, sizeof(ShadowMapConstantBufferData));
+	DirectX::XMStoreFloat4x4(&m_view, light.getViewMatrix());
+	DirectX::XMStoreFloat4x4(&m_proj, light.getProjMatrix());
 
-	context->Unmap(m_constantBuffer, NULL);
+	writeConstantBuffer(context, DirectX::XMMatrixIdentity());
 	context->VSSetConstantBuffers(0, 1, &m_constantBuffer);
 
 	// Set vertex shader and null pixel shader
@@ -85,16 +101,29 @@ void ShadowMapper::startShadowRender(ID3D11DeviceContext *context, const Camera
 void ShadowMapper::setWorldMatrix(ID3D11DeviceContext *context, const DirectX::XMMATRIX &world){
 	
 	// Update constant buffer with new world matrix
+	writeConstantBuffer(context, world);
+}
+
+void ShadowMapper::writeConstantBuffer(ID3D11DeviceContext *context, const DirectX::XMMATRIX &world){
 	D3D11_MAPPED_SUBRESOURCE mappedSubRsrc;
 
-	context->Map(m_constantBuffer, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &mappedSubRsrc);
+	if(FAILED(context->Map(m_constantBuffer, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &mappedSubRsrc))) return;
+
+	// Mapped memory is 16 byte aligned, write straight into it rather than through a CPU-side copy
+	ShadowMapConstantBufferData *data = static_cast<ShadowMapConstantBufferData *>(mappedSubRsrc.pData);
 
-	m_cbData->world = world;
-	memcpy(mappedSubRsrc.pData, m_cbData, sizeof(ShadowMapConstantBufferData));
+	data->world = world;
+	data->view = DirectX::XMLoadFloat4x4(&m_view);
+	data->proj = DirectX::XMLoadFloat4x4(&m_proj);
 
 	context->Unmap(m_constantBuffer, NULL);
 }
 
+void ShadowMapper::setShader(ID3D11VertexShader *vertexShader, ID3D11InputLayout *layout){
+	m_vertexShader	= vertexShader;
+	m_layout		= layout;
+}
+
 ID3D11ShaderResourceView * ShadowMapper::getShadowTextureView() const{
 	return m_shaderView;
 }
@@ -18,17 +18,25 @@ private:
 	ID3D11InputLayout *m_layout;
 	ID3D11VertexShader *m_vertexShader;
 
-	// GPU and CPU constant buffer
+	// Light matrices are kept to refill the constant buffer, every map discards it
 	ID3D11Buffer *m_constantBuffer;
-	ShadowMapConstantBufferData *m_cbData;
+	DirectX::XMFLOAT4X4 m_view, m_proj;
+
+	void writeConstantBuffer(ID3D11DeviceContext *context, const DirectX::XMMATRIX &world);
 
 public:
 	ShadowMapper(ID3D11Device *device, uint32_t width, uint32_t height, ID3D11VertexShader *vertexShader, 
 		ID3D11InputLayout *layout);
 	~ShadowMapper();
 
+	// False if the depth texture or the constant buffer couldn't be created, e.g. over the GPU memory budget
+	bool isValid() const;
+
 	void startShadowRender(ID3D11DeviceContext *context, const Camera &light);
 	void setWorldMatrix(ID3D11DeviceContext *context, const DirectX::XMMATRIX &world);
+
+	// Replaces the depth-only vertex shader, e.g. after it was reloaded
+	void setShader(ID3D11VertexShader *vertexShader, ID3D11InputLayout *layout);
 	
 	ID3D11ShaderResourceView * getShadowTextureView() const;
 };
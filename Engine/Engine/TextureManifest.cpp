@@ -0,0 +1,64 @@
+#include "Engine.h"
+
+void ScanTextureDirectory(const std::wstring &directory, std::vector<TextureManifestEntry> &entries, TextureScanStats &stats,
+	uint32_t numThreads){
+
+	Timer timer;
+	TimeStamp scanStart, scanEnd;
+
+	timer.createTimeStamp(scanStart);
+
+	std::vector<std::wstring> files;
+
+	Util::FindFiles(directory, L"*.dds", files);
+	std::sort(files.begin(), files.end());
+
+	entries.resize(files.size());
+
+	// Every file is independent and only its headers are read, so the scan is bound by open/read latency
+	Util::ParallelRanges(files.size(), numThreads, [&](size_t begin, size_t end){
+		for(size_t i = begin; i < end; i++){
+			entries[i].path		= files[i];
+			entries[i].result	= DirectX::GetDDSMetadataFromFile((directory + L"\\" + files[i]).c_str(), entries[i].metadata);
+		}
+	});
+
+	timer.createTimeStamp(scanEnd);
+
+	stats.numFiles		= entries.size();
+	stats.numFailed		= 0;
+	stats.totalBytes	= 0;
+
+	for(const auto &entry : entries){
+		if(FAILED(entry.result)) stats.numFailed++;
+		else stats.totalBytes += entry.metadata.dataSize;
+	}
+
+	stats.seconds			= timer.getDeltaTime(scanStart, scanEnd);
+	stats.filesPerSecond	= stats.seconds > 0.0 ? stats.numFiles / stats.seconds : 0.0;
+}
+
+bool WriteTextureManifest(const std::wstring &path, const std::vector<TextureManifestEntry> &entries){
+	std::string text;
+	char line[512];
+
+	for(const auto &entry : entries){
+		int length = WideCharToMultiByte(CP_UTF8, 0, entry.path.c_str(), static_cast<int>(entry.path.size()), line, sizeof(line) - 1, NULL, NULL);
+
+		text.append(line, std::max(length, 0));
+
+		if(FAILED(entry.result)){
+			sprintf_s(line, ",error 0x%08X\n", static_cast<uint32_t>(entry.result));
+		}
+		else{
+			const DirectX::DDS_METADATA &metadata = entry.metadata;
+
+			sprintf_s(line, ",%u,%Iu,%Iu,%Iu,%Iu,%Iu,%llu\n", static_cast<uint32_t>(metadata.format), metadata.width, metadata.height,
+				metadata.depth, metadata.mipCount, metadata.arraySize, metadata.dataSize);
+		}
+
+		text += line;
+	}
+
+	return Util::WriteMemoryToFile(path, text.data(), text.size());
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+///////////////////////////////
+// Texture metadata scanning //
+///////////////////////////////
+
+struct TextureManifestEntry{
+	// Relative to the scanned directory
+	std::wstring path;
+
+	HRESULT result;
+	DirectX::DDS_METADATA metadata;
+};
+
+struct TextureScanStats{
+	size_t numFiles, numFailed;
+
+	// Sum of the bit data of every texture that parsed
+	uint64_t totalBytes;
+
+	double seconds, filesPerSecond;
+};
+
+// Reads the headers of every .DDS file under directory on numThreads threads (0 uses every core),
+// entries come back sorted by path
+void ScanTextureDirectory(const std::wstring &directory, std::vector<TextureManifestEntry> &entries, TextureScanStats &stats,
+	uint32_t numThreads = 0);
+
+// Writes one line per texture: path, format, width, height, depth, mips, array size and bytes
+bool WriteTextureManifest(const std::wstring &path, const std::vector<TextureManifestEntry> &entries);
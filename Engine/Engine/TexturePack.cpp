@@ -0,0 +1,282 @@
+#include "Engine.h"
+
+namespace{
+
+// Lowercase UTF-8 with forward slashes
+std::string NormalizeName(std::wstring name){
+	for(auto &c : name){
+		c = c == L'\\' ? L'/' : towlower(c);
+	}
+
+	int size = WideCharToMultiByte(CP_UTF8, 0, name.c_str(), static_cast<int>(name.size()), NULL, 0, NULL, NULL);
+	std::string result(std::max(size, 0), '\0');
+
+	if(size > 0) WideCharToMultiByte(CP_UTF8, 0, name.c_str(), static_cast<int>(name.size()), &result[0], size, NULL, NULL);
+
+	return result;
+}
+
+// Writes data and pads with zeros up to the next multiple of alignment
+bool WriteAligned(HANDLE file, const void *data, size_t size, uint32_t alignment, uint64_t &position){
+	DWORD written = 0;
+
+	if(size && (!WriteFile(file, data, static_cast<DWORD>(size), &written, NULL) || written != size)) return false;
+
+	position += size;
+
+	static const uint8_t Zeros[512] = {0};
+	uint64_t padding = (alignment - position % alignment) % alignment;
+
+	while(padding > 0){
+		DWORD chunk = static_cast<DWORD>(std::min<uint64_t>(padding, sizeof(Zeros)));
+
+		if(!WriteFile(file, Zeros, chunk, &written, NULL) || written != chunk) return false;
+
+		padding		-= chunk;
+		position	+= chunk;
+	}
+
+	return true;
+}
+
+bool CompareEntries(const TexturePackEntry &a, const TexturePackEntry &b){
+	return a.nameHash < b.nameHash;
+}
+
+}
+
+TexturePack::TexturePack(){
+	m_file		= nullptr;
+	m_mapping	= nullptr;
+	m_view		= nullptr;
+	m_size		= 0;
+	m_header	= nullptr;
+	m_entries	= nullptr;
+	m_names		= nullptr;
+}
+
+TexturePack::~TexturePack(){
+	close();
+}
+
+bool TexturePack::open(const std::wstring &path){
+	close();
+
+	m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+
+	if(m_file == INVALID_HANDLE_VALUE){
+		m_file = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+
+	if(!GetFileSizeEx(m_file, &size) || static_cast<uint64_t>(size.QuadPart) < sizeof(TexturePackHeader) || static_cast<uint64_t>(size.QuadPart) > SIZE_MAX){
+		close();
+		return false;
+	}
+
+	m_size		= size.QuadPart;
+	m_mapping	= CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if(!m_mapping){
+		close();
+		return false;
+	}
+
+	m_view = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if(!m_view){
+		close();
+		return false;
+	}
+
+	m_header = reinterpret_cast<const TexturePackHeader *>(m_view);
+
+	// Everything the index points at has to be inside the file
+	bool valid = m_header->magic == Magic && m_header->version == Version && m_header->alignment != 0 &&
+		m_header->indexOffset <= m_size && m_header->numEntries <= (m_size - m_header->indexOffset) / sizeof(TexturePackEntry) &&
+		m_header->namesOffset <= m_size && m_header->namesSize <= m_size - m_header->namesOffset;
+
+	if(valid){
+		m_entries	= reinterpret_cast<const TexturePackEntry *>(m_view + m_header->indexOffset);
+		m_names		= reinterpret_cast<const char *>(m_view + m_header->namesOffset);
+
+		for(uint32_t i = 0; i < m_header->numEntries && valid; i++){
+			const TexturePackEntry &entry = m_entries[i];
+
+			valid = entry.offset <= m_size && entry.size <= m_size - entry.offset &&
+				static_cast<uint64_t>(entry.nameOffset) + entry.nameLength <= m_header->namesSize;
+		}
+	}
+
+	if(!valid){
+		close();
+		return false;
+	}
+
+	// Lookups are relative to the directory holding the pack
+	std::vector<wchar_t> directory(path.begin(), path.end());
+	directory.push_back(L'\0');
+
+	PathRemoveFileSpecW(&directory[0]);
+
+	m_root = NormalizeTexturePackPath(directory[0] ? &directory[0] : L".") + "/";
+
+	return true;
+}
+
+void TexturePack::close(){
+	if(m_view)		UnmapViewOfFile(m_view);
+	if(m_mapping)	CloseHandle(m_mapping);
+	if(m_file)		CloseHandle(m_file);
+
+	m_file		= nullptr;
+	m_mapping	= nullptr;
+	m_view		= nullptr;
+	m_size		= 0;
+	m_header	= nullptr;
+	m_entries	= nullptr;
+	m_names		= nullptr;
+
+	m_root.clear();
+}
+
+bool TexturePack::isOpen() const{
+	return m_view != nullptr;
+}
+
+const TexturePackEntry *TexturePack::findEntry(const std::wstring &path) const{
+	if(!isOpen()) return nullptr;
+
+	std::string name = NormalizeTexturePackPath(path);
+
+	if(name.compare(0, m_root.size(), m_root) != 0) return nullptr;
+
+	name.erase(0, m_root.size());
+
+	// Binary search on the hash, then compare names in case of a collision
+	TexturePackEntry key = {Util::HashFNV1a(name.data(), name.size())};
+	const TexturePackEntry *end = m_entries + m_header->numEntries;
+
+	for(const TexturePackEntry *entry = std::lower_bound(m_entries, end, key, CompareEntries); entry != end && entry->nameHash == key.nameHash; entry++){
+		if(entry->nameLength == name.size() && name.compare(0, name.size(), m_names + entry->nameOffset, entry->nameLength) == 0) return entry;
+	}
+
+	return nullptr;
+}
+
+bool TexturePack::find(const std::wstring &path, const uint8_t **data, size_t *size) const{
+	const TexturePackEntry *entry = findEntry(path);
+
+	if(!entry) return false;
+
+	*data = m_view + entry->offset;
+	*size = static_cast<size_t>(entry->size);
+
+	return true;
+}
+
+uint32_t TexturePack::getNumEntries() const{
+	return isOpen() ? m_header->numEntries : 0;
+}
+
+std::string TexturePack::getEntryName(uint32_t index) const{
+	if(index >= getNumEntries()) return std::string();
+
+	return std::string(m_names + m_entries[index].nameOffset, m_entries[index].nameLength);
+}
+
+std::string NormalizeTexturePackPath(const std::wstring &path){
+	wchar_t fullPath[MAX_PATH];
+	DWORD length = GetFullPathNameW(path.c_str(), MAX_PATH, fullPath, NULL);
+
+	std::string name = NormalizeName(length > 0 && length < MAX_PATH ? std::wstring(fullPath, length) : path);
+
+	// Directories may come in with or without a trailing slash
+	while(!name.empty() && name.back() == '/') name.pop_back();
+
+	return name;
+}
+
+bool BuildTexturePack(const std::wstring &directory, const std::wstring &outPath, uint32_t alignment){
+	if(alignment == 0) return false;
+
+	// Sorted so the same directory always produces the same archive
+	std::vector<std::wstring> files;
+
+	Util::FindFiles(directory, L"*.dds", files);
+	std::sort(files.begin(), files.end());
+
+	HANDLE file = CreateFileW(outPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	TexturePackHeader header = {TexturePack::Magic, TexturePack::Version, 0, alignment};
+	std::vector<TexturePackEntry> entries;
+	std::string names;
+	uint64_t position = 0;
+
+	// Header first as a placeholder, it is rewritten once the index location is known
+	bool ok = WriteAligned(file, &header, sizeof(header), alignment, position);
+
+	for(size_t i = 0; i < files.size() && ok; i++){
+		std::vector<uint8_t> data;
+
+		if(!Util::ReadFileToMemory(directory + L"\\" + files[i], data)){
+			ok = false;
+			break;
+		}
+
+		// Only actual DDS files go in
+		if(data.size() < sizeof(uint32_t) || *reinterpret_cast<const uint32_t *>(&data[0]) != 0x20534444) continue;
+
+		// Single-mip surfaces get their chain built here so loading never has to, files that already have
+		// mips or that the generator can't handle go in as they are
+		std::vector<uint8_t> mipmapped;
+
+		if(SUCCEEDED(DirectX::GenerateDDSMipsFromMemory(&data[0], data.size(), MipGenerator::MipOptions(), mipmapped))) data.swap(mipmapped);
+
+		std::string name = NormalizeName(files[i]);
+		TexturePackEntry entry = {Util::HashFNV1a(name.data(), name.size()), position, data.size(), static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size())};
+
+		entries.push_back(entry);
+		names += name;
+
+		ok = WriteAligned(file, &data[0], data.size(), alignment, position);
+	}
+
+	std::sort(entries.begin(), entries.end(), CompareEntries);
+
+	// Name hashes have to be unique for the lookup to stay a single binary search
+	for(size_t i = 1; i < entries.size() && ok; i++){
+		ok = entries[i].nameHash != entries[i - 1].nameHash;
+	}
+
+	if(ok){
+		header.numEntries	= static_cast<uint32_t>(entries.size());
+		header.indexOffset	= position;
+
+		ok = entries.empty() || WriteAligned(file, &entries[0], entries.size() * sizeof(TexturePackEntry), sizeof(uint64_t), position);
+	}
+
+	if(ok){
+		header.namesOffset	= position;
+		header.namesSize	= names.size();
+
+		ok = WriteAligned(file, names.data(), names.size(), 1, position);
+	}
+
+	if(ok){
+		LARGE_INTEGER start = {0};
+		DWORD written = 0;
+
+		ok = SetFilePointerEx(file, start, NULL, FILE_BEGIN) && WriteFile(file, &header, sizeof(header), &written, NULL) && written == sizeof(header);
+	}
+
+	CloseHandle(file);
+
+	if(!ok) DeleteFileW(outPath.c_str());
+
+	return ok;
+}
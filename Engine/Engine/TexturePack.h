@@ -0,0 +1,67 @@
+#pragma once
+
+//////////////////////////
+// Texture pack archive //
+//////////////////////////
+
+// File layout: header, payloads at aligned offsets, the entry index sorted by name hash, then the name table
+struct TexturePackHeader{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t alignment;
+	uint64_t indexOffset;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+
+struct TexturePackEntry{
+	uint64_t nameHash;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+class TexturePack{
+private:
+	HANDLE m_file, m_mapping;
+	const uint8_t *m_view;
+	uint64_t m_size;
+
+	const TexturePackHeader *m_header;
+	const TexturePackEntry *m_entries;
+	const char *m_names;
+
+	// Normalized directory of the pack, lookups are made relative to it
+	std::string m_root;
+
+	const TexturePackEntry *findEntry(const std::wstring &path) const;
+
+public:
+	static const uint32_t Magic				= 0x4B415054; // "TPAK"
+	static const uint32_t Version			= 1;
+	static const uint32_t DefaultAlignment	= 4096;
+
+	TexturePack();
+	~TexturePack();
+
+	// Maps the whole archive and validates its index
+	bool open(const std::wstring &path);
+	void close();
+	bool isOpen() const;
+
+	// Payload of a packed file, path is the file's loose path and is matched relative to the pack's directory.
+	// The payload points into the mapping and stays valid until close(), callers use it in place
+	bool find(const std::wstring &path, const uint8_t **data, size_t *size) const;
+
+	uint32_t getNumEntries() const;
+	std::string getEntryName(uint32_t index) const;
+};
+
+// Full path, lowercased with forward slashes and UTF-8 encoded, so the same file always hashes the same
+std::string NormalizeTexturePackPath(const std::wstring &path);
+
+// Packs every .DDS file under directory (recursively) into a new archive at outPath, single-mip 2D
+// textures are stored with a full mip chain generated on the CPU
+bool BuildTexturePack(const std::wstring &directory, const std::wstring &outPath, uint32_t alignment = TexturePack::DefaultAlignment);
@@ -0,0 +1,486 @@
+#include "Engine.h"
+
+TextureStreamer::TextureStreamer(ID3D11Device *device, ID3D11DeviceContext *context, size_t budgetBytes, size_t minResidentSize) :
+	m_device(device), m_context(context), m_budget(budgetBytes), m_minResidentSize(minResidentSize){
+
+	m_pack			= nullptr;
+	m_residentBytes = 0;
+	m_frame			= 0;
+	m_quit			= false;
+
+	m_ioThread = std::thread(&TextureStreamer::ioThreadMain, this);
+}
+
+TextureStreamer::~TextureStreamer(){
+	{
+		std::lock_guard<std::mutex> lock(m_ioMutex);
+		m_quit = true;
+	}
+
+	m_ioSignal.notify_all();
+	m_ioThread.join();
+
+	for(auto &entry : m_entries){
+		ReleaseCOM(entry.view);
+		ReleaseCOM(entry.texture);
+	}
+}
+
+void TextureStreamer::ioThreadMain(){
+	while(true){
+		ReadRequest request;
+
+		{
+			std::unique_lock<std::mutex> lock(m_ioMutex);
+
+			m_ioSignal.wait(lock, [this]{ return m_quit || !m_requests.empty(); });
+
+			if(m_quit) return;
+
+			request = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		ReadResult result;
+
+		result.handle		= request.handle;
+		result.generation	= request.generation;
+		result.mip			= request.mip;
+		result.baseMip		= request.baseMip;
+
+		// A failed read comes back empty so the entry stops being pending
+		if(!readFile(request, result)){
+			result.data.clear();
+			result.bytes	= nullptr;
+			result.size		= 0;
+		}
+
+		// Moving the result keeps data's buffer, so bytes stays valid
+		std::lock_guard<std::mutex> lock(m_ioMutex);
+		m_results.push_back(std::move(result));
+	}
+}
+
+size_t TextureStreamer::GetMaxSize(const PreparedTexture &info, size_t mip){
+	return std::max<size_t>(1, std::max(info.fullWidth >> mip, info.fullHeight >> mip));
+}
+
+uint64_t TextureStreamer::GetMipOffset(const PreparedTexture &info, size_t mip){
+	return info.dataOffset + info.chainBytes[0] - info.chainBytes[mip];
+}
+
+bool TextureStreamer::readFile(const ReadRequest &request, ReadResult &result) const{
+	const uint8_t *packed;
+	size_t packedSize;
+
+	// Packed files are used in place
+	if(m_pack && m_pack->find(request.path, &packed, &packedSize)){
+		if(request.size && (request.offset > packedSize || request.size > packedSize - request.offset)) return false;
+
+		result.bytes	= request.size ? packed + request.offset : packed;
+		result.size		= request.size ? request.size : packedSize;
+
+		return true;
+	}
+
+	bool read = request.size ? Util::ReadFileRange(request.path, request.offset, request.size, result.data) :
+		Util::ReadFileToMemory(request.path, result.data);
+
+	result.bytes	= result.data.data();
+	result.size		= result.data.size();
+
+	return read;
+}
+
+void TextureStreamer::setTexturePack(const TexturePack *pack){
+	m_pack = pack;
+}
+
+StreamedTextureHandle TextureStreamer::load(const std::wstring &path){
+	const uint8_t *data;
+	size_t size;
+	MappedFile file;
+	PreparedTexture prepared;
+
+	// The pack's mapping or the loose file's, neither is copied
+	if(!m_pack || !m_pack->find(path, &data, &size)){
+		if(!file.open(path)) return InvalidHandle;
+
+		data = file.getData();
+		size = file.getSize();
+	}
+
+	if(!prepare(path, data, size, prepared)) return InvalidHandle;
+
+	return load(prepared, data, size);
+}
+
+bool TextureStreamer::prepare(const std::wstring &path, const uint8_t *data, size_t size, PreparedTexture &prepared) const{
+	size_t width, height, mipCount, numBytes;
+
+	if(!size) return false;
+
+	if(FAILED(DirectX::GetDDSTextureFootprintFromMemory(data, size, 0, &width, &height, &mipCount, &numBytes))){
+		return false;
+	}
+
+	prepared.path		= path;
+	prepared.fullWidth	= width;
+	prepared.fullHeight	= height;
+	prepared.minMip		= 0;
+
+	// Byte size of the resident chain for every possible top mip
+	prepared.chainBytes.clear();
+	prepared.chainBytes.push_back(numBytes);
+
+	for(size_t mip = 1; mip < mipCount; mip++){
+		size_t mipWidth, mipHeight, mipLevels;
+
+		if(FAILED(DirectX::GetDDSTextureFootprintFromMemory(data, size, GetMaxSize(prepared, mip), &mipWidth, &mipHeight, &mipLevels, &numBytes))){
+			break;
+		}
+
+		prepared.chainBytes.push_back(numBytes);
+	}
+
+	// Lowest detail level that always stays resident
+	while(prepared.minMip + 1 < prepared.chainBytes.size() && GetMaxSize(prepared, prepared.minMip) > m_minResidentSize){
+		prepared.minMip++;
+	}
+
+	// Mips are read on their own when the file holds exactly the chain the texture is created with
+	DirectX::DDS_METADATA metadata;
+
+	prepared.dataOffset		= 0;
+	prepared.streamsMips	= false;
+
+	if(SUCCEEDED(DirectX::GetDDSMetadataFromMemory(data, size, size, metadata))){
+		prepared.dataOffset		= metadata.headerSize;
+		prepared.streamsMips	= metadata.resourceDimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D && metadata.arraySize == 1 &&
+			!metadata.isCubeMap && metadata.mipCount == prepared.chainBytes.size();
+
+		for(size_t mip = 0; prepared.streamsMips && mip < metadata.mipCount; mip++){
+			prepared.streamsMips = metadata.subresources[mip].offset == GetMipOffset(prepared, mip);
+		}
+	}
+
+	return true;
+}
+
+StreamedTextureHandle TextureStreamer::load(const PreparedTexture &prepared, const uint8_t *data, size_t size){
+
+	// The low mips count against the budget like streamed ones
+	if(!reserve(prepared.chainBytes[prepared.minMip])) return InvalidHandle;
+
+	Entry entry;
+
+	entry.info			= prepared;
+	entry.residentMip	= prepared.chainBytes.size();
+	entry.requestedMip	= prepared.minMip;
+	entry.pending		= false;
+	entry.lastUsedFrame	= m_frame;
+	entry.generation	= 0;
+	entry.texture		= nullptr;
+	entry.view			= nullptr;
+
+	if(!makeResident(entry, data, size, prepared.minMip)) return InvalidHandle;
+
+	m_entries.push_back(entry);
+
+	return static_cast<StreamedTextureHandle>(m_entries.size() - 1);
+}
+
+bool TextureStreamer::reload(StreamedTextureHandle handle, const PreparedTexture &prepared, const uint8_t *data, size_t size){
+	if(handle >= m_entries.size()) return false;
+
+	Entry &entry = m_entries[handle];
+	size_t oldBytes = entry.residentMip < entry.info.chainBytes.size() ? entry.info.chainBytes[entry.residentMip] : 0;
+	size_t newBytes = prepared.chainBytes[prepared.minMip];
+
+	if(newBytes > oldBytes && !reserve(newBytes - oldBytes)) return false;
+
+	Entry reloaded = entry;
+
+	reloaded.info			= prepared;
+	reloaded.residentMip	= prepared.chainBytes.size();
+	reloaded.requestedMip	= prepared.minMip;
+	reloaded.pending		= false;
+	reloaded.generation		= entry.generation + 1;
+	reloaded.texture		= nullptr;
+	reloaded.view			= nullptr;
+
+	// The old texture stays bound if the new one can't be created
+	if(!makeResident(reloaded, data, size, prepared.minMip)) return false;
+
+	if(entry.residentMip < entry.info.chainBytes.size()) m_residentBytes -= entry.info.chainBytes[entry.residentMip];
+
+	ReleaseCOM(entry.view);
+	ReleaseCOM(entry.texture);
+
+	entry = reloaded;
+
+	return true;
+}
+
+void TextureStreamer::requestDetail(StreamedTextureHandle handle, float screenSize){
+	if(handle >= m_entries.size()) return;
+
+	Entry &entry = m_entries[handle];
+
+	// One texel per pixel: every halving of the on-screen size drops a mip
+	float ratio = static_cast<float>(std::max(entry.info.fullWidth, entry.info.fullHeight)) / std::max(screenSize, 1.0f);
+	size_t mip = ratio > 1.0f ? static_cast<size_t>(floorf(log2f(ratio))) : 0;
+
+	entry.requestedMip	= std::min(entry.requestedMip, std::min(mip, entry.info.minMip));
+	entry.lastUsedFrame	= m_frame;
+}
+
+void TextureStreamer::update(){
+	std::vector<ReadResult> results;
+
+	{
+		std::lock_guard<std::mutex> lock(m_ioMutex);
+		results.swap(m_results);
+	}
+
+	// Finalize reads that completed since the last frame
+	for(auto &result : results){
+		Entry &entry = m_entries[result.handle];
+
+		// Read for a texture that has been reloaded since
+		if(result.generation != entry.generation) continue;
+
+		entry.pending = false;
+
+		if(!result.size || result.mip >= entry.residentMip) continue;
+
+		// Only upgrade if the extra bytes fit, evicting colder textures first
+		if(!reserve(entry.info.chainBytes[result.mip] - entry.info.chainBytes[entry.residentMip])) continue;
+
+		if(!entry.info.streamsMips){
+			makeResident(entry, result.bytes, result.size, result.mip);
+		}
+
+		// The read only covers the mips above the ones resident when it was issued, if some were evicted since
+		// then the next request reads them again
+		else if(result.baseMip == entry.residentMip){
+			addTopMips(entry, result.bytes, result.size, result.mip);
+		}
+	}
+
+	// Issue reads for textures that want more detail than they have
+	bool issued = false;
+
+	for(size_t i = 0; i < m_entries.size(); i++){
+		Entry &entry = m_entries[i];
+
+		if(!entry.pending && entry.requestedMip < entry.residentMip){
+			ReadRequest request = {static_cast<StreamedTextureHandle>(i), entry.generation, entry.requestedMip, entry.residentMip, entry.info.path, 0, 0};
+
+			// Only the missing mips when they can be read on their own
+			if(entry.info.streamsMips){
+				request.offset	= GetMipOffset(entry.info, entry.requestedMip);
+				request.size	= entry.info.chainBytes[entry.requestedMip] - entry.info.chainBytes[entry.residentMip];
+			}
+
+			std::lock_guard<std::mutex> lock(m_ioMutex);
+			m_requests.push_back(request);
+
+			entry.pending	= true;
+			issued			= true;
+		}
+
+		// Feedback is gathered again every frame
+		entry.requestedMip = entry.info.minMip;
+	}
+
+	if(issued) m_ioSignal.notify_one();
+
+	// Stay within budget even without new uploads
+	reserve(0);
+
+	m_frame++;
+}
+
+bool TextureStreamer::makeResident(Entry &entry, const uint8_t *data, size_t size, size_t mip){
+	ID3D11Resource *texture = nullptr;
+	ID3D11ShaderResourceView *view = nullptr;
+	GpuMemoryTag tag(entry.info.path);
+
+	if(FAILED(DirectX::CreateDDSTextureFromMemory(m_device, data, size, &texture, &view, GetMaxSize(entry.info, mip)))){
+		return false;
+	}
+
+	// Swap in the new texture, the old one is released immediately
+	if(entry.residentMip < entry.info.chainBytes.size()) m_residentBytes -= entry.info.chainBytes[entry.residentMip];
+
+	ReleaseCOM(entry.view);
+	ReleaseCOM(entry.texture);
+
+	entry.texture		= texture;
+	entry.view			= view;
+	entry.residentMip	= mip;
+
+	m_residentBytes += entry.info.chainBytes[mip];
+
+	return true;
+}
+
+bool TextureStreamer::addTopMips(Entry &entry, const uint8_t *data, size_t size, size_t mip){
+	if(size != entry.info.chainBytes[mip] - entry.info.chainBytes[entry.residentMip]) return false;
+
+	ID3D11Texture2D *oldTexture = static_cast<ID3D11Texture2D *>(entry.texture);
+	D3D11_TEXTURE2D_DESC desc;
+
+	oldTexture->GetDesc(&desc);
+
+	UINT numAdded = static_cast<UINT>(entry.residentMip - mip);
+
+	desc.Width		= static_cast<UINT>(std::max<size_t>(1, entry.info.fullWidth >> mip));
+	desc.Height		= static_cast<UINT>(std::max<size_t>(1, entry.info.fullHeight >> mip));
+	desc.MipLevels	+= numAdded;
+
+	ID3D11Texture2D *texture;
+	ID3D11ShaderResourceView *view;
+
+	GpuMemoryTag tag(entry.info.path);
+	GpuAllocationId allocation = ReserveGpuMemory(GpuMemoryTexture,
+		DirectX::GetTextureMemorySize(desc.Width, desc.Height, 1, desc.MipLevels, 1, desc.Format));
+
+	if(allocation == GpuMemoryTracker::InvalidAllocation) return false;
+
+	if(FAILED(m_device->CreateTexture2D(&desc, nullptr, &texture))){
+		BindGpuMemory(nullptr, allocation);
+		return false;
+	}
+
+	BindGpuMemory(texture, allocation);
+
+	if(FAILED(m_device->CreateShaderResourceView(texture, nullptr, &view))){
+		texture->Release();
+		return false;
+	}
+
+	// The new mips are uploaded from the read, largest first like in the file
+	size_t offset = 0;
+
+	for(UINT level = 0; level < numAdded; level++){
+		size_t rowBytes, numBytes;
+
+		DirectX::GetSurfacePitch(std::max<UINT>(1, desc.Width >> level), std::max<UINT>(1, desc.Height >> level), desc.Format, &rowBytes, &numBytes);
+
+		m_context->UpdateSubresource(texture, level, nullptr, &data[offset], static_cast<UINT>(rowBytes), static_cast<UINT>(numBytes));
+		offset += numBytes;
+	}
+
+	// The resident ones are copied over on the GPU
+	for(UINT level = numAdded; level < desc.MipLevels; level++){
+		m_context->CopySubresourceRegion(texture, level, 0, 0, 0, oldTexture, level - numAdded, nullptr);
+	}
+
+	m_residentBytes -= entry.info.chainBytes[entry.residentMip];
+
+	ReleaseCOM(entry.view);
+	ReleaseCOM(entry.texture);
+
+	entry.texture		= texture;
+	entry.view			= view;
+	entry.residentMip	= mip;
+
+	m_residentBytes += entry.info.chainBytes[mip];
+
+	return true;
+}
+
+bool TextureStreamer::evictTopMip(Entry &entry){
+	D3D11_RESOURCE_DIMENSION dimension;
+
+	entry.texture->GetType(&dimension);
+
+	if(dimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D) return false;
+
+	ID3D11Texture2D *oldTexture = static_cast<ID3D11Texture2D *>(entry.texture);
+	D3D11_TEXTURE2D_DESC desc;
+
+	oldTexture->GetDesc(&desc);
+
+	// Arrays and cube maps keep their full chain, only plain 2D textures are trimmed in place
+	if(desc.ArraySize != 1 || desc.MipLevels <= 1 || (desc.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE)) return false;
+
+	desc.Width		= std::max<UINT>(1, desc.Width >> 1);
+	desc.Height		= std::max<UINT>(1, desc.Height >> 1);
+	desc.MipLevels	-= 1;
+
+	ID3D11Texture2D *texture;
+	ID3D11ShaderResourceView *view;
+
+	GpuMemoryTag tag(entry.info.path);
+	GpuAllocationId allocation = ReserveGpuMemory(GpuMemoryTexture,
+		DirectX::GetTextureMemorySize(desc.Width, desc.Height, 1, desc.MipLevels, 1, desc.Format));
+
+	if(allocation == GpuMemoryTracker::InvalidAllocation) return false;
+
+	if(FAILED(m_device->CreateTexture2D(&desc, nullptr, &texture))){
+		BindGpuMemory(nullptr, allocation);
+		return false;
+	}
+
+	BindGpuMemory(texture, allocation);
+
+	if(FAILED(m_device->CreateShaderResourceView(texture, nullptr, &view))){
+		texture->Release();
+		return false;
+	}
+
+	// Copy the remaining mips down one level on the GPU
+	for(UINT mip = 0; mip < desc.MipLevels; mip++){
+		m_context->CopySubresourceRegion(texture, mip, 0, 0, 0, oldTexture, mip + 1, nullptr);
+	}
+
+	m_residentBytes -= entry.info.chainBytes[entry.residentMip];
+
+	ReleaseCOM(entry.view);
+	ReleaseCOM(entry.texture);
+
+	entry.texture		= texture;
+	entry.view			= view;
+	entry.residentMip	+= 1;
+
+	m_residentBytes += entry.info.chainBytes[entry.residentMip];
+
+	return true;
+}
+
+bool TextureStreamer::reserve(size_t bytes){
+	while(m_residentBytes + bytes > m_budget){
+
+		// Least recently used texture that still has evictable detail and was not used this frame
+		Entry *victim = nullptr;
+
+		for(auto &entry : m_entries){
+			if(entry.residentMip >= entry.info.minMip || entry.lastUsedFrame >= m_frame) continue;
+
+			if(!victim || entry.lastUsedFrame < victim->lastUsedFrame) victim = &entry;
+		}
+
+		if(!victim || !evictTopMip(*victim)) return false;
+	}
+
+	return true;
+}
+
+ID3D11ShaderResourceView *TextureStreamer::getView(StreamedTextureHandle handle) const{
+	return handle < m_entries.size() ? m_entries[handle].view : nullptr;
+}
+
+size_t TextureStreamer::getResidentMip(StreamedTextureHandle handle) const{
+	return handle < m_entries.size() ? m_entries[handle].residentMip : 0;
+}
+
+size_t TextureStreamer::getResidentBytes() const{
+	return m_residentBytes;
+}
+
+size_t TextureStreamer::getBudget() const{
+	return m_budget;
+}
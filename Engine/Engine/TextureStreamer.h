@@ -0,0 +1,129 @@
+#pragma once
+
+/////////////////////////////
+// Texture streaming class //
+/////////////////////////////
+
+using StreamedTextureHandle = uint32_t;
+
+// CPU-side description of a streamed texture, built without touching the device
+struct PreparedTexture{
+	std::wstring path;
+
+	// Full size of the texture and the byte size of the chain starting at each mip
+	size_t fullWidth, fullHeight;
+	std::vector<size_t> chainBytes;
+
+	// Lowest detail mip that is never evicted
+	size_t minMip;
+
+	// Plain 2D textures store their mips one after another after the headers, the bytes of mip m then start
+	// at dataOffset + chainBytes[0] - chainBytes[m] and missing mips are read on their own
+	size_t dataOffset;
+	bool streamsMips;
+};
+
+class TextureStreamer{
+private:
+	struct Entry{
+		PreparedTexture info;
+
+		// Currently resident and requested top mips
+		size_t residentMip, requestedMip;
+
+		bool pending;
+		uint64_t lastUsedFrame;
+
+		// Bumped by reload(), reads issued before it are dropped
+		uint32_t generation;
+
+		ID3D11Resource *texture;
+		ID3D11ShaderResourceView *view;
+	};
+
+	// Reads mips [mip, baseMip) when the texture streams its mips, otherwise the whole file (size 0)
+	struct ReadRequest{
+		StreamedTextureHandle handle;
+		uint32_t generation;
+		size_t mip, baseMip;
+		std::wstring path;
+		uint64_t offset;
+		size_t size;
+	};
+
+	// Bytes points into the pack's mapping for packed files, loose ones are read into data
+	struct ReadResult{
+		StreamedTextureHandle handle;
+		uint32_t generation;
+		size_t mip, baseMip;
+		std::vector<uint8_t> data;
+		const uint8_t *bytes;
+		size_t size;
+	};
+
+	ID3D11Device *m_device;
+	ID3D11DeviceContext *m_context;
+
+	// Optional archive tried before loose files
+	const TexturePack *m_pack;
+
+	std::vector<Entry> m_entries;
+	size_t m_budget, m_residentBytes, m_minResidentSize;
+	uint64_t m_frame;
+
+	// File reads happen on the I/O thread, resources are created on the thread calling update()
+	std::thread m_ioThread;
+	std::mutex m_ioMutex;
+	std::condition_variable m_ioSignal;
+	std::deque<ReadRequest> m_requests;
+	std::vector<ReadResult> m_results;
+	bool m_quit;
+
+	void ioThreadMain();
+	bool readFile(const ReadRequest &request, ReadResult &result) const;
+
+	bool makeResident(Entry &entry, const uint8_t *data, size_t size, size_t mip);
+
+	// Creates a texture with the mips read from the file above the resident ones and copies the resident ones
+	// over on the GPU
+	bool addTopMips(Entry &entry, const uint8_t *data, size_t size, size_t mip);
+	bool evictTopMip(Entry &entry);
+	bool reserve(size_t bytes);
+
+	static size_t GetMaxSize(const PreparedTexture &info, size_t mip);
+	static uint64_t GetMipOffset(const PreparedTexture &info, size_t mip);
+
+public:
+	static const StreamedTextureHandle InvalidHandle = 0xFFFFFFFF;
+
+	TextureStreamer(ID3D11Device *device, ID3D11DeviceContext *context, size_t budgetBytes, size_t minResidentSize);
+	~TextureStreamer();
+
+	// Reads go through the pack when it holds the file, must be set before the first load
+	void setTexturePack(const TexturePack *pack);
+
+	// Loads only the mips no larger than the minimum resident size, higher mips are streamed in on request.
+	// Fails if the low mips don't fit the budget
+	StreamedTextureHandle load(const std::wstring &path);
+
+	// Split version of load(), prepare() validates the file and computes its layout and is safe to call
+	// from any thread, load() then creates the low mips and must run on the thread calling update()
+	bool prepare(const std::wstring &path, const uint8_t *data, size_t size, PreparedTexture &prepared) const;
+	StreamedTextureHandle load(const PreparedTexture &prepared, const uint8_t *data, size_t size);
+
+	// Replaces the texture behind handle with a newly prepared one, it starts over from the low mips. Same
+	// threading as load()
+	bool reload(StreamedTextureHandle handle, const PreparedTexture &prepared, const uint8_t *data, size_t size);
+
+	// Mip feedback, screenSize is how many pixels the texture roughly covers on screen this frame
+	void requestDetail(StreamedTextureHandle handle, float screenSize);
+
+	// Creates textures for finished reads, issues new reads and evicts least recently used mips
+	void update();
+
+	ID3D11ShaderResourceView *getView(StreamedTextureHandle handle) const;
+	size_t getResidentMip(StreamedTextureHandle handle) const;
+
+	size_t getResidentBytes() const;
+	size_t getBudget() const;
+};
@@ -1,7 +1,11 @@
 #include "Engine.h"
 
 Timer::Timer(){
+#if defined(_WIN32)
 	QueryPerformanceFrequency(&m_freq);
+#else
+	m_freq.QuadPart = 1000000000;
+#endif
 }
 
 Timer::~Timer(){
@@ -9,7 +13,14 @@ Timer::~Timer(){
 }
 
 void Timer::createTimeStamp(TimeStamp &stamp) const{
+#if defined(_WIN32)
 	QueryPerformanceCounter(&stamp);
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	stamp.QuadPart = static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#endif
 }
 
 double Timer::getDeltaTime(const TimeStamp &stampA, const TimeStamp &stampB) const{
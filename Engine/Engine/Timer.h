@@ -1,10 +1,18 @@
 #pragma once
 
+#if defined(_WIN32)
 using TimeStamp = LARGE_INTEGER;
+#else
+
+// Same layout as LARGE_INTEGER, counts CLOCK_MONOTONIC nanoseconds
+union TimeStamp{
+	int64_t QuadPart;
+};
+#endif
 
 class Timer{
 private:
-	LARGE_INTEGER m_freq;
+	TimeStamp m_freq;
 
 public:
 	Timer();
@@ -13,3 +21,15 @@ public:
 	void createTimeStamp(TimeStamp &stamp) const;
 	double getDeltaTime(const TimeStamp &stampA, const TimeStamp &stampB) const;
 };
+
+// CPU cycle counter, much cheaper to read than a time stamp but has to be calibrated against one
+inline uint64_t ReadCycleCounter(){
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	return __rdtsc();
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#endif
+}
@@ -0,0 +1,291 @@
+#include "Engine.h"
+
+namespace{
+
+size_t AlignUp(size_t value, size_t alignment){
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+UploadRing::UploadRing(size_t capacity) : m_capacity(capacity){
+	m_head		= 0;
+	m_tail		= 0;
+	m_used		= 0;
+	m_pending	= 0;
+	m_peak		= 0;
+	m_lastHead	= 0;
+	m_lastBytes	= 0;
+}
+
+size_t UploadRing::allocate(size_t size, size_t alignment){
+	if(size == 0 || size > m_capacity) return InvalidOffset;
+
+	// Nothing in flight, start over at the beginning so the whole ring is one free range
+	if(m_used == 0){
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	size_t begin = AlignUp(m_head, alignment);
+	size_t bytes;
+
+	// Free space runs from the head to the end and on from the start to the tail, unless the head has
+	// already wrapped around and is behind the tail
+	if(m_head > m_tail || m_used == 0){
+		if(begin + size <= m_capacity){
+			bytes = begin + size - m_head;
+		}
+		else if(size <= m_tail){
+
+			// The rest of the ring is skipped, it's freed with this allocation's fence
+			bytes	= m_capacity - m_head + size;
+			begin	= 0;
+		}
+		else{
+			return InvalidOffset;
+		}
+	}
+	else{
+		if(begin + size > m_tail) return InvalidOffset;
+
+		bytes = begin + size - m_head;
+	}
+
+	m_lastHead	= m_head;
+	m_lastBytes	= bytes;
+
+	m_head		= begin + size;
+	m_used		+= bytes;
+	m_pending	+= bytes;
+	m_peak		= std::max(m_peak, m_used);
+
+	return begin;
+}
+
+void UploadRing::rollback(){
+	m_head		= m_lastHead;
+	m_used		-= m_lastBytes;
+	m_pending	-= m_lastBytes;
+	m_lastBytes	= 0;
+}
+
+void UploadRing::submit(uint64_t fence){
+	m_lastBytes = 0;
+
+	if(m_pending == 0) return;
+
+	Marker marker = {fence, m_head, m_pending};
+
+	m_markers.push_back(marker);
+	m_pending = 0;
+}
+
+void UploadRing::retire(uint64_t completedFence){
+	while(!m_markers.empty() && m_markers.front().fence <= completedFence){
+		m_tail = m_markers.front().end;
+		m_used -= m_markers.front().bytes;
+
+		m_markers.pop_front();
+	}
+}
+
+size_t UploadRing::getCapacity() const{
+	return m_capacity;
+}
+
+size_t UploadRing::getUsed() const{
+	return m_used;
+}
+
+size_t UploadRing::getPeak() const{
+	return m_peak;
+}
+
+size_t UploadRing::getNumInFlight() const{
+	return m_markers.size();
+}
+
+UploadManager::UploadManager(ID3D11Device *device, ID3D11DeviceContext *context, size_t capacity) : m_context(context), m_ring(capacity){
+	m_buffer	= nullptr;
+	m_mapped	= nullptr;
+	m_discarded	= false;
+	m_nextFence	= 1;
+
+	memset(&m_stats, 0, sizeof(UploadStats));
+
+	// Every upload goes through UpdateSubresource if anything here is missing
+	for(uint32_t i = 0; i < MaxFences; i++){
+		ID3D11Query *query;
+		D3D11_QUERY_DESC queryDesc = {D3D11_QUERY_EVENT, 0};
+
+		if(FAILED(device->CreateQuery(&queryDesc, &query))) return;
+
+		m_freeQueries.push_back(query);
+	}
+
+	// A dynamic vertex buffer can be mapped without waiting on the GPU, which a staging one can't
+	D3D11_BUFFER_DESC bufferDesc = {0};
+
+	bufferDesc.ByteWidth		= static_cast<UINT>(capacity);
+	bufferDesc.Usage			= D3D11_USAGE_DYNAMIC;
+	bufferDesc.BindFlags		= D3D11_BIND_VERTEX_BUFFER;
+	bufferDesc.CPUAccessFlags	= D3D11_CPU_ACCESS_WRITE;
+
+	GpuMemoryTag tag(L"Upload ring");
+	GpuAllocationId allocation = ReserveGpuMemory(GpuMemoryStaging, capacity);
+
+	// Without the ring every upload falls back to UpdateSubresource
+	if(allocation == GpuMemoryTracker::InvalidAllocation) return;
+
+	if(FAILED(device->CreateBuffer(&bufferDesc, NULL, &m_buffer))) m_buffer = nullptr;
+
+	BindGpuMemory(m_buffer, allocation);
+}
+
+UploadManager::~UploadManager(){
+	if(m_mapped) m_context->Unmap(m_buffer, 0);
+
+	for(auto &copy : m_copies){
+		copy.destination->Release();
+	}
+
+	for(auto &fence : m_fences){
+		fence.query->Release();
+	}
+
+	for(auto query : m_freeQueries){
+		query->Release();
+	}
+
+	ReleaseCOM(m_buffer);
+}
+
+bool UploadManager::map(){
+	if(m_mapped) return true;
+
+	// Discard once so the driver knows the contents are undefined, afterwards the fences keep the CPU off
+	// the bytes the GPU still reads
+	D3D11_MAPPED_SUBRESOURCE mapped;
+
+	if(FAILED(m_context->Map(m_buffer, 0, m_discarded ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return false;
+
+	m_mapped	= static_cast<uint8_t *>(mapped.pData);
+	m_discarded	= true;
+
+	return true;
+}
+
+void UploadManager::flush(){
+	if(m_mapped){
+		m_context->Unmap(m_buffer, 0);
+		m_mapped = nullptr;
+	}
+
+	if(m_copies.empty()) return;
+
+	// Out of fences, the oldest one has to finish first
+	if(m_freeQueries.empty()){
+		Fence oldest = m_fences.front();
+
+		m_stats.numFenceWaits++;
+
+		while(m_context->GetData(oldest.query, NULL, 0, 0) == S_FALSE){
+			std::this_thread::yield();
+		}
+
+		m_ring.retire(oldest.value);
+		m_freeQueries.push_back(oldest.query);
+
+		m_fences.pop_front();
+	}
+
+	for(auto &copy : m_copies){
+		D3D11_BOX box = {copy.sourceOffset, 0, 0, copy.sourceOffset + copy.size, 1, 1};
+
+		m_context->CopySubresourceRegion(copy.destination, 0, copy.destinationOffset, 0, 0, m_buffer, 0, &box);
+		copy.destination->Release();
+	}
+
+	Fence fence = {m_freeQueries.back(), m_nextFence++};
+
+	m_freeQueries.pop_back();
+	m_context->End(fence.query);
+	m_fences.push_back(fence);
+	m_ring.submit(fence.value);
+
+	m_copies.clear();
+}
+
+void UploadManager::retire(){
+	while(!m_fences.empty() && m_context->GetData(m_fences.front().query, NULL, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK){
+		m_ring.retire(m_fences.front().value);
+		m_freeQueries.push_back(m_fences.front().query);
+
+		m_fences.pop_front();
+	}
+}
+
+void UploadManager::upload(ID3D11Buffer *destination, UINT offset, const void *data, UINT size){
+	if(!destination || !data || size == 0) return;
+
+	m_stats.numUploads++;
+	m_stats.bytesUploaded += size;
+
+	size_t source = m_buffer ? m_ring.allocate(size, Alignment) : UploadRing::InvalidOffset;
+
+	// Full, send off what's queued and take back whatever the GPU has finished since
+	if(m_buffer && source == UploadRing::InvalidOffset){
+		flush();
+		retire();
+
+		source = m_ring.allocate(size, Alignment);
+	}
+
+	if(source == UploadRing::InvalidOffset || !map()){
+
+		// Nothing will be copied from the space, it mustn't wait for a fence that only a later copy brings
+		if(source != UploadRing::InvalidOffset) m_ring.rollback();
+
+		// Still no room, write it directly. The queued copies were flushed above so they can't land after this
+		D3D11_BOX box = {offset, 0, 0, offset + size, 1, 1};
+
+		flush();
+		m_context->UpdateSubresource(destination, 0, &box, data, 0, 0);
+
+		m_stats.numDirectUploads++;
+		m_stats.bytesDirect += size;
+
+		return;
+	}
+
+	memcpy(m_mapped + source, data, size);
+
+	PendingCopy copy = {destination, offset, static_cast<UINT>(source), size};
+
+	destination->AddRef();
+	m_copies.push_back(copy);
+}
+
+void UploadManager::submit(){
+	m_stats.lastBatchSize = static_cast<uint32_t>(m_copies.size());
+
+	if(!m_copies.empty()) m_stats.numBatches++;
+
+	flush();
+	retire();
+}
+
+const UploadStats &UploadManager::getStats() const{
+	return m_stats;
+}
+
+std::string UploadManager::formatStats() const{
+	char text[512];
+
+	sprintf_s(text, "Uploads: %llu (%.2f MB), %llu direct (%.2f MB), %llu batches, %llu fence waits, ring %.2f / %.2f MB peak\n",
+		m_stats.numUploads, m_stats.bytesUploaded / (1024.0 * 1024.0), m_stats.numDirectUploads, m_stats.bytesDirect / (1024.0 * 1024.0),
+		m_stats.numBatches, m_stats.numFenceWaits, m_ring.getPeak() / (1024.0 * 1024.0), m_ring.getCapacity() / (1024.0 * 1024.0));
+
+	return text;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+//////////////////////////
+// Upload manager class //
+//////////////////////////
+
+// Byte ring whose space is reused once the GPU has passed the fence it was submitted under. Only does the
+// accounting, allocations never wrap around the end
+class UploadRing{
+public:
+	static const size_t InvalidOffset = ~static_cast<size_t>(0);
+
+private:
+	struct Marker{
+		uint64_t fence;
+
+		// Where the head was at the submit and the bytes the fence holds, alignment and wrap padding included
+		size_t end, bytes;
+	};
+
+	size_t m_capacity;
+
+	// Allocations go at the head, the oldest in-flight byte is at the tail
+	size_t m_head, m_tail;
+	size_t m_used, m_pending, m_peak;
+
+	// Head before the last allocation and the bytes it took, for rollback()
+	size_t m_lastHead, m_lastBytes;
+
+	std::deque<Marker> m_markers;
+
+public:
+	UploadRing(size_t capacity);
+
+	// InvalidOffset while the space is still in flight
+	size_t allocate(size_t size, size_t alignment);
+
+	// Gives back the last allocation, only valid before the next allocate() or submit()
+	void rollback();
+
+	// Everything allocated since the last submit completes with fence, fences must increase
+	void submit(uint64_t fence);
+
+	// Frees the space of every fence up to and including completedFence
+	void retire(uint64_t completedFence);
+
+	size_t getCapacity() const;
+	size_t getUsed() const;
+	size_t getPeak() const;
+	size_t getNumInFlight() const;
+};
+
+struct UploadStats{
+	uint64_t numUploads, bytesUploaded;
+
+	// Uploads that went through UpdateSubresource because the ring was full
+	uint64_t numDirectUploads, bytesDirect;
+
+	// Copies issued by the last submit, not counting flushes of a full ring, and submits that issued any
+	uint32_t lastBatchSize;
+	uint64_t numBatches;
+
+	uint64_t numFenceWaits;
+};
+
+// Uploads buffer contents through a ring in a dynamic buffer, the copies into the destinations are issued
+// together once per frame and fenced with event queries. Textures keep their initial data at creation since
+// D3D11 can't copy a buffer into a texture. Main thread only
+class UploadManager{
+public:
+	static const size_t DefaultCapacity		= 8 * 1024 * 1024;
+	static const uint32_t MaxFences			= 8;
+	static const size_t Alignment			= 16;
+
+private:
+	struct PendingCopy{
+		ID3D11Buffer *destination;
+		UINT destinationOffset, sourceOffset, size;
+	};
+
+	struct Fence{
+		ID3D11Query *query;
+		uint64_t value;
+	};
+
+	ID3D11DeviceContext *m_context;
+	ID3D11Buffer *m_buffer;
+
+	UploadRing m_ring;
+	uint8_t *m_mapped;
+	bool m_discarded;
+
+	// Copies wait here until the ring is unmapped, the destinations are held until then
+	std::vector<PendingCopy> m_copies;
+
+	std::deque<Fence> m_fences;
+	std::vector<ID3D11Query *> m_freeQueries;
+	uint64_t m_nextFence;
+
+	UploadStats m_stats;
+
+	UploadManager(const UploadManager &) = delete;
+	UploadManager &operator=(const UploadManager &) = delete;
+
+	bool map();
+
+	// Unmaps the ring and issues the pending copies under a new fence
+	void flush();
+	void retire();
+
+public:
+	UploadManager(ID3D11Device *device, ID3D11DeviceContext *context, size_t capacity = DefaultCapacity);
+	~UploadManager();
+
+	// Copies data into destination at offset, the copy lands before anything drawn after the next submit. The
+	// destination can't be immutable
+	void upload(ID3D11Buffer *destination, UINT offset, const void *data, UINT size);
+
+	// Issues the frame's copies, call once per frame before drawing
+	void submit();
+
+	const UploadStats &getStats() const;
+	std::string formatStats() const;
+};
@@ -20,13 +20,16 @@ bool CreateVertexShaderFromBinary(ID3D11Device *device, const std::wstring &path
 	if(file != INVALID_HANDLE_VALUE){
 		DWORD bytesRead;
 		DWORD size = GetFileSize(file, NULL);
-		uint8_t *buffer = new uint8_t[size];
+		ScratchScope scratch;
+		uint8_t *buffer = scratch.allocateArray<uint8_t>(size);
 
-		ReadFile(file, buffer, size, &bytesRead, NULL);
+		if(!buffer || !ReadFile(file, buffer, size, &bytesRead, NULL)){
+			CloseHandle(file);
+			return false;
+		}
 
 		HRESULT result = device->CreateVertexShader(buffer, bytesRead, NULL, shaderObj);
 
-		delete[] buffer;
 		CloseHandle(file);
 
 		return SUCCEEDED(result);
@@ -41,12 +44,16 @@ bool CreatePixelShaderFromBinary(ID3D11Device *device, const std::wstring &path,
 	if(file != INVALID_HANDLE_VALUE){
 		DWORD bytesRead;
 		DWORD size = GetFileSize(file, NULL);
-		uint8_t *buffer = new uint8_t[size];
+		ScratchScope scratch;
+		uint8_t *buffer = scratch.allocateArray<uint8_t>(size);
+
+		if(!buffer || !ReadFile(file, buffer, size, &bytesRead, NULL)){
+			CloseHandle(file);
+			return false;
+		}
 
-		ReadFile(file, buffer, size, &bytesRead, NULL);
 		HRESULT result = device->CreatePixelShader(buffer, bytesRead, NULL, shaderObj);
 
-		delete[] buffer;
 		CloseHandle(file);
 
 		return SUCCEEDED(result);
@@ -124,6 +131,127 @@ bool CreateConstantBuffer(ID3D11Device *device, uint32_t size, ID3D11Buffer **co
 	return *constantBuffer != nullptr;
 }
 
+bool ReadFileToMemory(const std::wstring &path, std::vector<uint8_t> &data){
+	HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+
+	if(!GetFileSizeEx(file, &size) || size.HighPart > 0){
+		CloseHandle(file);
+		return false;
+	}
+
+	data.resize(size.LowPart);
+
+	DWORD bytesRead = 0;
+	BOOL result = data.empty() || ReadFile(file, &data[0], size.LowPart, &bytesRead, NULL);
+
+	CloseHandle(file);
+
+	return result && bytesRead == size.LowPart;
+}
+
+bool ReadFileRange(const std::wstring &path, uint64_t offset, size_t size, std::vector<uint8_t> &data){
+	if(size > MAXDWORD) return false;
+
+	HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER position;
+
+	position.QuadPart = static_cast<LONGLONG>(offset);
+	data.resize(size);
+
+	DWORD bytesRead = 0;
+	BOOL result = SetFilePointerEx(file, position, NULL, FILE_BEGIN) && (data.empty() || ReadFile(file, &data[0], static_cast<DWORD>(size), &bytesRead, NULL));
+
+	CloseHandle(file);
+
+	return result && bytesRead == size;
+}
+
+bool WriteMemoryToFile(const std::wstring &path, const void *data, size_t size){
+	if(size > MAXDWORD) return false;
+
+	HANDLE file = CreateFile(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	DWORD bytesWritten = 0;
+	BOOL result = size == 0 || WriteFile(file, data, static_cast<DWORD>(size), &bytesWritten, NULL);
+
+	CloseHandle(file);
+
+	return result && bytesWritten == size;
+}
+
+void FindFiles(const std::wstring &directory, const std::wstring &pattern, std::vector<std::wstring> &files){
+	std::vector<std::wstring> pending(1);
+
+	// Directories still to visit, relative to the root and with a trailing separator
+	while(!pending.empty()){
+		std::wstring relative = pending.back();
+		pending.pop_back();
+
+		WIN32_FIND_DATAW findData;
+		HANDLE find = FindFirstFileW((directory + L"\\" + relative + L"*").c_str(), &findData);
+
+		if(find == INVALID_HANDLE_VALUE) continue;
+
+		do{
+			std::wstring name = findData.cFileName;
+
+			if(name == L"." || name == L"..") continue;
+
+			if(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY){
+				pending.push_back(relative + name + L"\\");
+			}
+			else if(PathMatchSpecW(name.c_str(), pattern.c_str())){
+				files.push_back(relative + name);
+			}
+		} while(FindNextFileW(find, &findData));
+
+		FindClose(find);
+	}
+}
+
+uint64_t HashFNV1a(const void *data, size_t size, uint64_t hash){
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+	for(size_t i = 0; i < size; i++){
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+void ParallelRanges(size_t count, uint32_t numThreads, const std::function<void(size_t begin, size_t end)> &func){
+	if(numThreads == 0) numThreads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+
+	numThreads = static_cast<uint32_t>(std::min<size_t>(numThreads, count));
+
+	if(numThreads <= 1){
+		func(0, count);
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	size_t perThread = (count + numThreads - 1) / numThreads;
+
+	// The calling thread takes the last range itself
+	for(size_t begin = 0; begin + perThread < count; begin += perThread){
+		threads.push_back(std::thread(func, begin, begin + perThread));
+	}
+
+	func(threads.size() * perThread, count);
+
+	for(auto &thread : threads) thread.join();
+}
+
 HWND CreateSimpleWindow(HINSTANCE instance, const std::wstring &wndName, const std::wstring &className,
 	uint32_t width, uint32_t height){
 
@@ -221,7 +349,23 @@ bool InitalizeD3D(HWND wndHandle, uint32_t width, uint32_t height, uint32_t leve
 	depthStencilDesc.CPUAccessFlags		= 0;
 	depthStencilDesc.MiscFlags			= 0;
 
-	(*device)->CreateTexture2D(&depthStencilDesc, NULL, &depthTexture);
+	GpuAllocationId depthAllocation = ReserveGpuMemory(GpuMemoryDepthStencil,
+		DirectX::GetTextureMemorySize(width, height, 1, 1, 1, depthStencilDesc.Format) * levelMSAA);
+
+	if(depthAllocation == GpuMemoryTracker::InvalidAllocation){
+		DbgOut(L"Depth buffer is over the GPU memory budget");
+		backBuffer->Release();
+		return false;
+	}
+
+	if(FAILED((*device)->CreateTexture2D(&depthStencilDesc, NULL, &depthTexture))){
+		BindGpuMemory(nullptr, depthAllocation);
+		DbgOut(L"Depth buffer creation failed");
+		backBuffer->Release();
+		return false;
+	}
+
+	BindGpuMemory(depthTexture, depthAllocation);
 	(*device)->CreateDepthStencilView(depthTexture, NULL, depthView);
 
 	// Use the back buffer address as the render target along with our depth buffer
@@ -245,6 +389,14 @@ bool InitalizeD3D(HWND wndHandle, uint32_t width, uint32_t height, uint32_t leve
 }
 
 bool CreateVertexLayoutFromFile(ID3D11Device *device, const std::wstring &path, const std::string &entryPt, ID3D11InputLayout **layout){
+	VertexLayoutData layoutData;
+
+	if(!ReflectVertexLayoutFromFile(path, entryPt, layoutData)) return false;
+
+	return CreateVertexLayout(device, layoutData, layout);
+}
+
+bool ReflectVertexLayoutFromFile(const std::wstring &path, const std::string &entryPt, VertexLayoutData &layoutData){
 
 	// Compile vertex shader from file first
 	HRESULT result;
@@ -257,14 +409,22 @@ bool CreateVertexLayoutFromFile(ID3D11Device *device, const std::wstring &path,
 		return false;
 	}
 
-	// Grab reflection info
-	ID3D11ShaderReflection *reflection;
+	const uint8_t *bytecode = static_cast<const uint8_t *>(shaderBlob->GetBufferPointer());
+
+	layoutData.bytecode.assign(bytecode, bytecode + shaderBlob->GetBufferSize());
 
-	if(FAILED(D3DReflect(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection, (void **)&reflection))){
+	shaderBlob->Release();
 
-		ReleaseCOM(shaderBlob);
+	return ReflectVertexLayout(layoutData);
+}
+
+bool ReflectVertexLayout(VertexLayoutData &layoutData){
+	if(layoutData.bytecode.empty()) return false;
 
+	// Grab reflection info
+	ID3D11ShaderReflection *reflection;
+
+	if(FAILED(D3DReflect(&layoutData.bytecode[0], layoutData.bytecode.size(), IID_ID3D11ShaderReflection, (void **)&reflection))){
 		return false;
 	}
 
@@ -276,14 +436,17 @@ bool CreateVertexLayoutFromFile(ID3D11Device *device, const std::wstring &path,
 	// Read input layout description from shader info
 	D3D11_INPUT_ELEMENT_DESC descElement;
 	D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
+
+	layoutData.semanticNames.clear();
+	layoutData.elements.clear();
 
 	for(std::uint32_t i = 0; i < shaderDesc.InputParameters; i++){
 		reflection->GetInputParameterDesc(i, &paramDesc);
 
-		// Fill in info
-		descElement.SemanticName = paramDesc.SemanticName;
+		// Fill in info, the name is fixed up when the layout is created
+		descElement.SemanticName = nullptr;
 		descElement.SemanticIndex = paramDesc.SemanticIndex;
+		descElement.Format = DXGI_FORMAT_UNKNOWN;
 		descElement.InputSlot = 0;
 		descElement.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 		descElement.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -311,19 +474,36 @@ bool CreateVertexLayoutFromFile(ID3D11Device *device, const std::wstring &path,
 			else if(paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32)	descElement.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
 		}
 
-		inputLayoutDesc.push_back(descElement);
+		layoutData.semanticNames.push_back(paramDesc.SemanticName);
+		layoutData.elements.push_back(descElement);
 	}
 
-	// Build input layout
-	device->CreateInputLayout(&inputLayoutDesc[0], inputLayoutDesc.size(), shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(), layout);
-
 	// Clean up
 	reflection->Release();
 
 	return true;
 }
 
+bool CreateVertexLayout(ID3D11Device *device, const VertexLayoutData &layoutData, ID3D11InputLayout **layout){
+	if(layoutData.elements.empty() || layoutData.bytecode.empty()) return false;
+
+	// Point the semantic names at the strings owned by the layout data
+	ScratchScope scratch;
+	size_t numElements = layoutData.elements.size();
+	D3D11_INPUT_ELEMENT_DESC *inputLayoutDesc = scratch.allocateArray<D3D11_INPUT_ELEMENT_DESC>(numElements);
+
+	if(!inputLayoutDesc) return false;
+
+	for(size_t i = 0; i < numElements; i++){
+		inputLayoutDesc[i] = layoutData.elements[i];
+		inputLayoutDesc[i].SemanticName = layoutData.semanticNames[i].c_str();
+	}
+
+	// Build input layout
+	return SUCCEEDED(device->CreateInputLayout(inputLayoutDesc, numElements, &layoutData.bytecode[0],
+		layoutData.bytecode.size(), layout));
+}
+
 ID3D11Buffer *BuildBuffer(ID3D11Device *device, const void *data, uint32_t size, D3D11_BIND_FLAG bindFlag, D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG access){
 
 	// Build buffer
@@ -338,10 +518,18 @@ ID3D11Buffer *BuildBuffer(ID3D11Device *device, const void *data, uint32_t size,
 
 	initalData.pSysMem = data;
 
+	// Counted against the GPU memory budget first
+	GpuAllocationId allocation = ReserveGpuMemory(GetGpuMemoryCategory(bindFlag, usage), size);
+
+	if(allocation == GpuMemoryTracker::InvalidAllocation) return nullptr;
+
 	if(FAILED(device->CreateBuffer(&bufferDesc, data ? &initalData : NULL, &buffer))){
+		BindGpuMemory(nullptr, allocation);
 		return nullptr;
 	}
 
+	BindGpuMemory(buffer, allocation);
+
 	return buffer;
 }
 
@@ -6,6 +6,13 @@
 
 #define ReleaseCOM(x) if(x) (x)->Release(); (x) = nullptr;
 
+// VS2013 has no thread_local, its own keyword works for plain pointers and integers
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL thread_local
+#endif
+
 namespace Util{
 
 struct D3DInitData{
@@ -20,8 +27,8 @@ struct D3DInitData{
 };
 
 struct VertexBufferCreationData{
-	void *vertexData;
-	uint32_t *indexData;
+	const void *vertexData;
+	const uint32_t *indexData;
 
 	uint32_t numVertices;
 	uint32_t numIndices;
@@ -29,6 +36,14 @@ struct VertexBufferCreationData{
 	uint32_t vertexElementSize;
 };
 
+struct VertexLayoutData{
+	std::vector<uint8_t> bytecode;
+
+	// Element semantic names point into semanticNames once the layout is created
+	std::vector<std::string> semanticNames;
+	std::vector<D3D11_INPUT_ELEMENT_DESC> elements;
+};
+
 //////////////////////
 // Client functions //
 //////////////////////
@@ -50,11 +65,37 @@ bool CreatePixelShaderFromFile(ID3D11Device *device, const std::wstring &path, c
 // Creates a vertex input layout from a vertex shader file (.HLSL)
 bool CreateVertexLayoutFromFile(ID3D11Device *device, const std::wstring &path, const std::string &entryPt, ID3D11InputLayout **layout);
 
+// Compiles a vertex shader file (.HLSL) and reflects its input layout without touching the device
+bool ReflectVertexLayoutFromFile(const std::wstring &path, const std::string &entryPt, VertexLayoutData &layoutData);
+
+// Reflects the input signature of already compiled vertex shader bytecode (layoutData.bytecode)
+bool ReflectVertexLayout(VertexLayoutData &layoutData);
+
+// Creates a vertex input layout from reflected data
+bool CreateVertexLayout(ID3D11Device *device, const VertexLayoutData &layoutData, ID3D11InputLayout **layout);
+
 // Creates vertex/index/constant buffers
 bool CreateVertexIndexBuffer(ID3D11Device *device, const VertexBufferCreationData &data, ID3D11Buffer **vertexBuffer, ID3D11Buffer **indexBuffer, 
 	D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG access);
 bool CreateConstantBuffer(ID3D11Device *device, uint32_t size, ID3D11Buffer **constantBuffer, D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG access);
 
+// Reads a whole file into memory, or writes memory out as a whole file
+bool ReadFileToMemory(const std::wstring &path, std::vector<uint8_t> &data);
+bool WriteMemoryToFile(const std::wstring &path, const void *data, size_t size);
+
+// Reads size bytes starting at offset, fails if the file ends before them
+bool ReadFileRange(const std::wstring &path, uint64_t offset, size_t size, std::vector<uint8_t> &data);
+
+// Recursively lists the files under directory whose names match pattern (e.g. L"*.dds"), paths are relative to directory
+void FindFiles(const std::wstring &directory, const std::wstring &pattern, std::vector<std::wstring> &files);
+
+// 64-bit FNV-1a, pass a previous result as hash to continue hashing across several buffers
+static const uint64_t FNVOffsetBasis = 14695981039346656037ULL;
+uint64_t HashFNV1a(const void *data, size_t size, uint64_t hash = FNVOffsetBasis);
+
+// Splits [0, count) into contiguous ranges and runs them on numThreads threads (0 uses every core)
+void ParallelRanges(size_t count, uint32_t numThreads, const std::function<void(size_t begin, size_t end)> &func);
+
 //////////////////////
 // Helper functions //
 //////////////////////
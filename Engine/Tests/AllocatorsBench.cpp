@@ -0,0 +1,183 @@
+#include "Engine.h"
+#include "Test.h"
+
+#include <chrono>
+
+namespace{
+
+const uint32_t NumTemporaries	= 4096;
+const uint32_t NumFrames		= 2000;
+const uint32_t NumThreadFrames	= 20;
+const uint32_t NumLiveObjects	= 1024;
+const uint32_t NumPoolOps		= 2000000;
+
+// Keeps the allocations from being optimized away
+volatile uintptr_t g_sink;
+
+double ElapsedNs(Test::Clock::time_point start, double count){
+	return std::chrono::duration<double, std::nano>(Test::Clock::now() - start).count() / count;
+}
+
+// A frame's worth of temporaries between 16 and 2064 bytes, then everything released at once
+void BenchTemporaries(const std::vector<size_t> &sizes){
+	std::vector<void *> pointers(sizes.size());
+	LinearAllocator frame("Bench frame", 16 << 20);
+	double count = static_cast<double>(sizes.size()) * NumFrames;
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t f = 0; f < NumFrames; f++){
+		for(size_t i = 0; i < sizes.size(); i++){
+			pointers[i] = malloc(sizes[i]);
+			*static_cast<char *>(pointers[i]) = 1;
+		}
+
+		for(size_t i = 0; i < sizes.size(); i++) free(pointers[i]);
+	}
+
+	double mallocNs = ElapsedNs(start, count);
+
+	start = Test::Clock::now();
+
+	for(uint32_t f = 0; f < NumFrames; f++){
+		for(size_t i = 0; i < sizes.size(); i++){
+			pointers[i] = frame.allocate(sizes[i]);
+			*static_cast<char *>(pointers[i]) = 1;
+		}
+
+		frame.reset();
+	}
+
+	double frameNs = ElapsedNs(start, count);
+
+	// Once to grow the arena, the rest reuse its block
+	{
+		ScratchScope scratch;
+
+		for(size_t i = 0; i < sizes.size(); i++) scratch.allocate(sizes[i]);
+	}
+
+	start = Test::Clock::now();
+
+	for(uint32_t f = 0; f < NumFrames; f++){
+		ScratchScope scratch;
+
+		for(size_t i = 0; i < sizes.size(); i++){
+			pointers[i] = scratch.allocate(sizes[i]);
+			*static_cast<char *>(pointers[i]) = 1;
+		}
+	}
+
+	double scratchNs = ElapsedNs(start, count);
+
+	std::printf("temporaries      malloc+free %6.1f ns, frame %6.1f ns, scratch %6.1f ns\n", mallocNs, frameNs, scratchNs);
+}
+
+// Threads allocating at once, each from the heap or all from one frame allocator
+void BenchThreads(const std::vector<size_t> &sizes, uint32_t numThreads){
+	double count = static_cast<double>(numThreads) * sizes.size() * NumThreadFrames;
+	std::vector<std::thread> threads;
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t t = 0; t < numThreads; t++){
+		threads.push_back(std::thread([&]{
+			std::vector<void *> pointers(sizes.size());
+
+			for(uint32_t f = 0; f < NumThreadFrames; f++){
+				for(size_t i = 0; i < sizes.size(); i++) pointers[i] = malloc(sizes[i]);
+				for(size_t i = 0; i < sizes.size(); i++) free(pointers[i]);
+			}
+		}));
+	}
+
+	for(auto &thread : threads) thread.join();
+
+	double mallocNs = ElapsedNs(start, count);
+
+	LinearAllocator shared("Bench shared", numThreads * sizes.size() * NumThreadFrames * 2080);
+
+	threads.clear();
+	start = Test::Clock::now();
+
+	for(uint32_t t = 0; t < numThreads; t++){
+		threads.push_back(std::thread([&]{
+			for(uint32_t f = 0; f < NumThreadFrames; f++){
+				for(size_t i = 0; i < sizes.size(); i++) g_sink = reinterpret_cast<uintptr_t>(shared.allocate(sizes[i]));
+			}
+		}));
+	}
+
+	for(auto &thread : threads) thread.join();
+
+	double sharedNs = ElapsedNs(start, count);
+
+	AllocatorStats stats;
+
+	shared.getStats(stats);
+
+	if(stats.numFailed != 0) Test::g_failures++;
+
+	std::printf("%u threads        malloc+free %6.1f ns, shared frame %6.1f ns\n", numThreads, mallocNs, sharedNs);
+}
+
+// Random objects freed and replaced, the way entity chunks and jobs come and go
+void BenchPool(size_t objectSize){
+	Test::Random random(1);
+	std::vector<void *> live(NumLiveObjects);
+
+	for(auto &object : live) object = malloc(objectSize);
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumPoolOps; i++){
+		uint32_t index = random.range(0u, NumLiveObjects);
+
+		free(live[index]);
+		live[index] = malloc(objectSize);
+		*static_cast<char *>(live[index]) = 1;
+	}
+
+	double mallocNs = ElapsedNs(start, NumPoolOps);
+
+	for(auto object : live) free(object);
+
+	PoolAllocator pool("Bench pool", objectSize, 64, 64);
+
+	for(auto &object : live) object = pool.allocate();
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumPoolOps; i++){
+		uint32_t index = random.range(0u, NumLiveObjects);
+
+		pool.free(live[index]);
+		live[index] = pool.allocate();
+		*static_cast<char *>(live[index]) = 1;
+	}
+
+	double poolNs = ElapsedNs(start, NumPoolOps);
+
+	std::printf("%5zu byte objects malloc+free %6.1f ns, pool %6.1f ns\n", objectSize, mallocNs, poolNs);
+}
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	Test::Random random(1);
+	std::vector<size_t> sizes(NumTemporaries);
+
+	for(auto &size : sizes) size = 16 + random.range(0u, 2048u);
+
+	std::printf("%u temporaries per frame, ns per allocation\n", NumTemporaries);
+
+	BenchTemporaries(sizes);
+	BenchThreads(sizes, 2);
+	BenchThreads(sizes, 4);
+	BenchPool(64);
+	BenchPool(EntityWorld::ChunkSize);
+
+	return Test::g_failures ? 1 : 0;
+}
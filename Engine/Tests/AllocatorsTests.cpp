@@ -0,0 +1,218 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+bool IsAligned(const void *pointer, size_t alignment){
+	return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+}
+
+uint32_t CountScratchArenas(){
+	std::vector<AllocatorStats> stats;
+	uint32_t numArenas = 0;
+
+	TrackedAllocator::getAllStats(stats);
+
+	for(auto &allocator : stats) numArenas += allocator.name.compare(0, 8, "Scratch ") == 0;
+
+	return numArenas;
+}
+
+// Aligned ranges that never overlap, failures are counted and a reset starts over
+void TestLinear(){
+	LinearAllocator allocator("Test linear", 4096);
+	AllocatorStats stats;
+
+	uint8_t *a = static_cast<uint8_t *>(allocator.allocate(10, 16));
+	uint8_t *b = static_cast<uint8_t *>(allocator.allocate(10, 64));
+
+	CHECK(a && b && IsAligned(a, 16) && IsAligned(b, 64) && b >= a + 10);
+	CHECK(!allocator.allocate(5000));
+
+	allocator.getStats(stats);
+	CHECK(stats.numAllocations == 2 && stats.numFailed == 1 && stats.used == static_cast<size_t>(b + 10 - a));
+
+	allocator.reset();
+	allocator.getStats(stats);
+	CHECK(stats.used == 0 && stats.peak >= 74);
+	CHECK(allocator.allocate(10, 16) == a);
+
+	// Threads allocating at once each get their own memory
+	LinearAllocator shared("Test shared", 1 << 20);
+	std::vector<std::thread> threads;
+	std::vector<std::vector<uint32_t *>> results(4);
+
+	for(uint32_t t = 0; t < 4; t++){
+		threads.push_back(std::thread([&, t]{
+			for(uint32_t i = 0; i < 1000; i++){
+				uint32_t *values = shared.allocateArray<uint32_t>(16);
+
+				for(uint32_t k = 0; k < 16; k++) values[k] = t * 100000 + i;
+
+				results[t].push_back(values);
+			}
+		}));
+	}
+
+	for(auto &thread : threads) thread.join();
+
+	uint32_t numWrong = 0;
+
+	for(uint32_t t = 0; t < 4; t++){
+		for(uint32_t i = 0; i < 1000; i++){
+			for(uint32_t k = 0; k < 16; k++) numWrong += results[t][i][k] != t * 100000 + i;
+		}
+	}
+
+	CHECK(numWrong == 0);
+
+	// Slots come around again after numFrames
+	FrameAllocator frames("Test frames", 1024, 2);
+
+	CHECK(&frames.beginFrame(0) != &frames.beginFrame(1) && &frames.get(2) == &frames.get(0));
+}
+
+// Scopes nest, overflowing grows the arena and rewinding to empty merges the blocks
+void TestScratch(){
+	ScratchArena &arena = ScratchArena::get();
+	AllocatorStats stats;
+
+	CHECK(&arena == &ScratchArena::get());
+
+	{
+		ScratchScope scratch;
+
+		CHECK(scratch.allocate(1 << 20) != nullptr);
+
+		{
+			ScratchScope inner;
+
+			CHECK(IsAligned(inner.allocate(100, 64), 64));
+		}
+
+		arena.getStats(stats);
+		CHECK(stats.capacity > (1 << 20));
+	}
+
+	arena.getStats(stats);
+	CHECK(stats.used == 0 && stats.capacity >= (1 << 20) + ScratchArena::BlockSize);
+
+	// One block now, so the same allocations are contiguous
+	{
+		ScratchScope scratch;
+		uint8_t *first = static_cast<uint8_t *>(scratch.allocate(1 << 20));
+		uint8_t *second = static_cast<uint8_t *>(scratch.allocate(100));
+
+		CHECK(second == first + (1 << 20));
+	}
+}
+
+// Every thread gets its own arena and gives it back when it exits
+void TestScratchThreads(){
+	ScratchArena::get();
+
+	uint32_t numArenas = CountScratchArenas();
+
+	for(int round = 0; round < 20; round++){
+		std::vector<std::thread> threads;
+		std::atomic<int> numDistinct(0);
+
+		for(int t = 0; t < 4; t++){
+			threads.push_back(std::thread([&]{
+				ScratchScope scratch;
+
+				if(&ScratchArena::get() != &ScratchArena::get() || !scratch.allocate(1000)) return;
+
+				numDistinct++;
+			}));
+		}
+
+		for(auto &thread : threads) thread.join();
+
+		CHECK(numDistinct == 4);
+	}
+
+	CHECK(CountScratchArenas() == numArenas);
+}
+
+// Fixed size objects, aligned and reused last in first out
+void TestPool(){
+	PoolAllocator pool("Test pool", 100, 64, 4);
+	AllocatorStats stats;
+	void *objects[10];
+	bool aligned = true;
+
+	CHECK(pool.getObjectSize() == 128);
+
+	for(int i = 0; i < 10; i++){
+		objects[i] = pool.allocate();
+		aligned = aligned && IsAligned(objects[i], 64);
+	}
+
+	CHECK(aligned);
+
+	pool.free(objects[3]);
+	CHECK(pool.allocate() == objects[3]);
+
+	pool.getStats(stats);
+	CHECK(stats.capacity == 12 * 128 && stats.used == 10 * 128 && stats.numAllocations == 11);
+}
+
+// The job system's pool is used under its lock while the stats overlay reads it from another thread without
+// taking it, every read sees values the owner actually stored
+void TestPoolStatsThreads(){
+	const int NumRounds = 20000;
+
+	PoolAllocator pool("Shared pool", 32, 16, 16);
+	std::mutex mutex;
+	std::atomic<bool> done(false);
+	uint64_t numPolls = 0;
+	bool consistent = true;
+
+	std::thread owner([&]{
+		std::vector<void *> objects;
+
+		for(int round = 0; round < NumRounds; round++){
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if(objects.size() < 100 && (round % 3 != 2)) objects.push_back(pool.allocate());
+			else if(!objects.empty()){
+				pool.free(objects.back());
+				objects.pop_back();
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for(auto object : objects) pool.free(object);
+
+		done = true;
+	});
+
+	uint64_t lastAllocations = 0;
+
+	while(!done){
+		AllocatorStats stats;
+
+		pool.getStats(stats);
+
+		consistent = consistent && stats.used <= 100 * 32 && stats.peak <= 100 * 32 && stats.capacity <= 112 * 32 &&
+			stats.numAllocations >= lastAllocations;
+
+		lastAllocations = stats.numAllocations;
+		numPolls++;
+	}
+
+	owner.join();
+
+	AllocatorStats stats;
+
+	pool.getStats(stats);
+
+	CHECK(consistent && numPolls > 0);
+	CHECK(stats.used == 0 && stats.peak == 100 * 32 && stats.capacity == 112 * 32);
+}
+
+}
+
+TEST_MAIN(TestLinear, TestScratch, TestScratchThreads, TestPool, TestPoolStatsThreads)
@@ -0,0 +1,146 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+namespace{
+
+const uint32_t NumFiles		= 64;
+const uint32_t Size			= 1024;
+const uint32_t MipCount		= 11;
+const uint32_t NumRounds	= 5;
+
+uint64_t FileBytesRead(){
+	uint64_t numReads, numBytes;
+
+	GetFileReadStats(numReads, numBytes);
+
+	return numBytes;
+}
+
+// Startup the way Main.cpp does it: prepare on the workers, the low mips created when finalizing
+double LoadAll(TextureStreamer &streamer, const std::vector<std::wstring> &paths, const TexturePack *pack){
+	AssetLoader loader(2, std::max<uint32_t>(1, std::thread::hardware_concurrency() - 1));
+	std::vector<PreparedTexture> prepared(paths.size());
+	uint32_t numLoaded = 0;
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(size_t i = 0; i < paths.size(); i++){
+		const std::wstring &path = paths[i];
+		PreparedTexture *texture = &prepared[i];
+
+		auto prepare = [&streamer, path, texture](const AssetLoader::Data &data){
+			return streamer.prepare(path, data.bytes, data.size, *texture);
+		};
+
+		auto finalize = [&streamer, texture, &numLoaded](const AssetLoader::Data &data){
+			if(streamer.load(*texture, data.bytes, data.size) != TextureStreamer::InvalidHandle) numLoaded++;
+		};
+
+		const uint8_t *packed;
+		size_t packedSize;
+
+		if(pack && pack->find(path, &packed, &packedSize)){
+			loader.load(packed, packedSize, prepare, finalize);
+		}
+		else{
+			loader.load(path, prepare, finalize);
+		}
+	}
+
+	if(loader.finalize() || numLoaded != paths.size()) Test::g_failures++;
+
+	return Test::ElapsedMs(start);
+}
+
+// The same with every file read into memory on the calling thread first
+double LoadAllSerial(TextureStreamer &streamer, const std::vector<std::wstring> &paths){
+	uint32_t numLoaded = 0;
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(auto &path : paths){
+		std::vector<uint8_t> data;
+		PreparedTexture prepared;
+
+		if(Util::ReadFileToMemory(path, data) && streamer.prepare(path, data.data(), data.size(), prepared) &&
+			streamer.load(prepared, data.data(), data.size()) != TextureStreamer::InvalidHandle){
+
+			numLoaded++;
+		}
+	}
+
+	if(numLoaded != paths.size()) Test::g_failures++;
+
+	return Test::ElapsedMs(start);
+}
+
+void Report(const char *name, double ms, uint64_t bytesRead){
+	std::printf("%-28s %8.2f ms/startup, %8.2f MB copied/startup\n", name, ms / NumRounds, bytesRead / (1024.0 * 1024.0 * NumRounds));
+}
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	Test::TempDirectory directory;
+	std::vector<std::wstring> paths;
+	std::vector<uint8_t> file = Test::MakeDDSFile(DXGI_FORMAT_R8G8B8A8_UNORM, Size, Size, 1, MipCount, 1);
+
+	for(uint32_t i = 0; i < NumFiles; i++){
+		paths.push_back(directory.wideFile("texture" + std::to_string(i) + ".dds"));
+		Util::WriteMemoryToFile(paths.back(), file.data(), file.size());
+	}
+
+	TexturePack pack;
+
+	if(!BuildTexturePack(directory.wideFile(""), directory.wideFile("textures.pak")) || !pack.open(directory.wideFile("textures.pak"))){
+		Test::g_failures++;
+	}
+
+	std::printf("%u RGBA8 %ux%u files with full mip chains, %.1f MB each, null device\n", NumFiles, Size, Size, file.size() / (1024.0 * 1024.0));
+
+	ID3D11Device *device = new ID3D11Device;
+	ID3D11DeviceContext *context = new ID3D11DeviceContext;
+	double ms[3] = {};
+	uint64_t bytesRead[3] = {};
+
+	for(uint32_t round = 0; round < NumRounds; round++){
+		uint64_t bytesBefore;
+
+		{
+			TextureStreamer streamer(device, context, 1024 * 1024 * 1024, 64);
+
+			bytesBefore = FileBytesRead();
+			ms[0] += LoadAllSerial(streamer, paths);
+			bytesRead[0] += FileBytesRead() - bytesBefore;
+		}
+
+		{
+			TextureStreamer streamer(device, context, 1024 * 1024 * 1024, 64);
+
+			bytesBefore = FileBytesRead();
+			ms[1] += LoadAll(streamer, paths, nullptr);
+			bytesRead[1] += FileBytesRead() - bytesBefore;
+		}
+
+		{
+			TextureStreamer streamer(device, context, 1024 * 1024 * 1024, 64);
+
+			bytesBefore = FileBytesRead();
+			ms[2] += LoadAll(streamer, paths, &pack);
+			bytesRead[2] += FileBytesRead() - bytesBefore;
+		}
+	}
+
+	Report("Serial ReadFileToMemory", ms[0], bytesRead[0]);
+	Report("AssetLoader, mapped files", ms[1], bytesRead[1]);
+	Report("AssetLoader, texture pack", ms[2], bytesRead[2]);
+
+	// Neither loader path copies file contents
+	if(bytesRead[1] || bytesRead[2]) Test::g_failures++;
+
+	context->Release();
+	device->Release();
+
+	return Test::g_failures ? 1 : 0;
+}
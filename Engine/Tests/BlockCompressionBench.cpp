@@ -0,0 +1,70 @@
+#include "Engine.h"
+#include "Test.h"
+#include "Images.h"
+
+using namespace BlockCompression;
+
+namespace{
+
+const size_t Size			= 2048;
+const uint32_t NumRounds	= 3;
+
+double MPixPerSecond(double ms){
+	return Size * Size * NumRounds / (ms * 1000.0);
+}
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	std::vector<uint8_t> image = Test::MakeImage(Test::ImageSmooth, Size, Size), decoded(image.size());
+
+	const BlockFormat formats[] = {FormatBC1, FormatBC3, FormatBC4, FormatBC5, FormatBC7};
+	const char *names[] = {"BC1", "BC3", "BC4", "BC5", "BC7"};
+	const uint32_t threadCounts[] = {1, 0};
+
+	std::printf("%zux%zu smooth image, %u threads available\n", Size, Size, std::thread::hardware_concurrency());
+
+	for(size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++){
+		std::vector<uint8_t> blocks(GetSurfaceBytes(formats[f], Size, Size));
+
+		// No BC7 encoder, its decoder gets random blocks which cover every mode
+		if(formats[f] == FormatBC7){
+			Test::Random random(7);
+
+			for(auto &byte : blocks) byte = static_cast<uint8_t>(random.next());
+		}
+
+		for(uint32_t numThreads : threadCounts){
+			double encodeMs = 0.0;
+
+			if(formats[f] != FormatBC7){
+				Test::Clock::time_point start = Test::Clock::now();
+
+				for(uint32_t round = 0; round < NumRounds; round++){
+					if(!EncodeSurface(formats[f], &image[0], Size, Size, Size * 4, &blocks[0], numThreads)) Test::g_failures++;
+				}
+
+				encodeMs = Test::ElapsedMs(start);
+			}
+
+			Test::Clock::time_point start = Test::Clock::now();
+
+			for(uint32_t round = 0; round < NumRounds; round++){
+				if(!DecodeSurface(formats[f], &blocks[0], Size, Size, &decoded[0], Size * 4, numThreads)) Test::g_failures++;
+			}
+
+			double decodeMs = Test::ElapsedMs(start);
+
+			char encode[32] = "       -";
+
+			if(encodeMs > 0.0) sprintf_s(encode, "%8.1f", MPixPerSecond(encodeMs));
+
+			std::printf("%s %-8s encode %s MPix/s, decode %8.1f MPix/s\n", names[f], numThreads ? "1 thread" : "all", encode,
+				MPixPerSecond(decodeMs));
+		}
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,255 @@
+#include "Engine.h"
+#include "Test.h"
+#include "Images.h"
+
+using namespace BlockCompression;
+
+namespace{
+
+// Odd sizes so the right and bottom blocks are partial
+const size_t Width		= 517;
+const size_t Height		= 389;
+
+// Channels each format stores, BC1 is tested on opaque images since its alpha is a single bit
+const uint32_t MaskRGB	= 0x7;
+const uint32_t MaskRGBA	= 0xF;
+const uint32_t MaskR	= 0x1;
+const uint32_t MaskRG	= 0x3;
+
+double RoundTripPSNR(BlockFormat format, const std::vector<uint8_t> &image, uint32_t channelMask){
+	std::vector<uint8_t> blocks(GetSurfaceBytes(format, Width, Height)), decoded(image.size());
+
+	CHECK(EncodeSurface(format, &image[0], Width, Height, Width * 4, &blocks[0]));
+	CHECK(DecodeSurface(format, &blocks[0], Width, Height, &decoded[0], Width * 4));
+
+	return ComputePSNR(&image[0], &decoded[0], Width, Height, Width * 4, channelMask);
+}
+
+std::vector<uint8_t> MakeOpaque(std::vector<uint8_t> image){
+	for(size_t i = 3; i < image.size(); i += 4) image[i] = 255;
+
+	return image;
+}
+
+// Floors sit a little under what the encoders reach today, a drop below one is a quality regression
+void TestPSNR(){
+	struct Case{
+		BlockFormat format;
+		Test::ImageKind kind;
+		uint32_t channelMask;
+		double minPSNR;
+	};
+
+	const Case cases[] = {
+		{FormatBC1, Test::ImageSmooth,	MaskRGB,	40.2},
+		{FormatBC1, Test::ImageEdges,	MaskRGB,	29.6},
+		{FormatBC1, Test::ImageNoise,	MaskRGB,	13.1},
+		{FormatBC3, Test::ImageSmooth,	MaskRGBA,	41.5},
+		{FormatBC3, Test::ImageEdges,	MaskRGBA,	30.8},
+		{FormatBC3, Test::ImageNoise,	MaskRGBA,	14.3},
+		{FormatBC4, Test::ImageSmooth,	MaskR,		53.5},
+		{FormatBC4, Test::ImageEdges,	MaskR,		49.1},
+		{FormatBC4, Test::ImageNoise,	MaskR,		28.7},
+		{FormatBC5, Test::ImageSmooth,	MaskRG,		53.4},
+		{FormatBC5, Test::ImageEdges,	MaskRG,		49.0},
+		{FormatBC5, Test::ImageNoise,	MaskRG,		28.8},
+	};
+
+	for(auto &c : cases){
+		std::vector<uint8_t> image = Test::MakeImage(c.kind, Width, Height);
+
+		if(c.format == FormatBC1) image = MakeOpaque(image);
+
+		double psnr = RoundTripPSNR(c.format, image, c.channelMask);
+
+		CHECK(psnr >= c.minPSNR);
+	}
+}
+
+// Decoded palettes match the formulas in the D3D spec
+void TestDecodeKnownBlocks(){
+	uint8_t texels[64];
+
+	// BC1 four colors, red to blue with the two thirds in between
+	const uint8_t bc1[8] = {0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4};
+
+	DecodeBlockBC1(bc1, texels);
+
+	CHECK(texels[0] == 255 && texels[1] == 0 && texels[2] == 0 && texels[3] == 255);
+	CHECK(texels[4] == 0 && texels[5] == 0 && texels[6] == 255 && texels[7] == 255);
+	CHECK(texels[8] == 170 && texels[10] == 85);
+	CHECK(texels[12] == 85 && texels[14] == 170);
+
+	// Swapped endpoints switch to three colors and transparent black
+	const uint8_t bc1Alpha[8] = {0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4};
+
+	DecodeBlockBC1(bc1Alpha, texels);
+
+	CHECK(texels[8] == 127 && texels[10] == 127 && texels[11] == 255);
+	CHECK(texels[12] == 0 && texels[13] == 0 && texels[14] == 0 && texels[15] == 0);
+
+	// BC3 ignores the endpoint order and always has four colors
+	uint8_t bc3[16] = {255, 255};
+
+	memcpy(bc3 + 8, bc1Alpha, 8);
+	DecodeBlockBC3(bc3, texels);
+
+	CHECK(texels[15] == 255 && texels[12] == 170 && texels[14] == 85);
+
+	// BC4 with eight values, then six plus 0 and 255
+	const uint8_t bc4[8] = {240, 16, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA};
+	const uint8_t bc4Values[8] = {240, 16, 208, 176, 144, 112, 80, 48};
+
+	DecodeBlockBC4(bc4, texels);
+
+	for(uint32_t i = 0; i < 16; i++){
+		CHECK(texels[i * 4] == bc4Values[i & 7]);
+	}
+
+	const uint8_t bc4Six[8] = {16, 240, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA};
+	const uint8_t bc4SixValues[8] = {16, 240, 61, 106, 150, 195, 0, 255};
+
+	DecodeBlockBC4(bc4Six, texels);
+
+	for(uint32_t i = 0; i < 16; i++){
+		CHECK(texels[i * 4] == bc4SixValues[i & 7]);
+	}
+
+	// BC7 mode 6, one subset with 7-bit endpoints, per-endpoint p-bits and 4-bit indices
+	uint8_t bc7[16] = {};
+	uint32_t pos = 0;
+
+	auto write = [&](uint32_t value, uint32_t numBits){
+		for(uint32_t i = 0; i < numBits; i++, pos++){
+			if((value >> i) & 1) bc7[pos >> 3] |= 1 << (pos & 7);
+		}
+	};
+
+	const uint32_t endpoints[2][4] = {{10, 20, 30, 127}, {120, 100, 80, 64}};
+	const uint32_t pBits[2] = {1, 0};
+	const uint32_t weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+	write(1 << 6, 7);
+
+	for(uint32_t channel = 0; channel < 4; channel++){
+		write(endpoints[0][channel], 7);
+		write(endpoints[1][channel], 7);
+	}
+
+	write(pBits[0], 1);
+	write(pBits[1], 1);
+
+	// Texel i gets index i, the anchor's index has one bit less
+	for(uint32_t i = 0; i < 16; i++) write(i, i == 0 ? 3 : 4);
+
+	CHECK(pos == 128);
+
+	DecodeBlockBC7(bc7, texels);
+
+	for(uint32_t i = 0; i < 16; i++){
+		for(uint32_t channel = 0; channel < 4; channel++){
+			uint32_t e0 = (endpoints[0][channel] << 1) | pBits[0];
+			uint32_t e1 = (endpoints[1][channel] << 1) | pBits[1];
+
+			CHECK(texels[i * 4 + channel] == ((64 - weights[i]) * e0 + weights[i] * e1 + 32) >> 6);
+		}
+	}
+
+	// Reserved mode
+	uint8_t reserved[16] = {};
+
+	DecodeBlockBC7(reserved, texels);
+
+	CHECK(texels[0] == 0 && texels[3] == 0 && texels[63] == 0);
+}
+
+// Blocks the formats can represent exactly survive encoding unchanged
+void TestExactBlocks(){
+	uint8_t texels[64], block[16], decoded[64];
+
+	// Two colors that expand exactly from 5:6:5
+	for(uint32_t i = 0; i < 16; i++){
+		uint8_t *texel = texels + i * 4;
+
+		texel[0] = (i & 1) ? 255 : 0;
+		texel[1] = (i & 1) ? 0 : 130;
+		texel[2] = (i & 1) ? 66 : 255;
+		texel[3] = 255;
+	}
+
+	EncodeBlockBC1(texels, block);
+	DecodeBlockBC1(block, decoded);
+
+	CHECK(memcmp(texels, decoded, 64) == 0);
+
+	// Punch-through alpha keeps its transparent texels at zero
+	for(uint32_t i = 0; i < 16; i++) texels[i * 4 + 3] = (i % 3) ? 255 : 0;
+
+	EncodeBlockBC1(texels, block);
+	DecodeBlockBC1(block, decoded);
+
+	for(uint32_t i = 0; i < 16; i++){
+		CHECK(decoded[i * 4 + 3] == texels[i * 4 + 3]);
+	}
+
+	// The extremes of a single channel are always exact
+	for(uint32_t i = 0; i < 16; i++){
+		texels[i * 4]		= (i & 4) ? 200 : 17;
+		texels[i * 4 + 1]	= (i & 2) ? 3 : 250;
+	}
+
+	EncodeBlockBC5(texels, block);
+	DecodeBlockBC5(block, decoded);
+
+	for(uint32_t i = 0; i < 16; i++){
+		CHECK(decoded[i * 4] == texels[i * 4] && decoded[i * 4 + 1] == texels[i * 4 + 1]);
+		CHECK(decoded[i * 4 + 2] == 0 && decoded[i * 4 + 3] == 255);
+	}
+}
+
+// Threads only split the work and partial blocks never write past the surface
+void TestSurfaces(){
+	std::vector<uint8_t> image = Test::MakeImage(Test::ImageSmooth, Width, Height);
+	const BlockFormat formats[] = {FormatBC1, FormatBC3, FormatBC4, FormatBC5};
+
+	for(BlockFormat format : formats){
+		size_t surfaceBytes = GetSurfaceBytes(format, Width, Height);
+		std::vector<uint8_t> single(surfaceBytes), parallel(surfaceBytes);
+
+		CHECK(surfaceBytes == ((Width + 3) / 4) * ((Height + 3) / 4) * GetBlockSize(format));
+		CHECK(EncodeSurface(format, &image[0], Width, Height, Width * 4, &single[0], 1));
+		CHECK(EncodeSurface(format, &image[0], Width, Height, Width * 4, &parallel[0], 0));
+		CHECK(single == parallel);
+
+		// Padded rows, the padding must stay untouched
+		const size_t RowPitch = Width * 4 + 12;
+		std::vector<uint8_t> decoded(RowPitch * Height, 0xCD);
+
+		CHECK(DecodeSurface(format, &single[0], Width, Height, &decoded[0], RowPitch, 3));
+
+		for(size_t y = 0; y < Height; y++){
+			for(size_t x = Width * 4; x < RowPitch; x++){
+				if(decoded[y * RowPitch + x] != 0xCD){
+					CHECK(false);
+					y = Height;
+					break;
+				}
+			}
+		}
+	}
+
+	// No BC7 encoder and no SNORM formats
+	std::vector<uint8_t> blocks(GetSurfaceBytes(FormatBC7, Width, Height));
+	BlockFormat blockFormat;
+
+	CHECK(!EncodeSurface(FormatBC7, &image[0], Width, Height, Width * 4, &blocks[0]));
+	CHECK(GetBlockFormat(DXGI_FORMAT_BC7_UNORM_SRGB, blockFormat) && blockFormat == FormatBC7);
+	CHECK(!GetBlockFormat(DXGI_FORMAT_BC4_SNORM, blockFormat));
+
+	// Identical images
+	CHECK(ComputePSNR(&image[0], &image[0], Width, Height, Width * 4) == DBL_MAX);
+}
+
+}
+
+TEST_MAIN(TestPSNR, TestDecodeKnownBlocks, TestExactBlocks, TestSurfaces)
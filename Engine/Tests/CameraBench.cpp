@@ -0,0 +1,131 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumCameras	= 10000;
+const uint32_t NumFrames	= 100;
+
+// Keeps the matrices the frames read from being optimized away
+volatile float g_sink;
+
+// What a camera's frame data cost before it was cached: the view rebuilt and every matrix transposed on each
+// getter call, the view projection multiplied by the caller and the frustum planes extracted by whoever
+// needed them
+struct UncachedCamera{
+	DirectX::XMVECTOR pos, target, up;
+	DirectX::XMMATRIX proj;
+
+	DirectX::XMMATRIX getViewMatrix() const{
+		return DirectX::XMMatrixTranspose(DirectX::XMMatrixLookAtLH(pos, DirectX::XMVectorAdd(target, pos), up));
+	}
+
+	DirectX::XMMATRIX getProjMatrix() const{
+		return DirectX::XMMatrixTranspose(proj);
+	}
+
+	DirectX::XMVECTOR getRight() const{
+		return DirectX::XMVector3Normalize(DirectX::XMVector3Cross(target, up));
+	}
+};
+
+void Consume(const DirectX::XMMATRIX &m){
+	g_sink = g_sink + _mm_cvtss_f32(m.r[0]) + _mm_cvtss_f32(m.r[3]);
+}
+
+void Consume(DirectX::XMVECTOR v){
+	g_sink = g_sink + _mm_cvtss_f32(v);
+}
+
+// A frame's reads the way RenderScene and the culling passes make them
+void ReadFrame(const UncachedCamera &camera){
+	DirectX::XMMATRIX viewProj = DirectX::XMMatrixMultiply(camera.getProjMatrix(), camera.getViewMatrix());
+	DirectX::XMMATRIX cols = viewProj;
+	DirectX::XMVECTOR planes[Camera::PlaneCount];
+
+	planes[Camera::PlaneLeft]	= DirectX::XMPlaneNormalize(DirectX::XMVectorAdd(cols.r[3], cols.r[0]));
+	planes[Camera::PlaneRight]	= DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(cols.r[3], cols.r[0]));
+	planes[Camera::PlaneBottom]	= DirectX::XMPlaneNormalize(DirectX::XMVectorAdd(cols.r[3], cols.r[1]));
+	planes[Camera::PlaneTop]	= DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(cols.r[3], cols.r[1]));
+	planes[Camera::PlaneNear]	= DirectX::XMPlaneNormalize(cols.r[2]);
+	planes[Camera::PlaneFar]	= DirectX::XMPlaneNormalize(DirectX::XMVectorSubtract(cols.r[3], cols.r[2]));
+
+	Consume(viewProj);
+	Consume(camera.getViewMatrix());
+	Consume(camera.getProjMatrix());
+	Consume(camera.getRight());
+	Consume(planes[Camera::PlaneFar]);
+}
+
+void ReadFrame(const Camera &camera){
+	Consume(camera.getViewProjMatrix());
+	Consume(camera.getViewMatrix());
+	Consume(camera.getProjMatrix());
+	Consume(camera.getRight());
+	Consume(camera.getFrustumPlane(Camera::PlaneFar));
+}
+
+}
+
+int Test::g_failures = 0;
+
+// 10k cameras, as many as shadow cascades, probes and reflection views add up to, read every frame. Uncached
+// against cached with none, a tenth and all of them moving between frames
+int main(){
+	Test::Random random(1);
+	std::vector<Camera> cameras(NumCameras);
+	std::vector<UncachedCamera> uncached(NumCameras);
+	std::vector<Camera *> pointers;
+
+	for(uint32_t i = 0; i < NumCameras; i++){
+		DirectX::XMFLOAT3 pos(random.range(-100.0f, 100.0f), random.range(0.0f, 30.0f), random.range(-100.0f, 100.0f));
+		DirectX::XMFLOAT3 target(random.range(-1.0f, 1.0f), random.range(-0.5f, 0.5f), 1.0f);
+
+		cameras[i].setPos(pos);
+		cameras[i].setTarget(target);
+		cameras[i].setProperties(1920.0f, 1080.0f, 0.1f, 1000.0f);
+
+		uncached[i].pos		= DirectX::XMLoadFloat3(&pos);
+		uncached[i].target	= DirectX::XMLoadFloat3(&target);
+		uncached[i].up		= DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		uncached[i].proj	= DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV4, 1920.0f / 1080.0f, 0.1f, 1000.0f);
+
+		pointers.push_back(&cameras[i]);
+	}
+
+	std::printf("%u cameras, %u frames\n", NumCameras, NumFrames);
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t frame = 0; frame < NumFrames; frame++){
+		for(auto &camera : uncached) ReadFrame(camera);
+	}
+
+	std::printf("Uncached                %8.3f ms/frame\n", Test::ElapsedMs(start) / NumFrames);
+
+	uint32_t moving[] = {0, 10, 1};
+	const char *names[] = {"Cached, none moving", "Cached, a tenth moving", "Cached, all moving"};
+
+	for(uint32_t i = 0; i < 3; i++){
+		start = Test::Clock::now();
+
+		for(uint32_t frame = 0; frame < NumFrames; frame++){
+			if(moving[i]){
+				for(uint32_t camera = frame % moving[i]; camera < NumCameras; camera += moving[i]) cameras[camera].moveForward(0.01f);
+			}
+
+			UpdateCameras(pointers.data(), NumCameras);
+
+			for(auto &camera : cameras) ReadFrame(camera);
+		}
+
+		std::printf("%-23s %8.3f ms/frame\n", names[i], Test::ElapsedMs(start) / NumFrames);
+	}
+
+	// Nothing is left to rebuild after the batched update
+	for(auto &camera : cameras){
+		if(camera.isDirty()) Test::g_failures++;
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
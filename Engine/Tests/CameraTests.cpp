@@ -0,0 +1,114 @@
+#include "Engine.h"
+#include "Test.h"
+
+using namespace DirectX;
+
+namespace{
+
+bool Near(const XMMATRIX &a, const XMMATRIX &b, float tolerance){
+	XMFLOAT4X4 fa, fb;
+
+	XMStoreFloat4x4(&fa, a);
+	XMStoreFloat4x4(&fb, b);
+
+	for(int i = 0; i < 16; i++){
+		if(fabsf((&fa.m[0][0])[i] - (&fb.m[0][0])[i]) > tolerance) return false;
+	}
+
+	return true;
+}
+
+float PlaneDistance(XMVECTOR plane, const XMFLOAT3 &point){
+	XMFLOAT4 p;
+
+	XMStoreFloat4(&p, plane);
+
+	return p.x * point.x + p.y * point.y + p.z * point.z + p.w;
+}
+
+// Point at normalized device x, y and depth z seen from the camera, back in world space
+XMFLOAT3 Unproject(const Camera &camera, float x, float y, float z){
+	XMFLOAT4 point;
+
+	XMStoreFloat4(&point, XMVector4Transform(XMVectorSet(x, y, z, 1.0f), camera.getInvViewProjMatrix()));
+
+	return XMFLOAT3(point.x / point.w, point.y / point.w, point.z / point.w);
+}
+
+// The cached matrices are the ones the getters used to build on every call, and only change after a setter
+void TestCache(){
+	Camera camera;
+
+	camera.setPos(XMFLOAT3(3.0f, 2.0f, -5.0f));
+	camera.setTarget(XMFLOAT3(0.2f, -0.1f, 1.0f));
+	camera.setProperties(1920.0f, 1080.0f, 0.1f, 100.0f);
+
+	CHECK(camera.isDirty());
+
+	XMMATRIX view = XMMatrixLookAtLH(camera.getPos(), XMVectorAdd(camera.getTarget(), camera.getPos()), camera.getUp());
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, 1920.0f / 1080.0f, 0.1f, 100.0f);
+
+	CHECK(Near(camera.getViewMatrix(), XMMatrixTranspose(view), 1e-6f));
+	CHECK(Near(camera.getProjMatrix(), XMMatrixTranspose(proj), 1e-6f));
+	CHECK(Near(camera.getViewProjMatrixCPU(), XMMatrixMultiply(view, proj), 1e-5f));
+	CHECK(Near(camera.getViewProjMatrix(), XMMatrixTranspose(XMMatrixMultiply(view, proj)), 1e-5f));
+	CHECK(!camera.isDirty());
+
+	// Inverses undo their matrices
+	CHECK(Near(XMMatrixMultiply(view, camera.getInvViewMatrix()), XMMatrixIdentity(), 1e-5f));
+	CHECK(Near(XMMatrixMultiply(camera.getViewProjMatrixCPU(), camera.getInvViewProjMatrix()), XMMatrixIdentity(), 1e-4f));
+
+	XMMATRIX before = camera.getViewMatrix();
+
+	camera.moveForward(1.0f);
+
+	CHECK(camera.isDirty());
+	CHECK(!Near(camera.getViewMatrix(), before, 1e-3f));
+
+	// A batch update leaves nothing to rebuild
+	Camera cameras[3];
+	Camera *pointers[3] = {&cameras[0], &cameras[1], &cameras[2]};
+
+	cameras[1].rotate(0.1f, 0.2f);
+	UpdateCameras(pointers, 3);
+
+	for(auto &c : cameras) CHECK(!c.isDirty());
+}
+
+// Points inside the frustum are in front of every plane, points past any of its faces behind that plane
+void TestFrustum(){
+	Test::Random random(3);
+
+	for(uint32_t i = 0; i < 100; i++){
+		Camera camera;
+
+		camera.setPos(XMFLOAT3(random.range(-50.0f, 50.0f), random.range(-50.0f, 50.0f), random.range(-50.0f, 50.0f)));
+		camera.setTarget(XMFLOAT3(random.range(-1.0f, 1.0f), random.range(-0.5f, 0.5f), random.range(-1.0f, 1.0f)));
+		camera.setProperties(random.range(100.0f, 2000.0f), random.range(100.0f, 2000.0f), 0.5f, 200.0f);
+		camera.rotate(random.range(-0.5f, 0.5f), random.range(-3.0f, 3.0f));
+
+		const XMVECTOR *planes = camera.getFrustumPlanes();
+
+		for(uint32_t plane = 0; plane < Camera::PlaneCount; plane++){
+			XMFLOAT4 p;
+
+			XMStoreFloat4(&p, planes[plane]);
+			CHECK(fabsf(p.x * p.x + p.y * p.y + p.z * p.z - 1.0f) < 1e-4f);
+		}
+
+		XMFLOAT3 inside = Unproject(camera, random.range(-0.9f, 0.9f), random.range(-0.9f, 0.9f), random.range(0.1f, 0.9f));
+		XMFLOAT3 left = Unproject(camera, -1.1f, 0.0f, 0.5f), top = Unproject(camera, 0.0f, 1.1f, 0.5f);
+		XMFLOAT3 nearer = Unproject(camera, 0.0f, 0.0f, -0.1f), farther = Unproject(camera, 0.0f, 0.0f, 1.001f);
+
+		for(uint32_t plane = 0; plane < Camera::PlaneCount; plane++) CHECK(PlaneDistance(planes[plane], inside) > 0.0f);
+
+		CHECK(PlaneDistance(camera.getFrustumPlane(Camera::PlaneLeft), left) < 0.0f);
+		CHECK(PlaneDistance(camera.getFrustumPlane(Camera::PlaneTop), top) < 0.0f);
+		CHECK(PlaneDistance(camera.getFrustumPlane(Camera::PlaneNear), nearer) < 0.0f);
+		CHECK(PlaneDistance(camera.getFrustumPlane(Camera::PlaneFar), farther) < 0.0f);
+	}
+}
+
+}
+
+TEST_MAIN(TestCache, TestFrustum)
@@ -0,0 +1,30 @@
+#pragma once
+
+////////////////////////////////////////
+// D3DCompiler subset for Linux tests //
+////////////////////////////////////////
+
+// Enough to build the engine's default compile path, D3DCompile always fails here so tests hand the
+// engine a compiler of their own
+
+#include <d3d11_1.h>
+
+#define D3D_COMPILER_VERSION	47
+
+struct D3D_SHADER_MACRO{
+	const char *Name;
+	const char *Definition;
+};
+
+class ID3DInclude;
+
+#define D3D_COMPILE_STANDARD_FILE_INCLUDE	reinterpret_cast<ID3DInclude *>(1)
+
+class ID3DBlob : public IUnknown{
+public:
+	virtual void *STDMETHODCALLTYPE GetBufferPointer() = 0;
+	virtual size_t STDMETHODCALLTYPE GetBufferSize() = 0;
+};
+
+HRESULT D3DCompile(const void *srcData, size_t srcDataSize, const char *sourceName, const D3D_SHADER_MACRO *defines, ID3DInclude *include,
+	const char *entrypoint, const char *target, UINT flags1, UINT flags2, ID3DBlob **code, ID3DBlob **errorMsgs);
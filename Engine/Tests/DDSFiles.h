@@ -0,0 +1,141 @@
+#pragma once
+
+/////////////////////////
+// Synthetic DDS files //
+/////////////////////////
+
+// DX10 DDS files whose bit data bytes are a function of their offset in the file, so a test can tell which
+// bytes a loader handed to the device
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+
+namespace Test{
+
+const uint32_t DDSMagic			= 0x20534444;
+const uint32_t DDSFourCCDX10	= 0x30315844;
+
+// Magic, DDS_HEADER and DDS_HEADER_DXT10
+const size_t DDSHeaderSize		= 4 + 124 + 20;
+
+inline uint8_t PatternByte(uint64_t offset){
+	return static_cast<uint8_t>(offset ^ (offset >> 9) ^ (offset >> 17) ^ ((offset >> 32) * 7));
+}
+
+inline void FillPattern(uint64_t offset, uint8_t *data, size_t size){
+	for(size_t i = 0; i < size; i++) data[i] = PatternByte(offset + i);
+}
+
+// Hash of the pattern bytes in [offset, offset + size), to compare with what a device received
+inline uint64_t HashPattern(uint64_t offset, uint64_t size){
+	uint64_t hash = Util::FNVOffsetBasis;
+
+	for(uint64_t i = 0; i < size; i++){
+		hash ^= PatternByte(offset + i);
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+// Depth above 1 makes a volume texture, arraySize only applies to 2D ones
+inline std::vector<uint8_t> MakeDDSHeaders(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount,
+	uint32_t arraySize){
+
+	uint32_t words[DDSHeaderSize / 4] = {};
+	bool volume = depth > 1;
+
+	words[0] = DDSMagic;
+
+	// DDS_HEADER, caps, height, width, pixel format, mip count and the volume flag
+	words[1] = 124;
+	words[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | (volume ? 0x800000 : 0);
+	words[3] = height;
+	words[4] = width;
+	words[6] = depth;
+	words[7] = mipCount;
+	words[19] = 32;
+	words[20] = 0x4;
+	words[21] = DDSFourCCDX10;
+	words[27] = 0x1000 | (mipCount > 1 ? 0x400008 : 0);
+	words[28] = volume ? 0x200000 : 0;
+
+	// DDS_HEADER_DXT10
+	words[32] = format;
+	words[33] = volume ? D3D11_RESOURCE_DIMENSION_TEXTURE3D : D3D11_RESOURCE_DIMENSION_TEXTURE2D;
+	words[35] = volume ? 1 : arraySize;
+
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(words);
+
+	return std::vector<uint8_t>(bytes, bytes + DDSHeaderSize);
+}
+
+inline uint64_t GetDDSFileSize(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount, uint32_t arraySize){
+	return DDSHeaderSize + DirectX::GetTextureMemorySize(width, height, depth, mipCount, arraySize, format);
+}
+
+// Whole file in memory
+inline std::vector<uint8_t> MakeDDSFile(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount,
+	uint32_t arraySize){
+
+	std::vector<uint8_t> file = MakeDDSHeaders(format, width, height, depth, mipCount, arraySize);
+
+	file.resize(static_cast<size_t>(GetDDSFileSize(format, width, height, depth, mipCount, arraySize)));
+	FillPattern(DDSHeaderSize, &file[DDSHeaderSize], file.size() - DDSHeaderSize);
+
+	return file;
+}
+
+// Writes the headers and the pattern over [patternBegin, patternEnd) of a file size bytes long, the rest is a
+// hole in the file so huge ones cost nothing
+inline bool WriteSparseDDSFile(const std::string &path, const std::vector<uint8_t> &headers, uint64_t size, uint64_t patternBegin,
+	uint64_t patternEnd){
+
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if(fd < 0) return false;
+
+	bool ok = ftruncate(fd, static_cast<off_t>(size)) == 0 &&
+		pwrite(fd, headers.data(), headers.size(), 0) == static_cast<ssize_t>(headers.size());
+
+	std::vector<uint8_t> chunk(1 << 20);
+
+	for(uint64_t offset = patternBegin; ok && offset < patternEnd; offset += chunk.size()){
+		size_t chunkSize = static_cast<size_t>(std::min<uint64_t>(chunk.size(), patternEnd - offset));
+
+		FillPattern(offset, chunk.data(), chunkSize);
+		ok = pwrite(fd, chunk.data(), chunkSize, static_cast<off_t>(offset)) == static_cast<ssize_t>(chunkSize);
+	}
+
+	close(fd);
+
+	return ok;
+}
+
+// Fresh directory under /tmp, removed with everything in it by the destructor
+struct TempDirectory{
+	std::string path;
+
+	TempDirectory(){
+		char name[] = "/tmp/EngineTestsXXXXXX";
+
+		path = mkdtemp(name) ? name : "/tmp";
+	}
+
+	~TempDirectory(){
+		if(path != "/tmp") std::system(("rm -rf " + path).c_str());
+	}
+
+	std::string file(const std::string &name) const{
+		return path + "/" + name;
+	}
+
+	std::wstring wideFile(const std::string &name) const{
+		std::string narrow = file(name);
+
+		return std::wstring(narrow.begin(), narrow.end());
+	}
+};
+
+}
@@ -0,0 +1,108 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+namespace{
+
+const uint32_t NumFiles		= 32;
+const uint32_t Size			= 2048;
+const uint32_t NumRounds	= 20;
+
+// Reads every byte it is created with, like a driver copying the initial data would
+class TouchingDevice : public ID3D11Device{
+public:
+	uint64_t sum;
+
+	TouchingDevice() : sum(0){}
+
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC *desc, const D3D11_SUBRESOURCE_DATA *initialData, ID3D11Texture2D **texture){
+		for(UINT i = 0; initialData && i < desc->MipLevels * desc->ArraySize; i++){
+			const uint8_t *bytes = static_cast<const uint8_t *>(initialData[i].pSysMem);
+
+			for(UINT b = 0; b < initialData[i].SysMemSlicePitch; b += 64) sum += bytes[b];
+		}
+
+		return ID3D11Device::CreateTexture2D(desc, initialData, texture);
+	}
+};
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	Test::TempDirectory directory;
+	std::vector<std::wstring> paths;
+	std::vector<uint8_t> file = Test::MakeDDSFile(DXGI_FORMAT_BC1_UNORM, Size, Size, 1, 12, 1);
+
+	for(uint32_t i = 0; i < NumFiles; i++){
+		paths.push_back(directory.wideFile("texture" + std::to_string(i) + ".dds"));
+		Util::WriteMemoryToFile(paths.back(), file.data(), file.size());
+	}
+
+	std::printf("%u BC1 %ux%u files with full mip chains, %.1f MB each\n", NumFiles, Size, Size, file.size() / (1024.0 * 1024.0));
+
+	// Headers only
+	DirectX::DDS_METADATA metadata;
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t round = 0; round < NumRounds; round++){
+		for(auto &path : paths) DirectX::GetDDSMetadataFromFile(path.c_str(), metadata);
+	}
+
+	std::printf("GetDDSMetadataFromFile          %8.2f us/file\n", Test::ElapsedMs(start) * 1000.0 / (NumRounds * NumFiles));
+
+	// FillInitData's layout walk without pointers
+	const uint32_t NumLayouts = 100000;
+	size_t width, height, mipCount, numBytes = 0;
+	uint64_t totalBytes = 0;
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumLayouts; i++){
+		DirectX::GetDDSTextureFootprintFromMemory(file.data(), file.size(), (i & 1) ? 512 : 0, &width, &height, &mipCount, &numBytes);
+		totalBytes += numBytes;
+	}
+
+	std::printf("GetDDSTextureFootprintFromMemory %8.3f us/call (%llu)\n", Test::ElapsedMs(start) * 1000.0 / NumLayouts,
+		static_cast<unsigned long long>(totalBytes / NumLayouts));
+
+	// Mapping and handing the views to a device that reads them
+	size_t maxsizes[] = {0, 512, 64};
+
+	for(size_t maxsize : maxsizes){
+		TouchingDevice *device = new TouchingDevice;
+		uint64_t numViewsBefore, numBytesBefore, numViews, numViewBytes;
+
+		GetMappingStats(numViewsBefore, numBytesBefore);
+		start = Test::Clock::now();
+
+		for(uint32_t round = 0; round < NumRounds; round++){
+			for(auto &path : paths){
+				ID3D11Resource *texture = nullptr;
+
+				if(FAILED(DirectX::CreateDDSTextureFromFileEx(device, path.c_str(), maxsize, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+					false, &texture, nullptr))){
+
+					Test::g_failures++;
+				}
+
+				ReleaseCOM(texture);
+			}
+		}
+
+		double ms = Test::ElapsedMs(start);
+
+		GetMappingStats(numViews, numViewBytes);
+
+		double mappedMB = (numViewBytes - numBytesBefore) / (1024.0 * 1024.0);
+
+		std::printf("CreateDDSTextureFromFileEx maxsize %4zu: %7.1f us/file, %6.2f MB mapped/file, %7.0f MB/s (%llu)\n", maxsize,
+			ms * 1000.0 / (NumRounds * NumFiles), mappedMB / (NumRounds * NumFiles), mappedMB / (ms / 1000.0),
+			static_cast<unsigned long long>(device->sum & 0xFF));
+
+		device->Release();
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
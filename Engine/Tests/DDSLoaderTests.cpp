@@ -0,0 +1,235 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+namespace{
+
+const uint64_t FourGB = 1ULL << 32;
+
+// Keeps a hash of every subresource it was created with, in D3D11CalcSubresource order
+class RecordingDevice : public ID3D11Device{
+private:
+	void record(const D3D11_SUBRESOURCE_DATA *initialData, UINT mipLevels, UINT arraySize, UINT depth){
+		hashes.clear();
+
+		if(!initialData) return;
+
+		for(UINT item = 0; item < arraySize; item++){
+			for(UINT mip = 0; mip < mipLevels; mip++){
+				const D3D11_SUBRESOURCE_DATA &data = initialData[item * mipLevels + mip];
+				size_t numBytes = static_cast<size_t>(data.SysMemSlicePitch) * std::max<UINT>(depth >> mip, 1);
+
+				hashes.push_back(Util::HashFNV1a(data.pSysMem, numBytes));
+			}
+		}
+	}
+
+public:
+	std::vector<uint64_t> hashes;
+
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC *desc, const D3D11_SUBRESOURCE_DATA *initialData, ID3D11Texture2D **texture){
+		record(initialData, desc->MipLevels, desc->ArraySize, 1);
+
+		return ID3D11Device::CreateTexture2D(desc, initialData, texture);
+	}
+
+	HRESULT CreateTexture3D(const D3D11_TEXTURE3D_DESC *desc, const D3D11_SUBRESOURCE_DATA *initialData, ID3D11Texture3D **texture){
+		record(initialData, desc->MipLevels, 1, desc->Depth);
+
+		return ID3D11Device::CreateTexture3D(desc, initialData, texture);
+	}
+};
+
+uint64_t MappedBytes(){
+	uint64_t numViews, numBytes;
+
+	GetMappingStats(numViews, numBytes);
+
+	return numBytes;
+}
+
+// The device got the file's subresources from firstMip on, byte for byte
+void CheckSubresources(const RecordingDevice &device, const DirectX::DDS_METADATA &metadata, size_t firstMip){
+	size_t numMips = metadata.mipCount - firstMip;
+
+	CHECK(device.hashes.size() == numMips * metadata.arraySize);
+
+	for(size_t item = 0; item < metadata.arraySize; item++){
+		for(size_t mip = 0; mip < numMips && item * numMips + mip < device.hashes.size(); mip++){
+			const DirectX::DDS_SUBRESOURCE_INFO &info = metadata.subresources[item * metadata.mipCount + firstMip + mip];
+
+			CHECK(device.hashes[item * numMips + mip] == Test::HashPattern(info.offset, info.numBytes));
+		}
+	}
+}
+
+// Dropping the large mips maps the small ones only
+void TestMapsKeptMips(){
+	Test::TempDirectory directory;
+	std::vector<uint8_t> file = Test::MakeDDSFile(DXGI_FORMAT_R8G8B8A8_UNORM, 1024, 1024, 1, 11, 1);
+
+	CHECK(Util::WriteMemoryToFile(directory.wideFile("kept.dds"), file.data(), file.size()));
+
+	DirectX::DDS_METADATA metadata;
+
+	CHECK(SUCCEEDED(DirectX::GetDDSMetadataFromFile(directory.wideFile("kept.dds").c_str(), metadata)));
+
+	RecordingDevice *device = new RecordingDevice;
+	ID3D11Resource *texture = nullptr;
+	uint64_t mappedBefore = MappedBytes();
+
+	CHECK(SUCCEEDED(DirectX::CreateDDSTextureFromFileEx(device, directory.wideFile("kept.dds").c_str(), 128, D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE, 0, 0, false, &texture, nullptr)));
+
+	// Mips 128x128 and smaller are a small tail of the file, the view only rounds down to the granularity
+	uint64_t keptBytes = file.size() - metadata.subresources[3].offset;
+
+	CHECK(MappedBytes() - mappedBefore <= keptBytes + 65536);
+	CHECK(MappedBytes() - mappedBefore < file.size() / 4);
+
+	if(texture){
+		const D3D11_TEXTURE2D_DESC &desc = static_cast<ID3D11Texture2D *>(texture)->desc;
+
+		CHECK(desc.Width == 128 && desc.Height == 128 && desc.MipLevels == 8);
+		CheckSubresources(*device, metadata, 3);
+	}
+
+	ReleaseCOM(texture);
+	device->Release();
+}
+
+// Items of an array keep the same mips, the view spans from the first item's to the last one's
+void TestArrayMaxsize(){
+	Test::TempDirectory directory;
+	std::vector<uint8_t> file = Test::MakeDDSFile(DXGI_FORMAT_BC1_UNORM, 256, 256, 1, 9, 3);
+
+	CHECK(Util::WriteMemoryToFile(directory.wideFile("array.dds"), file.data(), file.size()));
+
+	DirectX::DDS_METADATA metadata;
+
+	CHECK(SUCCEEDED(DirectX::GetDDSMetadataFromFile(directory.wideFile("array.dds").c_str(), metadata)));
+	CHECK(metadata.arraySize == 3 && metadata.mipCount == 9);
+
+	RecordingDevice *device = new RecordingDevice;
+	ID3D11Resource *texture = nullptr;
+
+	CHECK(SUCCEEDED(DirectX::CreateDDSTextureFromFileEx(device, directory.wideFile("array.dds").c_str(), 64, D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE, 0, 0, false, &texture, nullptr)));
+
+	if(texture){
+		const D3D11_TEXTURE2D_DESC &desc = static_cast<ID3D11Texture2D *>(texture)->desc;
+
+		CHECK(desc.Width == 64 && desc.ArraySize == 3 && desc.MipLevels == 7);
+		CheckSubresources(*device, metadata, 2);
+	}
+
+	// And the whole file without a maxsize
+	ReleaseCOM(texture);
+
+	CHECK(SUCCEEDED(DirectX::CreateDDSTextureFromFileEx(device, directory.wideFile("array.dds").c_str(), 0, D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE, 0, 0, false, &texture, nullptr)));
+
+	CheckSubresources(*device, metadata, 0);
+
+	ReleaseCOM(texture);
+	device->Release();
+}
+
+// A file shorter than its headers describe fails before anything is mapped
+void TestTruncatedFile(){
+	Test::TempDirectory directory;
+	std::vector<uint8_t> file = Test::MakeDDSFile(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, 9, 1);
+
+	CHECK(Util::WriteMemoryToFile(directory.wideFile("short.dds"), file.data(), file.size() - 1));
+
+	RecordingDevice *device = new RecordingDevice;
+	ID3D11Resource *texture = nullptr;
+	uint64_t numViewsBefore, numViews, numBytes;
+
+	GetMappingStats(numViewsBefore, numBytes);
+
+	CHECK(FAILED(DirectX::CreateDDSTextureFromFileEx(device, directory.wideFile("short.dds").c_str(), 0, D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE, 0, 0, false, &texture, nullptr)));
+
+	GetMappingStats(numViews, numBytes);
+
+	CHECK(!texture);
+	CHECK(numViews == numViewsBefore);
+
+	device->Release();
+}
+
+// Volume texture whose top mip alone is past 4 GB, the kept mips start beyond it and are the only part mapped.
+// The file is sparse, only the kept range holds data
+void TestPast4GB(){
+	const DXGI_FORMAT Format	= DXGI_FORMAT_R8G8B8A8_UNORM;
+	const uint32_t Size			= 2048;
+	const uint32_t Depth		= 257;
+	const uint32_t MipCount		= 12;
+
+	Test::TempDirectory directory;
+	uint64_t fileSize = Test::GetDDSFileSize(Format, Size, Size, Depth, MipCount, 1);
+	uint64_t keptOffset = Test::DDSHeaderSize + DirectX::GetTextureMemorySize(Size, Size, Depth, 3, 1, Format);
+
+	CHECK(keptOffset > FourGB);
+	CHECK(Test::WriteSparseDDSFile(directory.file("huge.dds"), Test::MakeDDSHeaders(Format, Size, Size, Depth, MipCount, 1), fileSize,
+		keptOffset, fileSize));
+
+	DirectX::DDS_METADATA metadata;
+
+	CHECK(SUCCEEDED(DirectX::GetDDSMetadataFromFile(directory.wideFile("huge.dds").c_str(), metadata)));
+	CHECK(metadata.dataSize + metadata.headerSize == fileSize);
+	CHECK(metadata.subresources.size() == MipCount && metadata.subresources[3].offset == keptOffset);
+
+	RecordingDevice *device = new RecordingDevice;
+	ID3D11Resource *texture = nullptr;
+	uint64_t mappedBefore = MappedBytes();
+
+	CHECK(SUCCEEDED(DirectX::CreateDDSTextureFromFileEx(device, directory.wideFile("huge.dds").c_str(), 256, D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE, 0, 0, false, &texture, nullptr)));
+
+	CHECK(MappedBytes() - mappedBefore <= fileSize - keptOffset + 65536);
+
+	if(texture){
+		const D3D11_TEXTURE3D_DESC &desc = static_cast<ID3D11Texture3D *>(texture)->desc;
+
+		CHECK(desc.Width == 256 && desc.Height == 256 && desc.Depth == 32 && desc.MipLevels == MipCount - 3);
+		CheckSubresources(*device, metadata, 3);
+	}
+
+	ReleaseCOM(texture);
+	device->Release();
+}
+
+// Files without mips are created as they are, the chain is built when packing and never at load time
+void TestNoCPUMips(){
+	std::vector<uint8_t> file = Test::MakeDDSFile(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, 1, 1);
+
+	DirectX::DDS_METADATA metadata;
+
+	CHECK(SUCCEEDED(DirectX::GetDDSMetadataFromMemory(file.data(), file.size(), file.size(), metadata)));
+
+	RecordingDevice *device = new RecordingDevice;
+	ID3D11Resource *texture = nullptr;
+
+	CHECK(SUCCEEDED(DirectX::CreateDDSTextureFromMemoryEx(device, file.data(), file.size(), 0, D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE, 0, 0, false, &texture, nullptr)));
+
+	if(texture){
+		CHECK(static_cast<ID3D11Texture2D *>(texture)->desc.MipLevels == 1);
+		CheckSubresources(*device, metadata, 0);
+	}
+
+	// The footprint agrees with what was created
+	size_t width, height, mipCount, numBytes;
+
+	CHECK(SUCCEEDED(DirectX::GetDDSTextureFootprintFromMemory(file.data(), file.size(), 0, &width, &height, &mipCount, &numBytes)));
+	CHECK(width == 256 && height == 256 && mipCount == 1 && numBytes == file.size() - Test::DDSHeaderSize);
+
+	ReleaseCOM(texture);
+	device->Release();
+}
+
+}
+
+TEST_MAIN(TestMapsKeptMips, TestArrayMaxsize, TestTruncatedFile, TestPast4GB, TestNoCPUMips)
@@ -0,0 +1,347 @@
+#pragma once
+
+////////////////////////////////////////
+// DirectXMath subset for Linux tests //
+////////////////////////////////////////
+
+// Only what the portable engine sources call, on plain SSE with the same row vector conventions
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace DirectX{
+
+const float XM_PI = 3.141592654f;
+const float XM_PIDIV4 = 0.785398163f;
+
+typedef __m128 XMVECTOR;
+
+struct XMFLOAT2{
+	float x, y;
+	XMFLOAT2(){}
+	XMFLOAT2(float _x, float _y) : x(_x), y(_y){}
+};
+
+struct XMUINT2{
+	uint32_t x, y;
+	XMUINT2(){}
+	XMUINT2(uint32_t _x, uint32_t _y) : x(_x), y(_y){}
+};
+
+struct XMFLOAT3{
+	float x, y, z;
+	XMFLOAT3(){}
+	XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z){}
+};
+
+struct XMFLOAT4{
+	float x, y, z, w;
+	XMFLOAT4(){}
+	XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w){}
+};
+
+struct XMFLOAT4X4{
+	union{
+		struct{
+			float _11, _12, _13, _14;
+			float _21, _22, _23, _24;
+			float _31, _32, _33, _34;
+			float _41, _42, _43, _44;
+		};
+		float m[4][4];
+	};
+};
+
+struct XMMATRIX{
+	XMVECTOR r[4];
+};
+
+inline XMVECTOR XMVectorSet(float x, float y, float z, float w){
+	return _mm_set_ps(w, z, y, x);
+}
+
+inline XMVECTOR XMVectorReplicate(float value){
+	return _mm_set1_ps(value);
+}
+
+inline XMVECTOR XMVectorZero(){
+	return _mm_setzero_ps();
+}
+
+inline XMVECTOR XMVectorFalseInt(){
+	return _mm_setzero_ps();
+}
+
+inline XMVECTOR XMVectorSetW(XMVECTOR v, float w){
+	float f[4];
+
+	_mm_storeu_ps(f, v);
+	f[3] = w;
+
+	return _mm_loadu_ps(f);
+}
+
+inline XMVECTOR XMVectorAdd(XMVECTOR a, XMVECTOR b){
+	return _mm_add_ps(a, b);
+}
+
+inline XMVECTOR XMVectorSubtract(XMVECTOR a, XMVECTOR b){
+	return _mm_sub_ps(a, b);
+}
+
+inline XMVECTOR XMVectorScale(XMVECTOR v, float scale){
+	return _mm_mul_ps(v, _mm_set1_ps(scale));
+}
+
+inline XMVECTOR XMVectorMultiplyAdd(XMVECTOR a, XMVECTOR b, XMVECTOR c){
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+inline XMVECTOR XMVectorMin(XMVECTOR a, XMVECTOR b){
+	return _mm_min_ps(a, b);
+}
+
+inline XMVECTOR XMVectorMax(XMVECTOR a, XMVECTOR b){
+	return _mm_max_ps(a, b);
+}
+
+inline XMVECTOR XMVectorGreater(XMVECTOR a, XMVECTOR b){
+	return _mm_cmpgt_ps(a, b);
+}
+
+inline XMVECTOR XMVectorAndInt(XMVECTOR a, XMVECTOR b){
+	return _mm_and_ps(a, b);
+}
+
+// Picks b where the control bits are set
+inline XMVECTOR XMVectorSelect(XMVECTOR a, XMVECTOR b, XMVECTOR control){
+	return _mm_or_ps(_mm_andnot_ps(control, a), _mm_and_ps(control, b));
+}
+
+inline bool XMVector4EqualInt(XMVECTOR a, XMVECTOR b){
+	return _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_castps_si128(a), _mm_castps_si128(b))) == 0xFFFF;
+}
+
+// Dot product in every component
+inline XMVECTOR XMVector3Dot(XMVECTOR a, XMVECTOR b){
+	float f[4];
+
+	_mm_storeu_ps(f, _mm_mul_ps(a, b));
+
+	return _mm_set1_ps(f[0] + f[1] + f[2]);
+}
+
+inline XMVECTOR XMVector3Cross(XMVECTOR a, XMVECTOR b){
+	XMVECTOR aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	XMVECTOR bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	XMVECTOR cross = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+
+	// w comes out zero
+	return _mm_shuffle_ps(cross, cross, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+inline XMVECTOR XMVector3Normalize(XMVECTOR v){
+	float length = _mm_cvtss_f32(XMVector3Dot(v, v));
+
+	return length > 0.0f ? _mm_div_ps(v, _mm_set1_ps(sqrtf(length))) : v;
+}
+
+// Scales the whole plane so (a, b, c) has unit length
+inline XMVECTOR XMPlaneNormalize(XMVECTOR plane){
+	return XMVector3Normalize(plane);
+}
+
+inline XMVECTOR XMLoadFloat3(const XMFLOAT3 *source){
+	return _mm_set_ps(0.0f, source->z, source->y, source->x);
+}
+
+inline XMVECTOR XMLoadFloat4(const XMFLOAT4 *source){
+	return _mm_loadu_ps(&source->x);
+}
+
+inline void XMStoreFloat4(XMFLOAT4 *dest, XMVECTOR v){
+	_mm_storeu_ps(&dest->x, v);
+}
+
+inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4 *source){
+	XMMATRIX m;
+
+	for(int i = 0; i < 4; i++){
+		m.r[i] = _mm_loadu_ps(source->m[i]);
+	}
+
+	return m;
+}
+
+inline void XMStoreFloat4x4(XMFLOAT4X4 *dest, const XMMATRIX &m){
+	for(int i = 0; i < 4; i++){
+		_mm_storeu_ps(dest->m[i], m.r[i]);
+	}
+}
+
+inline XMMATRIX XMMatrixSet(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13,
+	float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33){
+
+	XMMATRIX m;
+
+	m.r[0] = XMVectorSet(m00, m01, m02, m03);
+	m.r[1] = XMVectorSet(m10, m11, m12, m13);
+	m.r[2] = XMVectorSet(m20, m21, m22, m23);
+	m.r[3] = XMVectorSet(m30, m31, m32, m33);
+
+	return m;
+}
+
+inline XMMATRIX XMMatrixIdentity(){
+	return XMMatrixSet(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+}
+
+inline XMMATRIX XMMatrixTranslation(float x, float y, float z){
+	return XMMatrixSet(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1);
+}
+
+// Row vector times matrix
+inline XMVECTOR XMVector4Transform(XMVECTOR v, const XMMATRIX &m){
+	XMVECTOR x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+	XMVECTOR y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+	XMVECTOR z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+	XMVECTOR w = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m.r[0]), _mm_mul_ps(y, m.r[1])), _mm_add_ps(_mm_mul_ps(z, m.r[2]), _mm_mul_ps(w, m.r[3])));
+}
+
+// Row vector with w = 0 times matrix
+inline XMVECTOR XMVector3TransformNormal(XMVECTOR v, const XMMATRIX &m){
+	XMVECTOR x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+	XMVECTOR y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+	XMVECTOR z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m.r[0]), _mm_mul_ps(y, m.r[1])), _mm_mul_ps(z, m.r[2]));
+}
+
+inline XMMATRIX XMMatrixMultiply(const XMMATRIX &a, const XMMATRIX &b){
+	XMMATRIX m;
+
+	for(int i = 0; i < 4; i++){
+		m.r[i] = XMVector4Transform(a.r[i], b);
+	}
+
+	return m;
+}
+
+inline XMMATRIX XMMatrixTranspose(const XMMATRIX &m){
+	XMMATRIX t = m;
+
+	_MM_TRANSPOSE4_PS(t.r[0], t.r[1], t.r[2], t.r[3]);
+
+	return t;
+}
+
+// Left handed, depth from 0 at the near plane to 1 at the far plane
+inline XMMATRIX XMMatrixPerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ){
+	float yScale = 1.0f / tanf(0.5f * fovY);
+	float range = farZ / (farZ - nearZ);
+
+	return XMMatrixSet(
+		yScale / aspect, 0, 0, 0,
+		0, yScale, 0, 0,
+		0, 0, range, 1,
+		0, 0, -range * nearZ, 0);
+}
+
+inline XMMATRIX XMMatrixOrthographicLH(float width, float height, float nearZ, float farZ){
+	float range = 1.0f / (farZ - nearZ);
+
+	return XMMatrixSet(
+		2.0f / width, 0, 0, 0,
+		0, 2.0f / height, 0, 0,
+		0, 0, range, 0,
+		0, 0, -range * nearZ, 1);
+}
+
+// Left handed, x = up x forward
+inline XMMATRIX XMMatrixLookAtLH(XMVECTOR eye, XMVECTOR focus, XMVECTOR up){
+	XMVECTOR z = XMVector3Normalize(_mm_sub_ps(focus, eye));
+	XMVECTOR x = XMVector3Normalize(XMVector3Cross(up, z));
+	XMVECTOR y = XMVector3Cross(z, x);
+
+	XMMATRIX m;
+
+	m.r[0] = x;
+	m.r[1] = y;
+	m.r[2] = z;
+	m.r[3] = _mm_setzero_ps();
+
+	m = XMMatrixTranspose(m);
+	m.r[3] = XMVectorSet(-_mm_cvtss_f32(XMVector3Dot(x, eye)), -_mm_cvtss_f32(XMVector3Dot(y, eye)), -_mm_cvtss_f32(XMVector3Dot(z, eye)), 1.0f);
+
+	return m;
+}
+
+// Rotates row vectors angle radians about the axis, clockwise looking down it like DirectXMath
+inline XMMATRIX XMMatrixRotationAxis(XMVECTOR axis, float angle){
+	float a[4];
+
+	_mm_storeu_ps(a, XMVector3Normalize(axis));
+
+	float x = a[0], y = a[1], z = a[2];
+	float s = sinf(angle), c = cosf(angle), t = 1.0f - c;
+
+	return XMMatrixSet(
+		t * x * x + c, t * x * y + s * z, t * x * z - s * y, 0,
+		t * x * y - s * z, t * y * y + c, t * y * z + s * x, 0,
+		t * x * z + s * y, t * y * z - s * x, t * z * z + c, 0,
+		0, 0, 0, 1);
+}
+
+inline XMMATRIX XMMatrixRotationY(float angle){
+	float s = sinf(angle), c = cosf(angle);
+
+	return XMMatrixSet(
+		c, 0, -s, 0,
+		0, 1, 0, 0,
+		s, 0, c, 0,
+		0, 0, 0, 1);
+}
+
+// Cofactors over the determinant, the determinant goes in every component of *determinant when asked for
+inline XMMATRIX XMMatrixInverse(XMVECTOR *determinant, const XMMATRIX &matrix){
+	XMFLOAT4X4 source, result;
+
+	XMStoreFloat4x4(&source, matrix);
+
+	const float *m = &source.m[0][0];
+	float *r = &result.m[0][0];
+
+	r[0]	= m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	r[4]	= -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	r[8]	= m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	r[12]	= -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	r[1]	= -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	r[5]	= m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	r[9]	= -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	r[13]	= m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	r[2]	= m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	r[6]	= -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	r[10]	= m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	r[14]	= -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	r[3]	= -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	r[7]	= m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	r[11]	= -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	r[15]	= m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	float det = m[0] * r[0] + m[1] * r[4] + m[2] * r[8] + m[3] * r[12];
+
+	if(determinant) *determinant = _mm_set1_ps(det);
+
+	float scale = det != 0.0f ? 1.0f / det : 0.0f;
+
+	for(int i = 0; i < 16; i++) r[i] *= scale;
+
+	return XMLoadFloat4x4(&result);
+}
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+///////////////////////////////////
+// Engine header for Linux tests //
+///////////////////////////////////
+
+// Stands in for Engine/Engine.h when the portable engine sources are built for the tests. The Makefile copies
+// those sources next to nothing else, so their #include "Engine.h" lands here. Windows and D3D only get the
+// declarations the tested code touches and fail where they would touch a real device or file
+
+// STD headers
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+// Windows, D3D and DirectXMath stand-ins
+#include "Win32.h"
+#include <d3d11_1.h>
+#include <D3Dcompiler.h>
+#include "DirectXMath.h"
+
+class IDXGISwapChain;
+class ID3D11RenderTargetView;
+class ID3D11DepthStencilView;
+class ID3D11VertexShader;
+class ID3D11PixelShader;
+
+#define D3D11_APPEND_ALIGNED_ELEMENT	0xffffffff
+
+enum D3D11_INPUT_CLASSIFICATION{
+	D3D11_INPUT_PER_VERTEX_DATA		= 0,
+	D3D11_INPUT_PER_INSTANCE_DATA	= 1
+};
+
+struct D3D11_INPUT_ELEMENT_DESC{
+	const char *SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D11_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+// Project headers the tested sources need, Util's file and hashing helpers are in Platform.cpp
+#include "Util.h"
+#include "Allocators.h"
+#include "Id.h"
+#include "EntityWorld.h"
+#include "GpuMemoryTracker.h"
+#include "DDSTextureLoader.h"
+#include "TextureManifest.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
+#include "Timer.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "ShaderCache.h"
+#include "InputLayoutCache.h"
+#include "ShaderPermutations.h"
+#include "MappedFile.h"
+#include "TexturePack.h"
+#include "TextureStreamer.h"
+#include "AssetLoader.h"
+#include "UploadManager.h"
+
+// Reads made through Util::ReadFileToMemory and Util::ReadFileRange so far and the bytes they asked for
+void GetFileReadStats(uint64_t &numReads, uint64_t &numBytes);
+
+// ReadFile calls on handles from CreateFileW so far and the bytes they returned
+void GetHandleReadStats(uint64_t &numReads, uint64_t &numBytes);
+
+// Engine
+struct BoxHeader{
+	int32_t numVertices;
+	int32_t numIndices;
+};
+
+struct BoxVertex{
+	float x, y, z, w;
+	float normX, normY, normZ;
+	float u, v;
+	float tanX, tanY, tanZ;
+};
+
+#include "Camera.h"
+#include "Occlusion.h"
+#include "LightCulling.h"
+#include "LightClusters.h"
@@ -0,0 +1,172 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumEntities	= 1000000;
+const uint32_t NumRounds	= 10;
+const uint32_t NumWorkers	= 3;
+
+struct Transform{
+	float m[16];
+};
+
+struct Bounds{
+	float min[3], max[3];
+};
+
+struct Mesh{
+	const void *mesh;
+};
+
+struct Material{
+	uint32_t diffuse, normal;
+};
+
+struct Shadow{
+	uint32_t flags;
+};
+
+struct Tag{
+	uint32_t value;
+};
+
+// Keeps the iteration loops from being optimized away
+volatile double g_sink;
+
+double NsPerEntity(double ms, uint32_t numEntities){
+	return ms * 1e6 / numEntities;
+}
+
+}
+
+int Test::g_failures = 0;
+
+// The renderables Main.cpp makes, every fourth one a shadow caster
+int main(){
+	EntityWorld world;
+	ComponentMask renderable = ComponentMaskOf<Transform, Bounds, Mesh, Material>::get();
+	std::vector<Id> ids(NumEntities);
+	std::vector<uint32_t> order(NumEntities);
+
+	// Scattered over every entity the way lookups from gameplay code would be
+	for(uint32_t i = 0; i < NumEntities; i++) order[i] = static_cast<uint32_t>(static_cast<uint64_t>(i) * 7919 % NumEntities);
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumEntities; i++){
+		ids[i] = world.create(i % 4 == 0 ? renderable | ComponentType<Shadow>::mask() : renderable);
+
+		world.get<Transform>(ids[i])->m[12] = static_cast<float>(i);
+
+		if(Shadow *shadow = world.get<Shadow>(ids[i])) shadow->flags = 1;
+	}
+
+	double createMs = Test::ElapsedMs(start);
+
+	// Every transform chunk by chunk, against the same reads through ids
+	std::vector<EntityWorld::Chunk> chunks;
+	double sum = 0.0;
+
+	start = Test::Clock::now();
+
+	for(uint32_t round = 0; round < NumRounds; round++){
+		world.getChunks(ComponentMaskOf<Transform, Bounds>::get(), 0, chunks);
+
+		for(auto &chunk : chunks){
+			const Transform *transforms = chunk.get<Transform>();
+
+			for(uint32_t row = 0; row < chunk.size(); row++) sum += transforms[row].m[12];
+		}
+	}
+
+	double iterateMs = Test::ElapsedMs(start);
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumEntities; i++) sum += world.get<Transform>(ids[order[i]])->m[12];
+
+	double getMs = Test::ElapsedMs(start);
+
+	// Shadow casters gathered chunk by chunk on the job system, the way the shadow pass extracts them
+	JobSystem jobs(NumWorkers);
+	size_t numDrawn = 0;
+
+	start = Test::Clock::now();
+
+	for(uint32_t round = 0; round < NumRounds; round++){
+		world.getChunks(ComponentMaskOf<Transform, Mesh, Shadow>::get(), 0, chunks);
+
+		std::vector<std::vector<uint32_t>> drawLists(chunks.size());
+
+		jobs.parallelFor(chunks.size(), 1, [&](size_t begin, size_t end){
+			for(size_t i = begin; i < end; i++){
+				const Transform *transforms = chunks[i].get<Transform>();
+				const Shadow *shadows = chunks[i].get<Shadow>();
+
+				for(uint32_t row = 0; row < chunks[i].size(); row++){
+					if(shadows[row].flags && transforms[row].m[12] >= 0.0f) drawLists[i].push_back(row);
+				}
+			}
+		});
+
+		for(auto &drawList : drawLists) numDrawn += drawList.size();
+	}
+
+	double extractMs = Test::ElapsedMs(start);
+
+	if(numDrawn != NumRounds * NumEntities / 4) Test::g_failures++;
+
+	// Structural changes, each one moves the entity to another archetype
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumEntities; i++){
+		Tag tag = {i};
+
+		world.add<Tag>(ids[i], tag);
+	}
+
+	double addMs = Test::ElapsedMs(start);
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumEntities; i += 2) world.removeComponents(ids[i], ComponentType<Tag>::mask());
+
+	double removeMs = Test::ElapsedMs(start);
+
+	uint32_t numWrong = 0;
+
+	for(uint32_t i = 0; i < NumEntities; i++){
+		Tag *tag = world.get<Tag>(ids[i]);
+
+		numWrong += (tag != nullptr) != (i % 2 == 1) || (tag && tag->value != i);
+		numWrong += world.get<Transform>(ids[i])->m[12] != static_cast<float>(i);
+	}
+
+	if(numWrong != 0) Test::g_failures++;
+
+	uint32_t numArchetypes = world.getNumArchetypes();
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumEntities; i++) world.destroy(ids[order[i]]);
+
+	double destroyMs = Test::ElapsedMs(start);
+
+	world.getChunks(0, 0, chunks);
+
+	if(world.getNumEntities() != 0 || !chunks.empty()) Test::g_failures++;
+
+	g_sink = sum;
+
+	std::printf("%u entities, %u archetypes, %u byte chunks, %u workers\n", NumEntities, numArchetypes, EntityWorld::ChunkSize, NumWorkers);
+	std::printf("create        %6.1f ns/entity\n", NsPerEntity(createMs, NumEntities));
+	std::printf("iterate       %6.2f ns/entity through chunks, %6.2f ns/entity through ids\n", NsPerEntity(iterateMs, NumRounds * NumEntities),
+		NsPerEntity(getMs, NumEntities));
+	std::printf("extract       %6.2f ns/entity\n", NsPerEntity(extractMs, NumRounds * NumEntities));
+	std::printf("add component %6.1f ns/entity\n", NsPerEntity(addMs, NumEntities));
+	std::printf("remove        %6.1f ns/entity\n", NsPerEntity(removeMs, NumEntities / 2));
+	std::printf("destroy       %6.1f ns/entity\n", NsPerEntity(destroyMs, NumEntities));
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+struct Transform{
+	float m[16];
+};
+
+struct Bounds{
+	float min[3], max[3];
+};
+
+struct Shadow{
+	uint32_t flags;
+};
+
+struct Tag{
+	uint64_t value;
+};
+
+float GetX(const EntityWorld &world, const Id &id){
+	Transform *transform = world.get<Transform>(id);
+
+	return transform ? transform->m[12] : -1.0f;
+}
+
+// Components start zeroed, entities only have what their mask says
+void TestCreate(){
+	EntityWorld world;
+	Id id = world.create(ComponentMaskOf<Transform, Bounds>::get());
+
+	ComponentMask mask = ComponentMaskOf<Transform, Bounds>::get();
+
+	CHECK(world.isAlive(id) && world.getMask(id) == mask);
+	CHECK(world.get<Transform>(id) && world.get<Bounds>(id) && !world.get<Shadow>(id));
+
+	Transform *transform = world.get<Transform>(id);
+	bool zeroed = true;
+
+	for(float value : transform->m) zeroed = zeroed && value == 0.0f;
+
+	CHECK(zeroed);
+
+	CHECK(world.destroy(id) && !world.isAlive(id) && !world.destroy(id));
+	CHECK(!world.get<Transform>(id) && world.getNumEntities() == 0);
+}
+
+// Enough entities for several chunks, destroying from the middle moves the last one without losing anything
+void TestDestroy(){
+	const uint32_t NumEntities = 10000;
+
+	EntityWorld world;
+	std::vector<Id> ids;
+
+	for(uint32_t i = 0; i < NumEntities; i++){
+		ids.push_back(world.create(ComponentMaskOf<Transform, Shadow>::get()));
+		world.get<Transform>(ids.back())->m[12] = static_cast<float>(i);
+	}
+
+	for(uint32_t i = 0; i < NumEntities; i += 3) world.destroy(ids[i]);
+
+	uint32_t numWrong = 0;
+
+	for(uint32_t i = 0; i < NumEntities; i++){
+		if(i % 3 == 0) numWrong += world.isAlive(ids[i]);
+		else numWrong += GetX(world, ids[i]) != static_cast<float>(i);
+	}
+
+	CHECK(numWrong == 0);
+	CHECK(world.getNumEntities() == NumEntities - (NumEntities + 2) / 3);
+
+	// Chunks hold exactly the live entities and their ids point back at them
+	std::vector<EntityWorld::Chunk> chunks;
+	uint32_t numSeen = 0;
+
+	world.getChunks(ComponentType<Transform>::mask(), 0, chunks);
+
+	CHECK(chunks.size() > 1);
+
+	for(auto &chunk : chunks){
+		const Transform *transforms = chunk.get<Transform>();
+
+		for(uint32_t row = 0; row < chunk.size(); row++){
+			numWrong += world.get<Transform>(chunk.getIds()[row]) != &transforms[row];
+			numSeen++;
+		}
+	}
+
+	CHECK(numWrong == 0 && numSeen == world.getNumEntities());
+}
+
+// Adding and removing components moves the entity between archetypes and keeps what it already had
+void TestStructuralChanges(){
+	EntityWorld world;
+	Id a = world.create(ComponentType<Transform>::mask());
+	Id b = world.create(ComponentType<Transform>::mask());
+
+	world.get<Transform>(a)->m[12] = 1.0f;
+	world.get<Transform>(b)->m[12] = 2.0f;
+
+	Tag tag = {42};
+
+	CHECK(world.add<Tag>(a, tag) && world.get<Tag>(a)->value == 42);
+	CHECK(GetX(world, a) == 1.0f && GetX(world, b) == 2.0f);
+	CHECK(world.getNumArchetypes() == 2);
+
+	// Adding what it has changes nothing
+	CHECK(world.addComponents(a, ComponentType<Tag>::mask()) && world.get<Tag>(a)->value == 42);
+
+	CHECK(world.removeComponents(a, ComponentType<Tag>::mask()));
+	CHECK(!world.get<Tag>(a) && GetX(world, a) == 1.0f);
+
+	// A component added again starts zeroed
+	CHECK(world.addComponents(a, ComponentType<Tag>::mask()) && world.get<Tag>(a)->value == 0);
+
+	world.destroy(b);
+	CHECK(!world.addComponents(b, ComponentType<Tag>::mask()) && !world.removeComponents(b, ComponentType<Tag>::mask()));
+}
+
+// Queries match every archetype with the required components and none of the excluded ones
+void TestQueries(){
+	EntityWorld world;
+	ComponentMask renderable = ComponentMaskOf<Transform, Bounds>::get();
+
+	for(uint32_t i = 0; i < 100; i++){
+		world.create(i % 4 == 0 ? renderable | ComponentType<Shadow>::mask() : renderable);
+		world.create(ComponentType<Tag>::mask());
+	}
+
+	std::vector<EntityWorld::Chunk> chunks;
+
+	auto count = [&](ComponentMask required, ComponentMask excluded){
+		uint32_t numEntities = 0;
+
+		world.getChunks(required, excluded, chunks);
+
+		for(auto &chunk : chunks) numEntities += chunk.has(required) ? chunk.size() : 0;
+
+		return numEntities;
+	};
+
+	CHECK(count(renderable, 0) == 100);
+	CHECK(count(ComponentType<Shadow>::mask(), 0) == 25);
+	CHECK(count(renderable, ComponentType<Shadow>::mask()) == 75);
+	CHECK(count(ComponentType<Tag>::mask(), 0) == 100);
+	CHECK(count(0, 0) == 200);
+	ComponentMask tagged = ComponentMaskOf<Tag, Transform>::get();
+
+	CHECK(count(tagged, 0) == 0);
+}
+
+}
+
+TEST_MAIN(TestCreate, TestDestroy, TestStructuralChanges, TestQueries)
@@ -0,0 +1,71 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumFrames		= 20000;
+const uint32_t NumWorkFrames	= 500;
+
+// Busy work that stays on its own thread's cache lines
+void Spin(uint32_t iterations){
+	volatile uint32_t sink = 0;
+
+	for(uint32_t i = 0; i < iterations; i++) sink = sink + i;
+}
+
+// Frames through the pipeline at one latency, in ms per frame and frames per second from both the wall clock and
+// the pipeline's own stats
+void Run(JobSystem &jobs, uint32_t latency, uint32_t numFrames, uint32_t updateWork, uint32_t submitWork){
+	std::vector<uint64_t> submitted;
+
+	submitted.reserve(numFrames);
+
+	FramePipeline pipeline(jobs, latency,
+		[](uint32_t, uint64_t){},
+		[=](uint32_t, uint64_t){ Spin(updateWork); },
+		[&](uint32_t, uint64_t frame){
+			Spin(submitWork);
+			submitted.push_back(frame);
+		});
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < numFrames; i++) pipeline.runFrame();
+
+	double ms = Test::ElapsedMs(start) / numFrames;
+	const FramePipelineStats &stats = pipeline.getStats();
+
+	if(submitted.size() != numFrames || stats.numFrames != numFrames) Test::g_failures++;
+
+	std::printf("  latency %u   %8.4f ms/frame %10.0f frames/s   stats %8.4f ms/frame %10.0f frames/s %8.4f ms latency\n", latency, ms,
+		1000.0 / ms, stats.averageFrameTime * 1000.0, stats.framesPerSecond, stats.averageLatency * 1000.0);
+}
+
+}
+
+int Test::g_failures = 0;
+
+// The pipeline's own cost with stages that do nothing, then with an update and a submit of about the same length
+// where a latency above 1 lets the update of the next frame run during the submit of this one
+int main(){
+	JobSystem jobs;
+	const uint32_t latencies[] = {1, 2, 4};
+
+	// Calibrate the spin to about a millisecond
+	Test::Clock::time_point start = Test::Clock::now();
+
+	Spin(10000000);
+
+	uint32_t msWork = static_cast<uint32_t>(10000000 / Test::ElapsedMs(start));
+
+	std::printf("%u workers\n", jobs.getNumWorkers());
+	std::printf("Null stages, %u frames\n", NumFrames);
+
+	for(uint32_t latency : latencies) Run(jobs, latency, NumFrames, 0, 0);
+
+	std::printf("1 ms update and 1 ms submit, %u frames\n", NumWorkFrames);
+
+	for(uint32_t latency : latencies) Run(jobs, latency, NumWorkFrames, msWork, msWork);
+
+	return Test::g_failures ? 1 : 0;
+}
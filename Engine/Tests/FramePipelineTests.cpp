@@ -0,0 +1,171 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumWorkers	= 3;
+const uint32_t NumFrames	= 200;
+
+// What the stages see of the frames, each stage checks the others left it the state it expects
+struct Recorder{
+	uint32_t latency;
+
+	// Frame owning each slot, -1 once submitted
+	int64_t slotFrames[FramePipeline::MaxLatency];
+
+	std::atomic<int64_t> lastUpdate;
+	std::atomic<int> numUpdating;
+	int64_t lastSubmit;
+	uint32_t numInFlight, maxInFlight;
+
+	explicit Recorder(uint32_t latency) : latency(latency), lastUpdate(-1), numUpdating(0), lastSubmit(-1), numInFlight(0), maxInFlight(0){
+		for(auto &frame : slotFrames) frame = -1;
+	}
+
+	void snapshot(uint32_t slot, uint64_t frame){
+		CHECK(slot < latency && slot == frame % latency);
+
+		// The slot's last frame was submitted before it is handed out again
+		CHECK(slotFrames[slot] == -1);
+
+		slotFrames[slot] = static_cast<int64_t>(frame);
+		maxInFlight = std::max(maxInFlight, ++numInFlight);
+	}
+
+	void update(uint32_t slot, uint64_t frame, uint32_t spinIterations){
+		CHECK(numUpdating.fetch_add(1) == 0);
+		CHECK(slotFrames[slot] == static_cast<int64_t>(frame));
+
+		// One after another in frame order
+		CHECK(lastUpdate.load() + 1 == static_cast<int64_t>(frame));
+
+		volatile uint32_t sink = 0;
+
+		for(uint32_t i = 0; i < spinIterations; i++) sink = sink + i;
+
+		lastUpdate = static_cast<int64_t>(frame);
+		numUpdating--;
+	}
+
+	void submit(uint32_t slot, uint64_t frame){
+		CHECK(slotFrames[slot] == static_cast<int64_t>(frame));
+		CHECK(lastUpdate.load() >= static_cast<int64_t>(frame));
+		CHECK(lastSubmit + 1 == static_cast<int64_t>(frame));
+
+		lastSubmit = static_cast<int64_t>(frame);
+		slotFrames[slot] = -1;
+		numInFlight--;
+	}
+};
+
+// Stages that do nothing but check each other at every latency, with updates of varying length so workers pick
+// them up at different points of the main thread's frame
+void TestOrdering(){
+	JobSystem jobs(NumWorkers);
+	const uint32_t latencies[] = {1, 2, 4};
+
+	for(uint32_t latency : latencies){
+		Recorder recorder(latency);
+
+		FramePipeline pipeline(jobs, latency,
+			[&](uint32_t slot, uint64_t frame){ recorder.snapshot(slot, frame); },
+			[&](uint32_t slot, uint64_t frame){ recorder.update(slot, frame, static_cast<uint32_t>(frame * 7919 % 20000)); },
+			[&](uint32_t slot, uint64_t frame){ recorder.submit(slot, frame); });
+
+		CHECK(pipeline.getLatency() == latency);
+
+		for(uint32_t i = 0; i < NumFrames; i++) pipeline.runFrame();
+
+		// Latency frames stay in flight, each already snapshotted once
+		CHECK(recorder.lastSubmit == NumFrames - 1);
+		CHECK(recorder.maxInFlight == latency && recorder.numInFlight == latency - 1);
+
+		pipeline.flush();
+
+		CHECK(recorder.lastUpdate == NumFrames + latency - 2);
+	}
+}
+
+// Frames dropped by a flush or a latency change are snapshotted and updated again, submits carry on without a gap
+void TestFlush(){
+	JobSystem jobs(NumWorkers);
+	std::vector<uint64_t> submitted;
+	std::atomic<uint32_t> numUpdates(0);
+	uint32_t numSnapshots = 0;
+
+	FramePipeline pipeline(jobs, 2,
+		[&](uint32_t, uint64_t){ numSnapshots++; },
+		[&](uint32_t, uint64_t){ numUpdates++; },
+		[&](uint32_t, uint64_t frame){ submitted.push_back(frame); });
+
+	CHECK(pipeline.getLatency() == 2);
+
+	for(uint32_t i = 0; i < 10; i++) pipeline.runFrame();
+
+	pipeline.setLatency(4);
+	CHECK(pipeline.getLatency() == 4);
+
+	for(uint32_t i = 0; i < 10; i++) pipeline.runFrame();
+
+	pipeline.setLatency(0);
+	CHECK(pipeline.getLatency() == 1);
+
+	for(uint32_t i = 0; i < 10; i++) pipeline.runFrame();
+
+	pipeline.setLatency(100);
+	CHECK(pipeline.getLatency() == FramePipeline::MaxLatency);
+
+	pipeline.flush();
+
+	CHECK(submitted.size() == 30);
+
+	for(uint32_t i = 0; i < submitted.size(); i++) CHECK(submitted[i] == i);
+
+	// Frame 10 was in flight at the first change, 20 to 22 at the second
+	CHECK(numSnapshots == 30 + 1 + 3);
+	CHECK(numUpdates == numSnapshots);
+}
+
+// The submit takes a known time, so every frame time is at least that and a frame's latency covers the submits
+// of the frames queued ahead of it plus its own
+void TestStats(){
+	const double SubmitTime = 0.002;
+
+	JobSystem jobs(NumWorkers);
+	const uint32_t latencies[] = {1, 2, 4};
+
+	for(uint32_t latency : latencies){
+		FramePipeline pipeline(jobs, latency,
+			[](uint32_t, uint64_t){},
+			[](uint32_t, uint64_t){},
+			[&](uint32_t, uint64_t){ std::this_thread::sleep_for(std::chrono::duration<double>(SubmitTime)); });
+
+		const FramePipelineStats &stats = pipeline.getStats();
+
+		CHECK(stats.numFrames == 0 && stats.framesPerSecond == 0);
+
+		for(uint32_t i = 0; i < 20; i++) pipeline.runFrame();
+
+		CHECK(stats.numFrames == 20);
+		CHECK(stats.minFrameTime >= SubmitTime && stats.minFrameTime <= stats.averageFrameTime && stats.averageFrameTime <= stats.maxFrameTime);
+		CHECK(fabs(stats.framesPerSecond * stats.averageFrameTime - 1.0) < 1e-9);
+
+		// The first frames have fewer queued ahead of them
+		CHECK(stats.averageLatency >= SubmitTime * (latency + 1) / 2);
+		CHECK(stats.averageLatency <= stats.maxFrameTime * latency);
+
+		pipeline.resetStats();
+
+		CHECK(stats.numFrames == 0 && stats.averageFrameTime == 0 && stats.averageLatency == 0 && stats.framesPerSecond == 0);
+
+		// Frame times restart from the next submit
+		pipeline.runFrame();
+		pipeline.runFrame();
+
+		CHECK(stats.numFrames == 2 && stats.minFrameTime == stats.maxFrameTime && stats.minFrameTime >= SubmitTime);
+	}
+}
+
+}
+
+TEST_MAIN(TestOrdering, TestFlush, TestStats)
@@ -0,0 +1,270 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+namespace{
+
+// Same as the null device but every format can get its mips generated
+class AutogenDevice : public ID3D11Device{
+public:
+	HRESULT CheckFormatSupport(DXGI_FORMAT, UINT *support){
+		*support = D3D11_FORMAT_SUPPORT_TEXTURE2D | D3D11_FORMAT_SUPPORT_MIP_AUTOGEN;
+
+		return S_OK;
+	}
+};
+
+GpuMemoryUsage GetUsage(const GpuMemoryTracker &tracker, GpuMemoryCategory category){
+	GpuMemoryStats stats;
+
+	tracker.getStats(stats);
+
+	return stats.categories[category];
+}
+
+GpuMemoryUsage GetTotal(const GpuMemoryTracker &tracker){
+	GpuMemoryStats stats;
+
+	tracker.getStats(stats);
+
+	return stats.total;
+}
+
+// Allocations over a category or the total budget are rejected and counted, freeing makes room again
+void TestBudgets(){
+	GpuMemoryTracker tracker;
+
+	tracker.setBudget(GpuMemoryTexture, 1000);
+	tracker.setTotalBudget(1500);
+
+	GpuAllocationId first = tracker.allocate(GpuMemoryTexture, 600);
+	GpuAllocationId second = tracker.allocate(GpuMemoryTexture, 600);
+	GpuAllocationId buffer = tracker.allocate(GpuMemoryVertexBuffer, 1000);
+	GpuAllocationId small = tracker.allocate(GpuMemoryVertexBuffer, 400);
+
+	CHECK(first != GpuMemoryTracker::InvalidAllocation && small != GpuMemoryTracker::InvalidAllocation);
+	CHECK(second == GpuMemoryTracker::InvalidAllocation && buffer == GpuMemoryTracker::InvalidAllocation);
+
+	GpuMemoryUsage textures = GetUsage(tracker, GpuMemoryTexture), total = GetTotal(tracker);
+
+	CHECK(textures.bytes == 600 && textures.numAllocations == 1 && textures.numRejected == 1);
+	CHECK(total.bytes == 1000 && total.numAllocations == 2 && total.numRejected == 2);
+
+	tracker.free(first);
+	second = tracker.allocate(GpuMemoryTexture, 1000);
+
+	CHECK(second != GpuMemoryTracker::InvalidAllocation);
+	CHECK(GetUsage(tracker, GpuMemoryTexture).peakBytes == 1000);
+
+	// Lowering the budget keeps what's there, removing it lets anything through
+	tracker.setBudget(GpuMemoryTexture, 10);
+	CHECK(GetUsage(tracker, GpuMemoryTexture).bytes == 1000);
+	CHECK(tracker.allocate(GpuMemoryTexture, 1) == GpuMemoryTracker::InvalidAllocation);
+
+	tracker.setBudget(GpuMemoryTexture, 0);
+	tracker.setTotalBudget(0);
+	CHECK(tracker.allocate(GpuMemoryTexture, 1ULL << 40) != GpuMemoryTracker::InvalidAllocation);
+
+	// Unknown and invalid ids are ignored, a double free only counts once
+	tracker.free(second);
+	tracker.free(second);
+	tracker.free(GpuMemoryTracker::InvalidAllocation);
+
+	CHECK(GetUsage(tracker, GpuMemoryTexture).bytes == 1ULL << 40);
+	CHECK(GetUsage(tracker, GpuMemoryVertexBuffer).bytes == 400);
+}
+
+// The frame counters hold the last finished frame's traffic, per category and in total
+void TestFrames(){
+	GpuMemoryTracker tracker;
+
+	GpuAllocationId a = tracker.allocate(GpuMemoryIndexBuffer, 100);
+	GpuAllocationId b = tracker.allocate(GpuMemoryConstantBuffer, 50);
+
+	tracker.free(a);
+	tracker.endFrame();
+
+	GpuMemoryUsage indices = GetUsage(tracker, GpuMemoryIndexBuffer), total = GetTotal(tracker);
+
+	CHECK(indices.frameAllocated == 100 && indices.frameFreed == 100);
+	CHECK(total.frameAllocated == 150 && total.frameFreed == 100 && total.bytes == 50);
+
+	tracker.free(b);
+	tracker.endFrame();
+	tracker.endFrame();
+
+	total = GetTotal(tracker);
+
+	GpuMemoryStats stats;
+	tracker.getStats(stats);
+
+	CHECK(stats.frame == 3);
+	CHECK(total.frameAllocated == 0 && total.frameFreed == 0 && total.bytes == 0 && total.peakBytes == 150);
+}
+
+// Tags follow the allocations made under them, sorted by what they hold now
+void TestTags(){
+	GpuMemoryTracker tracker;
+
+	uint32_t rocks = tracker.getTag(L"rocks.dds");
+	uint32_t trees = tracker.getTag(L"trees.dds");
+
+	CHECK(rocks != trees && tracker.getTag(L"rocks.dds") == rocks);
+
+	GpuAllocationId rock = tracker.allocate(GpuMemoryTexture, 100, rocks);
+	tracker.allocate(GpuMemoryTexture, 300, trees);
+	tracker.allocate(GpuMemoryTexture, 1000);
+
+	std::vector<GpuMemoryTagStats> tags;
+
+	tracker.getTagStats(tags);
+
+	CHECK(tags.size() == 2);
+
+	if(tags.size() == 2){
+		CHECK(tags[0].name == L"trees.dds" && tags[0].bytes == 300);
+		CHECK(tags[1].name == L"rocks.dds" && tags[1].bytes == 100 && tags[1].numAllocations == 1);
+	}
+
+	tracker.free(rock);
+	tracker.getTagStats(tags);
+
+	CHECK(tags.size() == 2 && tags[1].bytes == 0 && tags[1].peakBytes == 100);
+
+	// The calling thread's tag is picked up by the process-wide tracker and restored when the scope ends
+	CHECK(GpuMemoryTag::getCurrent() == GpuMemoryTracker::NoTag);
+
+	{
+		GpuMemoryTag outer(L"outer");
+		uint32_t outerTag = GpuMemoryTag::getCurrent();
+
+		{
+			GpuMemoryTag inner(L"inner");
+			CHECK(GpuMemoryTag::getCurrent() != outerTag);
+		}
+
+		CHECK(GpuMemoryTag::getCurrent() == outerTag);
+	}
+
+	CHECK(GpuMemoryTag::getCurrent() == GpuMemoryTracker::NoTag);
+}
+
+// Full chains add every level down to 1x1, BC levels round up to whole blocks
+void TestTextureSizes(){
+	struct Size{
+		size_t width, height, depth;
+		DXGI_FORMAT format;
+	};
+
+	const Size sizes[] = {
+		{256, 256, 1, DXGI_FORMAT_R8G8B8A8_UNORM},
+		{300, 17, 1, DXGI_FORMAT_R8G8B8A8_UNORM},
+		{1024, 128, 1, DXGI_FORMAT_BC1_UNORM},
+		{13, 7, 1, DXGI_FORMAT_BC3_UNORM},
+		{32, 16, 64, DXGI_FORMAT_R16G16B16A16_FLOAT}
+	};
+
+	for(const Size &size : sizes){
+		size_t numLevels = 0, levelBytes = 0;
+
+		for(size_t width = size.width, height = size.height, depth = size.depth; ; width = std::max<size_t>(width >> 1, 1),
+			height = std::max<size_t>(height >> 1, 1), depth = std::max<size_t>(depth >> 1, 1)){
+
+			levelBytes += DirectX::GetTextureMemorySize(width, height, depth, 1, 1, size.format);
+			numLevels++;
+
+			if(width == 1 && height == 1 && depth == 1) break;
+		}
+
+		CHECK(DirectX::GetTextureMemorySize(size.width, size.height, size.depth, 0, 1, size.format) == levelBytes);
+		CHECK(DirectX::GetTextureMemorySize(size.width, size.height, size.depth, numLevels, 1, size.format) == levelBytes);
+		CHECK(DirectX::GetTextureMemorySize(size.width, size.height, size.depth, 0, 3, size.format) == levelBytes * 3);
+	}
+
+	CHECK(DirectX::GetTextureMemorySize(4, 4, 1, 1, 1, DXGI_FORMAT_BC1_UNORM) == 8);
+	CHECK(DirectX::GetTextureMemorySize(1, 1, 1, 1, 1, DXGI_FORMAT_BC1_UNORM) == 8);
+}
+
+// A reservation lives as long as its resource, a failed creation gives it back straight away
+void TestResources(){
+	GpuMemoryTracker &tracker = GetGpuMemoryTracker();
+	ID3D11Device *device = new ID3D11Device;
+	uint64_t before = GetUsage(tracker, GpuMemoryVertexBuffer).bytes;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth	= 4096;
+	desc.BindFlags	= D3D11_BIND_VERTEX_BUFFER;
+
+	GpuAllocationId allocation = ReserveGpuMemory(GetGpuMemoryCategory(desc.BindFlags, desc.Usage), desc.ByteWidth);
+	ID3D11Buffer *buffer = nullptr;
+
+	CHECK(allocation != GpuMemoryTracker::InvalidAllocation);
+	CHECK(SUCCEEDED(device->CreateBuffer(&desc, nullptr, &buffer)));
+
+	BindGpuMemory(buffer, allocation);
+	CHECK(GetUsage(tracker, GpuMemoryVertexBuffer).bytes == before + 4096);
+
+	buffer->Release();
+	CHECK(GetUsage(tracker, GpuMemoryVertexBuffer).bytes == before);
+
+	allocation = ReserveGpuMemory(GpuMemoryVertexBuffer, 4096);
+	BindGpuMemory(nullptr, allocation);
+	CHECK(GetUsage(tracker, GpuMemoryVertexBuffer).bytes == before);
+
+	CHECK(GetGpuMemoryCategory(D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET, D3D11_USAGE_DEFAULT) == GpuMemoryTexture);
+	CHECK(GetGpuMemoryCategory(D3D11_BIND_RENDER_TARGET, D3D11_USAGE_DEFAULT) == GpuMemoryRenderTarget);
+	CHECK(GetGpuMemoryCategory(D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DEFAULT) == GpuMemoryDepthStencil);
+	CHECK(GetGpuMemoryCategory(D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_STAGING) == GpuMemoryStaging);
+
+	device->Release();
+}
+
+// DDS textures are charged before they're created, autogen mips for the whole chain, and fail over the budget
+void TestTextures(){
+	const DXGI_FORMAT Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+	GpuMemoryTracker &tracker = GetGpuMemoryTracker();
+	ID3D11Device *device = new AutogenDevice;
+	ID3D11DeviceContext *context = new ID3D11DeviceContext;
+	std::vector<uint8_t> file = Test::MakeDDSFile(Format, 256, 128, 1, 1, 1);
+	uint64_t chainBytes = DirectX::GetTextureMemorySize(256, 128, 1, 0, 1, Format);
+	uint64_t before = GetUsage(tracker, GpuMemoryTexture).bytes;
+
+	ID3D11Resource *texture = nullptr;
+	ID3D11ShaderResourceView *view = nullptr;
+
+	CHECK(SUCCEEDED(DirectX::CreateDDSTextureFromMemoryEx(device, context, file.data(), file.size(), 0, D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE, 0, 0, false, &texture, &view)));
+
+	CHECK(texture && view);
+	CHECK(GetUsage(tracker, GpuMemoryTexture).bytes == before + chainBytes);
+
+	if(view) view->Release();
+	if(texture) texture->Release();
+
+	CHECK(GetUsage(tracker, GpuMemoryTexture).bytes == before);
+
+	// One byte short of the chain, the top level alone would still fit
+	uint64_t rejected = GetUsage(tracker, GpuMemoryTexture).numRejected;
+
+	texture	= nullptr;
+	view	= nullptr;
+
+	tracker.setBudget(GpuMemoryTexture, before + chainBytes - 1);
+
+	CHECK(DirectX::CreateDDSTextureFromMemoryEx(device, context, file.data(), file.size(), 0, D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE, 0, 0, false, &texture, &view) == E_OUTOFMEMORY);
+
+	CHECK(!texture && !view);
+	CHECK(GetUsage(tracker, GpuMemoryTexture).numRejected == rejected + 1);
+	CHECK(GetUsage(tracker, GpuMemoryTexture).bytes == before);
+
+	tracker.setBudget(GpuMemoryTexture, 0);
+
+	context->Release();
+	device->Release();
+}
+
+}
+
+TEST_MAIN(TestBudgets, TestFrames, TestTags, TestTextureSizes, TestResources, TestTextures)
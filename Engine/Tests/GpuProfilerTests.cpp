@@ -0,0 +1,278 @@
+#include "Engine.h"
+#include "Test.h"
+
+#include <map>
+
+namespace{
+
+const uint64_t TicksPerSecond = 1000000;
+
+// A GPU that finishes every query delay frames after it was issued. Its clock runs at 1 MHz, each frame
+// starts 10 ms after the previous one and consecutive timestamps are 100 ticks apart
+class FakeQuerySource : public GpuQuerySource{
+private:
+	struct Result{
+		uint64_t readyFrame;
+		uint64_t value;
+	};
+
+	uint32_t m_numFrames, m_numTimestamps;
+	uint32_t m_delay;
+	uint32_t m_numIssued;
+
+	std::map<uint32_t, Result> m_disjoint;
+	std::map<std::pair<uint32_t, uint32_t>, Result> m_timestamps;
+	std::vector<bool> m_open;
+
+public:
+	uint64_t now;
+	bool failCreate, nextDisjoint;
+
+	// Queries used the wrong way, e.g. a timestamp outside its frame
+	uint32_t numMisuses;
+
+	FakeQuerySource(uint32_t delay) : m_numFrames(0), m_numTimestamps(0), m_delay(delay), m_numIssued(0){
+		now				= 0;
+		failCreate		= false;
+		nextDisjoint	= false;
+		numMisuses		= 0;
+	}
+
+	bool create(uint32_t numFrames, uint32_t numTimestamps){
+		m_numFrames		= numFrames;
+		m_numTimestamps	= numTimestamps;
+		m_open.assign(numFrames, false);
+
+		return !failCreate;
+	}
+
+	void beginFrame(uint32_t frame){
+		if(frame >= m_numFrames || m_open[frame]) numMisuses++;
+
+		m_open[frame]	= true;
+		m_numIssued		= 0;
+
+		m_disjoint.erase(frame);
+	}
+
+	void endFrame(uint32_t frame){
+		if(frame >= m_numFrames || !m_open[frame]) numMisuses++;
+
+		Result result = {now + m_delay, nextDisjoint ? 1u : 0u};
+
+		m_open[frame]		= false;
+		m_disjoint[frame]	= result;
+	}
+
+	void timestamp(uint32_t frame, uint32_t index){
+		if(frame >= m_numFrames || !m_open[frame] || index >= m_numTimestamps) numMisuses++;
+
+		Result result = {now + m_delay, 1000 + now * 10000 + (m_numIssued++) * 100};
+
+		m_timestamps[std::make_pair(frame, index)] = result;
+	}
+
+	bool getFrequency(uint32_t frame, uint64_t &frequency, bool &disjoint){
+		auto it = m_disjoint.find(frame);
+
+		if(it == m_disjoint.end() || it->second.readyFrame > now) return false;
+
+		frequency	= TicksPerSecond;
+		disjoint	= it->second.value != 0;
+
+		return true;
+	}
+
+	bool getTimestamp(uint32_t frame, uint32_t index, uint64_t &ticks){
+		auto it = m_timestamps.find(std::make_pair(frame, index));
+
+		// Reading a timestamp that was never issued
+		if(it == m_timestamps.end()){
+			numMisuses++;
+			return false;
+		}
+
+		if(it->second.readyFrame > now) return false;
+
+		ticks = it->second.value;
+
+		return true;
+	}
+};
+
+// Frame, then shadows and scene inside it
+void RecordFrame(GpuProfiler &profiler, FakeQuerySource &source){
+	source.now++;
+
+	profiler.beginFrame();
+
+	{
+		GPU_PROFILE_ZONE(profiler, "Frame (GPU)");
+
+		{
+			GPU_PROFILE_ZONE(profiler, "Shadows (GPU)");
+		}
+
+		{
+			GPU_PROFILE_ZONE(profiler, "Scene (GPU)");
+		}
+	}
+
+	profiler.endFrame();
+}
+
+bool Near(double a, double b){
+	return std::abs(a - b) < 1e-9;
+}
+
+// Results come back latency frames late, a GPU further behind than the query slots makes frames get skipped
+void TestLatency(){
+	const uint32_t Latency = 3;
+
+	for(uint32_t delay = 0; delay <= Latency + 2; delay++){
+		FakeQuerySource *source = new FakeQuerySource(delay);
+		GpuProfiler profiler(std::unique_ptr<GpuQuerySource>(source), Latency);
+
+		for(int i = 0; i < 100; i++) RecordFrame(profiler, *source);
+
+		CHECK(source->numMisuses == 0);
+
+		// One slot more than the latency, so a GPU that far behind still doesn't skip
+		if(delay <= Latency + 1){
+			CHECK(profiler.getNumSkipped() == 0);
+			CHECK(profiler.getNumCollected() >= 100 - delay - 1);
+		}
+		else{
+			CHECK(profiler.getNumSkipped() > 0);
+			CHECK(profiler.getNumCollected() + profiler.getNumSkipped() >= 100 - delay - 1);
+		}
+
+		CHECK(profiler.getNumDisjoint() == 0);
+	}
+}
+
+// Zones come back in issue order with their nesting, relative to the first one and in milliseconds
+void TestTimings(){
+	FakeQuerySource *source = new FakeQuerySource(2);
+	GpuProfiler profiler(std::unique_ptr<GpuQuerySource>(source), 3);
+
+	CHECK(profiler.getTimings().empty());
+
+	for(int i = 0; i < 10; i++) RecordFrame(profiler, *source);
+
+	const std::vector<GpuZoneTiming> &timings = profiler.getTimings();
+
+	CHECK(timings.size() == 3);
+
+	if(timings.size() == 3){
+		CHECK(strcmp(timings[0].name, "Frame (GPU)") == 0 && strcmp(timings[1].name, "Shadows (GPU)") == 0);
+		CHECK(timings[0].depth == 0 && timings[1].depth == 1 && timings[2].depth == 1);
+
+		// 100 ticks at 1 MHz are 0.1 ms
+		CHECK(timings[0].begin == 0.0 && Near(timings[0].duration, 0.5));
+		CHECK(Near(timings[1].begin, 0.1) && Near(timings[1].duration, 0.1));
+		CHECK(Near(timings[2].begin, 0.3) && Near(timings[2].duration, 0.1));
+	}
+
+	// The GPU zones land on the profiler's GPU track
+	Profiler::endFrame();
+
+	std::vector<ProfileZoneStats> stats;
+	bool found = false;
+
+	Profiler::getStats(stats);
+
+	for(auto &zone : stats) found = found || strcmp(zone.name, "Scene (GPU)") == 0;
+
+	CHECK(found);
+}
+
+// A frame whose GPU clock changed is counted and dropped, the next good frame replaces it
+void TestDisjoint(){
+	FakeQuerySource *source = new FakeQuerySource(1);
+	GpuProfiler profiler(std::unique_ptr<GpuQuerySource>(source), 2);
+
+	source->nextDisjoint = true;
+	RecordFrame(profiler, *source);
+	source->nextDisjoint = false;
+
+	for(int i = 0; i < 5; i++) RecordFrame(profiler, *source);
+
+	CHECK(profiler.getNumDisjoint() == 1);
+	CHECK(profiler.getNumCollected() >= 3);
+	CHECK(profiler.getTimings().size() == 3);
+}
+
+// Zones past the limit, unknown zones and zones left open are ignored without touching the queries
+void TestUnbalancedZones(){
+	FakeQuerySource *source = new FakeQuerySource(1);
+	GpuProfiler profiler(std::unique_ptr<GpuQuerySource>(source), 2);
+
+	source->now++;
+	profiler.beginFrame();
+
+	uint32_t numValid = 0;
+
+	for(uint32_t i = 0; i < GpuProfiler::MaxZones + 8; i++){
+		numValid += profiler.beginZone("Leak") != GpuProfiler::InvalidZone;
+	}
+
+	profiler.endZone(12345);
+	profiler.endZone(GpuProfiler::InvalidZone);
+
+	// Only the first zone is closed, twice
+	profiler.endZone(0);
+	profiler.endZone(0);
+	profiler.endFrame();
+
+	CHECK(numValid == GpuProfiler::MaxZones);
+
+	// Zones outside a frame go nowhere
+	CHECK(profiler.beginZone("Outside") == GpuProfiler::InvalidZone);
+	profiler.endZone(0);
+
+	for(int i = 0; i < 3; i++) RecordFrame(profiler, *source);
+
+	CHECK(source->numMisuses == 0);
+	CHECK(profiler.getNumSkipped() == 0);
+	CHECK(profiler.getTimings().size() == 3);
+}
+
+// Without queries nothing is timed and nothing breaks
+void TestNoQueries(){
+	FakeQuerySource *source = new FakeQuerySource(0);
+
+	source->failCreate = true;
+
+	GpuProfiler profiler(std::unique_ptr<GpuQuerySource>(source), 2);
+
+	for(int i = 0; i < 10; i++) RecordFrame(profiler, *source);
+
+	CHECK(profiler.getNumCollected() == 0 && profiler.getNumSkipped() == 0);
+	CHECK(profiler.getTimings().empty());
+
+	// The null device's queries never finish, frames are skipped instead of waited for
+	ID3D11Device *device = new ID3D11Device;
+	ID3D11DeviceContext *context = new ID3D11DeviceContext;
+
+	{
+		GpuProfiler d3dProfiler(device, context, 2);
+
+		for(int i = 0; i < 10; i++){
+			d3dProfiler.beginFrame();
+			{
+				GPU_PROFILE_ZONE(d3dProfiler, "Frame (GPU)");
+			}
+			d3dProfiler.endFrame();
+		}
+
+		CHECK(d3dProfiler.getNumCollected() == 0 && d3dProfiler.getNumSkipped() == 7);
+	}
+
+	context->Release();
+	device->Release();
+}
+
+}
+
+TEST_MAIN(TestLatency, TestTimings, TestDisjoint, TestUnbalancedZones, TestNoQueries)
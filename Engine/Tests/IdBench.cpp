@@ -0,0 +1,138 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumIds = 2000000;
+
+// Keeps the compare and lookup loops from being optimized away
+volatile size_t g_sink;
+
+double NsPerId(double ms){
+	return ms * 1e6 / NumIds;
+}
+
+// The GUID id the allocator replaced, a GUID and its string in every object
+class GuidId{
+private:
+	GUID m_guid;
+	std::wstring m_string;
+
+public:
+	GuidId(){
+		wchar_t string[40];
+
+		CoCreateGuid(&m_guid);
+		StringFromGUID2(m_guid, string, 40);
+		m_string = string;
+	}
+
+	bool operator== (const GuidId &id) const{
+		return m_guid == id.m_guid;
+	}
+};
+
+void BenchGuidIds(const std::vector<uint32_t> &order){
+	std::vector<GuidId> ids;
+	size_t hits = 0;
+
+	ids.reserve(NumIds);
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumIds; i++) ids.emplace_back();
+
+	double createMs = Test::ElapsedMs(start);
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumIds; i++) hits += ids[i] == ids[order[i]];
+
+	double compareMs = Test::ElapsedMs(start);
+
+	start = Test::Clock::now();
+
+	ids.clear();
+	ids.shrink_to_fit();
+
+	double destroyMs = Test::ElapsedMs(start);
+
+	g_sink = hits;
+
+	std::printf("GUID ids     create %6.1f ns, compare %5.2f ns, destroy %5.1f ns, %zu bytes each\n", NsPerId(createMs), NsPerId(compareMs),
+		NsPerId(destroyMs), sizeof(GuidId));
+}
+
+void BenchAllocator(const std::vector<uint32_t> &order){
+	IdAllocator allocator;
+	std::vector<Id> ids(NumIds);
+	Test::Random random(1);
+	size_t hits = 0;
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumIds; i++) ids[i] = allocator.create();
+
+	double createMs = Test::ElapsedMs(start);
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumIds; i++) hits += allocator.isValid(ids[order[i]]);
+
+	double lookupMs = Test::ElapsedMs(start);
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumIds; i++) hits += ids[i] == ids[order[i]];
+
+	double compareMs = Test::ElapsedMs(start);
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumIds; i++) allocator.destroy(ids[order[i]]);
+
+	double destroyMs = Test::ElapsedMs(start);
+
+	// Random ids replaced one at a time, the handle that was replaced has to stop being valid
+	for(uint32_t i = 0; i < NumIds; i++) ids[i] = allocator.create();
+
+	size_t numStale = 0;
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumIds; i++){
+		uint32_t index = random.range(0u, NumIds);
+		Id old = ids[index];
+
+		allocator.destroy(old);
+		ids[index] = allocator.create();
+		numStale += allocator.isValid(old);
+	}
+
+	double churnMs = Test::ElapsedMs(start);
+
+	g_sink = hits;
+
+	if(numStale != 0 || allocator.getNumAlive() != NumIds || allocator.getCapacity() != NumIds) Test::g_failures++;
+
+	std::printf("IdAllocator  create %6.1f ns, compare %5.2f ns, destroy %5.1f ns, %zu bytes each, lookup %5.2f ns, churn %5.1f ns\n",
+		NsPerId(createMs), NsPerId(compareMs), NsPerId(destroyMs), sizeof(Id), NsPerId(lookupMs), NsPerId(churnMs));
+}
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	std::vector<uint32_t> order(NumIds);
+
+	// Scattered over the whole range the way lookups from other objects would be
+	for(uint32_t i = 0; i < NumIds; i++) order[i] = static_cast<uint32_t>(static_cast<uint64_t>(i) * 7919 % NumIds);
+
+	std::printf("%u ids\n", NumIds);
+
+	BenchGuidIds(order);
+	BenchAllocator(order);
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+// Ids are unique among the live ones and stale ids stay invalid once their slot is reused
+void TestGenerations(){
+	IdAllocator ids;
+	Id a = ids.create(), b = ids.create();
+
+	CHECK(ids.isValid(a) && ids.isValid(b) && a != b);
+	CHECK(ids.destroy(a) && !ids.isValid(a));
+	CHECK(!ids.destroy(a));
+
+	Id c = ids.create();
+
+	CHECK(c.getIndex() == a.getIndex() && c.getGeneration() != a.getGeneration());
+	CHECK(c != a && !ids.isValid(a) && ids.isValid(c));
+	CHECK(ids.getNumAlive() == 2 && ids.getCapacity() == 2);
+
+	// The null id never matches a slot
+	Id null;
+
+	CHECK(null.isNull() && !ids.isValid(null) && !ids.destroy(null));
+	CHECK(!ids.isValid(Id(5, 1)));
+}
+
+// Random creates and destroys never hand out a live id twice and keep the capacity at the peak
+void TestChurn(){
+	IdAllocator ids;
+	Test::Random random(7);
+	std::vector<Id> live, dead;
+
+	for(int i = 0; i < 100000; i++){
+		if(live.empty() || random.range(0u, 3u) != 0){
+			Id id = ids.create();
+
+			CHECK(ids.isValid(id));
+			live.push_back(id);
+		}
+		else{
+			size_t index = random.range(0u, static_cast<uint32_t>(live.size()));
+
+			CHECK(ids.destroy(live[index]));
+			dead.push_back(live[index]);
+			live[index] = live.back();
+			live.pop_back();
+		}
+	}
+
+	std::vector<Id> sorted = live;
+	std::sort(sorted.begin(), sorted.end());
+
+	CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+	CHECK(ids.getNumAlive() == live.size());
+
+	size_t numStale = 0;
+
+	for(auto &id : dead) numStale += ids.isValid(id);
+
+	CHECK(numStale == 0);
+}
+
+// GUIDs are only made when asked for, stay put for the id and die with it
+void TestGuids(){
+	IdAllocator ids;
+	Id a = ids.create();
+	GUID first, second;
+
+	CHECK(ids.getGuid(a, first) && ids.getGuid(a, second) && first == second);
+	CHECK(ids.getGuidString(a).size() == 38);
+
+	ids.destroy(a);
+	CHECK(!ids.getGuid(a, first) && ids.getGuidString(a).empty());
+
+	Id b = ids.create();
+
+	CHECK(ids.getGuid(b, second) && first != second);
+}
+
+}
+
+TEST_MAIN(TestGenerations, TestChurn, TestGuids)
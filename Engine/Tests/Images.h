@@ -0,0 +1,52 @@
+#pragma once
+
+/////////////////
+// Test images //
+/////////////////
+
+// Deterministic RGBA8 reference images for the codec tests and benchmarks, tightly packed rows
+
+#include "Test.h"
+
+namespace Test{
+
+enum ImageKind{
+	ImageSmooth,	// Low frequency gradients, like most albedo and normal maps
+	ImageEdges,		// Flat colored tiles with hard edges between them
+	ImageNoise,		// Uncorrelated channels, the worst case for every block format
+};
+
+inline std::vector<uint8_t> MakeImage(ImageKind kind, size_t width, size_t height){
+	std::vector<uint8_t> image(width * height * 4);
+	Random random(1234);
+
+	for(size_t y = 0; y < height; y++){
+		for(size_t x = 0; x < width; x++){
+			uint8_t *texel = &image[(y * width + x) * 4];
+
+			if(kind == ImageSmooth){
+				texel[0] = static_cast<uint8_t>(128.0 + 127.0 * sin(x * 0.05));
+				texel[1] = static_cast<uint8_t>(128.0 + 127.0 * cos(y * 0.03 + x * 0.01));
+				texel[2] = static_cast<uint8_t>(((x + y) * 255) / (width + height));
+				texel[3] = static_cast<uint8_t>((x * 255) / width);
+			}
+			else if(kind == ImageEdges){
+				uint32_t tile = static_cast<uint32_t>((x / 13) * 7919 + (y / 11) * 104729);
+
+				texel[0] = static_cast<uint8_t>(tile * 37);
+				texel[1] = static_cast<uint8_t>(tile * 91);
+				texel[2] = static_cast<uint8_t>(tile * 53);
+				texel[3] = (tile & 1) ? 255 : 64;
+			}
+			else{
+				uint32_t value = random.next();
+
+				memcpy(texel, &value, 4);
+			}
+		}
+	}
+
+	return image;
+}
+
+}
@@ -0,0 +1,84 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumLookups	= 1000000;
+const uint32_t NumShaders	= 256;
+
+// Keeps the key loop from being optimized away
+volatile uint64_t g_keySink;
+
+// The first elements are shared by every signature, the last one tells them apart the way extra UV sets would
+Util::VertexLayoutData MakeSignature(uint32_t signature){
+	const char *names[] = {"POSITION", "NORMAL", "TANGENT", "TEXCOORD"};
+	const DXGI_FORMAT formats[] = {DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R32G32_FLOAT};
+	Util::VertexLayoutData layoutData;
+
+	layoutData.bytecode.resize(1024, static_cast<uint8_t>(signature));
+
+	for(uint32_t i = 0; i < 4; i++){
+		D3D11_INPUT_ELEMENT_DESC element = {nullptr, i == 3 ? signature : 0, formats[i], 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0};
+
+		layoutData.semanticNames.push_back(names[i]);
+		layoutData.elements.push_back(element);
+	}
+
+	return layoutData;
+}
+
+}
+
+int Test::g_failures = 0;
+
+// Shaders spread over a growing number of distinct signatures, every lookup after the first few is a hit
+int main(){
+	const uint32_t signatureCounts[] = {1, 4, 16, 64};
+
+	std::printf("%u lookups over %u shaders\n", NumLookups, NumShaders);
+
+	for(uint32_t numSignatures : signatureCounts){
+		std::vector<Util::VertexLayoutData> shaders;
+
+		for(uint32_t i = 0; i < NumShaders; i++) shaders.push_back(MakeSignature(i % numSignatures));
+
+		uint32_t numCreated = 0;
+		InputLayoutCache cache([&](const Util::VertexLayoutData &, ID3D11InputLayout **layout){
+			numCreated++;
+			*layout = new ID3D11InputLayout;
+
+			return true;
+		});
+
+		ID3D11InputLayout *layout;
+		Test::Clock::time_point start = Test::Clock::now();
+
+		for(uint32_t i = 0; i < NumLookups; i++){
+			if(!cache.get(shaders[i % NumShaders], &layout)) Test::g_failures++;
+		}
+
+		double ms = Test::ElapsedMs(start);
+
+		// The key alone, to separate hashing from the scan and comparison
+		uint64_t keys = 0;
+
+		start = Test::Clock::now();
+
+		for(uint32_t i = 0; i < NumLookups; i++){
+			const Util::VertexLayoutData &shader = shaders[i % NumShaders];
+
+			keys += InputLayoutCache::ComputeKey(shader.semanticNames, shader.elements);
+		}
+
+		double keyMs = Test::ElapsedMs(start);
+
+		g_keySink = keys;
+
+		if(numCreated != numSignatures) Test::g_failures++;
+
+		std::printf("%2u signatures %6.1f ns/lookup, %6.1f ns of it hashing, %u layouts created\n", numSignatures, ms * 1e6 / NumLookups,
+			keyMs * 1e6 / NumLookups, numCreated);
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+// Counts how many layouts are still alive so the tests can see the cache release them
+std::atomic<int> g_numLiveLayouts(0);
+
+class CountedLayout : public ID3D11InputLayout{
+public:
+	CountedLayout(){ g_numLiveLayouts++; }
+	~CountedLayout(){ g_numLiveLayouts--; }
+};
+
+struct Creator{
+	uint32_t numCreated;
+	bool fail;
+
+	Creator() : numCreated(0), fail(false){}
+
+	InputLayoutCache::CreateFunc func(){
+		return [this](const Util::VertexLayoutData &, ID3D11InputLayout **layout){
+			if(fail) return false;
+
+			numCreated++;
+			*layout = new CountedLayout;
+
+			return true;
+		};
+	}
+};
+
+Util::VertexLayoutData MakeSignature(const std::vector<std::pair<const char *, DXGI_FORMAT>> &elements, uint8_t bytecode){
+	Util::VertexLayoutData layoutData;
+
+	layoutData.bytecode.push_back(bytecode);
+
+	for(auto &element : elements){
+		D3D11_INPUT_ELEMENT_DESC desc = {nullptr, 0, element.second, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0};
+
+		layoutData.semanticNames.push_back(element.first);
+		layoutData.elements.push_back(desc);
+	}
+
+	return layoutData;
+}
+
+Util::VertexLayoutData MakeMaterialSignature(uint8_t bytecode){
+	return MakeSignature({{"SV_POSITION", DXGI_FORMAT_R32G32B32A32_FLOAT}, {"NORMAL", DXGI_FORMAT_R32G32B32_FLOAT},
+		{"TEXCOORD", DXGI_FORMAT_R32G32_FLOAT}}, bytecode);
+}
+
+uint64_t Key(const Util::VertexLayoutData &layoutData){
+	return InputLayoutCache::ComputeKey(layoutData.semanticNames, layoutData.elements);
+}
+
+// Shaders with the same signature share a layout whatever their bytecode and however they spell the semantics
+void TestSharing(){
+	Creator creator;
+
+	{
+		InputLayoutCache cache(creator.func());
+		Util::VertexLayoutData material = MakeMaterialSignature(1), shadow = MakeMaterialSignature(2);
+		Util::VertexLayoutData passthrough = MakeSignature({{"SV_POSITION", DXGI_FORMAT_R32G32B32A32_FLOAT}, {"TEXCOORD", DXGI_FORMAT_R32G32_FLOAT}}, 3);
+		Util::VertexLayoutData secondUV = MakeMaterialSignature(4);
+
+		shadow.semanticNames[1] = "normal";
+		secondUV.elements[2].SemanticIndex = 1;
+
+		ID3D11InputLayout *materialLayout, *shadowLayout, *passthroughLayout, *secondUVLayout;
+
+		CHECK(cache.get(material, &materialLayout));
+		CHECK(cache.get(shadow, &shadowLayout));
+		CHECK(cache.get(passthrough, &passthroughLayout));
+		CHECK(cache.get(secondUV, &secondUVLayout));
+
+		CHECK(materialLayout == shadowLayout);
+		CHECK(materialLayout != passthroughLayout && materialLayout != secondUVLayout && passthroughLayout != secondUVLayout);
+		CHECK(creator.numCreated == 3 && cache.getNumLayouts() == 3 && cache.getNumHits() == 1);
+		CHECK(g_numLiveLayouts == 3);
+	}
+
+	// Every layout released exactly once
+	CHECK(g_numLiveLayouts == 0);
+}
+
+// Every field that changes the layout changes the key, names don't run into each other and case doesn't matter
+void TestKeys(){
+	Util::VertexLayoutData base = MakeMaterialSignature(1);
+	uint64_t key = Key(base);
+
+	Util::VertexLayoutData changed = base;
+	changed.semanticNames[0] = "sv_Position";
+	CHECK(Key(changed) == key);
+	CHECK(InputLayoutCache::IsSameSignature(base.semanticNames, base.elements, changed.semanticNames, changed.elements));
+
+	changed = MakeMaterialSignature(2);
+	CHECK(Key(changed) == key);
+
+	for(uint32_t field = 0; field < 6; field++){
+		changed = base;
+
+		D3D11_INPUT_ELEMENT_DESC &element = changed.elements[1];
+
+		switch(field){
+		case 0: element.SemanticIndex = 1; break;
+		case 1: element.Format = DXGI_FORMAT_R16G16B16A16_FLOAT; break;
+		case 2: element.InputSlot = 1; break;
+		case 3: element.AlignedByteOffset = 12; break;
+		case 4: element.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA; break;
+		case 5: element.InstanceDataStepRate = 1; break;
+		}
+
+		CHECK(Key(changed) != key);
+		CHECK(!InputLayoutCache::IsSameSignature(base.semanticNames, base.elements, changed.semanticNames, changed.elements));
+	}
+
+	changed = base;
+	changed.semanticNames[1] = "BINORMAL";
+	CHECK(Key(changed) != key);
+
+	// Element order matters
+	changed = base;
+	std::swap(changed.semanticNames[1], changed.semanticNames[2]);
+	std::swap(changed.elements[1], changed.elements[2]);
+	CHECK(Key(changed) != key);
+
+	Util::VertexLayoutData ab = MakeSignature({{"AB", DXGI_FORMAT_UNKNOWN}, {"C", DXGI_FORMAT_UNKNOWN}}, 1);
+	Util::VertexLayoutData bc = MakeSignature({{"A", DXGI_FORMAT_UNKNOWN}, {"BC", DXGI_FORMAT_UNKNOWN}}, 1);
+
+	CHECK(Key(ab) != Key(bc));
+
+	// A prefix of a signature is a different signature
+	Util::VertexLayoutData prefix = base;
+	prefix.semanticNames.pop_back();
+	prefix.elements.pop_back();
+	CHECK(Key(prefix) != key);
+	CHECK(!InputLayoutCache::IsSameSignature(base.semanticNames, base.elements, prefix.semanticNames, prefix.elements));
+}
+
+// Bad signatures and failed creates are reported and leave nothing behind
+void TestFailures(){
+	Creator creator;
+	InputLayoutCache cache(creator.func());
+	ID3D11InputLayout *layout = nullptr;
+
+	Util::VertexLayoutData empty;
+	empty.bytecode.push_back(1);
+	CHECK(!cache.get(empty, &layout));
+
+	Util::VertexLayoutData missingName = MakeMaterialSignature(1);
+	missingName.semanticNames.pop_back();
+	CHECK(!cache.get(missingName, &layout));
+
+	// A failed create is retried on the next request
+	creator.fail = true;
+	CHECK(!cache.get(MakeMaterialSignature(1), &layout));
+	CHECK(cache.getNumLayouts() == 0);
+
+	creator.fail = false;
+	CHECK(cache.get(MakeMaterialSignature(1), &layout) && layout);
+	CHECK(cache.getNumLayouts() == 1 && cache.getNumHits() == 0);
+
+	// Without a device nothing can be created
+	InputLayoutCache deviceCache(static_cast<ID3D11Device *>(nullptr));
+	CHECK(!deviceCache.get(MakeMaterialSignature(1), &layout));
+}
+
+}
+
+TEST_MAIN(TestSharing, TestKeys, TestFailures)
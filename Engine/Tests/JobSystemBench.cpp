@@ -0,0 +1,99 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumJobs		= 1000000;
+const uint32_t NumForkJoins	= 10000;
+const size_t NumItems		= 1 << 22;
+
+// Empty jobs queued one by one from the main thread and from a thread the system doesn't own
+double Throughput(JobSystem &jobs, bool external){
+	std::atomic<uint32_t> numRun(0);
+	Test::Clock::time_point start = Test::Clock::now();
+
+	auto submit = [&]{
+		JobSystem::Counter counter;
+
+		for(uint32_t i = 0; i < NumJobs; i++) jobs.run([&]{ numRun.fetch_add(1, std::memory_order_relaxed); }, &counter);
+
+		jobs.wait(counter);
+	};
+
+	if(external){
+		std::thread thread(submit);
+		thread.join();
+	}
+	else{
+		submit();
+	}
+
+	double ms = Test::ElapsedMs(start);
+
+	if(numRun != NumJobs) Test::g_failures++;
+
+	return NumJobs / (ms * 1000.0);
+}
+
+// One item per thread, the time for the whole system to pick up a parallelFor and come back
+double ForkJoin(JobSystem &jobs){
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumForkJoins; i++) jobs.parallelFor(jobs.getNumWorkers() + 1, 1, [](size_t, size_t){});
+
+	return Test::ElapsedMs(start) * 1000.0 / NumForkJoins;
+}
+
+// Some arithmetic per item split in 1024 item ranges, the way the culling and clustering loops use it
+double Scaling(JobSystem &jobs, std::vector<float> &items){
+	Test::Clock::time_point start = Test::Clock::now();
+
+	jobs.parallelFor(items.size(), 1024, [&](size_t begin, size_t end){
+		for(size_t i = begin; i < end; i++){
+			float x = static_cast<float>(i);
+
+			for(int step = 0; step < 16; step++) x = sqrtf(x * 1.0001f + 1.0f);
+
+			items[i] = x;
+		}
+	});
+
+	return Test::ElapsedMs(start);
+}
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	uint32_t numCores = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+	std::vector<uint32_t> workerCounts;
+	std::vector<float> items(NumItems);
+	double singleMs = 0.0;
+
+	for(uint32_t numWorkers = 1; numWorkers < numCores; numWorkers *= 2) workerCounts.push_back(numWorkers);
+
+	if(workerCounts.empty() || workerCounts.back() != std::max<uint32_t>(1, numCores - 1)) workerCounts.push_back(std::max<uint32_t>(1, numCores - 1));
+
+	std::printf("%u cores, %u empty jobs, %u fork/joins, %zu items\n", numCores, NumJobs, NumForkJoins, items.size());
+
+	for(uint32_t numWorkers : workerCounts){
+		JobSystem jobs(numWorkers);
+
+		double mainRate = Throughput(jobs, false);
+		double externalRate = Throughput(jobs, true);
+		double forkJoinUs = ForkJoin(jobs);
+
+		// Best of a few so a stray context switch doesn't count
+		double ms = DBL_MAX;
+
+		for(int round = 0; round < 5; round++) ms = std::min(ms, Scaling(jobs, items));
+
+		if(numWorkers == workerCounts.front()) singleMs = ms;
+
+		std::printf("%2u workers %6.2f M jobs/s from main, %6.2f M jobs/s external, fork/join %7.2f us, items %7.2f ms (%.2fx)\n",
+			numWorkers, mainRate, externalRate, forkJoinUs, ms, singleMs / ms);
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumWorkers = 3;
+
+size_t GetJobPoolCapacity(){
+	std::vector<AllocatorStats> stats;
+
+	TrackedAllocator::getAllStats(stats);
+
+	for(auto &allocator : stats){
+		if(allocator.name == "Jobs") return allocator.capacity;
+	}
+
+	return 0;
+}
+
+// Every index is visited exactly once whatever the grain size
+void TestParallelFor(){
+	JobSystem jobs(NumWorkers);
+	const size_t grainSizes[] = {0, 1, 7, 1000, 2000000};
+
+	for(size_t grainSize : grainSizes){
+		std::vector<int> hits(1000003, 0);
+
+		jobs.parallelFor(hits.size(), grainSize, [&](size_t begin, size_t end){
+			for(size_t i = begin; i < end; i++) hits[i]++;
+		});
+
+		CHECK(std::count(hits.begin(), hits.end(), 1) == static_cast<ptrdiff_t>(hits.size()));
+	}
+
+	bool called = false;
+
+	jobs.parallelFor(0, 1, [&](size_t, size_t){ called = true; });
+	CHECK(!called);
+}
+
+// Jobs queued from jobs count against the same counter, a dependent job waits for all of them
+void TestDependencies(){
+	JobSystem jobs(NumWorkers);
+	std::atomic<int> sum(0), seen(-1);
+	JobSystem::Counter first, second;
+
+	for(int i = 0; i < 1000; i++){
+		jobs.run([&]{
+			sum++;
+			jobs.run([&]{ sum++; }, &first);
+		}, &first);
+	}
+
+	jobs.run([&]{ seen = sum.load(); }, &second, &first);
+	jobs.wait(second);
+
+	CHECK(first.isDone() && seen == 2000);
+}
+
+// Workers can hand work to the main thread and wait() on the main thread runs it
+void TestMainThreadJobs(){
+	JobSystem jobs(NumWorkers);
+	std::atomic<int> numOnMain(0), numElsewhere(0);
+	JobSystem::Counter counter;
+
+	CHECK(jobs.isMainThread());
+
+	for(int i = 0; i < 100; i++){
+		jobs.run([&]{
+			jobs.runOnMainThread([&]{
+				if(jobs.isMainThread()) numOnMain++;
+				else numElsewhere++;
+			}, &counter);
+		}, &counter);
+	}
+
+	jobs.wait(counter);
+
+	CHECK(numOnMain == 100 && numElsewhere == 0);
+}
+
+// Threads the system didn't create queue through the inbox and can wait like any other
+void TestExternalThreads(){
+	JobSystem jobs(NumWorkers);
+	std::atomic<int> numRun(0);
+	std::vector<std::thread> threads;
+
+	for(int t = 0; t < 4; t++){
+		threads.push_back(std::thread([&]{
+			JobSystem::Counter counter;
+
+			CHECK(!jobs.isMainThread());
+
+			for(int i = 0; i < 1000; i++){
+				jobs.run([&, i]{
+					numRun++;
+
+					// Nested jobs from a worker go to its deque, from an external thread back to the inbox
+					if(i % 10 == 0) jobs.run([&]{ numRun++; }, &counter);
+				}, &counter);
+			}
+
+			jobs.wait(counter);
+		}));
+	}
+
+	for(auto &thread : threads) thread.join();
+
+	CHECK(numRun == 4 * 1100);
+}
+
+// Small callables live in the job, big ones on the heap, either way they're destroyed once they ran
+void TestCallables(){
+	JobSystem jobs(NumWorkers);
+	JobSystem::Counter counter;
+	std::shared_ptr<int> shared = std::make_shared<int>(0);
+	std::atomic<int> sum(0);
+
+	uint8_t big[256];
+
+	for(size_t i = 0; i < sizeof(big); i++) big[i] = static_cast<uint8_t>(i);
+
+	for(int i = 0; i < 100; i++){
+		jobs.run([shared, &sum]{ sum += 1; }, &counter);
+
+		jobs.run([big, shared, &sum]{
+			int total = 0;
+
+			for(uint8_t value : big) total += value;
+
+			sum += total;
+		}, &counter);
+	}
+
+	JobSystem::JobFunc func = [&sum]{ sum += 1000000; };
+
+	jobs.run(func, &counter);
+	jobs.wait(counter);
+
+	CHECK(sum == 100 + 100 * 255 * 128 + 1000000);
+	CHECK(shared.use_count() == 1);
+}
+
+// Jobs are recycled, the pool only holds what was in flight at once plus what the thread caches keep
+void TestJobPool(){
+	const uint32_t NumJobs = 2000;
+
+	JobSystem jobs(NumWorkers);
+
+	for(int round = 0; round < 50; round++){
+		JobSystem::Counter counter;
+		std::atomic<uint32_t> numRun(0);
+
+		for(uint32_t i = 0; i < NumJobs; i++) jobs.run([&]{ numRun++; }, &counter);
+
+		jobs.wait(counter);
+
+		CHECK(numRun == NumJobs);
+	}
+
+	// Each cache holds under two batches, the pool grows by pages of four
+	size_t maxJobs = NumJobs + (NumWorkers + 1) * 2 * 64 + 4 * 64;
+
+	CHECK(GetJobPoolCapacity() > 0 && GetJobPoolCapacity() <= maxJobs * sizeof(JobSystem::Job));
+}
+
+}
+
+TEST_MAIN(TestParallelFor, TestDependencies, TestMainThreadJobs, TestExternalThreads, TestCallables, TestJobPool)
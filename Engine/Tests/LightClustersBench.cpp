@@ -0,0 +1,94 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumPointLights	= 10000;
+const uint32_t NumSpotLights	= 1000;
+const uint32_t NumFrames		= 100;
+const uint32_t IndexCapacity	= 4 * 1024 * 1024;
+
+// Lights through a 500 x 125 x 500 volume around the camera
+void MakeLights(Test::Random &random, std::vector<PointLight> &points, std::vector<SpotLight> &spots){
+	points.resize(NumPointLights);
+	spots.resize(NumSpotLights);
+
+	for(auto &light : points){
+		light.position	= DirectX::XMFLOAT3(random.range(-250.0f, 250.0f), random.range(-62.5f, 62.5f), random.range(-250.0f, 250.0f));
+		light.radius	= random.range(2.0f, 20.0f);
+		light.color		= DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+		light.padding	= 0.0f;
+	}
+
+	for(auto &light : spots){
+		float angle = random.range(0.1f, 1.2f);
+
+		light.position	= DirectX::XMFLOAT3(random.range(-250.0f, 250.0f), random.range(-62.5f, 62.5f), random.range(-250.0f, 250.0f));
+		light.direction	= DirectX::XMFLOAT3(0.0f, -1.0f, 0.0f);
+		light.radius	= random.range(4.0f, 40.0f);
+		light.cosAngle	= cosf(angle);
+		light.sinAngle	= sinf(angle);
+		light.color		= DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+	}
+}
+
+// The camera at the center of the lights turning a full circle over the frames, looking slightly down
+LightBinView MakeView(uint32_t frame){
+	float angle = 2.0f * DirectX::XM_PI * frame / NumFrames;
+	Camera camera;
+
+	camera.setPos(DirectX::XMFLOAT3(0.0f, 10.0f, 0.0f));
+	camera.setTarget(DirectX::XMFLOAT3(cosf(angle), -0.1f, sinf(angle)));
+	camera.setProperties(16.0f, 9.0f, 0.1f, 1000.0f);
+
+	return GetLightBinView(camera);
+}
+
+}
+
+int Test::g_failures = 0;
+
+// Assigns 10k point lights and 1k spot lights to the froxel grid every frame with the camera turning, on the
+// calling thread and spread over the job system's workers, in ms per frame
+int main(){
+	Test::Random random(1);
+	std::vector<PointLight> points;
+	std::vector<SpotLight> spots;
+
+	MakeLights(random, points, spots);
+
+	JobSystem jobs;
+	LightClusterer serial(nullptr, IndexCapacity), parallel(&jobs, IndexCapacity);
+	double serialMs = 0.0, parallelMs = 0.0;
+	uint32_t numMismatches = 0;
+
+	for(uint32_t frame = 0; frame < NumFrames; frame++){
+		LightBinView view = MakeView(frame);
+		Test::Clock::time_point start = Test::Clock::now();
+
+		serial.assign(view, points.data(), NumPointLights, spots.data(), NumSpotLights);
+		serialMs += Test::ElapsedMs(start);
+
+		start = Test::Clock::now();
+
+		parallel.assign(view, points.data(), NumPointLights, spots.data(), NumSpotLights);
+		parallelMs += Test::ElapsedMs(start);
+
+		// Both build the same lists
+		const LightCluster *a = serial.getClusters(), *b = parallel.getClusters();
+
+		numMismatches += serial.getNumIndices() != parallel.getNumIndices() ||
+			memcmp(serial.getIndices(), parallel.getIndices(), serial.getNumIndices() * sizeof(uint32_t)) != 0 ||
+			memcmp(a, b, LightClusterer::NumClusters * sizeof(LightCluster)) != 0;
+	}
+
+	if(numMismatches) Test::g_failures++;
+
+	std::printf("%u point and %u spot lights, %u clusters, %u workers\n", NumPointLights, NumSpotLights, LightClusterer::NumClusters,
+		jobs.getNumWorkers());
+	std::printf("Serial       %8.3f ms/frame\n", serialMs / NumFrames);
+	std::printf("Job system   %8.3f ms/frame\n", parallelMs / NumFrames);
+	std::printf("%s", serial.formatStats().c_str());
+
+	return Test::g_failures ? 1 : 0;
+}
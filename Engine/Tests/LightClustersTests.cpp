@@ -0,0 +1,329 @@
+#include "Engine.h"
+#include "Test.h"
+
+using namespace DirectX;
+
+namespace{
+
+typedef std::vector<std::vector<uint32_t>> ClusterLists;
+
+XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b){
+	return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b){
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+XMFLOAT3 Normalize(const XMFLOAT3 &v){
+	float scale = 1.0f / sqrtf(Dot(v, v));
+
+	return XMFLOAT3(v.x * scale, v.y * scale, v.z * scale);
+}
+
+// A view from eye along direction with a 45 degree vertical field of view, row-major like the camera's
+LightBinView MakeView(const XMFLOAT3 &eye, const XMFLOAT3 &direction, float aspect){
+	XMFLOAT3 z = Normalize(direction);
+	XMFLOAT3 x = Normalize(Cross(XMFLOAT3(0.0f, 1.0f, 0.0f), z));
+	XMFLOAT3 y = Cross(z, x);
+
+	LightBinView view;
+	XMFLOAT4X4 &m = view.view;
+
+	m._11 = x.x;	m._12 = y.x;	m._13 = z.x;	m._14 = 0.0f;
+	m._21 = x.y;	m._22 = y.y;	m._23 = z.y;	m._24 = 0.0f;
+	m._31 = x.z;	m._32 = y.z;	m._33 = z.z;	m._34 = 0.0f;
+	m._41 = -Dot(x, eye);
+	m._42 = -Dot(y, eye);
+	m._43 = -Dot(z, eye);
+	m._44 = 1.0f;
+
+	view.projScaleY	= 1.0f / tanf(XM_PI / 8.0f);
+	view.projScaleX	= view.projScaleY / aspect;
+	view.nearPlane	= 0.1f;
+	view.farPlane	= 1000.0f;
+
+	return view;
+}
+
+// A light in view space, points leave the cone zeroed
+struct ViewLight{
+	XMFLOAT3 position;
+	float radius;
+	XMFLOAT3 direction;
+	float cosAngle, sinAngle;
+};
+
+// Summed in the same order as the clusterer so both round the same way
+ViewLight ToView(const LightBinView &view, const XMFLOAT3 &p, float radius, const SpotLight *spot){
+	const XMFLOAT4X4 &m = view.view;
+	ViewLight light;
+
+	light.position.x	= (p.x * m._11 + p.y * m._21) + (p.z * m._31 + m._41);
+	light.position.y	= (p.x * m._12 + p.y * m._22) + (p.z * m._32 + m._42);
+	light.position.z	= (p.x * m._13 + p.y * m._23) + (p.z * m._33 + m._43);
+	light.radius		= radius;
+	light.direction		= XMFLOAT3(0.0f, 0.0f, 0.0f);
+	light.cosAngle		= 0.0f;
+	light.sinAngle		= 0.0f;
+
+	if(spot){
+		const XMFLOAT3 &d = spot->direction;
+
+		light.direction.x	= (d.x * m._11 + d.y * m._21) + d.z * m._31;
+		light.direction.y	= (d.x * m._12 + d.y * m._22) + d.z * m._32;
+		light.direction.z	= (d.x * m._13 + d.y * m._23) + d.z * m._33;
+		light.cosAngle		= spot->cosAngle;
+		light.sinAngle		= spot->sinAngle;
+	}
+
+	return light;
+}
+
+// The light's sphere against the box, and for spot lights the cone against the box's bounding sphere
+bool Touches(const ViewLight &light, const XMFLOAT3 &min, const XMFLOAT3 &max, bool spot){
+	const XMFLOAT3 &p = light.position;
+	float dx = std::max(0.0f, std::max(min.x - p.x, p.x - max.x));
+	float dy = std::max(0.0f, std::max(min.y - p.y, p.y - max.y));
+	float dz = std::max(0.0f, std::max(min.z - p.z, p.z - max.z));
+
+	if(!(dx * dx + (dy * dy + dz * dz) <= light.radius * light.radius)) return false;
+	if(!spot) return true;
+
+	float halfX = (max.x - min.x) * 0.5f, toX = (min.x + max.x) * 0.5f - p.x;
+	float halfY = 0.5f * (max.y - min.y), toY = 0.5f * (min.y + max.y) - p.y;
+	float halfZ = 0.5f * (max.z - min.z), toZ = 0.5f * (min.z + max.z) - p.z;
+	float boxRadius = sqrtf(halfX * halfX + (halfY * halfY + halfZ * halfZ));
+
+	float lengthSq	= toX * toX + (toY * toY + toZ * toZ);
+	float along		= toX * light.direction.x + (toY * light.direction.y + toZ * light.direction.z);
+	float across	= sqrtf(std::max(lengthSq - along * along, 0.0f));
+	float closest	= light.cosAngle * across - along * light.sinAngle;
+
+	return closest <= boxRadius && along <= boxRadius + light.radius && along >= 0.0f - boxRadius;
+}
+
+// Inside or touching the four side planes of the frustum
+bool InFrustum(const LightBinView &view, const ViewLight &light){
+	float slopeX = 1.0f / view.projScaleX, slopeY = 1.0f / view.projScaleY;
+	float scaleX = 1.0f / sqrtf(1.0f + slopeX * slopeX), scaleY = 1.0f / sqrtf(1.0f + slopeY * slopeY);
+	float outside = 0.0f - light.radius;
+	const XMFLOAT3 &p = light.position;
+
+	return (p.x + slopeX * p.z) * scaleX >= outside && (slopeX * p.z - p.x) * scaleX >= outside &&
+		(p.y + slopeY * p.z) * scaleY >= outside && (slopeY * p.z - p.y) * scaleY >= outside;
+}
+
+// Every light against every cluster's box one at a time, in light order
+void BruteForce(const LightClusterer &clusterer, const LightBinView &view, const std::vector<PointLight> &points,
+	const std::vector<SpotLight> &spots, ClusterLists &pointLists, ClusterLists &spotLists){
+
+	const uint32_t NumClusters = LightClusterer::NumClusters;
+	std::vector<XMFLOAT3> min(NumClusters), max(NumClusters);
+
+	pointLists.assign(NumClusters, std::vector<uint32_t>());
+	spotLists.assign(NumClusters, std::vector<uint32_t>());
+
+	for(uint32_t cluster = 0; cluster < NumClusters; cluster++) clusterer.getClusterBounds(cluster, min[cluster], max[cluster]);
+
+	for(uint32_t i = 0; i < points.size(); i++){
+		ViewLight light = ToView(view, points[i].position, points[i].radius, nullptr);
+
+		if(!InFrustum(view, light)) continue;
+
+		for(uint32_t cluster = 0; cluster < NumClusters; cluster++){
+			if(Touches(light, min[cluster], max[cluster], false)) pointLists[cluster].push_back(i);
+		}
+	}
+
+	for(uint32_t i = 0; i < spots.size(); i++){
+		ViewLight light = ToView(view, spots[i].position, spots[i].radius, &spots[i]);
+
+		if(!InFrustum(view, light)) continue;
+
+		for(uint32_t cluster = 0; cluster < NumClusters; cluster++){
+			if(Touches(light, min[cluster], max[cluster], true)) spotLists[cluster].push_back(i);
+		}
+	}
+}
+
+void MakeLights(Test::Random &random, uint32_t numPoints, uint32_t numSpots, float extent, float minRadius, float maxRadius,
+	std::vector<PointLight> &points, std::vector<SpotLight> &spots){
+
+	points.resize(numPoints);
+	spots.resize(numSpots);
+
+	for(auto &light : points){
+		light.position	= XMFLOAT3(random.range(-extent, extent), random.range(-extent * 0.25f, extent * 0.25f), random.range(-extent, extent));
+		light.radius	= random.range(minRadius, maxRadius);
+		light.color		= XMFLOAT3(1.0f, 1.0f, 1.0f);
+		light.padding	= 0.0f;
+	}
+
+	// Cones from narrow to just under 70 degrees
+	for(auto &light : spots){
+		float angle = random.range(0.1f, 1.2f);
+
+		light.position	= XMFLOAT3(random.range(-extent, extent), random.range(-extent * 0.25f, extent * 0.25f), random.range(-extent, extent));
+		light.direction	= Normalize(XMFLOAT3(random.range(-1.0f, 1.0f), random.range(-1.0f, 1.0f), random.range(-1.0f, 1.0f)));
+		light.radius	= random.range(minRadius, maxRadius) * 2.0f;
+		light.cosAngle	= cosf(angle);
+		light.sinAngle	= sinf(angle);
+		light.color		= XMFLOAT3(1.0f, 1.0f, 1.0f);
+	}
+}
+
+// Clusters that don't hold exactly the brute force lists, capped lists keep the lights that come first
+uint32_t CountMismatches(const LightClusterer &clusterer, const ClusterLists &pointLists, const ClusterLists &spotLists){
+	const LightCluster *clusters = clusterer.getClusters();
+	const uint32_t *indices = clusterer.getIndices();
+	uint32_t numMismatches = 0;
+
+	for(uint32_t i = 0; i < LightClusterer::NumClusters; i++){
+		const LightCluster &cluster = clusters[i];
+		uint32_t numPoints = std::min<uint32_t>(static_cast<uint32_t>(pointLists[i].size()), LightClusterer::MaxLightsPerCluster);
+		uint32_t numSpots = std::min<uint32_t>(static_cast<uint32_t>(spotLists[i].size()), LightClusterer::MaxLightsPerCluster);
+		bool same = cluster.numPointLights == numPoints && cluster.numSpotLights == numSpots;
+
+		for(uint32_t j = 0; same && j < numPoints; j++) same = indices[cluster.offset + j] == pointLists[i][j];
+		for(uint32_t j = 0; same && j < numSpots; j++) same = indices[cluster.offset + numPoints + j] == spotLists[i][j];
+
+		numMismatches += !same;
+	}
+
+	return numMismatches;
+}
+
+bool Listed(const uint32_t *indices, uint32_t count, uint32_t light){
+	return std::find(indices, indices + count, light) != indices + count;
+}
+
+// Random points in the frustum looked up the way the material shader does, every light reaching a point has to
+// be in its cluster unless the cluster is full. Points right on a slice boundary can round into either slice
+uint32_t CountMissedPoints(Test::Random &random, const LightClusterer &clusterer, const LightBinView &view, const std::vector<PointLight> &points,
+	const std::vector<SpotLight> &spots, uint32_t numSamples){
+
+	const LightCluster *clusters = clusterer.getClusters();
+	const uint32_t *indices = clusterer.getIndices();
+	XMFLOAT2 sliceParams = clusterer.getSliceParams();
+	std::vector<ViewLight> viewPoints, viewSpots;
+	uint32_t numMissed = 0;
+
+	for(auto &light : points) viewPoints.push_back(ToView(view, light.position, light.radius, nullptr));
+	for(auto &light : spots) viewSpots.push_back(ToView(view, light.position, light.radius, &light));
+
+	for(uint32_t sample = 0; sample < numSamples; sample++){
+		float u = random.range(0.0f, 1.0f), v = random.range(0.0f, 1.0f);
+		float z = view.nearPlane * powf(view.farPlane / view.nearPlane, random.range(0.0f, 1.0f));
+		float slicePosition = logf(z) * sliceParams.x + sliceParams.y;
+
+		if(fabsf(slicePosition - roundf(slicePosition)) < 1e-3f) continue;
+
+		uint32_t slice	= std::min(static_cast<uint32_t>(std::max(slicePosition, 0.0f)), LightClusterer::NumSlices - 1);
+		uint32_t column	= std::min(static_cast<uint32_t>(u * LightClusterer::NumColumns), LightClusterer::NumColumns - 1);
+		uint32_t row	= std::min(static_cast<uint32_t>(v * LightClusterer::NumRows), LightClusterer::NumRows - 1);
+
+		XMFLOAT3 position((2.0f * u - 1.0f) / view.projScaleX * z, (1.0f - 2.0f * v) / view.projScaleY * z, z);
+		const LightCluster &cluster = clusters[LightClusterer::GetClusterIndex(column, row, slice)];
+		const uint32_t *pointIndices = indices + cluster.offset;
+		const uint32_t *spotIndices = pointIndices + cluster.numPointLights;
+
+		for(uint32_t i = 0; i < viewPoints.size(); i++){
+			const ViewLight &light = viewPoints[i];
+			XMFLOAT3 offset(position.x - light.position.x, position.y - light.position.y, position.z - light.position.z);
+
+			if(Dot(offset, offset) > light.radius * light.radius * 0.999f) continue;
+
+			numMissed += !Listed(pointIndices, cluster.numPointLights, i) && cluster.numPointLights < LightClusterer::MaxLightsPerCluster;
+		}
+
+		for(uint32_t i = 0; i < viewSpots.size(); i++){
+			const ViewLight &light = viewSpots[i];
+			XMFLOAT3 offset(position.x - light.position.x, position.y - light.position.y, position.z - light.position.z);
+			float distance = sqrtf(Dot(offset, offset));
+
+			if(distance > light.radius * 0.999f || Dot(offset, light.direction) < distance * light.cosAngle + 1e-3f) continue;
+
+			numMissed += !Listed(spotIndices, cluster.numSpotLights, i) && cluster.numSpotLights < LightClusterer::MaxLightsPerCluster;
+		}
+	}
+
+	return numMissed;
+}
+
+// Light counts, sizes and views from a few small lights near the camera to clusters that fill up, assigned
+// serially and on the job system
+void TestAssign(){
+	struct Case{
+		uint32_t numPoints, numSpots;
+		float extent, minRadius, maxRadius;
+		XMFLOAT3 eye, direction;
+	};
+
+	Case cases[] = {
+		{500, 200, 60.0f, 0.5f, 8.0f, XMFLOAT3(0.0f, 2.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)},
+		{2000, 500, 200.0f, 1.0f, 30.0f, XMFLOAT3(5.0f, 10.0f, -3.0f), XMFLOAT3(0.3f, -0.2f, 1.0f)},
+		{300, 300, 20.0f, 2.0f, 25.0f, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 0.5f, 0.2f)},
+		{100, 100, 5.0f, 0.01f, 0.5f, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)},
+		{4000, 1000, 30.0f, 5.0f, 40.0f, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, -1.0f)}
+	};
+
+	JobSystem jobs;
+	Test::Random random(1);
+
+	for(auto &test : cases){
+		std::vector<PointLight> points;
+		std::vector<SpotLight> spots;
+
+		MakeLights(random, test.numPoints, test.numSpots, test.extent, test.minRadius, test.maxRadius, points, spots);
+
+		LightBinView view = MakeView(test.eye, test.direction, 800.0f / 600.0f);
+
+		for(uint32_t useJobs = 0; useJobs < 2; useJobs++){
+			LightClusterer clusterer(useJobs ? &jobs : nullptr, 1 << 20);
+			ClusterLists pointLists, spotLists;
+
+			clusterer.assign(view, points.data(), test.numPoints, spots.data(), test.numSpots);
+			BruteForce(clusterer, view, points, spots, pointLists, spotLists);
+
+			CHECK(CountMismatches(clusterer, pointLists, spotLists) == 0);
+			CHECK(CountMissedPoints(random, clusterer, view, points, spots, 20000) == 0);
+			CHECK(clusterer.getStats().numIndices == clusterer.getNumIndices() && clusterer.getStats().numOccupied > 0);
+		}
+	}
+}
+
+// A small index list keeps the lights of the clusters that come first, the lists stay back to back
+void TestCapacity(){
+	JobSystem jobs;
+	Test::Random random(2);
+	std::vector<PointLight> points;
+	std::vector<SpotLight> spots;
+
+	MakeLights(random, 3000, 500, 30.0f, 5.0f, 40.0f, points, spots);
+
+	LightBinView view = MakeView(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), 800.0f / 600.0f);
+	LightClusterer clusterer(&jobs, 5000);
+
+	clusterer.assign(view, points.data(), 3000, spots.data(), 500);
+
+	const LightCluster *clusters = clusterer.getClusters();
+	uint32_t offset = 0;
+
+	for(uint32_t i = 0; i < LightClusterer::NumClusters; i++){
+		CHECK(clusters[i].offset == offset);
+		offset += clusters[i].numPointLights + clusters[i].numSpotLights;
+	}
+
+	CHECK(offset == clusterer.getNumIndices() && offset <= 5000);
+	CHECK(clusterer.getStats().numDropped > 0);
+
+	// No lights leaves every cluster empty
+	clusterer.assign(view, nullptr, 0, nullptr, 0);
+
+	CHECK(clusterer.getNumIndices() == 0 && clusterer.getStats().numOccupied == 0);
+}
+
+}
+
+TEST_MAIN(TestAssign, TestCapacity)
@@ -0,0 +1,106 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t Width	= 1920;
+const uint32_t Height	= 1080;
+
+// Lights scattered through a 200 x 30 x 200 scene
+std::vector<PointLight> MakeLights(Test::Random &random, uint32_t numLights){
+	std::vector<PointLight> lights(numLights);
+
+	for(auto &light : lights){
+		light.position	= DirectX::XMFLOAT3(random.range(-100.0f, 100.0f), random.range(0.0f, 30.0f), random.range(-100.0f, 100.0f));
+		light.radius	= random.range(1.0f, 8.0f);
+		light.color		= DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+		light.padding	= 0.0f;
+	}
+
+	return lights;
+}
+
+// One light at a time against every tile it could touch, the way the compute shader's threads test them
+uint32_t BruteForce(const LightBinView &view, const std::vector<PointLight> &lights){
+	const DirectX::XMFLOAT4X4 &m = view.view;
+	uint32_t tilesX = (Width + LightBinner::TileSize - 1) / LightBinner::TileSize;
+	uint32_t tilesY = (Height + LightBinner::TileSize - 1) / LightBinner::TileSize;
+	uint32_t numIndices = 0;
+
+	for(auto &light : lights){
+		const DirectX::XMFLOAT3 &p = light.position;
+		float x = p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41;
+		float y = p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42;
+		float z = p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43;
+
+		if(z + light.radius < view.nearPlane || z - light.radius > view.farPlane) continue;
+
+		for(uint32_t tileY = 0; tileY < tilesY; tileY++){
+			float top		= (1.0f - 2.0f * (tileY * LightBinner::TileSize) / Height) / view.projScaleY;
+			float bottom	= (1.0f - 2.0f * std::min((tileY + 1) * LightBinner::TileSize, Height) / Height) / view.projScaleY;
+
+			if((y - bottom * z) / sqrtf(1.0f + bottom * bottom) < -light.radius || (y - top * z) / sqrtf(1.0f + top * top) > light.radius) continue;
+
+			for(uint32_t tileX = 0; tileX < tilesX; tileX++){
+				float left	= (2.0f * (tileX * LightBinner::TileSize) / Width - 1.0f) / view.projScaleX;
+				float right	= (2.0f * std::min((tileX + 1) * LightBinner::TileSize, Width) / Width - 1.0f) / view.projScaleX;
+
+				if((x - left * z) / sqrtf(1.0f + left * left) < -light.radius || (x - right * z) / sqrtf(1.0f + right * right) > light.radius) continue;
+
+				numIndices++;
+			}
+		}
+	}
+
+	return numIndices;
+}
+
+}
+
+int Test::g_failures = 0;
+
+// Bins 1k to 64k lights into 16x16 tiles at 1080p from a camera at one side of the scene, against testing
+// every light against every tile
+int main(){
+	Test::Random random(42);
+	Camera camera;
+
+	camera.setPos(DirectX::XMFLOAT3(0.0f, 15.0f, -120.0f));
+	camera.setProperties(static_cast<float>(Width), static_cast<float>(Height), 0.1f, 1000.0f);
+
+	LightBinView view = GetLightBinView(camera);
+	LightBinner binner(Width, Height, 8 * 1024 * 1024);
+
+	uint32_t counts[] = {1024, 4096, 16384, 65536};
+
+	for(uint32_t numLights : counts){
+		std::vector<PointLight> lights = MakeLights(random, numLights);
+		uint32_t numIterations = numLights <= 4096 ? 200 : 40;
+
+		// Once to size the lists
+		binner.bin(view, lights.data(), numLights);
+
+		Test::Clock::time_point start = Test::Clock::now();
+
+		for(uint32_t i = 0; i < numIterations; i++) binner.bin(view, lights.data(), numLights);
+
+		double binMs = Test::ElapsedMs(start) / numIterations;
+
+		start = Test::Clock::now();
+
+		uint32_t numBruteIndices = BruteForce(view, lights);
+		double bruteMs = Test::ElapsedMs(start);
+
+		const LightBinStats &stats = binner.getStats();
+
+		// Both count the same tiles up to rounding at the edges
+		if(stats.numDropped == 0 && std::abs(static_cast<int32_t>(numBruteIndices - stats.numIndices)) > static_cast<int32_t>(stats.numIndices / 1000)){
+			Test::g_failures++;
+		}
+
+		std::printf("%6u lights: %8.3f ms binned, %9.2f ms brute force, %5u visible, %8u indices, %4u most in a tile, %u dropped\n",
+			numLights, binMs, bruteMs, stats.numVisible, stats.numIndices, stats.maxTileLights, stats.numDropped);
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+#include "Engine.h"
+#include "Test.h"
+
+#include <set>
+
+using namespace DirectX;
+
+namespace{
+
+XMFLOAT3 Cross(const XMFLOAT3 &a, const XMFLOAT3 &b){
+	return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+float Dot(const XMFLOAT3 &a, const XMFLOAT3 &b){
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+XMFLOAT3 Normalize(const XMFLOAT3 &v){
+	float scale = 1.0f / sqrtf(Dot(v, v));
+
+	return XMFLOAT3(v.x * scale, v.y * scale, v.z * scale);
+}
+
+// A view from eye along direction with a 45 degree vertical field of view, row-major like the camera's
+LightBinView MakeView(const XMFLOAT3 &eye, const XMFLOAT3 &direction, uint32_t width, uint32_t height){
+	XMFLOAT3 z = Normalize(direction);
+	XMFLOAT3 x = Normalize(Cross(XMFLOAT3(0.0f, 1.0f, 0.0f), z));
+	XMFLOAT3 y = Cross(z, x);
+
+	LightBinView view;
+	XMFLOAT4X4 &m = view.view;
+
+	m._11 = x.x;	m._12 = y.x;	m._13 = z.x;	m._14 = 0.0f;
+	m._21 = x.y;	m._22 = y.y;	m._23 = z.y;	m._24 = 0.0f;
+	m._31 = x.z;	m._32 = y.z;	m._33 = z.z;	m._34 = 0.0f;
+	m._41 = -Dot(x, eye);
+	m._42 = -Dot(y, eye);
+	m._43 = -Dot(z, eye);
+	m._44 = 1.0f;
+
+	view.projScaleY	= 1.0f / tanf(XM_PI / 8.0f);
+	view.projScaleX	= view.projScaleY * height / width;
+	view.nearPlane	= 0.1f;
+	view.farPlane	= 1000.0f;
+
+	return view;
+}
+
+XMFLOAT3 ToView(const LightBinView &view, const XMFLOAT3 &p){
+	const XMFLOAT4X4 &m = view.view;
+
+	return XMFLOAT3(p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41, p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+		p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43);
+}
+
+// Signed distance from the plane through the eye at the given slope, positive past it
+float Edge(float position, float z, float slope){
+	return (position - slope * z) / sqrtf(1.0f + slope * slope);
+}
+
+// How far a light is inside each edge of a tile, negative when it's past one
+void TileMargins(const LightBinView &view, uint32_t width, uint32_t height, const XMFLOAT3 &center, float radius, uint32_t tileX,
+	uint32_t tileY, float margins[4]){
+
+	const uint32_t TileSize = LightBinner::TileSize;
+
+	float left		= (2.0f * (tileX * TileSize) / width - 1.0f) / view.projScaleX;
+	float right		= (2.0f * std::min((tileX + 1) * TileSize, width) / width - 1.0f) / view.projScaleX;
+	float top		= (1.0f - 2.0f * (tileY * TileSize) / height) / view.projScaleY;
+	float bottom	= (1.0f - 2.0f * std::min((tileY + 1) * TileSize, height) / height) / view.projScaleY;
+
+	margins[0] = Edge(center.x, center.z, left) + radius;
+	margins[1] = radius - Edge(center.x, center.z, right);
+	margins[2] = Edge(center.y, center.z, bottom) + radius;
+	margins[3] = radius - Edge(center.y, center.z, top);
+}
+
+// Every light against every tile one at a time, the test the binner has to agree with
+std::vector<std::vector<uint32_t>> BruteForce(const LightBinView &view, uint32_t width, uint32_t height, const std::vector<PointLight> &lights){
+	uint32_t tilesX = (width + LightBinner::TileSize - 1) / LightBinner::TileSize;
+	uint32_t tilesY = (height + LightBinner::TileSize - 1) / LightBinner::TileSize;
+	std::vector<std::vector<uint32_t>> tiles(tilesX * tilesY);
+
+	for(uint32_t i = 0; i < lights.size(); i++){
+		XMFLOAT3 center = ToView(view, lights[i].position);
+		float radius = lights[i].radius;
+
+		if(center.z + radius < view.nearPlane || center.z - radius > view.farPlane) continue;
+
+		for(uint32_t tileY = 0; tileY < tilesY; tileY++){
+			for(uint32_t tileX = 0; tileX < tilesX; tileX++){
+				float margins[4];
+
+				TileMargins(view, width, height, center, radius, tileX, tileY, margins);
+
+				if(margins[0] >= 0.0f && margins[1] >= 0.0f && margins[2] >= 0.0f && margins[3] >= 0.0f){
+					tiles[tileY * tilesX + tileX].push_back(i);
+				}
+			}
+		}
+	}
+
+	return tiles;
+}
+
+// Lights this close to a tile edge can land either side of it with rounding
+bool NearEdge(const LightBinView &view, uint32_t width, uint32_t height, const PointLight &light, uint32_t tileX, uint32_t tileY){
+	XMFLOAT3 center = ToView(view, light.position);
+	float tolerance = 1e-3f * std::max(1.0f, fabsf(center.z) + light.radius);
+	float margins[4];
+
+	TileMargins(view, width, height, center, light.radius, tileX, tileY, margins);
+
+	for(uint32_t i = 0; i < 4; i++){
+		if(fabsf(margins[i]) < tolerance) return true;
+	}
+
+	return false;
+}
+
+// Lights scattered through a 200 x 30 x 200 scene, or crowded around the eye so some reach behind it
+std::vector<PointLight> MakeLights(Test::Random &random, uint32_t numLights, bool aroundEye){
+	std::vector<PointLight> lights(numLights);
+
+	for(auto &light : lights){
+		if(aroundEye){
+			light.position = XMFLOAT3(random.range(-6.0f, 6.0f), 10.0f + random.range(-6.0f, 6.0f), -60.0f + random.range(-6.0f, 6.0f));
+		}
+		else{
+			light.position = XMFLOAT3(random.range(-100.0f, 100.0f), random.range(0.0f, 30.0f), random.range(-100.0f, 100.0f));
+		}
+
+		light.radius	= random.range(1.0f, 8.0f);
+		light.color		= XMFLOAT3(1.0f, 1.0f, 1.0f);
+		light.padding	= 0.0f;
+	}
+
+	return lights;
+}
+
+// The binner's lists hold the same lights as the brute force test, in light order and back to back. Spheres
+// reaching behind the eye may be binned into the tiles between their two runs as well
+void Validate(uint32_t width, uint32_t height, uint32_t numLights, uint32_t seed, bool aroundEye){
+	Test::Random random(seed);
+	XMFLOAT3 direction(random.range(-1.0f, 1.0f), random.range(-0.5f, 0.5f), 1.0f);
+	LightBinView view = MakeView(XMFLOAT3(0.0f, 10.0f, -60.0f), direction, width, height);
+	std::vector<PointLight> lights = MakeLights(random, numLights, aroundEye);
+
+	LightBinner binner(width, height, 16 * 1024 * 1024);
+
+	binner.bin(view, lights.data(), numLights);
+
+	std::vector<std::vector<uint32_t>> expected = BruteForce(view, width, height, lights);
+	const LightTile *tiles = binner.getTiles();
+	const uint32_t *indices = binner.getIndices();
+	uint32_t tilesX = binner.getNumTilesX(), offset = 0;
+
+	CHECK(tilesX * binner.getNumTilesY() == expected.size());
+	CHECK(binner.getStats().numDropped == 0);
+
+	for(uint32_t tile = 0; tile < expected.size(); tile++){
+		const uint32_t *begin = indices + tiles[tile].offset;
+		const uint32_t *end = begin + tiles[tile].count;
+		std::set<uint32_t> binned(begin, end), wanted(expected[tile].begin(), expected[tile].end());
+
+		CHECK(tiles[tile].offset == offset);
+		CHECK(std::is_sorted(begin, end) && binned.size() == tiles[tile].count);
+
+		offset += tiles[tile].count;
+
+		for(uint32_t light : wanted){
+			CHECK(binned.count(light) || NearEdge(view, width, height, lights[light], tile % tilesX, tile / tilesX));
+		}
+
+		for(uint32_t light : binned){
+			bool behindEye = ToView(view, lights[light].position).z <= lights[light].radius;
+
+			CHECK(wanted.count(light) || behindEye || NearEdge(view, width, height, lights[light], tile % tilesX, tile / tilesX));
+		}
+	}
+
+	CHECK(offset == binner.getNumIndices() && binner.getStats().numIndices == offset);
+}
+
+void TestFullHD(){
+	for(uint32_t seed = 1; seed <= 6; seed++) Validate(1920, 1080, 4096, seed, false);
+}
+
+// The last row and column of tiles are partial
+void TestOddSize(){
+	for(uint32_t seed = 1; seed <= 3; seed++) Validate(803, 611, 2000, seed, false);
+}
+
+void TestAroundEye(){
+	for(uint32_t seed = 1; seed <= 3; seed++) Validate(1920, 1080, 600, seed, true);
+}
+
+// Tiles keep their lights up to the limit and the index list stops at its capacity, the rest are counted
+void TestLimits(){
+	Test::Random random(7);
+	LightBinView view = MakeView(XMFLOAT3(0.0f, 10.0f, -60.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), 1920, 1080);
+	std::vector<PointLight> lights = MakeLights(random, 8192, true);
+
+	for(auto &light : lights) light.radius = 20.0f;
+
+	LightBinner binner(1920, 1080, 100000);
+
+	binner.bin(view, lights.data(), static_cast<uint32_t>(lights.size()));
+
+	uint32_t numIndices = 0;
+
+	for(uint32_t tile = 0; tile < binner.getNumTilesX() * binner.getNumTilesY(); tile++){
+		CHECK(binner.getTiles()[tile].count <= LightBinner::MaxLightsPerTile);
+		numIndices += binner.getTiles()[tile].count;
+	}
+
+	CHECK(numIndices == binner.getNumIndices() && numIndices <= 100000);
+	CHECK(binner.getStats().numDropped > 0 && binner.getStats().maxTileLights > LightBinner::MaxLightsPerTile);
+
+	// No lights leaves every tile empty
+	binner.bin(view, nullptr, 0);
+
+	CHECK(binner.getNumIndices() == 0 && binner.getStats().numVisible == 0);
+	CHECK(binner.getTiles()[0].count == 0);
+}
+
+}
+
+TEST_MAIN(TestFullHD, TestOddSize, TestAroundEye, TestLimits)
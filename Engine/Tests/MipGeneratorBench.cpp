@@ -0,0 +1,67 @@
+#include "Engine.h"
+#include "Test.h"
+#include "Images.h"
+
+using namespace MipGenerator;
+
+namespace{
+
+// Fraction of the top level texels that pass the alpha test, to compare with the smaller levels
+double Coverage(const uint8_t *texels, size_t numTexels){
+	size_t numPassing = 0;
+
+	for(size_t i = 0; i < numTexels; i++) numPassing += texels[i * 4 + 3] > 127;
+
+	return static_cast<double>(numPassing) / numTexels;
+}
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	const size_t sizes[] = {4096, 8192};
+
+	std::printf("%u threads available\n", std::thread::hardware_concurrency());
+
+	for(size_t size : sizes){
+		std::vector<uint8_t> image = Test::MakeImage(Test::ImageSmooth, size, size);
+
+		// Cutout alpha with thin features, like foliage, so the coverage preservation has work to do
+		for(size_t y = 0; y < size; y++){
+			for(size_t x = 0; x < size; x++) image[(y * size + x) * 4 + 3] = sin(x * 0.05) * cos(y * 0.07) > 0.6 ? 255 : 0;
+		}
+
+		for(int kaiser = 0; kaiser < 2; kaiser++){
+			for(int srgb = 0; srgb < 2; srgb++){
+				MipOptions options;
+
+				options.filter			= kaiser ? FilterKaiser : FilterBox;
+				options.srgb			= srgb != 0;
+				options.alphaReference	= 0.5f;
+
+				std::vector<uint8_t> chain;
+				size_t mipCount = 0;
+				Test::Clock::time_point start = Test::Clock::now();
+
+				if(!GenerateMipChain(&image[0], size, size, size * 4, options, chain, mipCount) || mipCount != GetMipCount(size, size)){
+					Test::g_failures++;
+					continue;
+				}
+
+				double ms = Test::ElapsedMs(start);
+
+				// Coverage of the 1/16 size level
+				size_t offset = 0;
+
+				for(size_t mip = 0; mip < 4; mip++) offset += (size >> mip) * (size >> mip) * 4;
+
+				std::printf("%zux%zu %-6s %-6s %9.1f ms, %7.1f MPix/s, coverage %.3f -> %.3f\n", size, size, kaiser ? "kaiser" : "box",
+					srgb ? "srgb" : "linear", ms, size * size / (ms * 1000.0), Coverage(&image[0], size * size),
+					Coverage(&chain[offset], (size >> 4) * (size >> 4)));
+			}
+		}
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
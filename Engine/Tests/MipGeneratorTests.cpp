@@ -0,0 +1,210 @@
+#include "Engine.h"
+#include "Test.h"
+#include "Images.h"
+#include "DDSFiles.h"
+
+using namespace MipGenerator;
+
+namespace{
+
+double ToLinear(double c){
+	return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+}
+
+double ToSRGB(double c){
+	return c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+}
+
+// Offset of a level in a packed chain
+size_t GetMipOffset(size_t width, size_t height, size_t mip){
+	size_t offset = 0;
+
+	for(size_t i = 0; i < mip; i++) offset += std::max<size_t>(1, width >> i) * std::max<size_t>(1, height >> i) * 4;
+
+	return offset;
+}
+
+// Fraction of texels that pass an alpha test at reference
+double Coverage(const uint8_t *texels, size_t numTexels, float reference){
+	size_t numPassing = 0;
+
+	for(size_t i = 0; i < numTexels; i++) numPassing += texels[i * 4 + 3] / 255.0f > reference;
+
+	return static_cast<double>(numPassing) / numTexels;
+}
+
+// Every box filtered texel is the average of the top level block under it, color in linear space when sRGB,
+// alpha always as stored, within the rounding of the 8-bit results
+void TestBoxAverages(){
+	const size_t Width = 64, Height = 32;
+
+	std::vector<uint8_t> image = Test::MakeImage(Test::ImageNoise, Width, Height);
+
+	for(int srgb = 0; srgb < 2; srgb++){
+		MipOptions options;
+
+		options.srgb = srgb != 0;
+
+		std::vector<uint8_t> chain;
+		size_t mipCount = 0;
+
+		CHECK(GenerateMipChain(&image[0], Width, Height, Width * 4, options, chain, mipCount));
+		CHECK(mipCount == 7 && chain.size() == GetMipOffset(Width, Height, mipCount));
+		CHECK(memcmp(&chain[0], &image[0], image.size()) == 0);
+
+		// Down to 4x4 blocks at level 2, each level is filtered from the unrounded one above it
+		for(size_t mip = 1; mip <= 2; mip++){
+			size_t mipWidth = Width >> mip, mipHeight = Height >> mip, blockSize = static_cast<size_t>(1) << mip;
+			const uint8_t *level = &chain[GetMipOffset(Width, Height, mip)];
+			int maxError = 0;
+
+			for(size_t y = 0; y < mipHeight; y++){
+				for(size_t x = 0; x < mipWidth; x++){
+					for(size_t c = 0; c < 4; c++){
+						double sum = 0.0;
+
+						for(size_t by = 0; by < blockSize; by++){
+							for(size_t bx = 0; bx < blockSize; bx++){
+								double value = image[((y * blockSize + by) * Width + x * blockSize + bx) * 4 + c] / 255.0;
+
+								sum += options.srgb && c < 3 ? ToLinear(value) : value;
+							}
+						}
+
+						double average = sum / (blockSize * blockSize);
+						int expected = static_cast<int>((options.srgb && c < 3 ? ToSRGB(average) : average) * 255.0 + 0.5);
+
+						maxError = std::max(maxError, std::abs(expected - level[(y * mipWidth + x) * 4 + c]));
+					}
+				}
+			}
+
+			CHECK(maxError <= 1);
+		}
+	}
+
+	// Black and white average to the middle grey of linear light, not of the stored values
+	uint8_t checker[2 * 2 * 4] = {0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255};
+	MipOptions options;
+	std::vector<uint8_t> chain;
+	size_t mipCount = 0;
+
+	options.srgb = true;
+
+	CHECK(GenerateMipChain(checker, 2, 2, 8, options, chain, mipCount) && mipCount == 2);
+	CHECK(std::abs(chain[16] - 188) <= 1 && chain[16] == chain[17] && chain[17] == chain[18] && chain[19] == 255);
+
+	options.srgb = false;
+
+	CHECK(GenerateMipChain(checker, 2, 2, 8, options, chain, mipCount) && mipCount == 2);
+	CHECK(chain[16] == 128 && chain[19] == 255);
+}
+
+// Thin cutout features fade out of plain box and Kaiser filtered levels. With an alpha reference every level
+// large enough to measure gets as close to the top level's share of texels passing the test as scaling its alpha
+// can, which is exact for all but the coarse steps of box filtered hard edges
+void TestAlphaCoverage(){
+	const size_t Width = 512, Height = 256;
+	const float Reference = 0.5f;
+
+	std::vector<uint8_t> image = Test::MakeImage(Test::ImageSmooth, Width, Height);
+
+	for(int pattern = 0; pattern < 2; pattern++){
+
+		// Hard edged stripes a few texels wide that wander across the rows like blades of grass, and one texel wide
+		// lines whose box filtered alpha lands right on the reference
+		for(size_t y = 0; y < Height; y++){
+			for(size_t x = 0; x < Width; x++){
+				bool covered = pattern == 0 ? sin(x * 0.4 + sin(y * 0.05) * 3.0) > 0.85 : (x + y / 3) % 6 == 0 || sin(x * 0.05) * cos(y * 0.07) > 0.9;
+
+				image[(y * Width + x) * 4 + 3] = covered ? 255 : 0;
+			}
+		}
+
+		double topCoverage = Coverage(&image[0], Width * Height, Reference);
+
+		CHECK(topCoverage > 0.05 && topCoverage < 0.5);
+
+		for(int kaiser = 0; kaiser < 2; kaiser++){
+			for(int srgb = 0; srgb < 2; srgb++){
+				MipOptions options;
+
+				options.filter	= kaiser ? FilterKaiser : FilterBox;
+				options.srgb	= srgb != 0;
+
+				std::vector<uint8_t> plain, preserved;
+				size_t mipCount = 0;
+
+				CHECK(GenerateMipChain(&image[0], Width, Height, Width * 4, options, plain, mipCount));
+
+				options.alphaReference = Reference;
+
+				CHECK(GenerateMipChain(&image[0], Width, Height, Width * 4, options, preserved, mipCount));
+
+				double maxPlainError = 0.0;
+
+				// Down to 32x16, smaller levels only have a few texels to get the share right with
+				for(size_t mip = 1; mip <= 4; mip++){
+					size_t offset = GetMipOffset(Width, Height, mip), numTexels = (Width >> mip) * (Height >> mip);
+					double plainError = fabs(Coverage(&plain[offset], numTexels, Reference) - topCoverage);
+					double preservedError = fabs(Coverage(&preserved[offset], numTexels, Reference) - topCoverage);
+
+					// Scaling keeps the order of the alpha values, so the shares it can reach are those of the texels
+					// at or above each one
+					std::vector<uint32_t> counts(256, 0);
+
+					for(size_t i = 0; i < numTexels; i++) counts[plain[offset + i * 4 + 3]]++;
+
+					double bestError = topCoverage;
+					uint32_t numAbove = 0;
+
+					for(int alpha = 255; alpha > 0; alpha--){
+						numAbove += counts[alpha];
+						bestError = std::min(bestError, fabs(static_cast<double>(numAbove) / numTexels - topCoverage));
+					}
+
+					CHECK(preservedError <= bestError + 0.005);
+
+					maxPlainError = std::max(maxPlainError, plainError);
+				}
+
+				CHECK(maxPlainError > 0.1);
+			}
+		}
+	}
+}
+
+// The offline tool's path, a single-mip file comes back with the same headers, the full chain and its top level
+// untouched, and files it can't build a chain for are left alone
+void TestDDSFile(){
+	Test::TempDirectory directory;
+	std::vector<uint8_t> file = Test::MakeDDSFile(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 64, 32, 1, 1, 1);
+
+	CHECK(Util::WriteMemoryToFile(directory.wideFile("single.dds"), file.data(), file.size()));
+	CHECK(GenerateDDSMipsToFile(directory.wideFile("single.dds"), directory.wideFile("mipmapped.dds"), MipOptions()));
+
+	std::vector<uint8_t> mipmapped;
+
+	CHECK(Util::ReadFileToMemory(directory.wideFile("mipmapped.dds"), mipmapped));
+	CHECK(mipmapped.size() == Test::GetDDSFileSize(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 64, 32, 1, 7, 1));
+
+	if(mipmapped.size() >= file.size()){
+		uint32_t mipCount;
+
+		memcpy(&mipCount, &mipmapped[28], sizeof(mipCount));
+
+		CHECK(mipCount == 7);
+		CHECK(memcmp(&mipmapped[Test::DDSHeaderSize], &file[Test::DDSHeaderSize], file.size() - Test::DDSHeaderSize) == 0);
+	}
+
+	// Already has mips
+	file = Test::MakeDDSFile(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 32, 1, 7, 1);
+
+	CHECK(Util::WriteMemoryToFile(directory.wideFile("chain.dds"), file.data(), file.size()));
+	CHECK(!GenerateDDSMipsToFile(directory.wideFile("chain.dds"), directory.wideFile("out.dds"), MipOptions()));
+	CHECK(!GenerateDDSMipsToFile(directory.wideFile("missing.dds"), directory.wideFile("out.dds"), MipOptions()));
+}
+
+}
+
+TEST_MAIN(TestBoxAverages, TestAlphaCoverage, TestDDSFile)
@@ -0,0 +1,100 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t Width		= 1920 / 4;
+const uint32_t Height		= 1080 / 4;
+const uint32_t NumFrames	= 100;
+const uint32_t NumBoxes		= 100000;
+
+// A grid of rings x segments quads on a sphere
+void BuildSphere(float radius, uint32_t rings, uint32_t segments, OccluderMesh &mesh){
+	for(uint32_t r = 0; r <= rings; r++){
+		float theta = 3.14159265f * r / rings;
+
+		for(uint32_t s = 0; s <= segments; s++){
+			float phi = 2.0f * 3.14159265f * s / segments;
+
+			mesh.positions.push_back(DirectX::XMFLOAT3(radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi)));
+		}
+	}
+
+	for(uint32_t r = 0; r < rings; r++){
+		for(uint32_t s = 0; s < segments; s++){
+			uint32_t i0 = r * (segments + 1) + s, i1 = i0 + 1, i2 = i0 + segments + 1, i3 = i2 + 1;
+			uint32_t quad[6] = {i0, i2, i1, i1, i2, i3};
+
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+}
+
+// Rasterizes a field of sphere occluders in front of the camera and tests boxes scattered behind them
+int main(){
+	Test::Random random(1);
+
+	OcclusionCuller culler(Width, Height);
+	Camera camera;
+
+	camera.setPos(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+	camera.setProperties(16.0f, 9.0f, 0.1f, 500.0f);
+
+	uint32_t sizes[] = {8, 16, 32};
+
+	for(uint32_t size : sizes){
+		OccluderMesh sphere;
+
+		BuildSphere(1.0f, size, size * 2, sphere);
+
+		std::vector<DirectX::XMMATRIX> occluders;
+
+		for(uint32_t i = 0; i < 64; i++){
+			occluders.push_back(DirectX::XMMatrixTranslation(random.range(-12.0f, 12.0f), random.range(-6.0f, 6.0f), random.range(8.0f, 20.0f)));
+		}
+
+		Test::Clock::time_point start = Test::Clock::now();
+
+		for(uint32_t frame = 0; frame < NumFrames; frame++){
+			culler.beginFrame(camera);
+
+			for(const DirectX::XMMATRIX &world : occluders){
+				culler.renderOccluder(sphere, world);
+			}
+
+			culler.endFrame();
+		}
+
+		double rasterMs = Test::ElapsedMs(start) / NumFrames;
+
+		std::printf("%u occluders of %u triangles, %ux%u: %.3f ms/frame, %u triangles rasterized\n", static_cast<uint32_t>(occluders.size()),
+			static_cast<uint32_t>(sphere.indices.size() / 3), culler.getWidth(), culler.getHeight(), rasterMs, culler.getNumTriangles());
+	}
+
+	std::vector<DirectX::XMFLOAT3> centres(NumBoxes);
+
+	for(DirectX::XMFLOAT3 &centre : centres){
+		centre = DirectX::XMFLOAT3(random.range(-30.0f, 30.0f), random.range(-15.0f, 15.0f), random.range(10.0f, 60.0f));
+	}
+
+	DirectX::XMMATRIX world = DirectX::XMMatrixIdentity();
+	DirectX::XMFLOAT3 extent(0.5f, 0.5f, 0.5f);
+	uint32_t numVisible = 0;
+
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(const DirectX::XMFLOAT3 &centre : centres){
+		DirectX::XMFLOAT3 boundsMin(centre.x - extent.x, centre.y - extent.y, centre.z - extent.z);
+		DirectX::XMFLOAT3 boundsMax(centre.x + extent.x, centre.y + extent.y, centre.z + extent.z);
+
+		if(culler.isVisible(boundsMin, boundsMax, world)) numVisible++;
+	}
+
+	double testMs = Test::ElapsedMs(start);
+
+	std::printf("%u box tests: %.1f ns/test, %u visible\n", NumBoxes, testMs * 1e6 / NumBoxes, numVisible);
+
+	return 0;
+}
@@ -0,0 +1,412 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t Width	= 320;
+const uint32_t Height	= 180;
+
+// Sphere with a bumpy radius, seen from outside it has dents and ridges for a simplification to fill in
+void BuildBumpySphere(float radius, uint32_t rings, uint32_t segments, Test::Random &random, std::vector<BoxVertex> &vertices,
+	std::vector<uint32_t> &indices){
+
+	vertices.clear();
+	indices.clear();
+
+	for(uint32_t r = 0; r <= rings; r++){
+		float theta = 3.14159265f * r / rings;
+
+		for(uint32_t s = 0; s <= segments; s++){
+			float phi = 2.0f * 3.14159265f * s / segments;
+			float bump = radius * random.range(0.7f, 1.3f);
+
+			BoxVertex v = {};
+
+			v.x = bump * sinf(theta) * cosf(phi);
+			v.y = bump * cosf(theta);
+			v.z = bump * sinf(theta) * sinf(phi);
+			v.w = 1.0f;
+
+			vertices.push_back(v);
+		}
+	}
+
+	for(uint32_t r = 0; r < rings; r++){
+		for(uint32_t s = 0; s < segments; s++){
+			uint32_t i0 = r * (segments + 1) + s, i1 = i0 + 1, i2 = i0 + segments + 1, i3 = i2 + 1;
+
+			indices.push_back(i0);
+			indices.push_back(i2);
+			indices.push_back(i1);
+			indices.push_back(i1);
+			indices.push_back(i2);
+			indices.push_back(i3);
+		}
+	}
+}
+
+// Wall in the xy plane with a comb of deep teeth along its top, built from quads of random sizes
+void BuildCombWall(float width, float height, uint32_t numTeeth, Test::Random &random, std::vector<BoxVertex> &vertices,
+	std::vector<uint32_t> &indices){
+
+	vertices.clear();
+	indices.clear();
+
+	auto addQuad = [&](float x0, float y0, float x1, float y1, float z){
+		uint32_t base = static_cast<uint32_t>(vertices.size());
+		float corners[4][2] = {{x0, y0}, {x1, y0}, {x0, y1}, {x1, y1}};
+
+		for(auto &corner : corners){
+			BoxVertex v = {};
+
+			v.x = corner[0];
+			v.y = corner[1];
+			v.z = z;
+			v.w = 1.0f;
+
+			vertices.push_back(v);
+		}
+
+		uint32_t quad[6] = {0, 2, 1, 1, 2, 3};
+
+		for(uint32_t i : quad) indices.push_back(base + i);
+	};
+
+	addQuad(-0.5f * width, 0.0f, 0.5f * width, 0.5f * height, 0.0f);
+
+	float toothWidth = width / numTeeth;
+
+	for(uint32_t t = 0; t < numTeeth; t += 2){
+		float x = -0.5f * width + t * toothWidth;
+
+		addQuad(x, 0.5f * height, x + toothWidth * random.range(0.2f, 1.0f), height * random.range(0.6f, 1.0f), random.range(-0.2f, 0.2f));
+	}
+}
+
+// Scalar reference for the culler's rasterizer, one pixel and one triangle at a time in double precision. Takes
+// clip space vertices in front of the near plane and keeps the nearest depth of the pixel centres strictly inside.
+// The culler works in floats from edge equations of absolute screen positions, so each pixel also gets the error
+// it can have: ambiguous when a centre is close enough to an edge to land on either side, otherwise the largest
+// depth error of the triangles covering it, which grows with the size of the positions over the triangle's area
+class ReferenceRasterizer{
+public:
+	static const double FloatError;
+
+	uint32_t width, height;
+	std::vector<float> depth, tolerance;
+	std::vector<bool> ambiguous;
+
+	ReferenceRasterizer(uint32_t w, uint32_t h) : width(w), height(h){
+		clear();
+	}
+
+	void clear(){
+		depth.assign(width * height, 1.0f);
+		tolerance.assign(width * height, 1e-5f);
+		ambiguous.assign(width * height, false);
+	}
+
+	void rasterize(const DirectX::XMFLOAT4 clip[3]){
+		double x[3], y[3], z[3];
+
+		for(int i = 0; i < 3; i++){
+			x[i] = (clip[i].x / clip[i].w) * 0.5 * width + 0.5 * width;
+			y[i] = 0.5 * height - (clip[i].y / clip[i].w) * 0.5 * height;
+			z[i] = clip[i].z / clip[i].w;
+		}
+
+		double area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+		if(fabs(area) < 1e-6) return;
+
+		// Rounding of each edge's constant term, and of the depth plane built from them
+		double edgeError[3], depthError = 0.0;
+
+		for(int i = 0; i < 3; i++){
+			int a = (i + 1) % 3, b = (i + 2) % 3;
+
+			edgeError[i] = FloatError * (fabs(x[a] * y[b]) + fabs(y[a] * x[b]) + fabs(x[b] - x[a]) * height + fabs(y[b] - y[a]) * width);
+			depthError += edgeError[i] * fabs(z[i]) / fabs(area);
+		}
+
+		for(uint32_t py = 0; py < height; py++){
+			for(uint32_t px = 0; px < width; px++){
+				double cx = px + 0.5, cy = py + 0.5;
+				double weights[3];
+				bool inside = true, nearEdge = false;
+
+				for(int i = 0; i < 3; i++){
+					int a = (i + 1) % 3, b = (i + 2) % 3;
+					double edge = (x[b] - x[a]) * (cy - y[a]) - (y[b] - y[a]) * (cx - x[a]);
+
+					weights[i] = edge / area;
+
+					inside = inside && weights[i] > 0.0;
+					nearEdge = nearEdge || fabs(edge) <= edgeError[i];
+				}
+
+				uint32_t i = py * width + px;
+
+				if(nearEdge) ambiguous[i] = true;
+				if(!inside) continue;
+
+				depth[i] = std::min(depth[i], static_cast<float>(std::max(0.0, weights[0] * z[0] + weights[1] * z[1] + weights[2] * z[2])));
+				tolerance[i] = std::max(tolerance[i], static_cast<float>(depthError));
+			}
+		}
+	}
+};
+
+// A few float roundings per term
+const double ReferenceRasterizer::FloatError = 4.0 * FLT_EPSILON;
+
+DirectX::XMFLOAT4 ToClip(const DirectX::XMFLOAT3 &position, const DirectX::XMMATRIX &viewProj){
+	DirectX::XMFLOAT4 clip;
+
+	DirectX::XMStoreFloat4(&clip, DirectX::XMVector4Transform(DirectX::XMVectorSetW(DirectX::XMLoadFloat3(&position), 1.0f), viewProj));
+
+	return clip;
+}
+
+// Random triangles in front of random views, the culler's depth buffer matches the reference within its error on
+// every pixel that isn't right on an edge, and its box tests agree with testing every pixel of the box's rectangle
+void TestReference(){
+	Test::Random random(4);
+	OcclusionCuller culler(Width, Height);
+	ReferenceRasterizer reference(culler.getWidth(), culler.getHeight());
+	Camera camera;
+	uint32_t numCompared = 0, numBoxes = 0, numVisible = 0;
+
+	camera.setProperties(static_cast<float>(Width), static_cast<float>(Height), 0.1f, 100.0f);
+
+	for(uint32_t view = 0; view < 16; view++){
+		DirectX::XMFLOAT3 eye(random.range(-20.0f, 20.0f), random.range(-5.0f, 5.0f), random.range(-20.0f, 20.0f));
+		DirectX::XMFLOAT3 direction(random.range(-1.0f, 1.0f), random.range(-0.3f, 0.3f), random.range(-1.0f, 1.0f));
+
+		camera.setPos(eye);
+		camera.setTarget(direction);
+
+		DirectX::XMMATRIX viewProj = camera.getViewProjMatrixCPU();
+		OccluderMesh mesh;
+
+		reference.clear();
+
+		// Triangles of all sizes spread along the view direction, the reference doesn't clip so only ones in front
+		// of the near plane are kept
+		for(uint32_t i = 0; i < 24; i++){
+			float distance = random.range(1.0f, 40.0f), size = random.range(0.2f, 6.0f);
+			DirectX::XMFLOAT3 centre(eye.x + direction.x * distance + random.range(-8.0f, 8.0f), eye.y + direction.y * distance + random.range(-4.0f, 4.0f),
+				eye.z + direction.z * distance + random.range(-8.0f, 8.0f));
+			DirectX::XMFLOAT3 corners[3];
+			DirectX::XMFLOAT4 clip[3];
+			bool inFront = true;
+
+			for(int j = 0; j < 3; j++){
+				corners[j] = DirectX::XMFLOAT3(centre.x + random.range(-size, size), centre.y + random.range(-size, size), centre.z + random.range(-size, size));
+				clip[j] = ToClip(corners[j], viewProj);
+				inFront = inFront && clip[j].z > 0.0f && clip[j].w > 0.1f;
+			}
+
+			if(!inFront) continue;
+
+			reference.rasterize(clip);
+
+			for(int j = 0; j < 3; j++){
+				mesh.indices.push_back(static_cast<uint32_t>(mesh.positions.size()));
+				mesh.positions.push_back(corners[j]);
+			}
+		}
+
+		culler.beginFrame(camera);
+		culler.renderOccluder(mesh, DirectX::XMMatrixIdentity());
+		culler.endFrame();
+
+		const float *depth = culler.getDepthBuffer();
+
+		for(uint32_t i = 0; i < reference.depth.size(); i++){
+			if(reference.ambiguous[i]) continue;
+
+			CHECK(fabsf(depth[i] - reference.depth[i]) <= reference.tolerance[i]);
+			numCompared++;
+		}
+
+		// Boxes in front of the camera, visible when the nearest corner is in front of any pixel of the rectangle
+		// around the corners
+		for(uint32_t b = 0; b < 256; b++){
+			float distance = random.range(2.0f, 60.0f), size = random.range(0.05f, 2.0f);
+			DirectX::XMFLOAT3 centre(eye.x + direction.x * distance + random.range(-10.0f, 10.0f), eye.y + direction.y * distance + random.range(-5.0f, 5.0f),
+				eye.z + direction.z * distance + random.range(-10.0f, 10.0f));
+			DirectX::XMFLOAT3 boundsMin(centre.x - size, centre.y - size, centre.z - size);
+			DirectX::XMFLOAT3 boundsMax(centre.x + size, centre.y + size, centre.z + size);
+
+			float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+			bool inFront = true;
+
+			for(uint32_t i = 0; i < 8; i++){
+				DirectX::XMFLOAT3 corner((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z);
+				DirectX::XMFLOAT4 clip = ToClip(corner, viewProj);
+
+				inFront = inFront && clip.z > 0.0f && clip.w > 0.1f;
+
+				minX = std::min(minX, (clip.x / clip.w) * 0.5f * reference.width + 0.5f * reference.width);
+				maxX = std::max(maxX, (clip.x / clip.w) * 0.5f * reference.width + 0.5f * reference.width);
+				minY = std::min(minY, 0.5f * reference.height - (clip.y / clip.w) * 0.5f * reference.height);
+				maxY = std::max(maxY, 0.5f * reference.height - (clip.y / clip.w) * 0.5f * reference.height);
+				minZ = std::min(minZ, clip.z / clip.w);
+			}
+
+			if(!inFront) continue;
+
+			int32_t x0 = std::max<int32_t>(0, static_cast<int32_t>(minX)), x1 = std::min<int32_t>(reference.width - 1, static_cast<int32_t>(maxX));
+			int32_t y0 = std::max<int32_t>(0, static_cast<int32_t>(minY)), y1 = std::min<int32_t>(reference.height - 1, static_cast<int32_t>(maxY));
+			bool visible = false, unsure = false;
+
+			for(int32_t y = y0; y <= y1 && maxX >= 0 && maxY >= 0 && minZ <= 1.0f; y++){
+				for(int32_t x = x0; x <= x1; x++){
+					uint32_t i = y * reference.width + x;
+
+					visible = visible || minZ <= reference.depth[i];
+					unsure = unsure || reference.ambiguous[i] || fabsf(minZ - reference.depth[i]) <= reference.tolerance[i];
+				}
+			}
+
+			// Rectangle edges that land right on a pixel boundary can round either way too
+			unsure = unsure || fabsf(minX - roundf(minX)) < 1e-3f || fabsf(maxX - roundf(maxX)) < 1e-3f ||
+				fabsf(minY - roundf(minY)) < 1e-3f || fabsf(maxY - roundf(maxY)) < 1e-3f;
+
+			if(unsure) continue;
+
+			CHECK(culler.isVisible(boundsMin, boundsMax, DirectX::XMMatrixIdentity()) == visible);
+
+			numBoxes++;
+			numVisible += visible;
+		}
+	}
+
+	// Enough of both to mean something
+	CHECK(numCompared > 16 * reference.depth.size() / 2);
+	CHECK(numBoxes > 16 * 64 && numVisible > 0 && numVisible < numBoxes);
+}
+
+// Renders the full mesh and its simplification from random views around it. The simplified occluder must never
+// be nearer than the full mesh on any pixel, and a box the full mesh leaves visible must stay visible
+void CheckConservative(const std::vector<BoxVertex> &vertices, const std::vector<uint32_t> &indices, float cellSize, float viewDistance,
+	Test::Random &random){
+
+	OccluderMesh full, simplified;
+
+	SimplifyOccluder(&vertices[0], &indices[0], static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()),
+		sizeof(BoxVertex), 0.0f, full);
+	SimplifyOccluder(&vertices[0], &indices[0], static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()),
+		sizeof(BoxVertex), cellSize, simplified);
+
+	CHECK(full.indices.size() == indices.size());
+	CHECK(simplified.indices.size() <= full.indices.size());
+
+	OcclusionCuller fullCuller(Width, Height), simplifiedCuller(Width, Height);
+	Camera camera;
+
+	camera.setProperties(static_cast<float>(Width), static_cast<float>(Height), 0.1f, 100.0f);
+
+	for(uint32_t view = 0; view < 32; view++){
+		float yaw = random.range(0.0f, 6.2831853f), pitch = random.range(-1.2f, 1.2f);
+		DirectX::XMFLOAT3 eye(viewDistance * cosf(pitch) * cosf(yaw), viewDistance * sinf(pitch), viewDistance * cosf(pitch) * sinf(yaw));
+
+		DirectX::XMFLOAT3 target(random.range(-0.5f, 0.5f), random.range(-0.5f, 0.5f), 0.0f);
+
+		// The camera's target is the direction it looks in
+		camera.setPos(eye);
+		camera.setTarget(DirectX::XMFLOAT3(target.x - eye.x, target.y - eye.y, target.z - eye.z));
+
+		DirectX::XMMATRIX world = DirectX::XMMatrixIdentity();
+
+		fullCuller.beginFrame(camera);
+		fullCuller.renderOccluder(full, world);
+		fullCuller.endFrame();
+
+		simplifiedCuller.beginFrame(camera);
+		simplifiedCuller.renderOccluder(simplified, world);
+		simplifiedCuller.endFrame();
+
+		const float *fullDepth = fullCuller.getDepthBuffer(), *simplifiedDepth = simplifiedCuller.getDepthBuffer();
+		uint32_t numNearer = 0;
+
+		for(uint32_t i = 0; i < fullCuller.getWidth() * fullCuller.getHeight(); i++){
+			if(simplifiedDepth[i] < fullDepth[i]) numNearer++;
+		}
+
+		CHECK(numNearer == 0);
+
+		// Small boxes scattered through and behind the mesh
+		for(uint32_t b = 0; b < 256; b++){
+			DirectX::XMFLOAT3 centre(random.range(-viewDistance, viewDistance), random.range(-viewDistance, viewDistance),
+				random.range(-viewDistance, viewDistance));
+			float size = random.range(0.05f, 0.5f);
+
+			DirectX::XMFLOAT3 boundsMin(centre.x - size, centre.y - size, centre.z - size);
+			DirectX::XMFLOAT3 boundsMax(centre.x + size, centre.y + size, centre.z + size);
+
+			if(fullCuller.isVisible(boundsMin, boundsMax, world)){
+				CHECK(simplifiedCuller.isVisible(boundsMin, boundsMax, world));
+			}
+		}
+	}
+}
+
+void TestBumpySphere(){
+	Test::Random random(1);
+	std::vector<BoxVertex> vertices;
+	std::vector<uint32_t> indices;
+
+	BuildBumpySphere(3.0f, 48, 96, random, vertices, indices);
+
+	float cellSizes[] = {0.02f, 0.1f, 0.25f, 0.5f};
+
+	for(float cellSize : cellSizes){
+		CheckConservative(vertices, indices, cellSize, 9.0f, random);
+	}
+}
+
+void TestCombWall(){
+	Test::Random random(2);
+	std::vector<BoxVertex> vertices;
+	std::vector<uint32_t> indices;
+
+	BuildCombWall(8.0f, 4.0f, 64, random, vertices, indices);
+
+	float cellSizes[] = {0.05f, 0.2f, 0.5f};
+
+	for(float cellSize : cellSizes){
+		CheckConservative(vertices, indices, cellSize, 10.0f, random);
+	}
+}
+
+// The big parts of a mesh survive, otherwise the simplification would be trivially conservative
+void TestKeepsLargeTriangles(){
+	Test::Random random(3);
+	std::vector<BoxVertex> vertices;
+	std::vector<uint32_t> indices;
+
+	BuildCombWall(8.0f, 4.0f, 64, random, vertices, indices);
+
+	OccluderMesh occluder;
+
+	SimplifyOccluder(&vertices[0], &indices[0], static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()),
+		sizeof(BoxVertex), 0.5f, occluder);
+
+	// The wall's base quad is kept and only its own four corners are copied
+	CHECK(occluder.indices.size() >= 6);
+	CHECK(occluder.indices.size() < indices.size());
+	CHECK(occluder.positions.size() * 6 == occluder.indices.size() * 4);
+
+	// Everything is kept without a cell size
+	SimplifyOccluder(&vertices[0], &indices[0], static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()),
+		sizeof(BoxVertex), 0.0f, occluder);
+
+	CHECK(occluder.indices.size() == indices.size());
+	CHECK(occluder.positions.size() == vertices.size());
+}
+
+}
+
+TEST_MAIN(TestReference, TestBumpySphere, TestCombWall, TestKeepsLargeTriangles)
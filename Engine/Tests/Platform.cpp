@@ -0,0 +1,565 @@
+#include "Engine.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <map>
+#include <fstream>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/random.h>
+#include <pthread.h>
+
+const GUID IID_IUnknown					= {0x00000000, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const GUID WKPDID_D3DDebugObjectName	= {0x429b8c22, 0x9188, 0x4b0c, {0x87, 0x42, 0xac, 0xb0, 0xbf, 0x85, 0xc2, 0x00}};
+
+namespace{
+
+// Handles point at one of these, a mapping keeps its own descriptor so it outlives the file handle
+struct FileObject{
+	int fd;
+};
+
+thread_local DWORD t_lastError = 0;
+
+std::atomic<uint64_t> g_numFileReads(0), g_numFileBytesRead(0);
+std::atomic<uint64_t> g_numHandleReads(0), g_numHandleBytesRead(0);
+
+std::mutex g_viewMutex;
+std::map<const void *, size_t> g_views;
+uint64_t g_numViews = 0, g_numViewBytes = 0;
+
+DWORD ErrorFromErrno(){
+	return errno == ENOENT ? ERROR_FILE_NOT_FOUND : ERROR_INVALID_DATA;
+}
+
+// Code points below 0x110000 as UTF-8, wchar_t is 32 bits here
+std::string ToUtf8(const wchar_t *text, size_t length){
+	std::string result;
+
+	for(size_t i = 0; i < length; i++){
+		uint32_t c = static_cast<uint32_t>(text[i]);
+
+		if(c < 0x80){
+			result += static_cast<char>(c);
+		}
+		else if(c < 0x800){
+			result += static_cast<char>(0xC0 | (c >> 6));
+			result += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else if(c < 0x10000){
+			result += static_cast<char>(0xE0 | (c >> 12));
+			result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			result += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else{
+			result += static_cast<char>(0xF0 | (c >> 18));
+			result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			result += static_cast<char>(0x80 | (c & 0x3F));
+		}
+	}
+
+	return result;
+}
+
+std::string ToUtf8(const wchar_t *text){
+	return ToUtf8(text, wcslen(text));
+}
+
+// Engine paths use backslashes
+std::string ToPath(const wchar_t *path){
+	std::string result = ToUtf8(path);
+
+	std::replace(result.begin(), result.end(), '\\', '/');
+
+	return result;
+}
+
+void FindFilesIn(const std::string &root, const std::string &relative, const std::string &pattern, std::vector<std::wstring> &files){
+	DIR *directory = opendir((root + relative).c_str());
+
+	if(!directory) return;
+
+	while(dirent *entry = readdir(directory)){
+		std::string name = entry->d_name;
+
+		if(name == "." || name == "..") continue;
+
+		std::string path = relative.empty() ? name : relative + "/" + name;
+		struct stat info;
+
+		if(stat((root + path).c_str(), &info) != 0) continue;
+
+		if(S_ISDIR(info.st_mode)){
+			FindFilesIn(root, path, pattern, files);
+		}
+		else if(fnmatch(pattern.c_str(), name.c_str(), FNM_CASEFOLD) == 0){
+			std::replace(path.begin(), path.end(), '/', '\\');
+			files.push_back(std::wstring(path.begin(), path.end()));
+		}
+	}
+
+	closedir(directory);
+}
+
+}
+
+HANDLE CreateFileW(const wchar_t *fileName, DWORD access, DWORD, SECURITY_ATTRIBUTES *, DWORD disposition, DWORD, HANDLE){
+	int flags = (access & GENERIC_WRITE) ? O_WRONLY : O_RDONLY;
+
+	if(disposition == CREATE_ALWAYS) flags |= O_CREAT | O_TRUNC;
+
+	int fd = open(ToPath(fileName).c_str(), flags, 0644);
+
+	if(fd < 0){
+		t_lastError = ErrorFromErrno();
+		return INVALID_HANDLE_VALUE;
+	}
+
+	return new FileObject{fd};
+}
+
+BOOL ReadFile(HANDLE file, void *buffer, DWORD bytesToRead, DWORD *bytesRead, void *){
+	ssize_t result = read(static_cast<FileObject *>(file)->fd, buffer, bytesToRead);
+
+	if(result < 0){
+		t_lastError = ErrorFromErrno();
+		return FALSE;
+	}
+
+	if(bytesRead) *bytesRead = static_cast<DWORD>(result);
+
+	g_numHandleReads++;
+	g_numHandleBytesRead += static_cast<uint64_t>(result);
+
+	return TRUE;
+}
+
+BOOL WriteFile(HANDLE file, const void *buffer, DWORD bytesToWrite, DWORD *bytesWritten, void *){
+	ssize_t result = write(static_cast<FileObject *>(file)->fd, buffer, bytesToWrite);
+
+	if(result < 0){
+		t_lastError = ErrorFromErrno();
+		return FALSE;
+	}
+
+	if(bytesWritten) *bytesWritten = static_cast<DWORD>(result);
+
+	return TRUE;
+}
+
+BOOL SetFilePointerEx(HANDLE file, LARGE_INTEGER distance, LARGE_INTEGER *newPosition, DWORD method){
+	off_t position = lseek(static_cast<FileObject *>(file)->fd, static_cast<off_t>(distance.QuadPart), method == FILE_BEGIN ? SEEK_SET : SEEK_CUR);
+
+	if(position < 0){
+		t_lastError = ErrorFromErrno();
+		return FALSE;
+	}
+
+	if(newPosition) newPosition->QuadPart = position;
+
+	return TRUE;
+}
+
+BOOL DeleteFileW(const wchar_t *fileName){
+	return unlink(ToPath(fileName).c_str()) == 0;
+}
+
+BOOL CreateDirectoryW(const wchar_t *path, SECURITY_ATTRIBUTES *){
+	return mkdir(ToPath(path).c_str(), 0755) == 0;
+}
+
+// rename() always replaces, which is all the engine asks for
+BOOL MoveFileExW(const wchar_t *existingName, const wchar_t *newName, DWORD){
+	return rename(ToPath(existingName).c_str(), ToPath(newName).c_str()) == 0;
+}
+
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER *size){
+	struct stat info;
+
+	if(fstat(static_cast<FileObject *>(file)->fd, &info) != 0){
+		t_lastError = ErrorFromErrno();
+		return FALSE;
+	}
+
+	size->QuadPart = info.st_size;
+
+	return TRUE;
+}
+
+BOOL CloseHandle(HANDLE handle){
+	if(!handle || handle == INVALID_HANDLE_VALUE) return FALSE;
+
+	FileObject *object = static_cast<FileObject *>(handle);
+
+	close(object->fd);
+	delete object;
+
+	return TRUE;
+}
+
+DWORD GetLastError(){
+	return t_lastError;
+}
+
+HANDLE CreateFileMappingW(HANDLE file, SECURITY_ATTRIBUTES *, DWORD, DWORD, DWORD, const wchar_t *){
+	int fd = dup(static_cast<FileObject *>(file)->fd);
+
+	if(fd < 0){
+		t_lastError = ErrorFromErrno();
+		return NULL;
+	}
+
+	return new FileObject{fd};
+}
+
+void *MapViewOfFile(HANDLE mapping, DWORD, DWORD offsetHigh, DWORD offsetLow, size_t numBytes){
+	off_t offset = static_cast<off_t>((static_cast<uint64_t>(offsetHigh) << 32) | offsetLow);
+	struct stat info;
+
+	// Zero maps to the end of the file
+	if(numBytes == 0 && fstat(static_cast<FileObject *>(mapping)->fd, &info) == 0) numBytes = static_cast<size_t>(info.st_size - offset);
+	void *view = mmap(nullptr, numBytes, PROT_READ, MAP_PRIVATE, static_cast<FileObject *>(mapping)->fd, offset);
+
+	if(view == MAP_FAILED){
+		t_lastError = ErrorFromErrno();
+		return NULL;
+	}
+
+	std::lock_guard<std::mutex> lock(g_viewMutex);
+
+	g_views[view] = numBytes;
+	g_numViews++;
+	g_numViewBytes += numBytes;
+
+	return view;
+}
+
+BOOL UnmapViewOfFile(const void *view){
+	std::lock_guard<std::mutex> lock(g_viewMutex);
+
+	auto found = g_views.find(view);
+
+	if(found == g_views.end()) return FALSE;
+
+	munmap(const_cast<void *>(view), found->second);
+	g_views.erase(found);
+
+	return TRUE;
+}
+
+void GetSystemInfo(SYSTEM_INFO *info){
+	info->dwPageSize				= static_cast<DWORD>(sysconf(_SC_PAGESIZE));
+	info->dwAllocationGranularity	= 65536;
+}
+
+DWORD GetFullPathNameW(const wchar_t *fileName, DWORD bufferLength, wchar_t *buffer, wchar_t **filePart){
+	std::wstring path = fileName;
+
+	std::replace(path.begin(), path.end(), L'\\', L'/');
+
+	if(path.empty() || path[0] != L'/'){
+		char directory[4096];
+
+		if(!getcwd(directory, sizeof(directory))) return 0;
+
+		std::string narrow = directory;
+
+		path = std::wstring(narrow.begin(), narrow.end()) + L"/" + path;
+	}
+
+	// Drop . and resolve .. like Windows does, without looking at the disk
+	std::vector<std::wstring> parts;
+	size_t start = 0;
+
+	while(start <= path.size()){
+		size_t end = path.find(L'/', start);
+
+		if(end == std::wstring::npos) end = path.size();
+
+		std::wstring part = path.substr(start, end - start);
+
+		if(part == L".."){
+			if(!parts.empty()) parts.pop_back();
+		}
+		else if(!part.empty() && part != L"."){
+			parts.push_back(part);
+		}
+
+		start = end + 1;
+	}
+
+	std::wstring full;
+
+	for(auto &part : parts) full += L"/" + part;
+
+	if(full.empty()) full = L"/";
+
+	if(full.size() >= bufferLength) return static_cast<DWORD>(full.size() + 1);
+
+	wcscpy(buffer, full.c_str());
+
+	if(filePart) *filePart = buffer + full.rfind(L'/') + 1;
+
+	return static_cast<DWORD>(full.size());
+}
+
+BOOL PathRemoveFileSpecW(wchar_t *path){
+	wchar_t *slash = nullptr;
+
+	for(wchar_t *c = path; *c; c++){
+		if(*c == L'\\' || *c == L'/') slash = c;
+	}
+
+	if(!slash){
+		BOOL removed = path[0] != L'\0';
+
+		path[0] = L'\0';
+
+		return removed;
+	}
+
+	*slash = L'\0';
+
+	return TRUE;
+}
+
+int WideCharToMultiByte(UINT, DWORD, const wchar_t *wideText, int wideLength, char *text, int length, const char *, BOOL *){
+	std::string utf8 = wideLength < 0 ? ToUtf8(wideText) + '\0' : ToUtf8(wideText, wideLength);
+
+	if(!text || length == 0) return static_cast<int>(utf8.size());
+
+	if(utf8.size() > static_cast<size_t>(length)) return 0;
+
+	memcpy(text, utf8.data(), utf8.size());
+
+	return static_cast<int>(utf8.size());
+}
+
+DWORD FlsAlloc(PFLS_CALLBACK_FUNCTION callback){
+	pthread_key_t key;
+
+	return pthread_key_create(&key, callback) == 0 ? static_cast<DWORD>(key) : FLS_OUT_OF_INDEXES;
+}
+
+BOOL FlsSetValue(DWORD index, void *value){
+	return pthread_setspecific(static_cast<pthread_key_t>(index), value) == 0;
+}
+
+HRESULT CoCreateGuid(GUID *guid){
+	return getrandom(guid, sizeof(GUID), 0) == sizeof(GUID) ? S_OK : E_FAIL;
+}
+
+int StringFromGUID2(const GUID &guid, wchar_t *text, int length){
+	int written = swprintf(text, length, L"{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}", guid.Data1, guid.Data2, guid.Data3,
+		guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3], guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+
+	// Length including the terminator, 0 when it doesn't fit
+	return written < 0 ? 0 : written + 1;
+}
+
+void GetMappingStats(uint64_t &numViews, uint64_t &numBytes){
+	std::lock_guard<std::mutex> lock(g_viewMutex);
+
+	numViews = g_numViews;
+	numBytes = g_numViewBytes;
+}
+
+// Util, the parts of Util.cpp that do not need a window or a device
+namespace Util{
+
+bool ReadFileToMemory(const std::wstring &path, std::vector<uint8_t> &data){
+	std::ifstream file(ToPath(path.c_str()), std::ios::binary | std::ios::ate);
+
+	if(!file) return false;
+
+	data.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+
+	g_numFileReads++;
+	g_numFileBytesRead += data.size();
+
+	return data.empty() || file.read(reinterpret_cast<char *>(data.data()), data.size());
+}
+
+bool WriteMemoryToFile(const std::wstring &path, const void *data, size_t size){
+	std::ofstream file(ToPath(path.c_str()), std::ios::binary | std::ios::trunc);
+
+	return file && file.write(static_cast<const char *>(data), size);
+}
+
+bool ReadFileRange(const std::wstring &path, uint64_t offset, size_t size, std::vector<uint8_t> &data){
+	std::ifstream file(ToPath(path.c_str()), std::ios::binary);
+
+	if(!file.seekg(static_cast<std::streamoff>(offset))) return false;
+
+	data.resize(size);
+
+	g_numFileReads++;
+	g_numFileBytesRead += size;
+
+	return data.empty() || (file.read(reinterpret_cast<char *>(data.data()), size) && static_cast<size_t>(file.gcount()) == size);
+}
+
+void FindFiles(const std::wstring &directory, const std::wstring &pattern, std::vector<std::wstring> &files){
+	FindFilesIn(ToPath(directory.c_str()) + "/", "", ToUtf8(pattern.c_str()), files);
+}
+
+uint64_t HashFNV1a(const void *data, size_t size, uint64_t hash){
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+	for(size_t i = 0; i < size; i++){
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+void ParallelRanges(size_t count, uint32_t numThreads, const std::function<void(size_t begin, size_t end)> &func){
+	if(numThreads == 0) numThreads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+
+	numThreads = static_cast<uint32_t>(std::min<size_t>(numThreads, count));
+
+	if(numThreads <= 1){
+		func(0, count);
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	size_t perThread = (count + numThreads - 1) / numThreads;
+
+	for(size_t begin = 0; begin + perThread < count; begin += perThread){
+		threads.push_back(std::thread(func, begin, begin + perThread));
+	}
+
+	func(threads.size() * perThread, count);
+
+	for(auto &thread : threads) thread.join();
+}
+
+// No shader reflection or input layouts without D3D
+bool ReflectVertexLayout(VertexLayoutData &){
+	return false;
+}
+
+bool CreateVertexLayout(ID3D11Device *, const VertexLayoutData &, ID3D11InputLayout **){
+	return false;
+}
+
+// Without the GPU memory accounting BuildBuffer does
+bool CreateConstantBuffer(ID3D11Device *device, uint32_t size, ID3D11Buffer **constantBuffer, D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG access){
+	D3D11_BUFFER_DESC desc = {size, usage, D3D11_BIND_CONSTANT_BUFFER, static_cast<UINT>(access), 0, 0};
+
+	if(FAILED(device->CreateBuffer(&desc, nullptr, constantBuffer))) *constantBuffer = nullptr;
+
+	return *constantBuffer != nullptr;
+}
+
+}
+
+void GetFileReadStats(uint64_t &numReads, uint64_t &numBytes){
+	numReads = g_numFileReads;
+	numBytes = g_numFileBytesRead;
+}
+
+void GetHandleReadStats(uint64_t &numReads, uint64_t &numBytes){
+	numReads = g_numHandleReads;
+	numBytes = g_numHandleBytesRead;
+}
+
+// D3D11
+ID3D11DeviceChild::~ID3D11DeviceChild(){
+	for(auto &entry : m_interfaces){
+		entry.second->Release();
+	}
+}
+
+HRESULT ID3D11DeviceChild::SetPrivateDataInterface(REFGUID guid, IUnknown *object){
+	object->AddRef();
+	m_interfaces.push_back(std::make_pair(guid, object));
+
+	return S_OK;
+}
+
+HRESULT ID3D11Device::CreateBuffer(const D3D11_BUFFER_DESC *desc, const D3D11_SUBRESOURCE_DATA *, ID3D11Buffer **buffer){
+	if(buffer) *buffer = new ID3D11Buffer(*desc);
+
+	return S_OK;
+}
+
+HRESULT ID3D11Device::CreateTexture1D(const D3D11_TEXTURE1D_DESC *desc, const D3D11_SUBRESOURCE_DATA *, ID3D11Texture1D **texture){
+	if(texture) *texture = new ID3D11Texture1D(*desc);
+
+	return S_OK;
+}
+
+HRESULT ID3D11Device::CreateTexture2D(const D3D11_TEXTURE2D_DESC *desc, const D3D11_SUBRESOURCE_DATA *, ID3D11Texture2D **texture){
+	if(texture) *texture = new ID3D11Texture2D(*desc);
+
+	return S_OK;
+}
+
+HRESULT ID3D11Device::CreateTexture3D(const D3D11_TEXTURE3D_DESC *desc, const D3D11_SUBRESOURCE_DATA *, ID3D11Texture3D **texture){
+	if(texture) *texture = new ID3D11Texture3D(*desc);
+
+	return S_OK;
+}
+
+HRESULT ID3D11Device::CreateShaderResourceView(ID3D11Resource *resource, const D3D11_SHADER_RESOURCE_VIEW_DESC *desc,
+	ID3D11ShaderResourceView **view){
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+
+	if(desc){
+		viewDesc = *desc;
+	}
+	else if(resource->getDimension() == D3D11_RESOURCE_DIMENSION_TEXTURE2D){
+		const D3D11_TEXTURE2D_DESC &textureDesc = static_cast<ID3D11Texture2D *>(resource)->desc;
+
+		viewDesc.Format				= textureDesc.Format;
+		viewDesc.ViewDimension		= D3D11_SRV_DIMENSION_TEXTURE2D;
+		viewDesc.Texture2D.MipLevels	= textureDesc.MipLevels;
+	}
+
+	if(view) *view = new ID3D11ShaderResourceView(resource, viewDesc);
+
+	return S_OK;
+}
+
+HRESULT ID3D11Device::CreateUnorderedAccessView(ID3D11Resource *resource, const D3D11_UNORDERED_ACCESS_VIEW_DESC *,
+	ID3D11UnorderedAccessView **view){
+
+	if(view) *view = new ID3D11UnorderedAccessView(resource);
+
+	return S_OK;
+}
+
+HRESULT ID3D11Device::CreateQuery(const D3D11_QUERY_DESC *desc, ID3D11Query **query){
+	if(query) *query = new ID3D11Query(*desc);
+
+	return S_OK;
+}
+
+HRESULT ID3D11Device::CheckFormatSupport(DXGI_FORMAT, UINT *support){
+	*support = D3D11_FORMAT_SUPPORT_TEXTURE2D;
+
+	return S_OK;
+}
+
+D3D_FEATURE_LEVEL ID3D11Device::GetFeatureLevel(){
+	return D3D_FEATURE_LEVEL_11_0;
+}
+
+// D3DCompiler
+HRESULT D3DCompile(const void *, size_t, const char *, const D3D_SHADER_MACRO *, ID3DInclude *, const char *, const char *, UINT, UINT,
+	ID3DBlob **code, ID3DBlob **errorMsgs){
+
+	if(code)		*code		= nullptr;
+	if(errorMsgs)	*errorMsgs	= nullptr;
+
+	return E_NOTIMPL;
+}
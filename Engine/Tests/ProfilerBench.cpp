@@ -0,0 +1,139 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+const uint32_t NumCalls		= 10000000;
+const uint32_t NumFrames	= 100;
+
+// Written by the measured functions so they don't fold away
+volatile uint32_t g_sink;
+
+// Kept out of line so every call pays the same call overhead, with and without a zone
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+BENCH_NOINLINE void Bare(){
+	g_sink = 0;
+}
+
+BENCH_NOINLINE void Zone(){
+	PROFILE_ZONE("Zone");
+	g_sink = 0;
+}
+
+BENCH_NOINLINE void CycleCounter(){
+	g_sink = static_cast<uint32_t>(ReadCycleCounter());
+}
+
+BENCH_NOINLINE void NestedZones(){
+	PROFILE_ZONE("Outer");
+
+	{
+		PROFILE_ZONE("Middle");
+
+		{
+			PROFILE_ZONE("Inner");
+			g_sink = 0;
+		}
+	}
+}
+
+// Nanoseconds per call, drained every so often like frames would so the ring never wraps
+double NsPerCall(void (*func)()){
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumCalls; i++){
+		func();
+
+		if((i & 4095) == 4095){
+			Test::Clock::time_point drainStart = Test::Clock::now();
+
+			Profiler::endFrame();
+
+			start += Test::Clock::now() - drainStart;
+		}
+	}
+
+	return Test::ElapsedMs(start) * 1e6 / NumCalls;
+}
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	Profiler::setThreadName("Main");
+
+	// Best of three for each
+	double bare = DBL_MAX, counter = DBL_MAX, zone = DBL_MAX, nested = DBL_MAX, disabled = DBL_MAX;
+
+	for(int round = 0; round < 3; round++){
+		bare	= std::min(bare, NsPerCall(Bare));
+		counter	= std::min(counter, NsPerCall(CycleCounter));
+		zone	= std::min(zone, NsPerCall(Zone));
+		nested	= std::min(nested, NsPerCall(NestedZones));
+
+		Profiler::setEnabled(false);
+		disabled = std::min(disabled, NsPerCall(Zone));
+		Profiler::setEnabled(true);
+	}
+
+	// A zone reads the cycle counter twice, under some hypervisors that read alone is most of the cost
+	std::printf("empty call %.2f ns, cycle counter read %.2f ns\n", bare, counter - bare);
+	std::printf("zone overhead %.2f ns, per nested zone %.2f ns, disabled %.2f ns\n", zone - bare, (nested - bare) / 3.0,
+		std::max(0.0, disabled - bare));
+
+	// Threads recording at once share nothing but the registration, so the total rate should scale with cores
+	const uint32_t threadCounts[] = {1, 2, 4, 8};
+
+	for(uint32_t numThreads : threadCounts){
+		std::vector<std::thread> threads;
+		Test::Clock::time_point start = Test::Clock::now();
+
+		// Nobody drains meanwhile, the rings wrap and keep the newest zones
+		for(uint32_t t = 0; t < numThreads; t++){
+			threads.push_back(std::thread([]{
+				for(uint32_t i = 0; i < NumCalls / 4; i++) Zone();
+			}));
+		}
+
+		for(auto &thread : threads) thread.join();
+
+		double ms = Test::ElapsedMs(start);
+
+		std::printf("%u threads %7.1f M zones/s in total\n", numThreads, numThreads * (NumCalls / 4) / (ms * 1000.0));
+	}
+
+	// endFrame() with a frame's worth of zones from the main thread
+	const uint32_t zonesPerFrame[] = {100, 1000, 10000};
+
+	Profiler::endFrame();
+
+	for(uint32_t numZones : zonesPerFrame){
+		double drainMs = 0.0;
+
+		for(uint32_t frame = 0; frame < NumFrames; frame++){
+			for(uint32_t i = 0; i < numZones; i++) Zone();
+
+			Test::Clock::time_point start = Test::Clock::now();
+
+			Profiler::endFrame();
+
+			drainMs += Test::ElapsedMs(start);
+		}
+
+		std::printf("endFrame with %5u zones %8.1f us\n", numZones, drainMs * 1000.0 / NumFrames);
+	}
+
+	std::vector<ProfileZoneStats> stats;
+
+	Profiler::getStats(stats);
+
+	if(stats.empty()) Test::g_failures++;
+
+	return Test::g_failures ? 1 : 0;
+}
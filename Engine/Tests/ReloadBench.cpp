@@ -0,0 +1,130 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+namespace{
+
+const uint32_t NumReloads	= 200;
+const uint32_t NumVariants	= 8;
+const uint32_t Size			= 512;
+const uint32_t MipCount		= 10;
+
+// Keeps the stand-in compiles from being optimized away
+volatile float g_compileSink;
+
+// About as long as a small shader takes to compile
+bool Compile(){
+	float x = 1.0f;
+
+	for(int i = 0; i < 200000; i++) x = sqrtf(x * 1.0001f + 1.0f);
+
+	g_compileSink = x;
+
+	return true;
+}
+
+// What the texture reload in Main.cpp does: read and check the file on a worker, create the texture on the
+// calling thread and swap it in
+bool ReloadTexture(AssetLoader &loader, ID3D11Device *device, const std::wstring &path){
+	ID3D11Resource *texture = nullptr;
+
+	loader.load(path, [](const AssetLoader::Data &data){
+		return data.size > Test::DDSHeaderSize;
+	},
+	[device, &texture](const AssetLoader::Data &data){
+		DirectX::CreateDDSTextureFromMemory(device, data.bytes, data.size, &texture, nullptr);
+	});
+
+	bool loaded = loader.finalize() == 0 && texture;
+
+	ReleaseCOM(texture);
+
+	return loaded;
+}
+
+// What a material shader reload does, every permutation compiled at once
+bool ReloadVariants(AssetLoader &loader){
+	uint32_t numCompiled = 0;
+
+	for(uint32_t i = 0; i < NumVariants; i++){
+		loader.run([](const AssetLoader::Data &){ return Compile(); }, [&numCompiled](const AssetLoader::Data &){ numCompiled++; });
+	}
+
+	return loader.finalize() == 0 && numCompiled == NumVariants;
+}
+
+struct Latency{
+	double averageMs, maxMs;
+};
+
+template<typename Func>
+Latency Measure(Func &&reload){
+	Latency latency = {0.0, 0.0};
+
+	for(uint32_t i = 0; i < NumReloads; i++){
+		Test::Clock::time_point start = Test::Clock::now();
+
+		if(!reload()) Test::g_failures++;
+
+		double ms = Test::ElapsedMs(start);
+
+		latency.averageMs	+= ms / NumReloads;
+		latency.maxMs		= std::max(latency.maxMs, ms);
+	}
+
+	return latency;
+}
+
+void Report(const char *name, const Latency &latency){
+	std::printf("%-36s %8.3f ms average, %8.3f ms worst\n", name, latency.averageMs, latency.maxMs);
+}
+
+}
+
+int Test::g_failures = 0;
+
+// Single reloads the way they used to run, on a loader with threads of its own, against the same on the
+// job system the frame already runs on
+int main(){
+	uint32_t numCores = std::max<uint32_t>(2, std::thread::hardware_concurrency());
+	Test::TempDirectory directory;
+	std::wstring path = directory.wideFile("texture.dds");
+	std::vector<uint8_t> file = Test::MakeDDSFile(DXGI_FORMAT_R8G8B8A8_UNORM, Size, Size, 1, MipCount, 1);
+
+	if(!Util::WriteMemoryToFile(path, file.data(), file.size())) Test::g_failures++;
+
+	ID3D11Device *device = new ID3D11Device;
+	JobSystem jobs;
+
+	std::printf("%u reloads, RGBA8 %ux%u texture with mips on a null device, %u shader variants, %u cores\n", NumReloads, Size, Size,
+		NumVariants, numCores);
+
+	Report("Texture, own loader threads", Measure([&]{
+		AssetLoader loader(1, 1);
+		return ReloadTexture(loader, device, path);
+	}));
+
+	Report("Texture, job system", Measure([&]{
+		AssetLoader loader(jobs);
+		return ReloadTexture(loader, device, path);
+	}));
+
+	Report("Shader variants, own loader threads", Measure([&]{
+		AssetLoader loader(1, numCores - 1);
+		return ReloadVariants(loader);
+	}));
+
+	Report("Shader variants, job system", Measure([&]{
+		AssetLoader loader(jobs);
+		return ReloadVariants(loader);
+	}));
+
+	// A file that's gone fails the reload without getting stuck
+	AssetLoader loader(jobs);
+
+	if(ReloadTexture(loader, device, directory.wideFile("missing.dds"))) Test::g_failures++;
+
+	device->Release();
+
+	return Test::g_failures ? 1 : 0;
+}
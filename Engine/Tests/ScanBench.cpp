@@ -0,0 +1,104 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+#include <sys/stat.h>
+
+namespace{
+
+const uint32_t NumFiles		= 4000;
+const uint32_t NumFolders	= 16;
+const uint32_t NumRounds	= 5;
+
+struct FileDesc{
+	DXGI_FORMAT format;
+	uint32_t width, height, mipCount;
+};
+
+// A texture folder's mix of block compressed and uncompressed, square and not, with and without mips
+FileDesc MakeDesc(Test::Random &random){
+	const DXGI_FORMAT formats[] = {DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM_SRGB,
+		DXGI_FORMAT_R8G8B8A8_UNORM};
+
+	FileDesc desc;
+
+	desc.format		= formats[random.range(0u, 5u)];
+	desc.width		= 1u << random.range(6u, 13u);
+	desc.height		= random.range(0u, 4u) ? desc.width : desc.width / 2;
+	desc.mipCount	= random.range(0u, 5u) ? static_cast<uint32_t>(MipGenerator::GetMipCount(desc.width, desc.height)) : 1;
+
+	return desc;
+}
+
+uint64_t HandleBytesRead(){
+	uint64_t numReads, numBytes;
+
+	GetHandleReadStats(numReads, numBytes);
+
+	return numBytes;
+}
+
+}
+
+int Test::g_failures = 0;
+
+// Scans a directory of 4000 synthetic textures spread over 16 folders for their headers, the way the -scan tool
+// builds the manifest, on one thread and on every core. The bit data is left as holes in sparse files since the
+// scan never reads it, so this measures opening files and parsing headers with the directory in the page cache
+int main(){
+	Test::TempDirectory directory;
+	Test::Random random(7);
+	std::vector<FileDesc> descs(NumFiles);
+	uint64_t totalBytes = 0;
+
+	for(uint32_t i = 0; i < NumFolders; i++) mkdir(directory.file("folder" + std::to_string(i)).c_str(), 0755);
+
+	for(uint32_t i = 0; i < NumFiles; i++){
+		FileDesc &desc = descs[i];
+
+		desc = MakeDesc(random);
+
+		std::string name = "folder" + std::to_string(i % NumFolders) + "/texture" + std::to_string(i) + ".dds";
+		uint64_t size = Test::GetDDSFileSize(desc.format, desc.width, desc.height, 1, desc.mipCount, 1);
+
+		if(!Test::WriteSparseDDSFile(directory.file(name), Test::MakeDDSHeaders(desc.format, desc.width, desc.height, 1, desc.mipCount, 1),
+			size, size, size)){
+			std::printf("Failed to write %s\n", name.c_str());
+			return 1;
+		}
+
+		totalBytes += size - Test::DDSHeaderSize;
+	}
+
+	std::printf("%u files in %u folders, %.1f MB of bit data\n", NumFiles, NumFolders, totalBytes / (1024.0 * 1024.0));
+
+	const uint32_t threadCounts[] = {1, 0};
+	std::wstring path = directory.wideFile("");
+
+	for(uint32_t numThreads : threadCounts){
+		double ms = 0.0, statsSeconds = 0.0;
+		uint64_t headerBytes = 0;
+
+		for(uint32_t round = 0; round < NumRounds; round++){
+			std::vector<TextureManifestEntry> entries;
+			TextureScanStats stats;
+			uint64_t bytesBefore = HandleBytesRead();
+			Test::Clock::time_point start = Test::Clock::now();
+
+			ScanTextureDirectory(path, entries, stats, numThreads);
+
+			ms += Test::ElapsedMs(start);
+			statsSeconds += stats.seconds;
+			headerBytes += HandleBytesRead() - bytesBefore;
+
+			// Every file parsed and describes the bit data it was made with
+			if(stats.numFiles != NumFiles || stats.numFailed != 0 || stats.totalBytes != totalBytes) Test::g_failures++;
+		}
+
+		std::printf("%-11s %8.2f ms/scan %9.0f files/s (stats %9.0f files/s) %7.3f MB of headers read, %.0f bytes/file\n",
+			numThreads ? "1 thread" : "Every core", ms / NumRounds, NumFiles * NumRounds / (ms / 1000.0), NumFiles * NumRounds / statsSeconds,
+			headerBytes / NumRounds / (1024.0 * 1024.0), static_cast<double>(headerBytes) / (NumFiles * NumRounds));
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,278 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+namespace{
+
+const uint64_t Salt = 1;
+
+// Stands in for D3DCompile: the bytecode is the source followed by the define names, so it changes with both
+std::atomic<uint32_t> g_numCompiles(0);
+
+bool StubCompile(const ShaderDesc &desc, const std::vector<uint8_t> &source, std::vector<uint8_t> &bytecode){
+	g_numCompiles++;
+
+	bytecode = source;
+
+	for(const auto &define : desc.defines) bytecode.insert(bytecode.end(), define.name.begin(), define.name.end());
+
+	return true;
+}
+
+// Vertex shaders get two elements, the second one with a semantic index so it has to survive the disk
+bool StubReflect(const ShaderDesc &desc, CompiledShader &shader){
+	if(desc.profile != "vs_5_0") return true;
+
+	D3D11_INPUT_ELEMENT_DESC position = {nullptr, 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0};
+	D3D11_INPUT_ELEMENT_DESC texcoord = {nullptr, 3, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0};
+
+	shader.semanticNames.push_back("POSITION");
+	shader.semanticNames.push_back("TEXCOORD");
+	shader.elements.push_back(position);
+	shader.elements.push_back(texcoord);
+
+	return true;
+}
+
+struct Fixture{
+	Test::TempDirectory directory;
+	ShaderDesc vs, ps, psMode;
+
+	Fixture(){
+		WriteSource("float4 main() : SV_Target { return 1; }");
+
+		vs.path			= directory.wideFile("shader.hlsl");
+		vs.entryPoint	= "V_Shader";
+		vs.profile		= "vs_5_0";
+
+		ps.path			= vs.path;
+		ps.entryPoint	= "P_Shader";
+		ps.profile		= "ps_5_0";
+
+		ShaderDefine mode = {"MODE", "1"};
+
+		psMode = ps;
+		psMode.defines.push_back(mode);
+	}
+
+	void WriteSource(const std::string &source){
+		Util::WriteMemoryToFile(directory.wideFile("shader.hlsl"), source.data(), source.size());
+	}
+
+	std::wstring cacheDirectory() const{
+		return directory.wideFile("cache");
+	}
+
+	// The cache files written so far
+	std::vector<std::wstring> cacheFiles() const{
+		std::vector<std::wstring> files;
+
+		Util::FindFiles(cacheDirectory(), L"*.shc", files);
+
+		return files;
+	}
+};
+
+std::vector<uint8_t> ToBytes(const std::string &text){
+	return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// Everything that changes the bytecode changes the key
+void TestKeys(){
+	Fixture fixture;
+	ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+	ShaderCache otherSalt(fixture.cacheDirectory(), StubCompile, StubReflect, Salt + 1);
+	std::vector<uint8_t> source = ToBytes("source");
+
+	uint64_t key = cache.computeKey(fixture.ps, source);
+
+	CHECK(key == cache.computeKey(fixture.ps, source));
+	CHECK(key != cache.computeKey(fixture.psMode, source));
+	CHECK(key != cache.computeKey(fixture.ps, ToBytes("source ")));
+	CHECK(key != otherSalt.computeKey(fixture.ps, source));
+
+	ShaderDesc desc = fixture.ps;
+
+	desc.entryPoint = "Other";
+	CHECK(key != cache.computeKey(desc, source));
+
+	desc = fixture.ps;
+	desc.profile = "ps_4_0";
+	CHECK(key != cache.computeKey(desc, source));
+
+	// Fields can't run into each other
+	desc = fixture.ps;
+	desc.entryPoint	= "P_Shaderp";
+	desc.profile	= "s_5_0";
+	CHECK(key != cache.computeKey(desc, source));
+
+	// Define values and their order count
+	ShaderDesc modeTwo = fixture.psMode;
+	modeTwo.defines[0].value = "2";
+	CHECK(cache.computeKey(fixture.psMode, source) != cache.computeKey(modeTwo, source));
+
+	ShaderDefine a = {"A", ""}, b = {"B", ""};
+	ShaderDesc ab = fixture.ps, ba = fixture.ps;
+
+	ab.defines.push_back(a);
+	ab.defines.push_back(b);
+	ba.defines.push_back(b);
+	ba.defines.push_back(a);
+	CHECK(cache.computeKey(ab, source) != cache.computeKey(ba, source));
+}
+
+// Misses compile and write a file, repeats come from memory
+void TestMemoryHits(){
+	Fixture fixture;
+	ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+	std::shared_ptr<const CompiledShader> first, second;
+	uint32_t compilesBefore = g_numCompiles;
+
+	CHECK(cache.get(fixture.vs, first));
+	CHECK(cache.get(fixture.vs, second));
+	CHECK(first == second);
+	CHECK(first && first->elements.size() == 2);
+	CHECK(cache.getNumCompiles() == 1 && cache.getNumMemoryHits() == 1 && cache.getNumDiskHits() == 0);
+	CHECK(g_numCompiles - compilesBefore == 1);
+	CHECK(fixture.cacheFiles().size() == 1);
+
+	// Defines make a separate entry with its own bytecode
+	CHECK(cache.get(fixture.psMode, second));
+	CHECK(second && second->bytecode != first->bytecode && second->elements.empty());
+	CHECK(fixture.cacheFiles().size() == 2);
+}
+
+// A new cache finds the bytecode and reflection on disk without compiling
+void TestDiskHits(){
+	Fixture fixture;
+
+	{
+		ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+		std::shared_ptr<const CompiledShader> shader;
+
+		CHECK(cache.get(fixture.vs, shader));
+		CHECK(cache.get(fixture.psMode, shader));
+	}
+
+	ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+	std::shared_ptr<const CompiledShader> shader;
+	std::vector<uint8_t> expected;
+
+	CHECK(cache.get(fixture.vs, shader));
+	CHECK(cache.getNumDiskHits() == 1 && cache.getNumCompiles() == 0);
+
+	if(shader){
+		StubCompile(fixture.vs, ToBytes("float4 main() : SV_Target { return 1; }"), expected);
+
+		CHECK(shader->bytecode == expected);
+		CHECK(shader->semanticNames.size() == 2 && shader->semanticNames[0] == "POSITION" && shader->semanticNames[1] == "TEXCOORD");
+		CHECK(shader->elements.size() == 2 && shader->elements[1].SemanticIndex == 3 && shader->elements[1].Format == DXGI_FORMAT_R32G32_FLOAT);
+		CHECK(shader->elements[0].AlignedByteOffset == D3D11_APPEND_ALIGNED_ELEMENT);
+	}
+
+	CHECK(cache.get(fixture.psMode, shader));
+	CHECK(shader && shader->elements.empty());
+	CHECK(cache.getNumDiskHits() == 2 && cache.getNumCompiles() == 0);
+}
+
+// Editing the source, changing the compiler or damaging a file all end in a compile
+void TestInvalidation(){
+	Fixture fixture;
+	std::shared_ptr<const CompiledShader> shader;
+
+	{
+		ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+
+		CHECK(cache.get(fixture.vs, shader));
+	}
+
+	{
+		ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt + 1);
+
+		CHECK(cache.get(fixture.vs, shader));
+		CHECK(cache.getNumCompiles() == 1);
+	}
+
+	fixture.WriteSource("float4 main() : SV_Target { return 0; }");
+
+	{
+		ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+
+		CHECK(cache.get(fixture.vs, shader));
+		CHECK(cache.getNumCompiles() == 1);
+	}
+
+	// Truncate every file by a byte
+	for(auto &file : fixture.cacheFiles()){
+		std::vector<uint8_t> data;
+		std::wstring path = fixture.cacheDirectory() + L"\\" + file;
+
+		CHECK(Util::ReadFileToMemory(path, data) && !data.empty());
+
+		data.pop_back();
+		Util::WriteMemoryToFile(path, data.data(), data.size());
+	}
+
+	{
+		ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+
+		CHECK(cache.get(fixture.vs, shader));
+		CHECK(cache.getNumCompiles() == 1 && cache.getNumDiskHits() == 0);
+	}
+
+	// And the rewritten file is good again
+	ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+
+	CHECK(cache.get(fixture.vs, shader));
+	CHECK(cache.getNumCompiles() == 0 && cache.getNumDiskHits() == 1);
+}
+
+// Workers asking for the same shaders all get the same result
+void TestThreads(){
+	Fixture fixture;
+	ShaderCache cache(fixture.cacheDirectory(), StubCompile, StubReflect, Salt);
+	std::vector<std::thread> threads;
+	std::atomic<uint32_t> numFailed(0);
+
+	for(uint32_t i = 0; i < 8; i++){
+		threads.push_back(std::thread([&, i]{
+			std::shared_ptr<const CompiledShader> shader;
+
+			if(!cache.get(i % 2 ? fixture.vs : fixture.psMode, shader) || !shader) numFailed++;
+		}));
+	}
+
+	for(auto &thread : threads) thread.join();
+
+	std::shared_ptr<const CompiledShader> vs, psMode;
+
+	CHECK(numFailed == 0);
+	CHECK(cache.get(fixture.vs, vs) && cache.get(fixture.psMode, psMode));
+	CHECK(vs && psMode && vs->elements.size() == 2 && psMode->elements.empty());
+	CHECK(cache.getNumMemoryHits() + cache.getNumDiskHits() + cache.getNumCompiles() == 10);
+}
+
+// Failures are reported and nothing is written for them
+void TestFailures(){
+	Fixture fixture;
+	std::shared_ptr<const CompiledShader> shader;
+
+	// D3DCompile isn't available here
+	ShaderCache d3dCache(fixture.cacheDirectory());
+
+	CHECK(!d3dCache.get(fixture.ps, shader));
+
+	ShaderCache cache(fixture.cacheDirectory(), [](const ShaderDesc &, const std::vector<uint8_t> &, std::vector<uint8_t> &){ return false; },
+		StubReflect, Salt);
+	ShaderDesc missing = fixture.ps;
+
+	missing.path = fixture.directory.wideFile("missing.hlsl");
+
+	CHECK(!cache.get(fixture.ps, shader));
+	CHECK(!cache.get(missing, shader));
+	CHECK(fixture.cacheFiles().empty());
+}
+
+}
+
+TEST_MAIN(TestKeys, TestMemoryHits, TestDiskHits, TestInvalidation, TestThreads, TestFailures)
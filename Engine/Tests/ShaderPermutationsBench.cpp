@@ -0,0 +1,103 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+namespace{
+
+const uint32_t NumSwitches	= 10000000;
+const uint32_t NumResolves	= 100000;
+
+const char *LightingKeywords[] = {"COOK_TORRANCE_1", "COOK_TORRANCE_2", "COOK_TORRANCE_3", "COOK_TORRANCE_4", "NO_LIGHTING"};
+
+// Keeps the loops from being optimized away
+volatile size_t g_sink;
+
+}
+
+int Test::g_failures = 0;
+
+// The material permutations Main.cpp declares. Switching a keyword and picking the variant from the table, as
+// HandleKeyInput does, against building the description and going through the shader cache on every switch
+int main(){
+	Test::TempDirectory directory;
+	std::string source = "float4 P_Shader() : SV_Target { return 1; }";
+
+	Util::WriteMemoryToFile(directory.wideFile("Material_PS.hlsl"), source.data(), source.size());
+
+	ShaderDesc base;
+
+	base.path		= directory.wideFile("Material_PS.hlsl");
+	base.entryPoint	= "P_Shader";
+	base.profile	= "ps_5_0";
+
+	ShaderPermutations permutations(base);
+
+	permutations.addKeywordGroup(std::vector<std::string>(LightingKeywords, LightingKeywords + 5));
+	permutations.addKeywordGroup({"TILED_LIGHTS", "CLUSTERED_LIGHTS"});
+
+	std::string keywords[6];
+
+	for(uint32_t i = 0; i < 5; i++) keywords[i] = LightingKeywords[i];
+
+	keywords[5] = "CLUSTERED_LIGHTS";
+
+	// Startup: every valid variant compiled once into the table
+	ShaderCache cache(directory.wideFile("cache"), [](const ShaderDesc &, const std::vector<uint8_t> &source, std::vector<uint8_t> &bytecode){
+		bytecode = source;
+		return true;
+	}, [](const ShaderDesc &, CompiledShader &){ return true; }, 0);
+
+	std::vector<std::shared_ptr<const CompiledShader>> table(permutations.getNumVariants());
+	uint32_t numVariants = 0;
+	Test::Clock::time_point start = Test::Clock::now();
+
+	for(uint32_t mask = 0; mask < permutations.getNumVariants(); mask++){
+		if(!permutations.isValid(mask)) continue;
+
+		if(!cache.get(permutations.getDesc(mask), table[mask])) Test::g_failures++;
+
+		numVariants++;
+	}
+
+	double startupMs = Test::ElapsedMs(start);
+
+	std::printf("%u valid variants of %u, built in %.2f ms with a stub compiler\n", numVariants, permutations.getNumVariants(), startupMs);
+
+	// Keyword switch plus table lookup
+	uint32_t mask = 0;
+	size_t sink = 0;
+
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumSwitches; i++){
+		mask = permutations.setKeyword(mask, keywords[i % 6]);
+		sink += reinterpret_cast<size_t>(table[mask].get());
+	}
+
+	double switchMs = Test::ElapsedMs(start);
+
+	// Keyword switch plus description and cache lookup
+	mask = 0;
+	start = Test::Clock::now();
+
+	for(uint32_t i = 0; i < NumResolves; i++){
+		std::shared_ptr<const CompiledShader> shader;
+
+		mask = permutations.setKeyword(mask, keywords[i % 6]);
+
+		if(!cache.get(permutations.getDesc(mask), shader)) Test::g_failures++;
+
+		sink += reinterpret_cast<size_t>(shader.get());
+	}
+
+	double resolveMs = Test::ElapsedMs(start);
+
+	g_sink = sink;
+
+	if(cache.getNumCompiles() != numVariants) Test::g_failures++;
+
+	std::printf("switch + table lookup %10.1f ns\n", switchMs * 1e6 / NumSwitches);
+	std::printf("switch + cache lookup %10.1f ns\n", resolveMs * 1e6 / NumResolves);
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+#include "Engine.h"
+#include "Test.h"
+
+namespace{
+
+ShaderDesc MaterialDesc(){
+	ShaderDesc desc;
+
+	desc.path		= L"Material_PS.hlsl";
+	desc.entryPoint	= "P_Shader";
+	desc.profile	= "ps_5_0";
+
+	return desc;
+}
+
+// Five lighting models take three bits, leaving three invalid values in their field
+void TestMasks(){
+	ShaderPermutations permutations(MaterialDesc());
+
+	CHECK(permutations.getNumVariants() == 1);
+	CHECK(permutations.addKeywordGroup({"COOK_TORRANCE_1", "COOK_TORRANCE_2", "COOK_TORRANCE_3", "COOK_TORRANCE_4", "NO_LIGHTING"}));
+	CHECK(permutations.addKeywordGroup({"", "SHADOWS"}));
+	CHECK(permutations.getNumVariants() == 16);
+
+	uint32_t numValid = 0;
+
+	for(uint32_t mask = 0; mask < permutations.getNumVariants(); mask++) numValid += permutations.isValid(mask);
+
+	CHECK(numValid == 10);
+	CHECK(!permutations.isValid(permutations.getNumVariants()));
+
+	// Switching a keyword only touches its own group
+	uint32_t mask = permutations.setKeyword(0, "NO_LIGHTING");
+	CHECK(mask == 4);
+
+	mask = permutations.setKeyword(mask, "SHADOWS");
+	CHECK(mask == 12);
+
+	mask = permutations.setKeyword(mask, "COOK_TORRANCE_2");
+	CHECK(mask == 9);
+
+	CHECK(permutations.setKeyword(mask, "BOGUS") == mask);
+	CHECK(permutations.setKeyword(mask, "") == mask);
+}
+
+// Keywords appear in group order and empty options define nothing
+void TestDescs(){
+	ShaderPermutations permutations(MaterialDesc());
+
+	CHECK(permutations.addKeywordGroup({"COOK_TORRANCE_1", "COOK_TORRANCE_2", "COOK_TORRANCE_3", "COOK_TORRANCE_4", "NO_LIGHTING"}));
+	CHECK(permutations.addKeywordGroup({"", "SHADOWS"}));
+
+	ShaderDesc desc = permutations.getDesc(9);
+
+	CHECK(desc.path == L"Material_PS.hlsl" && desc.entryPoint == "P_Shader" && desc.profile == "ps_5_0");
+	CHECK(desc.defines.size() == 2);
+
+	if(desc.defines.size() == 2){
+		CHECK(desc.defines[0].name == "COOK_TORRANCE_2" && desc.defines[0].value == "1");
+		CHECK(desc.defines[1].name == "SHADOWS");
+	}
+
+	desc = permutations.getDesc(0);
+	CHECK(desc.defines.size() == 1 && desc.defines[0].name == "COOK_TORRANCE_1");
+
+	// Every valid variant has its own set of defines
+	std::vector<std::string> seen;
+
+	for(uint32_t mask = 0; mask < permutations.getNumVariants(); mask++){
+		if(!permutations.isValid(mask)) continue;
+
+		std::string defines;
+
+		for(auto &define : permutations.getDesc(mask).defines) defines += define.name + ";";
+
+		CHECK(std::find(seen.begin(), seen.end(), defines) == seen.end());
+		seen.push_back(defines);
+	}
+}
+
+// Keywords can't be declared twice and the mask stays within 16 bits
+void TestLimits(){
+	ShaderPermutations permutations(MaterialDesc());
+
+	CHECK(permutations.addKeywordGroup({"", "SHADOWS"}));
+	CHECK(!permutations.addKeywordGroup({"SHADOWS"}));
+	CHECK(!permutations.addKeywordGroup({}));
+	CHECK(permutations.getNumVariants() == 2);
+
+	for(uint32_t i = 0; i < 15; i++){
+		std::string name = "KEYWORD_" + std::to_string(i);
+
+		CHECK(permutations.addKeywordGroup({"", name}));
+	}
+
+	CHECK(permutations.getNumVariants() == 65536);
+	CHECK(!permutations.addKeywordGroup({"", "ONE_TOO_MANY"}));
+	CHECK(permutations.setKeyword(0, "ONE_TOO_MANY") == 0);
+}
+
+}
+
+TEST_MAIN(TestMasks, TestDescs, TestLimits)
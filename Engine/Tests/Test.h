@@ -0,0 +1,64 @@
+#pragma once
+
+//////////////////
+// Test helpers //
+//////////////////
+
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+
+namespace Test{
+
+extern int g_failures;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+inline double ElapsedMs(Clock::time_point start){
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Xorshift, the same sequence on every platform
+struct Random{
+	uint32_t state;
+
+	explicit Random(uint32_t seed) : state(seed ? seed : 1){}
+
+	uint32_t next(){
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		return state;
+	}
+
+	// [min, max)
+	uint32_t range(uint32_t min, uint32_t max){
+		return min + next() % (max - min);
+	}
+
+	float range(float min, float max){
+		return min + (max - min) * (next() >> 8) * (1.0f / 16777216.0f);
+	}
+};
+
+}
+
+// Failures are counted and reported, the test keeps going so one run shows every problem
+#define CHECK(cond) \
+	do{ \
+		if(!(cond)){ \
+			std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+			Test::g_failures++; \
+		} \
+	} while(0)
+
+// Defines the failure counter and a main that runs the test functions in order
+#define TEST_MAIN(...) \
+	int Test::g_failures = 0; \
+	int main(){ \
+		void (*tests[])() = {__VA_ARGS__}; \
+		for(auto test : tests) test(); \
+		if(Test::g_failures) std::printf("%d check(s) failed\n", Test::g_failures); \
+		return Test::g_failures ? 1 : 0; \
+	}
@@ -0,0 +1,160 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+namespace{
+
+const DXGI_FORMAT Format	= DXGI_FORMAT_BC1_UNORM;
+const uint32_t NumFiles		= 32;
+const uint32_t Size			= 2048;
+const uint32_t MipCount		= 12;
+const uint32_t NumRounds	= 3;
+
+uint64_t FileBytesRead(){
+	uint64_t numReads, numBytes;
+
+	GetFileReadStats(numReads, numBytes);
+
+	return numBytes;
+}
+
+// Read every byte they are given, like a driver copying the data would
+class TouchingDevice : public ID3D11Device{
+public:
+	uint64_t sum;
+
+	TouchingDevice() : sum(0){}
+
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC *desc, const D3D11_SUBRESOURCE_DATA *initialData, ID3D11Texture2D **texture){
+		for(UINT i = 0; initialData && i < desc->MipLevels * desc->ArraySize; i++){
+			const uint8_t *bytes = static_cast<const uint8_t *>(initialData[i].pSysMem);
+
+			for(UINT b = 0; b < initialData[i].SysMemSlicePitch; b += 64) sum += bytes[b];
+		}
+
+		return ID3D11Device::CreateTexture2D(desc, initialData, texture);
+	}
+};
+
+class TouchingContext : public ID3D11DeviceContext{
+public:
+	uint64_t sum;
+
+	TouchingContext() : sum(0){}
+
+	void UpdateSubresource(ID3D11Resource *, UINT, const D3D11_BOX *, const void *data, UINT, UINT depthPitch){
+		const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+		for(UINT b = 0; b < depthPitch; b += 64) sum += bytes[b];
+	}
+};
+
+// Drops the file from the page cache so the next access has to go to the disk
+void Evict(const std::string &path){
+	int fd = open(path.c_str(), O_RDONLY);
+
+	if(fd < 0) return;
+
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+// Loads every texture and streams them all to full detail
+double LoadAndStream(const std::vector<std::wstring> &paths, const TexturePack *pack){
+	TouchingDevice *device = new TouchingDevice;
+	TouchingContext *context = new TouchingContext;
+	Test::Clock::time_point start = Test::Clock::now();
+
+	{
+		TextureStreamer streamer(device, context, 1024 * 1024 * 1024, 64);
+		std::vector<StreamedTextureHandle> handles;
+
+		streamer.setTexturePack(pack);
+
+		for(auto &path : paths){
+			handles.push_back(streamer.load(path));
+
+			if(handles.back() == TextureStreamer::InvalidHandle) Test::g_failures++;
+		}
+
+		bool resident = false;
+
+		for(int frame = 0; frame < 100000 && !resident; frame++){
+			resident = true;
+
+			for(auto handle : handles){
+				streamer.requestDetail(handle, static_cast<float>(Size));
+				resident = resident && streamer.getResidentMip(handle) == 0;
+			}
+
+			streamer.update();
+
+			if(!resident) std::this_thread::yield();
+		}
+
+		if(!resident) Test::g_failures++;
+	}
+
+	double ms = Test::ElapsedMs(start);
+
+	context->Release();
+	device->Release();
+
+	return ms;
+}
+
+}
+
+int Test::g_failures = 0;
+
+int main(){
+	Test::TempDirectory directory;
+	std::vector<std::wstring> paths;
+	std::vector<std::string> files;
+	std::vector<uint8_t> file = Test::MakeDDSFile(Format, Size, Size, 1, MipCount, 1);
+
+	for(uint32_t i = 0; i < NumFiles; i++){
+		std::string name = "texture" + std::to_string(i) + ".dds";
+
+		files.push_back(directory.file(name));
+		paths.push_back(directory.wideFile(name));
+		Util::WriteMemoryToFile(paths.back(), file.data(), file.size());
+	}
+
+	TexturePack pack;
+
+	if(!BuildTexturePack(directory.wideFile(""), directory.wideFile("textures.pak")) || !pack.open(directory.wideFile("textures.pak"))){
+		Test::g_failures++;
+	}
+
+	files.push_back(directory.file("textures.pak"));
+
+	std::printf("%u BC1 %ux%u files with full mip chains, %.1f MB each, loaded and streamed to full detail\n", NumFiles, Size, Size,
+		file.size() / (1024.0 * 1024.0));
+
+	for(int usePack = 0; usePack < 2; usePack++){
+		for(int cold = 1; cold >= 0; cold--){
+			double ms = 0.0;
+			uint64_t bytesBefore = FileBytesRead();
+
+			for(uint32_t round = 0; round < NumRounds; round++){
+				// Pages the pack has mapped can't be dropped, so it is reopened after evicting
+				if(cold){
+					pack.close();
+
+					for(auto &path : files) Evict(path);
+
+					if(!pack.open(directory.wideFile("textures.pak"))) Test::g_failures++;
+				}
+
+				ms += LoadAndStream(paths, usePack ? &pack : nullptr);
+			}
+
+			std::printf("%-5s %-4s %8.2f ms, %7.2f MB copied\n", usePack ? "pack" : "loose", cold ? "cold" : "warm", ms / NumRounds,
+				(FileBytesRead() - bytesBefore) / (1024.0 * 1024.0 * NumRounds));
+		}
+	}
+
+	return Test::g_failures ? 1 : 0;
+}
@@ -0,0 +1,288 @@
+#include "Engine.h"
+#include "Test.h"
+#include "DDSFiles.h"
+
+#include <chrono>
+
+namespace{
+
+const DXGI_FORMAT Format		= DXGI_FORMAT_R8G8B8A8_UNORM;
+const uint32_t Size				= 1024;
+const uint32_t MipCount			= 11;
+const size_t MinResidentSize	= 64;
+
+// 64x64 and below stay resident
+const size_t MinMip				= 4;
+
+size_t ChainBytes(size_t mip){
+	return DirectX::GetTextureMemorySize(Size >> mip, Size >> mip, 1, MipCount - mip, 1, Format);
+}
+
+// Keeps what the streamer uploaded and copied
+class RecordingContext : public ID3D11DeviceContext{
+public:
+	struct Upload{
+		UINT subresource;
+		uint64_t hash;
+		const uint8_t *data;
+	};
+
+	struct Copy{
+		UINT dstSubresource, srcSubresource;
+	};
+
+	std::vector<Upload> uploads;
+	std::vector<Copy> copies;
+
+	void UpdateSubresource(ID3D11Resource *, UINT subresource, const D3D11_BOX *, const void *data, UINT, UINT depthPitch){
+		Upload upload = {subresource, Util::HashFNV1a(data, depthPitch), static_cast<const uint8_t *>(data)};
+
+		uploads.push_back(upload);
+	}
+
+	void CopySubresourceRegion(ID3D11Resource *, UINT dstSubresource, UINT, UINT, UINT, ID3D11Resource *, UINT srcSubresource, const D3D11_BOX *){
+		Copy copy = {dstSubresource, srcSubresource};
+
+		copies.push_back(copy);
+	}
+};
+
+uint64_t FileBytesRead(){
+	uint64_t numReads, numBytes;
+
+	GetFileReadStats(numReads, numBytes);
+
+	return numBytes;
+}
+
+// Runs frames until the texture has mip as its top one, requesting full detail for it every frame
+bool StreamTo(TextureStreamer &streamer, StreamedTextureHandle handle, size_t mip){
+	for(int frame = 0; frame < 2000; frame++){
+		streamer.requestDetail(handle, static_cast<float>(Size));
+		streamer.update();
+
+		if(streamer.getResidentMip(handle) == mip) return true;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return false;
+}
+
+ID3D11Texture2D *GetTexture(TextureStreamer &streamer, StreamedTextureHandle handle){
+	ID3D11Resource *resource = nullptr;
+
+	streamer.getView(handle)->GetResource(&resource);
+	resource->Release();
+
+	return static_cast<ID3D11Texture2D *>(resource);
+}
+
+// The mips streamed in came from their place in the file and the resident ones were copied on the GPU
+void CheckUpgrade(const RecordingContext &context, size_t firstUpload, size_t firstCopy, size_t fromMip){
+	CHECK(context.uploads.size() - firstUpload == fromMip);
+	CHECK(context.copies.size() - firstCopy == MipCount - fromMip);
+
+	for(size_t i = firstUpload; i < context.uploads.size(); i++){
+		const RecordingContext::Upload &upload = context.uploads[i];
+		uint64_t offset = Test::DDSHeaderSize + ChainBytes(0) - ChainBytes(upload.subresource);
+		uint64_t size = DirectX::GetTextureMemorySize(Size >> upload.subresource, Size >> upload.subresource, 1, 1, 1, Format);
+
+		CHECK(upload.hash == Test::HashPattern(offset, size));
+	}
+
+	for(size_t i = firstCopy; i < context.copies.size(); i++){
+		CHECK(context.copies[i].dstSubresource == context.copies[i].srcSubresource + fromMip);
+	}
+}
+
+void WriteTexture(const Test::TempDirectory &directory, const std::string &name){
+	std::vector<uint8_t> file = Test::MakeDDSFile(Format, Size, Size, 1, MipCount, 1);
+
+	Util::WriteMemoryToFile(directory.wideFile(name), file.data(), file.size());
+}
+
+// Only the bytes of the missing mips are read
+void TestStreamsMissingMips(){
+	Test::TempDirectory directory;
+
+	WriteTexture(directory, "texture.dds");
+
+	ID3D11Device *device = new ID3D11Device;
+	RecordingContext *context = new RecordingContext;
+
+	{
+		TextureStreamer streamer(device, context, 64 * 1024 * 1024, MinResidentSize);
+		StreamedTextureHandle handle = streamer.load(directory.wideFile("texture.dds"));
+
+		CHECK(handle != TextureStreamer::InvalidHandle);
+		CHECK(streamer.getResidentMip(handle) == MinMip);
+		CHECK(streamer.getResidentBytes() == ChainBytes(MinMip));
+
+		uint64_t bytesBefore = FileBytesRead();
+
+		CHECK(StreamTo(streamer, handle, 0));
+		CHECK(FileBytesRead() - bytesBefore == ChainBytes(0) - ChainBytes(MinMip));
+		CHECK(streamer.getResidentBytes() == ChainBytes(0));
+
+		CheckUpgrade(*context, 0, 0, MinMip);
+
+		D3D11_TEXTURE2D_DESC desc;
+
+		GetTexture(streamer, handle)->GetDesc(&desc);
+
+		CHECK(desc.Width == Size && desc.Height == Size && desc.MipLevels == MipCount);
+	}
+
+	context->Release();
+	device->Release();
+}
+
+// Packed files are streamed out of the mapping in place, without a copy or touching the loose file
+void TestStreamsFromPack(){
+	Test::TempDirectory directory;
+
+	WriteTexture(directory, "texture.dds");
+
+	TexturePack pack;
+
+	CHECK(BuildTexturePack(directory.wideFile(""), directory.wideFile("textures.pak")));
+	CHECK(pack.open(directory.wideFile("textures.pak")));
+
+	ID3D11Device *device = new ID3D11Device;
+	RecordingContext *context = new RecordingContext;
+
+	{
+		TextureStreamer streamer(device, context, 64 * 1024 * 1024, MinResidentSize);
+
+		streamer.setTexturePack(&pack);
+
+		uint64_t bytesBefore = FileBytesRead();
+		StreamedTextureHandle handle = streamer.load(directory.wideFile("texture.dds"));
+
+		CHECK(handle != TextureStreamer::InvalidHandle);
+		CHECK(StreamTo(streamer, handle, 0));
+		CHECK(FileBytesRead() == bytesBefore);
+
+		CheckUpgrade(*context, 0, 0, MinMip);
+
+		const uint8_t *packed = nullptr;
+		size_t packedSize = 0;
+
+		CHECK(pack.find(directory.wideFile("texture.dds"), &packed, &packedSize));
+
+		for(auto &upload : context->uploads){
+			CHECK(upload.data >= packed && upload.data < packed + packedSize);
+		}
+	}
+
+	context->Release();
+	device->Release();
+}
+
+// load() fails instead of going over the budget, the low mips are never evicted to make room
+void TestLoadReservesBudget(){
+	Test::TempDirectory directory;
+
+	WriteTexture(directory, "texture.dds");
+
+	ID3D11Device *device = new ID3D11Device;
+	RecordingContext *context = new RecordingContext;
+
+	{
+		TextureStreamer streamer(device, context, ChainBytes(MinMip) - 1, MinResidentSize);
+
+		CHECK(streamer.load(directory.wideFile("texture.dds")) == TextureStreamer::InvalidHandle);
+		CHECK(streamer.getResidentBytes() == 0);
+	}
+
+	{
+		TextureStreamer streamer(device, context, ChainBytes(MinMip) * 3 / 2, MinResidentSize);
+
+		CHECK(streamer.load(directory.wideFile("texture.dds")) != TextureStreamer::InvalidHandle);
+		CHECK(streamer.load(directory.wideFile("texture.dds")) == TextureStreamer::InvalidHandle);
+		CHECK(streamer.getResidentBytes() == ChainBytes(MinMip));
+	}
+
+	context->Release();
+	device->Release();
+}
+
+// A texture that stops being used gives its top mips to one that needs them, then streams them back in
+void TestEvictionAndRestream(){
+	Test::TempDirectory directory;
+
+	WriteTexture(directory, "a.dds");
+	WriteTexture(directory, "b.dds");
+
+	ID3D11Device *device = new ID3D11Device;
+	RecordingContext *context = new RecordingContext;
+
+	{
+		size_t budget = ChainBytes(0) + ChainBytes(MinMip);
+		TextureStreamer streamer(device, context, budget, MinResidentSize);
+		StreamedTextureHandle a = streamer.load(directory.wideFile("a.dds"));
+		StreamedTextureHandle b = streamer.load(directory.wideFile("b.dds"));
+
+		CHECK(StreamTo(streamer, a, 0));
+
+		// B takes A's mips as it streams in
+		size_t firstUpload = context->uploads.size();
+
+		CHECK(StreamTo(streamer, b, 0));
+		CHECK(streamer.getResidentMip(a) == MinMip);
+		CHECK(streamer.getResidentBytes() == budget);
+
+		// Uploads are B's four mips, evicting A copied its mips down one level at a time
+		CHECK(context->uploads.size() - firstUpload == MinMip);
+
+		// And back to A, whose mips are read again since they were dropped
+		uint64_t bytesBefore = FileBytesRead();
+
+		firstUpload = context->uploads.size();
+
+		CHECK(StreamTo(streamer, a, 0));
+		CHECK(streamer.getResidentMip(b) == MinMip);
+		CHECK(FileBytesRead() - bytesBefore == ChainBytes(0) - ChainBytes(MinMip));
+		CHECK(streamer.getResidentBytes() <= budget);
+	}
+
+	context->Release();
+	device->Release();
+}
+
+// Packing builds the chain of single-mip files and leaves mipmapped ones byte for byte
+void TestPackGeneratesMips(){
+	Test::TempDirectory directory;
+	std::vector<uint8_t> single = Test::MakeDDSFile(Format, 256, 128, 1, 1, 1);
+	std::vector<uint8_t> mipmapped = Test::MakeDDSFile(Format, Size, Size, 1, MipCount, 1);
+
+	Util::WriteMemoryToFile(directory.wideFile("single.dds"), single.data(), single.size());
+	Util::WriteMemoryToFile(directory.wideFile("mipmapped.dds"), mipmapped.data(), mipmapped.size());
+
+	TexturePack pack;
+
+	CHECK(BuildTexturePack(directory.wideFile(""), directory.wideFile("textures.pak")));
+	CHECK(pack.open(directory.wideFile("textures.pak")));
+
+	const uint8_t *packed = nullptr;
+	size_t packedSize = 0;
+	DirectX::DDS_METADATA metadata;
+
+	CHECK(pack.find(directory.wideFile("single.dds"), &packed, &packedSize));
+	CHECK(packed && SUCCEEDED(DirectX::GetDDSMetadataFromMemory(packed, packedSize, packedSize, metadata)));
+	CHECK(metadata.mipCount == 9 && metadata.width == 256 && metadata.height == 128);
+	CHECK(packedSize == Test::GetDDSFileSize(Format, 256, 128, 1, 9, 1));
+
+	// The top level is the original one
+	if(packed && packedSize >= single.size()){
+		CHECK(memcmp(packed + Test::DDSHeaderSize, &single[Test::DDSHeaderSize], single.size() - Test::DDSHeaderSize) == 0);
+	}
+
+	CHECK(pack.find(directory.wideFile("mipmapped.dds"), &packed, &packedSize));
+	CHECK(packedSize == mipmapped.size() && memcmp(packed, mipmapped.data(), packedSize) == 0);
+}
+
+}
+
+TEST_MAIN(TestStreamsMissingMips, TestStreamsFromPack, TestLoadReservesBudget, TestEvictionAndRestream, TestPackGeneratesMips)
@@ -0,0 +1,373 @@
+#include "Engine.h"
+#include "Test.h"
+
+#include <map>
+
+namespace{
+
+struct LiveRange{
+	size_t begin, end;
+	uint64_t fence;
+};
+
+// A GPU that runs the command stream in order, each fence finishes 0 to 3 submits after it was issued. Copies
+// read the ring when they run, not when they're issued, so bytes overwritten while in flight show up as
+// wrong contents
+class FakeContext : public ID3D11DeviceContext{
+private:
+	struct Command{
+		ID3D11Buffer *destination;
+		UINT offset;
+
+		// Copies from the ring, or data given to UpdateSubresource
+		bool fromRing;
+		UINT source, size;
+		std::vector<uint8_t> data;
+	};
+
+	Test::Random m_random;
+
+	std::vector<uint8_t> m_ring;
+	bool m_mapped;
+
+	struct Fence{
+		uint64_t end, readyAt;
+	};
+
+	// Commands not run yet, each End() closes a batch and the last one is still open
+	std::deque<std::vector<Command>> m_batches;
+	std::map<ID3D11Asynchronous *, Fence> m_fences;
+	uint64_t m_numEnds, m_lastReady;
+
+	void run(const Command &command){
+		std::vector<uint8_t> &contents = destinations[command.destination];
+		const uint8_t *source = command.fromRing ? &m_ring[command.source] : command.data.data();
+
+		if(command.offset + command.size > contents.size()){
+			numMisuses++;
+			return;
+		}
+
+		memcpy(&contents[command.offset], source, command.size);
+	}
+
+public:
+	std::map<ID3D11Buffer *, std::vector<uint8_t>> destinations;
+
+	bool failMap;
+	uint32_t maxDelay;
+	uint32_t numMisuses, numDiscards;
+
+	FakeContext(uint32_t seed) : m_random(seed), m_mapped(false), m_numEnds(0), m_lastReady(0){
+		m_batches.push_back(std::vector<Command>());
+
+		failMap		= false;
+		maxDelay	= 3;
+		numMisuses	= 0;
+		numDiscards	= 0;
+	}
+
+	HRESULT Map(ID3D11Resource *resource, UINT, D3D11_MAP type, UINT, D3D11_MAPPED_SUBRESOURCE *mapped){
+		if(failMap) return E_FAIL;
+		if(m_mapped) numMisuses++;
+
+		m_ring.resize(static_cast<ID3D11Buffer *>(resource)->desc.ByteWidth);
+		m_mapped = true;
+
+		numDiscards += type == D3D11_MAP_WRITE_DISCARD;
+		mapped->pData = m_ring.data();
+
+		return S_OK;
+	}
+
+	void Unmap(ID3D11Resource *, UINT){
+		if(!m_mapped) numMisuses++;
+
+		m_mapped = false;
+	}
+
+	void CopySubresourceRegion(ID3D11Resource *destination, UINT, UINT x, UINT, UINT, ID3D11Resource *, UINT, const D3D11_BOX *box){
+		if(m_mapped || box->right > m_ring.size()) numMisuses++;
+
+		Command command = {static_cast<ID3D11Buffer *>(destination), x, true, box->left, box->right - box->left};
+
+		m_batches.back().push_back(command);
+	}
+
+	void UpdateSubresource(ID3D11Resource *destination, UINT, const D3D11_BOX *box, const void *data, UINT, UINT){
+		const uint8_t *bytes = static_cast<const uint8_t *>(data);
+		Command command = {static_cast<ID3D11Buffer *>(destination), box->left, false, 0, box->right - box->left};
+
+		command.data.assign(bytes, bytes + command.size);
+		m_batches.back().push_back(command);
+	}
+
+	// Fences finish in order, no later than maxDelay submits after they were issued
+	void End(ID3D11Asynchronous *query){
+		m_numEnds++;
+		m_lastReady = std::max<uint64_t>(m_lastReady, m_numEnds + m_random.range(0u, maxDelay + 1));
+
+		Fence fence = {m_numEnds, m_lastReady};
+
+		m_fences[query] = fence;
+		m_batches.push_back(std::vector<Command>());
+	}
+
+	HRESULT GetData(ID3D11Asynchronous *query, void *, UINT, UINT){
+		auto it = m_fences.find(query);
+
+		if(it == m_fences.end()){
+			numMisuses++;
+			return S_OK;
+		}
+
+		if(it->second.readyAt > m_numEnds) return S_FALSE;
+
+		// Everything before the fence has run by now
+		while(m_batches.size() > 1 && m_numEnds + 2 - m_batches.size() <= it->second.end){
+			for(auto &command : m_batches.front()) run(command);
+
+			m_batches.pop_front();
+		}
+
+		return S_OK;
+	}
+
+	// Runs everything issued so far
+	void drain(){
+		for(auto &batch : m_batches){
+			for(auto &command : batch) run(command);
+		}
+
+		m_batches.assign(1, std::vector<Command>());
+	}
+};
+
+// Fixed cases, padding at the end of the ring is held until the allocation after it is retired
+void TestRing(){
+	UploadRing ring(1024);
+
+	CHECK(ring.allocate(100, 16) == 0);
+	CHECK(ring.allocate(10, 16) == 112);
+
+	ring.submit(1);
+
+	// Too big for the end and nothing at the start is free yet
+	CHECK(ring.allocate(900, 16) == UploadRing::InvalidOffset);
+	CHECK(ring.allocate(800, 16) == 128);
+
+	ring.submit(2);
+
+	CHECK(ring.allocate(200, 16) == UploadRing::InvalidOffset);
+	CHECK(ring.getNumInFlight() == 2);
+
+	ring.retire(1);
+
+	// Wraps to the start, the 96 bytes left at the end go with it
+	CHECK(ring.getUsed() == 806);
+	CHECK(ring.allocate(100, 16) == 0);
+	CHECK(ring.getUsed() == 806 + 96 + 100);
+	CHECK(ring.allocate(30, 16) == UploadRing::InvalidOffset);
+
+	ring.submit(3);
+	ring.retire(3);
+
+	CHECK(ring.getUsed() == 0 && ring.getNumInFlight() == 0);
+	CHECK(ring.getPeak() == 1002);
+
+	// The whole ring in one go, and nothing at all
+	CHECK(ring.allocate(1024, 16) == 0);
+	CHECK(ring.allocate(1, 1) == UploadRing::InvalidOffset);
+	CHECK(ring.allocate(0, 16) == UploadRing::InvalidOffset && ring.allocate(1025, 1) == UploadRing::InvalidOffset);
+
+	// A rolled back allocation leaves nothing to submit
+	ring.rollback();
+	CHECK(ring.getUsed() == 0);
+
+	ring.submit(4);
+	CHECK(ring.getNumInFlight() == 0);
+
+	CHECK(ring.allocate(64, 16) == 0 && ring.allocate(64, 16) == 64);
+	ring.rollback();
+	CHECK(ring.allocate(16, 16) == 64 && ring.getUsed() == 80);
+
+	ring.submit(5);
+	ring.retire(5);
+	CHECK(ring.getUsed() == 0);
+}
+
+// Random sizes and alignments against fences retired 0 to 3 submits late, live ranges never overlap and
+// everything comes back once the last fence is retired
+void TestRingRandom(){
+	Test::Random random(7);
+
+	for(uint32_t round = 0; round < 16; round++){
+		size_t capacity = static_cast<size_t>(1) << (10 + round % 8);
+		UploadRing ring(capacity);
+		std::deque<LiveRange> live;
+		uint64_t fence = 0, completed = 0;
+		uint32_t numAllocated = 0;
+
+		for(uint32_t frame = 0; frame < 5000; frame++){
+			uint32_t numAllocations = random.range(0u, 6u);
+
+			for(uint32_t i = 0; i < numAllocations; i++){
+				size_t size = random.range(1u, static_cast<uint32_t>(capacity / 3));
+				size_t alignment = static_cast<size_t>(1) << random.range(0u, 7u);
+				size_t offset = ring.allocate(size, alignment);
+
+				if(offset == UploadRing::InvalidOffset) continue;
+
+				// Every so often the caller can't use it after all
+				if(random.range(0u, 16u) == 0){
+					ring.rollback();
+					continue;
+				}
+
+				bool overlaps = false;
+
+				for(auto &range : live) overlaps = overlaps || (offset < range.end && offset + size > range.begin);
+
+				CHECK(offset % alignment == 0 && offset + size <= capacity);
+				CHECK(!overlaps);
+
+				LiveRange range = {offset, offset + size, fence + 1};
+
+				live.push_back(range);
+				numAllocated++;
+			}
+
+			ring.submit(++fence);
+
+			// Some frames the GPU doesn't get anything done
+			uint64_t target = fence > 3 ? fence - random.range(0u, 4u) : 0;
+
+			if(target > completed && random.range(0u, 5u) != 0){
+				completed = target;
+				ring.retire(completed);
+
+				while(!live.empty() && live.front().fence <= completed) live.pop_front();
+			}
+
+			size_t liveBytes = 0;
+
+			for(auto &range : live) liveBytes += range.end - range.begin;
+
+			CHECK(ring.getUsed() >= liveBytes && ring.getUsed() <= capacity);
+		}
+
+		ring.retire(fence);
+
+		CHECK(numAllocated > 0);
+		CHECK(ring.getUsed() == 0 && ring.getNumInFlight() == 0);
+	}
+}
+
+// Uploads of random sizes into a few buffers through a small ring, the destinations end up with the last
+// bytes written to them however late the GPU is and however often the ring runs full
+void TestUploads(){
+	const UINT DestinationSize = 4096;
+
+	for(uint32_t maxDelay = 0; maxDelay <= 3; maxDelay++){
+		Test::Random random(100 + maxDelay);
+		ID3D11Device *device = new ID3D11Device;
+		FakeContext *context = new FakeContext(maxDelay + 1);
+		std::vector<ID3D11Buffer *> buffers;
+		std::vector<std::vector<uint8_t>> expected;
+
+		context->maxDelay = maxDelay;
+
+		D3D11_BUFFER_DESC desc = {DestinationSize, D3D11_USAGE_DEFAULT, D3D11_BIND_VERTEX_BUFFER, 0, 0, 0};
+
+		for(uint32_t i = 0; i < 4; i++){
+			buffers.push_back(new ID3D11Buffer(desc));
+			expected.push_back(std::vector<uint8_t>(DestinationSize, 0));
+			context->destinations[buffers.back()].assign(DestinationSize, 0);
+		}
+
+		{
+			UploadManager uploads(device, context, 16 * 1024);
+			std::vector<uint8_t> data;
+
+			for(uint32_t frame = 0; frame < 500; frame++){
+				uint32_t numUploads = random.range(1u, 12u);
+
+				for(uint32_t i = 0; i < numUploads; i++){
+					uint32_t target = random.range(0u, 4u);
+					UINT size = random.range(1u, 2000u);
+					UINT offset = random.range(0u, DestinationSize - size);
+
+					data.resize(size);
+
+					for(auto &byte : data) byte = static_cast<uint8_t>(random.next());
+
+					uploads.upload(buffers[target], offset, data.data(), size);
+					memcpy(&expected[target][offset], data.data(), size);
+				}
+
+				uploads.submit();
+			}
+
+			const UploadStats &stats = uploads.getStats();
+
+			CHECK(stats.numUploads > 0 && stats.numBatches > 0 && stats.numBatches <= 500);
+			CHECK(stats.numDirectUploads < stats.numUploads);
+			CHECK(context->numDiscards == 1);
+		}
+
+		context->drain();
+
+		CHECK(context->numMisuses == 0);
+
+		for(uint32_t i = 0; i < buffers.size(); i++){
+			CHECK(context->destinations[buffers[i]] == expected[i]);
+			buffers[i]->Release();
+		}
+
+		context->Release();
+		device->Release();
+	}
+}
+
+// An upload that can't map the ring goes directly and doesn't keep its ring space
+void TestMapFailure(){
+	ID3D11Device *device = new ID3D11Device;
+	FakeContext *context = new FakeContext(1);
+
+	D3D11_BUFFER_DESC desc = {256, D3D11_USAGE_DEFAULT, D3D11_BIND_VERTEX_BUFFER, 0, 0, 0};
+	ID3D11Buffer *buffer = new ID3D11Buffer(desc);
+	uint8_t data[256];
+
+	for(uint32_t i = 0; i < 256; i++) data[i] = static_cast<uint8_t>(i);
+
+	context->destinations[buffer].assign(256, 0);
+
+	{
+		UploadManager uploads(device, context, 256);
+
+		context->failMap = true;
+		uploads.upload(buffer, 0, data, 256);
+
+		CHECK(uploads.getStats().numDirectUploads == 1);
+
+		// The whole ring is free again, so the next upload fits
+		context->failMap = false;
+		uploads.upload(buffer, 0, data, 256);
+		uploads.submit();
+
+		CHECK(uploads.getStats().numDirectUploads == 1 && uploads.getStats().numBatches == 1);
+	}
+
+	context->drain();
+
+	CHECK(context->numMisuses == 0);
+	CHECK(memcmp(context->destinations[buffer].data(), data, 256) == 0);
+
+	buffer->Release();
+	context->Release();
+	device->Release();
+}
+
+}
+
+TEST_MAIN(TestRing, TestRingRandom, TestUploads, TestMapFailure)
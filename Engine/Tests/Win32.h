@@ -0,0 +1,233 @@
+#pragma once
+
+//////////////////////////////////
+// Win32 subset for Linux tests //
+//////////////////////////////////
+
+// Types, error codes and SAL annotations the engine sources use, with the file and mapping functions backed
+// by POSIX in Platform.cpp
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <cstdio>
+#include <cstdlib>
+#include <strings.h>
+#include <x86intrin.h>
+
+typedef int32_t BOOL;
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint32_t UINT;
+typedef uint32_t ULONG;
+typedef int32_t LONG;
+typedef int64_t LONGLONG;
+typedef uint64_t UINT64;
+typedef int32_t HRESULT;
+typedef char CHAR;
+typedef wchar_t WCHAR;
+typedef void *HANDLE;
+typedef void *HWND;
+typedef void *HINSTANCE;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+
+#ifndef TRUE
+#define TRUE	1
+#define FALSE	0
+#endif
+
+#ifndef NULL
+#define NULL	0
+#endif
+
+#define MAX_PATH	260
+#define MAXDWORD	0xFFFFFFFF
+#define CALLBACK
+#define NTAPI
+#define STDMETHODCALLTYPE
+#define UNREFERENCED_PARAMETER(x)	(void)(x)
+
+union LARGE_INTEGER{
+	int64_t QuadPart;
+};
+
+struct GUID{
+	uint32_t Data1;
+	uint16_t Data2, Data3;
+	uint8_t Data4[8];
+};
+
+typedef const GUID &REFIID;
+typedef const GUID &REFGUID;
+
+inline bool operator==(const GUID &a, const GUID &b){
+	return memcmp(&a, &b, sizeof(GUID)) == 0;
+}
+
+inline bool operator!=(const GUID &a, const GUID &b){
+	return !(a == b);
+}
+
+// Only the interfaces the engine asks for by name
+extern const GUID IID_IUnknown;
+#define __uuidof(type)	IID_##type
+
+// HRESULTs
+#define S_OK			static_cast<HRESULT>(0)
+#define S_FALSE			static_cast<HRESULT>(1)
+#define E_FAIL			static_cast<HRESULT>(0x80004005)
+#define E_INVALIDARG	static_cast<HRESULT>(0x80070057)
+#define E_OUTOFMEMORY	static_cast<HRESULT>(0x8007000E)
+#define E_POINTER		static_cast<HRESULT>(0x80004003)
+#define E_NOINTERFACE	static_cast<HRESULT>(0x80004002)
+#define E_UNEXPECTED	static_cast<HRESULT>(0x8000FFFF)
+#define E_NOTIMPL		static_cast<HRESULT>(0x80004001)
+
+#define SUCCEEDED(hr)	(static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr)		(static_cast<HRESULT>(hr) < 0)
+
+#define ERROR_FILE_NOT_FOUND	2
+#define ERROR_INVALID_DATA		13
+#define ERROR_HANDLE_EOF		38
+#define ERROR_NOT_SUPPORTED		50
+#define ERROR_FILE_TOO_LARGE	223
+
+inline HRESULT HRESULT_FROM_WIN32(DWORD error){
+	return error ? static_cast<HRESULT>((error & 0xFFFF) | 0x80070000) : S_OK;
+}
+
+// SAL annotations
+#define _In_
+#define _In_z_
+#define _In_opt_
+#define _In_reads_(x)
+#define _In_reads_opt_(x)
+#define _In_reads_bytes_(x)
+#define _In_reads_bytes_opt_(x)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(x)
+#define _Out_writes_opt_(x)
+#define _Out_writes_bytes_(x)
+#define _Outptr_opt_
+#define _Use_decl_annotations_
+#define _Analysis_assume_(x)
+
+// Files, opened for reading or created for writing. Paths may use either slash, handles from CreateFileW and
+// CreateFileMappingW are both closed with CloseHandle
+#define INVALID_HANDLE_VALUE		reinterpret_cast<HANDLE>(-1)
+#define GENERIC_READ				0x80000000
+#define GENERIC_WRITE				0x40000000
+#define FILE_SHARE_READ				0x1
+#define CREATE_ALWAYS				2
+#define OPEN_EXISTING				3
+#define FILE_ATTRIBUTE_NORMAL		0x80
+#define FILE_FLAG_SEQUENTIAL_SCAN	0x08000000
+#define FILE_FLAG_RANDOM_ACCESS		0x10000000
+#define FILE_BEGIN					0
+#define PAGE_READONLY				0x02
+#define FILE_MAP_READ				0x04
+
+// Keeps the loader on GetFileSizeEx
+#define _WIN32_WINNT_VISTA			0x0600
+#define _WIN32_WINNT				0x0501
+
+struct SECURITY_ATTRIBUTES;
+
+struct SYSTEM_INFO{
+	DWORD dwPageSize;
+	DWORD dwAllocationGranularity;
+};
+
+HANDLE CreateFileW(const wchar_t *fileName, DWORD access, DWORD shareMode, SECURITY_ATTRIBUTES *security, DWORD disposition, DWORD flags,
+	HANDLE templateFile);
+BOOL ReadFile(HANDLE file, void *buffer, DWORD bytesToRead, DWORD *bytesRead, void *overlapped);
+BOOL WriteFile(HANDLE file, const void *buffer, DWORD bytesToWrite, DWORD *bytesWritten, void *overlapped);
+BOOL SetFilePointerEx(HANDLE file, LARGE_INTEGER distance, LARGE_INTEGER *newPosition, DWORD method);
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER *size);
+BOOL DeleteFileW(const wchar_t *fileName);
+BOOL CreateDirectoryW(const wchar_t *path, SECURITY_ATTRIBUTES *security);
+BOOL MoveFileExW(const wchar_t *existingName, const wchar_t *newName, DWORD flags);
+BOOL CloseHandle(HANDLE handle);
+DWORD GetLastError();
+
+HANDLE CreateFileMappingW(HANDLE file, SECURITY_ATTRIBUTES *security, DWORD protect, DWORD sizeHigh, DWORD sizeLow, const wchar_t *name);
+void *MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, size_t numBytes);
+BOOL UnmapViewOfFile(const void *view);
+void GetSystemInfo(SYSTEM_INFO *info);
+
+inline HANDLE CreateFile(const wchar_t *fileName, DWORD access, DWORD shareMode, SECURITY_ATTRIBUTES *security, DWORD disposition, DWORD flags,
+	HANDLE templateFile){
+
+	return CreateFileW(fileName, access, shareMode, security, disposition, flags, templateFile);
+}
+
+// Views mapped so far and the bytes they covered, for tests that check how much of a file was mapped
+void GetMappingStats(uint64_t &numViews, uint64_t &numBytes);
+
+// Paths, full paths are made against the working directory without touching the file system
+DWORD GetFullPathNameW(const wchar_t *fileName, DWORD bufferLength, wchar_t *buffer, wchar_t **filePart);
+BOOL PathRemoveFileSpecW(wchar_t *path);
+
+#define MOVEFILE_REPLACE_EXISTING	0x1
+
+// Strings
+#define CP_ACP		0
+#define CP_UTF8		65001
+
+int WideCharToMultiByte(UINT codePage, DWORD flags, const wchar_t *wideText, int wideLength, char *text, int length, const char *defaultChar,
+	BOOL *usedDefaultChar);
+
+inline int _stricmp(const char *a, const char *b){
+	return strcasecmp(a, b);
+}
+
+inline size_t strnlen_s(const char *text, size_t maxLength){
+	return text ? strnlen(text, maxLength) : 0;
+}
+
+template<size_t N, typename... Args>
+int sprintf_s(char (&buffer)[N], const char *format, Args... args){
+	return snprintf(buffer, N, format, args...);
+}
+
+template<size_t N, typename... Args>
+int swprintf_s(wchar_t (&buffer)[N], const wchar_t *format, Args... args){
+	return swprintf(buffer, N, format, args...);
+}
+
+inline void OutputDebugStringA(const char *text){
+	fputs(text, stderr);
+}
+
+inline void OutputDebugStringW(const wchar_t *text){
+	fprintf(stderr, "%ls", text);
+}
+
+// Memory
+inline void *_aligned_malloc(size_t size, size_t alignment){
+	void *memory = nullptr;
+
+	return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+}
+
+inline void _aligned_free(void *memory){
+	free(memory);
+}
+
+// Fiber local storage on top of pthread keys, the callback runs with the thread's value when the thread exits
+typedef void (NTAPI *PFLS_CALLBACK_FUNCTION)(void *data);
+
+#define FLS_OUT_OF_INDEXES	0xFFFFFFFF
+
+DWORD FlsAlloc(PFLS_CALLBACK_FUNCTION callback);
+BOOL FlsSetValue(DWORD index, void *value);
+
+// GUIDs, random ones from the kernel the way CoCreateGuid gets them from the OS
+HRESULT CoCreateGuid(GUID *guid);
+int StringFromGUID2(const GUID &guid, wchar_t *text, int length);
@@ -0,0 +1,534 @@
+#pragma once
+
+//////////////////////////////////
+// D3D11 subset for Linux tests //
+//////////////////////////////////
+
+// The interfaces are plain classes with a null implementation: the device hands out objects that only keep
+// their descriptions and the context drops every command. Tests derive from ID3D11Device or
+// ID3D11DeviceContext to record what the engine does with them
+
+#include "Win32.h"
+
+#include <atomic>
+#include <vector>
+
+enum DXGI_FORMAT{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_TYPELESS = 1,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32A32_UINT = 3,
+	DXGI_FORMAT_R32G32B32A32_SINT = 4,
+	DXGI_FORMAT_R32G32B32_TYPELESS = 5,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R32G32B32_UINT = 7,
+	DXGI_FORMAT_R32G32B32_SINT = 8,
+	DXGI_FORMAT_R16G16B16A16_TYPELESS = 9,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R16G16B16A16_UINT = 12,
+	DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+	DXGI_FORMAT_R16G16B16A16_SINT = 14,
+	DXGI_FORMAT_R32G32_TYPELESS = 15,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R32G32_UINT = 17,
+	DXGI_FORMAT_R32G32_SINT = 18,
+	DXGI_FORMAT_R32G8X24_TYPELESS = 19,
+	DXGI_FORMAT_D32_FLOAT_S8X24_UINT = 20,
+	DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS = 21,
+	DXGI_FORMAT_X32_TYPELESS_G8X24_UINT = 22,
+	DXGI_FORMAT_R10G10B10A2_TYPELESS = 23,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R10G10B10A2_UINT = 25,
+	DXGI_FORMAT_R11G11B10_FLOAT = 26,
+	DXGI_FORMAT_R8G8B8A8_TYPELESS = 27,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	DXGI_FORMAT_R8G8B8A8_UINT = 30,
+	DXGI_FORMAT_R8G8B8A8_SNORM = 31,
+	DXGI_FORMAT_R8G8B8A8_SINT = 32,
+	DXGI_FORMAT_R16G16_TYPELESS = 33,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R16G16_UNORM = 35,
+	DXGI_FORMAT_R16G16_UINT = 36,
+	DXGI_FORMAT_R16G16_SNORM = 37,
+	DXGI_FORMAT_R16G16_SINT = 38,
+	DXGI_FORMAT_R32_TYPELESS = 39,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R32_SINT = 43,
+	DXGI_FORMAT_R24G8_TYPELESS = 44,
+	DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+	DXGI_FORMAT_R24_UNORM_X8_TYPELESS = 46,
+	DXGI_FORMAT_X24_TYPELESS_G8_UINT = 47,
+	DXGI_FORMAT_R8G8_TYPELESS = 48,
+	DXGI_FORMAT_R8G8_UNORM = 49,
+	DXGI_FORMAT_R8G8_UINT = 50,
+	DXGI_FORMAT_R8G8_SNORM = 51,
+	DXGI_FORMAT_R8G8_SINT = 52,
+	DXGI_FORMAT_R16_TYPELESS = 53,
+	DXGI_FORMAT_R16_FLOAT = 54,
+	DXGI_FORMAT_D16_UNORM = 55,
+	DXGI_FORMAT_R16_UNORM = 56,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_R16_SNORM = 58,
+	DXGI_FORMAT_R16_SINT = 59,
+	DXGI_FORMAT_R8_TYPELESS = 60,
+	DXGI_FORMAT_R8_UNORM = 61,
+	DXGI_FORMAT_R8_UINT = 62,
+	DXGI_FORMAT_R8_SNORM = 63,
+	DXGI_FORMAT_R8_SINT = 64,
+	DXGI_FORMAT_A8_UNORM = 65,
+	DXGI_FORMAT_R1_UNORM = 66,
+	DXGI_FORMAT_R9G9B9E5_SHAREDEXP = 67,
+	DXGI_FORMAT_R8G8_B8G8_UNORM = 68,
+	DXGI_FORMAT_G8R8_G8B8_UNORM = 69,
+	DXGI_FORMAT_BC1_TYPELESS = 70,
+	DXGI_FORMAT_BC1_UNORM = 71,
+	DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+	DXGI_FORMAT_BC2_TYPELESS = 73,
+	DXGI_FORMAT_BC2_UNORM = 74,
+	DXGI_FORMAT_BC2_UNORM_SRGB = 75,
+	DXGI_FORMAT_BC3_TYPELESS = 76,
+	DXGI_FORMAT_BC3_UNORM = 77,
+	DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+	DXGI_FORMAT_BC4_TYPELESS = 79,
+	DXGI_FORMAT_BC4_UNORM = 80,
+	DXGI_FORMAT_BC4_SNORM = 81,
+	DXGI_FORMAT_BC5_TYPELESS = 82,
+	DXGI_FORMAT_BC5_UNORM = 83,
+	DXGI_FORMAT_BC5_SNORM = 84,
+	DXGI_FORMAT_B5G6R5_UNORM = 85,
+	DXGI_FORMAT_B5G5R5A1_UNORM = 86,
+	DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+	DXGI_FORMAT_B8G8R8X8_UNORM = 88,
+	DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM = 89,
+	DXGI_FORMAT_B8G8R8A8_TYPELESS = 90,
+	DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+	DXGI_FORMAT_B8G8R8X8_TYPELESS = 92,
+	DXGI_FORMAT_B8G8R8X8_UNORM_SRGB = 93,
+	DXGI_FORMAT_BC6H_TYPELESS = 94,
+	DXGI_FORMAT_BC6H_UF16 = 95,
+	DXGI_FORMAT_BC6H_SF16 = 96,
+	DXGI_FORMAT_BC7_TYPELESS = 97,
+	DXGI_FORMAT_BC7_UNORM = 98,
+	DXGI_FORMAT_BC7_UNORM_SRGB = 99,
+	DXGI_FORMAT_AYUV = 100,
+	DXGI_FORMAT_Y410 = 101,
+	DXGI_FORMAT_Y416 = 102,
+	DXGI_FORMAT_NV12 = 103,
+	DXGI_FORMAT_P010 = 104,
+	DXGI_FORMAT_P016 = 105,
+	DXGI_FORMAT_420_OPAQUE = 106,
+	DXGI_FORMAT_YUY2 = 107,
+	DXGI_FORMAT_Y210 = 108,
+	DXGI_FORMAT_Y216 = 109,
+	DXGI_FORMAT_NV11 = 110,
+	DXGI_FORMAT_AI44 = 111,
+	DXGI_FORMAT_IA44 = 112,
+	DXGI_FORMAT_P8 = 113,
+	DXGI_FORMAT_A8P8 = 114,
+	DXGI_FORMAT_B4G4R4A4_UNORM = 115,
+	DXGI_FORMAT_P208 = 130,
+	DXGI_FORMAT_V208 = 131,
+	DXGI_FORMAT_V408 = 132,
+	DXGI_FORMAT_FORCE_UINT = 0xffffffff
+};
+
+struct DXGI_SAMPLE_DESC{
+	UINT Count;
+	UINT Quality;
+};
+
+enum D3D_FEATURE_LEVEL{
+	D3D_FEATURE_LEVEL_9_1	= 0x9100,
+	D3D_FEATURE_LEVEL_9_2	= 0x9200,
+	D3D_FEATURE_LEVEL_9_3	= 0x9300,
+	D3D_FEATURE_LEVEL_10_0	= 0xa000,
+	D3D_FEATURE_LEVEL_10_1	= 0xa100,
+	D3D_FEATURE_LEVEL_11_0	= 0xb000
+};
+
+enum D3D11_USAGE{
+	D3D11_USAGE_DEFAULT,
+	D3D11_USAGE_IMMUTABLE,
+	D3D11_USAGE_DYNAMIC,
+	D3D11_USAGE_STAGING
+};
+
+enum D3D11_BIND_FLAG{
+	D3D11_BIND_VERTEX_BUFFER	= 0x1,
+	D3D11_BIND_INDEX_BUFFER		= 0x2,
+	D3D11_BIND_CONSTANT_BUFFER	= 0x4,
+	D3D11_BIND_SHADER_RESOURCE	= 0x8,
+	D3D11_BIND_STREAM_OUTPUT	= 0x10,
+	D3D11_BIND_RENDER_TARGET	= 0x20,
+	D3D11_BIND_DEPTH_STENCIL	= 0x40,
+	D3D11_BIND_UNORDERED_ACCESS	= 0x80
+};
+
+enum D3D11_CPU_ACCESS_FLAG{
+	D3D11_CPU_ACCESS_WRITE	= 0x10000,
+	D3D11_CPU_ACCESS_READ	= 0x20000
+};
+
+enum D3D11_RESOURCE_MISC_FLAG{
+	D3D11_RESOURCE_MISC_GENERATE_MIPS			= 0x1,
+	D3D11_RESOURCE_MISC_TEXTURECUBE				= 0x4,
+	D3D11_RESOURCE_MISC_BUFFER_STRUCTURED		= 0x40
+};
+
+enum D3D11_RESOURCE_DIMENSION{
+	D3D11_RESOURCE_DIMENSION_UNKNOWN,
+	D3D11_RESOURCE_DIMENSION_BUFFER,
+	D3D11_RESOURCE_DIMENSION_TEXTURE1D,
+	D3D11_RESOURCE_DIMENSION_TEXTURE2D,
+	D3D11_RESOURCE_DIMENSION_TEXTURE3D
+};
+
+enum D3D_SRV_DIMENSION{
+	D3D_SRV_DIMENSION_UNKNOWN,
+	D3D_SRV_DIMENSION_BUFFER,
+	D3D_SRV_DIMENSION_TEXTURE1D,
+	D3D_SRV_DIMENSION_TEXTURE1DARRAY,
+	D3D_SRV_DIMENSION_TEXTURE2D,
+	D3D_SRV_DIMENSION_TEXTURE2DARRAY,
+	D3D_SRV_DIMENSION_TEXTURE2DMS,
+	D3D_SRV_DIMENSION_TEXTURE2DMSARRAY,
+	D3D_SRV_DIMENSION_TEXTURE3D,
+	D3D_SRV_DIMENSION_TEXTURECUBE,
+	D3D_SRV_DIMENSION_TEXTURECUBEARRAY,
+
+	D3D11_SRV_DIMENSION_UNKNOWN				= D3D_SRV_DIMENSION_UNKNOWN,
+	D3D11_SRV_DIMENSION_BUFFER				= D3D_SRV_DIMENSION_BUFFER,
+	D3D11_SRV_DIMENSION_TEXTURE1D			= D3D_SRV_DIMENSION_TEXTURE1D,
+	D3D11_SRV_DIMENSION_TEXTURE1DARRAY		= D3D_SRV_DIMENSION_TEXTURE1DARRAY,
+	D3D11_SRV_DIMENSION_TEXTURE2D			= D3D_SRV_DIMENSION_TEXTURE2D,
+	D3D11_SRV_DIMENSION_TEXTURE2DARRAY		= D3D_SRV_DIMENSION_TEXTURE2DARRAY,
+	D3D11_SRV_DIMENSION_TEXTURE3D			= D3D_SRV_DIMENSION_TEXTURE3D,
+	D3D11_SRV_DIMENSION_TEXTURECUBE			= D3D_SRV_DIMENSION_TEXTURECUBE,
+	D3D11_SRV_DIMENSION_TEXTURECUBEARRAY	= D3D_SRV_DIMENSION_TEXTURECUBEARRAY
+};
+
+typedef D3D_SRV_DIMENSION D3D11_SRV_DIMENSION;
+
+enum D3D11_FORMAT_SUPPORT{
+	D3D11_FORMAT_SUPPORT_TEXTURE2D		= 0x20,
+	D3D11_FORMAT_SUPPORT_MIP_AUTOGEN	= 0x80000
+};
+
+enum D3D11_MAP{
+	D3D11_MAP_READ					= 1,
+	D3D11_MAP_WRITE					= 2,
+	D3D11_MAP_READ_WRITE			= 3,
+	D3D11_MAP_WRITE_DISCARD			= 4,
+	D3D11_MAP_WRITE_NO_OVERWRITE	= 5
+};
+
+enum D3D11_QUERY{
+	D3D11_QUERY_EVENT				= 0,
+	D3D11_QUERY_OCCLUSION			= 1,
+	D3D11_QUERY_TIMESTAMP			= 2,
+	D3D11_QUERY_TIMESTAMP_DISJOINT	= 3
+};
+
+enum D3D11_ASYNC_GETDATA_FLAG{
+	D3D11_ASYNC_GETDATA_DONOTFLUSH	= 0x1
+};
+
+// Limits
+#define D3D11_REQ_MIP_LEVELS						15
+#define D3D11_REQ_TEXTURE1D_U_DIMENSION				16384
+#define D3D11_REQ_TEXTURE1D_ARRAY_AXIS_DIMENSION	2048
+#define D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION		16384
+#define D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION	2048
+#define D3D11_REQ_TEXTURE3D_U_V_OR_W_DIMENSION		2048
+#define D3D11_REQ_TEXTURECUBE_DIMENSION				16384
+
+inline UINT D3D11CalcSubresource(UINT mipSlice, UINT arraySlice, UINT mipLevels){
+	return mipSlice + arraySlice * mipLevels;
+}
+
+extern const GUID WKPDID_D3DDebugObjectName;
+
+struct D3D11_SUBRESOURCE_DATA{
+	const void *pSysMem;
+	UINT SysMemPitch;
+	UINT SysMemSlicePitch;
+};
+
+struct D3D11_MAPPED_SUBRESOURCE{
+	void *pData;
+	UINT RowPitch;
+	UINT DepthPitch;
+};
+
+struct D3D11_QUERY_DESC{
+	D3D11_QUERY Query;
+	UINT MiscFlags;
+};
+
+struct D3D11_QUERY_DATA_TIMESTAMP_DISJOINT{
+	UINT64 Frequency;
+	BOOL Disjoint;
+};
+
+struct D3D11_BOX{
+	UINT left, top, front;
+	UINT right, bottom, back;
+};
+
+struct D3D11_BUFFER_DESC{
+	UINT ByteWidth;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+	UINT StructureByteStride;
+};
+
+struct D3D11_TEXTURE1D_DESC{
+	UINT Width;
+	UINT MipLevels;
+	UINT ArraySize;
+	DXGI_FORMAT Format;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+};
+
+struct D3D11_TEXTURE2D_DESC{
+	UINT Width;
+	UINT Height;
+	UINT MipLevels;
+	UINT ArraySize;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+};
+
+struct D3D11_TEXTURE3D_DESC{
+	UINT Width;
+	UINT Height;
+	UINT Depth;
+	UINT MipLevels;
+	DXGI_FORMAT Format;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+};
+
+// One struct for every dimension, cube arrays name their slice fields differently
+struct D3D11_TEX_SRV{
+	UINT MostDetailedMip;
+	UINT MipLevels;
+	union{ UINT FirstArraySlice; UINT First2DArrayFace; };
+	union{ UINT ArraySize; UINT NumCubes; };
+};
+
+struct D3D11_SHADER_RESOURCE_VIEW_DESC{
+	DXGI_FORMAT Format;
+	D3D11_SRV_DIMENSION ViewDimension;
+
+	// The per-dimension members share one layout here
+	union{
+		D3D11_TEX_SRV Texture1D;
+		D3D11_TEX_SRV Texture1DArray;
+		D3D11_TEX_SRV Texture2D;
+		D3D11_TEX_SRV Texture2DArray;
+		D3D11_TEX_SRV Texture3D;
+		D3D11_TEX_SRV TextureCube;
+		D3D11_TEX_SRV TextureCubeArray;
+	};
+};
+
+// Interfaces
+class IUnknown{
+private:
+	std::atomic<ULONG> m_refs;
+
+protected:
+	IUnknown() : m_refs(1){}
+	virtual ~IUnknown(){}
+
+public:
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **object){
+		*object = nullptr;
+		return E_NOINTERFACE;
+	}
+
+	virtual ULONG STDMETHODCALLTYPE AddRef(){
+		return ++m_refs;
+	}
+
+	virtual ULONG STDMETHODCALLTYPE Release(){
+		ULONG refs = --m_refs;
+
+		if(refs == 0) delete this;
+
+		return refs;
+	}
+};
+
+class ID3D11DeviceChild : public IUnknown{
+private:
+	std::vector<std::pair<GUID, IUnknown *>> m_interfaces;
+
+protected:
+	~ID3D11DeviceChild();
+
+public:
+	HRESULT SetPrivateData(REFGUID, UINT, const void *){
+		return S_OK;
+	}
+
+	// Held until the object is destroyed, like D3D does
+	HRESULT SetPrivateDataInterface(REFGUID guid, IUnknown *object);
+};
+
+class ID3D11Resource : public ID3D11DeviceChild{
+public:
+	virtual D3D11_RESOURCE_DIMENSION getDimension() const = 0;
+
+	void GetType(D3D11_RESOURCE_DIMENSION *dimension){ *dimension = getDimension(); }
+};
+
+class ID3D11Buffer : public ID3D11Resource{
+public:
+	D3D11_BUFFER_DESC desc;
+
+	explicit ID3D11Buffer(const D3D11_BUFFER_DESC &d) : desc(d){}
+
+	void GetDesc(D3D11_BUFFER_DESC *d){ *d = desc; }
+	D3D11_RESOURCE_DIMENSION getDimension() const{ return D3D11_RESOURCE_DIMENSION_BUFFER; }
+};
+
+class ID3D11Texture1D : public ID3D11Resource{
+public:
+	D3D11_TEXTURE1D_DESC desc;
+
+	explicit ID3D11Texture1D(const D3D11_TEXTURE1D_DESC &d) : desc(d){}
+
+	void GetDesc(D3D11_TEXTURE1D_DESC *d){ *d = desc; }
+	D3D11_RESOURCE_DIMENSION getDimension() const{ return D3D11_RESOURCE_DIMENSION_TEXTURE1D; }
+};
+
+class ID3D11Texture2D : public ID3D11Resource{
+public:
+	D3D11_TEXTURE2D_DESC desc;
+
+	explicit ID3D11Texture2D(const D3D11_TEXTURE2D_DESC &d) : desc(d){}
+
+	void GetDesc(D3D11_TEXTURE2D_DESC *d){ *d = desc; }
+	D3D11_RESOURCE_DIMENSION getDimension() const{ return D3D11_RESOURCE_DIMENSION_TEXTURE2D; }
+};
+
+class ID3D11Texture3D : public ID3D11Resource{
+public:
+	D3D11_TEXTURE3D_DESC desc;
+
+	explicit ID3D11Texture3D(const D3D11_TEXTURE3D_DESC &d) : desc(d){}
+
+	void GetDesc(D3D11_TEXTURE3D_DESC *d){ *d = desc; }
+	D3D11_RESOURCE_DIMENSION getDimension() const{ return D3D11_RESOURCE_DIMENSION_TEXTURE3D; }
+};
+
+class ID3D11View : public ID3D11DeviceChild{
+private:
+	ID3D11Resource *m_resource;
+
+protected:
+	~ID3D11View(){ m_resource->Release(); }
+
+public:
+	explicit ID3D11View(ID3D11Resource *resource) : m_resource(resource){ resource->AddRef(); }
+
+	void GetResource(ID3D11Resource **resource){
+		m_resource->AddRef();
+		*resource = m_resource;
+	}
+};
+
+class ID3D11ShaderResourceView : public ID3D11View{
+public:
+	D3D11_SHADER_RESOURCE_VIEW_DESC desc;
+
+	ID3D11ShaderResourceView(ID3D11Resource *resource, const D3D11_SHADER_RESOURCE_VIEW_DESC &d) : ID3D11View(resource), desc(d){}
+
+	void GetDesc(D3D11_SHADER_RESOURCE_VIEW_DESC *d){ *d = desc; }
+};
+
+class ID3D11UnorderedAccessView : public ID3D11View{
+public:
+	explicit ID3D11UnorderedAccessView(ID3D11Resource *resource) : ID3D11View(resource){}
+};
+
+class ID3D11InputLayout : public ID3D11DeviceChild{};
+class ID3D11ComputeShader : public ID3D11DeviceChild{};
+class ID3D11ClassInstance;
+
+struct D3D11_UNORDERED_ACCESS_VIEW_DESC;
+
+class ID3D11Asynchronous : public ID3D11DeviceChild{};
+
+class ID3D11Query : public ID3D11Asynchronous{
+public:
+	D3D11_QUERY_DESC desc;
+
+	explicit ID3D11Query(const D3D11_QUERY_DESC &d) : desc(d){}
+
+	void GetDesc(D3D11_QUERY_DESC *d){ *d = desc; }
+};
+
+class ID3D11DeviceContext;
+
+// Creates objects that only keep their descriptions, every format supports everything but mip autogen
+class ID3D11Device : public IUnknown{
+public:
+	ID3D11Device(){}
+
+	virtual HRESULT CreateBuffer(const D3D11_BUFFER_DESC *desc, const D3D11_SUBRESOURCE_DATA *initialData, ID3D11Buffer **buffer);
+	virtual HRESULT CreateTexture1D(const D3D11_TEXTURE1D_DESC *desc, const D3D11_SUBRESOURCE_DATA *initialData, ID3D11Texture1D **texture);
+	virtual HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC *desc, const D3D11_SUBRESOURCE_DATA *initialData, ID3D11Texture2D **texture);
+	virtual HRESULT CreateTexture3D(const D3D11_TEXTURE3D_DESC *desc, const D3D11_SUBRESOURCE_DATA *initialData, ID3D11Texture3D **texture);
+	virtual HRESULT CreateShaderResourceView(ID3D11Resource *resource, const D3D11_SHADER_RESOURCE_VIEW_DESC *desc, ID3D11ShaderResourceView **view);
+	virtual HRESULT CreateUnorderedAccessView(ID3D11Resource *resource, const D3D11_UNORDERED_ACCESS_VIEW_DESC *desc, ID3D11UnorderedAccessView **view);
+	virtual HRESULT CreateQuery(const D3D11_QUERY_DESC *desc, ID3D11Query **query);
+
+	virtual HRESULT CheckFormatSupport(DXGI_FORMAT format, UINT *support);
+	virtual D3D_FEATURE_LEVEL GetFeatureLevel();
+};
+
+// Drops every command
+class ID3D11DeviceContext : public IUnknown{
+public:
+	ID3D11DeviceContext(){}
+
+	virtual void UpdateSubresource(ID3D11Resource *, UINT, const D3D11_BOX *, const void *, UINT, UINT){}
+	virtual void CopySubresourceRegion(ID3D11Resource *, UINT, UINT, UINT, UINT, ID3D11Resource *, UINT, const D3D11_BOX *){}
+	virtual void CopyResource(ID3D11Resource *, ID3D11Resource *){}
+	virtual void GenerateMips(ID3D11ShaderResourceView *){}
+
+	virtual void PSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView *const *){}
+	virtual void CSSetShader(ID3D11ComputeShader *, ID3D11ClassInstance *const *, UINT){}
+	virtual void CSSetConstantBuffers(UINT, UINT, ID3D11Buffer *const *){}
+	virtual void CSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView *const *){}
+	virtual void CSSetUnorderedAccessViews(UINT, UINT, ID3D11UnorderedAccessView *const *, const UINT *){}
+	virtual void ClearUnorderedAccessViewUint(ID3D11UnorderedAccessView *, const UINT[4]){}
+	virtual void Dispatch(UINT, UINT, UINT){}
+
+	// Nothing holds the contents to map
+	virtual HRESULT Map(ID3D11Resource *, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE *){ return E_FAIL; }
+	virtual void Unmap(ID3D11Resource *, UINT){}
+
+	// Queries never finish since nothing ever runs
+	virtual void Begin(ID3D11Asynchronous *){}
+	virtual void End(ID3D11Asynchronous *){}
+	virtual HRESULT GetData(ID3D11Asynchronous *, void *, UINT, UINT){ return S_FALSE; }
+};